@@ -0,0 +1,368 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+"""Reference host client for the multiplexed mode of the Serial LTE Modem.
+
+The client talks to SLM over a serial port, for example the UART of an nRF9160
+DK or the pseudo terminal of a native_posix build. It only depends on the
+Python standard library and runs on Linux.
+
+Examples:
+
+    # Run AT commands, bind socket 1 to a channel and send data through it
+    slm_mux_client.py /dev/ttyACM0 --at 'AT#XSOCKET=1,1,0' \\
+        --at 'AT#XCONNECT="example.com",7' --bind 1 --send 'Hello'
+
+    # Check the client against an SLM emulator over a pty
+    slm_mux_client.py --self-test
+"""
+
+import argparse
+import os
+import queue
+import re
+import select
+import sys
+import termios
+import threading
+import time
+import tty
+
+SOF = 0xF9
+HDR_LEN = 5
+CHANNEL_AT = 0
+
+TYPE_DATA = 0
+TYPE_CREDIT = 1
+TYPE_CLOSE = 2
+
+BAUDRATES = {
+    9600: termios.B9600,
+    115200: termios.B115200,
+    230400: termios.B230400,
+    460800: termios.B460800,
+    921600: termios.B921600,
+    1000000: termios.B1000000,
+}
+
+
+def crc8(data, crc=0xFF):
+    """CRC-8-CCITT, as crc8_ccitt() of Zephyr."""
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def encode_frame(channel, frame_type, payload=b''):
+    header = bytes([channel, frame_type]) + len(payload).to_bytes(2, 'little')
+    return bytes([SOF]) + header + payload + bytes([crc8(header + payload)])
+
+
+class FrameDecoder:
+    """Incremental frame decoder, resynchronizing on the start flag."""
+
+    def __init__(self, max_len=4096):
+        self.max_len = max_len
+        self.buf = bytearray()
+
+    def feed(self, data):
+        """Add received bytes, return the list of complete (channel, type, payload)."""
+        self.buf += data
+        frames = []
+        while True:
+            start = self.buf.find(bytes([SOF]))
+            if start < 0:
+                self.buf.clear()
+                break
+            del self.buf[:start]
+            if len(self.buf) < HDR_LEN:
+                break
+            length = int.from_bytes(self.buf[3:5], 'little')
+            if length > self.max_len or self.buf[2] > TYPE_CLOSE:
+                del self.buf[:1]
+                continue
+            if len(self.buf) < HDR_LEN + length + 1:
+                break
+            frame = bytes(self.buf[:HDR_LEN + length + 1])
+            if crc8(frame[1:-1]) != frame[-1]:
+                del self.buf[:1]
+                continue
+            del self.buf[:len(frame)]
+            frames.append((frame[1], frame[2], frame[HDR_LEN:-1]))
+        return frames
+
+
+class Channel:
+    def __init__(self):
+        self.rx = queue.Queue()
+        self.tx_credits = threading.Semaphore(0)
+        self.closed = threading.Event()
+
+
+class SlmMux:
+    """Multiplexed mode host, one reader thread dispatching frames to channels."""
+
+    def __init__(self, fd, timeout=5.0):
+        self.fd = fd
+        self.timeout = timeout
+        self.decoder = FrameDecoder()
+        self.channels = {CHANNEL_AT: Channel()}
+        self.frame_size = 0
+        self.plain = queue.Queue()
+        self.muxed = False
+        self.stopping = False
+        self.write_lock = threading.Lock()
+        self.running = True
+        self.reader = threading.Thread(target=self._read_loop, daemon=True)
+        self.reader.start()
+
+    @classmethod
+    def open(cls, port, baudrate=115200, rtscts=True):
+        fd = os.open(port, os.O_RDWR | os.O_NOCTTY)
+        tty.setraw(fd)
+        attrs = termios.tcgetattr(fd)
+        if baudrate in BAUDRATES:
+            attrs[4] = attrs[5] = BAUDRATES[baudrate]
+        if rtscts:
+            attrs[2] |= termios.CRTSCTS
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+        return cls(fd)
+
+    def close(self):
+        self.running = False
+        self.reader.join()
+        os.close(self.fd)
+
+    def _write(self, data):
+        with self.write_lock:
+            while data:
+                data = data[os.write(self.fd, data):]
+
+    def _read_loop(self):
+        while self.running:
+            ready, _, _ = select.select([self.fd], [], [], 0.1)
+            if not ready:
+                continue
+            try:
+                data = os.read(self.fd, 4096)
+            except OSError:
+                break
+            if not self.muxed or self.stopping:
+                self.plain.put(data)
+            if not self.muxed:
+                continue
+            for channel, frame_type, payload in self.decoder.feed(data):
+                self._dispatch(channel, frame_type, payload)
+
+    def _dispatch(self, channel, frame_type, payload):
+        ch = self.channels.setdefault(channel, Channel())
+        if frame_type == TYPE_DATA:
+            ch.rx.put(payload)
+        elif frame_type == TYPE_CREDIT and payload:
+            for _ in range(payload[0]):
+                ch.tx_credits.release()
+        elif frame_type == TYPE_CLOSE:
+            ch.closed.set()
+            ch.rx.put(None)
+
+    def _frame_send(self, channel, payload):
+        ch = self.channels[channel]
+        if not ch.tx_credits.acquire(timeout=self.timeout):
+            raise TimeoutError(f'no credit on channel {channel}')
+        self._write(encode_frame(channel, TYPE_DATA, payload))
+
+    def _response(self, read, timeout):
+        text = ''
+        deadline = time.monotonic() + timeout
+        while not re.search(r'(^|\r\n)(OK|ERROR)\r\n$', text):
+            remaining = deadline - time.monotonic()
+            if remaining <= 0:
+                raise TimeoutError(f'no final response: {text!r}')
+            data = read(remaining)
+            if data is None:
+                raise ConnectionError('AT channel closed')
+            text += data.decode(errors='replace')
+        if text.endswith('ERROR\r\n'):
+            raise RuntimeError(text.strip())
+        return text
+
+    def start(self):
+        """Start the multiplexed mode, return (channels, credits, frame size)."""
+        self.muxed = True
+        self._write(b'AT#XMUX=1\r\n')
+        text = self._response(lambda t: self.channels[CHANNEL_AT].rx.get(timeout=t),
+                              self.timeout)
+        channels, credits, self.frame_size = (int(v) for v in
+                                              re.search(r'#XMUX: (\d+),(\d+),(\d+)',
+                                                        text).groups())
+        self.decoder.max_len = self.frame_size
+        for channel in range(channels + 1):
+            ch = self.channels.setdefault(channel, Channel())
+            for _ in range(credits):
+                ch.tx_credits.release()
+        return channels, credits, self.frame_size
+
+    def at(self, command, timeout=None):
+        """Send an AT command on the AT channel, return the response text."""
+        self._frame_send(CHANNEL_AT, command.encode() + b'\r\n')
+        return self._response(lambda t: self.channels[CHANNEL_AT].rx.get(timeout=t),
+                              timeout or self.timeout)
+
+    def stop(self):
+        """Stop the multiplexed mode, the final response comes outside of a frame."""
+        self.stopping = True
+        self._frame_send(CHANNEL_AT, b'AT#XMUX=0\r\n')
+        try:
+            text = self._response(lambda t: self.plain.get(timeout=t), self.timeout)
+            # Drop the frames received before the final response
+            return text.split('\r\n')[-2]
+        finally:
+            self.muxed = False
+            self.stopping = False
+
+    def bind(self, handle, credits=2):
+        """Bind a socket handle to a channel and grant it credits."""
+        text = self.at(f'AT#XMUX=2,{handle}')
+        channel = int(re.search(r'#XMUX: (\d+),', text).group(1))
+        ch = self.channels.setdefault(channel, Channel())
+        ch.closed.clear()
+        self._write(encode_frame(channel, TYPE_CREDIT, bytes([credits])))
+        return channel
+
+    def send(self, channel, data):
+        """Send data to the socket bound to a channel."""
+        for offset in range(0, len(data), self.frame_size):
+            self._frame_send(channel, data[offset:offset + self.frame_size])
+
+    def recv(self, channel, timeout=None):
+        """Receive data from the socket bound to a channel, None when closed."""
+        data = self.channels[channel].rx.get(timeout=timeout or self.timeout)
+        if data is not None:
+            self._write(encode_frame(channel, TYPE_CREDIT, bytes([1])))
+        return data
+
+
+class SlmEmulator(threading.Thread):
+    """Minimal SLM side of the multiplexed mode, echoing data of bound channels."""
+
+    def __init__(self, fd, channels=4, credits=2, frame_size=512):
+        super().__init__(daemon=True)
+        self.fd = fd
+        self.config = (channels, credits, frame_size)
+        self.decoder = FrameDecoder(frame_size)
+        self.credits = {}
+        self.pending = {}
+        self.bound = {}
+        self.running = True
+
+    def _send(self, channel, frame_type, payload=b''):
+        os.write(self.fd, encode_frame(channel, frame_type, payload))
+
+    def _at(self, command):
+        match = re.match(r'AT#XMUX=(\d)(?:,(\d+))?', command)
+        if match and match.group(1) == '2':
+            channel = len(self.bound) + 1
+            self.bound[channel] = int(match.group(2))
+            self._send(CHANNEL_AT, TYPE_DATA,
+                       f'\r\n#XMUX: {channel},{match.group(2)}\r\nOK\r\n'.encode())
+        elif match and match.group(1) == '0':
+            os.write(self.fd, b'\r\nOK\r\n')
+            return False
+        else:
+            self._send(CHANNEL_AT, TYPE_DATA, b'\r\nOK\r\n')
+        return True
+
+    def _flush(self, channel):
+        while self.pending.get(channel) and self.credits.get(channel, 0) > 0:
+            self.credits[channel] -= 1
+            self._send(channel, TYPE_DATA, self.pending[channel].pop(0))
+
+    def run(self):
+        channels, credits, frame_size = self.config
+        command = b''
+        while not command.endswith(b'\r\n'):
+            command += os.read(self.fd, 1)
+        self._send(CHANNEL_AT, TYPE_DATA,
+                   f'\r\n#XMUX: {channels},{credits},{frame_size}\r\nOK\r\n'.encode())
+        while self.running:
+            for channel, frame_type, payload in self.decoder.feed(os.read(self.fd, 4096)):
+                if frame_type == TYPE_CREDIT:
+                    self.credits[channel] = self.credits.get(channel, 0) + payload[0]
+                elif frame_type == TYPE_DATA and channel == CHANNEL_AT:
+                    self._send(channel, TYPE_CREDIT, bytes([1]))
+                    self.running = self._at(payload.decode().strip())
+                elif frame_type == TYPE_DATA:
+                    self.pending.setdefault(channel, []).append(payload)
+                    self._send(channel, TYPE_CREDIT, bytes([1]))
+                self._flush(channel)
+
+
+def self_test():
+    master, slave = os.openpty()
+    tty.setraw(master)
+    emulator = SlmEmulator(master)
+    emulator.start()
+    mux = SlmMux.open(os.ttyname(slave), rtscts=False)
+
+    print('start:', mux.start())
+    channel = mux.bind(1)
+    data = bytes(range(256)) * 12
+    start = time.monotonic()
+    mux.send(channel, data)
+    echo = b''
+    while len(echo) < len(data):
+        echo += mux.recv(channel)
+    elapsed = time.monotonic() - start
+    print(f'channel {channel}: {len(echo)} bytes echoed in {elapsed:.3f} s')
+    assert echo == data, 'echoed data mismatch'
+    print('stop:', mux.stop())
+    mux.close()
+    os.close(master)
+    print('self-test passed')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('port', nargs='?', help='serial port or pty of SLM')
+    parser.add_argument('--baudrate', type=int, default=115200)
+    parser.add_argument('--no-rtscts', action='store_true',
+                        help='disable hardware flow control')
+    parser.add_argument('--at', action='append', default=[],
+                        help='AT command run before starting the multiplexed mode')
+    parser.add_argument('--bind', type=int, action='append', default=[],
+                        help='socket handle to bind to a channel')
+    parser.add_argument('--send', help='data sent on every bound channel')
+    parser.add_argument('--self-test', action='store_true',
+                        help='run against an SLM emulator over a pty')
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return 0
+    if not args.port:
+        parser.error('port is required')
+
+    mux = SlmMux.open(args.port, args.baudrate, not args.no_rtscts)
+    for command in args.at:
+        mux._write(command.encode() + b'\r\n')
+        print(mux._response(lambda t: mux.plain.get(timeout=t), mux.timeout).strip())
+    print('#XMUX:', mux.start())
+    channels = [mux.bind(handle) for handle in args.bind]
+    if args.send:
+        for channel in channels:
+            mux.send(channel, args.send.encode())
+        for channel in channels:
+            print(f'channel {channel}:', mux.recv(channel, timeout=10))
+    print(mux.stop())
+    mux.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -18,13 +18,18 @@
 #include "ncs_version.h"
 
 #include "slm_util.h"
+#include "slm_at_dispatch.h"
 #include "slm_at_host.h"
+#include "slm_poller.h"
 #include "slm_at_tcp_proxy.h"
 #include "slm_at_udp_proxy.h"
 #include "slm_at_socket.h"
 #if defined(CONFIG_SLM_NATIVE_TLS)
 #include "slm_at_cmng.h"
 #endif
+#if defined(CONFIG_SLM_MUX)
+#include "slm_mux.h"
+#endif
 #include "slm_at_icmp.h"
 #include "slm_at_sms.h"
 #include "slm_at_fota.h"
@@ -62,9 +67,6 @@ enum shutdown_modes {
 	SHUTDOWN_MODE_IDLE
 };
 
-/**@brief AT command handler type. */
-typedef int (*slm_at_handler_t) (enum at_cmd_type);
-
 static struct slm_work_info {
 	struct k_work_delayable uart_work;
 	struct k_work_delayable sleep_work;
@@ -396,6 +398,10 @@ int handle_at_getaddrinfo(enum at_cmd_type cmd_type);
 int handle_at_xcmng(enum at_cmd_type cmd_type);
 #endif
 
+#if defined(CONFIG_SLM_MUX)
+int handle_at_mux(enum at_cmd_type cmd_type);
+#endif
+
 /* ICMP commands */
 int handle_at_icmp_ping(enum at_cmd_type cmd_type);
 
@@ -448,10 +454,7 @@ int handle_at_dfu_get(enum at_cmd_type cmd_type);
 int handle_at_dfu_run(enum at_cmd_type cmd_type);
 #endif
 
-static struct slm_at_cmd {
-	char *string;
-	slm_at_handler_t handler;
-} slm_at_cmd_list[] = {
+static struct slm_at_cmd slm_at_cmd_list[] = {
 	/* Generic commands */
 	{"AT#XSLMVER", handle_at_slmver},
 	{"AT#XSLEEP", handle_at_sleep},
@@ -464,13 +467,13 @@ static struct slm_at_cmd {
 	/* TCP proxy commands */
 	{"AT#XTCPSVR", handle_at_tcp_server},
 	{"AT#XTCPCLI", handle_at_tcp_client},
-	{"AT#XTCPSEND", handle_at_tcp_send},
+	{"AT#XTCPSEND", handle_at_tcp_send, 2},
 	{"AT#XTCPHANGUP", handle_at_tcp_hangup},
 
 	/* UDP proxy commands */
 	{"AT#XUDPSVR", handle_at_udp_server},
 	{"AT#XUDPCLI", handle_at_udp_client},
-	{"AT#XUDPSEND", handle_at_udp_send},
+	{"AT#XUDPSEND", handle_at_udp_send, 2},
 
 	/* Socket-type TCPIP commands */
 	{"AT#XSOCKET", handle_at_socket},
@@ -482,16 +485,20 @@ static struct slm_at_cmd {
 	{"AT#XCONNECT", handle_at_connect},
 	{"AT#XLISTEN", handle_at_listen},
 	{"AT#XACCEPT", handle_at_accept},
-	{"AT#XSEND", handle_at_send},
-	{"AT#XRECV", handle_at_recv},
-	{"AT#XSENDTO", handle_at_sendto},
-	{"AT#XRECVFROM", handle_at_recvfrom},
+	{"AT#XSEND", handle_at_send, 2},
+	{"AT#XRECV", handle_at_recv, 3},
+	{"AT#XSENDTO", handle_at_sendto, 4},
+	{"AT#XRECVFROM", handle_at_recvfrom, 3},
 	{"AT#XPOLL", handle_at_poll},
 	{"AT#XGETADDRINFO", handle_at_getaddrinfo},
 
 #if defined(CONFIG_SLM_NATIVE_TLS)
 	{"AT#XCMNG", handle_at_xcmng},
 #endif
+
+#if defined(CONFIG_SLM_MUX)
+	{"AT#XMUX", handle_at_mux},
+#endif
 	/* ICMP commands */
 	{"AT#XPING", handle_at_icmp_ping},
 
@@ -570,27 +577,27 @@ int handle_at_clac(enum at_cmd_type cmd_type)
 	return ret;
 }
 
+SLM_AT_DISPATCH_DEFINE(slm_at_dispatch, ARRAY_SIZE(slm_at_cmd_list));
+
 int slm_at_parse(const char *at_cmd)
 {
-	int ret = -ENOENT;
-	int total = ARRAY_SIZE(slm_at_cmd_list);
+	int ret;
+	const struct slm_at_cmd *cmd;
+	enum at_cmd_type type;
 
-	for (int i = 0; i < total; i++) {
-		if (slm_util_cmd_casecmp(at_cmd, slm_at_cmd_list[i].string)) {
-			enum at_cmd_type type = at_parser_cmd_type_get(at_cmd);
+	cmd = slm_at_dispatch_find(&slm_at_dispatch, at_cmd);
+	if (cmd == NULL) {
+		return -ENOENT;
+	}
 
-			at_params_list_clear(&at_param_list);
-			ret = at_parser_params_from_str(at_cmd, NULL, &at_param_list);
-			if (ret) {
-				LOG_ERR("Failed to parse AT command %d", ret);
-				return -EINVAL;
-			}
-			ret = slm_at_cmd_list[i].handler(type);
-			break;
-		}
+	type = at_parser_cmd_type_get(at_cmd);
+	ret = slm_at_dispatch_parse(cmd, at_cmd, &at_param_list);
+	if (ret) {
+		LOG_ERR("Failed to parse AT command %d", ret);
+		return -EINVAL;
 	}
 
-	return ret;
+	return cmd->handler(type);
 }
 
 int slm_at_init(void)
@@ -600,6 +607,18 @@ int slm_at_init(void)
 	k_work_init_delayable(&slm_work.uart_work, set_uart_wk);
 	k_work_init_delayable(&slm_work.sleep_work, go_sleep_wk);
 
+	err = slm_at_dispatch_init(&slm_at_dispatch, slm_at_cmd_list,
+				   ARRAY_SIZE(slm_at_cmd_list));
+	if (err) {
+		LOG_ERR("AT command table could not be initialized: %d", err);
+		return -EFAULT;
+	}
+
+	err = slm_poller_init();
+	if (err) {
+		LOG_ERR("Socket poller could not be initialized: %d", err);
+		return -EFAULT;
+	}
 	err = slm_at_tcp_proxy_init();
 	if (err) {
 		LOG_ERR("TCP Server could not be initialized: %d", err);
@@ -615,6 +634,13 @@ int slm_at_init(void)
 		LOG_ERR("TCPIP could not be initialized: %d", err);
 		return -EFAULT;
 	}
+#if defined(CONFIG_SLM_MUX)
+	err = slm_mux_init();
+	if (err) {
+		LOG_ERR("MUX could not be initialized: %d", err);
+		return -EFAULT;
+	}
+#endif
 #if defined(CONFIG_SLM_NATIVE_TLS)
 	err = slm_at_cmng_init();
 	if (err) {
@@ -696,6 +722,12 @@ void slm_at_uninit(void)
 {
 	int err;
 
+#if defined(CONFIG_SLM_MUX)
+	err = slm_mux_uninit();
+	if (err) {
+		LOG_WRN("MUX could not be uninitialized: %d", err);
+	}
+#endif
 	err = slm_at_tcp_proxy_uninit();
 	if (err) {
 		LOG_WRN("TCP Server could not be uninitialized: %d", err);
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <zephyr/sys/util.h>
+#include "slm_at_dispatch.h"
+
+/* Characters ending the command name in an AT command string */
+#define CMD_NAME_END "=?\r\n"
+
+/* FNV-1a over the upper case command name, seeded. */
+static uint32_t cmd_hash(const char *name, size_t len, uint16_t seed)
+{
+	uint32_t hash = 2166136261U ^ (seed * 0x9E3779B1U);
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= (uint8_t)toupper((int)name[i]);
+		hash *= 16777619U;
+	}
+
+	return hash ^ (hash >> 15);
+}
+
+static size_t cmd_bucket(const struct slm_at_dispatch *dispatch, const char *name, size_t len)
+{
+	return cmd_hash(name, len, 0) % dispatch->bucket_count;
+}
+
+static size_t cmd_slot(const struct slm_at_dispatch *dispatch, const char *name, size_t len,
+		       uint16_t seed)
+{
+	return cmd_hash(name, len, seed) % dispatch->slot_count;
+}
+
+/* Try to place all commands of a bucket with the given seed. */
+static bool bucket_place(struct slm_at_dispatch *dispatch, size_t bucket, uint16_t seed)
+{
+	size_t i;
+
+	for (i = 0; i < dispatch->count; i++) {
+		const char *name = dispatch->list[i].string;
+		size_t len = strlen(name);
+		size_t slot;
+
+		if (cmd_bucket(dispatch, name, len) != bucket) {
+			continue;
+		}
+		slot = cmd_slot(dispatch, name, len, seed);
+		if (dispatch->slots[slot] != 0) {
+			break;
+		}
+		dispatch->slots[slot] = i + 1;
+	}
+
+	if (i == dispatch->count) {
+		dispatch->seeds[bucket] = seed;
+		return true;
+	}
+
+	/* Collision, undo the commands placed with this seed */
+	while (i-- > 0) {
+		const char *name = dispatch->list[i].string;
+		size_t len = strlen(name);
+		size_t slot;
+
+		if (cmd_bucket(dispatch, name, len) != bucket) {
+			continue;
+		}
+		slot = cmd_slot(dispatch, name, len, seed);
+		if (dispatch->slots[slot] == i + 1) {
+			dispatch->slots[slot] = 0;
+		}
+	}
+
+	return false;
+}
+
+int slm_at_dispatch_init(struct slm_at_dispatch *dispatch,
+			 const struct slm_at_cmd *list, size_t count)
+{
+	uint8_t bucket_size[SLM_AT_DISPATCH_BUCKET_COUNT(UINT8_MAX)] = {0};
+	uint8_t max_size = 0;
+
+	if (count >= UINT8_MAX ||
+	    dispatch->slot_count < SLM_AT_DISPATCH_SLOT_COUNT(count) ||
+	    dispatch->bucket_count < SLM_AT_DISPATCH_BUCKET_COUNT(count) ||
+	    dispatch->bucket_count > ARRAY_SIZE(bucket_size)) {
+		return -EINVAL;
+	}
+
+	dispatch->list = list;
+	dispatch->count = count;
+	memset(dispatch->slots, 0, dispatch->slot_count * sizeof(dispatch->slots[0]));
+	memset(dispatch->seeds, 0, dispatch->bucket_count * sizeof(dispatch->seeds[0]));
+
+	for (size_t i = 0; i < count; i++) {
+		size_t bucket = cmd_bucket(dispatch, list[i].string, strlen(list[i].string));
+
+		bucket_size[bucket]++;
+		max_size = MAX(max_size, bucket_size[bucket]);
+	}
+
+	/* Place the largest buckets first, while most of the slots are free */
+	for (uint8_t size = max_size; size > 0; size--) {
+		for (size_t bucket = 0; bucket < dispatch->bucket_count; bucket++) {
+			uint16_t seed;
+
+			if (bucket_size[bucket] != size) {
+				continue;
+			}
+			for (seed = 1; seed < UINT16_MAX; seed++) {
+				if (bucket_place(dispatch, bucket, seed)) {
+					break;
+				}
+			}
+			if (seed == UINT16_MAX) {
+				return -ENOSPC;
+			}
+		}
+	}
+
+	return 0;
+}
+
+const struct slm_at_cmd *slm_at_dispatch_find(const struct slm_at_dispatch *dispatch,
+					      const char *at_cmd)
+{
+	const struct slm_at_cmd *cmd;
+	size_t len = strcspn(at_cmd, CMD_NAME_END);
+	size_t slot;
+	uint8_t index;
+
+	if (dispatch->count == 0) {
+		return NULL;
+	}
+
+	slot = cmd_slot(dispatch, at_cmd, len,
+			dispatch->seeds[cmd_bucket(dispatch, at_cmd, len)]);
+	index = dispatch->slots[slot];
+	if (index == 0) {
+		return NULL;
+	}
+
+	cmd = &dispatch->list[index - 1];
+	if (strlen(cmd->string) != len) {
+		return NULL;
+	}
+	for (size_t i = 0; i < len; i++) {
+		if (toupper((int)at_cmd[i]) != toupper((int)cmd->string[i])) {
+			return NULL;
+		}
+	}
+
+	return cmd;
+}
+
+int slm_at_dispatch_parse(const struct slm_at_cmd *cmd, const char *at_cmd,
+			  struct at_param_list *list)
+{
+	int ret;
+
+	at_params_list_clear(list);
+
+	/* Read and test commands carry no parameters */
+	if (at_parser_cmd_type_get(at_cmd) != AT_CMD_TYPE_SET_COMMAND) {
+		return 0;
+	}
+
+	if (cmd->max_params == 0) {
+		return at_parser_params_from_str(at_cmd, NULL, list);
+	}
+
+	/* The parser returns -E2BIG once it has stored max_params parameters,
+	 * also when the command has no more parameters.
+	 */
+	ret = at_parser_max_params_from_str(at_cmd, NULL, list, cmd->max_params);
+
+	return (ret == -E2BIG) ? 0 : ret;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SLM_AT_DISPATCH_
+#define SLM_AT_DISPATCH_
+
+/**@file slm_at_dispatch.h
+ *
+ * @brief Hash based lookup of SLM proprietary AT command handlers.
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <stddef.h>
+#include <modem/at_cmd_parser.h>
+
+/**@brief AT command handler type. */
+typedef int (*slm_at_handler_t) (enum at_cmd_type);
+
+/**@brief SLM proprietary AT command. */
+struct slm_at_cmd {
+	/** Command name, for example "AT#XSEND". */
+	char *string;
+	/** Command handler. */
+	slm_at_handler_t handler;
+	/** Number of parameters (command name included) the handler reads
+	 *  from a set command. Zero means all parameters are parsed.
+	 */
+	uint8_t max_params;
+};
+
+/** Number of hash slots needed for @p count commands. */
+#define SLM_AT_DISPATCH_SLOT_COUNT(count) ((count) + ((count) / 4) + 1)
+
+/** Number of displacement buckets needed for @p count commands. */
+#define SLM_AT_DISPATCH_BUCKET_COUNT(count) (((count) / 2) + 1)
+
+/**@brief Perfect hash from command name to command.
+ *
+ * Commands are first hashed into buckets. Each bucket stores the seed
+ * with which all of its commands hash into distinct free slots, so that
+ * a lookup takes two hash calculations and one string comparison.
+ */
+struct slm_at_dispatch {
+	const struct slm_at_cmd *list;
+	size_t count;
+	/** Command index + 1 per slot, 0 for a free slot. */
+	uint8_t *slots;
+	size_t slot_count;
+	/** Seed per bucket. */
+	uint16_t *seeds;
+	size_t bucket_count;
+};
+
+/** Define a dispatcher for a command list of @p count entries. */
+#define SLM_AT_DISPATCH_DEFINE(_name, _count)						\
+	static uint8_t _name##_slots[SLM_AT_DISPATCH_SLOT_COUNT(_count)];		\
+	static uint16_t _name##_seeds[SLM_AT_DISPATCH_BUCKET_COUNT(_count)];		\
+	static struct slm_at_dispatch _name = {						\
+		.slots = _name##_slots,							\
+		.slot_count = SLM_AT_DISPATCH_SLOT_COUNT(_count),			\
+		.seeds = _name##_seeds,							\
+		.bucket_count = SLM_AT_DISPATCH_BUCKET_COUNT(_count),			\
+	}
+
+/**
+ * @brief Build the hash for a command list.
+ *
+ * @param dispatch Dispatcher defined with @ref SLM_AT_DISPATCH_DEFINE.
+ * @param list Command list. Must stay valid as long as the dispatcher is used.
+ * @param count Number of commands in @p list.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_at_dispatch_init(struct slm_at_dispatch *dispatch,
+			 const struct slm_at_cmd *list, size_t count);
+
+/**
+ * @brief Find the command matching an AT command string, ignoring case.
+ *
+ * @param dispatch Initialized dispatcher.
+ * @param at_cmd AT command string, with or without parameters.
+ *
+ * @return Matching command, or NULL if the command is not in the list.
+ */
+const struct slm_at_cmd *slm_at_dispatch_find(const struct slm_at_dispatch *dispatch,
+					      const char *at_cmd);
+
+/**
+ * @brief Parse the parameters of an AT command for its handler.
+ *
+ * Only set commands are parsed. If @p cmd limits the number of parameters,
+ * parsing stops after that many parameters and any further parameters are
+ * ignored.
+ *
+ * @param cmd Command found with @ref slm_at_dispatch_find.
+ * @param at_cmd AT command string.
+ * @param list Initialized parameter list, cleared before parsing.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_at_dispatch_parse(const struct slm_at_cmd *cmd, const char *at_cmd,
+			  struct at_param_list *list);
+
+/** @} */
+
+#endif /* SLM_AT_DISPATCH_ */
@@ -19,6 +19,9 @@
 #include "slm_util.h"
 #include "slm_at_host.h"
 #include "slm_at_fota.h"
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+#include "slm_rx_stream.h"
+#endif
 #if defined(CONFIG_SLM_NRF52_DFU_LEGACY)
 #include "slip.h"
 #endif
@@ -46,6 +49,7 @@ LOG_MODULE_REGISTER(slm_at_host, CONFIG_SLM_LOG_LEVEL);
 static enum slm_operation_modes {
 	SLM_AT_COMMAND_MODE,  /* AT command host or bridge */
 	SLM_DATA_MODE,        /* Raw data sending */
+	SLM_MUX_MODE,         /* Multiplexed AT commands and data */
 	SLM_DFU_MODE          /* nRF52 DFU controller */
 } slm_operation_mode;
 
@@ -53,18 +57,29 @@ static const struct device *uart_dev;
 static uint8_t at_buf[AT_MAX_CMD_LEN];
 static uint16_t at_buf_len;
 static bool at_buf_overflow;
+#if !defined(CONFIG_SLM_DATAMODE_STREAMING)
 static struct ring_buf data_rb;
+#endif
 static bool datamode_rx_disabled;
 static slm_datamode_handler_t datamode_handler;
+#if defined(CONFIG_SLM_MUX)
+static slm_muxmode_rx_handler_t muxmode_rx_handler;
+static slm_muxmode_tx_handler_t muxmode_tx_handler;
+#endif
 static struct k_work raw_send_work;
 static struct k_work cmd_send_work;
 static struct k_work datamode_quit_work;
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+static struct k_work_delayable terminator_work;
+#endif
 
 RING_BUF_DECLARE(delayed_rb, UART_TX_DATA_SIZE);
 static struct k_work delayed_send_work;
 
+#if !defined(CONFIG_SLM_DATAMODE_STREAMING)
 static uint8_t uart_rx_buf[UART_RX_BUF_NUM][UART_RX_LEN];
 static uint8_t *next_buf;
+#endif
 static uint8_t *uart_tx_buf;
 static bool uart_recovery_pending;
 static struct k_work_delayable uart_recovery_work;
@@ -87,14 +102,24 @@ uint16_t datamode_time_limit;                 /* Send trigger by time in data mo
 extern bool uart_configured;
 extern struct uart_config slm_uart;
 
-static int uart_send(const uint8_t *buffer, size_t len)
+static bool uart_active(void)
 {
-	int ret;
 	enum pm_device_state state = PM_DEVICE_STATE_OFF;
 
 	pm_device_state_get(uart_dev, &state);
 	if (state != PM_DEVICE_STATE_ACTIVE) {
 		(void)indicate_start();
+		return false;
+	}
+
+	return true;
+}
+
+static int uart_send(const uint8_t *buffer, size_t len)
+{
+	int ret;
+
+	if (!uart_active()) {
 		return -EAGAIN;
 	}
 
@@ -118,40 +143,123 @@ static int uart_send(const uint8_t *buffer, size_t len)
 	return ret;
 }
 
+/* Send a heap buffer as is, the buffer is freed when TX is done. */
+static int uart_send_nocopy(uint8_t *buffer, size_t len)
+{
+	int ret;
+
+	if (!uart_active()) {
+		return -EAGAIN;
+	}
+
+	k_sem_take(&tx_done, K_FOREVER);
+
+	uart_tx_buf = buffer;
+	ret = uart_tx(uart_dev, uart_tx_buf, len, SYS_FOREVER_US);
+	if (ret) {
+		LOG_WRN("uart_tx failed: %d", ret);
+		uart_tx_buf = NULL;
+		k_sem_give(&tx_done);
+	}
+
+	return ret;
+}
+
 void rsp_send(const char *str, size_t len)
 {
 	if (len == 0 || slm_operation_mode == SLM_DFU_MODE) {
 		return;
 	}
 
+#if defined(CONFIG_SLM_MUX)
+	if (slm_operation_mode == SLM_MUX_MODE) {
+		muxmode_tx_handler((const uint8_t *)str, len);
+		return;
+	}
+#endif
 	LOG_HEXDUMP_DBG(str, len, "TX");
 	if (uart_send(str, len) < 0) {
 		ring_buf_put(&delayed_rb, str, len);
 	}
 }
 
+static void uart_data_send_nocopy(uint8_t *data, size_t len)
+{
+	LOG_HEXDUMP_DBG(data, MIN(len, HEXDUMP_DATAMODE_MAX), "TX-DATA");
+	if (uart_send_nocopy(data, len) < 0) {
+		ring_buf_put(&delayed_rb, data, len);
+		k_free(data);
+	}
+}
+
 void data_send(const uint8_t *data, size_t len)
 {
 	if (slm_operation_mode == SLM_DFU_MODE) {
 		return;
 	}
+#if defined(CONFIG_SLM_MUX)
+	/* Data follows the response it belongs to on the AT channel */
+	if (slm_operation_mode == SLM_MUX_MODE) {
+		muxmode_tx_handler(data, len);
+		return;
+	}
+#endif
 	LOG_HEXDUMP_DBG(data, MIN(len, HEXDUMP_DATAMODE_MAX), "TX-DATA");
 	if (uart_send(data, len) < 0) {
 		ring_buf_put(&delayed_rb, data, len);
 	}
 }
 
+void data_send_nocopy(uint8_t *data, size_t len)
+{
+	if (slm_operation_mode == SLM_DFU_MODE) {
+		k_free(data);
+		return;
+	}
+#if defined(CONFIG_SLM_MUX)
+	if (slm_operation_mode == SLM_MUX_MODE) {
+		muxmode_tx_handler(data, len);
+		k_free(data);
+		return;
+	}
+#endif
+	uart_data_send_nocopy(data, len);
+}
+
+#if defined(CONFIG_SLM_MUX)
+void muxmode_frame_send(uint8_t *frame, size_t len)
+{
+	uart_data_send_nocopy(frame, len);
+}
+#endif
+
 static int uart_receive(void)
 {
 	int ret;
 
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+	uint8_t *buf = slm_rx_stream_buf_alloc();
+
+	if (buf == NULL) {
+		LOG_ERR("No UART RX buffer");
+		return -ENOMEM;
+	}
+	ret = uart_rx_enable(uart_dev, buf, CONFIG_SLM_DATAMODE_STREAMING_BUF_SIZE,
+			     UART_RX_TIMEOUT_US);
+	if (ret) {
+		slm_rx_stream_buf_release(buf);
+	}
+#else
 	ret = uart_rx_enable(uart_dev, uart_rx_buf[0], sizeof(uart_rx_buf[0]), UART_RX_TIMEOUT_US);
+#endif
 	if (ret && ret != -EBUSY) {
 		LOG_ERR("UART RX failed: %d", ret);
 		rsp_send(FATAL_STR, sizeof(FATAL_STR) - 1);
 		return ret;
 	}
+#if !defined(CONFIG_SLM_DATAMODE_STREAMING)
 	next_buf = uart_rx_buf[1];
+#endif
 	at_buf_overflow = false;
 	at_buf_len = 0;
 
@@ -169,12 +277,20 @@ static void uart_recovery(struct k_work *work)
 
 int enter_datamode(slm_datamode_handler_t handler)
 {
-	if (handler == NULL || datamode_handler != NULL) {
+	if (handler == NULL || datamode_handler != NULL ||
+	    slm_operation_mode != SLM_AT_COMMAND_MODE) {
 		LOG_INF("Invalid, not enter datamode");
 		return -EINVAL;
 	}
 
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+	if (slm_uart.flow_ctrl != UART_CFG_FLOW_CTRL_RTS_CTS) {
+		LOG_WRN("Data may be lost without hardware flow control");
+	}
+	slm_rx_stream_held_drop();
+#else
 	ring_buf_init(&data_rb, sizeof(at_buf), at_buf);
+#endif
 	datamode_handler = handler;
 	slm_operation_mode = SLM_DATA_MODE;
 	if (datamode_time_limit == 0) {
@@ -199,10 +315,22 @@ bool in_datamode(void)
 bool exit_datamode(int result)
 {
 	if (slm_operation_mode == SLM_DATA_MODE) {
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+		struct slm_rx_chunk chunk;
+#else
 		ring_buf_reset(&data_rb);
+#endif
 		/* reset UART to restore command mode */
 		uart_rx_disable(uart_dev);
 		k_sleep(K_MSEC(10));
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+		/* drop the data not sent, giving back its buffers */
+		while (slm_rx_stream_chunk_get(&chunk, K_NO_WAIT) == 0) {
+			slm_rx_stream_chunk_done(&chunk);
+		}
+		slm_rx_stream_held_drop();
+		(void)k_work_cancel_delayable(&terminator_work);
+#endif
 		(void)uart_receive();
 
 		sprintf(rsp_buf, "\r\n#XDATAMODE: %d\r\n", result);
@@ -217,6 +345,40 @@ bool exit_datamode(int result)
 	return false;
 }
 
+#if defined(CONFIG_SLM_MUX)
+int enter_muxmode(slm_muxmode_rx_handler_t rx_handler, slm_muxmode_tx_handler_t tx_handler)
+{
+	if (rx_handler == NULL || tx_handler == NULL ||
+	    slm_operation_mode != SLM_AT_COMMAND_MODE) {
+		LOG_INF("Invalid, not enter muxmode");
+		return -EINVAL;
+	}
+
+	muxmode_rx_handler = rx_handler;
+	muxmode_tx_handler = tx_handler;
+	slm_operation_mode = SLM_MUX_MODE;
+	LOG_INF("Enter muxmode");
+
+	return 0;
+}
+
+bool in_muxmode(void)
+{
+	return (slm_operation_mode == SLM_MUX_MODE);
+}
+
+bool exit_muxmode(void)
+{
+	if (slm_operation_mode == SLM_MUX_MODE) {
+		slm_operation_mode = SLM_AT_COMMAND_MODE;
+		LOG_INF("Exit muxmode");
+		return true;
+	}
+
+	return false;
+}
+#endif /* CONFIG_SLM_MUX */
+
 int poweroff_uart(void)
 {
 	int err;
@@ -342,7 +504,7 @@ AT_MONITOR(at_notify, ANY, notification_handler);
 
 static void notification_handler(const char *response)
 {
-	if (slm_operation_mode == SLM_AT_COMMAND_MODE) {
+	if (slm_operation_mode == SLM_AT_COMMAND_MODE || slm_operation_mode == SLM_MUX_MODE) {
 		/* Forward the data over UART */
 		rsp_send("\r\n", 2);
 		rsp_send(response, strlen(response));
@@ -469,6 +631,78 @@ int dfu_drv_tx(const uint8_t *data, uint16_t length)
 #endif /* CONFIG_SLM_NRF52_DFU_LEGACY */
 #endif /* CONFIG_SLM_NRF52_DFU */
 
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+static int raw_send_data(const uint8_t *data, size_t len)
+{
+	int size_sent;
+
+	LOG_DBG("Raw send %zu", len);
+	LOG_HEXDUMP_DBG(data, MIN(len, HEXDUMP_DATAMODE_MAX), "RX-DATAMODE");
+	if (datamode_handler == NULL) {
+		LOG_WRN("no handler, %zu dropped", len);
+		return 0;
+	}
+
+	size_sent = datamode_handler(DATAMODE_SEND, data, len);
+	if (size_sent < 0) {
+		LOG_WRN("Raw send failed, %zu dropped", len);
+		return size_sent;
+	}
+
+	return 0;
+}
+
+static int stream_send(void)
+{
+	int ret;
+
+	/* Send the data straight from the UART RX buffers */
+	ret = slm_rx_stream_send(raw_send_data);
+	if (ret < 0) {
+		k_work_submit(&datamode_quit_work);
+		LOG_INF("datamode off pending");
+		return ret;
+	}
+
+	/* As in buffered data mode, the terminator quits data mode only when
+	 * no more data is received within the time limit.
+	 */
+	if (ret > 0) {
+		if (slm_rx_stream_terminated()) {
+			k_work_reschedule(&terminator_work, K_MSEC(datamode_time_limit));
+		} else {
+			(void)k_work_cancel_delayable(&terminator_work);
+		}
+	}
+
+	/* resume UART RX in case of stopped by running out of buffers */
+	if (datamode_rx_disabled && slm_rx_stream_buf_available()) {
+		(void)uart_receive();
+		datamode_rx_disabled = false;
+	}
+
+	return ret;
+}
+
+static void raw_send(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	(void)stream_send();
+}
+
+static void terminator_timeout(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	/* Data received after the terminator is sent first, together with it */
+	if (stream_send() == 0 && slm_rx_stream_terminated()) {
+		slm_rx_stream_held_drop();
+		k_work_submit(&datamode_quit_work);
+		LOG_INF("datamode off pending");
+	}
+}
+#else
 static void raw_send(struct k_work *work)
 {
 	uint8_t *data = NULL;
@@ -550,6 +784,7 @@ static void inactivity_timer_handler(struct k_timer *timer)
 }
 
 K_TIMER_DEFINE(inactivity_timer, inactivity_timer_handler, NULL);
+#endif /* CONFIG_SLM_DATAMODE_STREAMING */
 
 static void datamode_quit(struct k_work *work)
 {
@@ -564,6 +799,7 @@ static void datamode_quit(struct k_work *work)
 	(void)exit_datamode(0);
 }
 
+#if !defined(CONFIG_SLM_DATAMODE_STREAMING)
 static int raw_rx_handler(const uint8_t *data, int datalen)
 {
 	int ret;
@@ -590,6 +826,8 @@ static int raw_rx_handler(const uint8_t *data, int datalen)
 	return 0;
 }
 
+#endif /* CONFIG_SLM_DATAMODE_STREAMING */
+
 /*
  * Check AT command grammar based on below.
  *  AT<NULL>
@@ -854,7 +1092,10 @@ static int cmd_rx_handler(uint8_t character)
 	return 0;
 
 send:
-	uart_rx_disable(uart_dev);
+	/* Multiplexed data keeps flowing while the command is handled */
+	if (slm_operation_mode != SLM_MUX_MODE) {
+		uart_rx_disable(uart_dev);
+	}
 
 	at_buf[at_cmd_len] = '\0';
 	at_buf_len = at_cmd_len;
@@ -868,6 +1109,17 @@ send:
 	return 0;
 }
 
+#if defined(CONFIG_SLM_MUX)
+void muxmode_cmd_rx(const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		if (cmd_rx_handler(data[i])) {
+			return;
+		}
+	}
+}
+#endif /* CONFIG_SLM_MUX */
+
 static void uart_callback(const struct device *dev, struct uart_event *evt, void *user_data)
 {
 	int err;
@@ -897,10 +1149,23 @@ static void uart_callback(const struct device *dev, struct uart_event *evt, void
 			}
 		} else if (slm_operation_mode == SLM_DATA_MODE) {
 			LOG_DBG("RX_RDY %d", evt->data.rx.len);
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+			err = slm_rx_stream_chunk_put(&(evt->data.rx.buf[pos]), evt->data.rx.len);
+			if (err) {
+				uart_rx_disable(uart_dev);
+				return;
+			}
+			k_work_submit(&raw_send_work);
+#else
 			err = raw_rx_handler(&(evt->data.rx.buf[pos]), evt->data.rx.len);
 			if (err) {
 				return;
 			}
+#endif
+#if defined(CONFIG_SLM_MUX)
+		} else if (slm_operation_mode == SLM_MUX_MODE) {
+			muxmode_rx_handler(&(evt->data.rx.buf[pos]), evt->data.rx.len);
+#endif
 #if defined(CONFIG_SLM_NRF52_DFU_LEGACY)
 		} else if (slm_operation_mode == SLM_DFU_MODE) {
 			(void)dfu_rx_handler(&(evt->data.rx.buf[pos]), evt->data.rx.len);
@@ -912,13 +1177,36 @@ static void uart_callback(const struct device *dev, struct uart_event *evt, void
 		break;
 	case UART_RX_BUF_REQUEST:
 		pos = 0;
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+		{
+			uint8_t *buf = slm_rx_stream_buf_alloc();
+
+			/* Without a next buffer, RX stops when the current one is full,
+			 * and the host is held off by flow control until a buffer is free.
+			 */
+			if (buf == NULL) {
+				LOG_DBG("UART RX buffers exhausted");
+				break;
+			}
+			err = uart_rx_buf_rsp(uart_dev, buf, CONFIG_SLM_DATAMODE_STREAMING_BUF_SIZE);
+			if (err) {
+				LOG_WRN("UART RX buf rsp: %d", err);
+				slm_rx_stream_buf_release(buf);
+			}
+		}
+#else
 		err = uart_rx_buf_rsp(uart_dev, next_buf, sizeof(uart_rx_buf[0]));
 		if (err) {
 			LOG_WRN("UART RX buf rsp: %d", err);
 		}
+#endif
 		break;
 	case UART_RX_BUF_RELEASED:
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+		slm_rx_stream_buf_release(evt->data.rx_buf.buf);
+#else
 		next_buf = evt->data.rx_buf.buf;
+#endif
 		break;
 	case UART_RX_STOPPED:
 		LOG_WRN("RX_STOPPED (%d)", evt->data.rx_stop.reason);
@@ -1007,6 +1295,9 @@ int slm_at_host_init(void)
 		LOG_ERR("Cannot set callback: %d", err);
 		return -EFAULT;
 	}
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+	slm_rx_stream_init();
+#endif
 	err = uart_receive();
 	if (err) {
 		return -EFAULT;
@@ -1030,6 +1321,9 @@ int slm_at_host_init(void)
 	k_work_init(&raw_send_work, raw_send);
 	k_work_init(&cmd_send_work, cmd_send);
 	k_work_init(&datamode_quit_work, datamode_quit);
+#if defined(CONFIG_SLM_DATAMODE_STREAMING)
+	k_work_init_delayable(&terminator_work, terminator_timeout);
+#endif
 	k_work_init(&delayed_send_work, delayed_send);
 	k_work_init_delayable(&uart_recovery_work, uart_recovery);
 	k_sem_give(&tx_done);
@@ -1045,9 +1339,11 @@ void slm_at_host_uninit(void)
 {
 	int err;
 
+#if !defined(CONFIG_SLM_DATAMODE_STREAMING)
 	if (slm_operation_mode == SLM_DATA_MODE) {
 		k_timer_stop(&inactivity_timer);
 	}
+#endif
 	datamode_handler = NULL;
 
 	slm_at_uninit();
@@ -34,6 +34,12 @@ enum slm_datamode_operation {
  */
 typedef int (*slm_datamode_handler_t)(uint8_t op, const uint8_t *data, int len);
 
+/**@brief Multiplexed mode UART RX handler type, called from ISR. */
+typedef void (*slm_muxmode_rx_handler_t)(const uint8_t *data, size_t len);
+
+/**@brief Multiplexed mode AT response and notification sending handler type. */
+typedef void (*slm_muxmode_tx_handler_t)(const uint8_t *data, size_t len);
+
 /**
  * @brief Initialize AT host for serial LTE modem
  *
@@ -60,12 +66,23 @@ void rsp_send(const char *str, size_t len);
 /**
  * @brief Send raw data received in data mode
  *
+ * In multiplexed mode, the data is sent in frames on the AT channel.
+ *
  * @param data Raw data received
  * @param len Length of raw data
  *
  */
 void data_send(const uint8_t *data, size_t len);
 
+/**
+ * @brief Send raw data without copying it
+ *
+ * @param data Raw data in a buffer allocated with k_malloc(), freed by SLM AT host
+ * @param len Length of raw data
+ *
+ */
+void data_send_nocopy(uint8_t *data, size_t len);
+
 /**
  * @brief Request SLM AT host to enter data mode
  *
@@ -94,6 +111,51 @@ bool in_datamode(void);
  *         false If not in data mode.
  */
 bool exit_datamode(int result);
+
+/**
+ * @brief Request SLM AT host to enter multiplexed mode
+ *
+ * All UART RX data goes to the RX handler, and AT responses and notifications
+ * are given to the TX handler instead of being sent over UART.
+ *
+ * @param rx_handler UART RX handler provided by the multiplexer
+ * @param tx_handler AT response handler provided by the multiplexer
+ *
+ * @retval 0 If the operation was successful.
+ *         Otherwise, a (negative) error code is returned.
+ */
+int enter_muxmode(slm_muxmode_rx_handler_t rx_handler, slm_muxmode_tx_handler_t tx_handler);
+
+/**
+ * @brief Check whether SLM AT host is in multiplexed mode
+ *
+ * @retval true if yes, false if no.
+ */
+bool in_muxmode(void);
+
+/**
+ * @brief Request SLM AT host to exit multiplexed mode
+ *
+ * @retval true If normal exit from multiplexed mode.
+ *         false If not in multiplexed mode.
+ */
+bool exit_muxmode(void);
+
+/**
+ * @brief Send a frame built by the multiplexer over UART as it is
+ *
+ * @param frame Frame in a buffer allocated with k_malloc(), freed by SLM AT host
+ * @param len Length of the frame
+ */
+void muxmode_frame_send(uint8_t *frame, size_t len);
+
+/**
+ * @brief Handle AT command characters received on the multiplexed AT channel
+ *
+ * @param data Received characters
+ * @param len Number of received characters
+ */
+void muxmode_cmd_rx(const uint8_t *data, size_t len);
 /** @} */
 
 #endif /* SLM_AT_HOST_ */
@@ -13,6 +13,8 @@
 #include <zephyr/net/tls_credentials.h>
 #include "slm_util.h"
 #include "slm_at_host.h"
+#include "slm_mux.h"
+#include "slm_poller.h"
 #include "slm_at_socket.h"
 #include "slm_native_tls.h"
 
@@ -61,6 +63,12 @@ static struct slm_socket {
 static struct pollfd fds[SLM_MAX_SOCKET_COUNT];
 static struct slm_socket sock;
 
+/* Sockets read in the background */
+static struct socket_rx {
+	struct slm_poller_item item;
+	uint16_t type;
+} socks_rx[SLM_MAX_SOCKET_COUNT];
+
 /* global variable defined in different files */
 extern struct at_param_list at_param_list;
 extern char rsp_buf[SLM_AT_CMD_RESPONSE_MAX_LEN];
@@ -106,6 +114,114 @@ static int find_avail_socket(void)
 	return -ENOENT;
 }
 
+static struct socket_rx *socket_rx_find(int fd)
+{
+	for (int i = 0; i < SLM_MAX_SOCKET_COUNT; i++) {
+		if (socks_rx[i].item.fd == fd) {
+			return &socks_rx[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Data received in the background, sent to the multiplexer channel of the socket
+ * or pushed to the host
+ */
+static void socket_rx_handler(struct slm_poller_item *item, short revents)
+{
+	struct socket_rx *rx = CONTAINER_OF(item, struct socket_rx, item);
+	int fd = item->fd;
+	uint8_t *rx_data;
+	int ret;
+	int err;
+
+	if (!IS_ENABLED(CONFIG_SLM_SOCKET_RX_PUSH) && !slm_mux_is_bound(fd)) {
+		/* Unbound, leave the data to AT#XRECV */
+		return;
+	}
+	if ((revents & POLLIN) != POLLIN) {
+		LOG_WRN("Socket %d poll events 0x%x", fd, revents);
+		slm_mux_close(fd);
+		return;
+	}
+
+	rx_data = k_malloc(SLM_MAX_PAYLOAD);
+	if (rx_data == NULL) {
+		LOG_ERR("No ram buffer, socket %d not read", fd);
+		return;
+	}
+	ret = recv(fd, (void *)rx_data, SLM_MAX_PAYLOAD, MSG_DONTWAIT);
+	if (ret < 0 && errno == EAGAIN) {
+		k_free(rx_data);
+		slm_poller_arm(item);
+		return;
+	}
+	if (ret < 0 || (ret == 0 && rx->type == SOCK_STREAM)) {
+		LOG_INF("Socket %d closed: %d", fd, ret ? -errno : 0);
+		k_free(rx_data);
+		if (slm_mux_is_bound(fd)) {
+			slm_mux_close(fd);
+		} else if (ret == 0) {
+			sprintf(rsp_buf, "\r\n#XRECV: %d,0\r\n", fd);
+			rsp_send(rsp_buf, strlen(rsp_buf));
+		}
+		return;
+	}
+
+	err = (ret > 0) ? slm_mux_data_send(fd, rx_data, ret, item) : 0;
+	if (err != -ENOENT) {
+		k_free(rx_data);
+		if (err == -EINPROGRESS) {
+			/* Re-armed once the host has taken the data */
+			return;
+		}
+	} else if (!IS_ENABLED(CONFIG_SLM_SOCKET_RX_PUSH)) {
+		LOG_WRN("Socket %d unbound, %d bytes dropped", fd, ret);
+		k_free(rx_data);
+		return;
+	} else if (in_datamode()) {
+		data_send_nocopy(rx_data, ret);
+	} else {
+		sprintf(rsp_buf, "\r\n#XRECV: %d,%d\r\n", fd, ret);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+		data_send_nocopy(rx_data, ret);
+	}
+	slm_poller_arm(item);
+}
+
+/* Read the socket in the background */
+static void socket_rx_start(int fd, uint16_t type)
+{
+	struct socket_rx *rx = socket_rx_find(fd);
+
+	if (rx != NULL) {
+		slm_poller_arm(&rx->item);
+		return;
+	}
+	rx = socket_rx_find(INVALID_SOCKET);
+	if (rx == NULL) {
+		LOG_ERR("Socket %d not read in the background", fd);
+		return;
+	}
+	rx->type = type;
+	(void)slm_poller_add(&rx->item, fd, POLLIN);
+}
+
+/* To be called before closing the socket */
+static void socket_rx_stop(int fd)
+{
+	struct socket_rx *rx;
+
+	if (fd == INVALID_SOCKET) {
+		return;
+	}
+	rx = socket_rx_find(fd);
+	if (rx != NULL) {
+		slm_poller_remove(&rx->item);
+	}
+}
+
 static int bind_to_device(uint16_t cid)
 {
 	int ret = 0;
@@ -267,12 +383,16 @@ static int do_socket_close(void)
 	}
 #endif
 	if (sock.fd_peer != INVALID_SOCKET) {
+		slm_mux_unbind(sock.fd_peer);
+		socket_rx_stop(sock.fd_peer);
 		ret = close(sock.fd_peer);
 		if (ret) {
 			LOG_WRN("peer close() error: %d", -errno);
 		}
 		sock.fd_peer = INVALID_SOCKET;
 	}
+	slm_mux_unbind(sock.fd);
+	socket_rx_stop(sock.fd);
 	ret = close(sock.fd);
 	if (ret) {
 		LOG_WRN("close() error: %d", -errno);
@@ -559,6 +679,9 @@ static int do_bind(uint16_t port)
 	} else {
 		return -EINVAL;
 	}
+	if (IS_ENABLED(CONFIG_SLM_SOCKET_RX_PUSH) && sock.type == SOCK_DGRAM) {
+		socket_rx_start(sock.fd, sock.type);
+	}
 
 	return 0;
 }
@@ -588,6 +711,9 @@ static int do_connect(const char *url, uint16_t port)
 
 	sprintf(rsp_buf, "\r\n#XCONNECT: 1\r\n");
 	rsp_send(rsp_buf, strlen(rsp_buf));
+	if (IS_ENABLED(CONFIG_SLM_SOCKET_RX_PUSH)) {
+		socket_rx_start(sock.fd, sock.type);
+	}
 
 	return ret;
 }
@@ -643,8 +769,16 @@ static int do_accept(int timeout)
 	} else {
 		return -EINVAL;
 	}
+	for (int i = 0; i < SLM_MAX_SOCKET_COUNT; i++) {
+		if (socks[i].fd == sock.fd) {
+			socks[i].fd_peer = sock.fd_peer;
+		}
+	}
 	sprintf(rsp_buf, "\r\n#XACCEPT: %d,\"%s\"\r\n", sock.fd_peer, peer_addr);
 	rsp_send(rsp_buf, strlen(rsp_buf));
+	if (IS_ENABLED(CONFIG_SLM_SOCKET_RX_PUSH)) {
+		socket_rx_start(sock.fd_peer, SOCK_STREAM);
+	}
 
 	return 0;
 }
@@ -727,7 +861,7 @@ static int do_recv(int timeout, int flags)
 {
 	int ret;
 	int sockfd = sock.fd;
-	char rx_data[SLM_MAX_PAYLOAD];
+	char *rx_data;
 	uint16_t length;
 
 	/* For TCP/TLS Server, receive from incoming socket */
@@ -760,9 +894,15 @@ static int do_recv(int timeout, int flags)
 	if (ret) {
 		return ret;
 	}
+	/* Receive into a heap buffer handed over to UART TX, without copying */
+	rx_data = k_malloc(length);
+	if (rx_data == NULL) {
+		return -ENOMEM;
+	}
 	ret = recv(sockfd, (void *)rx_data, length, flags);
 	if (ret < 0) {
 		LOG_WRN("recv() error: %d", -errno);
+		k_free(rx_data);
 		return -errno;
 	}
 	/**
@@ -774,10 +914,11 @@ static int do_recv(int timeout, int flags)
 	 */
 	if (ret == 0) {
 		LOG_WRN("recv() return 0");
+		k_free(rx_data);
 	} else {
 		sprintf(rsp_buf, "\r\n#XRECV: %d\r\n", ret);
 		rsp_send(rsp_buf, strlen(rsp_buf));
-		rsp_send(rx_data, ret);
+		data_send_nocopy(rx_data, ret);
 		ret = 0;
 	}
 
@@ -872,7 +1013,7 @@ static int do_recvfrom(int timeout, int flags)
 	int ret;
 	struct sockaddr remote;
 	socklen_t addrlen = sizeof(struct sockaddr);
-	char rx_data[SLM_MAX_PAYLOAD];
+	char *rx_data;
 	int length;
 
 	if (sock.family == AF_INET) {
@@ -884,9 +1025,14 @@ static int do_recvfrom(int timeout, int flags)
 	if (ret) {
 		return ret;
 	}
+	rx_data = k_malloc(length);
+	if (rx_data == NULL) {
+		return -ENOMEM;
+	}
 	ret = recvfrom(sock.fd, (void *)rx_data, length, flags, &remote, &addrlen);
 	if (ret < 0) {
 		LOG_ERR("recvfrom() error: %d", -errno);
+		k_free(rx_data);
 		return -errno;
 	}
 	/**
@@ -896,6 +1042,7 @@ static int do_recvfrom(int timeout, int flags)
 	 */
 	if (ret == 0) {
 		LOG_WRN("recvfrom() return 0");
+		k_free(rx_data);
 	} else {
 		char peer_addr[NET_IPV6_ADDR_LEN] = {0};
 
@@ -908,7 +1055,7 @@ static int do_recvfrom(int timeout, int flags)
 		}
 		sprintf(rsp_buf, "\r\n#XRECVFROM: %d,\"%s\"\r\n", ret, peer_addr);
 		rsp_send(rsp_buf, strlen(rsp_buf));
-		rsp_send(rx_data, ret);
+		data_send_nocopy(rx_data, ret);
 	}
 
 	return 0;
@@ -916,7 +1063,7 @@ static int do_recvfrom(int timeout, int flags)
 
 static int do_poll(int timeout)
 {
-	int ret = poll(fds, SLM_MAX_SOCKET_COUNT, timeout);
+	int ret = slm_poller_wait(fds, SLM_MAX_SOCKET_COUNT, timeout);
 
 	if (ret < 0) {
 		sprintf(rsp_buf, "\r\n#XPOLL: %d\r\n", ret);
@@ -950,10 +1097,9 @@ static int socket_poll(int sock_fd, int event, int timeout)
 		return 0;
 	}
 
-	ret = poll(&fd, 1, MSEC_PER_SEC * timeout);
+	ret = slm_poller_wait(&fd, 1, MSEC_PER_SEC * timeout);
 	if (ret < 0) {
-		LOG_WRN("poll() error: %d", -errno);
-		return -errno;
+		return ret;
 	} else if (ret == 0) {
 		LOG_WRN("poll() timeout");
 		return -EAGAIN;
@@ -1713,6 +1859,37 @@ int handle_at_poll(enum at_cmd_type cmd_type)
 	return err;
 }
 
+void slm_at_socket_rx_start(int fd)
+{
+	if (fd == INVALID_SOCKET) {
+		return;
+	}
+	for (int i = 0; i < SLM_MAX_SOCKET_COUNT; i++) {
+		if (socks[i].fd == fd) {
+			socket_rx_start(fd, socks[i].type);
+			return;
+		}
+		if (socks[i].fd_peer == fd) {
+			socket_rx_start(fd, SOCK_STREAM);
+			return;
+		}
+	}
+}
+
+bool slm_at_socket_is_open(int fd)
+{
+	if (fd == INVALID_SOCKET) {
+		return false;
+	}
+	for (int i = 0; i < SLM_MAX_SOCKET_COUNT; i++) {
+		if (socks[i].fd == fd || socks[i].fd_peer == fd) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /**@brief API to initialize Socket AT commands handler
  */
 int slm_at_socket_init(void)
@@ -1720,6 +1897,7 @@ int slm_at_socket_init(void)
 	INIT_SOCKET(sock);
 	for (int i = 0; i < SLM_MAX_SOCKET_COUNT; i++) {
 		INIT_SOCKET(socks[i]);
+		slm_poller_item_init(&socks_rx[i].item, socket_rx_handler);
 	}
 	socket_ranking = 1;
 
@@ -1733,9 +1911,11 @@ int slm_at_socket_uninit(void)
 	(void)do_socket_close();
 	for (int i = 0; i < SLM_MAX_SOCKET_COUNT; i++) {
 		if (socks[i].fd_peer != INVALID_SOCKET) {
+			socket_rx_stop(socks[i].fd_peer);
 			close(socks[i].fd_peer);
 		}
 		if (socks[i].fd != INVALID_SOCKET) {
+			socket_rx_stop(socks[i].fd);
 			close(socks[i].fd);
 		}
 	}
@@ -13,6 +13,8 @@
  * @{
  */
 
+#include <stdbool.h>
+
 /**
  * @brief Initialize socket AT command parser.
  *
@@ -28,6 +30,26 @@ int slm_at_socket_init(void);
  *           Otherwise, a (negative) error code is returned.
  */
 int slm_at_socket_uninit(void);
+
+/**
+ * @brief Check whether a socket is opened by the Socket service.
+ *
+ * @param fd Socket handle.
+ *
+ * @retval true If the socket is opened by the Socket service.
+ */
+bool slm_at_socket_is_open(int fd);
+
+/**
+ * @brief Read a socket of the Socket service in the background.
+ *
+ * The received data is sent on the multiplexer channel the socket is bound
+ * to. Otherwise, it is pushed to the host with #XRECV notifications if
+ * CONFIG_SLM_SOCKET_RX_PUSH is enabled, or left to AT#XRECV.
+ *
+ * @param fd Socket handle.
+ */
+void slm_at_socket_rx_start(int fd);
 /** @} */
 
 #endif /* SLM_AT_SOCKET_ */
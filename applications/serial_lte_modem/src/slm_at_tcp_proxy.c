@@ -11,13 +11,12 @@
 #include "slm_util.h"
 #include "slm_native_tls.h"
 #include "slm_at_host.h"
+#include "slm_mux.h"
+#include "slm_poller.h"
 #include "slm_at_tcp_proxy.h"
 
 LOG_MODULE_REGISTER(slm_tcp, CONFIG_SLM_LOG_LEVEL);
 
-#define THREAD_STACK_SIZE	KB(4)
-#define THREAD_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
-
 /* Some features need future modem firmware support */
 #define SLM_TCP_PROXY_FUTURE_FEATURE	0
 
@@ -37,10 +36,6 @@ enum slm_tcp_role {
 	TCP_ROLE_SERVER
 };
 
-static struct k_thread tcp_thread;
-static K_THREAD_STACK_DEFINE(tcp_thread_stack, THREAD_STACK_SIZE);
-static bool server_stop_pending;
-
 static struct tcp_proxy {
 	int sock;		/* Socket descriptor. */
 	int family;		/* Socket address family */
@@ -49,13 +44,17 @@ static struct tcp_proxy {
 	enum slm_tcp_role role;	/* Client or Server proxy */
 } proxy;
 
+static struct slm_poller_item sock_item;	/* Listening or client socket */
+static struct slm_poller_item peer_item;	/* Socket accepted by the server */
+
 /* global variable defined in different files */
 extern struct at_param_list at_param_list;
 extern char rsp_buf[SLM_AT_CMD_RESPONSE_MAX_LEN];
 
-/** forward declaration of thread function **/
-static void tcpcli_thread_func(void *p1, void *p2, void *p3);
-static void tcpsvr_thread_func(void *p1, void *p2, void *p3);
+/** forward declaration of socket event handlers **/
+static void tcp_rx_handler(struct slm_poller_item *item, short revents);
+static void tcpsvr_listen_handler(struct slm_poller_item *item, short revents);
+static void tcpsvr_stop(int cause);
 
 static int do_tcp_server_start(uint16_t port)
 {
@@ -193,11 +192,12 @@ static int do_tcp_server_start(uint16_t port)
 		goto exit_svr;
 	}
 
-	k_thread_create(&tcp_thread, tcp_thread_stack,
-			K_THREAD_STACK_SIZEOF(tcp_thread_stack),
-			tcpsvr_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
 	proxy.role = TCP_ROLE_SERVER;
+	slm_poller_item_init(&sock_item, tcpsvr_listen_handler);
+	ret = slm_poller_add(&sock_item, proxy.sock, POLLIN);
+	if (ret) {
+		goto exit_svr;
+	}
 	sprintf(rsp_buf, "\r\n#XTCPSVR: %d,\"started\"\r\n", proxy.sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -222,34 +222,10 @@ exit_svr:
 
 static int do_tcp_server_stop(void)
 {
-	int ret;
-
 	if (proxy.sock == INVALID_SOCKET) {
 		return 0;
 	}
-#if defined(CONFIG_SLM_NATIVE_TLS)
-	if (proxy.sec_tag != INVALID_SEC_TAG) {
-		(void)slm_tls_unloadcrdl(proxy.sec_tag);
-		proxy.sec_tag = INVALID_SEC_TAG;
-	}
-#endif
-	server_stop_pending = true;
-	if (proxy.sock_peer != INVALID_SOCKET) {
-		(void)close(proxy.sock_peer);
-		proxy.sock_peer = INVALID_SOCKET;
-		sprintf(rsp_buf, "\r\n#XTCPSVR: 0,\"disconnected\"\r\n");
-		rsp_send(rsp_buf, strlen(rsp_buf));
-	} else {
-		ret = close(proxy.sock);
-		if (ret < 0) {
-			LOG_WRN("close() failed: %d", -errno);
-			return ret;
-		}
-		proxy.sock = INVALID_SOCKET;
-	}
-	if (k_thread_join(&tcp_thread, K_SECONDS(CONFIG_SLM_TCP_POLL_TIME + 1)) != 0) {
-		LOG_WRN("Wait for thread terminate failed");
-	}
+	tcpsvr_stop(0);
 
 	return 0;
 }
@@ -311,12 +287,12 @@ static int do_tcp_client_connect(const char *url, uint16_t port)
 		goto exit_cli;
 	}
 
-	k_thread_create(&tcp_thread, tcp_thread_stack,
-			K_THREAD_STACK_SIZEOF(tcp_thread_stack),
-			tcpcli_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
-
 	proxy.role = TCP_ROLE_CLIENT;
+	slm_poller_item_init(&sock_item, tcp_rx_handler);
+	ret = slm_poller_add(&sock_item, proxy.sock, POLLIN);
+	if (ret) {
+		goto exit_cli;
+	}
 	sprintf(rsp_buf, "\r\n#XTCPCLI: %d,\"connected\"\r\n", proxy.sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -338,6 +314,12 @@ static int do_tcp_client_disconnect(void)
 	if (proxy.sock == INVALID_SOCKET) {
 		return 0;
 	}
+	slm_mux_unbind(proxy.sock);
+	slm_poller_remove(&sock_item);
+	if (proxy.sock == INVALID_SOCKET) {
+		/* Disconnected by remote meanwhile */
+		return 0;
+	}
 	ret = close(proxy.sock);
 	if (ret < 0) {
 		LOG_WRN("close() failed: %d", -errno);
@@ -345,10 +327,6 @@ static int do_tcp_client_disconnect(void)
 	} else {
 		proxy.sock = INVALID_SOCKET;
 	}
-	if (ret == 0 &&
-	    k_thread_join(&tcp_thread, K_SECONDS(CONFIG_SLM_TCP_POLL_TIME * 2)) != 0) {
-		LOG_WRN("Wait for thread terminate failed");
-	}
 	sprintf(rsp_buf, "\r\n#XTCPCLI: %d,\"disconnected\"\r\n", ret);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -429,6 +407,8 @@ static void tcpsvr_terminate_connection(int cause)
 		(void)exit_datamode(cause);
 	}
 	if (proxy.sock_peer != INVALID_SOCKET) {
+		slm_mux_unbind(proxy.sock_peer);
+		slm_poller_remove(&peer_item);
 		close(proxy.sock_peer);
 		proxy.sock_peer = INVALID_SOCKET;
 		sprintf(rsp_buf, "\r\n#XTCPSVR: %d,\"disconnected\"\r\n", cause);
@@ -436,236 +416,174 @@ static void tcpsvr_terminate_connection(int cause)
 	}
 }
 
-/* TCP server thread */
-static void tcpsvr_thread_func(void *p1, void *p2, void *p3)
+/* Stop the server, by AT command or on listening socket error */
+static void tcpsvr_stop(int cause)
 {
-	int ret;
-	struct pollfd fds[2];
-
-	ARG_UNUSED(p1);
-	ARG_UNUSED(p2);
-	ARG_UNUSED(p3);
-
-	fds[0].fd = proxy.sock;
-	fds[0].events = POLLIN;
-	/** The field fd contains a file descriptor for an open file.  If this field is negative,
-	 * then the corresponding events field is ignored and the revents field returns zero.
-	 */
-	fds[1].fd = INVALID_SOCKET;
-	fds[1].events = POLLIN;
-	while (true) {
-		ret = poll(fds, 2, MSEC_PER_SEC * CONFIG_SLM_TCP_POLL_TIME);
-		if (server_stop_pending) {  /* server wait to stop */
-			ret = 0;
-			break;
-		}
-		if (ret < 0) { /* IO error */
-			LOG_WRN("poll() error: %d", -errno);
-			ret = -EIO;
-			break;
-		}
-		if (ret == 0) { /* timeout */
-			continue;
-		}
-		LOG_DBG("fds[0] events 0x%08x", fds[0].revents);
-		LOG_DBG("fds[1] events 0x%08x", fds[1].revents);
-		/* Listening socket events must be handled first*/
-		if (fds[0].revents) {
-			if ((fds[0].revents & POLLERR) == POLLERR) {
-				LOG_ERR("0: POLLERR");
-				ret = -EIO;
-				break;
-			}
-			if ((fds[0].revents & POLLHUP) == POLLHUP) {
-				LOG_WRN("0: POLLHUP");
-				ret = -ECONNRESET;
-				break;
-			}
-			if ((fds[0].revents & POLLNVAL) == POLLNVAL) {
-				/* server stopped by AT command */
-				LOG_WRN("0: POLLNVAL");
-				ret = -ENETDOWN;
-				break;
-			}
-			if ((fds[0].revents & POLLIN) != POLLIN) {
-				/* Ignore and check whether there are client events */
-				goto client_events;
-			}
-
-			/* Accept incoming connection */
-			char peer_addr[INET6_ADDRSTRLEN] = {0};
-			socklen_t len;
-
-			if (proxy.family == AF_INET) {
-				struct sockaddr_in client;
-
-				len = sizeof(struct sockaddr_in);
-				ret = accept(proxy.sock, (struct sockaddr *)&client, &len);
-				if (ret == -1) {
-					LOG_WRN("accept(ipv4) error: %d", -errno);
-					goto client_events;
-				}
-				(void)inet_ntop(AF_INET, &client.sin_addr, peer_addr,
-					sizeof(peer_addr));
-			} else {
-				struct sockaddr_in6 client;
-
-				len = sizeof(struct sockaddr_in6);
-				ret = accept(proxy.sock, (struct sockaddr *)&client, &len);
-				if (ret == -1) {
-					LOG_WRN("accept(ipv6) error: %d", -errno);
-					goto client_events;
-				}
-				(void)inet_ntop(AF_INET6, &client.sin6_addr, peer_addr,
-					sizeof(peer_addr));
-			}
-			if (fds[1].fd >= 0) {
-				LOG_WRN("Full. Close connection.");
-				close(ret);
-				goto client_events;
-			}
-			proxy.sock_peer = ret;
-			fds[1].fd = proxy.sock_peer;
-			sprintf(rsp_buf, "\r\n#XTCPSVR: \"%s\",\"connected\"\r\n", peer_addr);
-			rsp_send(rsp_buf, strlen(rsp_buf));
-			LOG_DBG("New connection - %d", proxy.sock_peer);
-		}
-client_events:
-		/* Incoming socket events */
-		if (fds[1].revents) {
-			if ((fds[1].revents & POLLERR) == POLLERR) {
-				LOG_ERR("1: POLLERR");
-				tcpsvr_terminate_connection(-EIO);
-				fds[1].fd = INVALID_SOCKET;
-				continue;
-			}
-			if ((fds[1].revents & POLLHUP) == POLLHUP) {
-				LOG_ERR("1: POLLHUP");
-				tcpsvr_terminate_connection(-ECONNRESET);
-				fds[1].fd = INVALID_SOCKET;
-				continue;
-			}
-			if ((fds[1].revents & POLLNVAL) == POLLNVAL) {
-				LOG_WRN("1: POLLNVAL");
-				tcpsvr_terminate_connection(-ENETDOWN);
-				fds[1].fd = INVALID_SOCKET;
-				continue;
-			}
-			if ((fds[1].revents & POLLIN) != POLLIN) {
-				continue;
-			}
-			/* Receive data */
-			char rx_data[SLM_MAX_PAYLOAD];
-
-			ret = recv(fds[1].fd, (void *)rx_data, sizeof(rx_data), 0);
-			if (ret < 0) {
-				LOG_WRN("recv() error: %d", -errno);
-				continue;
-			}
-			if (ret == 0) {
-				continue;
-			}
-			if (in_datamode()) {
-				data_send(rx_data, ret);
-			} else {
-				rsp_send(rx_data, ret);
-				sprintf(rsp_buf, "\r\n#XTCPDATA: %d\r\n", ret);
-				rsp_send(rsp_buf, strlen(rsp_buf));
-			}
-		}
-	}
-
+	slm_poller_remove(&sock_item);
 #if defined(CONFIG_SLM_NATIVE_TLS)
 	if (proxy.sec_tag != INVALID_SEC_TAG) {
 		(void)slm_tls_unloadcrdl(proxy.sec_tag);
 		proxy.sec_tag = INVALID_SEC_TAG;
 	}
 #endif
-	tcpsvr_terminate_connection(ret);
+	tcpsvr_terminate_connection(cause);
 	if (proxy.sock != INVALID_SOCKET) {
+		slm_mux_unbind(proxy.sock);
 		(void)close(proxy.sock);
 		proxy.sock = INVALID_SOCKET;
 	}
-	sprintf(rsp_buf, "\r\n#XTCPSVR: %d,\"stopped\"\r\n", ret);
+	sprintf(rsp_buf, "\r\n#XTCPSVR: %d,\"stopped\"\r\n", cause);
 	rsp_send(rsp_buf, strlen(rsp_buf));
-	server_stop_pending = false;
-	LOG_INF("TCP server thread terminated");
 }
 
-/* TCP client thread */
-static void tcpcli_thread_func(void *p1, void *p2, void *p3)
+/* Client disconnected by remote or lose LTE connection */
+static void tcpcli_terminate_connection(int cause)
+{
+	slm_poller_remove(&sock_item);
+	if (in_datamode()) {
+		(void)exit_datamode(cause);
+	}
+	if (proxy.sock != INVALID_SOCKET) {
+		slm_mux_unbind(proxy.sock);
+		(void)close(proxy.sock);
+		proxy.sock = INVALID_SOCKET;
+		sprintf(rsp_buf, "\r\n#XTCPCLI: %d,\"disconnected\"\r\n", cause);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+	}
+}
+
+static void tcp_terminate_connection(int cause)
 {
+	if (proxy.role == TCP_ROLE_SERVER) {
+		tcpsvr_terminate_connection(cause);
+	} else {
+		tcpcli_terminate_connection(cause);
+	}
+}
+
+/* Listening socket events */
+static void tcpsvr_listen_handler(struct slm_poller_item *item, short revents)
+{
+	char peer_addr[INET6_ADDRSTRLEN] = {0};
+	socklen_t len;
 	int ret;
-	static struct pollfd fds;
-
-	ARG_UNUSED(p1);
-	ARG_UNUSED(p2);
-	ARG_UNUSED(p3);
-
-	fds.fd = proxy.sock;
-	fds.events = POLLIN;
-	while (true) {
-		ret = poll(&fds, 1, MSEC_PER_SEC * CONFIG_SLM_TCP_POLL_TIME);
-		if (ret < 0) {  /* IO error */
-			LOG_WRN("poll() error: %d", ret);
-			ret = -EIO;
-			break;
-		}
-		if (ret == 0) {  /* timeout */
-			continue;
-		}
-		LOG_DBG("Poll events 0x%08x", fds.revents);
-		if ((fds.revents & POLLERR) == POLLERR) {
-			LOG_ERR("POLLERR");
-			ret = -EIO;
-			break;
-		}
-		if ((fds.revents & POLLNVAL) == POLLNVAL) {
-			/* client disconnected locally by AT command */
-			LOG_WRN("POLLNVAL");
-			ret = -ENETDOWN;
-			break;
-		}
-		if ((fds.revents & POLLHUP) == POLLHUP) {
-			/* client disconnected by remote or lose LTE connection */
-			LOG_WRN("POLLHUP");
-			ret = -ECONNRESET;
-			break;
-		}
-		if ((fds.revents & POLLIN) != POLLIN) {
-			continue;
-		}
-		/* Receive data */
-		char rx_data[SLM_MAX_PAYLOAD];
 
-		ret = recv(fds.fd, (void *)rx_data, sizeof(rx_data), 0);
-		if (ret < 0) {
-			LOG_WRN("recv() error: %d", -errno);
-			continue;
-		}
-		if (ret == 0) {
-			continue;
+	LOG_DBG("Listening socket events 0x%08x", revents);
+	if ((revents & POLLERR) == POLLERR) {
+		LOG_ERR("0: POLLERR");
+		tcpsvr_stop(-EIO);
+		return;
+	}
+	if ((revents & POLLHUP) == POLLHUP) {
+		LOG_WRN("0: POLLHUP");
+		tcpsvr_stop(-ECONNRESET);
+		return;
+	}
+	if ((revents & POLLNVAL) == POLLNVAL) {
+		LOG_WRN("0: POLLNVAL");
+		tcpsvr_stop(-ENETDOWN);
+		return;
+	}
+	if ((revents & POLLIN) != POLLIN) {
+		goto rearm;
+	}
+
+	/* Accept incoming connection */
+	if (proxy.family == AF_INET) {
+		struct sockaddr_in client;
+
+		len = sizeof(struct sockaddr_in);
+		ret = accept(proxy.sock, (struct sockaddr *)&client, &len);
+		if (ret == -1) {
+			LOG_WRN("accept(ipv4) error: %d", -errno);
+			goto rearm;
 		}
-		if (in_datamode()) {
-			data_send(rx_data, ret);
-		} else {
-			rsp_send(rx_data, ret);
-			sprintf(rsp_buf, "\r\n#XTCPDATA: %d\r\n", ret);
-			rsp_send(rsp_buf, strlen(rsp_buf));
+		(void)inet_ntop(AF_INET, &client.sin_addr, peer_addr, sizeof(peer_addr));
+	} else {
+		struct sockaddr_in6 client;
+
+		len = sizeof(struct sockaddr_in6);
+		ret = accept(proxy.sock, (struct sockaddr *)&client, &len);
+		if (ret == -1) {
+			LOG_WRN("accept(ipv6) error: %d", -errno);
+			goto rearm;
 		}
+		(void)inet_ntop(AF_INET6, &client.sin6_addr, peer_addr, sizeof(peer_addr));
 	}
+	if (proxy.sock_peer != INVALID_SOCKET) {
+		LOG_WRN("Full. Close connection.");
+		close(ret);
+		goto rearm;
+	}
+	if (slm_poller_add(&peer_item, ret, POLLIN) != 0) {
+		close(ret);
+		goto rearm;
+	}
+	proxy.sock_peer = ret;
+	sprintf(rsp_buf, "\r\n#XTCPSVR: \"%s\",\"connected\"\r\n", peer_addr);
+	rsp_send(rsp_buf, strlen(rsp_buf));
+	LOG_DBG("New connection - %d", proxy.sock_peer);
 
-	if (in_datamode()) {
-		(void)exit_datamode(ret);
+rearm:
+	slm_poller_arm(item);
+}
+
+/* Client socket or incoming socket events */
+static void tcp_rx_handler(struct slm_poller_item *item, short revents)
+{
+	char rx_data[SLM_MAX_PAYLOAD];
+	int fd = item->fd;
+	int ret;
+	int err;
+
+	LOG_DBG("Poll events 0x%08x", revents);
+	if ((revents & POLLERR) == POLLERR) {
+		LOG_ERR("POLLERR");
+		tcp_terminate_connection(-EIO);
+		return;
 	}
-	if (proxy.sock != INVALID_SOCKET) {
-		(void)close(proxy.sock);
-		proxy.sock = INVALID_SOCKET;
-		sprintf(rsp_buf, "\r\n#XTCPCLI: %d,\"disconnected\"\r\n", ret);
+	if ((revents & POLLNVAL) == POLLNVAL) {
+		LOG_WRN("POLLNVAL");
+		tcp_terminate_connection(-ENETDOWN);
+		return;
+	}
+	if ((revents & POLLHUP) == POLLHUP) {
+		/* Disconnected by remote or lose LTE connection */
+		LOG_WRN("POLLHUP");
+		tcp_terminate_connection(-ECONNRESET);
+		return;
+	}
+	if ((revents & POLLIN) != POLLIN) {
+		goto rearm;
+	}
+
+	/* Receive data */
+	ret = recv(fd, (void *)rx_data, sizeof(rx_data), 0);
+	if (ret < 0) {
+		LOG_WRN("recv() error: %d", -errno);
+		goto rearm;
+	}
+	if (ret == 0) {
+		goto rearm;
+	}
+	err = slm_mux_data_send(fd, rx_data, ret, item);
+	if (err == -EINPROGRESS) {
+		/* Re-armed once the host has taken the data */
+		return;
+	}
+	if (err != -ENOENT) {
+		goto rearm;
+	}
+	if (in_datamode()) {
+		data_send(rx_data, ret);
+	} else {
+		rsp_send(rx_data, ret);
+		sprintf(rsp_buf, "\r\n#XTCPDATA: %d\r\n", ret);
 		rsp_send(rsp_buf, strlen(rsp_buf));
 	}
 
-	LOG_INF("TCP client thread terminated");
+rearm:
+	slm_poller_arm(item);
 }
 
 /**@brief handle AT#XTCPSVR commands
@@ -867,6 +785,11 @@ int handle_at_tcp_hangup(enum at_cmd_type cmd_type)
 	return err;
 }
 
+bool slm_at_tcp_proxy_is_open(int fd)
+{
+	return fd != INVALID_SOCKET && (fd == proxy.sock || fd == proxy.sock_peer);
+}
+
 /**@brief API to initialize TCP proxy AT commands handler
  */
 int slm_at_tcp_proxy_init(void)
@@ -876,6 +799,8 @@ int slm_at_tcp_proxy_init(void)
 	proxy.sock_peer = INVALID_SOCKET;
 	proxy.role      = INVALID_ROLE;
 	proxy.sec_tag   = INVALID_SEC_TAG;
+	slm_poller_item_init(&sock_item, tcp_rx_handler);
+	slm_poller_item_init(&peer_item, tcp_rx_handler);
 
 	return 0;
 }
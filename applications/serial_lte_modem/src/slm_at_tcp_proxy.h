@@ -12,6 +12,8 @@
  * @brief Vendor-specific AT command for TCP proxy service.
  * @{
  */
+
+#include <stdbool.h>
 /**
  * @brief Initialize TCP proxy AT command parser.
  *
@@ -27,5 +29,14 @@ int slm_at_tcp_proxy_init(void);
  *           Otherwise, a (negative) error code is returned.
  */
 int slm_at_tcp_proxy_uninit(void);
+
+/**
+ * @brief Check whether a socket is opened by the TCP proxy.
+ *
+ * @param fd Socket handle.
+ *
+ * @retval true If the socket is opened by the TCP proxy.
+ */
+bool slm_at_tcp_proxy_is_open(int fd);
 /** @} */
 #endif /* SLM_AT_TCP_PROXY_ */
@@ -11,13 +11,12 @@
 #include <zephyr/net/tls_credentials.h>
 #include "slm_util.h"
 #include "slm_at_host.h"
+#include "slm_mux.h"
+#include "slm_poller.h"
 #include "slm_at_udp_proxy.h"
 
 LOG_MODULE_REGISTER(slm_udp, CONFIG_SLM_LOG_LEVEL);
 
-#define THREAD_STACK_SIZE	KB(4)
-#define THREAD_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
-
 /*
  * Known limitation in this version
  * - Multiple concurrent
@@ -33,10 +32,6 @@ enum slm_udp_proxy_operation {
 	CLIENT_CONNECT6 = SERVER_START6
 };
 
-static struct k_thread udp_thread;
-static K_THREAD_STACK_DEFINE(udp_thread_stack, THREAD_STACK_SIZE);
-static k_tid_t udp_thread_id;
-
 /**@brief Proxy roles. */
 enum slm_udp_role {
 	UDP_ROLE_CLIENT,
@@ -54,12 +49,14 @@ static struct udp_proxy {
 	};
 } proxy;
 
+static struct slm_poller_item sock_item;
+
 /* global variable defined in different files */
 extern struct at_param_list at_param_list;
 extern char rsp_buf[SLM_AT_CMD_RESPONSE_MAX_LEN];
 
-/** forward declaration of thread function **/
-static void udp_thread_func(void *p1, void *p2, void *p3);
+/** forward declaration of socket event handler **/
+static void udp_rx_handler(struct slm_poller_item *item, short revents);
 
 static int do_udp_server_start(uint16_t port)
 {
@@ -123,12 +120,13 @@ static int do_udp_server_start(uint16_t port)
 		return -errno;
 	}
 
-	udp_thread_id = k_thread_create(&udp_thread, udp_thread_stack,
-			K_THREAD_STACK_SIZEOF(udp_thread_stack),
-			udp_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
-
 	proxy.role = UDP_ROLE_SERVER;
+	ret = slm_poller_add(&sock_item, proxy.sock, POLLIN);
+	if (ret) {
+		close(proxy.sock);
+		proxy.sock = INVALID_SOCKET;
+		return ret;
+	}
 	sprintf(rsp_buf, "\r\n#XUDPSVR: %d,\"started\"\r\n", proxy.sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -142,6 +140,12 @@ static int do_udp_server_stop(void)
 	if (proxy.sock == INVALID_SOCKET) {
 		return 0;
 	}
+	slm_mux_unbind(proxy.sock);
+	slm_poller_remove(&sock_item);
+	if (proxy.sock == INVALID_SOCKET) {
+		/* Stopped on error meanwhile */
+		return 0;
+	}
 	ret = close(proxy.sock);
 	if (ret < 0) {
 		LOG_WRN("close() failed: %d", -errno);
@@ -155,10 +159,6 @@ static int do_udp_server_stop(void)
 		}
 		(void)slm_at_udp_proxy_init();
 	}
-	if (ret == 0 &&
-	    k_thread_join(&udp_thread, K_SECONDS(CONFIG_SLM_UDP_POLL_TIME * 2)) != 0) {
-		LOG_WRN("Wait for thread terminate failed");
-	}
 	sprintf(rsp_buf, "\r\n#XUDPSVR: %d,\"stopped\"\r\n", ret);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -215,12 +215,11 @@ static int do_udp_client_connect(const char *url, uint16_t port)
 		goto cli_exit;
 	}
 
-	udp_thread_id = k_thread_create(&udp_thread, udp_thread_stack,
-			K_THREAD_STACK_SIZEOF(udp_thread_stack),
-			udp_thread_func, NULL, NULL, NULL,
-			THREAD_PRIORITY, K_USER, K_NO_WAIT);
-
 	proxy.role = UDP_ROLE_CLIENT;
+	ret = slm_poller_add(&sock_item, proxy.sock, POLLIN);
+	if (ret) {
+		goto cli_exit;
+	}
 	sprintf(rsp_buf, "\r\n#XUDPCLI: %d,\"connected\"\r\n", proxy.sock);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -242,6 +241,12 @@ static int do_udp_client_disconnect(void)
 	if (proxy.sock == INVALID_SOCKET) {
 		return 0;
 	}
+	slm_mux_unbind(proxy.sock);
+	slm_poller_remove(&sock_item);
+	if (proxy.sock == INVALID_SOCKET) {
+		/* Disconnected on error meanwhile */
+		return 0;
+	}
 	ret = close(proxy.sock);
 	if (ret < 0) {
 		LOG_WRN("close() failed: %d", -errno);
@@ -249,10 +254,6 @@ static int do_udp_client_disconnect(void)
 	} else {
 		proxy.sock = INVALID_SOCKET;
 	}
-	if (ret == 0 &&
-	    k_thread_join(&udp_thread, K_SECONDS(CONFIG_SLM_UDP_POLL_TIME * 2)) != 0) {
-		LOG_WRN("Wait for thread terminate failed");
-	}
 	sprintf(rsp_buf, "\r\n#XUDPCLI: %d,\"disconnected\"\r\n", ret);
 	rsp_send(rsp_buf, strlen(rsp_buf));
 
@@ -333,100 +334,97 @@ static int do_udp_send_datamode(const uint8_t *data, int datalen)
 	return (offset > 0) ? offset : -1;
 }
 
-static void udp_thread_func(void *p1, void *p2, void *p3)
+/* UDP client or server closed on error */
+static void udp_terminate(int cause)
 {
-	int ret;
-	struct pollfd fds;
-
-	ARG_UNUSED(p1);
-	ARG_UNUSED(p2);
-	ARG_UNUSED(p3);
-
-	fds.fd = proxy.sock;
-	fds.events = POLLIN;
-
-	do {
-		ret = poll(&fds, 1, MSEC_PER_SEC * CONFIG_SLM_UDP_POLL_TIME);
-		if (ret < 0) {  /* IO error */
-			LOG_WRN("poll() error: %d", ret);
-			continue;
-		}
-		if (ret == 0) {  /* timeout */
-			continue;
-		}
-		LOG_DBG("Poll events 0x%08x", fds.revents);
-		if ((fds.revents & POLLERR) == POLLERR) {
-			LOG_WRN("POLLERR");
-			ret = -EIO;
-			break;
-		}
-		if ((fds.revents & POLLNVAL) == POLLNVAL) {
-			/* UDP client or server closed */
-			LOG_WRN("POLLNVAL");
-			ret = -ENETDOWN;
-			break;
-		}
-		if ((fds.revents & POLLHUP) == POLLHUP) {
-			/* Lose LTE connection */
-			LOG_WRN("POLLHUP");
-			ret = -ECONNRESET;
-			break;
-		}
-		if ((fds.revents & POLLIN) != POLLIN) {
-			continue;
-		}
-		/* Receive data */
-		char rx_data[SLM_MAX_PAYLOAD];
-
-		if (proxy.role == UDP_ROLE_SERVER) {
-			/* remember remote from last recvfrom */
-			if (proxy.family == AF_INET) {
-				int size = sizeof(struct sockaddr_in);
-
-				memset(&proxy.remote, 0, sizeof(struct sockaddr_in));
-				ret = recvfrom(proxy.sock, (void *)rx_data, sizeof(rx_data), 0,
-					(struct sockaddr *)&(proxy.remote), &size);
-			} else {
-				int size = sizeof(struct sockaddr_in6);
-
-				memset(&proxy.remote6, 0, sizeof(struct sockaddr_in6));
-				ret = recvfrom(proxy.sock, (void *)rx_data, sizeof(rx_data), 0,
-					(struct sockaddr *)&(proxy.remote6), &size);
-			}
-		} else {
-			ret = recv(proxy.sock, (void *)rx_data, sizeof(rx_data), 0);
-		}
-		if (ret < 0) {
-			LOG_WRN("recv() error: %d", -errno);
-			continue;
-		}
-		if (ret == 0) {
-			continue;
-		}
-		if (in_datamode()) {
-			data_send(rx_data, ret);
-		} else {
-			rsp_send(rx_data, ret);
-			sprintf(rsp_buf, "\r\n#XUDPDATA: %d\r\n", ret);
-			rsp_send(rsp_buf, strlen(rsp_buf));
-		}
-	} while (true);
-
+	slm_poller_remove(&sock_item);
 	if (in_datamode()) {
-		(void)exit_datamode(ret);
+		(void)exit_datamode(cause);
 	}
 	if (proxy.sock != INVALID_SOCKET) {
+		slm_mux_unbind(proxy.sock);
 		(void)close(proxy.sock);
 		proxy.sock = INVALID_SOCKET;
 		if (proxy.role == UDP_ROLE_CLIENT) {
-			sprintf(rsp_buf, "\r\n#XUDPCLI: %d,\"disconnected\"\r\n", ret);
+			sprintf(rsp_buf, "\r\n#XUDPCLI: %d,\"disconnected\"\r\n", cause);
 		} else {
-			sprintf(rsp_buf, "\r\n#XUDPSVR: %d,\"stopped\"\r\n", ret);
+			sprintf(rsp_buf, "\r\n#XUDPSVR: %d,\"stopped\"\r\n", cause);
 		}
 		rsp_send(rsp_buf, strlen(rsp_buf));
 	}
+}
+
+static void udp_rx_handler(struct slm_poller_item *item, short revents)
+{
+	char rx_data[SLM_MAX_PAYLOAD];
+	int ret;
+	int err;
+
+	LOG_DBG("Poll events 0x%08x", revents);
+	if ((revents & POLLERR) == POLLERR) {
+		LOG_WRN("POLLERR");
+		udp_terminate(-EIO);
+		return;
+	}
+	if ((revents & POLLNVAL) == POLLNVAL) {
+		LOG_WRN("POLLNVAL");
+		udp_terminate(-ENETDOWN);
+		return;
+	}
+	if ((revents & POLLHUP) == POLLHUP) {
+		/* Lose LTE connection */
+		LOG_WRN("POLLHUP");
+		udp_terminate(-ECONNRESET);
+		return;
+	}
+	if ((revents & POLLIN) != POLLIN) {
+		goto rearm;
+	}
 
-	LOG_INF("UDP thread terminated");
+	/* Receive data */
+	if (proxy.role == UDP_ROLE_SERVER) {
+		/* remember remote from last recvfrom */
+		if (proxy.family == AF_INET) {
+			int size = sizeof(struct sockaddr_in);
+
+			memset(&proxy.remote, 0, sizeof(struct sockaddr_in));
+			ret = recvfrom(proxy.sock, (void *)rx_data, sizeof(rx_data), 0,
+				(struct sockaddr *)&(proxy.remote), &size);
+		} else {
+			int size = sizeof(struct sockaddr_in6);
+
+			memset(&proxy.remote6, 0, sizeof(struct sockaddr_in6));
+			ret = recvfrom(proxy.sock, (void *)rx_data, sizeof(rx_data), 0,
+				(struct sockaddr *)&(proxy.remote6), &size);
+		}
+	} else {
+		ret = recv(proxy.sock, (void *)rx_data, sizeof(rx_data), 0);
+	}
+	if (ret < 0) {
+		LOG_WRN("recv() error: %d", -errno);
+		goto rearm;
+	}
+	if (ret == 0) {
+		goto rearm;
+	}
+	err = slm_mux_data_send(proxy.sock, rx_data, ret, item);
+	if (err == -EINPROGRESS) {
+		/* Re-armed once the host has taken the data */
+		return;
+	}
+	if (err != -ENOENT) {
+		goto rearm;
+	}
+	if (in_datamode()) {
+		data_send(rx_data, ret);
+	} else {
+		rsp_send(rx_data, ret);
+		sprintf(rsp_buf, "\r\n#XUDPDATA: %d\r\n", ret);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+	}
+
+rearm:
+	slm_poller_arm(item);
 }
 
 static int udp_datamode_callback(uint8_t op, const uint8_t *data, int len)
@@ -590,12 +588,18 @@ int handle_at_udp_send(enum at_cmd_type cmd_type)
 	return err;
 }
 
+bool slm_at_udp_proxy_is_open(int fd)
+{
+	return fd != INVALID_SOCKET && fd == proxy.sock;
+}
+
 /**@brief API to initialize UDP Proxy AT commands handler
  */
 int slm_at_udp_proxy_init(void)
 {
 	proxy.sock     = INVALID_SOCKET;
 	proxy.sec_tag  = INVALID_SEC_TAG;
+	slm_poller_item_init(&sock_item, udp_rx_handler);
 
 	return 0;
 }
@@ -607,7 +611,8 @@ int slm_at_udp_proxy_uninit(void)
 	int ret = 0;
 
 	if (proxy.sock != INVALID_SOCKET) {
-		k_thread_abort(udp_thread_id);
+		slm_mux_unbind(proxy.sock);
+		slm_poller_remove(&sock_item);
 		ret = close(proxy.sock);
 		if (ret < 0) {
 			LOG_WRN("close() failed: %d", -errno);
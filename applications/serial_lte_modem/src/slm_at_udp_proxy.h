@@ -12,6 +12,8 @@
  * @brief Vendor-specific AT command for UDP proxy service.
  * @{
  */
+
+#include <stdbool.h>
 /**
  * @brief Initialize UDP proxy AT command parser.
  *
@@ -27,5 +29,14 @@ int slm_at_udp_proxy_init(void);
  *           Otherwise, a (negative) error code is returned.
  */
 int slm_at_udp_proxy_uninit(void);
+
+/**
+ * @brief Check whether a socket is opened by the UDP proxy.
+ *
+ * @param fd Socket handle.
+ *
+ * @retval true If the socket is opened by the UDP proxy.
+ */
+bool slm_at_udp_proxy_is_open(int fd);
 /** @} */
 #endif /* SLM_AT_UDP_PROXY_ */
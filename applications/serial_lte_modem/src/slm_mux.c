@@ -0,0 +1,667 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <zephyr/net/socket.h>
+#include "slm_util.h"
+#include "slm_at_host.h"
+#include "slm_at_socket.h"
+#include "slm_at_tcp_proxy.h"
+#include "slm_at_udp_proxy.h"
+#include "slm_mux.h"
+#include "slm_poller.h"
+
+LOG_MODULE_REGISTER(slm_mux, CONFIG_SLM_LOG_LEVEL);
+
+#define MUX_SOF			0xF9
+#define MUX_HDR_LEN		5	/* SOF, channel, type, length */
+#define MUX_FCS_LEN		1
+#define MUX_FCS_INIT		0xFF
+#define MUX_CTRL_MAX_LEN	4
+
+#define MUX_CHANNEL_COUNT	(CONFIG_SLM_MUX_CHANNELS + 1)
+#define MUX_FRAME_SIZE		CONFIG_SLM_MUX_FRAME_SIZE
+#define MUX_FRAME_COUNT		(MUX_CHANNEL_COUNT * CONFIG_SLM_MUX_CREDITS)
+
+/**@brief Multiplexer operations. */
+enum slm_mux_operation {
+	MUX_STOP,
+	MUX_START,
+	MUX_BIND,
+	MUX_UNBIND
+};
+
+/**@brief Frame types. */
+enum slm_mux_frame_type {
+	MUX_DATA,
+	MUX_CREDIT,
+	MUX_CLOSE
+};
+
+/* Data frame received from the host */
+struct mux_frame {
+	void *fifo_reserved;
+	uint8_t channel;
+	uint16_t len;
+	uint8_t data[MUX_FRAME_SIZE];
+};
+
+static struct mux_channel {
+	int fd;			/* Socket bound to the channel */
+	struct k_sem credits;	/* Data frames the host can take */
+	uint8_t *pending;	/* Data waiting for credits, allocated with k_malloc() */
+	size_t pending_len;
+	size_t pending_pos;
+	struct slm_poller_item *item;	/* Re-armed once the pending data is sent */
+} channels[MUX_CHANNEL_COUNT];
+
+static struct mux_decoder {
+	enum {
+		MUX_HUNT,
+		MUX_HEADER,
+		MUX_PAYLOAD,
+		MUX_FCS
+	} state;
+	uint8_t hdr[MUX_HDR_LEN];
+	size_t hdr_len;
+	uint8_t channel;
+	uint8_t type;
+	uint16_t len;
+	uint16_t pos;
+	struct mux_frame *frame;	/* NULL when the payload is dropped */
+	uint8_t ctrl[MUX_CTRL_MAX_LEN];
+} decoder;
+
+K_MEM_SLAB_DEFINE(mux_frame_slab, sizeof(struct mux_frame), MUX_FRAME_COUNT, 4);
+static K_FIFO_DEFINE(mux_rx_fifo);
+static K_MUTEX_DEFINE(mux_lock);
+static struct k_work mux_rx_work;
+static struct k_work mux_tx_work;
+static atomic_t close_requests;
+static bool mux_running;
+
+/* global variable defined in different files */
+extern struct at_param_list at_param_list;
+extern char rsp_buf[SLM_AT_CMD_RESPONSE_MAX_LEN];
+
+static uint8_t mux_fcs(const uint8_t *hdr, const uint8_t *data, size_t len)
+{
+	uint8_t fcs = crc8_ccitt(MUX_FCS_INIT, hdr + 1, MUX_HDR_LEN - 1);
+
+	return crc8_ccitt(fcs, data, len);
+}
+
+/* Fill in header and FCS around a payload already in place */
+static size_t mux_frame_seal(uint8_t *frame, uint8_t channel, uint8_t type, size_t len)
+{
+	frame[0] = MUX_SOF;
+	frame[1] = channel;
+	frame[2] = type;
+	sys_put_le16(len, &frame[3]);
+	frame[MUX_HDR_LEN + len] = mux_fcs(frame, frame + MUX_HDR_LEN, len);
+
+	return MUX_HDR_LEN + len + MUX_FCS_LEN;
+}
+
+static int mux_frame_send(uint8_t channel, uint8_t type, const uint8_t *data, size_t len)
+{
+	uint8_t *frame = k_malloc(MUX_HDR_LEN + len + MUX_FCS_LEN);
+
+	if (frame == NULL) {
+		LOG_WRN("No ram buffer");
+		return -ENOMEM;
+	}
+	if (len > 0) {
+		memcpy(frame + MUX_HDR_LEN, data, len);
+	}
+	muxmode_frame_send(frame, mux_frame_seal(frame, channel, type, len));
+
+	return 0;
+}
+
+static void mux_credit_send(uint8_t channel, uint8_t credits)
+{
+	(void)mux_frame_send(channel, MUX_CREDIT, &credits, sizeof(credits));
+}
+
+/* AT responses and notifications, not flow controlled */
+static void mux_at_tx(const uint8_t *data, size_t len)
+{
+	while (len > 0) {
+		size_t size = MIN(len, MUX_FRAME_SIZE);
+
+		if (mux_frame_send(SLM_MUX_CHANNEL_AT, MUX_DATA, data, size)) {
+			return;
+		}
+		data += size;
+		len -= size;
+	}
+}
+
+static int mux_channel_find(int fd)
+{
+	for (int i = 1; i < MUX_CHANNEL_COUNT; i++) {
+		if (channels[i].fd == fd) {
+			return i;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/* Drop the data waiting for credits and let the socket be read again */
+static void mux_pending_drop(struct mux_channel *ch)
+{
+	k_free(ch->pending);
+	ch->pending = NULL;
+	if (ch->item != NULL) {
+		slm_poller_arm(ch->item);
+		ch->item = NULL;
+	}
+}
+
+static void mux_channel_reset(int channel)
+{
+	channels[channel].fd = INVALID_SOCKET;
+	k_sem_reset(&channels[channel].credits);
+	mux_pending_drop(&channels[channel]);
+}
+
+/* Send data frames as long as the host has credits left.
+ * Returns the length sent, or a (negative) error code.
+ */
+static int mux_data_frames_send(int channel, const uint8_t *data, size_t len)
+{
+	size_t sent = 0;
+	int err;
+
+	while (sent < len && k_sem_take(&channels[channel].credits, K_NO_WAIT) == 0) {
+		size_t size = MIN(len - sent, MUX_FRAME_SIZE);
+
+		err = mux_frame_send(channel, MUX_DATA, data + sent, size);
+		if (err) {
+			return err;
+		}
+		sent += size;
+	}
+
+	return sent;
+}
+
+static int mux_bind(int fd)
+{
+	int channel;
+	bool socket;
+
+	if (slm_at_socket_is_open(fd)) {
+		socket = true;
+	} else if (slm_at_tcp_proxy_is_open(fd) || slm_at_udp_proxy_is_open(fd)) {
+		/* The proxies read their sockets themselves */
+		socket = false;
+	} else {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&mux_lock, K_FOREVER);
+	channel = mux_channel_find(fd);
+	if (channel < 0) {
+		channel = mux_channel_find(INVALID_SOCKET);
+	}
+	if (channel > 0) {
+		channels[channel].fd = fd;
+	}
+	k_mutex_unlock(&mux_lock);
+
+	if (channel > 0 && socket) {
+		/* Let the Socket service read the socket in the background */
+		slm_at_socket_rx_start(fd);
+	}
+
+	return channel;
+}
+
+/* The channel cannot be used anymore, let the host know */
+static void mux_channel_close(int channel, int fd)
+{
+	k_mutex_lock(&mux_lock, K_FOREVER);
+	if (channels[channel].fd == fd) {
+		mux_channel_reset(channel);
+	}
+	k_mutex_unlock(&mux_lock);
+
+	(void)mux_frame_send(channel, MUX_CLOSE, NULL, 0);
+}
+
+/* Forward a data frame from the host to the socket of its channel */
+static void mux_data_forward(const struct mux_frame *frame)
+{
+	int fd = channels[frame->channel].fd;
+	size_t offset = 0;
+	int ret;
+
+	if (fd == INVALID_SOCKET) {
+		LOG_WRN("Channel %d not bound", frame->channel);
+		mux_channel_close(frame->channel, fd);
+		return;
+	}
+
+	while (offset < frame->len) {
+		ret = send(fd, frame->data + offset, frame->len - offset, 0);
+		if (ret < 0) {
+			LOG_WRN("send() failed: %d, channel %d", -errno, frame->channel);
+			mux_channel_close(frame->channel, fd);
+			return;
+		}
+		offset += ret;
+	}
+}
+
+static void mux_rx(struct k_work *work)
+{
+	struct mux_frame *frame;
+	uint8_t channel;
+
+	ARG_UNUSED(work);
+
+	for (channel = 1; channel < MUX_CHANNEL_COUNT; channel++) {
+		if (atomic_test_and_clear_bit(&close_requests, channel)) {
+			k_mutex_lock(&mux_lock, K_FOREVER);
+			mux_channel_reset(channel);
+			k_mutex_unlock(&mux_lock);
+		}
+	}
+
+	while ((frame = k_fifo_get(&mux_rx_fifo, K_NO_WAIT)) != NULL) {
+		channel = frame->channel;
+		if (channel == SLM_MUX_CHANNEL_AT) {
+			muxmode_cmd_rx(frame->data, frame->len);
+		} else {
+			mux_data_forward(frame);
+		}
+		k_mem_slab_free(&mux_frame_slab, (void **)&frame);
+		/* The frame buffer is free again */
+		if (mux_running) {
+			mux_credit_send(channel, 1);
+		}
+	}
+}
+
+/* Send the data waiting for the credits granted by the host */
+static void mux_tx(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	k_mutex_lock(&mux_lock, K_FOREVER);
+	for (int i = 1; i < MUX_CHANNEL_COUNT; i++) {
+		struct mux_channel *ch = &channels[i];
+		int ret;
+
+		if (ch->pending == NULL) {
+			continue;
+		}
+		ret = mux_data_frames_send(i, ch->pending + ch->pending_pos,
+					   ch->pending_len - ch->pending_pos);
+		if (ret >= 0) {
+			ch->pending_pos += ret;
+		}
+		if (ret < 0 || ch->pending_pos == ch->pending_len) {
+			mux_pending_drop(ch);
+		}
+	}
+	k_mutex_unlock(&mux_lock);
+}
+
+static void mux_ctrl_handle(void)
+{
+	if (decoder.channel == SLM_MUX_CHANNEL_AT) {
+		return;
+	}
+	if (decoder.type == MUX_CREDIT && decoder.len == 1) {
+		for (int i = 0; i < decoder.ctrl[0]; i++) {
+			k_sem_give(&channels[decoder.channel].credits);
+		}
+		k_work_submit(&mux_tx_work);
+	} else if (decoder.type == MUX_CLOSE) {
+		atomic_set_bit(&close_requests, decoder.channel);
+		k_work_submit(&mux_rx_work);
+	}
+}
+
+static bool mux_header_valid(void)
+{
+	decoder.channel = decoder.hdr[1];
+	decoder.type = decoder.hdr[2];
+	decoder.len = sys_get_le16(&decoder.hdr[3]);
+
+	if (decoder.channel >= MUX_CHANNEL_COUNT) {
+		return false;
+	}
+	switch (decoder.type) {
+	case MUX_DATA:
+		return decoder.len <= MUX_FRAME_SIZE;
+	case MUX_CREDIT:
+	case MUX_CLOSE:
+		return decoder.len <= MUX_CTRL_MAX_LEN;
+	default:
+		return false;
+	}
+}
+
+static void mux_header_done(void)
+{
+	decoder.pos = 0;
+	decoder.frame = NULL;
+	if (decoder.type == MUX_DATA &&
+	    k_mem_slab_alloc(&mux_frame_slab, (void **)&decoder.frame, K_NO_WAIT) != 0) {
+		LOG_WRN("No credit left, channel %d frame dropped", decoder.channel);
+	}
+	decoder.state = (decoder.len > 0) ? MUX_PAYLOAD : MUX_FCS;
+}
+
+static void mux_frame_done(uint8_t fcs)
+{
+	uint8_t *payload = (decoder.type == MUX_DATA) ?
+			   (decoder.frame ? decoder.frame->data : NULL) : decoder.ctrl;
+
+	decoder.state = MUX_HUNT;
+	if (payload == NULL) {
+		return;
+	}
+	if (fcs != mux_fcs(decoder.hdr, payload, decoder.len)) {
+		LOG_WRN("FCS error, channel %d frame dropped", decoder.channel);
+		if (decoder.frame) {
+			k_mem_slab_free(&mux_frame_slab, (void **)&decoder.frame);
+		}
+		return;
+	}
+	if (decoder.type != MUX_DATA) {
+		mux_ctrl_handle();
+		return;
+	}
+	decoder.frame->channel = decoder.channel;
+	decoder.frame->len = decoder.len;
+	k_fifo_put(&mux_rx_fifo, decoder.frame);
+	k_work_submit(&mux_rx_work);
+}
+
+/* UART RX, in ISR context */
+static void mux_uart_rx(const uint8_t *data, size_t len)
+{
+	while (len > 0) {
+		switch (decoder.state) {
+		case MUX_HUNT:
+			if (*data == MUX_SOF) {
+				decoder.hdr[0] = MUX_SOF;
+				decoder.hdr_len = 1;
+				decoder.state = MUX_HEADER;
+			}
+			data++;
+			len--;
+			break;
+
+		case MUX_HEADER:
+			decoder.hdr[decoder.hdr_len++] = *data;
+			data++;
+			len--;
+			if (decoder.hdr_len < MUX_HDR_LEN) {
+				break;
+			}
+			if (mux_header_valid()) {
+				mux_header_done();
+			} else {
+				decoder.state = MUX_HUNT;
+			}
+			break;
+
+		case MUX_PAYLOAD: {
+			size_t size = MIN(len, decoder.len - decoder.pos);
+
+			if (decoder.type != MUX_DATA) {
+				memcpy(decoder.ctrl + decoder.pos, data, size);
+			} else if (decoder.frame) {
+				memcpy(decoder.frame->data + decoder.pos, data, size);
+			}
+			decoder.pos += size;
+			data += size;
+			len -= size;
+			if (decoder.pos == decoder.len) {
+				decoder.state = MUX_FCS;
+			}
+			break;
+		}
+
+		case MUX_FCS:
+			mux_frame_done(*data);
+			data++;
+			len--;
+			break;
+		}
+	}
+}
+
+static int mux_start(void)
+{
+	int err;
+
+	if (mux_running) {
+		return -EALREADY;
+	}
+
+	memset(&decoder, 0, sizeof(decoder));
+	for (int i = 0; i < MUX_CHANNEL_COUNT; i++) {
+		mux_channel_reset(i);
+	}
+	atomic_clear(&close_requests);
+
+	err = enter_muxmode(mux_uart_rx, mux_at_tx);
+	if (err) {
+		return err;
+	}
+	mux_running = true;
+
+	/* The response is the first frame on the AT channel */
+	sprintf(rsp_buf, "\r\n#XMUX: %d,%d,%d\r\n", CONFIG_SLM_MUX_CHANNELS,
+		CONFIG_SLM_MUX_CREDITS, CONFIG_SLM_MUX_FRAME_SIZE);
+	rsp_send(rsp_buf, strlen(rsp_buf));
+
+	return 0;
+}
+
+static int mux_stop(void)
+{
+	struct mux_frame *frame;
+
+	if (!mux_running) {
+		return 0;
+	}
+
+	mux_running = false;
+	(void)exit_muxmode();
+
+	k_mutex_lock(&mux_lock, K_FOREVER);
+	for (int i = 0; i < MUX_CHANNEL_COUNT; i++) {
+		mux_channel_reset(i);
+	}
+	k_mutex_unlock(&mux_lock);
+
+	while ((frame = k_fifo_get(&mux_rx_fifo, K_NO_WAIT)) != NULL) {
+		k_mem_slab_free(&mux_frame_slab, (void **)&frame);
+	}
+	if (decoder.frame) {
+		k_mem_slab_free(&mux_frame_slab, (void **)&decoder.frame);
+	}
+
+	return 0;
+}
+
+int slm_mux_data_send(int fd, const uint8_t *data, size_t len, struct slm_poller_item *item)
+{
+	struct mux_channel *ch;
+	int channel;
+	int ret;
+
+	k_mutex_lock(&mux_lock, K_FOREVER);
+	channel = mux_channel_find(fd);
+	if (!mux_running || channel < 0) {
+		ret = -ENOENT;
+		goto unlock;
+	}
+	ch = &channels[channel];
+	__ASSERT(ch->pending == NULL, "Socket read while data is pending");
+
+	ret = mux_data_frames_send(channel, data, len);
+	if (ret < 0 || (size_t)ret == len) {
+		ret = MIN(ret, 0);
+		goto unlock;
+	}
+
+	/* Keep the rest until the host grants credits, without blocking the
+	 * caller. Its socket is not read meanwhile.
+	 */
+	ch->pending = k_malloc(len - ret);
+	if (ch->pending == NULL) {
+		LOG_WRN("No ram buffer, channel %d: %zu bytes dropped", channel, len - ret);
+		ret = -ENOMEM;
+		goto unlock;
+	}
+	memcpy(ch->pending, data + ret, len - ret);
+	ch->pending_len = len - ret;
+	ch->pending_pos = 0;
+	ch->item = item;
+	ret = -EINPROGRESS;
+
+	/* Credits granted meanwhile */
+	k_work_submit(&mux_tx_work);
+
+unlock:
+	k_mutex_unlock(&mux_lock);
+	return ret;
+}
+
+bool slm_mux_is_bound(int fd)
+{
+	return mux_running && fd != INVALID_SOCKET && mux_channel_find(fd) > 0;
+}
+
+void slm_mux_close(int fd)
+{
+	int channel;
+
+	if (!mux_running || fd == INVALID_SOCKET) {
+		return;
+	}
+	channel = mux_channel_find(fd);
+	if (channel > 0) {
+		mux_channel_close(channel, fd);
+	}
+}
+
+void slm_mux_unbind(int fd)
+{
+	int channel;
+
+	k_mutex_lock(&mux_lock, K_FOREVER);
+	channel = mux_channel_find(fd);
+	if (channel > 0) {
+		mux_channel_reset(channel);
+	}
+	k_mutex_unlock(&mux_lock);
+}
+
+/**@brief handle AT#XMUX commands
+ *  AT#XMUX=<op>[,<handle>]
+ *  AT#XMUX?
+ *  AT#XMUX=?
+ */
+int handle_at_mux(enum at_cmd_type cmd_type)
+{
+	int err = -EINVAL;
+	uint16_t op;
+	int handle;
+
+	switch (cmd_type) {
+	case AT_CMD_TYPE_SET_COMMAND:
+		err = at_params_unsigned_short_get(&at_param_list, 1, &op);
+		if (err) {
+			return err;
+		}
+		if (op == MUX_START) {
+			err = mux_start();
+		} else if (op == MUX_STOP) {
+			err = mux_stop();
+		} else if (op == MUX_BIND || op == MUX_UNBIND) {
+			if (!mux_running) {
+				return -EINVAL;
+			}
+			err = at_params_int_get(&at_param_list, 2, &handle);
+			if (err) {
+				return err;
+			}
+			if (op == MUX_UNBIND) {
+				slm_mux_unbind(handle);
+				return 0;
+			}
+			err = mux_bind(handle);
+			if (err < 0) {
+				return err;
+			}
+			sprintf(rsp_buf, "\r\n#XMUX: %d,%d\r\n", err, handle);
+			rsp_send(rsp_buf, strlen(rsp_buf));
+			err = 0;
+		} else {
+			err = -EINVAL;
+		} break;
+
+	case AT_CMD_TYPE_READ_COMMAND:
+		sprintf(rsp_buf, "\r\n#XMUX: %d\r\n", mux_running ? MUX_START : MUX_STOP);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+		for (int i = 1; i < MUX_CHANNEL_COUNT; i++) {
+			if (channels[i].fd != INVALID_SOCKET) {
+				sprintf(rsp_buf, "\r\n#XMUX: %d,%d\r\n", i, channels[i].fd);
+				rsp_send(rsp_buf, strlen(rsp_buf));
+			}
+		}
+		err = 0;
+		break;
+
+	case AT_CMD_TYPE_TEST_COMMAND:
+		sprintf(rsp_buf, "\r\n#XMUX: (%d,%d,%d,%d),<handle>\r\n",
+			MUX_STOP, MUX_START, MUX_BIND, MUX_UNBIND);
+		rsp_send(rsp_buf, strlen(rsp_buf));
+		err = 0;
+		break;
+
+	default:
+		break;
+	}
+
+	return err;
+}
+
+int slm_mux_init(void)
+{
+	for (int i = 0; i < MUX_CHANNEL_COUNT; i++) {
+		channels[i].fd = INVALID_SOCKET;
+		channels[i].pending = NULL;
+		channels[i].item = NULL;
+		k_sem_init(&channels[i].credits, 0, K_SEM_MAX_LIMIT);
+	}
+	k_work_init(&mux_rx_work, mux_rx);
+	k_work_init(&mux_tx_work, mux_tx);
+	mux_running = false;
+
+	return 0;
+}
+
+int slm_mux_uninit(void)
+{
+	return mux_stop();
+}
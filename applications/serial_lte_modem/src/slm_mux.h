@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SLM_MUX_
+#define SLM_MUX_
+
+/**@file slm_mux.h
+ *
+ * @brief Multiplexed mode, carrying the AT channel and socket channels over UART.
+ *
+ * In multiplexed mode, all UART traffic is carried in frames:
+ *
+ *   0xF9 | channel | type | length (2 bytes, little endian) | payload | FCS
+ *
+ * The FCS is the CRC-8-CCITT, with 0xFF initial value, of all the bytes
+ * between the start flag and the FCS. Channel 0 carries AT commands and
+ * responses. The other channels are bound to sockets with AT#XMUX.
+ *
+ * Data frames are flow controlled with credits, one credit allowing one data
+ * frame. Each side grants credits to the other one with credit frames, whose
+ * payload is the number of credits granted (1 byte).
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <zephyr/sys/util.h>
+#include <errno.h>
+#include <stdbool.h>
+
+struct slm_poller_item;
+
+/** AT command channel. */
+#define SLM_MUX_CHANNEL_AT 0
+
+#if defined(CONFIG_SLM_MUX)
+/**
+ * @brief Send data received from a socket on the channel bound to it.
+ *
+ * Called from the poller handler of the socket. Does not wait for credits:
+ * the frames the host has no credit for are queued on the channel and sent
+ * when the host grants credits. The socket must not be read until then, so
+ * the poller item is re-armed once the queued data is sent.
+ *
+ * @param fd Socket the data was received from.
+ * @param data Received data.
+ * @param len Length of the data.
+ * @param item Poller item of the socket.
+ *
+ * @retval 0 If the data was sent. The caller re-arms its poller item.
+ * @retval -EINPROGRESS If part of the data is queued until the host grants credits.
+ * @retval -ENOENT If the socket is not bound to a channel.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_mux_data_send(int fd, const uint8_t *data, size_t len, struct slm_poller_item *item);
+
+/**
+ * @brief Check whether a socket is bound to a channel.
+ *
+ * @param fd Socket.
+ *
+ * @retval true If the socket is bound to a channel.
+ */
+bool slm_mux_is_bound(int fd);
+
+/**
+ * @brief Unbind a socket that cannot be used anymore from its channel, if
+ *        bound, and send a close frame to the host.
+ *
+ * @param fd Socket.
+ */
+void slm_mux_close(int fd);
+
+/**
+ * @brief Unbind a socket from its channel, if bound. To be called before
+ *        closing the socket.
+ *
+ * @param fd Socket.
+ */
+void slm_mux_unbind(int fd);
+#else
+static inline int slm_mux_data_send(int fd, const uint8_t *data, size_t len,
+				    struct slm_poller_item *item)
+{
+	ARG_UNUSED(fd);
+	ARG_UNUSED(data);
+	ARG_UNUSED(len);
+	ARG_UNUSED(item);
+	return -ENOENT;
+}
+
+static inline bool slm_mux_is_bound(int fd)
+{
+	ARG_UNUSED(fd);
+	return false;
+}
+
+static inline void slm_mux_close(int fd)
+{
+	ARG_UNUSED(fd);
+}
+
+static inline void slm_mux_unbind(int fd)
+{
+	ARG_UNUSED(fd);
+}
+#endif /* CONFIG_SLM_MUX */
+
+/**
+ * @brief Initialize multiplexed mode AT command parser.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_mux_init(void);
+
+/**
+ * @brief Uninitialize multiplexed mode AT command parser.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_mux_uninit(void);
+/** @} */
+
+#endif /* SLM_MUX_ */
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <zephyr/logging/log.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/net/socket.h>
+#include <modem/nrf_modem_lib.h>
+#include "slm_defines.h"
+#include "slm_poller.h"
+
+LOG_MODULE_REGISTER(slm_poller, CONFIG_SLM_LOG_LEVEL);
+
+#define THREAD_STACK_SIZE	KB(2)
+#define THREAD_PRIORITY		K_LOWEST_APPLICATION_THREAD_PRIO
+
+#define POLLER_FD_COUNT		SLM_MAX_SOCKET_COUNT
+#define POLLER_EVENTS_ALWAYS	(POLLERR | POLLHUP | POLLNVAL)
+/* Time the poller waits for the handlers it submitted, or after a poll() error */
+#define POLLER_HANDLER_TIMEOUT	K_SECONDS(1)
+
+static sys_slist_t poller_items = SYS_SLIST_STATIC_INIT(&poller_items);
+static size_t poller_item_count;
+static struct k_spinlock poller_lock;
+/* Given when an item is armed, to wake up the idle poller */
+static K_SEM_DEFINE(poller_wake, 0, 1);
+/* Given when a handler returns */
+static K_SEM_DEFINE(poller_done, 0, K_SEM_MAX_LIMIT);
+
+static struct k_work_q poller_work_q;
+static K_THREAD_STACK_DEFINE(poller_work_q_stack, CONFIG_SLM_POLLER_WORKQ_STACK_SIZE);
+static struct k_thread poller_thread;
+static K_THREAD_STACK_DEFINE(poller_thread_stack, THREAD_STACK_SIZE);
+static bool poller_started;
+
+/* Make the poller poll the armed items again. A poll() on offloaded sockets
+ * cannot wait for other file descriptors, so the wait of the poller thread
+ * in the modem library is interrupted instead.
+ */
+static void poller_wake_up(void)
+{
+	k_sem_give(&poller_wake);
+	if (poller_started) {
+		nrf_modem_lib_wait_interrupt(&poller_thread);
+	}
+}
+
+static void poller_work_fn(struct k_work *work)
+{
+	struct slm_poller_item *item = CONTAINER_OF(work, struct slm_poller_item, work);
+
+	item->handler(item, item->revents);
+	k_sem_give(&poller_done);
+}
+
+/* One pollfd per socket, with the events requested by all its armed items */
+static int poller_fds_build(struct pollfd *fds)
+{
+	struct slm_poller_item *item;
+	k_spinlock_key_t key = k_spin_lock(&poller_lock);
+	int nfds = 0;
+	int i;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&poller_items, item, node) {
+		if (!item->armed) {
+			continue;
+		}
+		for (i = 0; i < nfds; i++) {
+			if (fds[i].fd == item->fd) {
+				break;
+			}
+		}
+		if (i == nfds) {
+			fds[i].fd = item->fd;
+			fds[i].events = 0;
+			fds[i].revents = 0;
+			nfds++;
+		}
+		fds[i].events |= item->events;
+	}
+	k_spin_unlock(&poller_lock, key);
+
+	return nfds;
+}
+
+/* Disarm the ready items and submit their work, return the number submitted */
+static int poller_dispatch(const struct pollfd *fds, int nfds)
+{
+	struct slm_poller_item *item;
+	k_spinlock_key_t key = k_spin_lock(&poller_lock);
+	int count = 0;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&poller_items, item, node) {
+		if (!item->armed) {
+			continue;
+		}
+		for (int i = 0; i < nfds; i++) {
+			if (fds[i].fd != item->fd) {
+				continue;
+			}
+			if ((fds[i].revents & (item->events | POLLER_EVENTS_ALWAYS)) != 0) {
+				item->armed = false;
+				item->revents = fds[i].revents;
+				if (k_work_submit_to_queue(&poller_work_q, &item->work) > 0) {
+					count++;
+				}
+			}
+			break;
+		}
+	}
+	k_spin_unlock(&poller_lock, key);
+
+	return count;
+}
+
+static void poller_thread_func(void *p1, void *p2, void *p3)
+{
+	struct pollfd fds[POLLER_FD_COUNT];
+	int nfds;
+	int ret;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		nfds = poller_fds_build(fds);
+		if (nfds == 0) {
+			/* Nothing to poll, no wake-up until an item is armed */
+			(void)k_sem_take(&poller_wake, K_FOREVER);
+			continue;
+		}
+
+		ret = poll(fds, nfds, CONFIG_SLM_POLLER_TIMEOUT);
+		if (ret < 0) {
+			LOG_WRN("poll() error: %d", -errno);
+			k_sleep(POLLER_HANDLER_TIMEOUT);
+			continue;
+		}
+		if (ret == 0) {
+			continue;
+		}
+
+		k_sem_reset(&poller_done);
+		for (ret = poller_dispatch(fds, nfds); ret > 0; ret--) {
+			/* Let the handlers re-arm before polling again, unless one is blocked */
+			if (k_sem_take(&poller_done, POLLER_HANDLER_TIMEOUT) != 0) {
+				LOG_DBG("Handler busy");
+				break;
+			}
+		}
+	}
+}
+
+void slm_poller_item_init(struct slm_poller_item *item, slm_poller_handler_t handler)
+{
+	k_work_init(&item->work, poller_work_fn);
+	item->handler = handler;
+	item->fd = INVALID_SOCKET;
+	item->events = 0;
+	item->revents = 0;
+	item->armed = false;
+}
+
+int slm_poller_add(struct slm_poller_item *item, int fd, short events)
+{
+	k_spinlock_key_t key = k_spin_lock(&poller_lock);
+
+	if (item->fd != INVALID_SOCKET) {
+		k_spin_unlock(&poller_lock, key);
+		return -EALREADY;
+	}
+	if (poller_item_count >= POLLER_FD_COUNT) {
+		k_spin_unlock(&poller_lock, key);
+		LOG_ERR("Too many sockets");
+		return -ENOMEM;
+	}
+	item->fd = fd;
+	item->events = events;
+	item->armed = true;
+	sys_slist_append(&poller_items, &item->node);
+	poller_item_count++;
+	k_spin_unlock(&poller_lock, key);
+
+	poller_wake_up();
+
+	return 0;
+}
+
+void slm_poller_arm(struct slm_poller_item *item)
+{
+	k_spinlock_key_t key = k_spin_lock(&poller_lock);
+
+	if (item->fd != INVALID_SOCKET) {
+		item->armed = true;
+	}
+	k_spin_unlock(&poller_lock, key);
+
+	poller_wake_up();
+}
+
+void slm_poller_remove(struct slm_poller_item *item)
+{
+	struct k_work_sync sync;
+	k_spinlock_key_t key = k_spin_lock(&poller_lock);
+
+	if (item->fd == INVALID_SOCKET) {
+		k_spin_unlock(&poller_lock, key);
+		return;
+	}
+	if (sys_slist_find_and_remove(&poller_items, &item->node)) {
+		poller_item_count--;
+	}
+	item->fd = INVALID_SOCKET;
+	item->armed = false;
+	k_spin_unlock(&poller_lock, key);
+
+	if (k_current_get() == k_work_queue_thread_get(&poller_work_q)) {
+		/* Removed by a handler, possibly its own */
+		(void)k_work_cancel(&item->work);
+	} else {
+		(void)k_work_cancel_sync(&item->work, &sync);
+	}
+}
+
+int slm_poller_wait(struct pollfd *fds, int nfds, int timeout)
+{
+	int ret = poll(fds, nfds, timeout);
+
+	if (ret < 0) {
+		LOG_WRN("poll() error: %d", -errno);
+		return -errno;
+	}
+
+	return ret;
+}
+
+int slm_poller_init(void)
+{
+	if (poller_started) {
+		return 0;
+	}
+
+	k_work_queue_start(&poller_work_q, poller_work_q_stack,
+			   K_THREAD_STACK_SIZEOF(poller_work_q_stack),
+			   THREAD_PRIORITY, NULL);
+	k_thread_create(&poller_thread, poller_thread_stack,
+			K_THREAD_STACK_SIZEOF(poller_thread_stack),
+			poller_thread_func, NULL, NULL, NULL,
+			THREAD_PRIORITY, K_USER, K_NO_WAIT);
+	poller_started = true;
+
+	return 0;
+}
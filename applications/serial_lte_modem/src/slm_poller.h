@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SLM_POLLER_
+#define SLM_POLLER_
+
+/**@file slm_poller.h
+ *
+ * @brief Socket poller, waiting for events on all the sockets read in the background.
+ *
+ * A single thread polls the registered sockets and submits the work item of
+ * each ready socket to the poller work queue. An item is disarmed when its
+ * work item is submitted, so that the socket is not polled again before the
+ * handler has consumed the event. The handler re-arms the item when it wants
+ * to be notified again.
+ *
+ * Adding or re-arming an item interrupts the poll() of the poller thread, so
+ * that the socket is polled immediately, from any thread.
+ * @{
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/slist.h>
+#include <zephyr/net/socket.h>
+
+struct slm_poller_item;
+
+/**
+ * @brief Socket event handler, run in the poller work queue.
+ *
+ * @param item Item of the socket.
+ * @param revents Events returned by poll().
+ */
+typedef void (*slm_poller_handler_t)(struct slm_poller_item *item, short revents);
+
+/** Socket registered to the poller. */
+struct slm_poller_item {
+	/** Work item submitted when the socket is ready. */
+	struct k_work work;
+	/** Event handler. */
+	slm_poller_handler_t handler;
+	/** Socket descriptor, INVALID_SOCKET when not registered. */
+	int fd;
+	/** Requested events. */
+	short events;
+	/** Events returned by the last poll(). */
+	short revents;
+	/** Whether the socket is polled. */
+	bool armed;
+	sys_snode_t node;
+};
+
+/**
+ * @brief Initialize a poller item. To be called once, before the item is added.
+ *
+ * @param item Item.
+ * @param handler Event handler.
+ */
+void slm_poller_item_init(struct slm_poller_item *item, slm_poller_handler_t handler);
+
+/**
+ * @brief Register a socket and arm its item.
+ *
+ * @param item Initialized item, not registered.
+ * @param fd Socket descriptor.
+ * @param events Requested events, POLLERR, POLLHUP and POLLNVAL are always reported.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -EALREADY If the item is already registered.
+ * @retval -ENOMEM If the maximum number of sockets are registered.
+ */
+int slm_poller_add(struct slm_poller_item *item, int fd, short events);
+
+/**
+ * @brief Re-arm a registered item, typically from its handler. Can be called from ISR.
+ *
+ * @param item Item.
+ */
+void slm_poller_arm(struct slm_poller_item *item);
+
+/**
+ * @brief Unregister a socket. To be called before closing the socket.
+ *
+ * When called from another thread than the poller work queue, waits until
+ * the handler of the item has returned.
+ *
+ * @param item Item. Nothing is done if it is not registered.
+ */
+void slm_poller_remove(struct slm_poller_item *item);
+
+/**
+ * @brief Wait for events on sockets, blocking the calling thread.
+ *
+ * The poll is run on the calling thread, which is blocked anyway, instead
+ * of in the poller thread.
+ *
+ * @param fds Sockets and requested events, as for poll().
+ * @param nfds Number of sockets.
+ * @param timeout Time-out in milliseconds, negative to wait forever.
+ *
+ * @return Number of ready sockets, 0 on time-out.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_poller_wait(struct pollfd *fds, int nfds, int timeout);
+
+/**
+ * @brief Start the socket poller.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_poller_init(void);
+/** @} */
+
+#endif /* SLM_POLLER_ */
@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/__assert.h>
+#include <zephyr/logging/log.h>
+#include "slm_rx_stream.h"
+
+LOG_MODULE_REGISTER(slm_rx_stream, CONFIG_SLM_LOG_LEVEL);
+
+#define BUF_COUNT CONFIG_SLM_DATAMODE_STREAMING_BUF_COUNT
+#define BUF_SIZE  CONFIG_SLM_DATAMODE_STREAMING_BUF_SIZE
+
+/* Several chunks per buffer, as RX timeouts split the reception of a buffer */
+#define CHUNK_COUNT (BUF_COUNT * 4)
+
+#define TERMINATOR CONFIG_SLM_DATAMODE_TERMINATOR
+#define TERMINATOR_LEN (sizeof(TERMINATOR) - 1)
+
+BUILD_ASSERT(TERMINATOR_LEN > 0, "Data mode terminator must not be empty");
+
+static uint8_t bufs[BUF_COUNT][BUF_SIZE] __aligned(4);
+
+/* One reference held by the UART driver, plus one per queued chunk */
+static atomic_t buf_refs[BUF_COUNT];
+
+K_MSGQ_DEFINE(chunk_queue, sizeof(struct slm_rx_chunk), CHUNK_COUNT, 4);
+
+/* Received bytes matching the beginning of the terminator, not sent yet */
+static uint8_t held[TERMINATOR_LEN];
+static size_t held_len;
+
+static int buf_index(const uint8_t *data)
+{
+	int index = (data - bufs[0]) / BUF_SIZE;
+
+	__ASSERT(index >= 0 && index < BUF_COUNT, "Not a stream buffer");
+
+	return index;
+}
+
+static void buf_unref(int index)
+{
+	atomic_val_t refs = atomic_dec(&buf_refs[index]);
+
+	__ASSERT(refs > 0, "Stream buffer released twice");
+	ARG_UNUSED(refs);
+}
+
+void slm_rx_stream_init(void)
+{
+	k_msgq_purge(&chunk_queue);
+	for (int i = 0; i < BUF_COUNT; i++) {
+		atomic_set(&buf_refs[i], 0);
+	}
+	held_len = 0;
+}
+
+uint8_t *slm_rx_stream_buf_alloc(void)
+{
+	for (int i = 0; i < BUF_COUNT; i++) {
+		if (atomic_cas(&buf_refs[i], 0, 1)) {
+			return bufs[i];
+		}
+	}
+
+	return NULL;
+}
+
+void slm_rx_stream_buf_release(const uint8_t *buf)
+{
+	buf_unref(buf_index(buf));
+}
+
+int slm_rx_stream_chunk_put(uint8_t *data, size_t len)
+{
+	struct slm_rx_chunk chunk = {
+		.data = data,
+		.len = len
+	};
+	int index = buf_index(data);
+	int err;
+
+	atomic_inc(&buf_refs[index]);
+	err = k_msgq_put(&chunk_queue, &chunk, K_NO_WAIT);
+	if (err) {
+		LOG_ERR("Chunk queue full, %zu dropped", len);
+		buf_unref(index);
+	}
+
+	return err;
+}
+
+int slm_rx_stream_chunk_get(struct slm_rx_chunk *chunk, k_timeout_t timeout)
+{
+	return k_msgq_get(&chunk_queue, chunk, timeout);
+}
+
+void slm_rx_stream_chunk_done(const struct slm_rx_chunk *chunk)
+{
+	buf_unref(buf_index(chunk->data));
+}
+
+bool slm_rx_stream_buf_available(void)
+{
+	for (int i = 0; i < BUF_COUNT; i++) {
+		if (atomic_get(&buf_refs[i]) == 0) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Byte of the held data followed by the chunk */
+static uint8_t stream_byte(const struct slm_rx_chunk *chunk, size_t pos)
+{
+	return (pos < held_len) ? held[pos] : chunk->data[pos - held_len];
+}
+
+/* Length of the longest end of the held data followed by the chunk that
+ * matches the beginning of the terminator.
+ */
+static size_t terminator_match(const struct slm_rx_chunk *chunk)
+{
+	size_t total = held_len + chunk->len;
+
+	for (size_t len = MIN(TERMINATOR_LEN, total); len > 0; len--) {
+		size_t i;
+
+		for (i = 0; i < len; i++) {
+			if (stream_byte(chunk, total - len + i) != TERMINATOR[i]) {
+				break;
+			}
+		}
+		if (i == len) {
+			return len;
+		}
+	}
+
+	return 0;
+}
+
+static int chunk_send(const struct slm_rx_chunk *chunk, slm_rx_stream_send_t send)
+{
+	size_t match = terminator_match(chunk);
+	size_t send_len = held_len + chunk->len - match;
+	size_t held_send = MIN(held_len, send_len);
+	size_t data_send = send_len - held_send;
+	int err = 0;
+
+	if (held_send > 0) {
+		err = send(held, held_send);
+	}
+	if (err == 0 && data_send > 0) {
+		err = send(chunk->data, data_send);
+	}
+
+	/* Hold back the end that may be the beginning of the terminator */
+	memmove(held, &held[held_send], held_len - held_send);
+	memcpy(&held[held_len - held_send], &chunk->data[data_send], chunk->len - data_send);
+	held_len = match;
+
+	return err;
+}
+
+int slm_rx_stream_send(slm_rx_stream_send_t send)
+{
+	struct slm_rx_chunk chunk;
+	int count = 0;
+	int err;
+
+	while (slm_rx_stream_chunk_get(&chunk, K_NO_WAIT) == 0) {
+		err = chunk_send(&chunk, send);
+		slm_rx_stream_chunk_done(&chunk);
+		if (err) {
+			return err;
+		}
+		count++;
+	}
+
+	return count;
+}
+
+bool slm_rx_stream_terminated(void)
+{
+	return held_len == TERMINATOR_LEN;
+}
+
+void slm_rx_stream_held_drop(void)
+{
+	held_len = 0;
+}
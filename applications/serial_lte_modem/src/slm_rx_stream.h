@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef SLM_RX_STREAM_
+#define SLM_RX_STREAM_
+
+/**@file slm_rx_stream.h
+ *
+ * @brief UART RX buffer pool for streaming data mode.
+ *
+ * The UART driver receives directly into buffers of this pool. Received
+ * chunks are queued without copying and the buffer is returned to the pool
+ * only when the driver has released it and all its chunks are consumed.
+ * When the pool runs out of buffers, UART reception stops and the
+ * hardware flow control holds off the host.
+ *
+ * Received data that may be the beginning of the data mode terminator is
+ * held back until the following data shows whether it is the terminator,
+ * so that the terminator is also detected when it is split between chunks.
+ * @{
+ */
+
+#include <zephyr/types.h>
+#include <zephyr/kernel.h>
+#include <stdbool.h>
+
+/**@brief Received data chunk, pointing into a pool buffer. */
+struct slm_rx_chunk {
+	uint8_t *data;
+	size_t len;
+};
+
+/**@brief Function sending received data.
+ *
+ * @return 0 on success, otherwise a (negative) error code.
+ */
+typedef int (*slm_rx_stream_send_t)(const uint8_t *data, size_t len);
+
+/**
+ * @brief Initialize the buffer pool and drop all queued chunks and held data.
+ */
+void slm_rx_stream_init(void);
+
+/**
+ * @brief Take a free buffer from the pool, to be given to the UART driver.
+ *
+ * @return Buffer of CONFIG_SLM_DATAMODE_STREAMING_BUF_SIZE bytes, or NULL if
+ *         all the buffers are in use.
+ */
+uint8_t *slm_rx_stream_buf_alloc(void);
+
+/**
+ * @brief Release a buffer given back by the UART driver.
+ *
+ * The buffer returns to the pool when all its queued chunks are consumed.
+ *
+ * @param buf Buffer taken with @ref slm_rx_stream_buf_alloc.
+ */
+void slm_rx_stream_buf_release(const uint8_t *buf);
+
+/**
+ * @brief Queue a chunk of received data. Can be called from ISR.
+ *
+ * @param data Received data, within a buffer of the pool.
+ * @param len Length of the data.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_rx_stream_chunk_put(uint8_t *data, size_t len);
+
+/**
+ * @brief Get the oldest chunk of received data.
+ *
+ * @param chunk Received chunk, to be given back with
+ *              @ref slm_rx_stream_chunk_done when consumed.
+ * @param timeout Time to wait for a chunk.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int slm_rx_stream_chunk_get(struct slm_rx_chunk *chunk, k_timeout_t timeout);
+
+/**
+ * @brief Mark a chunk as consumed.
+ *
+ * @param chunk Chunk obtained with @ref slm_rx_stream_chunk_get.
+ */
+void slm_rx_stream_chunk_done(const struct slm_rx_chunk *chunk);
+
+/**
+ * @brief Check if a buffer is available, to resume stopped UART reception.
+ *
+ * @return true if at least one buffer is free.
+ */
+bool slm_rx_stream_buf_available(void);
+
+/**
+ * @brief Send the queued chunks and mark them as consumed.
+ *
+ * Data that may be the beginning of the data mode terminator is not sent
+ * until the following data shows that it is not the terminator.
+ *
+ * @param send Function sending the data.
+ *
+ * @return Number of chunks consumed, or the error returned by @p send.
+ */
+int slm_rx_stream_send(slm_rx_stream_send_t send);
+
+/**
+ * @brief Check if the data received so far ends with the data mode terminator.
+ *
+ * @return true if the held back data is the complete terminator.
+ */
+bool slm_rx_stream_terminated(void);
+
+/**
+ * @brief Drop the held back data, when data mode is left.
+ */
+void slm_rx_stream_held_drop(void);
+
+/** @} */
+
+#endif /* SLM_RX_STREAM_ */
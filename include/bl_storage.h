@@ -21,6 +21,37 @@ extern "C" {
  * @{
  */
 
+/** Length of the firmware digest stored in a validation record. */
+#define BL_VALIDATION_RECORD_HASH_LEN 32
+
+/** Value of the @c valid field of a completely written validation record. */
+#define BL_VALIDATION_RECORD_VALID 0x5A1DF1E5
+
+/** Whether the bootloader storage is write-protected before the firmware is
+ *  booted. On devices that keep it in OTP, the booted firmware can still write
+ *  to it.
+ */
+#if defined(CONFIG_SOC_NRF9160) \
+	|| defined(CONFIG_SOC_NRF5340_CPUNET) \
+	|| defined(CONFIG_SOC_NRF5340_CPUAPP)
+#define BL_STORAGE_PROTECTED 0
+#else
+#define BL_STORAGE_PROTECTED 1
+#endif
+
+/** Record of firmware that has already been validated by the bootloader.
+ *
+ *  The fields are written one word at a time, with @c valid written last, so
+ *  a record that was interrupted while being written is never complete.
+ */
+struct bl_validation_record {
+	uint32_t address; /* Address of the validated firmware. */
+	uint32_t version; /* Version from the fw_info of the validated firmware. */
+	uint32_t key_idx; /* Index of the public key that verified the signature. */
+	uint8_t hash[BL_VALIDATION_RECORD_HASH_LEN]; /* SHA-256 of the firmware. */
+	uint32_t valid; /* BL_VALIDATION_RECORD_VALID if the record is complete. */
+};
+
 /**
  * @brief Function for reading address of slot 0.
  *
@@ -106,6 +137,41 @@ uint16_t get_monotonic_counter(void);
  */
 int set_monotonic_counter(uint16_t new_counter);
 
+/**
+ * @brief Get the number of validation record slots.
+ *
+ * @return The number of slots. If the provision page does not contain the
+ *         information, 0 is returned.
+ */
+uint16_t num_validation_record_slots(void);
+
+/**
+ * @brief Read a validation record.
+ *
+ * @param[in]  idx     Index of the record slot.
+ * @param[out] record  Pointer to area where the record will be stored.
+ *
+ * @retval 0        The record was read successfully.
+ * @retval -ENOENT  The slot is empty.
+ * @retval -EINVAL  The record in the slot was not completely written.
+ * @retval -EFAULT  @p idx is too large. There is no slot with that index.
+ */
+int validation_record_read(uint32_t idx, struct bl_validation_record *record);
+
+/**
+ * @brief Write a validation record to the first empty slot.
+ *
+ * The @c valid field of @p record is ignored. The record is marked as complete
+ * after all other fields are written.
+ *
+ * @param[in]  record  Record to write.
+ *
+ * @retval 0        The record was written successfully.
+ * @retval -ENOMEM  There are no more empty record slots (see
+ *                  @kconfig{CONFIG_SB_NUM_VALIDATION_RECORDS}).
+ */
+int validation_record_write(const struct bl_validation_record *record);
+
   /** @} */
 
 #ifdef __cplusplus
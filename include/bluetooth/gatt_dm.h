@@ -264,9 +264,10 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * This function is asynchronous. Discovery results are passed through
  * the supplied callback.
  *
- * @note Only one discovery procedure can be started simultaneously. To start
- * another one, wait for the result of the previous procedure to finish
- * and call @ref bt_gatt_dm_data_release if it was successful.
+ * @note Up to @kconfig{CONFIG_BT_GATT_DM_MAX_INSTANCES} discovery procedures
+ * can be started simultaneously. When all instances are in use, wait for
+ * the result of a previous procedure to finish and call
+ * @ref bt_gatt_dm_data_release if it was successful.
  *
  * @param[in]     conn Connection object.
  * @param[in]     svc_uuid UUID of target service
@@ -283,7 +284,13 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
  * service instances may be discovered.
  * Call @ref bt_gatt_dm_continue to discover the next service instance.
  *
+ * If @kconfig{CONFIG_BT_GATT_DM_CACHE} is enabled and the peer is bonded,
+ * the Database Hash of the peer is read first. When it matches the hash
+ * stored with the previous discovery, the service is restored from the cache
+ * instead of being discovered.
+ *
  * @retval 0 If the operation was successful.
+ * @retval -EALREADY If all discovery instances are in use.
  *           Otherwise, a (negative) error code is returned.
  */
 int bt_gatt_dm_start(struct bt_conn *conn,
@@ -317,6 +324,80 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context);
  */
 int bt_gatt_dm_data_release(struct bt_gatt_dm *dm);
 
+#if defined(CONFIG_BT_GATT_DM_CACHE)
+/** Length of the GATT Database Hash. */
+#define BT_GATT_DM_CACHE_HASH_LEN 16
+
+/** @brief Reference to a cached service
+ *
+ * Identifies a service of a bonded peer together with the Database Hash
+ * it was discovered with. It is used to store additional service data
+ * that is valid as long as the peer database does not change.
+ */
+struct bt_gatt_dm_cache_ref {
+	/** Local identity. */
+	uint8_t id;
+	/** Peer identity address. */
+	bt_addr_le_t peer;
+	/** Database Hash of the peer. */
+	uint8_t db_hash[BT_GATT_DM_CACHE_HASH_LEN];
+	/** Service declaration handle. */
+	uint16_t svc_handle;
+};
+
+/** @brief Check if the discovery data was restored from the cache.
+ *
+ * @param[in] dm Discovery Manager instance
+ *
+ * @return True if the service was restored from the cache,
+ *         false if it was discovered.
+ */
+bool bt_gatt_dm_cache_restored(const struct bt_gatt_dm *dm);
+
+/** @brief Get the cache reference of the discovered service.
+ *
+ * The reference is available when the peer is bonded and its
+ * Database Hash was read, whether the service was discovered or
+ * restored from the cache.
+ *
+ * @param[in]  dm  Discovery Manager instance
+ * @param[out] ref Cache reference.
+ *
+ * @retval 0 If the operation was successful.
+ * @retval -ENOENT If the service cannot be cached.
+ */
+int bt_gatt_dm_cache_ref_get(const struct bt_gatt_dm *dm,
+			     struct bt_gatt_dm_cache_ref *ref);
+
+/** @brief Store data with the cached service.
+ *
+ * The data is deleted with the bond and is ignored once the peer
+ * Database Hash changes.
+ *
+ * @param[in] ref  Cache reference from @ref bt_gatt_dm_cache_ref_get.
+ * @param[in] data Data to store.
+ * @param[in] len  Data length.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int bt_gatt_dm_cache_data_store(const struct bt_gatt_dm_cache_ref *ref,
+				const void *data, size_t len);
+
+/** @brief Load data stored with the cached service.
+ *
+ * @param[in]  ref  Cache reference from @ref bt_gatt_dm_cache_ref_get.
+ * @param[out] data Buffer for the data.
+ * @param[in]  len  Buffer length.
+ *
+ * @return Length of the data loaded.
+ * @retval -ENOENT If there is no data stored for this Database Hash.
+ * @retval -ENOMEM If the buffer is too small.
+ */
+ssize_t bt_gatt_dm_cache_data_load(const struct bt_gatt_dm_cache_ref *ref,
+				   void *data, size_t len);
+#endif /* defined(CONFIG_BT_GATT_DM_CACHE) */
+
 /** @brief Print service discovery data.
  *
  * This function prints GATT attributes that belong to the discovered service.
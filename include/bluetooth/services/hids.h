@@ -47,6 +47,10 @@ extern "C" {
 /**
  * @brief Declare a HIDS instance.
  *
+ * Besides the context data of every connection, which holds the values of
+ * all reports, a buffer with the report values shared by the connections is
+ * allocated.
+ *
  * @param _name Name of the HIDS instance.
  * @param ...               Lengths of HIDS reports
  */
@@ -54,10 +58,15 @@ extern "C" {
 	BT_CONN_CTX_DEF(_name,						       \
 			CONFIG_BT_HIDS_MAX_CLIENT_COUNT,		       \
 			_BT_HIDS_CONN_CTX_SIZE_CALC(__VA_ARGS__));	       \
+	static uint8_t CONCAT(_name, _inp_rep_shared)			       \
+		[FOR_EACH(_BT_HIDS_GET_ARG1, (+), __VA_ARGS__)];	       \
 	static struct bt_hids _name =				       \
 	{								       \
 		.gp = BT_GATT_POOL_INIT(CONFIG_BT_HIDS_ATTR_MAX),	       \
 		.conn_ctx = &CONCAT(_name, _ctx_lib),			       \
+		.inp_rep_shared = CONCAT(_name, _inp_rep_shared),	       \
+		.inp_rep_shared_size =					       \
+			sizeof(CONCAT(_name, _inp_rep_shared)),		       \
 	}
 
 
@@ -460,6 +469,14 @@ struct bt_hids {
 
 	/** Bluetooth connection contexts. */
 	struct bt_conn_ctx_lib *conn_ctx;
+
+	/** Input Report values shared by all connections that have not
+	 *  diverged from the last report sent to every subscriber.
+	 */
+	uint8_t *inp_rep_shared;
+
+	/** Size of the shared Input Report values buffer. */
+	size_t inp_rep_shared_size;
 };
 
 /** @brief HID Connection context data structure.
@@ -477,6 +494,12 @@ struct bt_hids_conn_data {
 	/** HIDS Boot Keyboard Output Report Context. */
 	uint8_t hids_boot_kb_outp_rep_ctx[BT_HIDS_BOOT_KB_OUTPUT_REP_LEN];
 
+	/** Bitmask of Input Reports whose value is kept in
+	 *  @ref bt_hids_conn_data.inp_rep_ctx. Values of the remaining
+	 *  Input Reports are read from @ref bt_hids.inp_rep_shared.
+	 */
+	uint16_t inp_rep_own;
+
 	/** Pointer to Input Reports Context data. */
 	uint8_t *inp_rep_ctx;
 
@@ -551,6 +574,34 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj, struct bt_conn *conn,
 			 uint8_t rep_index, uint8_t const *rep, uint8_t len,
 			 bt_gatt_complete_func_t cb);
 
+/** @brief Send Input Report to a group of connections.
+ *
+ *  The report value is stored once in the buffer shared by the connections
+ *  instead of being copied into the context of every connection. The report
+ *  is sent to the connections from the list that have enabled notifications.
+ *  Connections from the list that have not enabled notifications are skipped.
+ *
+ *  @note The function is not thread safe.
+ *	     It can not be called from multiple threads at the same time.
+ *
+ *  @param hids_obj Pointer to HIDS instance.
+ *  @param conns Array of Connection Objects.
+ *  @param conn_cnt Number of Connection Objects in the array.
+ *  @param rep_index Index of report descriptor.
+ *  @param rep Pointer to the report data.
+ *  @param len Length of report data.
+ *  @param cb Notification complete callback (can be NULL). It is called
+ *	      once for every connection the report is sent to.
+ *
+ *  @retval 0 If the operation was successful.
+ *  @retval -ENODATA If none of the connections has enabled notifications.
+ *  @return Otherwise, a (negative) error code is returned.
+ */
+int bt_hids_inp_rep_send_conns(struct bt_hids *hids_obj,
+			       struct bt_conn *const *conns, size_t conn_cnt,
+			       uint8_t rep_index, uint8_t const *rep,
+			       uint8_t len, bt_gatt_complete_func_t cb);
+
 /** @brief Send Boot Mouse Input Report.
  *
  *  @note The function is not thread safe.
@@ -232,6 +232,12 @@ struct bt_hogp {
 	bool ready;
 	/** Current protocol mode. */
 	enum bt_hids_pm pm;
+#if defined(CONFIG_BT_HOGP_CACHE)
+	/** Reference of the HID service in the discovery cache. */
+	struct bt_gatt_dm_cache_ref cache_ref;
+	/** The service can be cached. */
+	bool cache_ref_valid;
+#endif
 };
 
 /**
@@ -34,6 +34,14 @@
  * 4. Call @c dfu_multi_image_done function to release open resources and verify that all
  *    data declared in the header have been written properly.
  *
+ * If @c CONFIG_DFU_MULTI_IMAGE_PIPELINE is enabled, the image writers are not called by
+ * @c dfu_multi_image_write directly. Instead, the image data is copied to a bounded buffer
+ * and written by a writer thread, so that the download of the package continues while
+ * the data is being written. Each image writer is assigned to one of the writer threads
+ * (lanes), so images stored on different flash devices can be erased and written at the
+ * same time. Errors reported by the image writers are then returned by a subsequent
+ * @c dfu_multi_image_write or @c dfu_multi_image_done call.
+ *
  * @{
  */
 
@@ -93,6 +101,16 @@ struct dfu_image_writer {
 	 * @return 0        On success.
 	 */
 	dfu_image_close_t close;
+
+	/**
+	 * @brief Writer thread used for the applicable image.
+	 *
+	 * Only used if @c CONFIG_DFU_MULTI_IMAGE_PIPELINE is enabled. Images stored on
+	 * the same flash device, or written using a shared DFU target, must be assigned to
+	 * the same lane, so that their writes are serialized. The value must be lower than
+	 * @c CONFIG_DFU_MULTI_IMAGE_PIPELINE_LANES.
+	 */
+	uint8_t lane;
 };
 
 /**
@@ -123,6 +141,7 @@ int dfu_multi_image_init(uint8_t *buffer, size_t buffer_size);
  *                   functions to be registered.
  *
  * @return -ENOMEM If the image writer could not be registered due to lack of empty slots.
+ * @return -EINVAL If the writer thread (lane) of the image writer does not exist.
  * @return 0	   On success.
  */
 int dfu_multi_image_register_writer(const struct dfu_image_writer *writer);
@@ -169,6 +188,10 @@ size_t dfu_multi_image_offset(void);
  * true, the function validates that all images listed in the package header have been
  * fully written.
  *
+ * If @c CONFIG_DFU_MULTI_IMAGE_PIPELINE is enabled, the function waits until the writer
+ * threads have processed all buffered data. If @c success is false, the buffered data
+ * that has not been written yet is dropped.
+ *
  * @param[in] success Indicates that a user expects all the package contents to have
  *                    been written successfully.
  *
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/** @file dfu_target_app_delta.h
+ *
+ * @defgroup dfu_target_app_delta Application Delta DFU Target
+ * @{
+ * @brief DFU Target for application updates distributed as a patch against
+ *	  the current application image.
+ *
+ * The patch is applied to the image in the MCUboot primary slot while it is
+ * downloaded, and the resulting image is written to the MCUboot secondary
+ * slot using the MCUboot DFU target. Use the
+ * 'scripts/bootloader/app_delta_tool.py' script to generate the patch from
+ * the signed images, for example 'app_update.bin' of the current and the new
+ * firmware.
+ *
+ * The buffer for flash writes must be provided using
+ * @ref dfu_target_mcuboot_set_buf before the target is initialized.
+ */
+
+#ifndef DFU_TARGET_APP_DELTA_H__
+#define DFU_TARGET_APP_DELTA_H__
+
+#include <stddef.h>
+#include <dfu/dfu_target.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief See if data in buf indicates an application delta update.
+ *
+ * @param[in] buf Pointer to data to check.
+ *
+ * @retval true if data matches, false otherwise.
+ */
+bool dfu_target_app_delta_identify(const void *const buf);
+
+/**
+ * @brief Initialize dfu target, perform steps necessary to receive a patch.
+ *
+ * The MCUboot secondary slot is prepared when the patch header is received
+ * and the image in the primary slot is verified to be the source image of
+ * the patch.
+ *
+ * @param[in] file_size Size of the patch. Not in use.
+ * @param[in] img_num Image pair index. Only image 0 is supported.
+ * @param[in] cb Not in use. In place to be compatible with DFU target API.
+ *
+ * @retval 0 If successful, negative errno otherwise.
+ */
+int dfu_target_app_delta_init(size_t file_size, int img_num, dfu_target_callback_t cb);
+
+/**
+ * @brief Get offset of the patch.
+ *
+ * The patch decoder state is not stored in flash, so after a reset the
+ * download restarts from the beginning of the patch.
+ *
+ * @param[out] offset Returns the number of patch bytes processed.
+ *
+ * @return 0 on success, negative errno otherwise.
+ */
+int dfu_target_app_delta_offset_get(size_t *offset);
+
+/**
+ * @brief Write patch data.
+ *
+ * @param[in] buf Pointer to data that should be written.
+ * @param[in] len Length of data to write.
+ *
+ * @retval 0 on success.
+ * @retval -EINVAL if the image in the primary slot is not the source image
+ *         of the patch.
+ * @retval -EBADMSG if the patch is malformed.
+ * @return Other negative errno on other failures.
+ */
+int dfu_target_app_delta_write(const void *const buf, size_t len);
+
+/**
+ * @brief Deinitialize resources and finalize the update if successful.
+ *
+ * @param[in] successful Indicate whether the patch was successfully received.
+ *
+ * @retval 0 on success.
+ * @retval -ENODATA if the patch is incomplete.
+ * @return Other negative errno on other failures.
+ */
+int dfu_target_app_delta_done(bool successful);
+
+/**
+ * @brief Schedule update of the image in the secondary slot.
+ *
+ * @param[in] img_num Image pair index, 0 or -1.
+ *
+ * @return 0 on success, negative errno otherwise.
+ **/
+int dfu_target_app_delta_schedule_update(int img_num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DFU_TARGET_APP_DELTA_H__ */
+
+/**@} */
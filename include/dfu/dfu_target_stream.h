@@ -22,6 +22,9 @@
 extern "C" {
 #endif
 
+/** Length of the SHA-256 digest of the stream. */
+#define DFU_TARGET_STREAM_SHA256_LEN 32
+
 struct stream_flash_ctx *dfu_target_stream_get_stream(void);
 
 /** @brief DFU target stream initialization structure. */
@@ -53,6 +56,13 @@ struct dfu_target_stream_init {
 	 * can be used to inspect the actual written data.
 	 */
 	stream_flash_callback_t cb;
+
+	/* Expected SHA-256 digest of the whole stream, for example taken from
+	 * an update manifest. Set to NULL to skip the check. The digest is
+	 * copied, so the buffer does not need to be kept. Only used if
+	 * `CONFIG_DFU_TARGET_STREAM_SHA256` is set.
+	 */
+	const uint8_t *expected_sha256;
 };
 
 /**
@@ -95,10 +105,28 @@ int dfu_target_stream_write(const uint8_t *buf, size_t len);
  * @param[in] successful Indicate whether the firmware was successfully
  * received.
  *
+ * @retval -EBADMSG The SHA-256 digest of the stream does not match the
+ *                  expected digest provided at initialization.
  * @return Non-negative value on success, negative errno otherwise.
  */
 int dfu_target_stream_done(bool successful);
 
+/**
+ * @brief Get the SHA-256 digest of the last successfully completed stream.
+ *
+ * The digest is computed while the data is written to flash, so it is
+ * available right after @ref dfu_target_stream_done without reading the
+ * data back. It requires the option `CONFIG_DFU_TARGET_STREAM_SHA256`.
+ *
+ * @param[out] digest Buffer of @ref DFU_TARGET_STREAM_SHA256_LEN bytes.
+ *
+ * @retval 0 on success.
+ * @retval -ENODATA if no stream was completed since the last
+ *         initialization or the digest could not be computed.
+ * @retval -ENOTSUP if `CONFIG_DFU_TARGET_STREAM_SHA256` is not set.
+ */
+int dfu_target_stream_sha256_get(uint8_t *digest);
+
 #endif /* DFU_TARGET_STREAM_H__ */
 
 /**@} */
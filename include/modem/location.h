@@ -43,6 +43,11 @@ enum location_req_mode {
 	LOCATION_REQ_MODE_FALLBACK = 0,
 	/** All requested methods are used sequentially. */
 	LOCATION_REQ_MODE_ALL,
+	/**
+	 * All requested methods are started at the same time. The first location meeting the
+	 * accuracy target is used. Requires CONFIG_LOCATION_REQ_MODE_PARALLEL.
+	 */
+	LOCATION_REQ_MODE_PARALLEL,
 };
 
 /** Event IDs. */
@@ -260,6 +265,37 @@ struct location_config {
 	 * @brief Location acquisition mode.
 	 */
 	enum location_req_mode mode;
+
+	/**
+	 * @brief Accuracy target in meters, used with LOCATION_REQ_MODE_PARALLEL.
+	 *
+	 * @details The first location with an accuracy equal to or better than the target is
+	 * reported and the other methods are cancelled. If none of the methods meets the target,
+	 * the most accurate location is reported once all methods are done. If set to 0, all
+	 * methods are always run until they are done.
+	 */
+	float accuracy_target;
+
+	/**
+	 * @brief Fuse the locations obtained in LOCATION_REQ_MODE_PARALLEL.
+	 *
+	 * @details If set to true, the reported latitude and longitude are the average of all the
+	 * locations obtained when the request is done, weighted by the inverse of their variance.
+	 * The method, accuracy and time are taken from the most accurate location.
+	 */
+	bool fuse;
+};
+
+/** Location cache statistics. */
+struct location_cache_stats {
+	/** Number of cellular and Wi-Fi cache lookups. */
+	uint32_t lookups;
+	/** Number of lookups answered from the cache. */
+	uint32_t hits;
+	/** Number of locations stored in the cache. */
+	uint32_t stores;
+	/** Number of entries evicted to make room for new locations. */
+	uint32_t evictions;
 };
 
 /**
@@ -379,6 +415,28 @@ int location_agps_data_process(const char *buf, size_t buf_len);
  */
 int location_pgps_data_process(const char *buf, size_t buf_len);
 
+/**
+ * @brief Reads the location cache statistics.
+ *
+ * @details The cache hit rate is the number of hits divided by the number of lookups. Each hit
+ * is a location service request saved.
+ *
+ * @param[out] stats Statistics.
+ *
+ * @return 0 on success, or negative error code on failure.
+ * @retval -EINVAL Given stats is NULL.
+ * @retval -ENOTSUP Location cache is not enabled with CONFIG_LOCATION_CACHE.
+ */
+int location_cache_stats_get(struct location_cache_stats *stats);
+
+/**
+ * @brief Clears the location cache, including the persisted entries, and its statistics.
+ *
+ * @return 0 on success, or negative error code on failure.
+ * @retval -ENOTSUP Location cache is not enabled with CONFIG_LOCATION_CACHE.
+ */
+int location_cache_clear(void);
+
 
 /** @} */
 
@@ -136,6 +136,17 @@ int nrf_modem_lib_get_init_ret(void);
  */
 int nrf_modem_lib_shutdown(void);
 
+/**
+ * @brief Interrupt the wait of a thread for the Modem library.
+ *
+ * The ongoing wait of the thread, or its next one if it is not waiting, ends
+ * as if it had timed out. For example, poll() returns 0. This allows a thread
+ * polling offloaded sockets to update the polled sockets. Can be called from ISR.
+ *
+ * @param id Thread ID.
+ */
+void nrf_modem_lib_wait_interrupt(k_tid_t id);
+
 /**
  * @brief Print diagnostic information for the TX heap.
  */
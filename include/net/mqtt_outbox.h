@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/**
+ * @file mqtt_outbox.h
+ *
+ * @defgroup mqtt_outbox MQTT outbox library
+ * @{
+ * @brief Persistent outbox for outgoing MQTT messages.
+ *
+ * @details Outgoing PUBLISH messages are stored in a log in flash until they are
+ *          delivered. QoS 1 messages are kept until the broker acknowledges them and
+ *          are sent again after a reconnect or a reboot. Queued messages are sent
+ *          several at a time, packed into as few socket writes as possible.
+ *
+ *          The library writes the PUBLISH packets directly to the socket of the MQTT
+ *          connection, holding the mutex of the MQTT client so that the writes do not
+ *          interleave with the ones of the client. It is used by the cloud libraries,
+ *          which report the connection state and the acknowledgments to it.
+ */
+
+#ifndef MQTT_OUTBOX_H__
+#define MQTT_OUTBOX_H__
+
+#include <zephyr/kernel.h>
+#include <zephyr/net/mqtt.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief Priority of the messages on topics without a policy. */
+#define MQTT_OUTBOX_PRIORITY_DEFAULT 0
+
+/** @brief Outbox statistics, counted since the outbox was initialized or cleared. */
+struct mqtt_outbox_stats {
+	/** Messages currently stored. */
+	uint32_t stored;
+	/** PUBLISH packets written to the socket, including the replays. */
+	uint32_t sent;
+	/** QoS 1 messages sent again after a reconnect. */
+	uint32_t replayed;
+	/** QoS 1 messages acknowledged by the broker. */
+	uint32_t acked;
+	/** Messages dropped to make room for new ones. */
+	uint32_t dropped;
+	/** Messages dropped because their time to live expired. */
+	uint32_t expired;
+	/** Socket writes. */
+	uint32_t writes;
+	/** Bytes written to the socket. */
+	uint32_t bytes;
+};
+
+/**
+ * @brief Initialize the outbox and load the messages stored in flash.
+ *
+ * @details Does nothing if the outbox is already initialized.
+ *
+ * @return 0 if successful, otherwise a negative error code.
+ */
+int mqtt_outbox_init(void);
+
+/**
+ * @brief Release the outbox.
+ *
+ * @details The stored messages are kept in flash and loaded again by
+ *          @ref mqtt_outbox_init.
+ */
+void mqtt_outbox_uninit(void);
+
+/**
+ * @brief Publish a message through the outbox.
+ *
+ * @details QoS 1 messages are stored until the broker acknowledges them. QoS 0 messages
+ *          are sent right away when connected, and stored until the next connection
+ *          otherwise. The topic and the payload are copied.
+ *
+ *          If the message ID is 0, the outbox assigns one. The DUP flag is set by the
+ *          outbox when a message is sent again.
+ *
+ * @param[in] param Message to publish. QoS 2 is not supported.
+ *
+ * @retval 0 The message was sent or stored.
+ * @retval -EINVAL Invalid parameters.
+ * @retval -ENOTSUP QoS 2 was requested.
+ * @retval -EMSGSIZE The message does not fit in CONFIG_MQTT_OUTBOX_MSG_MAX_SIZE.
+ * @retval -EEXIST A stored message has the same message ID.
+ * @retval -ENOMEM The outbox is full of messages of higher priority.
+ * @return Other negative error codes if the message could not be stored.
+ */
+int mqtt_outbox_publish(const struct mqtt_publish_param *param);
+
+/**
+ * @brief Set the priority and the time to live of the messages on a topic.
+ *
+ * @details The policy with the longest topic prefix matching the topic of a message is
+ *          used. When the outbox is full, the oldest message of the lowest priority is
+ *          dropped. Messages of a higher priority are sent first.
+ *
+ * @param[in] topic Topic prefix. The string is not copied and must stay valid.
+ * @param[in] priority Priority, higher values are sent first.
+ * @param[in] ttl Time to live in seconds, 0 for no limit. The time is counted from
+ *                the boot for the messages loaded from flash.
+ *
+ * @retval 0 The policy was set.
+ * @retval -EINVAL Invalid parameters.
+ * @retval -ENOMEM All CONFIG_MQTT_OUTBOX_POLICY_COUNT policies are in use.
+ */
+int mqtt_outbox_policy_set(const char *topic, uint8_t priority, uint32_t ttl);
+
+/**
+ * @brief Notify the outbox that the MQTT connection is ready for publishing.
+ *
+ * @details The unacknowledged QoS 1 messages are sent again with the DUP flag, then
+ *          the queued messages are sent.
+ *
+ * @param[in] client Connected MQTT client. The client must stay valid until
+ *                   @ref mqtt_outbox_disconnected is called.
+ *
+ * @retval 0 The queued messages were sent.
+ * @retval -EINVAL Invalid parameters.
+ * @return Other negative error codes from the socket.
+ */
+int mqtt_outbox_connected(struct mqtt_client *client);
+
+/** @brief Notify the outbox that the MQTT connection was closed. */
+void mqtt_outbox_disconnected(void);
+
+/**
+ * @brief Notify the outbox of a PUBACK from the broker.
+ *
+ * @param[in] message_id Acknowledged message ID.
+ *
+ * @retval 0 The message was sent through the outbox and is now deleted.
+ * @retval -ENOENT The message is not in the outbox.
+ */
+int mqtt_outbox_puback(uint16_t message_id);
+
+/**
+ * @brief Send the queued messages.
+ *
+ * @details Messages are also sent when published, acknowledged and after a connection,
+ *          calling this is only needed to retry after a socket error.
+ *
+ * @retval 0 The messages that fit in the window of unacknowledged messages were sent.
+ * @retval -ENOTCONN Not connected.
+ * @return Other negative error codes from the socket.
+ */
+int mqtt_outbox_flush(void);
+
+/**
+ * @brief Get a message ID for a message published directly with the MQTT client.
+ *
+ * @details The ID is taken from the same counter as the IDs assigned by the outbox and
+ *          is not used by a stored QoS 1 message, so the PUBACK of the message is not
+ *          taken for the one of a stored message.
+ *
+ * @return Message ID, never 0.
+ */
+uint16_t mqtt_outbox_message_id_get(void);
+
+/**
+ * @brief Check if a stored QoS 1 message uses a message ID.
+ *
+ * @details Used by the callers that allocate message IDs for the messages they
+ *          publish directly, to skip the IDs of stored messages.
+ *
+ * @param[in] message_id Message ID.
+ *
+ * @return true if a stored QoS 1 message uses the ID.
+ */
+bool mqtt_outbox_message_id_used(uint16_t message_id);
+
+/**
+ * @brief Delete all stored messages.
+ *
+ * @details The statistics are reset, and the message IDs start again from 1.
+ *          Call it while disconnected, so that a PUBACK of a deleted message is
+ *          not taken for the one of a new message with the same ID.
+ *
+ * @return 0 if successful, otherwise a negative error code.
+ */
+int mqtt_outbox_clear(void);
+
+/**
+ * @brief Read the outbox statistics.
+ *
+ * @param[out] stats Statistics.
+ */
+void mqtt_outbox_stats_get(struct mqtt_outbox_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+/** @} */
+
+#endif /* MQTT_OUTBOX_H__ */
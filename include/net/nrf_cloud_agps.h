@@ -25,10 +25,13 @@ extern "C" {
 
 #if defined(CONFIG_NRF_CLOUD_MQTT)
 /**@brief Requests specified A-GPS data from nRF Cloud via MQTT.
+ *
+ * @details If CONFIG_NRF_CLOUD_AGPS_CACHE is enabled, the cached data that is still
+ *          valid is injected first and only the missing data is requested.
  *
  * @param request Structure containing specified A-GPS data to be requested.
  *
- * @retval 0       Request sent successfully.
+ * @retval 0       Request sent successfully, or all data injected from the cache.
  * @retval -EACCES Cloud connection is not established; wait for @ref NRF_CLOUD_EVT_READY.
  * @return A negative value indicates an error.
  */
@@ -68,6 +71,50 @@ void nrf_cloud_agps_processed(struct nrf_modem_gnss_agps_data_frame *received_el
  */
 bool nrf_cloud_agps_request_in_progress(void);
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+/** @brief A-GPS cache statistics, counted since boot. */
+struct nrf_cloud_agps_cache_stats {
+	/** Elements received from nRF Cloud and stored in the cache. */
+	uint32_t stored;
+	/** Elements injected from the cache. */
+	uint32_t injected;
+	/** Bytes injected from the cache. */
+	uint32_t injected_bytes;
+	/** Requested elements that were not in the cache or had expired. */
+	uint32_t missed;
+	/** Bytes of binary A-GPS data given to @ref nrf_cloud_agps_process. */
+	uint32_t processed_bytes;
+};
+
+/**@brief Inject the cached A-GPS data that is still valid.
+ *
+ * @details The elements asked for in the request are injected to the GNSS from the
+ *          cache and cleared from the request, so it only contains the elements that
+ *          must still be downloaded. System time and TOWs are never injected from the
+ *          cache. @ref nrf_cloud_agps_request does this before sending a request,
+ *          applications using @ref nrf_cloud_rest_agps_data_get call this first.
+ *
+ * @param request A-GPS data requested by the GNSS, updated with the missing elements.
+ *
+ * @return Number of elements injected, or a negative error code if an element could
+ *         not be written to the GNSS.
+ */
+int nrf_cloud_agps_cache_inject(struct nrf_modem_gnss_agps_data_frame *request);
+
+/**@brief Delete all cached A-GPS data.
+ *
+ * @details Call this when the data stored in the GNSS is deleted, for example for a
+ *          cold start test.
+ */
+void nrf_cloud_agps_cache_clear(void);
+
+/**@brief Read the A-GPS cache statistics.
+ *
+ * @param stats Statistics.
+ */
+void nrf_cloud_agps_cache_stats_get(struct nrf_cloud_agps_cache_stats *stats);
+#endif /* CONFIG_NRF_CLOUD_AGPS_CACHE */
+
 /** @} */
 
 #ifdef __cplusplus
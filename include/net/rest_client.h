@@ -51,7 +51,10 @@ struct rest_client_req_context {
 	 */
 	int connect_socket;
 
-	/** Defines whether the connection should remain after API call. Default: false. */
+	/** Defines whether the connection should remain after API call. Default: false.
+	 *  If false and CONFIG_REST_CLIENT_POOL is enabled, the connection is given to
+	 *  the connection pool instead of being closed, and reused by the following requests.
+	 */
 	bool keep_alive;
 
 	/** Security tag. Default: REST_CLIENT_SEC_TAG_NO_SEC. */
@@ -156,6 +159,20 @@ int rest_client_request(struct rest_client_req_context *req_ctx,
  */
 void rest_client_request_defaults_set(struct rest_client_req_context *req_ctx);
 
+/**
+ * @brief Closes the idle connections of the connection pool.
+ *
+ * @details Can be used to release the sockets, for example before going offline.
+ *          Does nothing if CONFIG_REST_CLIENT_POOL is disabled.
+ */
+#if defined(CONFIG_REST_CLIENT_POOL)
+void rest_client_pool_flush(void);
+#else
+static inline void rest_client_pool_flush(void)
+{
+}
+#endif
+
 /** @} */
 
 #endif /* REST_CLIENT_H__ */
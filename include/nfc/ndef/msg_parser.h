@@ -15,6 +15,7 @@
  */
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <zephyr/types.h>
 #include <nfc/ndef/record_parser.h>
 #include <nfc/ndef/msg.h>
@@ -86,6 +87,88 @@ int nfc_ndef_msg_parse(uint8_t  *result_buf,
 		       const uint8_t *raw_data,
 		       uint32_t *raw_data_len);
 
+/** @brief Iterator over the records of a raw NDEF message.
+ *
+ *  The iterator does not need any memory for the record descriptors.
+ *  It yields record views (@ref nfc_ndef_record_view) that point into
+ *  the raw data, so the raw data must be kept as long as the iterator
+ *  or the record views are used.
+ */
+struct nfc_ndef_msg_iter {
+	/** Pointer to the raw NDEF message. */
+	const uint8_t *data;
+
+	/** Size of the raw data. */
+	uint32_t data_len;
+
+	/** Offset of the next record in the raw data. */
+	uint32_t offset;
+
+	/** Number of records returned so far. */
+	uint32_t record_count;
+
+	/** The last record of the message was returned. */
+	bool done;
+};
+
+/** @brief Initialize an iterator over the records of a raw NDEF message.
+ *
+ *  @param[out] iter Pointer to the iterator.
+ *  @param[in] raw_data Pointer to the data to be parsed.
+ *  @param[in] raw_data_len Size of the NFC data in the @p raw_data buffer.
+ */
+void nfc_ndef_msg_iter_init(struct nfc_ndef_msg_iter *iter,
+			    const uint8_t *raw_data,
+			    uint32_t raw_data_len);
+
+/** @brief Get the next record of a raw NDEF message.
+ *
+ *  Only the record header is decoded. The Record Location flags are checked
+ *  in the same way as in @ref nfc_ndef_msg_parse.
+ *
+ *  @param[in,out] iter Pointer to the iterator.
+ *  @param[out] view Pointer to the record view.
+ *
+ *  @retval 0 If the next record was found.
+ *  @retval -ENOENT If the last record of the message was already returned.
+ *  @retval -EINVAL If the record does not fit in the provided data.
+ *  @retval -EFAULT If the Record Location flags are invalid, or the data ends
+ *                  before the last record of the message.
+ */
+int nfc_ndef_msg_iter_next(struct nfc_ndef_msg_iter *iter,
+			   struct nfc_ndef_record_view *view);
+
+/** @brief Get the size of the NDEF message parsed by the iterator.
+ *
+ *  @param[in] iter Pointer to the iterator.
+ *
+ *  @return Size of the records returned so far. After @ref
+ *          nfc_ndef_msg_iter_next returned -ENOENT, this is the size
+ *          of the whole NDEF message.
+ */
+static inline uint32_t nfc_ndef_msg_iter_parsed_len(const struct nfc_ndef_msg_iter *iter)
+{
+	return iter->offset;
+}
+
+/** @brief Count the records of a raw NDEF message.
+ *
+ *  This function validates the whole message with the iterator, so it can
+ *  be used to size the buffer for @ref nfc_ndef_msg_parse exactly.
+ *
+ *  @param[in] raw_data Pointer to the data to be parsed.
+ *  @param[in,out] raw_data_len As input: size of the NFC data in
+ *                 the @p raw_data buffer. As output: size of the
+ *                 parsed message.
+ *  @param[out] record_count Number of records in the message.
+ *
+ *  @retval 0 If the operation was successful.
+ *            Otherwise, a (negative) error code is returned.
+ */
+int nfc_ndef_msg_record_count(const uint8_t *raw_data,
+			      uint32_t *raw_data_len,
+			      uint32_t *record_count);
+
 /** @brief Print the parsed contents of an NDEF message.
  *
  *  @param[in] msg_desc Pointer to the descriptor of the message that should
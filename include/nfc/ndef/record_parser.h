@@ -7,6 +7,8 @@
 #define NFC_NDEF_RECORD_PARSER_H_
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include <zephyr/types.h>
 #include <nfc/ndef/record.h>
 
@@ -21,6 +23,164 @@ extern "C" {
  */
 
 
+/** @brief View of an NDEF record in the raw NFC data.
+ *
+ *  The view only holds the decoded field lengths. The Type, ID and Payload
+ *  fields are not copied, use the accessor functions to get pointers to
+ *  them in the raw data. The raw data must be kept as long as the view
+ *  is used.
+ */
+struct nfc_ndef_record_view {
+	/** Pointer to the first byte (flags and TNF) of the record. */
+	const uint8_t *raw;
+
+	/** Length of the Payload field. */
+	uint32_t payload_length;
+
+	/** Length of the record header, from the flags byte up to
+	 *  the Type field.
+	 */
+	uint8_t header_length;
+
+	/** Length of the Type field. */
+	uint8_t type_length;
+
+	/** Length of the ID field. */
+	uint8_t id_length;
+};
+
+/** @brief Decode the header of an NDEF record.
+ *
+ *  The function checks that the whole record fits in the provided data,
+ *  but it does not copy any of the record fields.
+ *
+ *  @param[out] view Pointer to the record view.
+ *  @param[in] nfc_data Pointer to the raw data to be parsed.
+ *  @param[in] nfc_data_len Size of the NFC data in the @p nfc_data buffer.
+ *
+ *  @retval 0 If the operation was successful.
+ *  @retval -EINVAL If the record does not fit in the provided data.
+ */
+int nfc_ndef_record_view_decode(struct nfc_ndef_record_view *view,
+				const uint8_t *nfc_data,
+				uint32_t nfc_data_len);
+
+/** @brief Fill the record descriptors with the data of an NDEF record view.
+ *
+ *  Use this function to pass a record view to the parsers that take
+ *  the record descriptor (@ref nfc_ndef_record_desc). The fields are not
+ *  copied, the descriptors point to the raw data.
+ *
+ *  @param[in] view Pointer to the record view.
+ *  @param[out] rec_desc Pointer to the record descriptor.
+ *  @param[out] bin_pay_desc Pointer to the binary payload descriptor that
+ *                           will be referenced by the record descriptor.
+ */
+void nfc_ndef_record_view_desc_get(const struct nfc_ndef_record_view *view,
+				   struct nfc_ndef_record_desc *rec_desc,
+				   struct nfc_ndef_bin_payload_desc *bin_pay_desc);
+
+/** @brief Get the Type Name Format of an NDEF record view.
+ *
+ *  A reserved TNF value is reported as @ref TNF_UNKNOWN_TYPE.
+ *
+ *  @param[in] view Pointer to the record view.
+ *
+ *  @return Type Name Format of the record.
+ */
+static inline enum nfc_ndef_record_tnf
+nfc_ndef_record_view_tnf(const struct nfc_ndef_record_view *view)
+{
+	enum nfc_ndef_record_tnf tnf =
+		(enum nfc_ndef_record_tnf)(view->raw[0] & NDEF_RECORD_TNF_MASK);
+
+	return (tnf == TNF_RESERVED) ? TNF_UNKNOWN_TYPE : tnf;
+}
+
+/** @brief Get the location of an NDEF record view within the NDEF message.
+ *
+ *  @param[in] view Pointer to the record view.
+ *
+ *  @return Record location.
+ */
+static inline enum nfc_ndef_record_location
+nfc_ndef_record_view_location(const struct nfc_ndef_record_view *view)
+{
+	return (enum nfc_ndef_record_location)(view->raw[0] & NDEF_RECORD_LOCATION_MASK);
+}
+
+/** @brief Get the Type field of an NDEF record view.
+ *
+ *  @param[in] view Pointer to the record view.
+ *
+ *  @return Pointer to the Type field, or NULL if the record has no type.
+ */
+static inline const uint8_t *nfc_ndef_record_view_type(const struct nfc_ndef_record_view *view)
+{
+	return view->type_length ? (view->raw + view->header_length) : NULL;
+}
+
+/** @brief Get the ID field of an NDEF record view.
+ *
+ *  @param[in] view Pointer to the record view.
+ *
+ *  @return Pointer to the ID field, or NULL if the record has no ID.
+ */
+static inline const uint8_t *nfc_ndef_record_view_id(const struct nfc_ndef_record_view *view)
+{
+	return view->id_length ?
+	       (view->raw + view->header_length + view->type_length) : NULL;
+}
+
+/** @brief Get the Payload field of an NDEF record view.
+ *
+ *  @param[in] view Pointer to the record view.
+ *
+ *  @return Pointer to the Payload field, or NULL if the payload is empty.
+ */
+static inline const uint8_t *
+nfc_ndef_record_view_payload(const struct nfc_ndef_record_view *view)
+{
+	return view->payload_length ?
+	       (view->raw + view->header_length + view->type_length + view->id_length) :
+	       NULL;
+}
+
+/** @brief Get the size of an NDEF record view in the raw data.
+ *
+ *  @param[in] view Pointer to the record view.
+ *
+ *  @return Size of the whole record, in bytes.
+ */
+static inline uint32_t nfc_ndef_record_view_size(const struct nfc_ndef_record_view *view)
+{
+	return view->header_length + view->type_length + view->id_length +
+	       view->payload_length;
+}
+
+/** @brief Check the Type Name Format and the Type field of an NDEF record view.
+ *
+ *  @param[in] view Pointer to the record view.
+ *  @param[in] tnf Expected Type Name Format.
+ *  @param[in] type Expected Type field.
+ *  @param[in] type_len Length of the expected Type field.
+ *
+ *  @retval true If the record has the given TNF and type.
+ *  @retval false Otherwise.
+ */
+static inline bool nfc_ndef_record_view_type_check(const struct nfc_ndef_record_view *view,
+						   enum nfc_ndef_record_tnf tnf,
+						   const uint8_t *type,
+						   uint8_t type_len)
+{
+	if ((nfc_ndef_record_view_tnf(view) != tnf) || (view->type_length != type_len)) {
+		return false;
+	}
+
+	return (type_len == 0) ||
+	       (memcmp(nfc_ndef_record_view_type(view), type, type_len) == 0);
+}
+
 /** @brief Parse NDEF records.
  *
  *  This parsing implementation uses the binary payload descriptor
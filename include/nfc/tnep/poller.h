@@ -215,6 +215,27 @@ int nfc_tnep_poller_svc_search(const struct nfc_ndef_msg_desc *ndef_msg,
 			       struct nfc_ndef_tnep_rec_svc_param *param,
 			       uint8_t *cnt);
 
+/**@brief Search if a raw NDEF Message contains TNEP Service Parameters Records.
+ *
+ * Function for searching the TNEP Service Parameters Records directly in
+ * the raw NDEF Message, without parsing it into the message descriptor
+ * first. The found service parameters point to the raw data, so it has
+ * to be stored until all operations on services are finished.
+ *
+ * @param[in] data Raw NDEF Message which can be the Initial TNEP Message.
+ * @param[in] len Length of the NDEF Message.
+ * @param[out] param Pointer to structure where found service parameters will
+ *                   be stored.
+ * @param[in,out] cnt Count of service parameters which can be stored as an
+ *                    input. Count of found services parameters as an output.
+ *
+ * @retval 0 If the operation was successful.
+ *           Otherwise, a (negative) error code is returned.
+ */
+int nfc_tnep_poller_svc_search_raw(const uint8_t *data, size_t len,
+				   struct nfc_ndef_tnep_rec_svc_param *param,
+				   uint8_t *cnt);
+
 /**@brief Select the TNEP Service.
  *
  * Function for selecting the given service. After service is selected
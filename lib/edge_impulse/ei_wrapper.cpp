@@ -14,6 +14,8 @@ LOG_MODULE_REGISTER(ei_wrapper, CONFIG_EI_WRAPPER_LOG_LEVEL);
 
 #define INPUT_FRAME_SIZE	EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME
 #define INPUT_WINDOW_SIZE	EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE
+#define INPUT_SLICE_SIZE	EI_CLASSIFIER_SLICE_SIZE
+#define INPUT_SLICE_COUNT	EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW
 #define INPUT_FREQUENCY		EI_CLASSIFIER_FREQUENCY
 #define HAS_ANOMALY		EI_CLASSIFIER_HAS_ANOMALY
 #define RESULT_LABEL_COUNT	EI_CLASSIFIER_LABEL_COUNT
@@ -25,6 +27,22 @@ BUILD_ASSERT(CONFIG_EI_WRAPPER_THREAD_STACK_SIZE > 0);
 #define THREAD_PRIORITY 	CONFIG_EI_WRAPPER_THREAD_PRIORITY
 #define DEBUG_MODE		IS_ENABLED(CONFIG_EI_WRAPPER_DEBUG_MODE)
 
+#if defined(CONFIG_EI_WRAPPER_DATA_BUF_INT16)
+typedef int16_t sample_t;
+#define SAMPLE_MIN		INT16_MIN
+#define SAMPLE_MAX		INT16_MAX
+#elif defined(CONFIG_EI_WRAPPER_DATA_BUF_INT8)
+typedef int8_t sample_t;
+#define SAMPLE_MIN		INT8_MIN
+#define SAMPLE_MAX		INT8_MAX
+#else
+typedef float sample_t;
+#endif
+
+#ifdef CONFIG_EI_WRAPPER_DATA_BUF_FRAC_BITS
+#define SAMPLE_SCALE		((float)BIT(CONFIG_EI_WRAPPER_DATA_BUF_FRAC_BITS))
+#endif
+
 enum state {
 	STATE_DISABLED,
 	STATE_WAITING_FOR_DATA,
@@ -33,10 +51,11 @@ enum state {
 };
 
 struct data_buffer {
-	float buf[DATA_BUFFER_SIZE];
+	sample_t buf[DATA_BUFFER_SIZE];
 	size_t process_idx;
 	size_t append_idx;
 	size_t wait_data_size;
+	size_t moved;
 	struct k_spinlock lock;
 	enum state state;
 };
@@ -51,11 +70,46 @@ static struct data_buffer ei_input;
 static ei_impulse_result_t ei_result;
 static int cur_res_idx;
 static ei_wrapper_result_ready_cb user_cb;
+static size_t signal_offset;
 
 
 BUILD_ASSERT(DATA_BUFFER_SIZE > INPUT_WINDOW_SIZE);
 BUILD_ASSERT(INPUT_WINDOW_SIZE % INPUT_FRAME_SIZE == 0);
+#if defined(CONFIG_EI_WRAPPER_CONTINUOUS)
+BUILD_ASSERT(INPUT_WINDOW_SIZE == INPUT_SLICE_SIZE * INPUT_SLICE_COUNT);
+BUILD_ASSERT(INPUT_SLICE_SIZE % INPUT_FRAME_SIZE == 0);
+#endif
+
+
+static void samples_store(sample_t *dst, const float *src, size_t len)
+{
+#if defined(CONFIG_EI_WRAPPER_DATA_BUF_FLOAT)
+	memcpy(dst, src, len * sizeof(dst[0]));
+#else
+	for (size_t i = 0; i < len; i++) {
+		float val = roundf(src[i] * SAMPLE_SCALE);
+
+		if (val < SAMPLE_MIN) {
+			val = SAMPLE_MIN;
+		} else if (val > SAMPLE_MAX) {
+			val = SAMPLE_MAX;
+		}
+
+		dst[i] = (sample_t)val;
+	}
+#endif
+}
 
+static void samples_load(float *dst, const sample_t *src, size_t len)
+{
+#if defined(CONFIG_EI_WRAPPER_DATA_BUF_FLOAT)
+	memcpy(dst, src, len * sizeof(dst[0]));
+#else
+	for (size_t i = 0; i < len; i++) {
+		dst[i] = src[i] / SAMPLE_SCALE;
+	}
+#endif
+}
 
 static size_t buf_get_collected_data_count(const struct data_buffer *b)
 {
@@ -103,6 +157,8 @@ static int buf_cleanup(struct data_buffer *b, bool *cancelled)
 		b->process_idx = 0;
 		b->append_idx = 0;
 		b->wait_data_size = 0;
+		/* Window content is not related to the previously processed one. */
+		b->moved = SIZE_MAX;
 		b->state = STATE_READY;
 	}
 
@@ -149,11 +205,10 @@ static int buf_append(struct data_buffer *b, const float *data, size_t len,
 	if (looped) {
 		size_t copy_cnt = ARRAY_SIZE(b->buf) - cur_idx;
 
-		memcpy(&b->buf[cur_idx], data, copy_cnt * sizeof(b->buf[0]));
-		memcpy(&b->buf[0], data + copy_cnt,
-		      (len - copy_cnt) * sizeof(b->buf[0]));
+		samples_store(&b->buf[cur_idx], data, copy_cnt);
+		samples_store(&b->buf[0], data + copy_cnt, len - copy_cnt);
 	} else {
-		memcpy(&b->buf[cur_idx], data, len * sizeof(b->buf[0]));
+		samples_store(&b->buf[cur_idx], data, len);
 	}
 
 	return 0;
@@ -173,15 +228,13 @@ static void buf_get(const struct data_buffer *b, float *b_res, size_t offset,
 	if ((read_end > ARRAY_SIZE(b->buf)) && (read_start < ARRAY_SIZE(b->buf))) {
 		size_t copy_cnt = ARRAY_SIZE(b->buf) - read_start;
 
-		memcpy(b_res, &b->buf[read_start],
-		       copy_cnt * sizeof(b->buf[0]));
-		memcpy(b_res + copy_cnt, &b->buf[0],
-		       (len - copy_cnt) * sizeof(b->buf[0]));
+		samples_load(b_res, &b->buf[read_start], copy_cnt);
+		samples_load(b_res + copy_cnt, &b->buf[0], len - copy_cnt);
 	} else {
 		if (read_start >= ARRAY_SIZE(b->buf)) {
 			read_start -= ARRAY_SIZE(b->buf);
 		}
-		memcpy(b_res, &b->buf[read_start], len * sizeof(b->buf[0]));
+		samples_load(b_res, &b->buf[read_start], len);
 	}
 }
 
@@ -207,6 +260,10 @@ static int buf_processing_move(struct data_buffer *b, size_t move,
 		b->process_idx -= ARRAY_SIZE(b->buf);
 	}
 
+	if (b->moved != SIZE_MAX) {
+		b->moved += move;
+	}
+
 	size_t processing_end_move = move + INPUT_WINDOW_SIZE;
 
 	if (processing_end_move > max_move) {
@@ -295,7 +352,7 @@ int ei_wrapper_start_prediction(size_t window_shift, size_t frame_shift)
 
 static int raw_feature_get_data(size_t offset, size_t length, float *out_ptr)
 {
-	buf_get(&ei_input, out_ptr, offset, length);
+	buf_get(&ei_input, out_ptr, signal_offset + offset, length);
 
 	return 0;
 }
@@ -309,6 +366,44 @@ static void processing_finished(int err)
 	user_cb(err);
 }
 
+#if defined(CONFIG_EI_WRAPPER_CONTINUOUS)
+static EI_IMPULSE_ERROR run_classifier_incremental(signal_t *signal)
+{
+	static bool primed;
+	EI_IMPULSE_ERROR err;
+
+	/* Processing window can be moved only while no processing is done. */
+	size_t moved = ei_input.moved;
+
+	ei_input.moved = 0;
+	signal->total_length = INPUT_SLICE_SIZE;
+
+	if (primed && (moved == INPUT_SLICE_SIZE)) {
+		/* Features of the other slices are cached by the library. */
+		signal_offset = INPUT_WINDOW_SIZE - INPUT_SLICE_SIZE;
+		err = run_classifier_continuous(signal, &ei_result, DEBUG_MODE, false);
+	} else {
+		int dsp_time = 0;
+
+		run_classifier_init();
+		err = EI_IMPULSE_OK;
+
+		/* Classification is done after the last slice is provided. */
+		for (size_t i = 0; (i < INPUT_SLICE_COUNT) && !err; i++) {
+			signal_offset = i * INPUT_SLICE_SIZE;
+			err = run_classifier_continuous(signal, &ei_result, DEBUG_MODE, false);
+			dsp_time += ei_result.timing.dsp;
+		}
+
+		ei_result.timing.dsp = dsp_time;
+	}
+
+	primed = !err;
+
+	return err;
+}
+#endif /* CONFIG_EI_WRAPPER_CONTINUOUS */
+
 static void edge_impulse_thread_fn(void)
 {
 	signal_t features_signal;
@@ -319,14 +414,19 @@ static void edge_impulse_thread_fn(void)
 
 		features_signal.get_data = &raw_feature_get_data;
 		features_signal.total_length = INPUT_WINDOW_SIZE;
+		signal_offset = 0;
 
 		if (IS_ENABLED(CONFIG_EI_WRAPPER_PROFILING)) {
 			start_time = k_uptime_get();
 		}
 
 		/* Invoke the impulse. */
+#if defined(CONFIG_EI_WRAPPER_CONTINUOUS)
+		EI_IMPULSE_ERROR err = run_classifier_incremental(&features_signal);
+#else
 		EI_IMPULSE_ERROR err = run_classifier(&features_signal,
 						      &ei_result, DEBUG_MODE);
+#endif
 		if (IS_ENABLED(CONFIG_EI_WRAPPER_PROFILING)) {
 			int64_t delta = k_uptime_delta(&start_time);
 
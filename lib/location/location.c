@@ -16,6 +16,9 @@
 #endif
 
 #include "location_core.h"
+#if defined(CONFIG_LOCATION_CACHE)
+#include "location_cache.h"
+#endif
 
 LOG_MODULE_REGISTER(location, CONFIG_LOCATION_LOG_LEVEL);
 
@@ -219,3 +222,24 @@ int location_pgps_data_process(const char *buf, size_t buf_len)
 #endif
 	return -ENOTSUP;
 }
+
+int location_cache_stats_get(struct location_cache_stats *stats)
+{
+#if defined(CONFIG_LOCATION_CACHE)
+	if (!stats) {
+		LOG_ERR("Cache statistics cannot be a NULL pointer.");
+		return -EINVAL;
+	}
+	location_cache_stats_read(stats);
+	return 0;
+#endif
+	return -ENOTSUP;
+}
+
+int location_cache_clear(void)
+{
+#if defined(CONFIG_LOCATION_CACHE)
+	return location_cache_reset();
+#endif
+	return -ENOTSUP;
+}
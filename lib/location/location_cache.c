@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <modem/location.h>
+#if defined(CONFIG_LOCATION_CACHE_SETTINGS)
+#include <zephyr/settings/settings.h>
+#include <date_time.h>
+#endif
+
+#include "location_cache.h"
+
+LOG_MODULE_DECLARE(location, CONFIG_LOCATION_LOG_LEVEL);
+
+#define LOCATION_CACHE_SETTINGS_NAME "location_cache"
+
+/* 32-bit FNV-1a */
+#define LOCATION_CACHE_HASH_OFFSET 2166136261u
+#define LOCATION_CACHE_HASH_PRIME 16777619u
+
+/** Cache entry, persisted as is. */
+struct location_cache_entry {
+	/** Time the location was stored, in milliseconds. */
+	int64_t timestamp;
+	double latitude;
+	double longitude;
+	float accuracy;
+	/** Key, unused entry if the method is 0. */
+	struct location_cache_key key;
+};
+
+static struct location_cache_entry entries[CONFIG_LOCATION_CACHE_SIZE];
+
+/** Last use of the entries, for replacing the least recently used one. Not persisted. */
+static uint32_t entries_used[CONFIG_LOCATION_CACHE_SIZE];
+static uint32_t use_count;
+
+static struct location_cache_stats stats;
+
+/** Mutex protecting the cache, used by the cellular and Wi-Fi methods. */
+static K_MUTEX_DEFINE(cache_mutex);
+
+#if defined(CONFIG_LOCATION_CACHE_SETTINGS)
+static int location_cache_settings_set(const char *key, size_t len,
+				       settings_read_cb read_cb, void *cb_arg);
+
+SETTINGS_STATIC_HANDLER_DEFINE(location_cache, LOCATION_CACHE_SETTINGS_NAME, NULL,
+			       location_cache_settings_set, NULL, NULL);
+
+static int location_cache_settings_set(const char *key, size_t len,
+				       settings_read_cb read_cb, void *cb_arg)
+{
+	unsigned long index;
+	char *end;
+	ssize_t size;
+
+	index = strtoul(key, &end, 10);
+	if (end == key || *end != '\0' || index >= CONFIG_LOCATION_CACHE_SIZE) {
+		LOG_DBG("Cache entry %s ignored", log_strdup(key));
+		return 0;
+	}
+
+	if (len != sizeof(entries[index])) {
+		/* Stored with another configuration */
+		LOG_DBG("Cache entry %lu of unexpected size, ignored", index);
+		return 0;
+	}
+
+	size = read_cb(cb_arg, &entries[index], sizeof(entries[index]));
+	if (size != sizeof(entries[index])) {
+		LOG_ERR("Cache entry %lu read error: %d", index, (int)size);
+		memset(&entries[index], 0, sizeof(entries[index]));
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static void location_cache_entry_name_get(int index, char *name, size_t name_len)
+{
+	snprintk(name, name_len, LOCATION_CACHE_SETTINGS_NAME "/%d", index);
+}
+#endif /* CONFIG_LOCATION_CACHE_SETTINGS */
+
+static void location_cache_entry_save(int index)
+{
+#if defined(CONFIG_LOCATION_CACHE_SETTINGS)
+	char name[sizeof(LOCATION_CACHE_SETTINGS_NAME) + 4];
+	int err;
+
+	location_cache_entry_name_get(index, name, sizeof(name));
+	err = settings_save_one(name, &entries[index], sizeof(entries[index]));
+	if (err) {
+		LOG_WRN("Failed to save cache entry %d, error: %d", index, err);
+	}
+#else
+	ARG_UNUSED(index);
+#endif
+}
+
+/** Current time in milliseconds. Unix time when persisted, to be valid across reboots. */
+static int location_cache_now(int64_t *now)
+{
+#if defined(CONFIG_LOCATION_CACHE_SETTINGS)
+	return date_time_now(now);
+#else
+	*now = k_uptime_get();
+
+	return 0;
+#endif
+}
+
+static uint32_t location_cache_hash(const void *data, size_t len)
+{
+	const uint8_t *bytes = data;
+	uint32_t hash = LOCATION_CACHE_HASH_OFFSET;
+
+	for (size_t i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= LOCATION_CACHE_HASH_PRIME;
+	}
+
+	return hash;
+}
+
+void location_cache_key_init(struct location_cache_key *key, enum location_method method)
+{
+	memset(key, 0, sizeof(*key));
+	key->method = method;
+}
+
+void location_cache_key_add(struct location_cache_key *key, const void *data, size_t len)
+{
+	uint32_t hash = location_cache_hash(data, len);
+	int i;
+
+	/* Insert in increasing order, keeping the smallest hashes */
+	for (i = 0; i < key->fingerprint_count; i++) {
+		if (key->fingerprint[i] == hash) {
+			return;
+		}
+		if (key->fingerprint[i] > hash) {
+			break;
+		}
+	}
+	if (i == CONFIG_LOCATION_CACHE_FINGERPRINT_SIZE) {
+		return;
+	}
+	if (key->fingerprint_count < CONFIG_LOCATION_CACHE_FINGERPRINT_SIZE) {
+		key->fingerprint_count++;
+	}
+	memmove(&key->fingerprint[i + 1], &key->fingerprint[i],
+		(key->fingerprint_count - 1 - i) * sizeof(key->fingerprint[0]));
+	key->fingerprint[i] = hash;
+}
+
+#if defined(CONFIG_LOCATION_METHOD_CELLULAR)
+void location_cache_key_cellular_set(struct location_cache_key *key,
+				     const struct lte_lc_cells_info *cells)
+{
+	uint32_t ncell;
+
+	location_cache_key_init(key, LOCATION_METHOD_CELLULAR);
+	key->mcc = cells->current_cell.mcc;
+	key->mnc = cells->current_cell.mnc;
+	key->tac = cells->current_cell.tac;
+	key->cell_id = cells->current_cell.id;
+
+	for (int i = 0; i < cells->ncells_count; i++) {
+		/* Physical cell IDs are 9 bits long */
+		ncell = (cells->neighbor_cells[i].earfcn << 9) |
+			(cells->neighbor_cells[i].phys_cell_id & 0x1FF);
+		location_cache_key_add(key, &ncell, sizeof(ncell));
+	}
+}
+#endif
+
+/** Jaccard similarity of the fingerprints, in percent. */
+static int location_cache_similarity(const struct location_cache_key *a,
+				     const struct location_cache_key *b)
+{
+	int common = 0;
+	int i = 0;
+	int j = 0;
+
+	if (a->fingerprint_count == 0 && b->fingerprint_count == 0) {
+		return 100;
+	}
+
+	while (i < a->fingerprint_count && j < b->fingerprint_count) {
+		if (a->fingerprint[i] == b->fingerprint[j]) {
+			common++;
+			i++;
+			j++;
+		} else if (a->fingerprint[i] < b->fingerprint[j]) {
+			i++;
+		} else {
+			j++;
+		}
+	}
+
+	return common * 100 / (a->fingerprint_count + b->fingerprint_count - common);
+}
+
+static bool location_cache_entry_valid(const struct location_cache_entry *entry, int64_t now)
+{
+	int64_t age = now - entry->timestamp;
+
+	return entry->key.method != 0 &&
+	       age >= 0 && age < (int64_t)CONFIG_LOCATION_CACHE_TTL * MSEC_PER_SEC;
+}
+
+/** Finds the valid entry most similar to the key, -1 if none is similar enough. */
+static int location_cache_find(const struct location_cache_key *key, int64_t now)
+{
+	const struct location_cache_key *entry_key;
+	int best_similarity = CONFIG_LOCATION_CACHE_SIMILARITY - 1;
+	int best = -1;
+	int similarity;
+
+	for (int i = 0; i < CONFIG_LOCATION_CACHE_SIZE; i++) {
+		if (!location_cache_entry_valid(&entries[i], now)) {
+			continue;
+		}
+		entry_key = &entries[i].key;
+		if (entry_key->method != key->method ||
+		    entry_key->cell_id != key->cell_id ||
+		    entry_key->tac != key->tac ||
+		    entry_key->mcc != key->mcc ||
+		    entry_key->mnc != key->mnc) {
+			continue;
+		}
+		similarity = location_cache_similarity(entry_key, key);
+		if (similarity > best_similarity) {
+			best_similarity = similarity;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+/** Gets an unused or expired entry, or else the least recently used one. */
+static int location_cache_free_entry_get(int64_t now)
+{
+	int lru = 0;
+
+	for (int i = 0; i < CONFIG_LOCATION_CACHE_SIZE; i++) {
+		if (!location_cache_entry_valid(&entries[i], now)) {
+			return i;
+		}
+		if (entries_used[i] < entries_used[lru]) {
+			lru = i;
+		}
+	}
+
+	stats.evictions++;
+
+	return lru;
+}
+
+int location_cache_lookup(const struct location_cache_key *key, struct location_data *location)
+{
+	int64_t now;
+	int index = -1;
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	stats.lookups++;
+	if (location_cache_now(&now) == 0) {
+		index = location_cache_find(key, now);
+	} else {
+		LOG_DBG("Time not known, cache not used");
+	}
+
+	if (index < 0) {
+		k_mutex_unlock(&cache_mutex);
+		return -ENOENT;
+	}
+
+	stats.hits++;
+	entries_used[index] = ++use_count;
+	location->latitude = entries[index].latitude;
+	location->longitude = entries[index].longitude;
+	location->accuracy = entries[index].accuracy;
+
+	k_mutex_unlock(&cache_mutex);
+
+	LOG_DBG("Location found in cache entry %d", index);
+
+	return 0;
+}
+
+void location_cache_store(const struct location_cache_key *key,
+			  const struct location_data *location)
+{
+	struct location_cache_entry *entry;
+	int64_t now;
+	int index;
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	if (location_cache_now(&now) != 0) {
+		LOG_DBG("Time not known, location not cached");
+		k_mutex_unlock(&cache_mutex);
+		return;
+	}
+
+	index = location_cache_find(key, now);
+	if (index < 0) {
+		index = location_cache_free_entry_get(now);
+	}
+
+	entry = &entries[index];
+	entry->key = *key;
+	entry->timestamp = now;
+	entry->latitude = location->latitude;
+	entry->longitude = location->longitude;
+	entry->accuracy = location->accuracy;
+	entries_used[index] = ++use_count;
+	stats.stores++;
+
+	location_cache_entry_save(index);
+
+	k_mutex_unlock(&cache_mutex);
+
+	LOG_DBG("Location stored in cache entry %d", index);
+}
+
+void location_cache_stats_read(struct location_cache_stats *stats_out)
+{
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+	*stats_out = stats;
+	k_mutex_unlock(&cache_mutex);
+}
+
+int location_cache_reset(void)
+{
+	int err = 0;
+#if defined(CONFIG_LOCATION_CACHE_SETTINGS)
+	char name[sizeof(LOCATION_CACHE_SETTINGS_NAME) + 4];
+	int ret;
+#endif
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	for (int i = 0; i < CONFIG_LOCATION_CACHE_SIZE; i++) {
+#if defined(CONFIG_LOCATION_CACHE_SETTINGS)
+		if (entries[i].key.method != 0) {
+			location_cache_entry_name_get(i, name, sizeof(name));
+			ret = settings_delete(name);
+			if (ret) {
+				LOG_WRN("Failed to delete cache entry %d, error: %d", i, ret);
+				err = ret;
+			}
+		}
+#endif
+		memset(&entries[i], 0, sizeof(entries[i]));
+		entries_used[i] = 0;
+	}
+	use_count = 0;
+	memset(&stats, 0, sizeof(stats));
+
+	k_mutex_unlock(&cache_mutex);
+
+	return err;
+}
+
+int location_cache_init(void)
+{
+#if defined(CONFIG_LOCATION_CACHE_SETTINGS)
+	int err = settings_subsys_init();
+
+	if (err) {
+		LOG_ERR("Settings init failed: %d", err);
+		return err;
+	}
+
+	err = settings_load_subtree(LOCATION_CACHE_SETTINGS_NAME);
+	if (err) {
+		LOG_ERR("Cannot load cache entries: %d", err);
+		return err;
+	}
+#endif
+	return 0;
+}
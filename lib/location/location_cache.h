@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef LOCATION_CACHE_H
+#define LOCATION_CACHE_H
+
+#include <modem/location.h>
+#if defined(CONFIG_LOCATION_METHOD_CELLULAR)
+#include <modem/lte_lc.h>
+#endif
+
+/**
+ * @brief Cache lookup key.
+ *
+ * @details Cellular keys are made of the serving cell and a fingerprint of the neighbor cells,
+ * Wi-Fi keys of a fingerprint of the access points. A fingerprint is the bottom-k sketch of
+ * the hashes of the set elements, that is the CONFIG_LOCATION_CACHE_FINGERPRINT_SIZE smallest
+ * hashes in increasing order. Fingerprints are compared by their Jaccard similarity.
+ */
+struct location_cache_key {
+	/** LOCATION_METHOD_CELLULAR or LOCATION_METHOD_WIFI. */
+	enum location_method method;
+	/** Serving cell, for cellular keys. */
+	uint32_t cell_id;
+	uint32_t tac;
+	uint16_t mcc;
+	uint16_t mnc;
+	/** Number of hashes in the fingerprint. */
+	uint8_t fingerprint_count;
+	/** Fingerprint. */
+	uint32_t fingerprint[CONFIG_LOCATION_CACHE_FINGERPRINT_SIZE];
+};
+
+/**
+ * @brief Initialize an empty key.
+ *
+ * @param[out] key Key.
+ * @param[in] method Location method.
+ */
+void location_cache_key_init(struct location_cache_key *key, enum location_method method);
+
+/**
+ * @brief Add an element, such as an access point MAC address, to the key fingerprint.
+ *
+ * @param[in,out] key Key.
+ * @param[in] data Element.
+ * @param[in] len Element length.
+ */
+void location_cache_key_add(struct location_cache_key *key, const void *data, size_t len);
+
+#if defined(CONFIG_LOCATION_METHOD_CELLULAR)
+/**
+ * @brief Initialize a cellular key from cell measurements.
+ *
+ * @param[out] key Key.
+ * @param[in] cells Serving and neighbor cells.
+ */
+void location_cache_key_cellular_set(struct location_cache_key *key,
+				     const struct lte_lc_cells_info *cells);
+#endif
+
+/**
+ * @brief Look up a location in the cache.
+ *
+ * @details The most similar entry that has not expired is used, if its similarity is at least
+ * CONFIG_LOCATION_CACHE_SIMILARITY percent.
+ *
+ * @param[in] key Key.
+ * @param[out] location Location. Only latitude, longitude and accuracy are set.
+ *
+ * @retval 0 Location found.
+ * @retval -ENOENT Location not found.
+ */
+int location_cache_lookup(const struct location_cache_key *key, struct location_data *location);
+
+/**
+ * @brief Store a location obtained from a location service.
+ *
+ * @details Replaces the entry matching the key if any, otherwise an expired entry or the
+ * least recently used one.
+ *
+ * @param[in] key Key.
+ * @param[in] location Location.
+ */
+void location_cache_store(const struct location_cache_key *key,
+			  const struct location_data *location);
+
+/**
+ * @brief Read the cache statistics.
+ *
+ * @param[out] stats Statistics.
+ */
+void location_cache_stats_read(struct location_cache_stats *stats);
+
+/**
+ * @brief Remove all entries, also from the settings, and reset the statistics.
+ *
+ * @return 0 on success, or negative error code on failure.
+ */
+int location_cache_reset(void);
+
+/**
+ * @brief Initialize the cache and load the persisted entries.
+ *
+ * @return 0 on success, or negative error code on failure.
+ */
+int location_cache_init(void);
+
+#endif /* LOCATION_CACHE_H */
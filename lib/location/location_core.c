@@ -19,6 +19,9 @@
 #if defined(CONFIG_LOCATION_METHOD_WIFI)
 #include "method_wifi.h"
 #endif
+#if defined(CONFIG_LOCATION_CACHE)
+#include "location_cache.h"
+#endif
 
 LOG_MODULE_DECLARE(location, CONFIG_LOCATION_LOG_LEVEL);
 
@@ -60,6 +63,52 @@ K_WORK_DELAYABLE_DEFINE(location_timeout_work, location_core_timeout_work_fn);
 /** Semaphore protecting the use of location requests. */
 K_SEM_DEFINE(location_core_sem, 1, 1);
 
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+/***** Parallel location requests *****/
+
+/* Cellular and Wi-Fi positioning block their work queue while waiting for the measurements
+ * and the location service. They get their own work queues so that they run concurrently
+ * with GNSS, which uses location_core_work_q.
+ */
+#if defined(CONFIG_LOCATION_METHOD_CELLULAR)
+K_THREAD_STACK_DEFINE(location_cellular_stack, CONFIG_LOCATION_METHOD_WORKQ_STACK_SIZE);
+static struct k_work_q location_cellular_work_q;
+#endif
+#if defined(CONFIG_LOCATION_METHOD_WIFI)
+K_THREAD_STACK_DEFINE(location_wifi_stack, CONFIG_LOCATION_METHOD_WORKQ_STACK_SIZE);
+static struct k_work_q location_wifi_work_q;
+#endif
+
+/** State of a method in a parallel location request. */
+struct location_core_parallel_method {
+	/** Timeout of the method. */
+	struct k_work_delayable timeout_work;
+	/** Outcome of the method, 0 while it is running. */
+	enum location_event_id event_id;
+	/** Location acquired with the method. */
+	struct location_data location;
+};
+
+/** Methods of the ongoing parallel request, indexed as in current_config.methods. */
+static struct location_core_parallel_method parallel_methods[CONFIG_LOCATION_METHODS_LIST_SIZE];
+
+/** Whether the ongoing or last request is a parallel one. Kept once the request is done, so
+ * that late events of its methods are not taken for events of a sequential request.
+ */
+static bool parallel_mode;
+
+/** Bit mask of the indexes of the methods still running. */
+static uint32_t parallel_pending;
+
+/** Mutex protecting the state of the parallel request, methods report from several threads. */
+static K_MUTEX_DEFINE(parallel_mutex);
+
+/** Accuracy used for weighting, to not divide by 0. */
+#define LOCATION_CORE_FUSE_ACCURACY_MIN 0.1f
+
+BUILD_ASSERT(CONFIG_LOCATION_METHODS_LIST_SIZE <= 32, "Too many methods for the bit mask");
+#endif /* CONFIG_LOCATION_REQ_MODE_PARALLEL */
+
 /***** Location method configurations *****/
 
 #if defined(CONFIG_LOCATION_METHOD_GNSS)
@@ -199,6 +248,42 @@ int location_core_event_handler_set(location_event_handler_t handler)
 	return 0;
 }
 
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+static void location_core_parallel_timeout_work_fn(struct k_work *work);
+
+static void location_core_parallel_init(void)
+{
+#if defined(CONFIG_LOCATION_METHOD_CELLULAR)
+	struct k_work_queue_config cellular_cfg = {
+		.name = "location_cellular_workq",
+	};
+
+	k_work_queue_start(
+		&location_cellular_work_q,
+		location_cellular_stack,
+		K_THREAD_STACK_SIZEOF(location_cellular_stack),
+		LOCATION_CORE_PRIORITY,
+		&cellular_cfg);
+#endif
+#if defined(CONFIG_LOCATION_METHOD_WIFI)
+	struct k_work_queue_config wifi_cfg = {
+		.name = "location_wifi_workq",
+	};
+
+	k_work_queue_start(
+		&location_wifi_work_q,
+		location_wifi_stack,
+		K_THREAD_STACK_SIZEOF(location_wifi_stack),
+		LOCATION_CORE_PRIORITY,
+		&wifi_cfg);
+#endif
+	for (int i = 0; i < CONFIG_LOCATION_METHODS_LIST_SIZE; i++) {
+		k_work_init_delayable(&parallel_methods[i].timeout_work,
+				      location_core_parallel_timeout_work_fn);
+	}
+}
+#endif
+
 int location_core_init(void)
 {
 	int err;
@@ -212,6 +297,9 @@ int location_core_init(void)
 		K_THREAD_STACK_SIZEOF(location_core_stack),
 		LOCATION_CORE_PRIORITY,
 		&cfg);
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	location_core_parallel_init();
+#endif
 
 	for (int i = 0; methods_supported[i] != NULL; i++) {
 		err = methods_supported[i]->init();
@@ -224,6 +312,14 @@ int location_core_init(void)
 			methods_supported[i]->method_string);
 	}
 
+#if defined(CONFIG_LOCATION_CACHE)
+	err = location_cache_init();
+	if (err) {
+		/* Cache is still used, only the persisted entries are lost */
+		LOG_WRN("Failed to load location cache, error: %d", err);
+	}
+#endif
+
 	return 0;
 }
 
@@ -252,6 +348,27 @@ int location_core_validate_params(const struct location_config *config)
 			return -EINVAL;
 		}
 	}
+
+	if (config->mode == LOCATION_REQ_MODE_PARALLEL) {
+		if (!IS_ENABLED(CONFIG_LOCATION_REQ_MODE_PARALLEL)) {
+			LOG_ERR("Parallel location requests not enabled");
+			return -EINVAL;
+		}
+		if (config->accuracy_target < 0) {
+			LOG_ERR("Accuracy target must not be negative");
+			return -EINVAL;
+		}
+		/* Methods can only run once at a time */
+		for (int i = 0; i < config->methods_count; i++) {
+			for (int j = i + 1; j < config->methods_count; j++) {
+				if (config->methods[i].method == config->methods[j].method) {
+					LOG_ERR("Location method (%d) given twice",
+						config->methods[i].method);
+					return -EINVAL;
+				}
+			}
+		}
+	}
 	return 0;
 }
 
@@ -264,6 +381,11 @@ void location_core_config_log(const struct location_config *config)
 
 	LOG_DBG("  Methods count: %d", config->methods_count);
 	LOG_DBG("  Interval: %d", config->interval);
+	LOG_DBG("  Mode: %d", config->mode);
+	if (config->mode == LOCATION_REQ_MODE_PARALLEL) {
+		LOG_DBG("  Accuracy target: %dm", (int)config->accuracy_target);
+		LOG_DBG("  Fuse: %s", config->fuse ? "true" : "false");
+	}
 	LOG_DBG("  List of methods:");
 
 	for (uint8_t i = 0; i < config->methods_count; i++) {
@@ -314,12 +436,72 @@ static void location_core_current_config_set(const struct location_config *confi
 	memcpy(&current_config, config, sizeof(struct location_config));
 }
 
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+static int location_core_parallel_index_get(enum location_method method)
+{
+	for (int i = 0; i < current_config.methods_count; i++) {
+		if (current_config.methods[i].method == method) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static int location_core_location_get_parallel(void)
+{
+	enum location_method requested_method;
+	int err = 0;
+	int ret;
+
+	k_mutex_lock(&parallel_mutex, K_FOREVER);
+
+	parallel_pending = 0;
+	for (int i = 0; i < current_config.methods_count; i++) {
+		memset(&parallel_methods[i].location, 0, sizeof(parallel_methods[i].location));
+		parallel_methods[i].event_id = 0;
+		parallel_pending |= BIT(i);
+	}
+
+	for (int i = 0; i < current_config.methods_count; i++) {
+		requested_method = current_config.methods[i].method;
+		LOG_DBG("Requesting location with '%s' method in parallel",
+			(char *)location_method_api_get(requested_method)->method_string);
+		ret = location_method_api_get(requested_method)->location_get(
+			&current_config.methods[i]);
+		if (ret) {
+			LOG_WRN("Failed to start '%s' method, error: %d",
+				(char *)location_method_api_get(requested_method)->method_string,
+				ret);
+			parallel_methods[i].event_id = LOCATION_EVT_ERROR;
+			parallel_pending &= ~BIT(i);
+			err = ret;
+		}
+	}
+
+	if (parallel_pending != 0) {
+		err = 0;
+	}
+
+	k_mutex_unlock(&parallel_mutex);
+
+	return err;
+}
+#endif
+
 static int location_core_location_get_pos(const struct location_config *config)
 {
 	int err;
 	enum location_method requested_method;
 
 	location_core_current_config_set(config);
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	parallel_mode = (current_config.mode == LOCATION_REQ_MODE_PARALLEL);
+	if (parallel_mode) {
+		location_core_current_event_data_init(current_config.methods[0].method);
+		return location_core_location_get_parallel();
+	}
+#endif
 	/* Location request starts from the first method */
 	current_method_index = 0;
 	requested_method = config->methods[current_method_index].method;
@@ -343,18 +525,210 @@ int location_core_location_get(const struct location_config *config)
 		return -EBUSY;
 	}
 
-	return location_core_location_get_pos(config);
+	err = location_core_location_get_pos(config);
+	if (err && config->mode == LOCATION_REQ_MODE_PARALLEL) {
+		/* None of the methods could be started */
+		location_core_current_config_clear();
+		k_sem_give(&location_core_sem);
+	}
+
+	return err;
+}
+
+/** Sends the event of the request and either schedules the next periodic request or ends it. */
+static void location_core_request_done(void)
+{
+	event_handler(&current_event_data);
+
+	if (current_config.interval > 0) {
+		k_work_schedule_for_queue(
+			location_core_work_queue_get(),
+			&location_periodic_work,
+			K_SECONDS(current_config.interval));
+	} else {
+		location_core_current_config_clear();
+
+		k_sem_give(&location_core_sem);
+	}
+}
+
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+/** Combines the locations acquired in the parallel request, weighting them by their variance. */
+static void location_core_parallel_fuse(struct location_data *fused)
+{
+	const struct location_data *location;
+	double weight_sum = 0.0;
+	double latitude = 0.0;
+	double longitude_delta = 0.0;
+	double delta;
+	double weight;
+	float accuracy;
+
+	for (int i = 0; i < current_config.methods_count; i++) {
+		if (parallel_methods[i].event_id != LOCATION_EVT_LOCATION) {
+			continue;
+		}
+		location = &parallel_methods[i].location;
+		accuracy = MAX(location->accuracy, LOCATION_CORE_FUSE_ACCURACY_MIN);
+		weight = 1.0 / ((double)accuracy * accuracy);
+
+		/* Longitudes are averaged relative to the most accurate one, so that locations on
+		 * both sides of the antimeridian are combined correctly.
+		 */
+		delta = location->longitude - fused->longitude;
+		if (delta > 180.0) {
+			delta -= 360.0;
+		} else if (delta < -180.0) {
+			delta += 360.0;
+		}
+
+		latitude += weight * location->latitude;
+		longitude_delta += weight * delta;
+		weight_sum += weight;
+	}
+
+	fused->latitude = latitude / weight_sum;
+	fused->longitude += longitude_delta / weight_sum;
+	if (fused->longitude > 180.0) {
+		fused->longitude -= 360.0;
+	} else if (fused->longitude < -180.0) {
+		fused->longitude += 360.0;
+	}
+}
+
+/** Builds the event of the parallel request from the outcome of all methods. */
+static void location_core_parallel_result_set(void)
+{
+	const struct location_data *best = NULL;
+	bool timeout = false;
+
+	for (int i = 0; i < current_config.methods_count; i++) {
+		if (parallel_methods[i].event_id == LOCATION_EVT_TIMEOUT) {
+			timeout = true;
+		} else if (parallel_methods[i].event_id == LOCATION_EVT_LOCATION &&
+			   (best == NULL ||
+			    parallel_methods[i].location.accuracy < best->accuracy)) {
+			best = &parallel_methods[i].location;
+		}
+	}
+
+	if (best == NULL) {
+		LOG_ERR("Location acquisition failed with all methods");
+		current_event_data.id = timeout ? LOCATION_EVT_TIMEOUT : LOCATION_EVT_ERROR;
+		return;
+	}
+
+	current_event_data.id = LOCATION_EVT_LOCATION;
+	current_event_data.location = *best;
+	if (current_config.fuse) {
+		location_core_parallel_fuse(&current_event_data.location);
+	}
+}
+
+/** Handles the outcome of a method in a parallel request. */
+static void location_core_parallel_event_cb(
+	enum location_method method,
+	enum location_event_id event_id,
+	const struct location_data *location)
+{
+	struct location_core_parallel_method *parallel_method;
+	const struct location_method_api *method_api;
+	bool done;
+	int index;
+
+	k_mutex_lock(&parallel_mutex, K_FOREVER);
+
+	index = location_core_parallel_index_get(method);
+	if (index < 0 || !(parallel_pending & BIT(index))) {
+		/* Method was cancelled, or the request is already done */
+		k_mutex_unlock(&parallel_mutex);
+		return;
+	}
+
+	parallel_method = &parallel_methods[index];
+	(void)k_work_cancel_delayable(&parallel_method->timeout_work);
+	parallel_pending &= ~BIT(index);
+	parallel_method->event_id = event_id;
+	if (location != NULL) {
+		parallel_method->location = *location;
+	}
+
+	done = (parallel_pending == 0) ||
+	       (location != NULL &&
+		current_config.accuracy_target > 0 &&
+		location->accuracy <= current_config.accuracy_target);
+
+	LOG_DBG("'%s' method done (event %d), %s",
+		(char *)location_method_api_get(method)->method_string, event_id,
+		done ? "request done" : "waiting for other methods");
+
+	if (!done) {
+		k_mutex_unlock(&parallel_mutex);
+		return;
+	}
+
+	/* Cancel the methods still running */
+	for (int i = 0; i < current_config.methods_count; i++) {
+		if (parallel_pending & BIT(i)) {
+			method_api = location_method_api_get(current_config.methods[i].method);
+			LOG_DBG("Cancelling '%s' method", (char *)method_api->method_string);
+			(void)k_work_cancel_delayable(&parallel_methods[i].timeout_work);
+			(void)method_api->cancel();
+		}
+	}
+	parallel_pending = 0;
+
+	location_core_parallel_result_set();
+
+	k_mutex_unlock(&parallel_mutex);
+
+	location_core_request_done();
+}
+
+static void location_core_parallel_timeout_work_fn(struct k_work *work)
+{
+	struct k_work_delayable *timeout_work = k_work_delayable_from_work(work);
+	struct location_core_parallel_method *parallel_method =
+		CONTAINER_OF(timeout_work, struct location_core_parallel_method, timeout_work);
+	int index = parallel_method - parallel_methods;
+	enum location_method method;
+
+	k_mutex_lock(&parallel_mutex, K_FOREVER);
+	if (!(parallel_pending & BIT(index))) {
+		k_mutex_unlock(&parallel_mutex);
+		return;
+	}
+	method = current_config.methods[index].method;
+	LOG_WRN("Timeout occurred for '%s' method",
+		(char *)location_method_api_get(method)->method_string);
+	location_method_api_get(method)->cancel();
+	k_mutex_unlock(&parallel_mutex);
+
+	location_core_parallel_event_cb(method, LOCATION_EVT_TIMEOUT, NULL);
 }
+#endif /* CONFIG_LOCATION_REQ_MODE_PARALLEL */
 
-void location_core_event_cb_error(void)
+void location_core_event_cb_error(enum location_method method)
 {
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	if (parallel_mode) {
+		location_core_parallel_event_cb(method, LOCATION_EVT_ERROR, NULL);
+		return;
+	}
+#endif
 	current_event_data.id = LOCATION_EVT_ERROR;
 
 	location_core_event_cb(NULL);
 }
 
-void location_core_event_cb_timeout(void)
+void location_core_event_cb_timeout(enum location_method method)
 {
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	if (parallel_mode) {
+		location_core_parallel_event_cb(method, LOCATION_EVT_TIMEOUT, NULL);
+		return;
+	}
+#endif
 	current_event_data.id = LOCATION_EVT_TIMEOUT;
 
 	location_core_event_cb(NULL);
@@ -391,6 +765,13 @@ void location_core_event_cb(const struct location_data *location)
 	enum location_method previous_method;
 	int err;
 
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	if (location != NULL && parallel_mode) {
+		location_core_parallel_event_cb(location->method, LOCATION_EVT_LOCATION, location);
+		return;
+	}
+#endif
+
 	k_work_cancel_delayable(&location_timeout_work);
 
 	if (location != NULL) {
@@ -480,18 +861,7 @@ void location_core_event_cb(const struct location_data *location)
 		LOG_ERR("Location acquisition failed and fallbacks are also done");
 	}
 
-	event_handler(&current_event_data);
-
-	if (current_config.interval > 0) {
-		k_work_schedule_for_queue(
-			location_core_work_queue_get(),
-			&location_periodic_work,
-			K_SECONDS(current_config.interval));
-	} else {
-		location_core_current_config_clear();
-
-		k_sem_give(&location_core_sem);
-	}
+	location_core_request_done();
 }
 
 struct k_work_q *location_core_work_queue_get(void)
@@ -499,6 +869,25 @@ struct k_work_q *location_core_work_queue_get(void)
 	return &location_core_work_q;
 }
 
+struct k_work_q *location_core_method_work_queue_get(enum location_method method)
+{
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	switch (method) {
+#if defined(CONFIG_LOCATION_METHOD_CELLULAR)
+	case LOCATION_METHOD_CELLULAR:
+		return &location_cellular_work_q;
+#endif
+#if defined(CONFIG_LOCATION_METHOD_WIFI)
+	case LOCATION_METHOD_WIFI:
+		return &location_wifi_work_q;
+#endif
+	default:
+		break;
+	}
+#endif
+	return &location_core_work_q;
+}
+
 static void location_core_periodic_work_fn(struct k_work *work)
 {
 	ARG_UNUSED(work);
@@ -515,11 +904,31 @@ static void location_core_timeout_work_fn(struct k_work *work)
 	LOG_WRN("Timeout occurred");
 
 	location_method_api_get(current_method)->cancel();
-	location_core_event_cb_timeout();
+	location_core_event_cb_timeout(current_method);
 }
 
-void location_core_timer_start(int32_t timeout)
+void location_core_timer_start(enum location_method method, int32_t timeout)
 {
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	int index;
+
+	if (parallel_mode) {
+		if (timeout == SYS_FOREVER_MS || timeout <= 0) {
+			return;
+		}
+		k_mutex_lock(&parallel_mutex, K_FOREVER);
+		index = location_core_parallel_index_get(method);
+		if (index >= 0 && (parallel_pending & BIT(index))) {
+			LOG_DBG("Starting timer for '%s' method with timeout=%d",
+				(char *)location_method_api_get(method)->method_string, timeout);
+			k_work_schedule(&parallel_methods[index].timeout_work, K_MSEC(timeout));
+		}
+		k_mutex_unlock(&parallel_mutex);
+		return;
+	}
+#else
+	ARG_UNUSED(method);
+#endif
 	if (timeout != SYS_FOREVER_MS && timeout > 0) {
 		LOG_DBG("Starting timer with timeout=%d", timeout);
 
@@ -533,11 +942,54 @@ void location_core_timer_start(int32_t timeout)
 	}
 }
 
-void location_core_timer_stop(void)
+void location_core_timer_stop(enum location_method method)
 {
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	int index;
+
+	if (parallel_mode) {
+		k_mutex_lock(&parallel_mutex, K_FOREVER);
+		index = location_core_parallel_index_get(method);
+		if (index >= 0) {
+			k_work_cancel_delayable(&parallel_methods[index].timeout_work);
+		}
+		k_mutex_unlock(&parallel_mutex);
+		return;
+	}
+#else
+	ARG_UNUSED(method);
+#endif
 	k_work_cancel_delayable(&location_timeout_work);
 }
 
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+static int location_core_parallel_cancel(void)
+{
+	const struct location_method_api *method_api;
+	int err = 0;
+	int ret;
+
+	k_mutex_lock(&parallel_mutex, K_FOREVER);
+	for (int i = 0; i < current_config.methods_count; i++) {
+		if (!(parallel_pending & BIT(i))) {
+			continue;
+		}
+		method_api = location_method_api_get(current_config.methods[i].method);
+		LOG_DBG("Cancelling location method for '%s' method",
+			(char *)method_api->method_string);
+		(void)k_work_cancel_delayable(&parallel_methods[i].timeout_work);
+		ret = method_api->cancel();
+		if (ret && ret != -EPERM) {
+			err = ret;
+		}
+	}
+	parallel_pending = 0;
+	k_mutex_unlock(&parallel_mutex);
+
+	return err;
+}
+#endif
+
 int location_core_cancel(void)
 {
 	int err = 0;
@@ -547,6 +999,15 @@ int location_core_cancel(void)
 	k_work_cancel_delayable(&location_timeout_work);
 	k_work_cancel_delayable(&location_periodic_work);
 
+#if defined(CONFIG_LOCATION_REQ_MODE_PARALLEL)
+	if (parallel_mode) {
+		err = location_core_parallel_cancel();
+		location_core_current_config_clear();
+		k_sem_give(&location_core_sem);
+		return err;
+	}
+#endif
+
 	/* Check if location has been requested using one of the methods */
 	if (current_method != 0) {
 		LOG_DBG("Cancelling location method for '%s' method",
@@ -13,6 +13,9 @@
 
 #include "location_core.h"
 #include "location_utils.h"
+#if defined(CONFIG_LOCATION_CACHE)
+#include "location_cache.h"
+#endif
 
 LOG_MODULE_DECLARE(location, CONFIG_LOCATION_LOG_LEVEL);
 
@@ -106,6 +109,9 @@ static void method_cellular_positioning_work_fn(struct k_work *work)
 	struct multicell_location_params params = { 0 };
 	struct multicell_location location;
 	struct location_data location_result = { 0 };
+#if defined(CONFIG_LOCATION_CACHE)
+	struct location_cache_key cache_key;
+#endif
 	int64_t ncellmeas_start_time;
 	int64_t ncellmeas_time;
 	int ret;
@@ -113,7 +119,7 @@ static void method_cellular_positioning_work_fn(struct k_work *work)
 		CONTAINER_OF(work, struct method_cellular_positioning_work_args, work_item);
 	const struct location_cellular_config cellular_config = work_data->cellular_config;
 
-	location_core_timer_start(cellular_config.timeout);
+	location_core_timer_start(LOCATION_METHOD_CELLULAR, cellular_config.timeout);
 
 	ncellmeas_start_time = k_uptime_get();
 
@@ -121,7 +127,7 @@ static void method_cellular_positioning_work_fn(struct k_work *work)
 	ret = method_cellular_ncellmeas_start();
 	if (ret) {
 		LOG_WRN("Cannot start neighbor cell measurements");
-		location_core_event_cb_error();
+		location_core_event_cb_error(LOCATION_METHOD_CELLULAR);
 		running = false;
 		return;
 	}
@@ -132,11 +138,11 @@ static void method_cellular_positioning_work_fn(struct k_work *work)
 	}
 
 	/* Stop the timer and let rest_client timer handle the request */
-	location_core_timer_stop();
+	location_core_timer_stop(LOCATION_METHOD_CELLULAR);
 
 	if (cell_data.current_cell.id == LTE_LC_CELL_EUTRAN_ID_INVALID) {
 		LOG_WRN("Current cell ID not valid");
-		location_core_event_cb_error();
+		location_core_event_cb_error(LOCATION_METHOD_CELLULAR);
 		running = false;
 		return;
 	}
@@ -144,6 +150,19 @@ static void method_cellular_positioning_work_fn(struct k_work *work)
 	/* NCELLMEAS done at this point of time. Store current time to response. */
 	location_utils_systime_to_location_datetime(&location_result.datetime);
 
+#if defined(CONFIG_LOCATION_CACHE)
+	location_cache_key_cellular_set(&cache_key, &cell_data);
+	if (location_cache_lookup(&cache_key, &location_result) == 0) {
+		LOG_DBG("Location found in cache, location service not requested");
+		location_result.method = LOCATION_METHOD_CELLULAR;
+		if (running) {
+			running = false;
+			location_core_event_cb(&location_result);
+		}
+		return;
+	}
+#endif
+
 	/* Check if timeout is given */
 	params.timeout = cellular_config.timeout;
 	if (cellular_config.timeout != SYS_FOREVER_MS) {
@@ -153,7 +172,7 @@ static void method_cellular_positioning_work_fn(struct k_work *work)
 		/* Check if timeout has already elapsed */
 		if (ncellmeas_time >= cellular_config.timeout) {
 			LOG_WRN("Timeout occurred during neighbour cell measurement");
-			location_core_event_cb_timeout();
+			location_core_event_cb_timeout(LOCATION_METHOD_CELLULAR);
 			running = false;
 			return;
 		}
@@ -168,15 +187,18 @@ static void method_cellular_positioning_work_fn(struct k_work *work)
 	if (ret) {
 		LOG_ERR("Failed to acquire location from multicell_location lib, error: %d", ret);
 		if (ret == -ETIMEDOUT) {
-			location_core_event_cb_timeout();
+			location_core_event_cb_timeout(LOCATION_METHOD_CELLULAR);
 		} else {
-			location_core_event_cb_error();
+			location_core_event_cb_error(LOCATION_METHOD_CELLULAR);
 		}
 	} else {
 		location_result.method = LOCATION_METHOD_CELLULAR;
 		location_result.latitude = location.latitude;
 		location_result.longitude = location.longitude;
 		location_result.accuracy = location.accuracy;
+#if defined(CONFIG_LOCATION_CACHE)
+		location_cache_store(&cache_key, &location_result);
+#endif
 		if (running) {
 			running = false;
 			location_core_event_cb(&location_result);
@@ -189,7 +211,7 @@ int method_cellular_location_get(const struct location_method_config *config)
 	/* Note: LTE status not checked, let it fail in NCELLMEAS if no connection */
 
 	method_cellular_positioning_work.cellular_config = config->cellular;
-	k_work_submit_to_queue(location_core_work_queue_get(),
+	k_work_submit_to_queue(location_core_method_work_queue_get(LOCATION_METHOD_CELLULAR),
 			       &method_cellular_positioning_work.work_item);
 
 	running = true;
@@ -72,6 +72,9 @@ static struct k_work method_gnss_agps_request_work;
 #if defined(CONFIG_NRF_CLOUD_REST) && !defined(CONFIG_NRF_CLOUD_MQTT)
 static char agps_rest_data_buf[AGPS_REQUEST_RECV_BUF_SIZE];
 #endif
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+bool method_gnss_agps_required(struct nrf_modem_gnss_agps_data_frame *request);
+#endif
 #endif
 
 #if defined(CONFIG_NRF_CLOUD_PGPS)
@@ -226,6 +229,24 @@ static void method_gnss_agps_request_work_fn(struct k_work *item)
 		.fragment_size = 0
 	};
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	/* Download only the data that could not be injected from the cache. */
+	err = nrf_cloud_agps_cache_inject(&agps_request);
+	if (err < 0) {
+		LOG_WRN("Injecting cached A-GPS data failed, error: %d", err);
+	}
+
+	if (!method_gnss_agps_required(&agps_request)) {
+		LOG_DBG("A-GPS data injected from cache");
+#if defined(CONFIG_NRF_CLOUD_PGPS)
+		k_work_submit_to_queue(
+			location_core_work_queue_get(),
+			&method_gnss_notify_pgps_work);
+#endif
+		return;
+	}
+#endif
+
 	jwt_buf = location_utils_nrf_cloud_jwt_generate();
 	if (jwt_buf == NULL) {
 		return;
@@ -627,7 +648,7 @@ static void method_gnss_pvt_work_fn(struct k_work *item)
 
 	if (nrf_modem_gnss_read(&pvt_data, sizeof(pvt_data), NRF_MODEM_GNSS_DATA_PVT) != 0) {
 		LOG_ERR("Failed to read PVT data from GNSS");
-		location_core_event_cb_error();
+		location_core_event_cb_error(LOCATION_METHOD_GNSS);
 		return;
 	}
 
@@ -663,7 +684,7 @@ static void method_gnss_pvt_work_fn(struct k_work *item)
 		    method_gnss_tracked_satellites(&pvt_data) < VISIBILITY_DETECTION_SAT_LIMIT) {
 			LOG_DBG("GNSS visibility obstructed, canceling");
 			method_gnss_cancel();
-			location_core_event_cb_error();
+			location_core_event_cb_error(LOCATION_METHOD_GNSS);
 		}
 	}
 }
@@ -720,7 +741,7 @@ static void method_gnss_positioning_work_fn(struct k_work *work)
 
 	if (err) {
 		LOG_ERR("Failed to configure GNSS");
-		location_core_event_cb_error();
+		location_core_event_cb_error(LOCATION_METHOD_GNSS);
 		running = false;
 		return;
 	}
@@ -728,12 +749,12 @@ static void method_gnss_positioning_work_fn(struct k_work *work)
 	err = nrf_modem_gnss_start();
 	if (err) {
 		LOG_ERR("Failed to start GNSS");
-		location_core_event_cb_error();
+		location_core_event_cb_error(LOCATION_METHOD_GNSS);
 		running = false;
 		return;
 	}
 
-	location_core_timer_start(gnss_config.timeout);
+	location_core_timer_start(LOCATION_METHOD_GNSS, gnss_config.timeout);
 }
 
 int method_gnss_location_get(const struct location_method_config *config)
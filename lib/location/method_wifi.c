@@ -16,6 +16,9 @@
 #include "location_core.h"
 #include "location_utils.h"
 #include "wifi/wifi_service.h"
+#if defined(CONFIG_LOCATION_CACHE)
+#include "location_cache.h"
+#endif
 
 LOG_MODULE_DECLARE(location, CONFIG_LOCATION_LOG_LEVEL);
 
@@ -153,9 +156,12 @@ static void method_wifi_positioning_work_fn(struct k_work *work)
 	struct location_data result;
 	const struct location_wifi_config wifi_config = work_data->wifi_config;
 	int64_t starting_uptime_ms = work_data->starting_uptime_ms;
+#if defined(CONFIG_LOCATION_CACHE)
+	struct location_cache_key cache_key;
+#endif
 	int err;
 
-	location_core_timer_start(wifi_config.timeout);
+	location_core_timer_start(LOCATION_METHOD_WIFI, wifi_config.timeout);
 
 	err = method_wifi_scanning_start();
 	if (err) {
@@ -168,11 +174,30 @@ static void method_wifi_positioning_work_fn(struct k_work *work)
 		goto end;
 	}
 	/* Stop the timer and let rest_client timer handle the request */
-	location_core_timer_stop();
+	location_core_timer_stop(LOCATION_METHOD_WIFI);
 
 	/* Scanning done at this point of time. Store current time to response. */
 	location_utils_systime_to_location_datetime(&location_result.datetime);
 
+#if defined(CONFIG_LOCATION_CACHE)
+	/* Cache is looked up before checking the PDN, a cached location does not need it */
+	location_cache_key_init(&cache_key, LOCATION_METHOD_WIFI);
+	for (int i = 0; i < latest_scan_result_count; i++) {
+		location_cache_key_add(&cache_key, latest_scan_results[i].mac_addr_str,
+				       strlen(latest_scan_results[i].mac_addr_str));
+	}
+	if (latest_scan_result_count > 1 &&
+	    location_cache_lookup(&cache_key, &location_result) == 0) {
+		LOG_DBG("Location found in cache, location service not requested");
+		location_result.method = LOCATION_METHOD_WIFI;
+		if (running) {
+			running = false;
+			location_core_event_cb(&location_result);
+		}
+		goto end;
+	}
+#endif
+
 	if (!location_utils_is_default_pdn_active()) {
 		/* Not worth to start trying to fetch with the REST api over cellular.
 		 * Thus, fail faster in this case and save the trying "costs".
@@ -219,6 +244,9 @@ static void method_wifi_positioning_work_fn(struct k_work *work)
 			location_result.latitude = result.latitude;
 			location_result.longitude = result.longitude;
 			location_result.accuracy = result.accuracy;
+#if defined(CONFIG_LOCATION_CACHE)
+			location_cache_store(&cache_key, &location_result);
+#endif
 			if (running) {
 				running = false;
 				location_core_event_cb(&location_result);
@@ -239,10 +267,10 @@ static void method_wifi_positioning_work_fn(struct k_work *work)
 	}
 end:
 	if (err == -ETIMEDOUT) {
-		location_core_event_cb_timeout();
+		location_core_event_cb_timeout(LOCATION_METHOD_WIFI);
 		running = false;
 	} else if (err) {
-		location_core_event_cb_error();
+		location_core_event_cb_error(LOCATION_METHOD_WIFI);
 		running = false;
 	}
 }
@@ -263,7 +291,8 @@ int method_wifi_location_get(const struct location_method_config *config)
 	k_work_init(&method_wifi_start_work.work_item, method_wifi_positioning_work_fn);
 	method_wifi_start_work.wifi_config = config->wifi;
 	method_wifi_start_work.starting_uptime_ms = k_uptime_get();
-	k_work_submit_to_queue(location_core_work_queue_get(), &method_wifi_start_work.work_item);
+	k_work_submit_to_queue(location_core_method_work_queue_get(LOCATION_METHOD_WIFI),
+			       &method_wifi_start_work.work_item);
 
 	running = true;
 
@@ -43,11 +43,16 @@
 /* Offloading context related to nRF socket. */
 static struct nrf_sock_ctx {
 	int nrf_fd; /* nRF socket descriptior. */
+	int type; /* nRF socket type. */
 	struct k_mutex *lock; /* Mutex associated with the socket. */
 } offload_ctx[NRF_MODEM_MAX_SOCKET_COUNT];
 
 static K_MUTEX_DEFINE(ctx_lock);
 
+/* Pool of intermediate buffers used by `sendmsg` to repack the message. */
+K_MEM_SLAB_DEFINE(nrf91_sendmsg_slab, CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE,
+		  CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_COUNT, sizeof(void *));
+
 static const struct socket_op_vtable nrf91_socket_fd_op_vtable;
 
 /* Offloading disabled in general. */
@@ -55,7 +60,7 @@ static bool offload_disabled;
 /* TLS offloading disabled only. */
 static bool tls_offload_disabled;
 
-static struct nrf_sock_ctx *allocate_ctx(int nrf_fd)
+static struct nrf_sock_ctx *allocate_ctx(int nrf_fd, int type)
 {
 	struct nrf_sock_ctx *ctx = NULL;
 
@@ -65,6 +70,7 @@ static struct nrf_sock_ctx *allocate_ctx(int nrf_fd)
 		if (offload_ctx[i].nrf_fd == -1) {
 			ctx = &offload_ctx[i];
 			ctx->nrf_fd = nrf_fd;
+			ctx->type = type;
 			break;
 		}
 	}
@@ -79,6 +85,7 @@ static void release_ctx(struct nrf_sock_ctx *ctx)
 	k_mutex_lock(&ctx_lock, K_FOREVER);
 
 	ctx->nrf_fd = -1;
+	ctx->type = 0;
 	ctx->lock = NULL;
 
 	k_mutex_unlock(&ctx_lock);
@@ -556,7 +563,7 @@ static int nrf91_socket_offload_accept(void *obj, struct sockaddr *addr,
 		goto error;
 	}
 
-	ctx = allocate_ctx(new_sd);
+	ctx = allocate_ctx(new_sd, NRF_SOCK_STREAM);
 	if (ctx == NULL) {
 		errno = ENOMEM;
 		goto error;
@@ -844,15 +851,42 @@ error:
 	return retval;
 }
 
+static ssize_t sendmsg_repacked(void *obj, uint8_t *buf,
+				const struct msghdr *msg, int flags)
+{
+	ssize_t len = 0;
+	ssize_t offset;
+	ssize_t ret;
+
+	for (int i = 0; i < msg->msg_iovlen; i++) {
+		memcpy(buf + len, msg->msg_iov[i].iov_base,
+		       msg->msg_iov[i].iov_len);
+		len += msg->msg_iov[i].iov_len;
+	}
+
+	offset = 0;
+	ret = 0;
+	while ((offset < len) && (ret >= 0)) {
+		ret = nrf91_socket_offload_sendto(obj,
+			(buf + offset), (len - offset), flags,
+			msg->msg_name, msg->msg_namelen);
+		if (ret > 0) {
+			offset += ret;
+		}
+	}
+
+	return ret;
+}
+
 static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 					    int flags)
 {
+	struct nrf_sock_ctx *ctx = OBJ_TO_CTX(obj);
 	ssize_t len = 0;
 	ssize_t ret;
 	ssize_t offset;
+	void *buf;
 	int i;
-	static K_MUTEX_DEFINE(sendmsg_lock);
-	static uint8_t buf[CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE];
 
 	if (msg == NULL) {
 		errno = EINVAL;
@@ -874,34 +908,33 @@ static ssize_t nrf91_socket_offload_sendmsg(void *obj, const struct msghdr *msg,
 		len += msg->msg_iov[i].iov_len;
 	}
 
-	if (len <= sizeof(buf)) {
-		/* Protect `buf` access with a mutex. */
-		k_mutex_lock(&sendmsg_lock, K_FOREVER);
-		len = 0;
-
-		for (i = 0; i < msg->msg_iovlen; i++) {
-			memcpy(buf + len, msg->msg_iov[i].iov_base,
-			       msg->msg_iov[i].iov_len);
-			len += msg->msg_iov[i].iov_len;
-		}
+	if (len <= CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE) {
+		/* Each sender takes its own buffer from the pool, so that
+		 * senders on different sockets are not serialized.
+		 */
+		k_mem_slab_alloc(&nrf91_sendmsg_slab, &buf, K_FOREVER);
+		ret = sendmsg_repacked(obj, buf, msg, flags);
+		k_mem_slab_free(&nrf91_sendmsg_slab, &buf);
+		return ret;
+	}
 
-		offset = 0;
-		ret = 0;
-		while ((offset < len) && (ret >= 0)) {
-			ret = nrf91_socket_offload_sendto(obj,
-				(buf + offset), (len - offset), flags,
-				msg->msg_name, msg->msg_namelen);
-			if (ret > 0) {
-				offset += ret;
-			}
+	/* Sending the message parts separately would split a datagram into
+	 * several ones, so repack it into a buffer allocated for this message.
+	 */
+	if (ctx->type != NRF_SOCK_STREAM) {
+		buf = k_malloc(len);
+		if (buf == NULL) {
+			errno = ENOMEM;
+			return -1;
 		}
 
-		k_mutex_unlock(&sendmsg_lock);
+		ret = sendmsg_repacked(obj, buf, msg, flags);
+		k_free(buf);
 		return ret;
 	}
 
-	/* If the data won't fit into intermediate buffer, send the buffers
-	 * separately
+	/* If the stream data won't fit into intermediate buffer, send the
+	 * buffers separately
 	 */
 
 	len = 0;
@@ -1272,7 +1305,7 @@ static int nrf91_socket_create(int family, int type, int proto)
 		return -1;
 	}
 
-	ctx = allocate_ctx(sd);
+	ctx = allocate_ctx(sd, z_to_nrf_socktype(type));
 	if (ctx == NULL) {
 		errno = ENOMEM;
 		nrf_close(sd);
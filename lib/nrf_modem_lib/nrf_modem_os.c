@@ -16,6 +16,7 @@
 #include <errno.h>
 #include <pm_config.h>
 #include <zephyr/logging/log.h>
+#include <modem/nrf_modem_lib.h>
 
 #ifdef CONFIG_NRF_MODEM_LIB_TRACE_ENABLED
 #include <modem/nrf_modem_lib_trace.h>
@@ -42,6 +43,7 @@ struct mem_diagnostic_info {
 struct sleeping_thread {
 	sys_snode_t node;
 	struct k_sem sem;
+	k_tid_t id;
 };
 
 /* Shared memory heap
@@ -68,6 +70,7 @@ static struct mem_diagnostic_info trace_heap_diag;
 static struct thread_monitor_entry {
 	k_tid_t id; /* Thread ID. */
 	int cnt; /* Last RPC event count. */
+	bool interrupt; /* Next or ongoing wait is interrupted. */
 } thread_event_monitor[THREAD_MONITOR_ENTRIES];
 
 /* A list of threads that are sleeping and should be woken up on next event. */
@@ -104,6 +107,7 @@ static struct thread_monitor_entry *thread_monitor_entry_get(k_tid_t id)
 
 	new_entry->id = id;
 	new_entry->cnt = rpc_event_cnt - 1;
+	new_entry->interrupt = false;
 
 	return new_entry;
 }
@@ -134,6 +138,7 @@ static bool can_thread_sleep(struct thread_monitor_entry *entry)
 static void sleeping_thread_init(struct sleeping_thread *thread)
 {
 	k_sem_init(&thread->sem, 0, 1);
+	thread->id = k_current_get();
 }
 
 /* Add thread to the sleeping threads list. Will return information whether
@@ -148,7 +153,7 @@ static bool sleeping_thread_add(struct sleeping_thread *thread)
 
 	entry = thread_monitor_entry_get(k_current_get());
 
-	if (can_thread_sleep(entry)) {
+	if (!entry->interrupt && can_thread_sleep(entry)) {
 		allow_to_sleep = true;
 		sys_slist_append(&sleeping_threads, &thread->node);
 	}
@@ -173,6 +178,46 @@ static void sleeping_thread_remove(struct sleeping_thread *thread)
 	irq_unlock(key);
 }
 
+/* Check whether the wait of the current thread is interrupted, and clear the
+ * interruption. An interrupted wait ends as if it had timed out.
+ */
+static bool wait_interrupted(int32_t *timeout)
+{
+	struct thread_monitor_entry *entry;
+	bool interrupt;
+
+	uint32_t key = irq_lock();
+
+	entry = thread_monitor_entry_get(k_current_get());
+	interrupt = entry->interrupt;
+	entry->interrupt = false;
+
+	irq_unlock(key);
+
+	if (interrupt) {
+		*timeout = 0;
+	}
+
+	return interrupt;
+}
+
+void nrf_modem_lib_wait_interrupt(k_tid_t id)
+{
+	struct sleeping_thread *thread;
+
+	uint32_t key = irq_lock();
+
+	thread_monitor_entry_get(id)->interrupt = true;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&sleeping_threads, thread, node) {
+		if (thread->id == id) {
+			k_sem_give(&thread->sem);
+		}
+	}
+
+	irq_unlock(key);
+}
+
 void nrf_modem_os_busywait(int32_t usec)
 {
 	k_busy_wait(usec);
@@ -201,7 +246,7 @@ int32_t nrf_modem_os_timedwait(uint32_t context, int32_t *timeout)
 	sleeping_thread_init(&thread);
 
 	if (!sleeping_thread_add(&thread)) {
-		return 0;
+		return wait_interrupted(timeout) ? -NRF_EAGAIN : 0;
 	}
 
 	(void)k_sem_take(&thread.sem, SYS_TIMEOUT_MS(*timeout));
@@ -212,6 +257,10 @@ int32_t nrf_modem_os_timedwait(uint32_t context, int32_t *timeout)
 		return -NRF_ESHUTDOWN;
 	}
 
+	if (wait_interrupted(timeout)) {
+		return -NRF_EAGAIN;
+	}
+
 	if (*timeout == SYS_FOREVER_MS) {
 		return 0;
 	}
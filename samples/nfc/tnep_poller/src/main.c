@@ -26,7 +26,6 @@
 #define NFC_TNEP_SVC_NAME_MAX_LEN 30
 
 #define MAX_TLV_BLOCKS 10
-#define MAX_NDEF_RECORDS 10
 
 #define NFC_T4T_ISODEP_FSD 256
 #define NFC_T4T_ISODEP_RX_DATA_MAX_SIZE 1024
@@ -115,21 +114,10 @@ static void nfc_tag_detect(bool all_request)
 static bool tnep_data_search(const uint8_t *ndef_msg_buff, size_t nfc_data_len)
 {
 	int  err;
-	uint8_t desc_buf[NFC_NDEF_PARSER_REQUIRED_MEM(MAX_NDEF_RECORDS)];
-	size_t desc_buf_len = sizeof(desc_buf);
 	uint8_t cnt = ARRAY_SIZE(services);
 
-	err = nfc_ndef_msg_parse(desc_buf,
-				 &desc_buf_len,
-				 ndef_msg_buff,
-				 &nfc_data_len);
-	if (err) {
-		printk("Error during parsing a NDEF message, err: %d.\n", err);
-		return false;
-	}
-
-	err = nfc_tnep_poller_svc_search((struct nfc_ndef_msg_desc *) desc_buf,
-					 services, &cnt);
+	err = nfc_tnep_poller_svc_search_raw(ndef_msg_buff, nfc_data_len,
+					     services, &cnt);
 	if (err) {
 		printk("Service search err: %d\n", err);
 		return false;
@@ -0,0 +1,352 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+"""
+Utility for creating application delta patches.
+
+An application delta patch describes the new application image as a sequence
+of approximate copies of the current image (bsdiff-style diff data) and new
+data (extra data). It is applied by the 'dfu_target_app_delta' DFU target
+against the image in the MCUboot primary slot while the patch is downloaded.
+
+Patch format (integers are little-endian):
+
+header:  magic "ADLT" (u32), source size (u32), source CRC-32 (u32),
+         target size (u32)
+records: diff length, extra length and zigzag-encoded seek (LEB128 varints),
+         diff data as pairs of zero run length and literal length (varints),
+         each literal length followed by the literal delta bytes,
+         extra data (extra length bytes).
+
+Delta bytes are added to the source bytes at the current source position.
+The source position is advanced by the diff length and then moved by the seek.
+
+Usage examples:
+
+Creating a patch from the signed images of the current and new firmware:
+./app_delta_tool.py create --source old/app_update.bin --target new/app_update.bin app_delta.bin
+
+Applying a patch, for example to verify it:
+./app_delta_tool.py apply --source old/app_update.bin app_delta.bin new_app_update.bin
+
+Showing the patch statistics:
+./app_delta_tool.py show app_delta.bin
+"""
+
+import argparse
+import struct
+import zlib
+
+
+MAGIC = 0x544c4441
+HEADER_FORMAT = '<IIII'
+HEADER_SIZE = struct.calcsize(HEADER_FORMAT)
+
+# Length of the substring used to find match candidates in the source image
+MATCH_KEY_LEN = 8
+
+# Score of a differing byte when extending a match, relative to an equal byte
+MISMATCH_COST = 3
+
+# Shortest zero run that starts a new zero run and literal pair
+MIN_ZERO_RUN = 3
+
+
+def encode_varint(value: int) -> bytes:
+    out = bytearray()
+
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def decode_varint(data: bytes, pos: int) -> tuple:
+    value = 0
+    shift = 0
+
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7f) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def zigzag(value: int) -> int:
+    return ((value << 1) ^ (value >> 31)) & 0xffffffff
+
+
+def unzigzag(value: int) -> int:
+    return (value >> 1) ^ -(value & 1)
+
+
+def build_index(source: bytes) -> dict:
+    """
+    Map each substring of MATCH_KEY_LEN bytes to its first position in the source
+    """
+
+    index = {}
+
+    for pos in range(len(source) - MATCH_KEY_LEN + 1):
+        index.setdefault(source[pos:pos + MATCH_KEY_LEN], pos)
+
+    return index
+
+
+def extend_match(source: bytes, spos: int, target: bytes, tpos: int) -> int:
+    """
+    Extend an approximate match forward, similarly to bsdiff. The match length
+    maximizes a score where differing bytes cost more than equal bytes gain, so
+    that the match ends where the images stop being mostly the same.
+    """
+
+    limit = min(len(source) - spos, len(target) - tpos)
+    score = 0
+    best_score = 0
+    best_len = 0
+
+    for i in range(limit):
+        if source[spos + i] == target[tpos + i]:
+            score += 1
+            if score > best_score:
+                best_score = score
+                best_len = i + 1
+        else:
+            score -= MISMATCH_COST
+            # Stop when the mismatches can no longer pay off
+            if score < best_score - 2 * MATCH_KEY_LEN:
+                break
+
+    return best_len
+
+
+def find_matches(source: bytes, target: bytes) -> list:
+    """
+    Find approximate matches as (target position, source position, length)
+    """
+
+    index = build_index(source)
+    matches = []
+    offset = 0
+    tpos = 0
+
+    while tpos + MATCH_KEY_LEN <= len(target):
+        key = target[tpos:tpos + MATCH_KEY_LEN]
+        spos = tpos + offset
+
+        # Prefer continuing at the offset of the previous match
+        if not (0 <= spos and source[spos:spos + MATCH_KEY_LEN] == key):
+            spos = index.get(key)
+
+        if spos is None:
+            tpos += 1
+            continue
+
+        length = extend_match(source, spos, target, tpos)
+        matches.append((tpos, spos, length))
+        offset = spos - tpos
+        tpos += length
+
+    return matches
+
+
+def encode_diff(delta: bytes) -> bytes:
+    """
+    Encode delta bytes as pairs of zero run length and literal length
+    """
+
+    out = bytearray()
+    pos = 0
+
+    while pos < len(delta):
+        start = pos
+        while pos < len(delta) and delta[pos] == 0:
+            pos += 1
+        out += encode_varint(pos - start)
+
+        if pos == len(delta):
+            break
+
+        start = pos
+        while pos < len(delta) and delta[pos:pos + MIN_ZERO_RUN] != bytes(MIN_ZERO_RUN):
+            pos += 1
+        # A shorter zero run at the end is cheaper as literal bytes
+        if len(delta) - pos < MIN_ZERO_RUN:
+            pos = len(delta)
+        out += encode_varint(pos - start)
+        out += delta[start:pos]
+
+    return bytes(out)
+
+
+def encode_record(diff: bytes, extra: bytes, seek: int) -> bytes:
+    return (encode_varint(len(diff)) + encode_varint(len(extra)) +
+            encode_varint(zigzag(seek)) + encode_diff(diff) + extra)
+
+
+def create_patch(source: bytes, target: bytes) -> bytes:
+    """
+    Create a patch that transforms the source image into the target image
+    """
+
+    patch = bytearray(struct.pack(HEADER_FORMAT, MAGIC, len(source),
+                                  zlib.crc32(source), len(target)))
+    matches = find_matches(source, target)
+    source_pos = 0
+    target_pos = 0
+
+    # Bytes before the first match are stored as extra data, followed by a seek
+    # to the source position of the first match
+    if target and (not matches or matches[0][:2] != (0, 0)):
+        end = matches[0][0] if matches else len(target)
+        seek = matches[0][1] if matches else 0
+        patch += encode_record(b'', target[:end], seek)
+        source_pos = seek
+        target_pos = end
+
+    for i, (tpos, spos, length) in enumerate(matches):
+        assert tpos == target_pos and spos == source_pos
+
+        diff = bytes((target[tpos + j] - source[spos + j]) & 0xff for j in range(length))
+
+        if i + 1 < len(matches):
+            extra_end, next_spos, _ = matches[i + 1]
+        else:
+            extra_end, next_spos = len(target), spos + length
+
+        seek = next_spos - (spos + length)
+        patch += encode_record(diff, target[tpos + length:extra_end], seek)
+        source_pos = next_spos
+        target_pos = extra_end
+
+    return bytes(patch)
+
+
+def parse_patch(patch: bytes) -> tuple:
+    magic, source_size, source_crc, target_size = struct.unpack_from(HEADER_FORMAT, patch)
+
+    if magic != MAGIC:
+        raise ValueError('Invalid patch magic')
+
+    return source_size, source_crc, target_size
+
+
+def apply_patch(source: bytes, patch: bytes) -> bytes:
+    """
+    Apply a patch to the source image, the same way the DFU target does
+    """
+
+    source_size, source_crc, target_size = parse_patch(patch)
+
+    if len(source) != source_size or zlib.crc32(source) != source_crc:
+        raise ValueError('Patch does not apply to source image')
+
+    target = bytearray()
+    source_pos = 0
+    pos = HEADER_SIZE
+
+    while len(target) < target_size:
+        diff_len, pos = decode_varint(patch, pos)
+        extra_len, pos = decode_varint(patch, pos)
+        seek, pos = decode_varint(patch, pos)
+
+        diff_end = len(target) + diff_len
+        while len(target) < diff_end:
+            zero_run, pos = decode_varint(patch, pos)
+            target += source[source_pos:source_pos + zero_run]
+            source_pos += zero_run
+
+            if len(target) < diff_end:
+                literal_len, pos = decode_varint(patch, pos)
+                for byte in patch[pos:pos + literal_len]:
+                    target.append((source[source_pos] + byte) & 0xff)
+                    source_pos += 1
+                pos += literal_len
+
+        target += patch[pos:pos + extra_len]
+        pos += extra_len
+        source_pos += unzigzag(seek)
+
+    if pos != len(patch) or len(target) != target_size:
+        raise ValueError('Malformed patch')
+
+    return bytes(target)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Application delta patch tool',
+                                     fromfile_prefix_chars='@')
+    subcommands = parser.add_subparsers(dest='subcommand', title='valid subcommands')
+
+    create_parser = subcommands.add_parser(
+        'create', help='Create application delta patch')
+    create_parser.add_argument(
+        '-s', '--source', required=True, help='Path to current image')
+    create_parser.add_argument(
+        '-t', '--target', required=True, help='Path to new image')
+    create_parser.add_argument(
+        'output_file', help='Path to output patch file')
+
+    apply_parser = subcommands.add_parser(
+        'apply', help='Apply application delta patch')
+    apply_parser.add_argument(
+        '-s', '--source', required=True, help='Path to current image')
+    apply_parser.add_argument(
+        'input_file', help='Path to patch file')
+    apply_parser.add_argument(
+        'output_file', help='Path to output image file')
+
+    show_parser = subcommands.add_parser(
+        'show', help='Show application delta patch header')
+    show_parser.add_argument(
+        'input_file', help='Path to patch file')
+
+    args = parser.parse_args()
+
+    if args.subcommand == 'create':
+        with open(args.source, 'rb') as file:
+            source = file.read()
+        with open(args.target, 'rb') as file:
+            target = file.read()
+
+        patch = create_patch(source, target)
+
+        # Verify that the patch reproduces the target image
+        if apply_patch(source, patch) != target:
+            raise RuntimeError('Patch verification failed')
+
+        with open(args.output_file, 'wb') as file:
+            file.write(patch)
+
+        print(f'Patch size: {len(patch)} bytes ({100 * len(patch) // max(len(target), 1)}% '
+              'of target image)')
+    elif args.subcommand == 'apply':
+        with open(args.source, 'rb') as file:
+            source = file.read()
+        with open(args.input_file, 'rb') as file:
+            patch = file.read()
+
+        with open(args.output_file, 'wb') as file:
+            file.write(apply_patch(source, patch))
+    elif args.subcommand == 'show':
+        with open(args.input_file, 'rb') as file:
+            source_size, source_crc, target_size = parse_patch(file.read(HEADER_SIZE))
+
+        print(f'Source size: {source_size}')
+        print(f'Source CRC-32: 0x{source_crc:08x}')
+        print(f'Target size: {target_size}')
+    else:
+        parser.print_help()
+
+
+if __name__ == "__main__":
+    main()
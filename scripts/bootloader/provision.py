@@ -14,8 +14,12 @@ from hashlib import sha256
 import os
 
 
+# Size of a single validated firmware record, see struct bl_validation_record.
+VALIDATION_RECORD_SIZE = 48
+
+
 def generate_provision_hex_file(s0_address, s1_address, hashes, provision_address, output, max_size,
-                                num_counter_slots_version):
+                                num_counter_slots_version, num_validation_records=0):
     # Add addresses
     provision_data = struct.pack('III', s0_address, s1_address, len(hashes))
     for mhash in hashes:
@@ -33,8 +37,17 @@ def generate_provision_hex_file(s0_address, s1_address, hashes, provision_addres
         provision_data += struct.pack('H', 1) # counter description
         provision_data += struct.pack('H', num_counter_slots_version)
 
-    assert (len(provision_data) + (2 * num_counter_slots_version)) <= max_size, """Provisioning data doesn't fit.
-Reduce the number of public keys or counter slots and try again."""
+    provision_size = len(provision_data) + (2 * num_counter_slots_version)
+
+    if num_validation_records > 0:
+        # The records are placed after the counter slots, which are left unwritten.
+        provision_data += b'\xff' * (2 * num_counter_slots_version)
+        provision_data += struct.pack('H', 2) # Type "validation record collection"
+        provision_data += struct.pack('H', num_validation_records)
+        provision_size = len(provision_data) + (VALIDATION_RECORD_SIZE * num_validation_records)
+
+    assert provision_size <= max_size, """Provisioning data doesn't fit.
+Reduce the number of public keys, counter slots or validation records and try again."""
 
     ih = IntelHex()
     ih.frombytes(provision_data, offset=provision_address)
@@ -57,6 +70,8 @@ def parse_args():
                         help='Maximum total size of the provision data, including the counter slots.')
     parser.add_argument('--num-counter-slots-version', required=False, type=int, default=0,
                         help='Number of monotonic counter slots for version number.')
+    parser.add_argument('--num-validation-records', required=False, type=int, default=0,
+                        help='Number of records for firmware already validated by the bootloader.')
     parser.add_argument('--no-verify-hashes', required=False, action="store_true",
                         help="Don't check hashes for applicability. Use this option only for testing.")
     return parser.parse_args()
@@ -94,7 +109,8 @@ def main():
                                 provision_address=provision_address,
                                 output=args.output,
                                 max_size=args.max_size,
-                                num_counter_slots_version=args.num_counter_slots_version)
+                                num_counter_slots_version=args.num_counter_slots_version,
+                                num_validation_records=args.num_validation_records)
 
 
 if __name__ == '__main__':
@@ -0,0 +1,260 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+"""Benchmark of the REST client connection strategies against a local HTTPS server.
+
+A local HTTPS server stands in for the REST service, behind a relay that adds the
+round-trip time of the cellular link and counts the bytes on the wire. The same
+sequence of requests is made with each strategy of the REST client library:
+
+  connect  New connection per request, DNS query and full TLS handshake
+           (CONFIG_REST_CLIENT_SCKT_TLS_SESSION_CACHE_IN_USE=n).
+  resume   New connection per request, DNS query and abbreviated TLS handshake
+           resuming the previous session (default configuration).
+  pool     Connections kept alive in the connection pool and the address in the DNS
+           cache (CONFIG_REST_CLIENT_POOL=y, CONFIG_REST_CLIENT_DNS_CACHE=y).
+
+TLS 1.2 is used, as the library requests IPPROTO_TLS_1_2 sockets.
+"""
+
+import argparse
+import http.client
+import http.server
+import os
+import socket
+import ssl
+import statistics
+import subprocess
+import tempfile
+import threading
+import time
+
+STRATEGIES = ('connect', 'resume', 'pool')
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+
+    def do_POST(self):
+        length = int(self.headers.get('Content-Length', 0))
+        self.rfile.read(length)
+        body = b'{"lat":61.49780,"lon":23.76100,"uncertainty":1200,"type":"MCELL"}'
+        body = body.ljust(self.server.body_size, b' ')
+        self.send_response(200)
+        self.send_header('Content-Type', 'application/json')
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    do_GET = do_POST
+
+    def log_message(self, format, *args):
+        pass
+
+
+class Server(http.server.ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, cert, key, body_size, idle_timeout):
+        super().__init__(('127.0.0.1', 0), Handler)
+        self.body_size = body_size
+        self.idle_timeout = idle_timeout
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.maximum_version = ssl.TLSVersion.TLSv1_2
+        context.load_cert_chain(cert, key)
+        self.context = context
+
+    def get_request(self):
+        sock, addr = self.socket.accept()
+        sock.settimeout(self.idle_timeout)
+        return self.context.wrap_socket(sock, server_side=True), addr
+
+
+class Relay:
+    """TCP relay adding a one-way delay and counting the bytes in both directions."""
+
+    def __init__(self, target, rtt_ms):
+        self.target = target
+        self.delay = rtt_ms / 2000
+        self.up = 0
+        self.down = 0
+        self.lock = threading.Lock()
+        self.sock = socket.create_server(('127.0.0.1', 0))
+        self.port = self.sock.getsockname()[1]
+        threading.Thread(target=self.accept, daemon=True).start()
+
+    def accept(self):
+        while True:
+            client, _ = self.sock.accept()
+            server = socket.create_connection(self.target)
+            for src, dst, up in ((client, server, True), (server, client, False)):
+                threading.Thread(target=self.forward, args=(src, dst, up), daemon=True).start()
+
+    def forward(self, src, dst, up):
+        try:
+            while True:
+                data = src.recv(4096)
+                if not data:
+                    break
+                time.sleep(self.delay)
+                with self.lock:
+                    if up:
+                        self.up += len(data)
+                    else:
+                        self.down += len(data)
+                dst.sendall(data)
+        except OSError:
+            pass
+        finally:
+            for s in (src, dst):
+                try:
+                    s.shutdown(socket.SHUT_RDWR)
+                except OSError:
+                    pass
+
+    def counters(self):
+        with self.lock:
+            return self.up, self.down
+
+
+class Client:
+    def __init__(self, strategy, port, dns_ms, rtt_ms, idle_timeout):
+        self.strategy = strategy
+        self.port = port
+        self.dns_delay = (dns_ms + rtt_ms) / 1000
+        self.idle_timeout = idle_timeout
+        self.context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+        self.context.maximum_version = ssl.TLSVersion.TLSv1_2
+        self.context.check_hostname = False
+        self.context.verify_mode = ssl.CERT_NONE
+        self.session = None
+        self.conn = None
+        self.conn_idle_since = 0
+        self.resolved = False
+        self.handshakes = 0
+        self.resumed = 0
+
+    def resolve(self):
+        # Stands in for the DNS query over the cellular link
+        if self.strategy != 'pool' or not self.resolved:
+            time.sleep(self.dns_delay)
+            self.resolved = True
+        return ('127.0.0.1', self.port)
+
+    def connect(self):
+        sock = socket.create_connection(self.resolve())
+        session = self.session if self.strategy == 'resume' else None
+        conn = self.context.wrap_socket(sock, session=session)
+        self.handshakes += 1
+        if conn.session_reused:
+            self.resumed += 1
+        self.session = conn.session
+        return conn
+
+    def request(self, body):
+        if self.conn and time.monotonic() - self.conn_idle_since >= self.idle_timeout:
+            self.conn.close()
+            self.conn = None
+        conn = self.conn or self.connect()
+        self.conn = None
+        request = (f'POST /v1/location/ground-fix HTTP/1.1\r\n'
+                   f'Host: api.nrfcloud.com\r\n'
+                   f'Content-Type: application/json\r\n'
+                   f'Content-Length: {len(body)}\r\n\r\n').encode() + body
+        conn.sendall(request)
+        response = http.client.HTTPResponse(conn)
+        response.begin()
+        response.read()
+        if self.strategy == 'pool' and not response.will_close:
+            self.conn = conn
+            self.conn_idle_since = time.monotonic()
+        else:
+            conn.close()
+        return response.status
+
+
+def certificate(directory):
+    cert = os.path.join(directory, 'cert.pem')
+    key = os.path.join(directory, 'key.pem')
+    subprocess.run(['openssl', 'req', '-x509', '-newkey', 'ec', '-pkeyopt',
+                    'ec_paramgen_curve:prime256v1', '-nodes', '-days', '1',
+                    '-subj', '/CN=api.nrfcloud.com', '-keyout', key, '-out', cert],
+                   check=True, capture_output=True)
+    return cert, key
+
+
+def run(args, cert, key, strategy):
+    server = Server(cert, key, args.body_size, args.server_idle_timeout)
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    relay = Relay(server.server_address, args.rtt)
+    client = Client(strategy, relay.port, args.dns, args.rtt, args.idle_timeout)
+    body = b'{"lte":[{"mcc":244,"mnc":91,"eci":19088771,"tac":15502}]}'
+
+    latencies = []
+    for _ in range(args.requests):
+        start = time.monotonic()
+        status = client.request(body)
+        latencies.append((time.monotonic() - start) * 1000)
+        if status != 200:
+            raise RuntimeError(f'Unexpected status {status}')
+        time.sleep(args.interval / 1000)
+
+    # Let the relay count the closing bytes
+    time.sleep(args.rtt / 1000 + 0.1)
+    up, down = relay.counters()
+    server.shutdown()
+
+    latencies.sort()
+    return {
+        'strategy': strategy,
+        'median': statistics.median(latencies),
+        'p90': latencies[int(len(latencies) * 0.9) - 1],
+        'up': up / args.requests,
+        'down': down / args.requests,
+        'handshakes': client.handshakes,
+        'resumed': client.resumed,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('--requests', type=int, default=20, help='Requests per strategy')
+    parser.add_argument('--interval', type=int, default=500,
+                        help='Time between the requests in milliseconds')
+    parser.add_argument('--rtt', type=int, default=200,
+                        help='Round-trip time of the link in milliseconds')
+    parser.add_argument('--dns', type=int, default=50,
+                        help='DNS resolver time on top of the round trip in milliseconds')
+    parser.add_argument('--body-size', type=int, default=128, help='Response body size')
+    parser.add_argument('--idle-timeout', type=int, default=30,
+                        help='CONFIG_REST_CLIENT_POOL_IDLE_TIMEOUT in seconds')
+    parser.add_argument('--server-idle-timeout', type=int, default=60,
+                        help='Idle timeout of the server in seconds')
+    parser.add_argument('--strategy', choices=STRATEGIES, action='append',
+                        help='Strategy to benchmark, all by default')
+    parser.add_argument('--cert', help='Server certificate, generated by default')
+    parser.add_argument('--key', help='Server private key')
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as directory:
+        if args.cert and args.key:
+            cert, key = args.cert, args.key
+        else:
+            cert, key = certificate(directory)
+
+        results = [run(args, cert, key, s) for s in args.strategy or STRATEGIES]
+
+    print(f'{args.requests} requests, RTT {args.rtt} ms, interval {args.interval} ms\n')
+    print(f'{"strategy":<10}{"median ms":>11}{"p90 ms":>9}{"up B/req":>10}{"down B/req":>12}'
+          f'{"handshakes":>12}{"resumed":>9}')
+    for r in results:
+        print(f'{r["strategy"]:<10}{r["median"]:>11.0f}{r["p90"]:>9.0f}{r["up"]:>10.0f}'
+              f'{r["down"]:>12.0f}{r["handshakes"]:>12}{r["resumed"]:>9}')
+
+
+if __name__ == '__main__':
+    main()
@@ -10,15 +10,22 @@
 
 #include <bluetooth/gatt_dm.h>
 
+#if CONFIG_BT_GATT_DM_CACHE
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/init.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/byteorder.h>
+#endif
+
 LOG_MODULE_REGISTER(bt_gatt_dm, CONFIG_BT_GATT_DM_LOG_LEVEL);
 
-/* Available sizes: 128, 512, 2048... */
-#define CHUNK_DATA_SIZE (128 - sizeof(struct k_mem_block_id) \
-		- sizeof(struct data_chunk_item *))
+/* Size of a memory block of the discovery data arena */
+#define ARENA_BLOCK_SIZE 128
+#define ARENA_BLOCK_DATA_SIZE (ARENA_BLOCK_SIZE - sizeof(sys_snode_t))
 
 #define DATA_ALIGN 4U
 
-/* They are placed in data_chunk without padding, so they must be aligned */
+/* They are placed in the arena without padding, so they must be aligned */
 BUILD_ASSERT(sizeof(struct bt_gatt_service_val) % DATA_ALIGN == 0);
 BUILD_ASSERT(sizeof(struct bt_gatt_chrc) % DATA_ALIGN == 0);
 
@@ -29,12 +36,78 @@ enum {
 	STATE_NUM
 };
 
-/* One item in linked list containing dynamically allocated user data chunks */
-struct data_chunk_item {
+#if CONFIG_BT_GATT_DM_CACHE
+/* Settings subtree of the discovery cache */
+#define CACHE_SUBTREE "bt_dm"
+/* Bump when the record layout changes, older records are then rediscovered */
+#define CACHE_VERSION 1
+/* Hex encoded local identity and peer identity address */
+#define CACHE_PEER_KEY_LEN (2 * (1 + sizeof(bt_addr_le_t)) + 1)
+/* bt_dm/<peer>/<service UUID>/<instance> */
+#define CACHE_KEY_LEN (sizeof(CACHE_SUBTREE) + CACHE_PEER_KEY_LEN + 2 * 16 + 5)
+/* Encoded UUID: type and value */
+#define CACHE_UUID_MAX_LEN (1 + 16)
+/* The largest encoded attribute is a characteristic declaration: handle,
+ * permissions, 16-bit attribute UUID, value UUID, value handle and properties.
+ */
+#define CACHE_ATTR_MAX_LEN (3 + 3 + CACHE_UUID_MAX_LEN + 3)
+/* Keys removed in one settings pass when a bond is deleted */
+#define CACHE_DELETE_BATCH 4
+
+/* Header of the record stored for every discovered service instance */
+struct cache_hdr {
+	uint8_t version;
+	/* Number of attributes, 0 if there are no more service instances */
+	uint8_t attr_cnt;
+	/* End handle of the service, the next instance is searched after it */
+	uint16_t end_handle;
+	uint8_t hash[BT_GATT_DM_CACHE_HASH_LEN];
+} __packed;
+
+/* Header of the user data stored with @ref bt_gatt_dm_cache_data_store */
+struct cache_data_hdr {
+	uint8_t version;
+	uint8_t hash[BT_GATT_DM_CACHE_HASH_LEN];
+} __packed;
+
+union cache_uuid {
+	struct bt_uuid uuid;
+	struct bt_uuid_16 u16;
+	struct bt_uuid_32 u32;
+	struct bt_uuid_128 u128;
+};
+
+struct cache_load_ctx {
+	size_t len;
+};
+
+struct cache_delete_ctx {
+	const char *subtree;
+	char keys[CACHE_DELETE_BATCH][CACHE_KEY_LEN];
+	size_t cnt;
+};
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
+/* One memory block of the discovery data arena */
+struct arena_block {
 	/* Required by the sys_slist */
 	sys_snode_t node;
 	/* User data storage */
-	uint8_t data[CHUNK_DATA_SIZE];
+	uint8_t data[ARENA_BLOCK_DATA_SIZE];
+};
+
+BUILD_ASSERT(sizeof(struct arena_block) == ARENA_BLOCK_SIZE);
+
+/* Discovery data of one instance, released at once when the discovery data is
+ * released.
+ */
+struct arena {
+	/* Blocks taken from the arena_slab */
+	sys_slist_t blocks;
+	/* Number of blocks in the list, at most CONFIG_BT_GATT_DM_ARENA_BLOCKS */
+	size_t block_cnt;
+	/* The used length of the last block */
+	size_t used;
 };
 
 /* The instance structure real declaration */
@@ -61,78 +134,141 @@ struct bt_gatt_dm {
 		struct bt_uuid_128 u128;
 	} svc_uuid;
 
-	/* Single-linked list of allocated chunks for user data */
-	sys_slist_t chunk_list;
-	/* The used length of the current chunk */
-	size_t cur_chunk_len;
+	/* Storage of the attribute values and UUIDs */
+	struct arena arena;
 
 	/* The pointer to callback structure */
 	const struct bt_gatt_dm_cb *callback;
 
 	/* Indicates that services should be searched by the UUID. */
 	bool search_svc_by_uuid;
+
+#if CONFIG_BT_GATT_DM_CACHE
+	/* Persistent cache state of the current discovery */
+	struct {
+		/* Read parameters of the Database Hash characteristic */
+		struct bt_gatt_read_params read_params;
+		/* Serves the discovery from the cache or starts it */
+		struct k_work work;
+		/* Database Hash of the peer */
+		uint8_t hash[BT_GATT_DM_CACHE_HASH_LEN];
+		/* Peer identity address */
+		bt_addr_le_t peer;
+		/* Local identity */
+		uint8_t id;
+		/* Index of the service instance with the searched UUID */
+		uint8_t instance;
+		/* The peer is bonded and its Database Hash is known */
+		bool active;
+		/* The Database Hash read is in progress */
+		bool hash_pending;
+		/* The current service was restored from the cache */
+		bool restored;
+	} cache;
+#endif
 };
 
-/* Currently only one instance is supported */
-static struct bt_gatt_dm bt_gatt_dm_inst;
+static struct bt_gatt_dm bt_gatt_dm_inst[CONFIG_BT_GATT_DM_MAX_INSTANCES];
 
-/* Returns pointer to newly allocated space in a dm->data_chunk */
-static void *user_data_alloc(struct bt_gatt_dm *dm,
-			     size_t len)
+/* Every instance takes at most CONFIG_BT_GATT_DM_ARENA_BLOCKS blocks, so a large
+ * discovery cannot starve the other instances.
+ */
+K_MEM_SLAB_DEFINE(arena_slab, ARENA_BLOCK_SIZE,
+		  CONFIG_BT_GATT_DM_MAX_INSTANCES * CONFIG_BT_GATT_DM_ARENA_BLOCKS,
+		  DATA_ALIGN);
+
+/* Descriptor UUIDs that are referenced instead of being stored in the arena */
+static const struct bt_uuid_16 desc_uuids[] = {
+	BT_UUID_INIT_16(BT_UUID_GATT_CEP_VAL),
+	BT_UUID_INIT_16(BT_UUID_GATT_CUD_VAL),
+	BT_UUID_INIT_16(BT_UUID_GATT_CCC_VAL),
+	BT_UUID_INIT_16(BT_UUID_GATT_SCC_VAL),
+	BT_UUID_INIT_16(BT_UUID_GATT_CPF_VAL),
+	BT_UUID_INIT_16(BT_UUID_GATT_CAF_VAL),
+};
+
+static void *arena_alloc(struct arena *arena, size_t len)
 {
-	uint8_t *user_data_loc;
-	struct data_chunk_item *item;
+	struct arena_block *block;
+	void *block_mem;
+	uint8_t *loc;
 
 	/* Round up len to 32 bits to make sure that return pointers are always
 	 * correctly aligned.
 	 */
 	len = ROUND_UP(len, DATA_ALIGN);
 
-	__ASSERT_NO_MSG(len <= CHUNK_DATA_SIZE);
-
-	if (sys_slist_is_empty(&dm->chunk_list) ||
-	    dm->cur_chunk_len + len > CHUNK_DATA_SIZE) {
-
-		item = k_calloc(1, sizeof(struct data_chunk_item));
+	__ASSERT_NO_MSG(len <= ARENA_BLOCK_DATA_SIZE);
 
-		if (!item) {
+	if (sys_slist_is_empty(&arena->blocks) ||
+	    arena->used + len > ARENA_BLOCK_DATA_SIZE) {
+		if (arena->block_cnt >= CONFIG_BT_GATT_DM_ARENA_BLOCKS ||
+		    k_mem_slab_alloc(&arena_slab, &block_mem, K_NO_WAIT)) {
+			LOG_WRN("Discovery data arena full, increase "
+				"CONFIG_BT_GATT_DM_ARENA_BLOCKS");
 			return NULL;
 		}
 
-		sys_slist_append(&dm->chunk_list, &item->node);
-		dm->cur_chunk_len = 0;
-
+		block = block_mem;
+		sys_slist_append(&arena->blocks, &block->node);
+		arena->block_cnt++;
+		arena->used = 0;
 	} else {
+		block = SYS_SLIST_PEEK_TAIL_CONTAINER(&arena->blocks, block,
+						      node);
+	}
 
-		item = SYS_SLIST_PEEK_TAIL_CONTAINER(&dm->chunk_list, item,
-						     node);
+	loc = &block->data[arena->used];
+	arena->used += len;
 
+	return loc;
+}
+
+static void arena_reset(struct arena *arena)
+{
+	sys_snode_t *node;
+	void *block_mem;
+
+	while ((node = sys_slist_get(&arena->blocks)) != NULL) {
+		block_mem = CONTAINER_OF(node, struct arena_block, node);
+		k_mem_slab_free(&arena_slab, &block_mem);
 	}
 
-	user_data_loc = &item->data[dm->cur_chunk_len];
-	dm->cur_chunk_len += len;
+	arena->block_cnt = 0;
+	arena->used = 0;
+}
 
-	return user_data_loc;
+/* Returns pointer to newly allocated space in the dm->arena */
+static void *user_data_alloc(struct bt_gatt_dm *dm,
+			     size_t len)
+{
+	return arena_alloc(&dm->arena, len);
 }
 
 static void svc_attr_memory_release(struct bt_gatt_dm *dm)
 {
-	sys_snode_t *node;
-	struct data_chunk_item *item;
-
 	LOG_DBG("Attr memory release");
 
 	/* Clear attributes */
 	dm->cur_attr_id = 0;
 
-	/* Release dynamic memory data chunks */
-	while (!sys_slist_is_empty(&dm->chunk_list)) {
-		node = sys_slist_get_not_empty(&dm->chunk_list);
-		item = CONTAINER_OF(node, struct data_chunk_item, node);
-		k_free(item);
+	arena_reset(&dm->arena);
+}
+
+/* Returns the shared copy of a descriptor UUID or NULL */
+static struct bt_uuid *desc_uuid_get(const struct bt_uuid *uuid)
+{
+	if (uuid->type != BT_UUID_TYPE_16) {
+		return NULL;
 	}
 
-	dm->cur_chunk_len = 0;
+	for (size_t i = 0; i < ARRAY_SIZE(desc_uuids); i++) {
+		if (desc_uuids[i].val == BT_UUID_16(uuid)->val) {
+			return (struct bt_uuid *)&desc_uuids[i].uuid;
+		}
+	}
+
+	return NULL;
 }
 
 /* Returns size of UUID structure with padding for memory alignment */
@@ -154,7 +290,8 @@ static size_t get_uuid_size(const struct bt_uuid *uuid)
 /** @brief Stores attribute in bt_gatt_dm instance.
  *
  * This function stores attr at dm->attrs array. Its UUID is stored in
- * dm->data_chunk. The Discovery Manager attribute does not contain
+ * dm->arena, unless it is a common descriptor UUID which is shared between
+ * the attributes. The Discovery Manager attribute does not contain
  * a pointer to the context data. This data could be either
  * bt_gatt_service_val or bt_gatt_chrc. It is assumed that attribute context
  * data (if any) is always placed before its UUID data. For this purpose,
@@ -180,20 +317,28 @@ static struct bt_gatt_dm_attr *attr_store(struct bt_gatt_dm *dm,
 		return NULL;
 	}
 
+	struct bt_uuid *desc_uuid = additional_len ? NULL : desc_uuid_get(attr->uuid);
 	size_t uuid_size = get_uuid_size(attr->uuid);
-	uint8_t *attr_data = user_data_alloc(dm, additional_len + uuid_size);
+	uint8_t *attr_data = NULL;
 
-	if (!attr_data) {
-		LOG_ERR("No space for attribute data.");
-		return NULL;
+	if (!desc_uuid) {
+		attr_data = user_data_alloc(dm, additional_len + uuid_size);
+		if (!attr_data) {
+			LOG_ERR("No space for attribute data.");
+			return NULL;
+		}
 	}
 
 	cur_attr = &dm->attrs[(dm->cur_attr_id)++];
 	cur_attr->handle = attr->handle;
 	cur_attr->perm = attr->perm;
-	cur_attr->uuid = (struct bt_uuid *)&attr_data[additional_len];
 
-	memcpy(cur_attr->uuid, attr->uuid, uuid_size);
+	if (desc_uuid) {
+		cur_attr->uuid = desc_uuid;
+	} else {
+		cur_attr->uuid = (struct bt_uuid *)&attr_data[additional_len];
+		memcpy(cur_attr->uuid, attr->uuid, uuid_size);
+	}
 
 	return cur_attr;
 }
@@ -247,9 +392,311 @@ static struct bt_gatt_dm_attr *attr_find_by_handle(
 	return NULL;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+static uint8_t cache_buf[sizeof(struct cache_hdr) +
+			 CONFIG_BT_GATT_DM_MAX_ATTRS * CACHE_ATTR_MAX_LEN];
+static K_MUTEX_DEFINE(cache_lock);
+static const struct bt_uuid_16 db_hash_uuid = BT_UUID_INIT_16(BT_UUID_GATT_DB_HASH_VAL);
+
+static void cache_peer_key(char *buf, uint8_t id, const bt_addr_le_t *addr)
+{
+	uint8_t peer[1 + sizeof(*addr)];
+
+	peer[0] = id;
+	memcpy(&peer[1], addr, sizeof(*addr));
+	bin2hex(peer, sizeof(peer), buf, CACHE_PEER_KEY_LEN);
+}
+
+static void cache_svc_key(char *key, const struct bt_gatt_dm *dm)
+{
+	char peer[CACHE_PEER_KEY_LEN];
+	char uuid[2 * 16 + 1] = "0";
+
+	if (dm->search_svc_by_uuid) {
+		if (dm->svc_uuid.uuid.type == BT_UUID_TYPE_16) {
+			snprintk(uuid, sizeof(uuid), "%04x", dm->svc_uuid.u16.val);
+		} else {
+			bin2hex(dm->svc_uuid.u128.val, sizeof(dm->svc_uuid.u128.val),
+				uuid, sizeof(uuid));
+		}
+	}
+
+	cache_peer_key(peer, dm->cache.id, &dm->cache.peer);
+	snprintk(key, CACHE_KEY_LEN, CACHE_SUBTREE "/%s/%s/%u", peer, uuid,
+		 dm->cache.instance);
+}
+
+static void cache_data_key(char *key, const struct bt_gatt_dm_cache_ref *ref)
+{
+	char peer[CACHE_PEER_KEY_LEN];
+
+	cache_peer_key(peer, ref->id, &ref->peer);
+	snprintk(key, CACHE_KEY_LEN, CACHE_SUBTREE "/%s/d/%04x", peer,
+		 ref->svc_handle);
+}
+
+static uint8_t *cache_uuid_encode(uint8_t *p, const struct bt_uuid *uuid)
+{
+	*p++ = uuid->type;
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		sys_put_le16(BT_UUID_16(uuid)->val, p);
+		return p + sizeof(uint16_t);
+	case BT_UUID_TYPE_32:
+		sys_put_le32(BT_UUID_32(uuid)->val, p);
+		return p + sizeof(uint32_t);
+	default:
+		memcpy(p, BT_UUID_128(uuid)->val, sizeof(BT_UUID_128(uuid)->val));
+		return p + sizeof(BT_UUID_128(uuid)->val);
+	}
+}
+
+static const uint8_t *cache_uuid_decode(const uint8_t *p, const uint8_t *end,
+					union cache_uuid *uuid)
+{
+	if (p >= end) {
+		return NULL;
+	}
+
+	uuid->uuid.type = *p++;
+
+	switch (uuid->uuid.type) {
+	case BT_UUID_TYPE_16:
+		if (end - p < sizeof(uint16_t)) {
+			return NULL;
+		}
+		uuid->u16.val = sys_get_le16(p);
+		return p + sizeof(uint16_t);
+	case BT_UUID_TYPE_32:
+		if (end - p < sizeof(uint32_t)) {
+			return NULL;
+		}
+		uuid->u32.val = sys_get_le32(p);
+		return p + sizeof(uint32_t);
+	case BT_UUID_TYPE_128:
+		if (end - p < sizeof(uuid->u128.val)) {
+			return NULL;
+		}
+		memcpy(uuid->u128.val, p, sizeof(uuid->u128.val));
+		return p + sizeof(uuid->u128.val);
+	default:
+		return NULL;
+	}
+}
+
+static uint8_t *cache_attr_encode(uint8_t *p, const struct bt_gatt_dm_attr *attr)
+{
+	const struct bt_gatt_service_val *service_val;
+	const struct bt_gatt_chrc *chrc_val;
+
+	sys_put_le16(attr->handle, p);
+	p += sizeof(uint16_t);
+	*p++ = attr->perm;
+	p = cache_uuid_encode(p, attr->uuid);
+
+	service_val = bt_gatt_dm_attr_service_val(attr);
+	if (service_val) {
+		p = cache_uuid_encode(p, service_val->uuid);
+		sys_put_le16(service_val->end_handle, p);
+		return p + sizeof(uint16_t);
+	}
+
+	chrc_val = bt_gatt_dm_attr_chrc_val(attr);
+	if (chrc_val) {
+		p = cache_uuid_encode(p, chrc_val->uuid);
+		sys_put_le16(chrc_val->value_handle, p);
+		p += sizeof(uint16_t);
+		*p++ = chrc_val->properties;
+	}
+
+	return p;
+}
+
+static const uint8_t *cache_attr_restore(struct bt_gatt_dm *dm,
+					 const uint8_t *p, const uint8_t *end)
+{
+	union cache_uuid uuid;
+	union cache_uuid val_uuid;
+	struct bt_gatt_attr attr = {
+		.uuid = &uuid.uuid,
+	};
+	struct bt_gatt_dm_attr *cur_attr;
+	struct bt_gatt_service_val *service_val;
+	struct bt_gatt_chrc *chrc_val;
+
+	if (end - p < sizeof(uint16_t) + 1) {
+		return NULL;
+	}
+
+	attr.handle = sys_get_le16(p);
+	p += sizeof(uint16_t);
+	attr.perm = *p++;
+	p = cache_uuid_decode(p, end, &uuid);
+	if (!p) {
+		return NULL;
+	}
+
+	if (!bt_uuid_cmp(&uuid.uuid, BT_UUID_GATT_PRIMARY) ||
+	    !bt_uuid_cmp(&uuid.uuid, BT_UUID_GATT_SECONDARY)) {
+		p = cache_uuid_decode(p, end, &val_uuid);
+		if (!p || end - p < sizeof(uint16_t)) {
+			return NULL;
+		}
+
+		cur_attr = attr_store(dm, &attr, sizeof(*service_val));
+		if (!cur_attr) {
+			return NULL;
+		}
+
+		service_val = bt_gatt_dm_attr_service_val(cur_attr);
+		service_val->end_handle = sys_get_le16(p);
+		service_val->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!service_val->uuid) {
+			return NULL;
+		}
+
+		return p + sizeof(uint16_t);
+	}
+
+	if (!bt_uuid_cmp(&uuid.uuid, BT_UUID_GATT_CHRC)) {
+		p = cache_uuid_decode(p, end, &val_uuid);
+		if (!p || end - p < sizeof(uint16_t) + 1) {
+			return NULL;
+		}
+
+		cur_attr = attr_store(dm, &attr, sizeof(*chrc_val));
+		if (!cur_attr) {
+			return NULL;
+		}
+
+		chrc_val = bt_gatt_dm_attr_chrc_val(cur_attr);
+		chrc_val->value_handle = sys_get_le16(p);
+		p += sizeof(uint16_t);
+		chrc_val->properties = *p++;
+		chrc_val->uuid = uuid_store(dm, &val_uuid.uuid);
+		if (!chrc_val->uuid) {
+			return NULL;
+		}
+
+		return p;
+	}
+
+	return attr_store(dm, &attr, 0) ? p : NULL;
+}
+
+/* Store the discovered service, or that no more instances were found */
+static void cache_store(struct bt_gatt_dm *dm, bool found)
+{
+	struct cache_hdr *hdr = (struct cache_hdr *)cache_buf;
+	uint8_t *p = &cache_buf[sizeof(*hdr)];
+	char key[CACHE_KEY_LEN];
+	int err;
+
+	if (!dm->cache.active || dm->cache.restored) {
+		return;
+	}
+
+	/* Discovery also ends without an attribute when the link is lost */
+	if (!bt_gatt_get_mtu(dm->conn)) {
+		return;
+	}
+
+	cache_svc_key(key, dm);
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	hdr->version = CACHE_VERSION;
+	hdr->attr_cnt = found ? dm->cur_attr_id : 0;
+	hdr->end_handle = sys_cpu_to_le16(dm->discover_params.end_handle);
+	memcpy(hdr->hash, dm->cache.hash, sizeof(hdr->hash));
+
+	for (size_t i = 0; i < hdr->attr_cnt; i++) {
+		p = cache_attr_encode(p, &dm->attrs[i]);
+	}
+
+	err = settings_save_one(key, cache_buf, p - cache_buf);
+
+	k_mutex_unlock(&cache_lock);
+
+	if (err) {
+		LOG_WRN("Cannot store discovery cache (err: %d)", err);
+	} else {
+		LOG_DBG("Discovery cache stored: %s", key);
+	}
+}
+
+static int cache_load_cb(const char *key, size_t len, settings_read_cb read_cb,
+			 void *cb_arg, void *param)
+{
+	struct cache_load_ctx *ctx = param;
+	ssize_t rc;
+
+	/* Only the exact key, not the entries below it */
+	if (key || len > sizeof(cache_buf)) {
+		return 0;
+	}
+
+	rc = read_cb(cb_arg, cache_buf, len);
+	ctx->len = (rc > 0) ? rc : 0;
+
+	return 0;
+}
+
+/* Restore the service from the cache, must be called with cache_lock taken */
+static int cache_load(struct bt_gatt_dm *dm, uint8_t *attr_cnt)
+{
+	const struct cache_hdr *hdr = (const struct cache_hdr *)cache_buf;
+	const uint8_t *p = &cache_buf[sizeof(*hdr)];
+	const uint8_t *end;
+	struct cache_load_ctx ctx = {0};
+	char key[CACHE_KEY_LEN];
+	int err;
+
+	cache_svc_key(key, dm);
+
+	err = settings_load_subtree_direct(key, cache_load_cb, &ctx);
+	if (err) {
+		return err;
+	}
+
+	if ((ctx.len < sizeof(*hdr)) ||
+	    (hdr->version != CACHE_VERSION) ||
+	    memcmp(hdr->hash, dm->cache.hash, sizeof(hdr->hash))) {
+		return -ENOENT;
+	}
+
+	end = &cache_buf[ctx.len];
+	for (size_t i = 0; i < hdr->attr_cnt; i++) {
+		p = cache_attr_restore(dm, p, end);
+		if (!p) {
+			LOG_WRN("Invalid discovery cache: %s", key);
+			return -EINVAL;
+		}
+	}
+
+	if ((p != end) ||
+	    (hdr->attr_cnt && !bt_gatt_dm_attr_service_val(&dm->attrs[0]))) {
+		LOG_WRN("Invalid discovery cache: %s", key);
+		return -EINVAL;
+	}
+
+	*attr_cnt = hdr->attr_cnt;
+	dm->discover_params.uuid = NULL;
+	dm->discover_params.end_handle = sys_le16_to_cpu(hdr->end_handle);
+
+	return 0;
+}
+#else
+static void cache_store(struct bt_gatt_dm *dm, bool found)
+{
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 static void discovery_complete(struct bt_gatt_dm *dm)
 {
 	LOG_DBG("Discovery complete.");
+	cache_store(dm, true);
 	atomic_set_bit(dm->state_flags, STATE_ATTRS_RELEASE_PENDING);
 	if (dm->callback->completed) {
 		dm->callback->completed(dm, dm->context);
@@ -284,6 +731,7 @@ static uint8_t discovery_process_service(struct bt_gatt_dm *dm,
 	int err;
 
 	if (!attr) {
+		cache_store(dm, false);
 		discovery_complete_not_found(dm);
 		return BT_GATT_ITER_STOP;
 	}
@@ -377,9 +825,6 @@ static uint8_t discovery_process_attribute(struct bt_gatt_dm *dm,
 
 	if (bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CHRC) == 0) {
 		cur_attr = attr_store(dm, attr, sizeof(struct bt_gatt_chrc));
-		struct bt_gatt_chrc *cur_gatt_chrc = bt_gatt_dm_attr_chrc_val(cur_attr);
-
-		cur_gatt_chrc->uuid = cur_attr->uuid;
 	} else {
 		cur_attr = attr_store(dm, attr, 0);
 	}
@@ -392,6 +837,12 @@ static uint8_t discovery_process_attribute(struct bt_gatt_dm *dm,
 		return BT_GATT_ITER_STOP;
 	}
 
+	if (bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CHRC) == 0) {
+		struct bt_gatt_chrc *cur_gatt_chrc = bt_gatt_dm_attr_chrc_val(cur_attr);
+
+		cur_gatt_chrc->uuid = cur_attr->uuid;
+	}
+
 	return BT_GATT_ITER_CONTINUE;
 }
 
@@ -402,6 +853,7 @@ static uint8_t discovery_process_characteristic(
 {
 	struct bt_gatt_chrc *gatt_chrc;
 	struct bt_gatt_dm_attr *cur_attr;
+	struct bt_gatt_dm_attr *value_attr;
 	struct bt_gatt_chrc *cur_gatt_chrc;
 
 	if (!attr) {
@@ -424,7 +876,14 @@ static uint8_t discovery_process_characteristic(
 	__ASSERT_NO_MSG(cur_gatt_chrc != NULL);
 
 	memcpy(cur_gatt_chrc, gatt_chrc, sizeof(*cur_gatt_chrc));
-	cur_gatt_chrc->uuid = uuid_store(dm, cur_gatt_chrc->uuid);
+
+	/* The value attribute was discovered with the same UUID, share it */
+	value_attr = attr_find_by_handle(dm, gatt_chrc->value_handle);
+	if (value_attr && !bt_uuid_cmp(value_attr->uuid, gatt_chrc->uuid)) {
+		cur_gatt_chrc->uuid = value_attr->uuid;
+	} else {
+		cur_gatt_chrc->uuid = uuid_store(dm, cur_gatt_chrc->uuid);
+	}
 	if (!cur_gatt_chrc->uuid) {
 		discovery_complete_error(dm, -ENOMEM);
 		return BT_GATT_ITER_STOP;
@@ -443,24 +902,23 @@ static uint8_t discovery_callback(struct bt_conn *conn,
 		LOG_DBG("Attr: handle %u", attr->handle);
 	}
 
-	if (conn != bt_gatt_dm_inst.conn) {
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     discover_params);
+
+	if (conn != dm->conn) {
 		LOG_ERR("Unexpected conn object. Aborting.");
-		discovery_complete_error(&bt_gatt_dm_inst, -EFAULT);
+		discovery_complete_error(dm, -EFAULT);
 		return BT_GATT_ITER_STOP;
 	}
 
 	switch (params->type) {
 	case BT_GATT_DISCOVER_PRIMARY:
 	case BT_GATT_DISCOVER_SECONDARY:
-		return discovery_process_service(&bt_gatt_dm_inst,
-						 attr, params);
+		return discovery_process_service(dm, attr, params);
 	case BT_GATT_DISCOVER_ATTRIBUTE:
-		return discovery_process_attribute(&bt_gatt_dm_inst,
-						   attr, params);
+		return discovery_process_attribute(dm, attr, params);
 	case BT_GATT_DISCOVER_CHARACTERISTIC:
-		return discovery_process_characteristic(&bt_gatt_dm_inst,
-							attr,
-							params);
+		return discovery_process_characteristic(dm, attr, params);
 	default:
 		/* This should not be possible */
 		__ASSERT(false, "Unknown param type.");
@@ -470,6 +928,208 @@ static uint8_t discovery_callback(struct bt_conn *conn,
 	return BT_GATT_ITER_STOP;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+static void cache_work_handler(struct k_work *work)
+{
+	struct bt_gatt_dm *dm = CONTAINER_OF(work, struct bt_gatt_dm,
+					     cache.work);
+	uint8_t attr_cnt;
+	int err = -ENOENT;
+
+	if (dm->cache.active) {
+		k_mutex_lock(&cache_lock, K_FOREVER);
+		err = cache_load(dm, &attr_cnt);
+		k_mutex_unlock(&cache_lock);
+	}
+
+	if (!err) {
+		LOG_DBG("Service restored from the cache");
+		dm->cache.restored = true;
+		if (attr_cnt) {
+			discovery_complete(dm);
+		} else {
+			discovery_complete_not_found(dm);
+		}
+		return;
+	}
+
+	/* Drop anything restored before an invalid record was detected */
+	svc_attr_memory_release(dm);
+
+	err = bt_gatt_discover(dm->conn, &dm->discover_params);
+	if (err) {
+		LOG_ERR("Discover failed, error: %d.", err);
+		discovery_complete_error(dm, err);
+	}
+}
+
+static uint8_t cache_hash_read(struct bt_conn *conn, uint8_t err,
+			       struct bt_gatt_read_params *params,
+			       const void *data, uint16_t length)
+{
+	struct bt_gatt_dm *dm = CONTAINER_OF(params, struct bt_gatt_dm,
+					     cache.read_params);
+
+	if (!dm->cache.hash_pending) {
+		return BT_GATT_ITER_STOP;
+	}
+	dm->cache.hash_pending = false;
+
+	if (!err && data && (length == sizeof(dm->cache.hash))) {
+		memcpy(dm->cache.hash, data, length);
+		dm->cache.active = true;
+	} else {
+		LOG_DBG("Database Hash not available (err: %u)", err);
+	}
+
+	k_work_submit(&dm->cache.work);
+
+	return BT_GATT_ITER_STOP;
+}
+
+/* Reads the Database Hash of a bonded peer, the discovery is then either
+ * restored from the cache or started in the cache_work_handler.
+ */
+static int cache_start(struct bt_gatt_dm *dm)
+{
+	struct bt_conn_info info;
+	int err;
+
+	dm->cache.active = false;
+	dm->cache.restored = false;
+	dm->cache.instance = 0;
+
+	err = bt_conn_get_info(dm->conn, &info);
+	if (err) {
+		return err;
+	}
+
+	if (!bt_addr_le_is_bonded(info.id, info.le.dst)) {
+		return -ENOENT;
+	}
+
+	dm->cache.id = info.id;
+	bt_addr_le_copy(&dm->cache.peer, info.le.dst);
+
+	dm->cache.read_params.func = cache_hash_read;
+	dm->cache.read_params.handle_count = 0;
+	dm->cache.read_params.by_uuid.start_handle = 0x0001;
+	dm->cache.read_params.by_uuid.end_handle = 0xffff;
+	dm->cache.read_params.by_uuid.uuid = &db_hash_uuid.uuid;
+	dm->cache.hash_pending = true;
+
+	err = bt_gatt_read(dm->conn, &dm->cache.read_params);
+	if (err) {
+		LOG_WRN("Database Hash read failed (err: %d)", err);
+		dm->cache.hash_pending = false;
+	}
+
+	return err;
+}
+
+static void cache_next(struct bt_gatt_dm *dm)
+{
+	dm->cache.restored = false;
+	if (dm->cache.instance < UINT8_MAX) {
+		dm->cache.instance++;
+	} else {
+		dm->cache.active = false;
+	}
+}
+
+static bool cache_submit(struct bt_gatt_dm *dm)
+{
+	if (!dm->cache.active) {
+		return false;
+	}
+
+	k_work_submit(&dm->cache.work);
+
+	return true;
+}
+
+static int cache_delete_cb(const char *key, size_t len,
+			   settings_read_cb read_cb, void *cb_arg, void *param)
+{
+	struct cache_delete_ctx *ctx = param;
+
+	if (key && len && (ctx->cnt < ARRAY_SIZE(ctx->keys))) {
+		snprintk(ctx->keys[ctx->cnt++], CACHE_KEY_LEN, "%s/%s",
+			 ctx->subtree, key);
+	}
+
+	return 0;
+}
+
+static void cache_bond_deleted(uint8_t id, const bt_addr_le_t *peer)
+{
+	char subtree[sizeof(CACHE_SUBTREE) + CACHE_PEER_KEY_LEN];
+	char peer_key[CACHE_PEER_KEY_LEN];
+	struct cache_delete_ctx ctx = {
+		.subtree = subtree,
+	};
+	int err;
+
+	cache_peer_key(peer_key, id, peer);
+	snprintk(subtree, sizeof(subtree), CACHE_SUBTREE "/%s", peer_key);
+
+	/* Keys are collected first, as settings must not be modified while
+	 * they are being loaded.
+	 */
+	do {
+		ctx.cnt = 0;
+		err = settings_load_subtree_direct(subtree, cache_delete_cb,
+						   &ctx);
+		if (err) {
+			LOG_WRN("Cannot load discovery cache (err: %d)", err);
+			return;
+		}
+
+		for (size_t i = 0; i < ctx.cnt; i++) {
+			err = settings_delete(ctx.keys[i]);
+			if (err) {
+				LOG_WRN("Cannot delete %s (err: %d)",
+					ctx.keys[i], err);
+				return;
+			}
+		}
+	} while (ctx.cnt == ARRAY_SIZE(ctx.keys));
+
+	LOG_DBG("Discovery cache deleted: %s", subtree);
+}
+
+static struct bt_conn_auth_info_cb cache_auth_info_cb = {
+	.bond_deleted = cache_bond_deleted,
+};
+
+static int cache_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	for (size_t i = 0; i < ARRAY_SIZE(bt_gatt_dm_inst); i++) {
+		k_work_init(&bt_gatt_dm_inst[i].cache.work, cache_work_handler);
+	}
+
+	return bt_conn_auth_info_cb_register(&cache_auth_info_cb);
+}
+
+SYS_INIT(cache_init, APPLICATION, CONFIG_APPLICATION_INIT_PRIORITY);
+#else
+static int cache_start(struct bt_gatt_dm *dm)
+{
+	return -ENOTSUP;
+}
+
+static void cache_next(struct bt_gatt_dm *dm)
+{
+}
+
+static bool cache_submit(struct bt_gatt_dm *dm)
+{
+	return false;
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 struct bt_gatt_service_val *bt_gatt_dm_attr_service_val(
 	const struct bt_gatt_dm_attr *attr)
 {
@@ -599,6 +1259,21 @@ const struct bt_gatt_dm_attr *bt_gatt_dm_desc_next(
 	return curr;
 }
 
+/* Returns a locked instance that is not used by another discovery */
+static struct bt_gatt_dm *instance_take(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(bt_gatt_dm_inst); i++) {
+		struct bt_gatt_dm *dm = &bt_gatt_dm_inst[i];
+
+		if (!atomic_test_and_set_bit(dm->state_flags,
+					     STATE_ATTRS_LOCKED)) {
+			return dm;
+		}
+	}
+
+	return NULL;
+}
+
 int bt_gatt_dm_start(struct bt_conn *conn,
 		     const struct bt_uuid *svc_uuid,
 		     const struct bt_gatt_dm_cb *cb,
@@ -617,9 +1292,8 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 		return -EINVAL;
 	}
 
-	dm = &bt_gatt_dm_inst;
-
-	if (atomic_test_and_set_bit(dm->state_flags, STATE_ATTRS_LOCKED)) {
+	dm = instance_take();
+	if (!dm) {
 		return -EALREADY;
 	}
 
@@ -627,8 +1301,6 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 	dm->context = context;
 	dm->callback = cb;
 	dm->cur_attr_id = 0;
-	sys_slist_init(&dm->chunk_list);
-	dm->cur_chunk_len = 0;
 	dm->search_svc_by_uuid = (svc_uuid != NULL);
 
 	if (svc_uuid) {
@@ -644,6 +1316,10 @@ int bt_gatt_dm_start(struct bt_conn *conn,
 	dm->discover_params.end_handle = 0xffff;
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 
+	if (!cache_start(dm)) {
+		return 0;
+	}
+
 	err = bt_gatt_discover(conn, &dm->discover_params);
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
@@ -675,6 +1351,8 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context)
 		return -EALREADY;
 	}
 
+	cache_next(dm);
+
 	if (dm->discover_params.end_handle == 0xffff) {
 		/* No more handles to discover. */
 		discovery_complete_not_found(dm);
@@ -687,6 +1365,10 @@ int bt_gatt_dm_continue(struct bt_gatt_dm *dm, void *context)
 	dm->discover_params.type = BT_GATT_DISCOVER_PRIMARY;
 	dm->discover_params.uuid = dm->search_svc_by_uuid ? &dm->svc_uuid.uuid : NULL;
 
+	if (cache_submit(dm)) {
+		return 0;
+	}
+
 	err = bt_gatt_discover(dm->conn, &dm->discover_params);
 	if (err) {
 		LOG_ERR("Discover failed, error: %d.", err);
@@ -710,6 +1392,100 @@ int bt_gatt_dm_data_release(struct bt_gatt_dm *dm)
 	return 0;
 }
 
+#if CONFIG_BT_GATT_DM_CACHE
+bool bt_gatt_dm_cache_restored(const struct bt_gatt_dm *dm)
+{
+	return dm->cache.restored;
+}
+
+int bt_gatt_dm_cache_ref_get(const struct bt_gatt_dm *dm,
+			     struct bt_gatt_dm_cache_ref *ref)
+{
+	if (!dm->cache.active || !dm->cur_attr_id) {
+		return -ENOENT;
+	}
+
+	ref->id = dm->cache.id;
+	bt_addr_le_copy(&ref->peer, &dm->cache.peer);
+	memcpy(ref->db_hash, dm->cache.hash, sizeof(ref->db_hash));
+	ref->svc_handle = dm->attrs[0].handle;
+
+	return 0;
+}
+
+int bt_gatt_dm_cache_data_store(const struct bt_gatt_dm_cache_ref *ref,
+				const void *data, size_t len)
+{
+	struct cache_data_hdr *hdr = (struct cache_data_hdr *)cache_buf;
+	char key[CACHE_KEY_LEN];
+	int err;
+
+	if (!ref || (!data && len)) {
+		return -EINVAL;
+	}
+
+	if (len > sizeof(cache_buf) - sizeof(*hdr)) {
+		return -ENOMEM;
+	}
+
+	cache_data_key(key, ref);
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	hdr->version = CACHE_VERSION;
+	memcpy(hdr->hash, ref->db_hash, sizeof(hdr->hash));
+	memcpy(&cache_buf[sizeof(*hdr)], data, len);
+	err = settings_save_one(key, cache_buf, sizeof(*hdr) + len);
+
+	k_mutex_unlock(&cache_lock);
+
+	return err;
+}
+
+ssize_t bt_gatt_dm_cache_data_load(const struct bt_gatt_dm_cache_ref *ref,
+				   void *data, size_t len)
+{
+	const struct cache_data_hdr *hdr =
+		(const struct cache_data_hdr *)cache_buf;
+	struct cache_load_ctx ctx = {0};
+	char key[CACHE_KEY_LEN];
+	ssize_t ret;
+
+	if (!ref || !data) {
+		return -EINVAL;
+	}
+
+	cache_data_key(key, ref);
+
+	k_mutex_lock(&cache_lock, K_FOREVER);
+
+	ret = settings_load_subtree_direct(key, cache_load_cb, &ctx);
+	if (ret) {
+		goto out;
+	}
+
+	if ((ctx.len < sizeof(*hdr)) ||
+	    (hdr->version != CACHE_VERSION) ||
+	    memcmp(hdr->hash, ref->db_hash, sizeof(hdr->hash))) {
+		ret = -ENOENT;
+		goto out;
+	}
+
+	ret = ctx.len - sizeof(*hdr);
+	if ((size_t)ret > len) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	memcpy(data, &cache_buf[sizeof(*hdr)], ret);
+
+out:
+	k_mutex_unlock(&cache_lock);
+
+	return ret;
+}
+#endif /* CONFIG_BT_GATT_DM_CACHE */
+
 #if CONFIG_BT_GATT_DM_DATA_PRINT
 
 #define UUID_STR_LEN 37
@@ -14,6 +14,23 @@ LOG_MODULE_REGISTER(nrf_bt_scan, CONFIG_BT_SCAN_LOG_LEVEL);
 
 #define BT_SCAN_UUID_128_SIZE 16
 
+/* Number of nodes in the prefix trie for the given filter count and
+ * filter length. Node 0 is the trie root.
+ */
+#define FILTER_TRIE_SIZE(_cnt, _len) ((_cnt) * (_len) + 1)
+
+/* Number of slots in the open addressing hash table for the given
+ * filter count. At most half of the slots are used.
+ */
+#define FILTER_HASH_SIZE(_cnt) (2 * (_cnt) + 1)
+
+BUILD_ASSERT(FILTER_TRIE_SIZE(CONFIG_BT_SCAN_NAME_CNT,
+			      CONFIG_BT_SCAN_NAME_MAX_LEN) <= UINT16_MAX);
+BUILD_ASSERT(FILTER_TRIE_SIZE(CONFIG_BT_SCAN_SHORT_NAME_CNT,
+			      CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN) <= UINT16_MAX);
+BUILD_ASSERT(FILTER_TRIE_SIZE(CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT,
+			      CONFIG_BT_SCAN_MANUFACTURER_DATA_MAX_LEN) <= UINT16_MAX);
+
 #define MODE_CHECK (BT_SCAN_NAME_FILTER | BT_SCAN_ADDR_FILTER | \
 	BT_SCAN_SHORT_NAME_FILTER | BT_SCAN_APPEARANCE_FILTER | \
 	BT_SCAN_UUID_FILTER | BT_SCAN_MANUFACTURER_DATA_FILTER)
@@ -37,6 +54,9 @@ struct bt_scan_control {
 	/* Indicates in which mode filters operate. */
 	bool all_mode;
 
+	/* Enabled advertising data filters that are not matched yet. */
+	uint8_t ad_pending;
+
 	/* Inform that device is connectable. */
 	bool connectable;
 
@@ -47,6 +67,29 @@ struct bt_scan_control {
 	struct bt_scan_filter_match filter_status;
 };
 
+/* Prefix trie node. The filter strings are compiled into a trie when
+ * they are added, so the advertising data is walked once instead of
+ * being compared against every filter. Node 0 is the root, so a zero
+ * link means no node. Filter indexes are stored incremented by one,
+ * so zero means no filter.
+ */
+struct filter_trie_node {
+	/* First child node. */
+	uint16_t child;
+
+	/* Next node with the same parent. */
+	uint16_t sibling;
+
+	/* Byte leading to this node. */
+	uint8_t label;
+
+	/* Lowest filter with a string passing through this node. */
+	uint8_t min_filter;
+
+	/* Filter with a string ending at this node. */
+	uint8_t end_filter;
+};
+
 /* Name filter structure.
  */
 struct bt_scan_name_filter {
@@ -55,6 +98,13 @@ struct bt_scan_name_filter {
 	 */
 	char target_name[CONFIG_BT_SCAN_NAME_CNT][CONFIG_BT_SCAN_NAME_MAX_LEN];
 
+	/* Prefix trie of the names. */
+	struct filter_trie_node trie[FILTER_TRIE_SIZE(CONFIG_BT_SCAN_NAME_CNT,
+						      CONFIG_BT_SCAN_NAME_MAX_LEN)];
+
+	/* Number of the trie nodes in use, excluding the root. */
+	uint16_t trie_cnt;
+
 	/* Name filter counter. */
 	uint8_t cnt;
 
@@ -76,6 +126,13 @@ struct bt_scan_short_name_filter {
 		uint8_t min_len;
 	} name[CONFIG_BT_SCAN_SHORT_NAME_CNT];
 
+	/* Prefix trie of the short names. */
+	struct filter_trie_node trie[FILTER_TRIE_SIZE(CONFIG_BT_SCAN_SHORT_NAME_CNT,
+						      CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN)];
+
+	/* Number of the trie nodes in use, excluding the root. */
+	uint16_t trie_cnt;
+
 	/* Short name filter counter. */
 	uint8_t cnt;
 
@@ -89,6 +146,9 @@ struct bt_scan_addr_filter {
 	/* Addresses advertised by the peripherals. */
 	bt_addr_le_t target_addr[CONFIG_BT_SCAN_ADDRESS_CNT];
 
+	/* Hash table of the address filter indexes incremented by one. */
+	uint8_t hash[FILTER_HASH_SIZE(CONFIG_BT_SCAN_ADDRESS_CNT)];
+
 	/* Address filter counter. */
 	uint8_t cnt;
 
@@ -110,6 +170,9 @@ struct bt_scan_uuid {
 		/* 128-bit UUID. */
 		struct bt_uuid_128 uuid_128;
 	} uuid_data;
+
+	/* Hash key, equal for all representations of the UUID. */
+	uint32_t key;
 };
 
 /* UUIDs filter structure.
@@ -120,6 +183,9 @@ struct bt_scan_uuid_filter {
 	 */
 	struct bt_scan_uuid uuid[CONFIG_BT_SCAN_UUID_CNT];
 
+	/* Hash table of the UUID filter indexes incremented by one. */
+	uint8_t hash[FILTER_HASH_SIZE(CONFIG_BT_SCAN_UUID_CNT)];
+
 	/* UUID filter counter. */
 	uint8_t cnt;
 
@@ -133,6 +199,9 @@ struct bt_scan_appearance_filter {
 	 */
 	uint16_t appearance[CONFIG_BT_SCAN_APPEARANCE_CNT];
 
+	/* Hash table of the appearance filter indexes incremented by one. */
+	uint8_t hash[FILTER_HASH_SIZE(CONFIG_BT_SCAN_APPEARANCE_CNT)];
+
 	/* Appearance filter counter. */
 	uint8_t cnt;
 
@@ -155,6 +224,13 @@ struct bt_scan_manufacturer_data_filter {
 		uint8_t data_len;
 	} manufacturer_data[CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT];
 
+	/* Prefix trie of the manufacturer data. */
+	struct filter_trie_node trie[FILTER_TRIE_SIZE(CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT,
+						      CONFIG_BT_SCAN_MANUFACTURER_DATA_MAX_LEN)];
+
+	/* Number of the trie nodes in use, excluding the root. */
+	uint16_t trie_cnt;
+
 	/* Name filter counter. */
 	uint8_t cnt;
 
@@ -501,16 +577,141 @@ static void scan_connect_with_target(struct bt_scan_control *control,
 	}
 }
 
+static uint16_t filter_trie_child(const struct filter_trie_node *trie,
+				  uint16_t node, uint8_t label)
+{
+	for (uint16_t child = trie[node].child; child;
+	     child = trie[child].sibling) {
+		if (trie[child].label == label) {
+			return child;
+		}
+	}
+
+	return 0;
+}
+
+static void filter_trie_add(struct filter_trie_node *trie, uint16_t *trie_cnt,
+			    const uint8_t *data, size_t len, uint8_t filter_idx)
+{
+	const uint8_t filter = filter_idx + 1;
+	uint16_t node = 0;
+
+	/* Filters are added in the index order, so the first filter
+	 * passing through a node is the lowest one.
+	 */
+	if (!trie[node].min_filter) {
+		trie[node].min_filter = filter;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		uint16_t child = filter_trie_child(trie, node, data[i]);
+
+		if (!child) {
+			child = ++(*trie_cnt);
+
+			trie[child].child = 0;
+			trie[child].sibling = trie[node].child;
+			trie[child].label = data[i];
+			trie[child].min_filter = filter;
+			trie[child].end_filter = 0;
+
+			/* Link the node only once it is complete. */
+			trie[node].child = child;
+		}
+
+		node = child;
+	}
+
+	if (!trie[node].end_filter) {
+		trie[node].end_filter = filter;
+	}
+}
+
+static void filter_trie_reset(struct filter_trie_node *trie, uint16_t *trie_cnt)
+{
+	memset(trie, 0, (*trie_cnt + 1) * sizeof(*trie));
+	*trie_cnt = 0;
+}
+
+/* Find the lowest filter whose name starts with the advertised name,
+ * which is what comparing the name with strncmp() matches.
+ */
+static uint8_t filter_trie_name_find(const struct filter_trie_node *trie,
+				     const uint8_t *data, uint8_t data_len)
+{
+	uint16_t node = 0;
+
+	for (size_t i = 0; i < data_len; i++) {
+		/* The comparison stops at the name terminator, so the
+		 * advertised name is only matched by a name ending here.
+		 */
+		if (data[i] == '\0') {
+			return trie[node].end_filter;
+		}
+
+		node = filter_trie_child(trie, node, data[i]);
+		if (!node) {
+			return 0;
+		}
+	}
+
+	return trie[node].min_filter;
+}
+
+/* Find the lowest filter whose data is a prefix of the advertised data. */
+static uint8_t filter_trie_prefix_find(const struct filter_trie_node *trie,
+				       const uint8_t *data, uint8_t data_len)
+{
+	uint8_t filter = 0;
+	uint16_t node = 0;
+
+	for (size_t i = 0; i < data_len; i++) {
+		node = filter_trie_child(trie, node, data[i]);
+		if (!node) {
+			break;
+		}
+
+		if (trie[node].end_filter &&
+		    (!filter || (trie[node].end_filter < filter))) {
+			filter = trie[node].end_filter;
+		}
+	}
+
+	return filter;
+}
+
+static void filter_hash_add(uint8_t *hash, size_t size, uint32_t key,
+			    uint8_t filter_idx)
+{
+	size_t i = key % size;
+
+	while (hash[i]) {
+		i = (i + 1) % size;
+	}
+
+	hash[i] = filter_idx + 1;
+}
+
+static uint32_t addr_hash_key(const bt_addr_le_t *addr)
+{
+	return sys_get_le32(addr->a.val) ^ sys_get_le16(&addr->a.val[4]) ^
+	       addr->type;
+}
+
 static bool adv_addr_compare(const bt_addr_le_t *target_addr,
 			     struct bt_scan_control *control)
 {
-	const bt_addr_le_t *addr =
-			bt_scan.scan_filters.addr.target_addr;
-	uint8_t counter = bt_scan.scan_filters.addr.cnt;
+	const struct bt_scan_addr_filter *addr_filter =
+			&bt_scan.scan_filters.addr;
+	const size_t size = ARRAY_SIZE(addr_filter->hash);
 
-	for (size_t i = 0; i < counter; i++) {
-		if (bt_addr_le_cmp(target_addr, &addr[i]) == 0) {
-			control->filter_status.addr.addr = &addr[i];
+	for (size_t i = addr_hash_key(target_addr) % size; addr_filter->hash[i];
+	     i = (i + 1) % size) {
+		const bt_addr_le_t *addr =
+			&addr_filter->target_addr[addr_filter->hash[i] - 1];
+
+		if (bt_addr_le_cmp(target_addr, addr) == 0) {
+			control->filter_status.addr.addr = addr;
 
 			return true;
 		}
@@ -559,6 +760,9 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 
 	/* Add target address to filter. */
 	bt_addr_le_copy(&addr_filter[counter], target_addr);
+	filter_hash_add(bt_scan.scan_filters.addr.hash,
+			ARRAY_SIZE(bt_scan.scan_filters.addr.hash),
+			addr_hash_key(target_addr), counter);
 
 	LOG_DBG("Filter set on address type %i",
 		addr_filter[counter].type);
@@ -573,36 +777,24 @@ static int scan_addr_filter_add(const bt_addr_le_t *target_addr)
 	return 0;
 }
 
-static bool adv_name_cmp(const uint8_t *data,
-			 uint8_t data_len,
-			 const char *target_name)
-{
-	return strncmp(target_name, data, data_len) == 0;
-}
-
 static bool adv_name_compare(const struct bt_data *data,
 			     struct bt_scan_control *control)
 {
 	struct bt_scan_name_filter const *name_filter =
 			&bt_scan.scan_filters.name;
-	uint8_t counter = bt_scan.scan_filters.name.cnt;
 	uint8_t data_len = data->data_len;
+	uint8_t filter;
 
 	/* Compare the name found with the name filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_name_cmp(data->data,
-				 data_len,
-				 name_filter->target_name[i])) {
-
-			control->filter_status.name.name =
-				name_filter->target_name[i];
-			control->filter_status.name.len = data_len;
-
-			return true;
-		}
+	filter = filter_trie_name_find(name_filter->trie, data->data, data_len);
+	if (!filter) {
+		return false;
 	}
 
-	return false;
+	control->filter_status.name.name = name_filter->target_name[filter - 1];
+	control->filter_status.name.len = data_len;
+
+	return true;
 }
 
 static inline bool is_name_filter_enabled(void)
@@ -613,13 +805,15 @@ static inline bool is_name_filter_enabled(void)
 static void name_check(struct bt_scan_control *control,
 		       const struct bt_data *data)
 {
-	if (is_name_filter_enabled()) {
+	/* Check the filter until the first match. */
+	if (control->ad_pending & BT_SCAN_NAME_FILTER) {
 		if (adv_name_compare(data, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.name.match = true;
 			control->filter_match = true;
+			control->ad_pending &= ~BT_SCAN_NAME_FILTER;
 		}
 	}
 }
@@ -651,6 +845,9 @@ static int scan_name_filter_add(const char *name)
 	/* Add name to filter. */
 	memcpy(bt_scan.scan_filters.name.target_name[counter],
 	       name, name_len);
+	filter_trie_add(bt_scan.scan_filters.name.trie,
+			&bt_scan.scan_filters.name.trie_cnt,
+			(const uint8_t *)name, name_len, counter);
 
 	bt_scan.scan_filters.name.cnt++;
 
@@ -679,23 +876,40 @@ static bool adv_short_name_compare(const struct bt_data *data,
 			&bt_scan.scan_filters.short_name;
 	uint8_t counter = bt_scan.scan_filters.short_name.cnt;
 	uint8_t data_len = data->data_len;
+	uint8_t filter;
 
 	/* Compare the name found with the name filters. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_short_name_cmp(data->data,
-				       data_len,
-				       name_filter->name[i].target_name,
-				       name_filter->name[i].min_len)) {
+	filter = filter_trie_name_find(name_filter->trie, data->data, data_len);
+	if (!filter) {
+		return false;
+	}
 
-			control->filter_status.short_name.name =
-				name_filter->name[i].target_name;
-			control->filter_status.short_name.len = data_len;
+	/* The lowest matching name is too long for the advertised name,
+	 * fall back to checking the minimum length of every name.
+	 */
+	if (data_len < name_filter->name[filter - 1].min_len) {
+		filter = 0;
+
+		for (size_t i = 0; i < counter; i++) {
+			if (adv_short_name_cmp(data->data,
+					       data_len,
+					       name_filter->name[i].target_name,
+					       name_filter->name[i].min_len)) {
+				filter = i + 1;
+				break;
+			}
+		}
 
-			return true;
+		if (!filter) {
+			return false;
 		}
 	}
 
-	return false;
+	control->filter_status.short_name.name =
+		name_filter->name[filter - 1].target_name;
+	control->filter_status.short_name.len = data_len;
+
+	return true;
 }
 
 static inline bool is_short_name_filter_enabled(void)
@@ -706,13 +920,15 @@ static inline bool is_short_name_filter_enabled(void)
 static void short_name_check(struct bt_scan_control *control,
 			     const struct bt_data *data)
 {
-	if (is_short_name_filter_enabled()) {
+	/* Check the filter until the first match. */
+	if (control->ad_pending & BT_SCAN_SHORT_NAME_FILTER) {
 		if (adv_short_name_compare(data, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.short_name.match = true;
 			control->filter_match = true;
+			control->ad_pending &= ~BT_SCAN_SHORT_NAME_FILTER;
 		}
 	}
 }
@@ -751,6 +967,8 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	memcpy(short_name_filter->name[counter].target_name,
 	       short_name->name,
 	       name_len);
+	filter_trie_add(short_name_filter->trie, &short_name_filter->trie_cnt,
+			(const uint8_t *)short_name->name, name_len, counter);
 
 	bt_scan.scan_filters.short_name.cnt++;
 
@@ -759,74 +977,101 @@ static int scan_short_name_filter_add(const struct bt_scan_short_name *short_nam
 	return 0;
 }
 
-static bool find_uuid(const uint8_t *data,
-		      uint8_t data_len,
-		      uint8_t uuid_type,
-		      const struct bt_scan_uuid *target_uuid)
-{
-	uint8_t uuid_len;
-
-	switch (uuid_type) {
-	case BT_UUID_TYPE_16:
-		uuid_len = sizeof(uint16_t);
-		break;
+/* Bluetooth Base UUID without the leading 32 bits, in little-endian. */
+static const uint8_t uuid_base[] = {
+	0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80, 0x00, 0x10, 0x00, 0x00
+};
 
-	case BT_UUID_TYPE_32:
-		uuid_len = sizeof(uint32_t);
-		break;
+/* UUIDs based on the Bluetooth Base UUID get the same key as their
+ * 16-bit or 32-bit form, as they are equal for bt_uuid_cmp().
+ */
+static uint32_t uuid_hash_key(const uint8_t *data, uint8_t uuid_len)
+{
+	switch (uuid_len) {
+	case sizeof(uint16_t):
+		return sys_get_le16(data);
 
-	case BT_UUID_TYPE_128:
-		uuid_len = BT_SCAN_UUID_128_SIZE * sizeof(uint8_t);
-		break;
+	case sizeof(uint32_t):
+		return sys_get_le32(data);
 
 	default:
-		return false;
+		if (memcmp(data, uuid_base, sizeof(uuid_base)) == 0) {
+			return sys_get_le32(&data[sizeof(uuid_base)]);
+		}
+
+		return sys_get_le32(&data[0]) ^ sys_get_le32(&data[4]) ^
+		       sys_get_le32(&data[8]) ^ sys_get_le32(&data[12]);
 	}
+}
 
-	for (size_t i = 0; i < data_len; i += uuid_len) {
+static uint8_t uuid_filter_find(const uint8_t *data, uint8_t uuid_len)
+{
+	const struct bt_scan_uuid_filter *uuid_filter =
+			&bt_scan.scan_filters.uuid;
+	const size_t size = ARRAY_SIZE(uuid_filter->hash);
+	const uint32_t key = uuid_hash_key(data, uuid_len);
+
+	for (size_t i = key % size; uuid_filter->hash[i]; i = (i + 1) % size) {
+		const struct bt_scan_uuid *target =
+			&uuid_filter->uuid[uuid_filter->hash[i] - 1];
 		struct bt_uuid_128 uuid;
 
-		if (!bt_uuid_create(&uuid.uuid, &data[i], uuid_len)) {
-			return false;
+		if (target->key != key) {
+			continue;
 		}
 
-		if (bt_uuid_cmp(&uuid.uuid, target_uuid->uuid) == 0) {
-			return true;
+		if (bt_uuid_create(&uuid.uuid, data, uuid_len) &&
+		    (bt_uuid_cmp(&uuid.uuid, target->uuid) == 0)) {
+			return uuid_filter->hash[i];
 		}
 	}
 
-	return false;
+	return 0;
 }
 
-static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_type,
+static bool adv_uuid_compare(const struct bt_data *data, uint8_t uuid_len,
 			     struct bt_scan_control *control)
 {
 	const struct bt_scan_uuid_filter *uuid_filter =
 			&bt_scan.scan_filters.uuid;
 	const bool all_filters_mode = bt_scan.scan_filters.all_mode;
 	const uint8_t counter = bt_scan.scan_filters.uuid.cnt;
-	uint8_t data_len = data->data_len;
+	bool found[CONFIG_BT_SCAN_UUID_CNT];
 	uint8_t uuid_match_cnt = 0;
+	uint8_t filter = 0;
 
-	for (size_t i = 0; i < counter; i++) {
+	memset(found, 0, sizeof(found));
 
-		if (find_uuid(data->data, data_len, uuid_type,
-			      &uuid_filter->uuid[i])) {
-			control->filter_status.uuid.uuid[uuid_match_cnt] =
-				uuid_filter->uuid[i].uuid;
+	for (size_t i = 0; (i + uuid_len) <= data->data_len; i += uuid_len) {
+		uint8_t match = uuid_filter_find(&data->data[i], uuid_len);
 
-			uuid_match_cnt++;
+		if (match) {
+			found[match - 1] = true;
 
-			/* In the normal filter mode,
-			 * only one UUID is needed to match.
-			 */
-			if (!all_filters_mode) {
-				break;
+			if (!filter || (match < filter)) {
+				filter = match;
 			}
+		}
+	}
 
-		} else if (all_filters_mode) {
-			break;
+	if (all_filters_mode) {
+		/* Report the filters found, in their order, until the
+		 * first one that is missing.
+		 */
+		while ((uuid_match_cnt < counter) && found[uuid_match_cnt]) {
+			control->filter_status.uuid.uuid[uuid_match_cnt] =
+				uuid_filter->uuid[uuid_match_cnt].uuid;
+
+			uuid_match_cnt++;
 		}
+	} else if (filter) {
+		/* In the normal filter mode,
+		 * only one UUID is needed to match.
+		 */
+		control->filter_status.uuid.uuid[0] =
+			uuid_filter->uuid[filter - 1].uuid;
+
+		uuid_match_cnt++;
 	}
 
 	control->filter_status.uuid.count = uuid_match_cnt;
@@ -849,15 +1094,17 @@ static bool is_uuid_filter_enabled(void)
 
 static void uuid_check(struct bt_scan_control *control,
 		       const struct bt_data *data,
-		       uint8_t type)
+		       uint8_t uuid_len)
 {
-	if (is_uuid_filter_enabled()) {
-		if (adv_uuid_compare(data, type, control)) {
+	/* Check the filter until the first match. */
+	if (control->ad_pending & BT_SCAN_UUID_FILTER) {
+		if (adv_uuid_compare(data, uuid_len, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.uuid.match = true;
 			control->filter_match = true;
+			control->ad_pending &= ~BT_SCAN_UUID_FILTER;
 		}
 	}
 }
@@ -890,6 +1137,7 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		uuid_filter[counter].uuid_data.uuid_16 = *uuid_16;
 		uuid_filter[counter].uuid =
 				(struct bt_uuid *)&uuid_filter[counter].uuid_data.uuid_16;
+		uuid_filter[counter].key = uuid_16->val;
 		break;
 
 	case BT_UUID_TYPE_32:
@@ -898,6 +1146,7 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		uuid_filter[counter].uuid_data.uuid_32 = *uuid_32;
 		uuid_filter[counter].uuid =
 				(struct bt_uuid *)&uuid_filter[counter].uuid_data.uuid_32;
+		uuid_filter[counter].key = uuid_32->val;
 		break;
 
 	case BT_UUID_TYPE_128:
@@ -906,55 +1155,48 @@ static int scan_uuid_filter_add(struct bt_uuid *uuid)
 		uuid_filter[counter].uuid_data.uuid_128 = *uuid_128;
 		uuid_filter[counter].uuid =
 				(struct bt_uuid *)&uuid_filter[counter].uuid_data.uuid_128;
+		uuid_filter[counter].key = uuid_hash_key(uuid_128->val,
+							 BT_SCAN_UUID_128_SIZE);
 		break;
 
 	default:
 		return -EINVAL;
 	}
 
+	filter_hash_add(bt_scan.scan_filters.uuid.hash,
+			ARRAY_SIZE(bt_scan.scan_filters.uuid.hash),
+			uuid_filter[counter].key, counter);
+
 	bt_scan.scan_filters.uuid.cnt++;
 	LOG_DBG("Added filter on UUID type %x", uuid->type);
 
 	return 0;
 }
 
-static bool find_appearance(const uint8_t *data,
-			    uint8_t data_len,
-			    const uint16_t *appearance)
-{
-	if (data_len != sizeof(uint16_t)) {
-		return false;
-	}
-
-	uint16_t decoded_appearance = sys_get_be16(data);
-
-	if (decoded_appearance == *appearance) {
-		return true;
-	}
-
-	/* Could not find the appearance among the encoded data. */
-	return false;
-}
-
 static bool adv_appearance_compare(const struct bt_data *data,
 				   struct bt_scan_control *control)
 {
 	const struct bt_scan_appearance_filter *appearance_filter =
 			&bt_scan.scan_filters.appearance;
-	const uint8_t counter =
-			bt_scan.scan_filters.appearance.cnt;
-	uint8_t data_len = data->data_len;
+	const size_t size = ARRAY_SIZE(appearance_filter->hash);
+	uint16_t decoded_appearance;
+
+	if (data->data_len != sizeof(uint16_t)) {
+		return false;
+	}
+
+	decoded_appearance = sys_get_be16(data->data);
 
 	/* Verify if the advertised appearance matches
 	 * the provided appearance.
 	 */
-	for (size_t i = 0; i < counter; i++) {
-		if (find_appearance(data->data,
-				    data_len,
-				    &appearance_filter->appearance[i])) {
+	for (size_t i = decoded_appearance % size; appearance_filter->hash[i];
+	     i = (i + 1) % size) {
+		const uint16_t *appearance =
+			&appearance_filter->appearance[appearance_filter->hash[i] - 1];
 
-			control->filter_status.appearance.appearance =
-					&appearance_filter->appearance[i];
+		if (*appearance == decoded_appearance) {
+			control->filter_status.appearance.appearance = appearance;
 
 			return true;
 		}
@@ -971,13 +1213,15 @@ static inline bool is_appearance_filter_enabled(void)
 static void appearance_check(struct bt_scan_control *control,
 			     const struct bt_data *data)
 {
-	if (is_appearance_filter_enabled()) {
+	/* Check the filter until the first match. */
+	if (control->ad_pending & BT_SCAN_APPEARANCE_FILTER) {
 		if (adv_appearance_compare(data, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.appearance.match = true;
 			control->filter_match = true;
+			control->ad_pending &= ~BT_SCAN_APPEARANCE_FILTER;
 		}
 	}
 }
@@ -1001,6 +1245,9 @@ static int scan_appearance_filter_add(uint16_t appearance)
 
 	/* Add appearance to the filter. */
 	appearance_filter[counter] = appearance;
+	filter_hash_add(bt_scan.scan_filters.appearance.hash,
+			ARRAY_SIZE(bt_scan.scan_filters.appearance.hash),
+			appearance, counter);
 	bt_scan.scan_filters.appearance.cnt++;
 
 	LOG_DBG("Added filter on appearance %x", appearance);
@@ -1029,26 +1276,23 @@ static bool adv_manufacturer_data_compare(const struct bt_data *data,
 {
 	const struct bt_scan_manufacturer_data_filter *md_filter =
 		&bt_scan.scan_filters.manufacturer_data;
-	uint8_t counter = bt_scan.scan_filters.manufacturer_data.cnt;
-
-	/* Compare the name found with the name filter. */
-	for (size_t i = 0; i < counter; i++) {
-		if (adv_manufacturer_data_cmp(data->data,
-				data->data_len,
-				md_filter->manufacturer_data[i].data,
-				md_filter->manufacturer_data[i].data_len)) {
-
-			control->filter_status.manufacturer_data.data =
-				md_filter->manufacturer_data[i].data;
-			control->filter_status.manufacturer_data.len =
-				md_filter->manufacturer_data[i].data_len;
+	uint8_t filter;
 
-			return true;
-		}
+	/* Compare the manufacturer data found with the filter. */
+	filter = filter_trie_prefix_find(md_filter->trie, data->data,
+					 data->data_len);
+	if (!filter) {
+		return false;
 	}
 
-	return false;
+	control->filter_status.manufacturer_data.data =
+		md_filter->manufacturer_data[filter - 1].data;
+	control->filter_status.manufacturer_data.len =
+		md_filter->manufacturer_data[filter - 1].data_len;
+
+	return true;
 }
+
 static inline bool is_manufacturer_data_filter_enabled(void)
 {
 	return CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT &&
@@ -1058,13 +1302,15 @@ static inline bool is_manufacturer_data_filter_enabled(void)
 static void manufacturer_data_check(struct bt_scan_control *control,
 				    const struct bt_data *data)
 {
-	if (is_manufacturer_data_filter_enabled()) {
+	/* Check the filter until the first match. */
+	if (control->ad_pending & BT_SCAN_MANUFACTURER_DATA_FILTER) {
 		if (adv_manufacturer_data_compare(data, control)) {
 			control->filter_match_cnt++;
 
 			/* Information about the filters matched. */
 			control->filter_status.manufacturer_data.match = true;
 			control->filter_match = true;
+			control->ad_pending &= ~BT_SCAN_MANUFACTURER_DATA_FILTER;
 		}
 	}
 }
@@ -1102,6 +1348,9 @@ static int scan_manufacturer_data_filter_add(const struct bt_scan_manufacturer_d
 			manufacturer_data->data, manufacturer_data->data_len);
 	md_filter->manufacturer_data[counter].data_len =
 		manufacturer_data->data_len;
+	filter_trie_add(md_filter->trie, &md_filter->trie_cnt,
+			manufacturer_data->data, manufacturer_data->data_len,
+			counter);
 
 	bt_scan.scan_filters.manufacturer_data.cnt++;
 
@@ -1237,6 +1486,19 @@ void bt_scan_filter_remove_all(void)
 		&bt_scan.scan_filters.manufacturer_data;
 	manufacturer_data_filter->cnt = 0;
 
+	/* Clear the compiled filters and the stored strings, as new
+	 * strings are copied without the terminator.
+	 */
+	memset(name_filter->target_name, 0, sizeof(name_filter->target_name));
+	filter_trie_reset(name_filter->trie, &name_filter->trie_cnt);
+	memset(short_name_filter->name, 0, sizeof(short_name_filter->name));
+	filter_trie_reset(short_name_filter->trie, &short_name_filter->trie_cnt);
+	memset(addr_filter->hash, 0, sizeof(addr_filter->hash));
+	memset(uuid_filter->hash, 0, sizeof(uuid_filter->hash));
+	memset(appearance_filter->hash, 0, sizeof(appearance_filter->hash));
+	filter_trie_reset(manufacturer_data_filter->trie,
+			  &manufacturer_data_filter->trie_cnt);
+
 	k_mutex_unlock(&scan_mutex);
 }
 
@@ -1372,6 +1634,7 @@ void bt_scan_update_init_conn_params(struct bt_le_conn_param *new_conn_param)
 static void check_enabled_filters(struct bt_scan_control *control)
 {
 	control->filter_cnt = 0;
+	control->ad_pending = 0;
 
 	if (is_addr_filter_enabled()) {
 		control->filter_cnt++;
@@ -1379,30 +1642,33 @@ static void check_enabled_filters(struct bt_scan_control *control)
 
 	if (is_name_filter_enabled()) {
 		control->filter_cnt++;
+		control->ad_pending |= BT_SCAN_NAME_FILTER;
 	}
 
 	if (is_short_name_filter_enabled()) {
 		control->filter_cnt++;
+		control->ad_pending |= BT_SCAN_SHORT_NAME_FILTER;
 	}
 
 	if (is_uuid_filter_enabled()) {
 		control->filter_cnt++;
+		control->ad_pending |= BT_SCAN_UUID_FILTER;
 	}
 
 	if (is_appearance_filter_enabled()) {
 		control->filter_cnt++;
+		control->ad_pending |= BT_SCAN_APPEARANCE_FILTER;
 	}
 
 	if (is_manufacturer_data_filter_enabled()) {
 		control->filter_cnt++;
+		control->ad_pending |= BT_SCAN_MANUFACTURER_DATA_FILTER;
 	}
 }
 
-static bool adv_data_found(struct bt_data *data, void *user_data)
+static void adv_data_found(const struct bt_data *data,
+			   struct bt_scan_control *scan_control)
 {
-	struct bt_scan_control *scan_control =
-			(struct bt_scan_control *)user_data;
-
 	switch (data->type) {
 	case BT_DATA_NAME_COMPLETE:
 		/* Check the name filter. */
@@ -1422,18 +1688,18 @@ static bool adv_data_found(struct bt_data *data, void *user_data)
 	case BT_DATA_UUID16_SOME:
 	case BT_DATA_UUID16_ALL:
 		/* Check the UUID filter. */
-		uuid_check(scan_control, data, BT_UUID_TYPE_16);
+		uuid_check(scan_control, data, sizeof(uint16_t));
 		break;
 
 	case BT_DATA_UUID32_SOME:
 	case BT_DATA_UUID32_ALL:
-		uuid_check(scan_control, data, BT_UUID_TYPE_32);
+		uuid_check(scan_control, data, sizeof(uint32_t));
 		break;
 
 	case BT_DATA_UUID128_SOME:
 	case BT_DATA_UUID128_ALL:
 		/* Check the UUID filter. */
-		uuid_check(scan_control, data, BT_UUID_TYPE_128);
+		uuid_check(scan_control, data, BT_SCAN_UUID_128_SIZE);
 		break;
 
 	case BT_DATA_MANUFACTURER_DATA:
@@ -1444,8 +1710,41 @@ static bool adv_data_found(struct bt_data *data, void *user_data)
 	default:
 		break;
 	}
+}
 
-	return true;
+/* Walk the advertising data once, in the same way as bt_data_parse(),
+ * without changing the buffer. The walk stops as soon as every enabled
+ * advertising data filter is matched.
+ */
+static void adv_data_parse(struct bt_scan_control *control,
+			   const struct net_buf_simple *ad)
+{
+	const uint8_t *data = ad->data;
+	size_t len = ad->len;
+
+	while ((len > 1) && control->ad_pending) {
+		struct bt_data field;
+		uint8_t field_len = data[0];
+
+		/* Early termination. */
+		if (field_len == 0) {
+			return;
+		}
+
+		if (field_len > (len - 1)) {
+			LOG_WRN("Malformed advertising data");
+			return;
+		}
+
+		field.type = data[1];
+		field.data_len = field_len - 1;
+		field.data = &data[2];
+
+		adv_data_found(&field, control);
+
+		data += field_len + 1;
+		len -= field_len + 1;
+	}
 }
 
 static void filter_state_check(struct bt_scan_control *control,
@@ -1481,7 +1780,6 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 		      struct net_buf_simple *ad)
 {
 	struct bt_scan_control scan_control;
-	struct net_buf_simple_state state;
 
 	memset(&scan_control, 0, sizeof(scan_control));
 
@@ -1496,12 +1794,13 @@ static void scan_recv(const struct bt_le_scan_recv_info *info,
 	/* Check the address filter. */
 	check_addr(&scan_control, info->addr);
 
-	/* Save advertising buffer state to transfer it
-	 * data to application if futher processing is needed.
+	/* In the multifilter mode, a device with a filtered out address
+	 * cannot match, so its advertising data is not checked.
 	 */
-	net_buf_simple_save(ad, &state);
-	bt_data_parse(ad, adv_data_found, (void *)&scan_control);
-	net_buf_simple_restore(ad, &state);
+	if (!scan_control.all_mode || !is_addr_filter_enabled() ||
+	    scan_control.filter_status.addr.match) {
+		adv_data_parse(&scan_control, ad);
+	}
 
 	scan_control.device_info.recv_info = info;
 	scan_control.device_info.conn_param = &bt_scan.conn_param;
@@ -34,14 +34,24 @@ size_t fp_crypto_account_key_filter_size(size_t n)
 	}
 }
 
+static void account_key_filter_bits_set(uint8_t *out, size_t s, const uint8_t *h)
+{
+	uint32_t x;
+	uint32_t m;
+
+	for (size_t j = 0; j < FP_CRYPTO_SHA256_HASH_LEN / sizeof(x); j++) {
+		x = sys_get_be32(&h[j * sizeof(x)]);
+		m = x % (s * __CHAR_BIT__);
+		WRITE_BIT(out[m / __CHAR_BIT__], m % __CHAR_BIT__, 1);
+	}
+}
+
 int fp_crypto_account_key_filter(uint8_t *out, const struct fp_account_key *account_key_list,
 				 size_t n, uint8_t salt)
 {
 	size_t s = fp_crypto_account_key_filter_size(n);
 	uint8_t v[FP_ACCOUNT_KEY_LEN + sizeof(salt)];
 	uint8_t h[FP_CRYPTO_SHA256_HASH_LEN];
-	uint32_t x;
-	uint32_t m;
 
 	memset(out, 0, s);
 	for (size_t i = 0; i < n; i++) {
@@ -52,11 +62,26 @@ int fp_crypto_account_key_filter(uint8_t *out, const struct fp_account_key *acco
 		if (err) {
 			return err;
 		}
-		for (size_t j = 0; j < FP_CRYPTO_SHA256_HASH_LEN / sizeof(x); j++) {
-			x = sys_get_be32(&h[j * sizeof(x)]);
-			m = x % (s * __CHAR_BIT__);
-			WRITE_BIT(out[m / __CHAR_BIT__], m % __CHAR_BIT__, 1);
+		account_key_filter_bits_set(out, s, h);
+	}
+	return 0;
+}
+
+int fp_crypto_account_key_filter_from_hash(uint8_t *out,
+					   const struct fp_crypto_account_key_hash *hash_list,
+					   size_t n, uint8_t salt)
+{
+	size_t s = fp_crypto_account_key_filter_size(n);
+	uint8_t h[FP_CRYPTO_SHA256_HASH_LEN];
+
+	memset(out, 0, s);
+	for (size_t i = 0; i < n; i++) {
+		int err = fp_crypto_account_key_hash_finish(h, &hash_list[i], salt);
+
+		if (err) {
+			return err;
 		}
+		account_key_filter_bits_set(out, s, h);
 	}
 	return 0;
 }
@@ -121,6 +121,100 @@ int fp_crypto_aes128_decrypt(uint8_t *out, const uint8_t *in, const uint8_t *k)
 	return aes128_ecb_crypt(out, in, k, false);
 }
 
+int fp_crypto_aes128_decrypt_key_set(struct fp_crypto_aes128_key *key, const uint8_t *k)
+{
+	int ret;
+
+	mbedtls_aes_init(&key->ctx);
+
+	ret = mbedtls_aes_setkey_dec(&key->ctx, k, AES128_ECB_KEY_BIT_LEN);
+	if (ret) {
+		LOG_ERR("aes128_key: mbedtls_aes_setkey_dec failed: %d", ret);
+		mbedtls_aes_free(&key->ctx);
+	}
+
+	return ret;
+}
+
+int fp_crypto_aes128_key_decrypt(struct fp_crypto_aes128_key *key, uint8_t *out,
+				 const uint8_t *in)
+{
+	int ret;
+
+	ret = mbedtls_aes_crypt_ecb(&key->ctx, MBEDTLS_AES_DECRYPT, in, out);
+	if (ret) {
+		LOG_ERR("aes128_key: mbedtls_aes_crypt_ecb failed: %d", ret);
+	}
+
+	return ret;
+}
+
+void fp_crypto_aes128_key_free(struct fp_crypto_aes128_key *key)
+{
+	mbedtls_aes_free(&key->ctx);
+}
+
+int fp_crypto_account_key_hash_init(struct fp_crypto_account_key_hash *hash,
+				    const struct fp_account_key *account_key)
+{
+	int ret;
+	const int is_sha224 = 0;
+
+	mbedtls_sha256_init(&hash->ctx);
+
+	ret = mbedtls_sha256_starts(&hash->ctx, is_sha224);
+	if (ret) {
+		LOG_ERR("account_key_hash: mbedtls_sha256_starts failed: %d", ret);
+		goto error;
+	}
+
+	ret = mbedtls_sha256_update(&hash->ctx, account_key->key, FP_ACCOUNT_KEY_LEN);
+	if (ret) {
+		LOG_ERR("account_key_hash: mbedtls_sha256_update failed: %d", ret);
+		goto error;
+	}
+
+	return 0;
+
+error:
+	mbedtls_sha256_free(&hash->ctx);
+
+	return ret;
+}
+
+int fp_crypto_account_key_hash_finish(uint8_t *out, const struct fp_crypto_account_key_hash *hash,
+				      uint8_t salt)
+{
+	int ret;
+	mbedtls_sha256_context sha256_context;
+
+	mbedtls_sha256_init(&sha256_context);
+	mbedtls_sha256_clone(&sha256_context, &hash->ctx);
+
+	ret = mbedtls_sha256_update(&sha256_context, &salt, sizeof(salt));
+	if (ret) {
+		LOG_ERR("account_key_hash: mbedtls_sha256_update failed: %d", ret);
+		goto cleanup;
+	}
+
+	ret = mbedtls_sha256_finish(&sha256_context, out);
+	if (ret) {
+		LOG_ERR("account_key_hash: mbedtls_sha256_finish failed: %d", ret);
+		goto cleanup;
+	}
+
+cleanup:
+	/* Free the SHA256 context. */
+	mbedtls_sha256_free(&sha256_context);
+
+	return ret;
+}
+
+void fp_crypto_account_key_hash_free(struct fp_crypto_account_key_hash *hash)
+{
+	mbedtls_sha256_free(&hash->ctx);
+}
+
 int fp_crypto_ecdh_shared_secret(uint8_t *secret_key,
 				 const uint8_t *public_key,
 				 const uint8_t *private_key)
@@ -5,6 +5,7 @@
  */
 
 #include <errno.h>
+#include <string.h>
 #include <tinycrypt/constants.h>
 #include <tinycrypt/sha256.h>
 #include <tinycrypt/aes.h>
@@ -53,6 +54,61 @@ int fp_crypto_aes128_decrypt(uint8_t *out, const uint8_t *in, const uint8_t *k)
 	return 0;
 }
 
+int fp_crypto_aes128_decrypt_key_set(struct fp_crypto_aes128_key *key, const uint8_t *k)
+{
+	if (tc_aes128_set_decrypt_key(&key->sched, k) != TC_CRYPTO_SUCCESS) {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+int fp_crypto_aes128_key_decrypt(struct fp_crypto_aes128_key *key, uint8_t *out,
+				 const uint8_t *in)
+{
+	if (tc_aes_decrypt(out, in, &key->sched) != TC_CRYPTO_SUCCESS) {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+void fp_crypto_aes128_key_free(struct fp_crypto_aes128_key *key)
+{
+	memset(key, 0, sizeof(*key));
+}
+
+int fp_crypto_account_key_hash_init(struct fp_crypto_account_key_hash *hash,
+				    const struct fp_account_key *account_key)
+{
+	if (tc_sha256_init(&hash->state) != TC_CRYPTO_SUCCESS) {
+		return -EINVAL;
+	}
+	if (tc_sha256_update(&hash->state, account_key->key, FP_ACCOUNT_KEY_LEN) !=
+	    TC_CRYPTO_SUCCESS) {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+int fp_crypto_account_key_hash_finish(uint8_t *out, const struct fp_crypto_account_key_hash *hash,
+				      uint8_t salt)
+{
+	/* Tinycrypt state holds no pointers, so a copy is a clone. */
+	struct tc_sha256_state_struct s = hash->state;
+
+	if (tc_sha256_update(&s, &salt, sizeof(salt)) != TC_CRYPTO_SUCCESS) {
+		return -EINVAL;
+	}
+	if (tc_sha256_final(out, &s) != TC_CRYPTO_SUCCESS) {
+		return -EINVAL;
+	}
+	return 0;
+}
+
+void fp_crypto_account_key_hash_free(struct fp_crypto_account_key_hash *hash)
+{
+	memset(hash, 0, sizeof(*hash));
+}
+
 int fp_crypto_ecdh_shared_secret(uint8_t *secret_key, const uint8_t *public_key,
 				 const uint8_t *private_key)
 {
@@ -5,6 +5,8 @@
  */
 
 #include <errno.h>
+#include <string.h>
+#include <zephyr/kernel.h>
 #include <zephyr/net/buf.h>
 #include <zephyr/random/rand32.h>
 #include <zephyr/bluetooth/bluetooth.h>
@@ -30,6 +32,50 @@ static const uint16_t fast_pair_uuid = FP_SERVICE_UUID;
 static const uint8_t flags;
 static const uint8_t empty_account_key_list;
 
+static struct fp_account_key ak_hash_keys[CONFIG_BT_FAST_PAIR_STORAGE_ACCOUNT_KEY_MAX];
+static struct fp_crypto_account_key_hash ak_hashes[CONFIG_BT_FAST_PAIR_STORAGE_ACCOUNT_KEY_MAX];
+static bool ak_hash_valid[CONFIG_BT_FAST_PAIR_STORAGE_ACCOUNT_KEY_MAX];
+static K_MUTEX_DEFINE(ak_hash_lock);
+
+static int account_key_filter_cached(uint8_t *out, const struct fp_account_key *ak, size_t n,
+				     uint8_t salt)
+{
+	int err = 0;
+
+	k_mutex_lock(&ak_hash_lock, K_FOREVER);
+
+	/* A new Account Key overwrites a single storage slot, so only the hash state of that
+	 * slot is computed again.
+	 */
+	for (size_t i = 0; i < n; i++) {
+		if (ak_hash_valid[i] &&
+		    !memcmp(ak_hash_keys[i].key, ak[i].key, FP_ACCOUNT_KEY_LEN)) {
+			continue;
+		}
+
+		if (ak_hash_valid[i]) {
+			fp_crypto_account_key_hash_free(&ak_hashes[i]);
+			ak_hash_valid[i] = false;
+		}
+
+		err = fp_crypto_account_key_hash_init(&ak_hashes[i], &ak[i]);
+		if (err) {
+			break;
+		}
+
+		ak_hash_keys[i] = ak[i];
+		ak_hash_valid[i] = true;
+	}
+
+	if (!err) {
+		err = fp_crypto_account_key_filter_from_hash(out, ak_hashes, n, salt);
+	}
+
+	k_mutex_unlock(&ak_hash_lock);
+
+	return err;
+}
+
 static size_t bt_fast_pair_adv_data_size_non_discoverable(size_t account_key_cnt)
 {
 	size_t res = 0;
@@ -113,8 +159,13 @@ static int fp_adv_data_fill_non_discoverable(struct net_buf_simple *buf, size_t
 		__ASSERT_NO_MSG(ak_filter_size <= BIT_MASK(LEN_BITS));
 		net_buf_simple_add_u8(buf, ENCODE_FIELD_LEN_TYPE(ak_filter_size, ak_filter_type));
 
-		err = fp_crypto_account_key_filter(net_buf_simple_add(buf, ak_filter_size), ak,
-						   account_key_cnt, salt);
+		if (IS_ENABLED(CONFIG_BT_FAST_PAIR_KEY_CACHE)) {
+			err = account_key_filter_cached(net_buf_simple_add(buf, ak_filter_size), ak,
+							account_key_cnt, salt);
+		} else {
+			err = fp_crypto_account_key_filter(net_buf_simple_add(buf, ak_filter_size),
+							   ak, account_key_cnt, salt);
+		}
 		if (err) {
 			return err;
 		}
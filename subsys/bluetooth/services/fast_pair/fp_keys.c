@@ -43,9 +43,18 @@ struct fp_key_gen_account_key_check_context {
 	struct fp_keys_keygen_params *keygen_params;
 };
 
+struct fp_account_key_aes {
+	struct fp_account_key account_key;
+	struct fp_crypto_aes128_key aes_key;
+	bool valid;
+};
+
 static bool user_pairing_mode = true;
 static struct fp_procedure fp_procedures[CONFIG_BT_MAX_CONN];
 
+static struct fp_account_key_aes account_key_aes_cache[CONFIG_BT_FAST_PAIR_STORAGE_ACCOUNT_KEY_MAX];
+static uint8_t account_key_aes_cache_next;
+
 
 void bt_fast_pair_set_pairing_mode(bool pairing_mode)
 {
@@ -161,6 +170,41 @@ static int key_gen_public_key(const struct bt_conn *conn,
 	return err;
 }
 
+static struct fp_crypto_aes128_key *account_key_aes_get(const struct fp_account_key *account_key)
+{
+	struct fp_account_key_aes *entry;
+
+	for (size_t i = 0; i < ARRAY_SIZE(account_key_aes_cache); i++) {
+		entry = &account_key_aes_cache[i];
+
+		if (entry->valid &&
+		    !memcmp(entry->account_key.key, account_key->key, FP_ACCOUNT_KEY_LEN)) {
+			return &entry->aes_key;
+		}
+	}
+
+	/* The cache holds as many entries as the storage holds Account Keys, so a replaced
+	 * entry belongs to an Account Key that was overwritten in the storage.
+	 */
+	entry = &account_key_aes_cache[account_key_aes_cache_next];
+	account_key_aes_cache_next = (account_key_aes_cache_next + 1) %
+				     ARRAY_SIZE(account_key_aes_cache);
+
+	if (entry->valid) {
+		fp_crypto_aes128_key_free(&entry->aes_key);
+		entry->valid = false;
+	}
+
+	if (fp_crypto_aes128_decrypt_key_set(&entry->aes_key, account_key->key)) {
+		return NULL;
+	}
+
+	entry->account_key = *account_key;
+	entry->valid = true;
+
+	return &entry->aes_key;
+}
+
 static bool key_gen_account_key_check(const struct fp_account_key *account_key, void *context)
 {
 	int err;
@@ -172,7 +216,17 @@ static bool key_gen_account_key_check(const struct fp_account_key *account_key,
 
 	memcpy(proc->aes_key, account_key->key, FP_ACCOUNT_KEY_LEN);
 
-	err = fp_keys_decrypt(conn, req, keygen_params->req_enc);
+	if (IS_ENABLED(CONFIG_BT_FAST_PAIR_KEY_CACHE)) {
+		struct fp_crypto_aes128_key *aes_key = account_key_aes_get(account_key);
+
+		if (aes_key) {
+			err = fp_crypto_aes128_key_decrypt(aes_key, req, keygen_params->req_enc);
+		} else {
+			err = -EINVAL;
+		}
+	} else {
+		err = fp_keys_decrypt(conn, req, keygen_params->req_enc);
+	}
 	if (err) {
 		return false;
 	}
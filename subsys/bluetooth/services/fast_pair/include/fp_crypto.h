@@ -9,6 +9,14 @@
 
 #include "fp_common.h"
 
+#if defined(CONFIG_BT_FAST_PAIR_CRYPTO_MBEDTLS)
+#include <mbedtls/aes.h>
+#include <mbedtls/sha256.h>
+#elif defined(CONFIG_BT_FAST_PAIR_CRYPTO_TINYCRYPT)
+#include <tinycrypt/aes.h>
+#include <tinycrypt/sha256.h>
+#endif
+
 /**
  * @defgroup fp_crypto Fast Pair crypto
  * @brief Internal API for Fast Pair crypto
@@ -29,6 +37,28 @@ extern "C" {
 /** Length of ECDH shared key (256 bits = 32 bytes). */
 #define FP_CRYPTO_ECDH_SHARED_KEY_LEN	32U
 
+/** @brief Expanded AES-128 decryption key. */
+struct fp_crypto_aes128_key {
+#if defined(CONFIG_BT_FAST_PAIR_CRYPTO_MBEDTLS)
+	/** MbedTLS AES context. */
+	mbedtls_aes_context ctx;
+#elif defined(CONFIG_BT_FAST_PAIR_CRYPTO_TINYCRYPT)
+	/** Tinycrypt AES key schedule. */
+	struct tc_aes_key_sched_struct sched;
+#endif
+};
+
+/** @brief SHA-256 state after hashing an Account Key, without the salt. */
+struct fp_crypto_account_key_hash {
+#if defined(CONFIG_BT_FAST_PAIR_CRYPTO_MBEDTLS)
+	/** MbedTLS SHA-256 context. */
+	mbedtls_sha256_context ctx;
+#elif defined(CONFIG_BT_FAST_PAIR_CRYPTO_TINYCRYPT)
+	/** Tinycrypt SHA-256 state. */
+	struct tc_sha256_state_struct state;
+#endif
+};
+
 /** Hash value using SHA-256.
  *
  * @param[out] out 256-bit (32-byte) buffer to receive hashed result.
@@ -59,6 +89,35 @@ int fp_crypto_aes128_encrypt(uint8_t *out, const uint8_t *in, const uint8_t *k);
  */
 int fp_crypto_aes128_decrypt(uint8_t *out, const uint8_t *in, const uint8_t *k);
 
+/** Expand an AES-128 key for decryption.
+ *
+ * The expanded key is used to decrypt several messages without expanding the key again.
+ * It must be released with @ref fp_crypto_aes128_key_free.
+ *
+ * @param[out] key Expanded key.
+ * @param[in] k 128-bit (16-byte) AES key.
+ *
+ * @return 0 If the operation was successful. Otherwise, a (negative) error code is returned.
+ */
+int fp_crypto_aes128_decrypt_key_set(struct fp_crypto_aes128_key *key, const uint8_t *k);
+
+/** Decrypt message using an expanded AES-128 key.
+ *
+ * @param[in] key Key expanded with @ref fp_crypto_aes128_decrypt_key_set.
+ * @param[out] out 128-bit (16-byte) buffer to receive plaintext message.
+ * @param[in] in 128-bit (16-byte) ciphertext message.
+ *
+ * @return 0 If the operation was successful. Otherwise, a (negative) error code is returned.
+ */
+int fp_crypto_aes128_key_decrypt(struct fp_crypto_aes128_key *key, uint8_t *out,
+				 const uint8_t *in);
+
+/** Release an expanded AES-128 key.
+ *
+ * @param[in] key Expanded key.
+ */
+void fp_crypto_aes128_key_free(struct fp_crypto_aes128_key *key);
+
 /** Compute a shared secret key using Elliptic-Curve Diffie-Hellman algorithm.
  *
  * Keys are assumed to be secp256r1 elliptic curve keys.
@@ -103,6 +162,56 @@ size_t fp_crypto_account_key_filter_size(size_t n);
 int fp_crypto_account_key_filter(uint8_t *out, const struct fp_account_key *account_key_list,
 				 size_t n, uint8_t salt);
 
+/** Hash an Account Key for the Account Key Filter.
+ *
+ * The filter hashes every Account Key followed by the salt. The hash state after the
+ * Account Key is kept, so that a filter with a new salt only hashes the salt. The state
+ * must be released with @ref fp_crypto_account_key_hash_free.
+ *
+ * @param[out] hash Hash state.
+ * @param[in] account_key Account Key.
+ *
+ * @return 0 If the operation was successful. Otherwise, a (negative) error code is returned.
+ */
+int fp_crypto_account_key_hash_init(struct fp_crypto_account_key_hash *hash,
+				    const struct fp_account_key *account_key);
+
+/** Finish the hash of an Account Key with the salt.
+ *
+ * The hash state is not modified.
+ *
+ * @param[out] out 256-bit (32-byte) buffer to receive hashed result.
+ * @param[in] hash Hash state from @ref fp_crypto_account_key_hash_init.
+ * @param[in] salt Random byte - Salt.
+ *
+ * @return 0 If the operation was successful. Otherwise, a (negative) error code is returned.
+ */
+int fp_crypto_account_key_hash_finish(uint8_t *out, const struct fp_crypto_account_key_hash *hash,
+				      uint8_t salt);
+
+/** Release the hash state of an Account Key.
+ *
+ * @param[in] hash Hash state.
+ */
+void fp_crypto_account_key_hash_free(struct fp_crypto_account_key_hash *hash);
+
+/** Compute an Account Key Filter from the hash states of the Account Keys.
+ *
+ * The result is the same as from @ref fp_crypto_account_key_filter.
+ *
+ * @param[out] out Buffer to receive Account Key Filter. Buffer size must be at least
+ *                 @ref fp_crypto_account_key_filter_size.
+ * @param[in] hash_list Pointer to array of hash states from
+ *			@ref fp_crypto_account_key_hash_init.
+ * @param[in] n Number of account keys (n >= 1).
+ * @param[in] salt Random byte - Salt.
+ *
+ * @return 0 If the operation was successful. Otherwise, a (negative) error code is returned.
+ */
+int fp_crypto_account_key_filter_from_hash(uint8_t *out,
+					   const struct fp_crypto_account_key_hash *hash_list,
+					   size_t n, uint8_t salt);
+
 #ifdef __cplusplus
 }
 #endif
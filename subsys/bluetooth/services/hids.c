@@ -52,6 +52,37 @@
 
 LOG_MODULE_REGISTER(bt_hids, CONFIG_BT_HIDS_LOG_LEVEL);
 
+BUILD_ASSERT(CONFIG_BT_HIDS_INPUT_REP_MAX <=
+	     8 * sizeof(((struct bt_hids_conn_data *)0)->inp_rep_own),
+	     "Input Report ownership bitmask too small");
+
+static uint8_t *inp_rep_value_get(struct bt_hids *hids_obj,
+				  struct bt_hids_conn_data *conn_data,
+				  struct bt_hids_inp_rep *hids_inp_rep)
+{
+	if (conn_data->inp_rep_own & BIT(hids_inp_rep->idx)) {
+		return conn_data->inp_rep_ctx + hids_inp_rep->offset;
+	}
+
+	return hids_obj->inp_rep_shared + hids_inp_rep->offset;
+}
+
+static uint8_t *inp_rep_value_own(struct bt_hids *hids_obj,
+				  struct bt_hids_conn_data *conn_data,
+				  struct bt_hids_inp_rep *hids_inp_rep)
+{
+	uint8_t *rep_data = conn_data->inp_rep_ctx + hids_inp_rep->offset;
+
+	if (!(conn_data->inp_rep_own & BIT(hids_inp_rep->idx))) {
+		memcpy(rep_data,
+		       hids_obj->inp_rep_shared + hids_inp_rep->offset,
+		       hids_inp_rep->size);
+		conn_data->inp_rep_own |= BIT(hids_inp_rep->idx);
+	}
+
+	return rep_data;
+}
+
 int bt_hids_connected(struct bt_hids *hids_obj, struct bt_conn *conn)
 {
 	__ASSERT_NO_MSG(conn != NULL);
@@ -70,6 +101,11 @@ int bt_hids_connected(struct bt_hids *hids_obj, struct bt_conn *conn)
 
 	conn_data->pm_ctx_value = BT_HIDS_PM_REPORT;
 
+	/* A new connection has not received any Input Report yet, so it does
+	 * not follow the shared values.
+	 */
+	conn_data->inp_rep_own = BIT_MASK(CONFIG_BT_HIDS_INPUT_REP_MAX);
+
 	/* Assign input report context. */
 	conn_data->inp_rep_ctx =
 		(uint8_t *)conn_data + sizeof(struct bt_hids_conn_data);
@@ -226,7 +262,7 @@ static ssize_t hids_inp_rep_read(struct bt_conn *conn,
 		return BT_GATT_ERR(BT_ATT_ERR_INSUFFICIENT_RESOURCES);
 	}
 
-	rep_data = conn_data->inp_rep_ctx + rep->offset;
+	rep_data = inp_rep_value_get(hids, conn_data, rep);
 
 	ret_len = bt_gatt_attr_read(conn, attr, buf, len, offset, rep_data,
 				    rep->size);
@@ -871,6 +907,21 @@ int bt_hids_init(struct bt_hids *hids_obj,
 {
 	LOG_DBG("Initializing HIDS.");
 
+	size_t inp_rep_size = 0;
+	size_t cnt = MIN(init_param->inp_rep_group_init.cnt,
+			 ARRAY_SIZE(init_param->inp_rep_group_init.reports));
+
+	for (size_t i = 0; i < cnt; i++) {
+		inp_rep_size += init_param->inp_rep_group_init.reports[i].size;
+	}
+
+	if (inp_rep_size > hids_obj->inp_rep_shared_size) {
+		LOG_ERR("No memory for the shared Input Report values");
+		return -ENOMEM;
+	}
+
+	memset(hids_obj->inp_rep_shared, 0, inp_rep_size);
+
 	hids_obj->pm.evt_handler = init_param->pm_evt_handler;
 	hids_obj->cp.evt_handler = init_param->cp_evt_handler;
 
@@ -998,7 +1049,10 @@ int bt_hids_uninit(struct bt_hids *hids_obj)
 	}
 
 	struct bt_gatt_attr *attr_start = hids_obj->gp.svc.attrs;
+	size_t attr_array_size = hids_obj->gp.attr_array_size;
 	struct bt_conn_ctx_lib *conn_ctx = hids_obj->conn_ctx;
+	uint8_t *inp_rep_shared = hids_obj->inp_rep_shared;
+	size_t inp_rep_shared_size = hids_obj->inp_rep_shared_size;
 
 	/* Free the whole GATT pool */
 	bt_gatt_pool_free(&hids_obj->gp);
@@ -1009,7 +1063,10 @@ int bt_hids_uninit(struct bt_hids *hids_obj)
 	/* Reset HIDS instance. */
 	memset(hids_obj, 0, sizeof(*hids_obj));
 	hids_obj->gp.svc.attrs = attr_start;
+	hids_obj->gp.attr_array_size = attr_array_size;
 	hids_obj->conn_ctx = conn_ctx;
+	hids_obj->inp_rep_shared = inp_rep_shared;
+	hids_obj->inp_rep_shared_size = inp_rep_shared_size;
 
 	return 0;
 }
@@ -1032,53 +1089,120 @@ static void store_input_report(struct bt_hids_inp_rep *hids_inp_rep,
 	}
 }
 
-static int inp_rep_notify_all(struct bt_hids *hids_obj,
-			      struct bt_hids_inp_rep *hids_inp_rep,
-			      uint8_t const *rep, uint8_t len,
-			      bt_gatt_complete_func_t cb)
+static bool conn_listed(struct bt_conn *conn, struct bt_conn *const *conns,
+			size_t conn_cnt)
 {
-	struct bt_hids_conn_data *conn_data;
-	uint8_t *rep_data = NULL;
+	if (!conns) {
+		return true;
+	}
+
+	for (size_t i = 0; i < conn_cnt; i++) {
+		if (conns[i] == conn) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static int inp_rep_notify_group(struct bt_hids *hids_obj,
+				struct bt_hids_inp_rep *hids_inp_rep,
+				struct bt_conn *const *conns, size_t conn_cnt,
+				uint8_t const *rep, uint8_t len,
+				bt_gatt_complete_func_t cb)
+{
+	struct bt_conn_ctx_lib *ctx_lib = hids_obj->conn_ctx;
 	struct bt_gatt_attr *rep_attr =
 		&hids_obj->gp.svc.attrs[hids_inp_rep->att_ind];
+	const size_t contexts = bt_conn_ctx_count(ctx_lib);
+	struct bt_conn *receivers[ARRAY_SIZE(ctx_lib->ctx)];
+	uint8_t receiver_ids[ARRAY_SIZE(ctx_lib->ctx)];
+	size_t receiver_cnt = 0;
+	int err = 0;
+
+	/* The shared values are guarded by the mutex of the connection
+	 * context library, which serializes every access to the connection
+	 * contexts. Hold it for the whole update so that a concurrent read
+	 * never observes a half-updated state.
+	 */
+	k_mutex_lock(ctx_lib->mutex, K_FOREVER);
 
-	const size_t contexts =
-	    bt_conn_ctx_count(hids_obj->conn_ctx);
-
+	/* Connections that do not receive the report keep their current value
+	 * before the shared value is overwritten.
+	 */
 	for (size_t i = 0; i < contexts; i++) {
 		const struct bt_conn_ctx *ctx =
-			bt_conn_ctx_get_by_id(hids_obj->conn_ctx, i);
+			bt_conn_ctx_get_by_id(ctx_lib, i);
 
-		if (ctx) {
-			bool notification_enabled = bt_gatt_is_subscribed(
-				ctx->conn, rep_attr, BT_GATT_CCC_NOTIFY);
+		if (!ctx) {
+			continue;
+		}
 
-			if (notification_enabled) {
-				conn_data = ctx->data;
-				rep_data = conn_data->inp_rep_ctx +
-					   hids_inp_rep->offset;
+		if (conn_listed(ctx->conn, conns, conn_cnt) &&
+		    bt_gatt_is_subscribed(ctx->conn, rep_attr,
+					  BT_GATT_CCC_NOTIFY)) {
+			receivers[receiver_cnt] = ctx->conn;
+			receiver_ids[receiver_cnt] = i;
+			receiver_cnt++;
+		} else {
+			inp_rep_value_own(hids_obj, ctx->data, hids_inp_rep);
+		}
 
-				store_input_report(hids_inp_rep, rep_data, rep,
-						   len);
-			}
+		bt_conn_ctx_release(ctx_lib, (void *)ctx->data);
+	}
 
-			bt_conn_ctx_release(hids_obj->conn_ctx,
-					    (void *)ctx->data);
+	if (receiver_cnt == 0) {
+		k_mutex_unlock(ctx_lib->mutex);
+		return -ENODATA;
+	}
+
+	/* Store the report once for all receivers. Receivers drop their own
+	 * copy and follow the shared value, unless the report is masked and
+	 * the merged value of the receiver may differ from the shared one.
+	 */
+	store_input_report(hids_inp_rep,
+			   hids_obj->inp_rep_shared + hids_inp_rep->offset,
+			   rep, len);
+
+	for (size_t i = 0; i < receiver_cnt; i++) {
+		const struct bt_conn_ctx *ctx =
+			bt_conn_ctx_get_by_id(ctx_lib, receiver_ids[i]);
+		struct bt_hids_conn_data *conn_data = ctx->data;
+
+		if (!hids_inp_rep->rep_mask) {
+			conn_data->inp_rep_own &= ~BIT(hids_inp_rep->idx);
+		} else if (conn_data->inp_rep_own & BIT(hids_inp_rep->idx)) {
+			store_input_report(hids_inp_rep,
+					   conn_data->inp_rep_ctx +
+					   hids_inp_rep->offset,
+					   rep, len);
 		}
+
+		bt_conn_ctx_release(ctx_lib, (void *)ctx->data);
 	}
 
-	if (rep_data != NULL) {
-		struct bt_gatt_notify_params params = {0};
+	k_mutex_unlock(ctx_lib->mutex);
 
-		params.attr = rep_attr;
-		params.data = rep;
-		params.len = hids_inp_rep->size;
-		params.func = cb;
+	struct bt_gatt_notify_params params = {0};
 
+	params.attr = rep_attr;
+	params.data = rep;
+	params.len = hids_inp_rep->size;
+	params.func = cb;
+
+	if (!conns) {
 		return bt_gatt_notify_cb(NULL, &params);
-	} else {
-		return -ENODATA;
 	}
+
+	for (size_t i = 0; i < receiver_cnt; i++) {
+		int ret = bt_gatt_notify_cb(receivers[i], &params);
+
+		if (ret && !err) {
+			err = ret;
+		}
+	}
+
+	return err;
 }
 
 int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
@@ -1097,7 +1221,8 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 	}
 
 	if (!conn) {
-		return inp_rep_notify_all(hids_obj, hids_inp_rep, rep, len, cb);
+		return inp_rep_notify_group(hids_obj, hids_inp_rep, NULL, 0,
+					    rep, len, cb);
 	}
 
 	if (!bt_gatt_is_subscribed(conn, rep_attr, BT_GATT_CCC_NOTIFY)) {
@@ -1112,7 +1237,7 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 		return -EINVAL;
 	}
 
-	rep_data = conn_data->inp_rep_ctx + hids_inp_rep->offset;
+	rep_data = inp_rep_value_own(hids_obj, conn_data, hids_inp_rep);
 
 	store_input_report(hids_inp_rep, rep_data, rep, len);
 
@@ -1130,6 +1255,29 @@ int bt_hids_inp_rep_send(struct bt_hids *hids_obj,
 	return err;
 }
 
+int bt_hids_inp_rep_send_conns(struct bt_hids *hids_obj,
+			       struct bt_conn *const *conns, size_t conn_cnt,
+			       uint8_t rep_index, uint8_t const *rep,
+			       uint8_t len, bt_gatt_complete_func_t cb)
+{
+	__ASSERT_NO_MSG(hids_obj != NULL);
+	__ASSERT_NO_MSG((conns != NULL) || (conn_cnt == 0));
+
+	struct bt_hids_inp_rep *hids_inp_rep =
+	    &hids_obj->inp_rep_group.reports[rep_index];
+
+	if (hids_inp_rep->size != len) {
+		return -EINVAL;
+	}
+
+	if (conn_cnt == 0) {
+		return -ENODATA;
+	}
+
+	return inp_rep_notify_group(hids_obj, hids_inp_rep, conns, conn_cnt,
+				    rep, len, cb);
+}
+
 static int boot_mouse_inp_report_notify_all(
 	struct bt_hids *hids_obj, const uint8_t *buttons,
 	struct bt_hids_boot_mouse_inp_rep *boot_mouse_inp_rep,
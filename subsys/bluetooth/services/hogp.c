@@ -273,6 +273,87 @@ static void hids_prep_error(struct bt_hogp *hogp, int err)
 	}
 }
 
+#if CONFIG_BT_HOGP_CACHE
+/* HID Information followed by the Report IDs in the report array order */
+#define INFO_CACHE_LEN(_rep_cnt) (4 + (_rep_cnt))
+
+/**
+ * @brief Store HID information and report identifiers
+ *
+ * The data is stored with the discovery cache of the HID service,
+ * if the peer supports caching.
+ *
+ * @param hogp HOGP object.
+ */
+static void info_cache_store(struct bt_hogp *hogp)
+{
+	uint8_t buf[INFO_CACHE_LEN(CONFIG_BT_HOGP_REPORTS_MAX)];
+	int err;
+
+	if (!hogp->cache_ref_valid ||
+	    (hogp->rep_count > CONFIG_BT_HOGP_REPORTS_MAX)) {
+		return;
+	}
+
+	sys_put_le16(hogp->info_val.bcd_hid, &buf[0]);
+	buf[2] = hogp->info_val.b_country_code;
+	buf[3] = hogp->info_val.flags;
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		buf[INFO_CACHE_LEN(i)] = hogp->rep_info[i]->ref.id;
+	}
+
+	err = bt_gatt_dm_cache_data_store(&hogp->cache_ref, buf,
+					  INFO_CACHE_LEN(hogp->rep_count));
+	if (err) {
+		LOG_WRN("Cannot store HID information (err: %d)", err);
+	}
+}
+
+/**
+ * @brief Restore HID information and report identifiers
+ *
+ * @param hogp HOGP object.
+ *
+ * @return 0 or negative error code if the data is not cached.
+ */
+static int info_cache_load(struct bt_hogp *hogp)
+{
+	uint8_t buf[INFO_CACHE_LEN(CONFIG_BT_HOGP_REPORTS_MAX)];
+	ssize_t len;
+
+	if (!hogp->cache_ref_valid) {
+		return -ENOENT;
+	}
+
+	len = bt_gatt_dm_cache_data_load(&hogp->cache_ref, buf, sizeof(buf));
+	if (len != INFO_CACHE_LEN(hogp->rep_count)) {
+		return -ENOENT;
+	}
+
+	hogp->info_val.bcd_hid = sys_get_le16(&buf[0]);
+	hogp->info_val.b_country_code = buf[2];
+	hogp->info_val.flags = buf[3];
+	for (size_t i = 0; i < hogp->rep_count; i++) {
+		hogp->rep_info[i]->ref.id = buf[INFO_CACHE_LEN(i)];
+	}
+
+	/* Nothing new to store */
+	hogp->cache_ref_valid = false;
+	LOG_DBG("HID information restored from the cache");
+
+	return 0;
+}
+#else
+static void info_cache_store(struct bt_hogp *hogp)
+{
+}
+
+static int info_cache_load(struct bt_hogp *hogp)
+{
+	return -ENOTSUP;
+}
+#endif /* CONFIG_BT_HOGP_CACHE */
+
 /**
  * @brief Process protocol mode read
  *
@@ -388,6 +469,7 @@ static int repref_read_start(struct bt_hogp *hogp, size_t rep_idx)
 
 	__ASSERT_NO_MSG(hogp);
 	if (rep_idx >= hogp->rep_count) {
+		info_cache_store(hogp);
 		err = pm_read_start(hogp);
 		if (err) {
 			LOG_ERR("Cannot start boot protocol read (err: %d)",
@@ -530,7 +612,8 @@ static uint8_t hid_info_read_process(struct bt_conn *conn, uint8_t err,
 	LOG_DBG("  bCountryCode: 0x%x", hogp->info_val.b_country_code);
 	LOG_DBG("  Flags: 0x%x", hogp->info_val.flags);
 
-	err = repref_read_start(hogp, 0);
+	/* Report references that were restored from the cache are skipped */
+	err = repref_read_start(hogp, hogp->init_repref.rep_idx);
 	if (err) {
 		hids_prep_error(hogp, err);
 	}
@@ -559,7 +642,20 @@ static int post_discovery_start(struct bt_hogp *hogp)
 		return err;
 	}
 
-	err = hid_info_read_start(hogp);
+	hogp->init_repref.rep_idx = 0;
+	if (!info_cache_load(hogp)) {
+		hogp->init_repref.rep_idx = hogp->rep_count;
+		/* One read is still done, so that the ready callback
+		 * is not called from bt_hogp_handles_assign.
+		 */
+		if (hogp->handlers.pm) {
+			err = pm_read_start(hogp);
+		} else {
+			err = hid_info_read_start(hogp);
+		}
+	} else {
+		err = hid_info_read_start(hogp);
+	}
 	if (err) {
 		k_sem_give(&hogp->read_params_sem);
 		return err;
@@ -750,6 +846,9 @@ static int handles_assign_internal(struct bt_gatt_dm *dm,
 
 	/* Finally - save connection object */
 	hogp->conn = bt_gatt_dm_conn_get(dm);
+#if CONFIG_BT_HOGP_CACHE
+	hogp->cache_ref_valid = !bt_gatt_dm_cache_ref_get(dm, &hogp->cache_ref);
+#endif
 
 	return post_discovery_start(hogp);
 }
@@ -9,6 +9,7 @@
 #include <pm_config.h>
 #include <fw_info.h>
 #include <fprotect.h>
+#include <bl_storage.h>
 #include <hal/nrf_clock.h>
 #ifdef CONFIG_UART_NRFX
 #ifdef CONFIG_UART_0_NRF_UART
@@ -41,9 +42,7 @@ extern uint32_t _vector_table_pointer;
 
 void bl_boot(const struct fw_info *fw_info)
 {
-#if !(defined(CONFIG_SOC_NRF9160) \
-      || defined(CONFIG_SOC_NRF5340_CPUNET) \
-      || defined(CONFIG_SOC_NRF5340_CPUAPP))
+#if BL_STORAGE_PROTECTED
 	/* Protect bootloader storage data after firmware is validated so
 	 * invalidation of public keys can be written into the page if needed.
 	 * Note that for some devices (for example, nRF9160 and the nRF5340
@@ -51,7 +51,18 @@ struct counter_collection {
 	struct monotonic_counter counters[1];
 };
 
+/** The third data structure in the provision page. It is optional and has
+ *  unknown length since 'records' is repeated. It is placed immediately after
+ *  the last slot of the last counter in struct counter_collection.
+ */
+struct validation_record_collection {
+	uint16_t type; /* Must be "validation record collection". */
+	uint16_t num_records; /* Number of entries in 'records' list. */
+	struct bl_validation_record records[1];
+};
+
 #define TYPE_COUNTERS 1 /* Type referring to counter collection. */
+#define TYPE_VALIDATION_RECORDS 2 /* Type referring to validation record collection. */
 #define COUNTER_DESC_VERSION 1 /* Counter description value for firmware version. */
 
 static const struct bl_storage_data *p_bl_storage_data =
@@ -332,3 +343,112 @@ int set_monotonic_counter(uint16_t new_counter)
 	write_halfword(next_counter_addr, ~new_counter);
 	return 0;
 }
+
+
+/** Function for reading a word from OTP. */
+static uint32_t read_word(const uint32_t *ptr)
+{
+	uint32_t val32 = *ptr;
+
+	__DSB(); /* Because of nRF9160 Erratum 7 */
+	return val32;
+}
+
+
+/** Get the validation_record_collection data structure in the provision data. */
+static const struct validation_record_collection *get_validation_record_collection(void)
+{
+	const struct counter_collection *counters = get_counter_collection();
+
+	if (counters == NULL) {
+		return NULL;
+	}
+
+	const struct monotonic_counter *current = counters->counters;
+
+	for (size_t i = 0; i < read_halfword(&counters->num_counters); i++) {
+		uint16_t num_slots = read_halfword(&current->num_counter_slots);
+
+		current = (const struct monotonic_counter *)
+					&current->counter_slots[num_slots];
+	}
+
+	const struct validation_record_collection *collection =
+		(const struct validation_record_collection *)current;
+
+	return read_halfword(&collection->type) == TYPE_VALIDATION_RECORDS
+		? collection : NULL;
+}
+
+
+uint16_t num_validation_record_slots(void)
+{
+	const struct validation_record_collection *collection =
+			get_validation_record_collection();
+	uint16_t num_records = 0;
+
+	if (collection != NULL) {
+		num_records = read_halfword(&collection->num_records);
+	}
+	return num_records != 0xFFFF ? num_records : 0;
+}
+
+
+int validation_record_read(uint32_t idx, struct bl_validation_record *record)
+{
+	if (idx >= num_validation_record_slots()) {
+		return -EFAULT;
+	}
+
+	const uint32_t *src = (const uint32_t *)
+		&get_validation_record_collection()->records[idx];
+	uint32_t *dst = (uint32_t *)record;
+
+	BUILD_ASSERT(sizeof(struct bl_validation_record) % 4 == 0);
+	BUILD_ASSERT(offsetof(struct validation_record_collection, records) % 4 == 0);
+
+	for (size_t i = 0; i < (sizeof(*record) / 4); i++) {
+		dst[i] = read_word(&src[i]);
+	}
+
+	if (record->address == 0xFFFFFFFF) {
+		return -ENOENT;
+	}
+
+	if (record->valid != BL_VALIDATION_RECORD_VALID) {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+
+int validation_record_write(const struct bl_validation_record *record)
+{
+	const uint16_t num_records = num_validation_record_slots();
+
+	for (uint32_t i = 0; i < num_records; i++) {
+		const struct bl_validation_record *slot =
+			&get_validation_record_collection()->records[i];
+
+		/* The address is written first, so a slot with any data written
+		 * to it has the address set.
+		 */
+		if (read_word(&slot->address) != 0xFFFFFFFF) {
+			continue;
+		}
+
+		const uint32_t *src = (const uint32_t *)record;
+		uint32_t dst = (uint32_t)slot;
+
+		for (size_t j = 0; j < (offsetof(struct bl_validation_record, valid) / 4); j++) {
+			nrfx_nvmc_word_write(dst + (j * 4), src[j]);
+		}
+
+		nrfx_nvmc_word_write((uint32_t)&slot->valid, BL_VALIDATION_RECORD_VALID);
+		return 0;
+	}
+
+	/* No more room. */
+	return -ENOMEM;
+}
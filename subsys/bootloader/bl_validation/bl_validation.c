@@ -146,7 +146,7 @@ validation_info_find(uint32_t start_address, uint32_t search_distance)
 #ifdef CONFIG_SB_VALIDATE_FW_SIGNATURE
 static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_size,
 			       const struct fw_validation_info *fw_val_info,
-			       bool external)
+			       bool external, uint32_t *key_idx_out)
 {
 	int init_retval = bl_crypto_init();
 
@@ -204,6 +204,9 @@ static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_
 				invalidate_public_key(i);
 			}
 			PRINT("Firmware signature verified.\n\r");
+			if (key_idx_out != NULL) {
+				*key_idx_out = key_data_idx;
+			}
 			return true;
 		} else if (retval == -EHASHINV) {
 			PRINT("Public key didn't match, try next.\n\r");
@@ -219,6 +222,90 @@ static bool validate_signature(const uint32_t fw_src_address, const uint32_t fw_
 	return false;
 }
 
+#ifdef CONFIG_SB_VALIDATION_RECORD
+static bool validation_record_find(const struct bl_validation_record *fw_record)
+{
+	struct bl_validation_record record;
+	/* Some key data storage backends require word sized reads, hence
+	 * we need to ensure word alignment for 'key_data'
+	 */
+	__aligned(4) uint8_t key_data[CONFIG_SB_PUBLIC_KEY_HASH_LEN];
+
+	for (uint32_t i = 0; i < num_validation_record_slots(); i++) {
+		if (validation_record_read(i, &record) != 0) {
+			continue;
+		}
+
+		if (!validation_record_trusted(&record, fw_record, BL_STORAGE_PROTECTED)) {
+			continue;
+		}
+
+		/* Firmware verified with a revoked key must not boot anymore. */
+		if (public_key_data_read(record.key_idx, key_data,
+					 sizeof(key_data)) == sizeof(key_data)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Skip the signature verification if the firmware matches a record written
+ * when its signature was verified on a previous boot.
+ */
+static bool validate_signature_recorded(const uint32_t fw_address,
+					const struct fw_info *fwinfo,
+					const struct fw_validation_info *fw_val_info)
+{
+	const bool external = false;
+	struct bl_validation_record fw_record = {
+		.address = fw_address,
+		.version = fwinfo->version,
+	};
+	bl_sha256_ctx_t ctx;
+	int retval = bl_crypto_init();
+
+	if (retval) {
+		PRINT("bl_crypto_init() returned %d.\n\r", retval);
+		return false;
+	}
+
+	BUILD_ASSERT(CONFIG_SB_HASH_LEN == BL_VALIDATION_RECORD_HASH_LEN);
+
+	retval = bl_sha256_init(&ctx);
+	if (!retval) {
+		retval = bl_sha256_update(&ctx, (const uint8_t *)fw_address,
+					  fwinfo->size);
+	}
+	if (!retval) {
+		retval = bl_sha256_finalize(&ctx, fw_record.hash);
+	}
+	if (retval) {
+		PRINT("Firmware hash failed with error %d.\n\r", retval);
+		return false;
+	}
+
+	if (validation_record_find(&fw_record)) {
+		PRINT("Firmware matches validation record.\n\r");
+		return true;
+	}
+
+	if (!validate_signature(fw_address, fwinfo->size, fw_val_info, external,
+				&fw_record.key_idx)) {
+		return false;
+	}
+
+	if (BL_STORAGE_PROTECTED && num_validation_record_slots() > 0) {
+		retval = validation_record_write(&fw_record);
+		if (retval) {
+			PRINT("validation_record_write() error: %d\n\r", retval);
+		}
+	}
+
+	return true;
+}
+#endif /* CONFIG_SB_VALIDATION_RECORD */
+
 
 #elif defined(CONFIG_SB_VALIDATE_FW_HASH)
 static bool validate_hash(const uint32_t fw_src_address, const uint32_t fw_size,
@@ -339,8 +426,14 @@ static bool validate_firmware(uint32_t fw_dst_address, uint32_t fw_src_address,
 	}
 
 #ifdef CONFIG_SB_VALIDATE_FW_SIGNATURE
+#ifdef CONFIG_SB_VALIDATION_RECORD
+	if (!external) {
+		return validate_signature_recorded(fw_src_address, fwinfo,
+						   fw_val_info);
+	}
+#endif
 	return validate_signature(fw_src_address, fwinfo->size, fw_val_info,
-				external);
+				external, NULL);
 #elif defined(CONFIG_SB_VALIDATE_FW_HASH)
 	return validate_hash(fw_src_address, fwinfo->size, fw_val_info,
 				external);
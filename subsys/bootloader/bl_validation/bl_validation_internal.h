@@ -12,6 +12,8 @@ extern "C" {
 #endif
 
 #include <zephyr/types.h>
+#include <string.h>
+#include <bl_storage.h>
 
 
 static bool within(uint32_t addr, uint32_t start, uint32_t end)
@@ -43,6 +45,39 @@ static bool region_within(uint32_t inner_start, uint32_t inner_end,
 	return true;
 }
 
+/* Check whether a validation record was written for the given firmware. */
+static inline bool validation_record_matches(const struct bl_validation_record *record,
+			uint32_t address, uint32_t version, const uint8_t *hash)
+{
+	if (record->valid != BL_VALIDATION_RECORD_VALID) {
+		return false;
+	}
+	if (record->address != address) {
+		return false;
+	}
+	if (record->version != version) {
+		return false;
+	}
+	if (memcmp(record->hash, hash, sizeof(record->hash)) != 0) {
+		return false;
+	}
+	return true;
+}
+
+/* Check whether the signature verification of the firmware can be skipped
+ * because of the record. Nothing authenticates the record, so it can only be
+ * trusted if the booted firmware cannot write to the bootloader storage.
+ */
+static inline bool validation_record_trusted(const struct bl_validation_record *record,
+			const struct bl_validation_record *fw_record, bool storage_protected)
+{
+	if (!storage_protected) {
+		return false;
+	}
+	return validation_record_matches(record, fw_record->address,
+					 fw_record->version, fw_record->hash);
+}
+
 #ifdef __cplusplus
 }
 #endif
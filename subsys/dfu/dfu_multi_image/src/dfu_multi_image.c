@@ -12,6 +12,8 @@
 #include <errno.h>
 #include <string.h>
 
+#include "dfu_multi_image_pipeline.h"
+
 #define FIXED_HEADER_SIZE sizeof(uint16_t)
 #define CBOR_HEADER_NESTING_LEVEL 3
 #define IMAGE_NO_FIXED_HEADER -2
@@ -109,6 +111,34 @@ static const struct dfu_image_writer *current_image_writer(void)
 	return NULL;
 }
 
+static int writer_open(const struct dfu_image_writer *writer, size_t image_size)
+{
+	if (IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		return dfu_multi_image_pipeline_open(writer, image_size);
+	}
+
+	return writer->open(writer->image_id, image_size);
+}
+
+static int writer_write(const struct dfu_image_writer *writer, const uint8_t *chunk,
+			size_t chunk_size)
+{
+	if (IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		return dfu_multi_image_pipeline_write(writer, chunk, chunk_size);
+	}
+
+	return writer->write(chunk, chunk_size);
+}
+
+static int writer_close(const struct dfu_image_writer *writer, bool success)
+{
+	if (IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		return dfu_multi_image_pipeline_close(writer, success);
+	}
+
+	return writer->close(success);
+}
+
 static void select_next_image(void)
 {
 	ctx.cur_item_offset = 0;
@@ -149,16 +179,15 @@ static int process_current_item(const uint8_t *chunk, size_t chunk_size)
 		}
 
 		if (!err && ctx.cur_item_offset == 0) {
-			err = writer->open(writer->image_id,
-					   ctx.header.images[ctx.cur_image_no].size);
+			err = writer_open(writer, ctx.header.images[ctx.cur_image_no].size);
 		}
 
 		if (!err) {
-			err = writer->write(chunk, chunk_size);
+			err = writer_write(writer, chunk, chunk_size);
 		}
 
 		if (!err && ctx.cur_item_offset + chunk_size == ctx.cur_item_size) {
-			err = writer->close(true);
+			err = writer_close(writer, true);
 		}
 	}
 
@@ -182,6 +211,14 @@ int dfu_multi_image_init(uint8_t *buffer, size_t buffer_size)
 		return -EINVAL;
 	}
 
+	if (IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		int err = dfu_multi_image_pipeline_init();
+
+		if (err) {
+			return err;
+		}
+	}
+
 	memset(&ctx, 0, sizeof(ctx));
 	ctx.buffer = buffer;
 	ctx.buffer_size = buffer_size;
@@ -197,6 +234,12 @@ int dfu_multi_image_register_writer(const struct dfu_image_writer *writer)
 		return -ENOMEM;
 	}
 
+#ifdef CONFIG_DFU_MULTI_IMAGE_PIPELINE
+	if (writer->lane >= CONFIG_DFU_MULTI_IMAGE_PIPELINE_LANES) {
+		return -EINVAL;
+	}
+#endif
+
 	ctx.writers[ctx.writer_count++] = *writer;
 	return 0;
 }
@@ -242,9 +285,20 @@ int dfu_multi_image_done(bool success)
 	const struct dfu_image_writer *writer = current_image_writer();
 	int err = 0;
 
+	if (IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE) && !success) {
+		dfu_multi_image_pipeline_abort();
+	}
+
 	/* Close any active writer if such exists */
 	if (writer != NULL) {
-		err = writer->close(success);
+		err = writer_close(writer, success);
+	}
+
+	/* Wait for the writer threads to write all buffered data */
+	if (IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		int sync_err = dfu_multi_image_pipeline_sync();
+
+		err = err ? err : sync_err;
 	}
 
 	/* On success, verify that all images have been fully written */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include "dfu_multi_image_pipeline.h"
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/util.h>
+
+#define LANE_COUNT CONFIG_DFU_MULTI_IMAGE_PIPELINE_LANES
+
+enum lane_op_type {
+	LANE_OP_OPEN,
+	LANE_OP_WRITE,
+	LANE_OP_CLOSE,
+	LANE_OP_SYNC,
+};
+
+/*
+ * Operation queued on a lane. LANE_OP_WRITE operation is followed in the lane buffer
+ * by the image data of the given size.
+ */
+struct lane_op {
+	const struct dfu_image_writer *writer;
+	size_t size;
+	uint8_t type;
+	bool success;
+};
+
+struct lane {
+	struct k_pipe pipe;
+	struct k_sem synced;
+	struct k_thread thread;
+
+	/* First error reported by the image writers on this lane */
+	atomic_t err;
+
+	/* Owned by the lane thread */
+	bool image_open;
+	uint8_t chunk[CONFIG_DFU_MULTI_IMAGE_PIPELINE_WRITE_SIZE];
+
+	uint8_t buffer[CONFIG_DFU_MULTI_IMAGE_PIPELINE_BUF_SIZE];
+};
+
+static K_THREAD_STACK_ARRAY_DEFINE(lane_stacks, LANE_COUNT,
+				   CONFIG_DFU_MULTI_IMAGE_PIPELINE_STACK_SIZE);
+static struct lane lanes[LANE_COUNT];
+static atomic_t aborted;
+static bool started;
+
+static void lane_get(struct lane *lane, void *data, size_t size)
+{
+	size_t bytes_read;
+
+	/* Blocks until all requested bytes are available */
+	(void)k_pipe_get(&lane->pipe, data, size, &bytes_read, size, K_FOREVER);
+}
+
+static int lane_put(struct lane *lane, const void *data, size_t size)
+{
+	size_t bytes_written;
+
+	/* Blocks until all bytes are buffered or consumed by the lane thread */
+	return k_pipe_put(&lane->pipe, (void *)data, size, &bytes_written, size, K_FOREVER);
+}
+
+static bool lane_failed(struct lane *lane)
+{
+	return atomic_get(&lane->err) != 0 || atomic_get(&aborted) != 0;
+}
+
+static void lane_set_error(struct lane *lane, int err)
+{
+	if (err) {
+		(void)atomic_cas(&lane->err, 0, err);
+	}
+}
+
+static void lane_write(struct lane *lane, const struct lane_op *op)
+{
+	size_t remaining = op->size;
+
+	/* Data is consumed even after a failure so that the lane buffer does not block */
+	while (remaining > 0) {
+		const size_t size = MIN(remaining, sizeof(lane->chunk));
+
+		lane_get(lane, lane->chunk, size);
+		remaining -= size;
+
+		if (!lane_failed(lane)) {
+			lane_set_error(lane, op->writer->write(lane->chunk, size));
+		}
+	}
+}
+
+static void lane_thread(void *p1, void *p2, void *p3)
+{
+	struct lane *lane = p1;
+	struct lane_op op;
+	int err;
+
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (true) {
+		lane_get(lane, &op, sizeof(op));
+
+		switch (op.type) {
+		case LANE_OP_OPEN:
+			if (!lane_failed(lane)) {
+				err = op.writer->open(op.writer->image_id, op.size);
+				lane->image_open = (err == 0);
+				lane_set_error(lane, err);
+			}
+			break;
+		case LANE_OP_WRITE:
+			lane_write(lane, &op);
+			break;
+		case LANE_OP_CLOSE:
+			if (lane->image_open) {
+				lane->image_open = false;
+				err = op.writer->close(op.success && !lane_failed(lane));
+				lane_set_error(lane, err);
+			}
+			break;
+		case LANE_OP_SYNC:
+			k_sem_give(&lane->synced);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static int first_error(void)
+{
+	int err;
+
+	for (size_t i = 0; i < LANE_COUNT; i++) {
+		err = (int)atomic_get(&lanes[i].err);
+
+		if (err) {
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+static int queue_op(const struct dfu_image_writer *writer, uint8_t type, size_t size,
+		    bool success)
+{
+	const struct lane_op op = {
+		.writer = writer, .size = size, .type = type, .success = success
+	};
+
+	return lane_put(&lanes[writer->lane], &op, sizeof(op));
+}
+
+int dfu_multi_image_pipeline_init(void)
+{
+	if (!started) {
+		for (size_t i = 0; i < LANE_COUNT; i++) {
+			struct lane *lane = &lanes[i];
+
+			k_pipe_init(&lane->pipe, lane->buffer, sizeof(lane->buffer));
+			k_sem_init(&lane->synced, 0, 1);
+			k_thread_create(&lane->thread, lane_stacks[i],
+					K_THREAD_STACK_SIZEOF(lane_stacks[i]), lane_thread, lane,
+					NULL, NULL, CONFIG_DFU_MULTI_IMAGE_PIPELINE_THREAD_PRIO, 0,
+					K_NO_WAIT);
+			k_thread_name_set(&lane->thread, "dfu_multi_image");
+		}
+
+		started = true;
+	} else {
+		/* Let the lanes finish the previous package */
+		(void)dfu_multi_image_pipeline_sync();
+	}
+
+	for (size_t i = 0; i < LANE_COUNT; i++) {
+		atomic_clear(&lanes[i].err);
+		lanes[i].image_open = false;
+	}
+
+	atomic_clear(&aborted);
+
+	return 0;
+}
+
+int dfu_multi_image_pipeline_open(const struct dfu_image_writer *writer, size_t image_size)
+{
+	int err = first_error();
+
+	if (err) {
+		return err;
+	}
+
+	return queue_op(writer, LANE_OP_OPEN, image_size, false);
+}
+
+int dfu_multi_image_pipeline_write(const struct dfu_image_writer *writer, const uint8_t *chunk,
+				   size_t chunk_size)
+{
+	int err = first_error();
+
+	if (err) {
+		return err;
+	}
+
+	err = queue_op(writer, LANE_OP_WRITE, chunk_size, false);
+
+	if (err) {
+		return err;
+	}
+
+	return lane_put(&lanes[writer->lane], chunk, chunk_size);
+}
+
+int dfu_multi_image_pipeline_close(const struct dfu_image_writer *writer, bool success)
+{
+	/* Always queued, so that an open image is closed even if a lane has failed */
+	int err = queue_op(writer, LANE_OP_CLOSE, 0, success);
+
+	return err ? err : first_error();
+}
+
+void dfu_multi_image_pipeline_abort(void)
+{
+	atomic_set(&aborted, 1);
+}
+
+int dfu_multi_image_pipeline_sync(void)
+{
+	const struct lane_op op = { .type = LANE_OP_SYNC };
+
+	/* Nothing to wait for if the lanes have not been created yet */
+	if (!started) {
+		return 0;
+	}
+
+	for (size_t i = 0; i < LANE_COUNT; i++) {
+		(void)lane_put(&lanes[i], &op, sizeof(op));
+	}
+
+	for (size_t i = 0; i < LANE_COUNT; i++) {
+		k_sem_take(&lanes[i].synced, K_FOREVER);
+	}
+
+	return first_error();
+}
@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef DFU_MULTI_IMAGE_PIPELINE_H__
+#define DFU_MULTI_IMAGE_PIPELINE_H__
+
+#include <dfu/dfu_multi_image.h>
+
+/*
+ * Writer thread (lane) interface used by the DFU Multi Image library when
+ * CONFIG_DFU_MULTI_IMAGE_PIPELINE is enabled.
+ *
+ * The open, write and close functions queue the operation on the lane of the
+ * writer and return the first error reported by any lane so far.
+ */
+
+int dfu_multi_image_pipeline_init(void);
+int dfu_multi_image_pipeline_open(const struct dfu_image_writer *writer, size_t image_size);
+int dfu_multi_image_pipeline_write(const struct dfu_image_writer *writer, const uint8_t *chunk,
+				   size_t chunk_size);
+int dfu_multi_image_pipeline_close(const struct dfu_image_writer *writer, bool success);
+
+/* Drop the queued data that has not been written yet. */
+void dfu_multi_image_pipeline_abort(void);
+
+/* Wait until all lanes are idle and return the first error reported by any lane. */
+int dfu_multi_image_pipeline_sync(void);
+
+#endif /* DFU_MULTI_IMAGE_PIPELINE_H__ */
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef DFU_TARGET_APP_DELTA_PATCH_H__
+#define DFU_TARGET_APP_DELTA_PATCH_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Streaming decoder of the application delta patch format generated by
+ * 'scripts/bootloader/app_delta_tool.py'.
+ *
+ * The patch starts with a header of four little-endian 32-bit words: magic,
+ * source image size, CRC-32 (IEEE) of the source image and target image size.
+ * It is followed by records, each consisting of:
+ *
+ * - diff length, extra length and seek, as LEB128 varints (seek is zigzag
+ *   encoded),
+ * - diff data covering diff length target bytes, as pairs of a zero run
+ *   length and a literal length (varints), each literal length followed by
+ *   the literal bytes. A target byte is the sum of the source byte at the
+ *   current source position and the corresponding delta byte; delta bytes in
+ *   zero runs are zero, that is, the source bytes are copied,
+ * - extra length bytes copied to the target as is.
+ *
+ * The source position is advanced by the diff length and then moved by the
+ * seek. The target image is complete when the sum of all diff and extra
+ * lengths reaches the target size.
+ *
+ * The decoder keeps no copy of the source or target image. Source bytes are
+ * read on demand directly into the target buffer.
+ */
+
+#define APP_DELTA_PATCH_MAGIC 0x544c4441 /* "ADLT" */
+#define APP_DELTA_PATCH_HEADER_SIZE 16
+
+struct app_delta_patch_cb {
+	/* Read source image bytes at the given offset. */
+	int (*source_read)(size_t offset, uint8_t *buf, size_t len);
+
+	/* Called once the header is parsed and the source image is verified. */
+	int (*target_open)(size_t target_size);
+
+	/* Write subsequent target image bytes. */
+	int (*target_write)(const uint8_t *buf, size_t len);
+};
+
+struct app_delta_patch {
+	const struct app_delta_patch_cb *cb;
+
+	/* Target buffer */
+	uint8_t *buf;
+	size_t buf_len;
+	size_t buf_bytes;
+
+	uint8_t header[APP_DELTA_PATCH_HEADER_SIZE];
+	size_t header_bytes;
+
+	uint32_t source_size;
+	uint32_t target_size;
+	size_t source_pos;
+	size_t target_bytes;
+	size_t patch_bytes;
+
+	/* Current record */
+	uint32_t diff_left;
+	uint32_t extra_left;
+	uint32_t run_left;
+	int32_t seek;
+
+	/* Varint being parsed */
+	uint32_t varint;
+	uint8_t varint_shift;
+
+	uint8_t state;
+};
+
+/**
+ * @brief Initialize the patch decoder.
+ *
+ * @param[out] patch   Decoder context.
+ * @param[in]  cb      Source and target access functions.
+ * @param[in]  buf     Target buffer. Source bytes are read into it, so its size
+ *                     also limits the size of a single source read.
+ * @param[in]  buf_len Size of the target buffer.
+ *
+ * @retval 0 on success, -EINVAL on invalid parameters.
+ */
+int app_delta_patch_init(struct app_delta_patch *patch, const struct app_delta_patch_cb *cb,
+			 uint8_t *buf, size_t buf_len);
+
+/**
+ * @brief Process subsequent patch bytes.
+ *
+ * @retval 0 on success.
+ * @retval -EBADMSG if the patch is malformed or does not fit the source image.
+ * @retval -EINVAL if the source image does not match the patch.
+ * @retval negative errno returned by the callbacks otherwise.
+ */
+int app_delta_patch_write(struct app_delta_patch *patch, const uint8_t *data, size_t len);
+
+/**
+ * @brief Flush the target buffer and check that the target image is complete.
+ *
+ * @retval 0 on success.
+ * @retval -ENODATA if the patch is incomplete.
+ * @retval negative errno returned by the callbacks otherwise.
+ */
+int app_delta_patch_done(struct app_delta_patch *patch);
+
+/** @brief Check whether the buffer starts with the patch magic. */
+bool app_delta_patch_identify(const void *const buf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DFU_TARGET_APP_DELTA_PATCH_H__ */
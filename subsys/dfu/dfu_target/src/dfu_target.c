@@ -29,6 +29,10 @@ DEF_DFU_TARGET(mcuboot);
 #include "dfu/dfu_target_full_modem.h"
 DEF_DFU_TARGET(full_modem);
 #endif
+#ifdef CONFIG_DFU_TARGET_APP_DELTA
+#include "dfu/dfu_target_app_delta.h"
+DEF_DFU_TARGET(app_delta);
+#endif
 
 #define MIN_SIZE_IDENTIFY_BUF 32
 
@@ -56,6 +60,11 @@ int dfu_target_img_type(const void *const buf, size_t len)
 	if (dfu_target_full_modem_identify(buf)) {
 		return DFU_TARGET_IMAGE_TYPE_FULL_MODEM;
 	}
+#endif
+#ifdef CONFIG_DFU_TARGET_APP_DELTA
+	if (dfu_target_app_delta_identify(buf)) {
+		return DFU_TARGET_IMAGE_TYPE_APP_DELTA;
+	}
 #endif
 	LOG_ERR("No supported image type found");
 	return -ENOTSUP;
@@ -79,6 +88,11 @@ int dfu_target_init(int img_type, int img_num, size_t file_size, dfu_target_call
 	if (img_type == DFU_TARGET_IMAGE_TYPE_FULL_MODEM) {
 		new_target = &dfu_target_full_modem;
 	}
+#endif
+#ifdef CONFIG_DFU_TARGET_APP_DELTA
+	if (img_type == DFU_TARGET_IMAGE_TYPE_APP_DELTA) {
+		new_target = &dfu_target_app_delta;
+	}
 #endif
 	if (new_target == NULL) {
 		LOG_ERR("Unknown image type");
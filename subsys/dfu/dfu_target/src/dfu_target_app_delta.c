@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/storage/flash_map.h>
+#include <pm_config.h>
+#include <dfu/dfu_target.h>
+#include <dfu/dfu_target_app_delta.h>
+#include <dfu/dfu_target_mcuboot.h>
+
+#include "dfu_target_app_delta_patch.h"
+
+LOG_MODULE_REGISTER(dfu_target_app_delta, CONFIG_DFU_TARGET_LOG_LEVEL);
+
+static struct app_delta_patch patch;
+static uint8_t patch_buf[CONFIG_DFU_TARGET_APP_DELTA_BUF_SIZE];
+static const struct flash_area *primary;
+static bool target_open;
+
+static int source_read(size_t offset, uint8_t *buf, size_t len)
+{
+	return flash_area_read(primary, offset, buf, len);
+}
+
+static int target_init(size_t target_size)
+{
+	size_t offset;
+	int err;
+
+	err = dfu_target_mcuboot_init(target_size, 0, NULL);
+	if (err) {
+		return err;
+	}
+
+	target_open = true;
+
+	/* The patch is always applied from its beginning, so write progress
+	 * of an earlier attempt restored by the stream cannot be used.
+	 */
+	err = dfu_target_mcuboot_offset_get(&offset);
+	if (err || offset == 0) {
+		return err;
+	}
+
+	LOG_INF("Discarding %zu bytes of an earlier update", offset);
+
+	err = dfu_target_mcuboot_done(true);
+	if (err) {
+		target_open = false;
+		return err;
+	}
+
+	return dfu_target_mcuboot_init(target_size, 0, NULL);
+}
+
+static int target_write(const uint8_t *buf, size_t len)
+{
+	return dfu_target_mcuboot_write(buf, len);
+}
+
+static const struct app_delta_patch_cb patch_cb = {
+	.source_read = source_read,
+	.target_open = target_init,
+	.target_write = target_write,
+};
+
+bool dfu_target_app_delta_identify(const void *const buf)
+{
+	return app_delta_patch_identify(buf);
+}
+
+int dfu_target_app_delta_init(size_t file_size, int img_num, dfu_target_callback_t cb)
+{
+	int err;
+
+	ARG_UNUSED(file_size);
+	ARG_UNUSED(cb);
+
+	/* Only the image in the application core primary slot can be read */
+	if (img_num != 0) {
+		LOG_ERR("Delta update of image %d not supported", img_num);
+		return -ENOTSUP;
+	}
+
+	if (primary == NULL) {
+		err = flash_area_open(PM_MCUBOOT_PRIMARY_ID, &primary);
+		if (err) {
+			LOG_ERR("Failed to open primary slot (err %d)", err);
+			return err;
+		}
+	}
+
+	target_open = false;
+
+	return app_delta_patch_init(&patch, &patch_cb, patch_buf, sizeof(patch_buf));
+}
+
+int dfu_target_app_delta_offset_get(size_t *out)
+{
+	/* Patch state is kept in RAM only, so a download can be continued
+	 * only until the device is reset.
+	 */
+	*out = patch.patch_bytes;
+
+	return 0;
+}
+
+int dfu_target_app_delta_write(const void *const buf, size_t len)
+{
+	return app_delta_patch_write(&patch, buf, len);
+}
+
+int dfu_target_app_delta_done(bool successful)
+{
+	int err = 0;
+
+	if (successful) {
+		err = app_delta_patch_done(&patch);
+	}
+
+	if (target_open) {
+		int done_err = dfu_target_mcuboot_done(successful && err == 0);
+
+		err = err ? err : done_err;
+		target_open = false;
+	}
+
+	if (err) {
+		LOG_ERR("Application delta update failed (err %d)", err);
+	}
+
+	/* Start over on the next download */
+	(void)app_delta_patch_init(&patch, &patch_cb, patch_buf, sizeof(patch_buf));
+
+	return err;
+}
+
+int dfu_target_app_delta_schedule_update(int img_num)
+{
+	return dfu_target_mcuboot_schedule_update(img_num == -1 ? 0 : img_num);
+}
@@ -0,0 +1,406 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/crc.h>
+#include <string.h>
+
+#include "dfu_target_app_delta_patch.h"
+
+LOG_MODULE_REGISTER(dfu_target_app_delta_patch, CONFIG_DFU_TARGET_LOG_LEVEL);
+
+enum patch_state {
+	STATE_HEADER,
+	STATE_DIFF_LEN,
+	STATE_EXTRA_LEN,
+	STATE_SEEK,
+	STATE_ZERO_RUN_LEN,
+	STATE_ZERO_RUN,
+	STATE_LITERAL_LEN,
+	STATE_LITERAL,
+	STATE_EXTRA,
+	STATE_COMPLETE,
+};
+
+static int flush(struct app_delta_patch *p)
+{
+	int err = 0;
+
+	if (p->buf_bytes > 0) {
+		err = p->cb->target_write(p->buf, p->buf_bytes);
+		p->buf_bytes = 0;
+	}
+
+	return err;
+}
+
+/* Make room in the target buffer and return the number of bytes that fit. */
+static int reserve(struct app_delta_patch *p, size_t *room)
+{
+	int err = 0;
+
+	if (p->buf_bytes == p->buf_len) {
+		err = flush(p);
+	}
+
+	*room = p->buf_len - p->buf_bytes;
+
+	return err;
+}
+
+/* Read source bytes into the target buffer. */
+static int source_copy(struct app_delta_patch *p, size_t len)
+{
+	int err;
+
+	if (p->source_pos + len > p->source_size) {
+		LOG_ERR("Patch reads beyond source image");
+		return -EBADMSG;
+	}
+
+	err = p->cb->source_read(p->source_pos, &p->buf[p->buf_bytes], len);
+	if (err) {
+		LOG_ERR("Source read failed (err %d)", err);
+		return err;
+	}
+
+	p->source_pos += len;
+	p->buf_bytes += len;
+	p->target_bytes += len;
+
+	return 0;
+}
+
+static int source_verify(struct app_delta_patch *p, uint32_t crc)
+{
+	uint32_t actual = 0;
+	int err;
+
+	/* Target buffer is not used before the header is parsed */
+	for (size_t off = 0; off < p->source_size; off += p->buf_len) {
+		size_t len = MIN(p->buf_len, p->source_size - off);
+
+		err = p->cb->source_read(off, p->buf, len);
+		if (err) {
+			LOG_ERR("Source read failed (err %d)", err);
+			return err;
+		}
+
+		actual = crc32_ieee_update(actual, p->buf, len);
+	}
+
+	if (actual != crc) {
+		LOG_ERR("Patch does not apply to source image (CRC 0x%08x != 0x%08x)",
+			actual, crc);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int parse_header(struct app_delta_patch *p)
+{
+	int err;
+
+	if (sys_get_le32(&p->header[0]) != APP_DELTA_PATCH_MAGIC) {
+		LOG_ERR("Invalid patch magic");
+		return -EBADMSG;
+	}
+
+	p->source_size = sys_get_le32(&p->header[4]);
+	p->target_size = sys_get_le32(&p->header[12]);
+
+	err = source_verify(p, sys_get_le32(&p->header[8]));
+	if (err) {
+		return err;
+	}
+
+	err = p->cb->target_open(p->target_size);
+	if (err) {
+		return err;
+	}
+
+	p->state = (p->target_size > 0) ? STATE_DIFF_LEN : STATE_COMPLETE;
+
+	return 0;
+}
+
+/* Returns true when the varint is complete. */
+static bool varint_feed(struct app_delta_patch *p, uint8_t byte, int *err)
+{
+	if (p->varint_shift > 28) {
+		*err = -EBADMSG;
+		return false;
+	}
+
+	p->varint |= (uint32_t)(byte & 0x7f) << p->varint_shift;
+	p->varint_shift += 7;
+
+	return (byte & 0x80) == 0;
+}
+
+static uint32_t varint_take(struct app_delta_patch *p)
+{
+	uint32_t value = p->varint;
+
+	p->varint = 0;
+	p->varint_shift = 0;
+
+	return value;
+}
+
+static int end_record(struct app_delta_patch *p)
+{
+	int64_t pos = (int64_t)p->source_pos + p->seek;
+
+	if (pos < 0 || pos > p->source_size) {
+		LOG_ERR("Patch seeks beyond source image");
+		return -EBADMSG;
+	}
+
+	p->source_pos = (size_t)pos;
+	p->state = (p->target_bytes == p->target_size) ? STATE_COMPLETE : STATE_DIFF_LEN;
+
+	return 0;
+}
+
+/* Select the next state within a record after its diff data is processed. */
+static int next_section(struct app_delta_patch *p)
+{
+	if (p->diff_left > 0) {
+		p->state = STATE_ZERO_RUN_LEN;
+	} else if (p->extra_left > 0) {
+		p->state = STATE_EXTRA;
+	} else {
+		return end_record(p);
+	}
+
+	return 0;
+}
+
+/* Process a control varint. */
+static int process_varint(struct app_delta_patch *p, uint32_t value)
+{
+	switch (p->state) {
+	case STATE_DIFF_LEN:
+		p->diff_left = value;
+		p->state = STATE_EXTRA_LEN;
+		break;
+	case STATE_EXTRA_LEN:
+		p->extra_left = value;
+		if ((uint64_t)p->diff_left + p->extra_left > p->target_size - p->target_bytes) {
+			LOG_ERR("Patch record exceeds target image");
+			return -EBADMSG;
+		}
+		p->state = STATE_SEEK;
+		break;
+	case STATE_SEEK:
+		/* Zigzag decoding */
+		p->seek = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+		return next_section(p);
+	case STATE_ZERO_RUN_LEN:
+		if (value > p->diff_left) {
+			return -EBADMSG;
+		}
+		p->run_left = value;
+		p->state = STATE_ZERO_RUN;
+		break;
+	case STATE_LITERAL_LEN:
+		if (value == 0 || value > p->diff_left) {
+			return -EBADMSG;
+		}
+		p->run_left = value;
+		p->state = STATE_LITERAL;
+		break;
+	default:
+		return -EBADMSG;
+	}
+
+	return 0;
+}
+
+/* Copy a zero run from the source. Does not consume patch bytes. */
+static int process_zero_run(struct app_delta_patch *p)
+{
+	size_t room;
+	size_t len;
+	int err;
+
+	while (p->run_left > 0) {
+		err = reserve(p, &room);
+		if (err) {
+			return err;
+		}
+
+		len = MIN(room, p->run_left);
+		err = source_copy(p, len);
+		if (err) {
+			return err;
+		}
+
+		p->run_left -= len;
+		p->diff_left -= len;
+	}
+
+	if (p->diff_left > 0) {
+		p->state = STATE_LITERAL_LEN;
+		return 0;
+	}
+
+	return next_section(p);
+}
+
+static int process_literal(struct app_delta_patch *p, const uint8_t *data, size_t len,
+			   size_t *used)
+{
+	uint8_t *out;
+	size_t room;
+	int err;
+
+	err = reserve(p, &room);
+	if (err) {
+		return err;
+	}
+
+	len = MIN(MIN(len, room), p->run_left);
+	out = &p->buf[p->buf_bytes];
+
+	err = source_copy(p, len);
+	if (err) {
+		return err;
+	}
+
+	for (size_t i = 0; i < len; i++) {
+		out[i] += data[i];
+	}
+
+	*used = len;
+	p->run_left -= len;
+	p->diff_left -= len;
+
+	if (p->run_left > 0) {
+		return 0;
+	}
+
+	if (p->diff_left > 0) {
+		p->state = STATE_ZERO_RUN_LEN;
+		return 0;
+	}
+
+	return next_section(p);
+}
+
+static int process_extra(struct app_delta_patch *p, const uint8_t *data, size_t len,
+			 size_t *used)
+{
+	size_t room;
+	int err;
+
+	err = reserve(p, &room);
+	if (err) {
+		return err;
+	}
+
+	len = MIN(MIN(len, room), p->extra_left);
+	memcpy(&p->buf[p->buf_bytes], data, len);
+	p->buf_bytes += len;
+	p->target_bytes += len;
+
+	*used = len;
+	p->extra_left -= len;
+
+	return (p->extra_left > 0) ? 0 : end_record(p);
+}
+
+int app_delta_patch_init(struct app_delta_patch *patch, const struct app_delta_patch_cb *cb,
+			 uint8_t *buf, size_t buf_len)
+{
+	if (patch == NULL || cb == NULL || buf == NULL || buf_len == 0) {
+		return -EINVAL;
+	}
+
+	memset(patch, 0, sizeof(*patch));
+	patch->cb = cb;
+	patch->buf = buf;
+	patch->buf_len = buf_len;
+	patch->state = STATE_HEADER;
+
+	return 0;
+}
+
+int app_delta_patch_write(struct app_delta_patch *p, const uint8_t *data, size_t len)
+{
+	size_t used;
+	int err = 0;
+
+	while (!err && (len > 0 || p->state == STATE_ZERO_RUN)) {
+		used = 0;
+
+		switch (p->state) {
+		case STATE_HEADER:
+			used = MIN(len, sizeof(p->header) - p->header_bytes);
+			memcpy(&p->header[p->header_bytes], data, used);
+			p->header_bytes += used;
+			if (p->header_bytes == sizeof(p->header)) {
+				err = parse_header(p);
+			}
+			break;
+		case STATE_DIFF_LEN:
+		case STATE_EXTRA_LEN:
+		case STATE_SEEK:
+		case STATE_ZERO_RUN_LEN:
+		case STATE_LITERAL_LEN:
+			used = 1;
+			if (varint_feed(p, data[0], &err)) {
+				err = process_varint(p, varint_take(p));
+			}
+			break;
+		case STATE_ZERO_RUN:
+			err = process_zero_run(p);
+			break;
+		case STATE_LITERAL:
+			err = process_literal(p, data, len, &used);
+			break;
+		case STATE_EXTRA:
+			err = process_extra(p, data, len, &used);
+			break;
+		default:
+			LOG_ERR("Trailing data after patch");
+			err = -EBADMSG;
+			break;
+		}
+
+		data += used;
+		len -= used;
+		p->patch_bytes += used;
+	}
+
+	return err;
+}
+
+int app_delta_patch_done(struct app_delta_patch *p)
+{
+	int err = flush(p);
+
+	if (err) {
+		return err;
+	}
+
+	if (p->state != STATE_COMPLETE) {
+		LOG_ERR("Patch incomplete, %zu of %u target bytes", p->target_bytes,
+			p->target_size);
+		return -ENODATA;
+	}
+
+	return 0;
+}
+
+bool app_delta_patch_identify(const void *const buf)
+{
+	return sys_get_le32(buf) == APP_DELTA_PATCH_MAGIC;
+}
@@ -13,18 +13,77 @@
 #ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
 #define MODULE "dfu"
 #define DFU_STREAM_OFFSET "stream/offset"
+#define DFU_STREAM_SHA256 "sha256"
 #include <zephyr/settings/settings.h>
 #endif /* CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS */
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+#include <tinycrypt/constants.h>
+#include <tinycrypt/sha256.h>
+
+BUILD_ASSERT(TC_SHA256_DIGEST_SIZE == DFU_TARGET_STREAM_SHA256_LEN);
+#endif /* CONFIG_DFU_TARGET_STREAM_SHA256 */
+
 LOG_MODULE_REGISTER(dfu_target_stream, CONFIG_DFU_TARGET_LOG_LEVEL);
 
 static struct stream_flash_ctx stream;
 static const char *current_id;
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+/* Hash state of the data written to flash, that is, the first
+ * stream.bytes_written bytes of the stream. The data in the stream buffer
+ * is hashed when it is flushed.
+ */
+static struct tc_sha256_state_struct sha256;
+static bool sha256_valid;
+static uint8_t expected_sha256[DFU_TARGET_STREAM_SHA256_LEN];
+static bool expected_sha256_set;
+static uint8_t digest[DFU_TARGET_STREAM_SHA256_LEN];
+static bool digest_valid;
+
+/* The hash state is stored together with the write progress it refers to. */
+struct sha256_progress {
+	size_t bytes_written;
+	struct tc_sha256_state_struct state;
+};
+#endif /* CONFIG_DFU_TARGET_STREAM_SHA256 */
+
 #ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
 
 static char current_name_key[32];
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+static char current_sha256_key[sizeof(current_name_key) + sizeof(DFU_STREAM_SHA256)];
+static struct sha256_progress loaded_sha256;
+static bool loaded_sha256_valid;
+static size_t stored_sha256_bytes;
+
+static int store_sha256_progress(size_t bytes_written)
+{
+	int err;
+	struct sha256_progress progress = {
+		.bytes_written = bytes_written,
+		.state = sha256,
+	};
+
+	/* Hash state changes only when data is flushed to flash. */
+	if (!sha256_valid || (bytes_written == stored_sha256_bytes)) {
+		return 0;
+	}
+
+	err = settings_save_one(current_sha256_key, &progress,
+				sizeof(progress));
+	if (err) {
+		LOG_ERR("Problem storing hash state (err %d)", err);
+		return err;
+	}
+
+	stored_sha256_bytes = bytes_written;
+
+	return 0;
+}
+#endif /* CONFIG_DFU_TARGET_STREAM_SHA256 */
+
 /**
  * @brief Store the information stored in the stream_flash instance so that it
  *        can be restored from flash in case of a power failure, reboot etc.
@@ -42,6 +101,13 @@ static int store_progress(void)
 		return err;
 	}
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	err = store_sha256_progress(bytes_written);
+	if (err) {
+		return err;
+	}
+#endif
+
 	return 0;
 }
 
@@ -53,6 +119,21 @@ static int store_progress(void)
 static int settings_set(const char *key, size_t len_rd,
 			settings_read_cb read_cb, void *cb_arg)
 {
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	const char *next;
+
+	if (current_id && settings_name_steq(key, current_id, &next) &&
+	    next && !strcmp(next, DFU_STREAM_SHA256)) {
+		ssize_t len = read_cb(cb_arg, &loaded_sha256,
+				      sizeof(loaded_sha256));
+
+		/* Discard the state stored by an incompatible build. */
+		loaded_sha256_valid = (len_rd == sizeof(loaded_sha256)) &&
+				      (len == sizeof(loaded_sha256));
+		return 0;
+	}
+#endif /* CONFIG_DFU_TARGET_STREAM_SHA256 */
+
 	if (current_id && !strcmp(key, current_id)) {
 		int err;
 		off_t absolute_offset;
@@ -91,6 +172,78 @@ static int settings_set(const char *key, size_t len_rd,
 }
 #endif /* CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS */
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+/**
+ * @brief Restore the hash state of the data that was already written to flash.
+ *
+ * If no matching hash state was stored, the data is read back from flash.
+ */
+static void sha256_resume(uint8_t *buf, size_t buf_len)
+{
+	size_t bytes_written = stream_flash_bytes_written(&stream);
+
+	(void)tc_sha256_init(&sha256);
+	sha256_valid = true;
+
+#ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
+	stored_sha256_bytes = 0;
+#endif
+
+	if (bytes_written == 0) {
+		return;
+	}
+
+#ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
+	if (loaded_sha256_valid &&
+	    (loaded_sha256.bytes_written == bytes_written)) {
+		sha256 = loaded_sha256.state;
+		stored_sha256_bytes = bytes_written;
+		return;
+	}
+#endif
+
+	LOG_WRN("No hash state for stored progress, reading %zu bytes back",
+		bytes_written);
+
+	for (size_t off = 0; off < bytes_written; off += buf_len) {
+		size_t chunk = MIN(buf_len, bytes_written - off);
+		int err = flash_read(stream.fdev, stream.offset + off, buf,
+				     chunk);
+
+		if (err) {
+			LOG_ERR("flash_read error %d", err);
+			sha256_valid = false;
+			return;
+		}
+
+		(void)tc_sha256_update(&sha256, buf, chunk);
+	}
+}
+
+/**
+ * @brief Hash the data flushed to flash by a stream_flash write.
+ *
+ * @param[in] buf      Data passed to the write.
+ * @param[in] buffered Number of bytes in the stream buffer before the write.
+ *                     They were hashed before the write.
+ * @param[in] flushed  Number of bytes flushed to flash by the write.
+ */
+static void sha256_flushed(const uint8_t *buf, size_t buffered, size_t flushed)
+{
+	if (flushed == 0) {
+		return;
+	}
+
+	if (flushed < buffered) {
+		/* Stream buffer contents were hashed, but were not flushed. */
+		sha256_valid = false;
+		return;
+	}
+
+	(void)tc_sha256_update(&sha256, buf, flushed - buffered);
+}
+#endif /* CONFIG_DFU_TARGET_STREAM_SHA256 */
+
 struct stream_flash_ctx *dfu_target_stream_get_stream(void)
 {
 	return &stream;
@@ -126,6 +279,12 @@ int dfu_target_stream_init(const struct dfu_target_stream_init *init)
 		return -EFAULT;
 	}
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	(void)snprintf(current_sha256_key, sizeof(current_sha256_key), "%s/%s",
+		       current_name_key, DFU_STREAM_SHA256);
+	loaded_sha256_valid = false;
+#endif
+
 	static struct settings_handler sh = {
 		.name = MODULE,
 		.h_set = settings_set,
@@ -151,6 +310,17 @@ int dfu_target_stream_init(const struct dfu_target_stream_init *init)
 	}
 #endif /* CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS */
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	digest_valid = false;
+	expected_sha256_set = (init->expected_sha256 != NULL);
+	if (expected_sha256_set) {
+		memcpy(expected_sha256, init->expected_sha256,
+		       sizeof(expected_sha256));
+	}
+
+	sha256_resume(init->buf, init->len);
+#endif
+
 	return 0;
 }
 
@@ -163,13 +333,35 @@ int dfu_target_stream_offset_get(size_t *out)
 
 int dfu_target_stream_write(const uint8_t *buf, size_t len)
 {
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	size_t bytes_written = stream_flash_bytes_written(&stream);
+	size_t buffered = stream.buf_bytes;
+
+	/* The stream buffer is flushed when it gets full. Its contents are
+	 * overwritten by the write, so hash them beforehand.
+	 */
+	if (sha256_valid && (buffered + len >= stream.buf_len)) {
+		(void)tc_sha256_update(&sha256, stream.buf, buffered);
+	}
+#endif
+
 	int err = stream_flash_buffered_write(&stream, buf, len, false);
 
 	if (err != 0) {
 		LOG_ERR("stream_flash_buffered_write error %d", err);
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+		sha256_valid = false;
+#endif
 		return err;
 	}
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	if (sha256_valid) {
+		sha256_flushed(buf, buffered,
+			       stream_flash_bytes_written(&stream) - bytes_written);
+	}
+#endif
+
 #ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
 	err = store_progress();
 	if (err != 0) {
@@ -188,10 +380,21 @@ int dfu_target_stream_done(bool successful)
 	int err = 0;
 
 	if (successful) {
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+		if (sha256_valid) {
+			(void)tc_sha256_update(&sha256, stream.buf,
+					       stream.buf_bytes);
+		}
+#endif
 		err = stream_flash_buffered_write(&stream, NULL, 0, true);
 		if (err != 0) {
 			LOG_ERR("stream_flash_buffered_write error %d", err);
 		}
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+		digest_valid = (err == 0) && sha256_valid &&
+			       (tc_sha256_final(digest, &sha256) == TC_CRYPTO_SUCCESS);
+		sha256_valid = false;
+#endif
 #ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
 		/* Delete state so that a new call to 'init' will
 		 * start with offset 0.
@@ -200,6 +403,12 @@ int dfu_target_stream_done(bool successful)
 		if (err != 0) {
 			LOG_ERR("setting_delete error %d", err);
 		}
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+		err = settings_delete(current_sha256_key);
+		if (err != 0) {
+			LOG_ERR("setting_delete error %d", err);
+		}
+#endif
 
 	} else {
 		/* The stream has not completed, store the progress so that
@@ -212,7 +421,36 @@ int dfu_target_stream_done(bool successful)
 #endif
 	}
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	if (successful && (err == 0) && expected_sha256_set) {
+		if (!digest_valid) {
+			LOG_ERR("SHA-256 digest of the stream is not available");
+			err = -EBADMSG;
+		} else if (memcmp(digest, expected_sha256, sizeof(digest))) {
+			LOG_ERR("SHA-256 digest of the stream does not match");
+			err = -EBADMSG;
+		}
+	}
+#endif
+
 	current_id = NULL;
 
 	return err;
 }
+
+int dfu_target_stream_sha256_get(uint8_t *out)
+{
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+	if (!digest_valid) {
+		return -ENODATA;
+	}
+
+	memcpy(out, digest, sizeof(digest));
+
+	return 0;
+#else
+	ARG_UNUSED(out);
+
+	return -ENOTSUP;
+#endif
+}
@@ -13,6 +13,10 @@
 #include <net/aws_fota.h>
 #endif
 
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+#include <net/mqtt_outbox.h>
+#endif
+
 #if defined(CONFIG_AWS_IOT_PROVISION_CERTIFICATES)
 #include CONFIG_AWS_IOT_CERTIFICATES_FILE
 #endif /* CONFIG_AWS_IOT_PROVISION_CERTIFICATES */
@@ -171,6 +175,36 @@ static void aws_iot_notify_event(const struct aws_iot_evt *aws_iot_evt)
 	}
 }
 
+/* Message ID for the packets the library sends directly with the MQTT client */
+static uint16_t message_id_get(void)
+{
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+	/* Not the ID of a message stored in the outbox, so that the acknowledgments
+	 * are not mixed up.
+	 */
+	return mqtt_outbox_message_id_get();
+#else
+	return k_cycle_get_32();
+#endif
+}
+
+static void aws_iot_ready_notify(void)
+{
+	struct aws_iot_evt aws_iot_evt = {
+		.type = AWS_IOT_EVT_READY
+	};
+
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+	/* Send the messages stored while disconnected */
+	int err = mqtt_outbox_connected(&client);
+
+	if (err) {
+		LOG_ERR("Failed to send stored messages, error: %d", err);
+	}
+#endif
+	aws_iot_notify_event(&aws_iot_evt);
+}
+
 #if defined(CONFIG_AWS_FOTA)
 static void aws_fota_cb_handler(struct aws_fota_event *fota_evt)
 {
@@ -382,7 +416,7 @@ static int topic_subscribe(void)
 
 	if (app_topic_data.list_count > 0) {
 
-		suback_conf.app_subs_message_id = k_cycle_get_32();
+		suback_conf.app_subs_message_id = message_id_get();
 
 		const struct mqtt_subscription_list app_sub_list = {
 			.list = app_topic_data.list,
@@ -406,7 +440,7 @@ static int topic_subscribe(void)
 
 	if (ARRAY_SIZE(aws_iot_rx_list) > 0) {
 
-		suback_conf.aws_subs_message_id = k_cycle_get_32();
+		suback_conf.aws_subs_message_id = message_id_get();
 
 		const struct mqtt_subscription_list aws_sub_list = {
 			.list = (struct mqtt_topic *)&aws_iot_rx_list,
@@ -564,15 +598,13 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 			}
 			if (err == 0) {
 				/* There were not topics to subscribe to. */
-				aws_iot_evt.type = AWS_IOT_EVT_READY;
-				aws_iot_notify_event(&aws_iot_evt);
+				aws_iot_ready_notify();
 			} /* else: wait for SUBACK */
 		} else {
 			/* pre-existing session:
 			 * subscription is already established.
 			 */
-			aws_iot_evt.type = AWS_IOT_EVT_READY;
-			aws_iot_notify_event(&aws_iot_evt);
+			aws_iot_ready_notify();
 
 			if (IS_ENABLED(
 				CONFIG_AWS_IOT_AUTO_DEVICE_SHADOW_REQUEST)) {
@@ -589,6 +621,9 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 			aws_iot_evt.data.err = AWS_IOT_DISCONNECT_USER_REQUEST;
 		}
 
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+		mqtt_outbox_disconnected();
+#endif
 		atomic_set(&aws_iot_disconnected, 1);
 		aws_iot_evt.type = AWS_IOT_EVT_DISCONNECTED;
 		aws_iot_notify_event(&aws_iot_evt);
@@ -627,6 +662,9 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 			mqtt_evt->param.puback.message_id,
 			mqtt_evt->result);
 
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+		(void)mqtt_outbox_puback(mqtt_evt->param.puback.message_id);
+#endif
 		aws_iot_evt.type = AWS_IOT_EVT_PUBACK;
 		aws_iot_evt.data.message_id = mqtt_evt->param.puback.message_id;
 		aws_iot_notify_event(&aws_iot_evt);
@@ -653,8 +691,7 @@ static void mqtt_evt_handler(struct mqtt_client *const c,
 			}
 
 			/* MQTT subscriptions established. */
-			aws_iot_evt.type = AWS_IOT_EVT_READY;
-			aws_iot_notify_event(&aws_iot_evt);
+			aws_iot_ready_notify();
 		} else if (err == -EAGAIN) {
 			/* Subscriptions remaining to be acknowledged. */
 		} else if (err < 0) {
@@ -984,25 +1021,47 @@ int aws_iot_send(const struct aws_iot_data *const tx_data)
 	param.dup_flag			= tx_data_pub.dup_flag;
 	param.retain_flag		= tx_data_pub.retain_flag;
 
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+	/* If the message ID has not been set by the application, the outbox assigns one. */
+	param.message_id = tx_data_pub.message_id;
+#else
 	/* If the message ID has not been set by the application, a random message ID is assigned
 	 * to the packet.
 	 */
 	if (tx_data_pub.message_id == 0) {
-		param.message_id = k_cycle_get_32();
+		param.message_id = message_id_get();
 		LOG_DBG("Using message ID %d set by the library", param.message_id);
 	} else {
 		param.message_id = tx_data_pub.message_id;
 		LOG_DBG("Using message ID %d set by the application", param.message_id);
 	}
+#endif
 
 	LOG_DBG("Publishing to topic: %s",
 		log_strdup(param.message.topic.topic.utf8));
 
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+	int err = mqtt_outbox_publish(&param);
+
+	if (err != -EMSGSIZE) {
+		return err;
+	}
+
+	/* Too large for the outbox, only sent when connected */
+	if (param.message_id == 0) {
+		param.message_id = message_id_get();
+	}
+#endif
+
 	return mqtt_publish(&client, &param);
 }
 
 int aws_iot_disconnect(void)
 {
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+	/* No more writes to the socket before it is closed */
+	mqtt_outbox_disconnected();
+#endif
 	atomic_set(&disconnect_requested, 1);
 	return mqtt_disconnect(&client);
 }
@@ -1099,6 +1158,14 @@ int aws_iot_init(const struct aws_iot_config *const config,
 	}
 #endif
 
+#if defined(CONFIG_AWS_IOT_MQTT_OUTBOX)
+	err = mqtt_outbox_init();
+	if (err) {
+		LOG_ERR("mqtt_outbox_init, error: %d", err);
+		return err;
+	}
+#endif
+
 	module_evt_handler = event_handler;
 
 	return err;
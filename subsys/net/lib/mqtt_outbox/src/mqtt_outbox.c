@@ -0,0 +1,1104 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/fs/fcb.h>
+#include <zephyr/storage/flash_map.h>
+#if defined(CONFIG_POSIX_API)
+#include <zephyr/posix/poll.h>
+#include <zephyr/posix/sys/socket.h>
+#else
+#include <zephyr/net/socket.h>
+#endif
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/logging/log.h>
+
+#include <net/mqtt_outbox.h>
+
+LOG_MODULE_REGISTER(mqtt_outbox, CONFIG_MQTT_OUTBOX_LOG_LEVEL);
+
+#if defined(CONFIG_PARTITION_MANAGER_ENABLED)
+#define OUTBOX_AREA_ID FLASH_AREA_ID(mqtt_outbox_storage)
+#else
+#define OUTBOX_AREA_ID FLASH_AREA_ID(storage)
+#endif
+
+#define OUTBOX_FCB_MAGIC 0x4f42514d
+#define OUTBOX_FCB_VERSION 1
+
+/* Fixed header, remaining length, topic length and message ID */
+#define PUBLISH_OVERHEAD_MAX 9
+#define PUBLISH_TYPE 0x30
+#define PUBLISH_DUP BIT(3)
+#define PUBLISH_RETAIN BIT(0)
+
+BUILD_ASSERT(CONFIG_MQTT_OUTBOX_BUF_SIZE >=
+	     CONFIG_MQTT_OUTBOX_MSG_MAX_SIZE + PUBLISH_OVERHEAD_MAX,
+	     "CONFIG_MQTT_OUTBOX_BUF_SIZE too small for CONFIG_MQTT_OUTBOX_MSG_MAX_SIZE");
+
+/* Size of the chunks written to flash, a multiple of the write block size */
+#define LOG_CHUNK_SIZE 32
+
+enum outbox_record_type {
+	RECORD_MSG = 'M',
+	/* Marks the message with the same ID and QoS as deleted */
+	RECORD_DELETE = 'D',
+};
+
+#define RECORD_QOS_MASK 0x03
+#define RECORD_RETAIN BIT(2)
+
+/** Log record, followed by the topic and the payload of a message. */
+struct outbox_record {
+	uint8_t type;
+	/** QoS and retain flag. */
+	uint8_t flags;
+	uint8_t priority;
+	uint8_t reserved;
+	uint16_t id;
+	uint16_t topic_len;
+	uint16_t payload_len;
+	uint16_t reserved2;
+	/** Time to live in seconds, 0 for no limit. */
+	uint32_t ttl;
+	/** Sequence number, keeps the order of the messages moved by log compaction. */
+	uint32_t seq;
+} __packed;
+
+/* Message states */
+#define MSG_STATE_USED BIT(0)
+/* Sent on the current connection, waiting for the PUBACK */
+#define MSG_STATE_INFLIGHT BIT(1)
+/* Sent at least once, sent again with the DUP flag */
+#define MSG_STATE_SENT BIT(2)
+/* In the buffer being written */
+#define MSG_STATE_BATCH BIT(3)
+
+/** Stored message. */
+struct outbox_msg {
+	/** Location of the record in the log. */
+	struct fcb_entry loc;
+	/** Uptime when the message expires, 0 for no limit. */
+	int64_t expiry;
+	uint32_t seq;
+	uint16_t id;
+	uint16_t topic_len;
+	uint16_t payload_len;
+	uint8_t flags;
+	uint8_t priority;
+	uint8_t state;
+};
+
+struct outbox_policy {
+	const char *topic;
+	size_t topic_len;
+	uint8_t priority;
+	uint32_t ttl;
+};
+
+/** Writes a record to flash in chunks padded to the write block size. */
+struct log_writer {
+	off_t off;
+	size_t fill;
+	uint8_t chunk[LOG_CHUNK_SIZE];
+};
+
+static struct fcb fcb;
+static struct flash_sector sectors[CONFIG_MQTT_OUTBOX_SECTOR_COUNT];
+static struct outbox_msg msgs[CONFIG_MQTT_OUTBOX_MSG_COUNT];
+static struct outbox_policy policies[CONFIG_MQTT_OUTBOX_POLICY_COUNT];
+static struct mqtt_outbox_stats stats;
+static uint8_t buf[CONFIG_MQTT_OUTBOX_BUF_SIZE];
+
+static bool initialized;
+/* MQTT client of the connection and its socket, NULL and -1 when disconnected */
+static struct mqtt_client *client;
+static int sock = -1;
+/* QoS 1 messages sent on the current connection and not acknowledged */
+static int inflight;
+static uint16_t next_id = 1;
+static uint32_t next_seq;
+
+static K_MUTEX_DEFINE(outbox_mutex);
+
+static uint8_t msg_qos(const struct outbox_msg *msg)
+{
+	return msg->flags & RECORD_QOS_MASK;
+}
+
+static struct outbox_msg *msg_find(uint16_t id, uint8_t qos)
+{
+	for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if ((msgs[i].state & MSG_STATE_USED) && msgs[i].id == id &&
+		    msg_qos(&msgs[i]) == qos) {
+			return &msgs[i];
+		}
+	}
+
+	return NULL;
+}
+
+static struct outbox_msg *msg_alloc(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if (!(msgs[i].state & MSG_STATE_USED)) {
+			return &msgs[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void msg_set(struct outbox_msg *msg, const struct outbox_record *rec,
+		    const struct fcb_entry *loc)
+{
+	msg->loc = *loc;
+	msg->expiry = rec->ttl ? k_uptime_get() + (int64_t)rec->ttl * MSEC_PER_SEC : 0;
+	msg->seq = rec->seq;
+	msg->id = rec->id;
+	msg->topic_len = rec->topic_len;
+	msg->payload_len = rec->payload_len;
+	msg->flags = rec->flags;
+	msg->priority = rec->priority;
+	msg->state = MSG_STATE_USED;
+}
+
+static int log_write(struct log_writer *w, const void *data, size_t len)
+{
+	const uint8_t *src = data;
+	size_t n;
+	int err;
+
+	while (len > 0) {
+		n = MIN(len, sizeof(w->chunk) - w->fill);
+		memcpy(&w->chunk[w->fill], src, n);
+		w->fill += n;
+		src += n;
+		len -= n;
+
+		if (w->fill == sizeof(w->chunk)) {
+			err = flash_area_write(fcb.fap, w->off, w->chunk, w->fill);
+			if (err) {
+				return err;
+			}
+			w->off += w->fill;
+			w->fill = 0;
+		}
+	}
+
+	return 0;
+}
+
+static int log_write_finish(struct log_writer *w)
+{
+	size_t len = ROUND_UP(w->fill, fcb.f_align);
+
+	if (len == 0) {
+		return 0;
+	}
+
+	memset(&w->chunk[w->fill], fcb.f_erase_value, len - w->fill);
+
+	return flash_area_write(fcb.fap, w->off, w->chunk, len);
+}
+
+/* Copies a live message to the active sector and updates its location */
+static int log_copy(struct outbox_msg *msg)
+{
+	struct log_writer w = { 0 };
+	struct fcb_entry loc;
+	uint8_t tmp[LOG_CHUNK_SIZE];
+	off_t src = FCB_ENTRY_FA_DATA_OFF(msg->loc);
+	size_t len = msg->loc.fe_data_len;
+	size_t n;
+	int err;
+
+	err = fcb_append(&fcb, len, &loc);
+	if (err) {
+		return err;
+	}
+
+	w.off = FCB_ENTRY_FA_DATA_OFF(loc);
+	for (size_t copied = 0; copied < len; copied += n) {
+		n = MIN(sizeof(tmp), len - copied);
+		err = flash_area_read(fcb.fap, src + copied, tmp, n);
+		if (err) {
+			return err;
+		}
+		err = log_write(&w, tmp, n);
+		if (err) {
+			return err;
+		}
+	}
+
+	err = log_write_finish(&w);
+	if (err) {
+		return err;
+	}
+
+	err = fcb_append_finish(&fcb, &loc);
+	if (!err) {
+		msg->loc = loc;
+	}
+
+	return err;
+}
+
+/* Frees the oldest sector, moving its live messages to the scratch sector first */
+static int log_compact(void)
+{
+	bool live = false;
+	int err;
+
+	for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if ((msgs[i].state & MSG_STATE_USED) && msgs[i].loc.fe_sector == fcb.f_oldest) {
+			live = true;
+			break;
+		}
+	}
+
+	if (live) {
+		err = fcb_append_to_scratch(&fcb);
+		if (err) {
+			return err;
+		}
+
+		for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+			if ((msgs[i].state & MSG_STATE_USED) &&
+			    msgs[i].loc.fe_sector == fcb.f_oldest) {
+				err = log_copy(&msgs[i]);
+				if (err) {
+					return err;
+				}
+			}
+		}
+	}
+
+	return fcb_rotate(&fcb);
+}
+
+static int log_append(const struct outbox_record *rec, const uint8_t *topic,
+		      const uint8_t *payload, struct fcb_entry *loc)
+{
+	struct log_writer w = { 0 };
+	size_t len = sizeof(*rec) + rec->topic_len + rec->payload_len;
+	int err;
+
+	/* Compacting every sector once frees all the space not used by live messages */
+	for (int i = 0; ; i++) {
+		err = fcb_append(&fcb, len, loc);
+		if (err != -ENOSPC || i == fcb.f_sector_cnt) {
+			break;
+		}
+
+		err = log_compact();
+		if (err) {
+			LOG_ERR("Log compaction failed, error: %d", err);
+			return err;
+		}
+	}
+
+	if (err) {
+		return err;
+	}
+
+	w.off = FCB_ENTRY_FA_DATA_OFF(*loc);
+	err = log_write(&w, rec, sizeof(*rec));
+	if (!err) {
+		err = log_write(&w, topic, rec->topic_len);
+	}
+	if (!err) {
+		err = log_write(&w, payload, rec->payload_len);
+	}
+	if (!err) {
+		err = log_write_finish(&w);
+	}
+	if (err) {
+		return err;
+	}
+
+	return fcb_append_finish(&fcb, loc);
+}
+
+static void msg_remove(struct outbox_msg *msg)
+{
+	struct outbox_record rec = {
+		.type = RECORD_DELETE,
+		.flags = msg_qos(msg),
+		.id = msg->id,
+	};
+	struct fcb_entry loc;
+	int err;
+
+	msg->state = 0;
+
+	/* If the record is lost, the message is sent again after a reboot */
+	err = log_append(&rec, NULL, NULL, &loc);
+	if (err) {
+		LOG_WRN("Failed to delete message %d from flash, error: %d", rec.id, err);
+	}
+}
+
+static int log_init(void)
+{
+	const struct flash_area *fa;
+	uint32_t sector_cnt = ARRAY_SIZE(sectors);
+	int err;
+
+	/* -ENOMEM if the area has more sectors than are used */
+	err = flash_area_get_sectors(OUTBOX_AREA_ID, &sector_cnt, sectors);
+	if (err && err != -ENOMEM) {
+		LOG_ERR("Failed to get the flash sectors, error: %d", err);
+		return err;
+	}
+
+	/* One sector is kept free for compaction */
+	if (sector_cnt < 2) {
+		LOG_ERR("At least two flash sectors are needed");
+		return -ENOSPC;
+	}
+
+	fcb.f_magic = OUTBOX_FCB_MAGIC;
+	fcb.f_version = OUTBOX_FCB_VERSION;
+	fcb.f_sector_cnt = sector_cnt;
+	fcb.f_scratch_cnt = 1;
+	fcb.f_sectors = sectors;
+
+	err = fcb_init(OUTBOX_AREA_ID, &fcb);
+	if (err) {
+		LOG_WRN("Outbox storage not valid, erasing");
+
+		err = flash_area_open(OUTBOX_AREA_ID, &fa);
+		if (err) {
+			return err;
+		}
+		err = flash_area_erase(fa, 0, fa->fa_size);
+		flash_area_close(fa);
+		if (err) {
+			return err;
+		}
+
+		err = fcb_init(OUTBOX_AREA_ID, &fcb);
+		if (err) {
+			LOG_ERR("Failed to initialize the outbox storage, error: %d", err);
+			return err;
+		}
+	}
+
+	if (LOG_CHUNK_SIZE % fcb.f_align) {
+		LOG_ERR("Flash write block size %d not supported", fcb.f_align);
+		return -ENOTSUP;
+	}
+
+	return 0;
+}
+
+/* Rebuilds the message index from the log, the later records win */
+static void log_load(void)
+{
+	struct fcb_entry loc = { 0 };
+	struct outbox_record rec;
+	struct outbox_msg *msg;
+	uint16_t id_max = 0;
+	int err;
+
+	while (fcb_getnext(&fcb, &loc) == 0) {
+		if (loc.fe_data_len < sizeof(rec)) {
+			continue;
+		}
+
+		err = flash_area_read(fcb.fap, FCB_ENTRY_FA_DATA_OFF(loc), &rec, sizeof(rec));
+		if (err) {
+			LOG_ERR("Failed to read the outbox storage, error: %d", err);
+			return;
+		}
+
+		msg = msg_find(rec.id, rec.flags & RECORD_QOS_MASK);
+
+		if (rec.type == RECORD_DELETE) {
+			if (msg) {
+				msg->state = 0;
+			}
+			continue;
+		}
+
+		if (rec.type != RECORD_MSG ||
+		    loc.fe_data_len != sizeof(rec) + rec.topic_len + rec.payload_len) {
+			continue;
+		}
+
+		if (!msg) {
+			msg = msg_alloc();
+		}
+		if (!msg) {
+			LOG_WRN("Outbox full, stored message %d skipped", rec.id);
+			continue;
+		}
+
+		msg_set(msg, &rec, &loc);
+
+		id_max = MAX(id_max, rec.id);
+		if ((int32_t)(rec.seq - next_seq) >= 0) {
+			next_seq = rec.seq + 1;
+		}
+	}
+
+	next_id = MAX(id_max + 1, 1);
+}
+
+static uint16_t id_next(uint8_t qos)
+{
+	uint16_t id;
+
+	do {
+		id = next_id++;
+		if (next_id == 0) {
+			next_id = 1;
+		}
+	} while (msg_find(id, qos));
+
+	return id;
+}
+
+static void policy_get(const struct mqtt_utf8 *topic, uint8_t *priority, uint32_t *ttl)
+{
+	const struct outbox_policy *policy = NULL;
+
+	for (int i = 0; i < ARRAY_SIZE(policies); i++) {
+		if (policies[i].topic && policies[i].topic_len <= topic->size &&
+		    memcmp(policies[i].topic, topic->utf8, policies[i].topic_len) == 0 &&
+		    (!policy || policies[i].topic_len > policy->topic_len)) {
+			policy = &policies[i];
+		}
+	}
+
+	*priority = policy ? policy->priority : MQTT_OUTBOX_PRIORITY_DEFAULT;
+	*ttl = policy ? policy->ttl : CONFIG_MQTT_OUTBOX_TTL;
+}
+
+/* Drops the oldest message of the lowest priority, unless all are more important */
+static int msg_drop(uint8_t priority)
+{
+	struct outbox_msg *victim = NULL;
+
+	for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if (!(msgs[i].state & MSG_STATE_USED) ||
+		    (msgs[i].state & (MSG_STATE_INFLIGHT | MSG_STATE_BATCH))) {
+			continue;
+		}
+		if (!victim || msgs[i].priority < victim->priority ||
+		    (msgs[i].priority == victim->priority &&
+		     (int32_t)(msgs[i].seq - victim->seq) < 0)) {
+			victim = &msgs[i];
+		}
+	}
+
+	if (!victim || victim->priority > priority) {
+		return -ENOMEM;
+	}
+
+	LOG_DBG("Outbox full, dropping message %d", victim->id);
+	stats.dropped++;
+	msg_remove(victim);
+
+	return 0;
+}
+
+static size_t publish_len(uint8_t flags, uint16_t topic_len, uint16_t payload_len)
+{
+	uint32_t remaining = 2 + topic_len + payload_len + ((flags & RECORD_QOS_MASK) ? 2 : 0);
+	size_t len = 1 + remaining;
+
+	do {
+		len++;
+		remaining >>= 7;
+	} while (remaining);
+
+	return len;
+}
+
+/* Encodes the PUBLISH packet up to the topic, returns the length */
+static size_t publish_header_encode(uint8_t *dst, uint8_t flags, bool dup, uint16_t topic_len,
+				    uint16_t payload_len)
+{
+	uint8_t qos = flags & RECORD_QOS_MASK;
+	uint32_t remaining = 2 + topic_len + payload_len + (qos ? 2 : 0);
+	size_t len = 0;
+
+	dst[len++] = PUBLISH_TYPE | (dup ? PUBLISH_DUP : 0) | (qos << 1) |
+		     ((flags & RECORD_RETAIN) ? PUBLISH_RETAIN : 0);
+	do {
+		dst[len] = remaining & 0x7f;
+		remaining >>= 7;
+		if (remaining) {
+			dst[len] |= 0x80;
+		}
+		len++;
+	} while (remaining);
+
+	sys_put_be16(topic_len, &dst[len]);
+
+	return len + 2;
+}
+
+/* Encodes a stored message, reading the topic and the payload from flash */
+static int msg_encode(const struct outbox_msg *msg, uint8_t *dst)
+{
+	off_t off = FCB_ENTRY_FA_DATA_OFF(msg->loc) + sizeof(struct outbox_record);
+	size_t len;
+	int err;
+
+	len = publish_header_encode(dst, msg->flags, msg->state & MSG_STATE_SENT, msg->topic_len,
+				    msg->payload_len);
+
+	err = flash_area_read(fcb.fap, off, &dst[len], msg->topic_len);
+	if (err) {
+		return err;
+	}
+	len += msg->topic_len;
+
+	if (msg_qos(msg)) {
+		sys_put_be16(msg->id, &dst[len]);
+		len += 2;
+	}
+
+	return flash_area_read(fcb.fap, off + msg->topic_len, &dst[len], msg->payload_len);
+}
+
+static int client_sock_get(const struct mqtt_client *c)
+{
+#if defined(CONFIG_MQTT_LIB_TLS)
+	if (c->transport.type == MQTT_TRANSPORT_SECURE) {
+		return c->transport.tls.sock;
+	}
+#endif
+	return c->transport.tcp.sock;
+}
+
+static int outbox_send(const uint8_t *data, size_t len)
+{
+	struct pollfd fds = {
+		.fd = sock,
+		.events = POLLOUT,
+	};
+	ssize_t ret;
+	int err = 0;
+
+	/* The MQTT client writes to the same socket, for example PINGREQ and PUBACK
+	 * packets or messages published directly. Holding its mutex keeps the
+	 * packets from being interleaved.
+	 *
+	 * This is a deliberate layering break: the mutex is a private field of the
+	 * MQTT client, and the socket is written past it. The public API writes one
+	 * packet per mqtt_publish() call and has no way to send a batch in one write,
+	 * which is what keeps the TCP segments large. The field must be revisited
+	 * when the MQTT client is updated.
+	 */
+	sys_mutex_lock(&client->internal.mutex, K_FOREVER);
+
+	while (len > 0) {
+		ret = send(sock, data, len, 0);
+		if (ret < 0) {
+			if (errno != EAGAIN) {
+				err = -errno;
+				break;
+			}
+
+			/* Non-blocking socket, wait for room in the send buffer */
+			ret = poll(&fds, 1, CONFIG_MQTT_OUTBOX_SEND_TIMEOUT);
+			if (ret == 0) {
+				err = -ETIMEDOUT;
+				break;
+			} else if (ret < 0) {
+				err = -errno;
+				break;
+			}
+			continue;
+		}
+
+		stats.writes++;
+		stats.bytes += ret;
+		data += ret;
+		len -= ret;
+	}
+
+	sys_mutex_unlock(&client->internal.mutex);
+
+	return err;
+}
+
+static void connection_lost(void)
+{
+	client = NULL;
+	sock = -1;
+	inflight = 0;
+
+	for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+		msgs[i].state &= ~(MSG_STATE_INFLIGHT | MSG_STATE_BATCH);
+	}
+}
+
+/* Messages sent before first, then by priority and age */
+static bool msg_before(const struct outbox_msg *a, const struct outbox_msg *b)
+{
+	if ((a->state & MSG_STATE_SENT) != (b->state & MSG_STATE_SENT)) {
+		return a->state & MSG_STATE_SENT;
+	}
+	if (a->priority != b->priority) {
+		return a->priority > b->priority;
+	}
+
+	return (int32_t)(a->seq - b->seq) < 0;
+}
+
+static struct outbox_msg *msg_next(void)
+{
+	int64_t now = k_uptime_get();
+	struct outbox_msg *next = NULL;
+	struct outbox_msg *msg;
+
+	for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+		msg = &msgs[i];
+
+		if (!(msg->state & MSG_STATE_USED) ||
+		    (msg->state & (MSG_STATE_INFLIGHT | MSG_STATE_BATCH))) {
+			continue;
+		}
+
+		if (msg->expiry && now >= msg->expiry) {
+			LOG_DBG("Message %d expired", msg->id);
+			stats.expired++;
+			msg_remove(msg);
+			continue;
+		}
+
+		if (msg_qos(msg) && inflight >= CONFIG_MQTT_OUTBOX_INFLIGHT_MAX) {
+			continue;
+		}
+
+		if (!next || msg_before(msg, next)) {
+			next = msg;
+		}
+	}
+
+	return next;
+}
+
+/* Sends the queued messages, as many as fit in the buffer at a time */
+static int outbox_flush(void)
+{
+	struct outbox_msg *msg;
+	size_t pkt_len;
+	size_t len;
+	int count;
+	int err;
+
+	while (sock >= 0) {
+		len = 0;
+		count = 0;
+
+		while ((msg = msg_next()) != NULL) {
+			pkt_len = publish_len(msg->flags, msg->topic_len, msg->payload_len);
+			if (len + pkt_len > sizeof(buf)) {
+				break;
+			}
+
+			err = msg_encode(msg, &buf[len]);
+			if (err) {
+				LOG_ERR("Failed to read message %d, error: %d", msg->id, err);
+				msg_remove(msg);
+				continue;
+			}
+
+			len += pkt_len;
+			count++;
+			msg->state |= MSG_STATE_BATCH;
+			if (msg_qos(msg)) {
+				inflight++;
+			}
+		}
+
+		if (count == 0) {
+			return 0;
+		}
+
+		err = outbox_send(buf, len);
+
+		for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+			msg = &msgs[i];
+			if (!(msg->state & MSG_STATE_BATCH)) {
+				continue;
+			}
+
+			msg->state &= ~MSG_STATE_BATCH;
+			if (msg_qos(msg)) {
+				if (!err && (msg->state & MSG_STATE_SENT)) {
+					stats.replayed++;
+				}
+				/* Possibly received by the broker if the write failed */
+				msg->state |= MSG_STATE_SENT | (err ? 0 : MSG_STATE_INFLIGHT);
+			} else if (!err) {
+				msg_remove(msg);
+			}
+		}
+
+		if (err) {
+			LOG_WRN("Failed to send queued messages, error: %d", err);
+			connection_lost();
+			return err;
+		}
+
+		LOG_DBG("Sent %d messages, %zu bytes", count, len);
+		stats.sent += count;
+	}
+
+	return 0;
+}
+
+/* Sends a QoS 0 message without storing it */
+static int publish_direct(const struct mqtt_publish_param *param, uint8_t flags)
+{
+	const struct mqtt_binstr *payload = &param->message.payload;
+	const struct mqtt_utf8 *topic = &param->message.topic.topic;
+	size_t len;
+	int err;
+
+	len = publish_header_encode(buf, flags, false, topic->size, payload->len);
+	memcpy(&buf[len], topic->utf8, topic->size);
+	len += topic->size;
+	memcpy(&buf[len], payload->data, payload->len);
+	len += payload->len;
+
+	err = outbox_send(buf, len);
+	if (err) {
+		LOG_WRN("Failed to send message, error: %d", err);
+		connection_lost();
+		return err;
+	}
+
+	stats.sent++;
+
+	return 0;
+}
+
+int mqtt_outbox_init(void)
+{
+	int err = 0;
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	if (initialized) {
+		goto unlock;
+	}
+
+	err = log_init();
+	if (err) {
+		goto unlock;
+	}
+
+	memset(msgs, 0, sizeof(msgs));
+	memset(&stats, 0, sizeof(stats));
+	sock = -1;
+	inflight = 0;
+	next_seq = 0;
+
+	log_load();
+	initialized = true;
+
+unlock:
+	k_mutex_unlock(&outbox_mutex);
+
+	return err;
+}
+
+void mqtt_outbox_uninit(void)
+{
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+	initialized = false;
+	connection_lost();
+	k_mutex_unlock(&outbox_mutex);
+}
+
+int mqtt_outbox_publish(const struct mqtt_publish_param *param)
+{
+	struct outbox_record rec = { .type = RECORD_MSG };
+	struct outbox_msg *msg;
+	struct fcb_entry loc;
+	uint8_t priority;
+	uint32_t ttl;
+	uint8_t qos;
+	int err;
+
+	if (!param || !param->message.topic.topic.utf8 || param->message.topic.topic.size == 0 ||
+	    (param->message.payload.len && !param->message.payload.data)) {
+		return -EINVAL;
+	}
+
+	qos = param->message.topic.qos;
+	if (qos > MQTT_QOS_1_AT_LEAST_ONCE) {
+		return -ENOTSUP;
+	}
+
+	if (param->message.topic.topic.size + param->message.payload.len >
+	    CONFIG_MQTT_OUTBOX_MSG_MAX_SIZE) {
+		return -EMSGSIZE;
+	}
+
+	rec.flags = qos | (param->retain_flag ? RECORD_RETAIN : 0);
+	rec.topic_len = param->message.topic.topic.size;
+	rec.payload_len = param->message.payload.len;
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	if (!initialized) {
+		err = -EACCES;
+		goto unlock;
+	}
+
+	if (qos == MQTT_QOS_0_AT_MOST_ONCE && sock >= 0) {
+		err = publish_direct(param, rec.flags);
+		if (!err) {
+			goto unlock;
+		}
+	}
+
+	if (qos == MQTT_QOS_1_AT_LEAST_ONCE && param->message_id) {
+		if (msg_find(param->message_id, qos)) {
+			err = -EEXIST;
+			goto unlock;
+		}
+		rec.id = param->message_id;
+	} else {
+		/* Also for QoS 0, the ID identifies the message in the log */
+		rec.id = id_next(qos);
+	}
+
+	policy_get(&param->message.topic.topic, &priority, &ttl);
+	rec.priority = priority;
+	rec.ttl = ttl;
+	rec.seq = next_seq;
+
+	msg = msg_alloc();
+	while (!msg) {
+		err = msg_drop(rec.priority);
+		if (err) {
+			goto unlock;
+		}
+		msg = msg_alloc();
+	}
+
+	err = log_append(&rec, param->message.topic.topic.utf8, param->message.payload.data,
+			 &loc);
+	while (err == -ENOSPC) {
+		err = msg_drop(rec.priority);
+		if (err) {
+			break;
+		}
+		err = log_append(&rec, param->message.topic.topic.utf8,
+				 param->message.payload.data, &loc);
+	}
+	if (err) {
+		LOG_ERR("Failed to store message %d, error: %d", rec.id, err);
+		goto unlock;
+	}
+
+	msg_set(msg, &rec, &loc);
+	next_seq++;
+
+	LOG_DBG("Stored message %d, QoS %d, %d bytes", rec.id, qos, rec.payload_len);
+
+	/* Message is stored, send errors are handled on the next connection */
+	(void)outbox_flush();
+
+unlock:
+	k_mutex_unlock(&outbox_mutex);
+
+	return err;
+}
+
+int mqtt_outbox_policy_set(const char *topic, uint8_t priority, uint32_t ttl)
+{
+	struct outbox_policy *policy = NULL;
+	int err = 0;
+
+	if (!topic || topic[0] == '\0') {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	for (int i = 0; i < ARRAY_SIZE(policies); i++) {
+		if (policies[i].topic && strcmp(policies[i].topic, topic) == 0) {
+			policy = &policies[i];
+			break;
+		}
+		if (!policies[i].topic && !policy) {
+			policy = &policies[i];
+		}
+	}
+
+	if (policy) {
+		policy->topic = topic;
+		policy->topic_len = strlen(topic);
+		policy->priority = priority;
+		policy->ttl = ttl;
+	} else {
+		err = -ENOMEM;
+	}
+
+	k_mutex_unlock(&outbox_mutex);
+
+	return err;
+}
+
+int mqtt_outbox_connected(struct mqtt_client *new_client)
+{
+	int err;
+
+	if (!new_client) {
+		return -EINVAL;
+	}
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	if (!initialized) {
+		err = -EACCES;
+		goto unlock;
+	}
+
+	/* Unacknowledged messages of the previous connection are sent again */
+	connection_lost();
+	client = new_client;
+	sock = client_sock_get(client);
+
+	err = outbox_flush();
+
+unlock:
+	k_mutex_unlock(&outbox_mutex);
+
+	return err;
+}
+
+void mqtt_outbox_disconnected(void)
+{
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+	connection_lost();
+	k_mutex_unlock(&outbox_mutex);
+}
+
+int mqtt_outbox_puback(uint16_t message_id)
+{
+	struct outbox_msg *msg;
+	int err = 0;
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	msg = initialized ? msg_find(message_id, MQTT_QOS_1_AT_LEAST_ONCE) : NULL;
+	if (!msg) {
+		err = -ENOENT;
+		goto unlock;
+	}
+
+	if (msg->state & MSG_STATE_INFLIGHT) {
+		inflight--;
+	}
+
+	stats.acked++;
+	msg_remove(msg);
+
+	/* Window is refilled once half empty, to send the messages in larger writes */
+	if (inflight <= CONFIG_MQTT_OUTBOX_INFLIGHT_MAX / 2) {
+		(void)outbox_flush();
+	}
+
+unlock:
+	k_mutex_unlock(&outbox_mutex);
+
+	return err;
+}
+
+int mqtt_outbox_flush(void)
+{
+	int err;
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	if (!initialized) {
+		err = -EACCES;
+	} else if (sock < 0) {
+		err = -ENOTCONN;
+	} else {
+		err = outbox_flush();
+	}
+
+	k_mutex_unlock(&outbox_mutex);
+
+	return err;
+}
+
+uint16_t mqtt_outbox_message_id_get(void)
+{
+	uint16_t id;
+
+	/* Same counter as the IDs assigned by the outbox, so that the messages
+	 * published directly do not collide with the stored ones.
+	 */
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+	id = id_next(MQTT_QOS_1_AT_LEAST_ONCE);
+	k_mutex_unlock(&outbox_mutex);
+
+	return id;
+}
+
+bool mqtt_outbox_message_id_used(uint16_t message_id)
+{
+	bool used;
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+	used = initialized && msg_find(message_id, MQTT_QOS_1_AT_LEAST_ONCE);
+	k_mutex_unlock(&outbox_mutex);
+
+	return used;
+}
+
+int mqtt_outbox_clear(void)
+{
+	int err;
+
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	if (!initialized) {
+		err = -EACCES;
+		goto unlock;
+	}
+
+	err = fcb_clear(&fcb);
+	memset(msgs, 0, sizeof(msgs));
+	memset(&stats, 0, sizeof(stats));
+	inflight = 0;
+	next_id = 1;
+
+unlock:
+	k_mutex_unlock(&outbox_mutex);
+
+	return err;
+}
+
+void mqtt_outbox_stats_get(struct mqtt_outbox_stats *out)
+{
+	k_mutex_lock(&outbox_mutex, K_FOREVER);
+
+	*out = stats;
+	out->stored = 0;
+	for (int i = 0; i < ARRAY_SIZE(msgs); i++) {
+		if (msgs[i].state & MSG_STATE_USED) {
+			out->stored++;
+		}
+	}
+
+	k_mutex_unlock(&outbox_mutex);
+}
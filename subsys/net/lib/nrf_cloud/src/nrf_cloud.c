@@ -50,6 +50,14 @@ enum nfsm_state nfsm_get_current_state(void)
 	return current_state;
 }
 
+/* With the MQTT outbox, device messages are also stored while disconnected */
+static bool dc_send_allowed(void)
+{
+	return (current_state == STATE_DC_CONNECTED) ||
+	       (IS_ENABLED(CONFIG_NRF_CLOUD_MQTT_OUTBOX) &&
+		(current_state >= STATE_INITIALIZED));
+}
+
 void nfsm_set_current_state_and_notify(enum nfsm_state state,
 				       const struct nrf_cloud_evt *evt)
 {
@@ -291,7 +299,7 @@ int nrf_cloud_sensor_data_send(const struct nrf_cloud_sensor_data *param)
 	int err;
 	struct nct_dc_data sensor_data;
 
-	if (current_state != STATE_DC_CONNECTED) {
+	if (!dc_send_allowed()) {
 		return -EACCES;
 	}
 
@@ -321,7 +329,7 @@ int nrf_cloud_sensor_data_stream(const struct nrf_cloud_sensor_data *param)
 	int err;
 	struct nct_dc_data sensor_data;
 
-	if (current_state != STATE_DC_CONNECTED) {
+	if (!dc_send_allowed()) {
 		return -EACCES;
 	}
 
@@ -369,7 +377,7 @@ int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
 		break;
 	}
 	case NRF_CLOUD_TOPIC_MESSAGE: {
-		if (current_state != STATE_DC_CONNECTED) {
+		if (!dc_send_allowed()) {
 			return -EACCES;
 		}
 		const struct nct_dc_data buf = {
@@ -391,7 +399,7 @@ int nrf_cloud_send(const struct nrf_cloud_tx_data *msg)
 		break;
 	}
 	case NRF_CLOUD_TOPIC_BULK: {
-		if (current_state != STATE_DC_CONNECTED) {
+		if (!dc_send_allowed()) {
 			return -EACCES;
 		}
 		const struct nct_dc_data buf = {
@@ -45,6 +45,286 @@ static atomic_t request_in_progress;
 static int64_t last_request_timestamp;
 #endif
 
+#define AGPS_SV_COUNT 32
+
+/* Bit of the satellite in the masks, 0 for an invalid satellite ID */
+static uint32_t sv_bit(uint8_t sv_id)
+{
+	if ((sv_id == 0) || (sv_id > AGPS_SV_COUNT)) {
+		return 0;
+	}
+
+	return BIT(sv_id - 1);
+}
+
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+#define AGPS_CACHE_SV_COUNT AGPS_SV_COUNT
+
+/* Ephemerides or almanacs of the satellites. Satellites missing from the last set
+ * received from the cloud are marked absent, and not requested again while the set
+ * is valid. Filtered ephemerides are never marked absent.
+ */
+struct cache_sv_set {
+	uint32_t stored;
+	uint32_t absent;
+	uint32_t time[AGPS_CACHE_SV_COUNT];
+};
+
+/* Elements are stored in the format written to the GNSS, with the uptime in seconds
+ * when they were received. The cache is protected by processed_lock.
+ */
+static struct {
+	struct cache_sv_set ephe_set;
+	struct cache_sv_set alm_set;
+	uint32_t data_flags;
+	uint32_t utc_time;
+	uint32_t klobuchar_time;
+	uint32_t location_time;
+	uint32_t integrity_time;
+	struct nrf_modem_gnss_agps_data_ephemeris ephe[AGPS_CACHE_SV_COUNT];
+	struct nrf_modem_gnss_agps_data_almanac alm[AGPS_CACHE_SV_COUNT];
+	struct nrf_modem_gnss_agps_data_utc utc;
+	struct nrf_modem_gnss_agps_data_klobuchar klobuchar;
+	struct nrf_modem_gnss_agps_data_location location;
+	struct nrf_modem_gnss_agps_data_integrity integrity;
+} cache;
+
+/* Elements requested with a flag in data_flags. System time and TOWs are not cached. */
+static const struct cache_entry {
+	uint32_t flag;
+	uint16_t type;
+	void *data;
+	size_t size;
+	uint32_t *time;
+	uint32_t validity;
+} cache_entries[] = {
+	{ NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST, NRF_MODEM_GNSS_AGPS_UTC_PARAMETERS,
+	  &cache.utc, sizeof(cache.utc), &cache.utc_time,
+	  CONFIG_NRF_CLOUD_AGPS_CACHE_ALM_VALIDITY },
+	{ NRF_MODEM_GNSS_AGPS_KLOBUCHAR_REQUEST,
+	  NRF_MODEM_GNSS_AGPS_KLOBUCHAR_IONOSPHERIC_CORRECTION,
+	  &cache.klobuchar, sizeof(cache.klobuchar), &cache.klobuchar_time,
+	  CONFIG_NRF_CLOUD_AGPS_CACHE_IONO_VALIDITY },
+	{ NRF_MODEM_GNSS_AGPS_POSITION_REQUEST, NRF_MODEM_GNSS_AGPS_LOCATION,
+	  &cache.location, sizeof(cache.location), &cache.location_time,
+	  CONFIG_NRF_CLOUD_AGPS_CACHE_LOCATION_VALIDITY },
+	{ NRF_MODEM_GNSS_AGPS_INTEGRITY_REQUEST, NRF_MODEM_GNSS_AGPS_INTEGRITY,
+	  &cache.integrity, sizeof(cache.integrity), &cache.integrity_time,
+	  CONFIG_NRF_CLOUD_AGPS_CACHE_LOCATION_VALIDITY },
+};
+
+static struct nrf_cloud_agps_cache_stats cache_stats;
+
+/* Set while predicted P-GPS data is processed. It is not what the cloud sent as A-GPS
+ * data, so it is not stored. Protected by agps_injection_active.
+ */
+static bool cache_skip;
+
+static uint32_t cache_now(void)
+{
+	return (uint32_t)(k_uptime_get() / MSEC_PER_SEC);
+}
+
+static bool cache_valid(uint32_t time, uint32_t validity, uint32_t now)
+{
+	return (now - time) < (validity * SEC_PER_MIN);
+}
+
+static void cache_sv_store(struct cache_sv_set *set, void *data, const void *src, size_t size,
+			   uint8_t sv_id)
+{
+	if (!sv_bit(sv_id)) {
+		return;
+	}
+
+	memcpy((uint8_t *)data + (sv_id - 1) * size, src, size);
+	set->time[sv_id - 1] = cache_now();
+	set->stored |= BIT(sv_id - 1);
+	set->absent &= ~BIT(sv_id - 1);
+	cache_stats.stored++;
+}
+
+static void cache_store(const void *data, size_t data_len, uint16_t type)
+{
+	const struct nrf_modem_gnss_agps_data_ephemeris *ephe = data;
+	const struct nrf_modem_gnss_agps_data_almanac *alm = data;
+
+	if (type == NRF_MODEM_GNSS_AGPS_EPHEMERIDES) {
+		cache_sv_store(&cache.ephe_set, cache.ephe, ephe, sizeof(*ephe), ephe->sv_id);
+		return;
+	} else if (type == NRF_MODEM_GNSS_AGPS_ALMANAC) {
+		cache_sv_store(&cache.alm_set, cache.alm, alm, sizeof(*alm), alm->sv_id);
+		return;
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(cache_entries); i++) {
+		const struct cache_entry *entry = &cache_entries[i];
+
+		if (entry->type == type) {
+			memcpy(entry->data, data, MIN(data_len, entry->size));
+			*entry->time = cache_now();
+			cache.data_flags |= entry->flag;
+			cache_stats.stored++;
+			return;
+		}
+	}
+}
+
+/* Marks the satellites not in a set received from the cloud as absent. */
+static void cache_sv_absent_mark(struct cache_sv_set *set, uint32_t received)
+{
+	uint32_t now = cache_now();
+
+	for (size_t i = 0; i < AGPS_CACHE_SV_COUNT; i++) {
+		if (!(received & BIT(i))) {
+			set->time[i] = now;
+			set->stored &= ~BIT(i);
+			set->absent |= BIT(i);
+		}
+	}
+}
+
+/* Called after a response is processed, with the satellites it contained. */
+static void cache_absent_mark(const struct nrf_modem_gnss_agps_data_frame *received)
+{
+	k_mutex_lock(&processed_lock, K_FOREVER);
+	/* A filtered response leaves out the ephemerides of the satellites below the
+	 * elevation mask, they are not absent from the constellation.
+	 */
+	if (received->sv_mask_ephe && !IS_ENABLED(CONFIG_NRF_CLOUD_AGPS_FILTERED)) {
+		cache_sv_absent_mark(&cache.ephe_set, received->sv_mask_ephe);
+	}
+	if (received->sv_mask_alm) {
+		cache_sv_absent_mark(&cache.alm_set, received->sv_mask_alm);
+	}
+	k_mutex_unlock(&processed_lock);
+}
+
+static int cache_write(void *data, size_t data_len, uint16_t type)
+{
+	int err = nrf_modem_gnss_agps_write(data, data_len, type);
+
+	if (!err) {
+		cache_stats.injected++;
+		cache_stats.injected_bytes += data_len;
+	}
+
+	return err;
+}
+
+/* Injects the valid data of the requested satellites and clears them from the mask. */
+static int cache_sv_inject(const struct cache_sv_set *set, uint32_t validity, void *data,
+			   size_t size, uint16_t type, uint32_t *mask, uint32_t *processed_mask)
+{
+	uint32_t now = cache_now();
+	uint32_t requested = *mask;
+	int injected = 0;
+	int err;
+
+	for (size_t i = 0; i < AGPS_CACHE_SV_COUNT; i++) {
+		if (!(requested & BIT(i))) {
+			continue;
+		}
+		if (!((set->stored | set->absent) & BIT(i)) ||
+		    !cache_valid(set->time[i], validity, now)) {
+			cache_stats.missed++;
+			continue;
+		}
+
+		if (set->stored & BIT(i)) {
+			err = cache_write((uint8_t *)data + i * size, size, type);
+			if (err) {
+				return err;
+			}
+			*processed_mask |= BIT(i);
+			injected++;
+		}
+		*mask &= ~BIT(i);
+	}
+
+	return injected;
+}
+
+int nrf_cloud_agps_cache_inject(struct nrf_modem_gnss_agps_data_frame *request)
+{
+	int injected = 0;
+	int err;
+	uint32_t now;
+
+	if (!request) {
+		return -EINVAL;
+	}
+
+	k_sem_take(&agps_injection_active, K_FOREVER);
+	k_mutex_lock(&processed_lock, K_FOREVER);
+
+	err = cache_sv_inject(&cache.ephe_set, CONFIG_NRF_CLOUD_AGPS_CACHE_EPHE_VALIDITY,
+			      cache.ephe, sizeof(cache.ephe[0]), NRF_MODEM_GNSS_AGPS_EPHEMERIDES,
+			      &request->sv_mask_ephe, &processed.sv_mask_ephe);
+	if (err < 0) {
+		goto unlock;
+	}
+	injected += err;
+
+	err = cache_sv_inject(&cache.alm_set, CONFIG_NRF_CLOUD_AGPS_CACHE_ALM_VALIDITY,
+			      cache.alm, sizeof(cache.alm[0]), NRF_MODEM_GNSS_AGPS_ALMANAC,
+			      &request->sv_mask_alm, &processed.sv_mask_alm);
+	if (err < 0) {
+		goto unlock;
+	}
+	injected += err;
+
+	now = cache_now();
+	for (size_t i = 0; i < ARRAY_SIZE(cache_entries); i++) {
+		const struct cache_entry *entry = &cache_entries[i];
+
+		if (!(request->data_flags & entry->flag)) {
+			continue;
+		}
+		if (!(cache.data_flags & entry->flag) ||
+		    !cache_valid(*entry->time, entry->validity, now)) {
+			cache_stats.missed++;
+			continue;
+		}
+
+		err = cache_write(entry->data, entry->size, entry->type);
+		if (err) {
+			goto unlock;
+		}
+		request->data_flags &= ~entry->flag;
+		processed.data_flags |= entry->flag;
+		injected++;
+	}
+
+	err = injected;
+	LOG_DBG("%d A-GPS elements injected from cache", injected);
+
+unlock:
+	k_mutex_unlock(&processed_lock);
+	k_sem_give(&agps_injection_active);
+
+	return err;
+}
+
+void nrf_cloud_agps_cache_clear(void)
+{
+	k_mutex_lock(&processed_lock, K_FOREVER);
+	memset(&cache.ephe_set, 0, sizeof(cache.ephe_set));
+	memset(&cache.alm_set, 0, sizeof(cache.alm_set));
+	cache.data_flags = 0;
+	k_mutex_unlock(&processed_lock);
+}
+
+void nrf_cloud_agps_cache_stats_get(struct nrf_cloud_agps_cache_stats *stats)
+{
+	if (stats) {
+		k_mutex_lock(&processed_lock, K_FOREVER);
+		*stats = cache_stats;
+		k_mutex_unlock(&processed_lock);
+	}
+}
+#endif /* CONFIG_NRF_CLOUD_AGPS_CACHE */
+
 void agps_print_enable(bool enable)
 {
 	agps_print_enabled = enable;
@@ -89,10 +369,6 @@ static int json_add_types_array(cJSON * const obj, enum nrf_cloud_agps_type *typ
 int nrf_cloud_agps_request(const struct nrf_modem_gnss_agps_data_frame *request)
 {
 #if IS_ENABLED(CONFIG_NRF_CLOUD_MQTT)
-	if (nfsm_get_current_state() != STATE_DC_CONNECTED) {
-		return -EACCES;
-	}
-
 	int err;
 	enum nrf_cloud_agps_type types[9];
 	size_t type_count = 0;
@@ -106,6 +382,26 @@ int nrf_cloud_agps_request(const struct nrf_modem_gnss_agps_data_frame *request)
 	memset(&processed, 0, sizeof(processed));
 	k_mutex_unlock(&processed_lock);
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	/* Only request what the cache cannot provide, also when not connected */
+	struct nrf_modem_gnss_agps_data_frame missing = *request;
+
+	err = nrf_cloud_agps_cache_inject(&missing);
+	if (err < 0) {
+		LOG_WRN("Failed to inject cached A-GPS data, error: %d", err);
+	}
+	request = &missing;
+
+	if (!request->sv_mask_ephe && !request->sv_mask_alm && !request->data_flags) {
+		LOG_DBG("All requested A-GPS data injected from cache");
+		return 0;
+	}
+#endif
+
+	if (nfsm_get_current_state() != STATE_DC_CONNECTED) {
+		return -EACCES;
+	}
+
 	if (request->data_flags & NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST) {
 		types[type_count++] = NRF_CLOUD_AGPS_UTC_PARAMETERS;
 	}
@@ -242,7 +538,15 @@ static int send_to_modem(void *data, size_t data_len, uint16_t type)
 		agps_print(type, data);
 	}
 
-	return nrf_modem_gnss_agps_write(data, data_len, type);
+	int err = nrf_modem_gnss_agps_write(data, data_len, type);
+
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	if (!err && !cache_skip) {
+		cache_store(data, data_len, type);
+	}
+#endif
+
+	return err;
 }
 
 static int copy_utc(struct nrf_modem_gnss_agps_data_utc *dst,
@@ -412,7 +716,7 @@ static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data)
 	case NRF_CLOUD_AGPS_EPHEMERIDES: {
 		struct nrf_modem_gnss_agps_data_ephemeris ephemeris;
 
-		processed.sv_mask_ephe |= (1 << (agps_data->ephemeris->sv_id - 1));
+		processed.sv_mask_ephe |= sv_bit(agps_data->ephemeris->sv_id);
 #if defined(CONFIG_NRF_CLOUD_PGPS)
 		if (agps_data->ephemeris->health ==
 		    NRF_CLOUD_PGPS_EMPTY_EPHEM_HEALTH) {
@@ -431,7 +735,7 @@ static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data)
 	case NRF_CLOUD_AGPS_ALMANAC: {
 		struct nrf_modem_gnss_agps_data_almanac almanac;
 
-		processed.sv_mask_alm |= (1 << (agps_data->almanac->sv_id - 1));
+		processed.sv_mask_alm |= sv_bit(agps_data->almanac->sv_id);
 		copy_almanac(&almanac, agps_data);
 		LOG_DBG("A-GPS type: NRF_CLOUD_AGPS_ALMANAC %d",
 			agps_data->almanac->sv_id);
@@ -478,7 +782,7 @@ static int agps_send_to_modem(struct nrf_cloud_apgs_element *agps_data)
 
 		processed.data_flags |= NRF_MODEM_GNSS_AGPS_INTEGRITY_REQUEST;
 		return send_to_modem(agps_data->integrity,
-				     sizeof(agps_data->integrity),
+				     sizeof(*agps_data->integrity),
 				     NRF_MODEM_GNSS_AGPS_INTEGRITY);
 	default:
 		LOG_WRN("Unknown AGPS data type: %d", agps_data->type);
@@ -558,7 +862,8 @@ static size_t get_next_agps_element(struct nrf_cloud_apgs_element *element,
 	return len;
 }
 
-int nrf_cloud_agps_process(const char *buf, size_t buf_len)
+/* P-GPS injects its predictions with store set to false */
+int agps_process(const char *buf, size_t buf_len, bool store)
 {
 	int err;
 	struct nrf_cloud_apgs_element element = {0};
@@ -569,6 +874,9 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len)
 #if defined(CONFIG_NRF_CLOUD_AGPS_FILTERED)
 	bool ephemerides_processed = false;
 #endif
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	struct nrf_modem_gnss_agps_data_frame received = {0};
+#endif
 
 	if (!buf || (buf_len == 0)) {
 		return -EINVAL;
@@ -607,6 +915,15 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len)
 
 	LOG_DBG("A-GPS_injection_active LOCKED");
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	cache_skip = !store;
+	if (store) {
+		cache_stats.processed_bytes += buf_len;
+	}
+#else
+	ARG_UNUSED(store);
+#endif
+
 	while (parsed_len < buf_len) {
 		size_t element_size =
 			get_next_agps_element(&element, &buf[parsed_len]);
@@ -638,9 +955,14 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len)
 			LOG_DBG("TOWs copied, bitmask: 0x%08x",
 				sys_time.sv_mask);
 			element.time_and_tow = &sys_time;
-#if defined(CONFIG_NRF_CLOUD_AGPS_FILTERED)
 		} else if (element.type == NRF_CLOUD_AGPS_EPHEMERIDES) {
+#if defined(CONFIG_NRF_CLOUD_AGPS_FILTERED)
 			ephemerides_processed = true;
+#endif
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+			received.sv_mask_ephe |= sv_bit(element.ephemeris->sv_id);
+		} else if (element.type == NRF_CLOUD_AGPS_ALMANAC) {
+			received.sv_mask_alm |= sv_bit(element.almanac->sv_id);
 #endif
 		}
 
@@ -667,12 +989,24 @@ int nrf_cloud_agps_process(const char *buf, size_t buf_len)
 	}
 #endif
 
+#if defined(CONFIG_NRF_CLOUD_AGPS_CACHE)
+	if (!err && store) {
+		cache_absent_mark(&received);
+	}
+	cache_skip = false;
+#endif
+
 	LOG_DBG("A-GPS_inject_active UNLOCKED");
 	k_sem_give(&agps_injection_active);
 
 	return err;
 }
 
+int nrf_cloud_agps_process(const char *buf, size_t buf_len)
+{
+	return agps_process(buf, buf_len, true);
+}
+
 void nrf_cloud_agps_processed(struct nrf_modem_gnss_agps_data_frame *received_elements)
 {
 	if (received_elements) {
@@ -42,12 +42,21 @@ LOG_MODULE_REGISTER(nrf_cloud_pgps, CONFIG_NRF_CLOUD_GPS_LOG_LEVEL);
 #define LOCATION_UNC_SEMIMINOR_K	89U
 #define LOCATION_CONFIDENCE_PERCENT	68U
 
+/* Downloaded prediction up to the ephemerides, without the schema version */
+#define PREDICTION_HEAD_SIZE		(offsetof(struct nrf_cloud_pgps_prediction, ephemerii) - \
+					 PGPS_SCHEMA_SIZE)
+#define PREDICTION_SCHEMA_OFFSET	offsetof(struct nrf_cloud_pgps_prediction, schema_version)
+#define EPHEMERIS_SIZE			sizeof(struct nrf_cloud_agps_ephemeris)
+
 BUILD_ASSERT(((NUM_PREDICTIONS & 1) == 0),
 	 "NUM_PREDICTIONS must be even");
 BUILD_ASSERT(((REPLACEMENT_THRESHOLD & 1) == 0),
 	 "REPLACEMENT_THRESHOLD must be even");
 BUILD_ASSERT((NUM_PREDICTIONS != REPLACEMENT_THRESHOLD),
 	 "NUM_PREDICTIONS and REPLACEMENT_THRESHOLD cannot be equal");
+BUILD_ASSERT((PGPS_PREDICTION_DL_SIZE ==
+	      (PREDICTION_HEAD_SIZE + NRF_CLOUD_PGPS_NUM_SV * EPHEMERIS_SIZE)),
+	 "Unexpected prediction layout");
 
 enum pgps_state {
 	PGPS_NONE,
@@ -79,6 +88,8 @@ struct pgps_index {
 
 	/* array of pointers to predictions, in sorted time order */
 	struct nrf_cloud_pgps_prediction *predictions[NUM_PREDICTIONS];
+	/* predictions fully validated since they were stored or loaded */
+	bool validated[NUM_PREDICTIONS];
 };
 
 static struct pgps_index index;
@@ -91,7 +102,13 @@ static struct stream_flash_ctx stream;
 static uint8_t *write_buf;
 static uint32_t flash_page_size;
 
-static uint8_t prediction_buf[PGPS_PREDICTION_STORAGE_SIZE];
+/* prediction being downloaded; only the parts split between fragments are copied */
+static struct {
+	uint8_t head[PREDICTION_HEAD_SIZE];
+	uint8_t ephemeris[EPHEMERIS_SIZE];
+	int64_t gps_sec;
+	bool skip;
+} dl_pred;
 static bool ignore_packets;
 static atomic_t pgps_need_assistance;
 
@@ -99,13 +116,15 @@ static int validate_stored_predictions(uint16_t *bad_day, uint32_t *bad_time);
 static void log_pgps_header(const char *msg, const struct nrf_cloud_pgps_header *header);
 static int consume_pgps_header(const char *buf, size_t buf_len);
 static void cache_pgps_header(const struct nrf_cloud_pgps_header *header);
-static int consume_pgps_data(uint8_t pnum, const char *buf, size_t buf_len);
+static int consume_pgps_data(const uint8_t *buf, size_t len);
 static void prediction_work_handler(struct k_work *work);
 static void prediction_timer_handler(struct k_timer *dummy);
 void agps_print_enable(bool enable);
+int agps_process(const char *buf, size_t buf_len, bool store);
 static void print_time_details(const char *info,
 			       int64_t sec, uint16_t day, uint32_t time_of_day);
 static int pgps_request(const struct gps_pgps_request *request);
+static int pgps_request_range(const struct gps_pgps_request *request, uint8_t pnum_offset);
 static int pgps_request_all(void);
 
 K_WORK_DEFINE(prediction_work, prediction_work_handler);
@@ -234,12 +253,11 @@ static int validate_prediction(const struct nrf_cloud_pgps_prediction *p,
 static int validate_stored_predictions(uint16_t *first_bad_day,
 				       uint32_t *first_bad_time)
 {
-	int err;
 	int i;
 	uint16_t count = index.header.prediction_count;
 	uint16_t period_min = index.header.prediction_period_min;
-	uint16_t gps_day = index.header.gps_day;
-	uint32_t gps_time_of_day = index.header.gps_time_of_day;
+	uint16_t gps_day;
+	uint32_t gps_time_of_day;
 	uint8_t *p = storage;
 	struct nrf_cloud_pgps_prediction *pred;
 	int64_t start_gps_sec = index.start_sec;
@@ -249,6 +267,7 @@ static int validate_stored_predictions(uint16_t *first_bad_day,
 	/* reset catalog of predictions */
 	for (pnum = 0; pnum < count; pnum++) {
 		index.predictions[pnum] = NULL;
+		index.validated[pnum] = false;
 	}
 
 	npgps_reset_block_pool();
@@ -271,7 +290,10 @@ static int validate_stored_predictions(uint16_t *first_bad_day,
 		p += PGPS_PREDICTION_STORAGE_SIZE;
 	}
 
-	/* validate predictions in time order, independent of storage order */
+	/* check predictions in time order, independent of storage order;
+	 * the sentinel is written last, so a matching one means the prediction
+	 * was stored completely; the full validation is done on first use
+	 */
 	i = -1;
 	for (pnum = 0; pnum < count; pnum++) {
 		/* calculate expected time signature */
@@ -287,12 +309,10 @@ static int validate_stored_predictions(uint16_t *first_bad_day,
 			break;
 		}
 
-		err = validate_prediction(pred, gps_day, gps_time_of_day,
-					  period_min, true, false);
-		if (err) {
+		if (pred->sentinel != (uint32_t)gps_sec) {
 			LOG_ERR("Prediction num:%u, gps_day:%u, "
-				"gps_time_of_day:%u is bad:%d; loc:%p",
-				pnum, gps_day, gps_time_of_day, err, pred);
+				"gps_time_of_day:%u is incomplete; loc:%p",
+				pnum, gps_day, gps_time_of_day, pred);
 			/* request partial data; download interrupted? */
 			*first_bad_day = gps_day;
 			*first_bad_time = gps_time_of_day;
@@ -336,6 +356,63 @@ static void get_prediction_day_time(int pnum, int64_t *gps_sec, uint16_t *gps_da
 	}
 }
 
+/* requests a single prediction, to replace one that was discarded */
+static int pgps_request_prediction(int pnum)
+{
+	struct gps_pgps_request request;
+	uint16_t gps_day;
+	uint32_t gps_time_of_day;
+
+	get_prediction_day_time(pnum, NULL, &gps_day, &gps_time_of_day);
+
+	request.gps_day = gps_day;
+	request.gps_time_of_day = gps_time_of_day;
+	request.prediction_count = 1;
+	request.prediction_period_min = index.header.prediction_period_min;
+
+	LOG_INF("Requesting replacement for prediction num:%d", pnum);
+	return pgps_request_range(&request, pnum);
+}
+
+/* validates a prediction on first use; the result is kept until it is replaced */
+static struct nrf_cloud_pgps_prediction *prediction_get(int pnum)
+{
+	struct nrf_cloud_pgps_prediction *pred = index.predictions[pnum];
+	uint16_t gps_day;
+	uint32_t gps_time_of_day;
+	int block;
+	int err;
+
+	if ((pred == NULL) || index.validated[pnum]) {
+		return pred;
+	}
+
+	get_prediction_day_time(pnum, NULL, &gps_day, &gps_time_of_day);
+	if (validate_prediction(pred, gps_day, gps_time_of_day,
+				index.header.prediction_period_min, true, false)) {
+		if (nrf_cloud_pgps_loading()) {
+			/* may not be flushed to flash yet */
+			return NULL;
+		}
+		LOG_ERR("Prediction num:%d is bad; discarding", pnum);
+		block = npgps_pointer_to_block((uint8_t *)pred);
+		if (block != NO_BLOCK) {
+			npgps_free_block(block);
+		}
+		index.predictions[pnum] = NULL;
+
+		/* the replacement is stored in the block just freed */
+		err = pgps_request_prediction(pnum);
+		if (err) {
+			LOG_ERR("Error requesting prediction num:%d: %d", pnum, err);
+		}
+		return NULL;
+	}
+
+	index.validated[pnum] = true;
+	return pred;
+}
+
 static void discard_oldest_predictions(int num)
 {
 	int i;
@@ -360,6 +437,7 @@ static void discard_oldest_predictions(int num)
 	for (i = last; i < index.header.prediction_count; i++) {
 		pnum = i - last;
 		index.predictions[pnum] = index.predictions[i];
+		index.validated[pnum] = index.validated[i];
 	}
 
 	/* set prediction pointers for 'last' in the newly empty
@@ -368,6 +446,7 @@ static void discard_oldest_predictions(int num)
 	for (pnum = index.header.prediction_count - last; pnum <
 	      index.header.prediction_count; pnum++) {
 		index.predictions[pnum] = NULL;
+		index.validated[pnum] = false;
 	}
 	npgps_print_blocks();
 
@@ -503,6 +582,7 @@ int nrf_cloud_pgps_find_prediction(struct nrf_cloud_pgps_prediction **prediction
 {
 	int64_t cur_gps_sec;
 	int64_t offset_sec;
+	int64_t pred_sec;
 	int64_t start_sec = index.start_sec;
 	int64_t end_sec = index.end_sec;
 	uint16_t cur_gps_day;
@@ -584,16 +664,19 @@ int nrf_cloud_pgps_find_prediction(struct nrf_cloud_pgps_prediction **prediction
 
 	LOG_INF("Selected prediction num:%d", pnum);
 	index.cur_pnum = pnum;
-	*prediction = index.predictions[pnum];
+	*prediction = prediction_get(pnum);
 	if (*prediction) {
-		err = validate_prediction(*prediction,
-					  cur_gps_day, cur_gps_time_of_day,
-					  period_min, false, margin);
-		if (!err) {
-			start_expiration_timer(pnum, cur_gps_sec);
-			return pnum;
+		/* the prediction's own time was validated against the index */
+		get_prediction_day_time(pnum, &pred_sec, NULL, NULL);
+		if ((cur_gps_sec < pred_sec) ||
+		    (cur_gps_sec > (pred_sec + period_min * SEC_PER_MIN +
+				    (margin ? PGPS_MARGIN_SEC : 0)))) {
+			LOG_ERR("prediction does not contain desired time; "
+				"start:%d, cur:%d", (int32_t)pred_sec, (int32_t)cur_gps_sec);
+			return -EINVAL;
 		}
-		return err;
+		start_expiration_timer(pnum, cur_gps_sec);
+		return pnum;
 	}
 	if (nrf_cloud_pgps_loading()) {
 		LOG_WRN("Prediction num:%u not loaded yet", pnum);
@@ -638,6 +721,14 @@ void nrf_cloud_pgps_request_reset(void)
 #endif
 
 static int pgps_request(const struct gps_pgps_request *request)
+{
+	/* partial requests are for the predictions at the end of the set */
+	return pgps_request_range(request,
+				  index.header.prediction_count - request->prediction_count);
+}
+
+/* the requested predictions are stored starting at pnum_offset */
+static int pgps_request_range(const struct gps_pgps_request *request, uint8_t pnum_offset)
 {
 	if (state == PGPS_NONE) {
 		LOG_ERR("P-GPS subsystem is not initialized.");
@@ -651,8 +742,7 @@ static int pgps_request(const struct gps_pgps_request *request)
 
 	if (request->prediction_count < index.header.prediction_count) {
 		index.partial_request = true;
-		index.pnum_offset = index.header.prediction_count -
-				    request->prediction_count;
+		index.pnum_offset = pnum_offset;
 	} else {
 		index.partial_request = false;
 		index.pnum_offset = 0;
@@ -899,9 +989,8 @@ int nrf_cloud_pgps_inject(struct nrf_cloud_pgps_prediction *p,
 				day, sec);
 
 			/* send time */
-			err = nrf_cloud_agps_process((const char *)&sys_time,
-						     sizeof(sys_time) -
-						     sizeof(sys_time.time.sv_tow));
+			err = agps_process((const char *)&sys_time,
+					   sizeof(sys_time) - sizeof(sys_time.time.sv_tow), false);
 			if (err) {
 				LOG_ERR("Error injecting P-GPS sys_time (%u, %u): %d",
 					sys_time.time.date_day, sys_time.time.time_full_s,
@@ -939,7 +1028,7 @@ int nrf_cloud_pgps_inject(struct nrf_cloud_pgps_prediction *p,
 			saved_location->longitude);
 		/* send location */
 
-		err = nrf_cloud_agps_process((const char *)&location, sizeof(location));
+		err = agps_process((const char *)&location, sizeof(location), false);
 		if (err) {
 			LOG_ERR("Error injecting P-GPS location (%d, %d): %d",
 				location.location.latitude, location.location.longitude,
@@ -956,11 +1045,11 @@ int nrf_cloud_pgps_inject(struct nrf_cloud_pgps_prediction *p,
 		LOG_INF("GPS unit needs ephemerides. Injecting %u.", p->ephemeris_count);
 
 		/* send ephemerii */
-		err = nrf_cloud_agps_process((const char *)&p->schema_version,
-					     sizeof(p->schema_version) +
-					     sizeof(p->ephemeris_type) +
-					     sizeof(p->ephemeris_count) +
-					     sizeof(p->ephemerii));
+		err = agps_process((const char *)&p->schema_version,
+				   sizeof(p->schema_version) +
+				   sizeof(p->ephemeris_type) +
+				   sizeof(p->ephemeris_count) +
+				   sizeof(p->ephemerii), false);
 		if (err) {
 			LOG_ERR("Error injecting ephermerii:%d", err);
 			ret = err;
@@ -1001,7 +1090,7 @@ void *flash_callback;
 static int open_storage(uint32_t offset, bool preserve)
 {
 	int err;
-	const struct device *flash_dev = DEVICE_DT_GET(DT_NODELABEL(flash_controller));
+	const struct device *flash_dev = DEVICE_DT_GET(DT_CHOSEN(zephyr_flash_controller));
 	uint32_t block_offset = 0;
 
 	LOG_DBG("storage name: %s", flash_dev->name);
@@ -1043,48 +1132,6 @@ static int open_storage(uint32_t offset, bool preserve)
 	return err;
 }
 
-static int store_prediction(uint8_t *p, size_t len, uint32_t sentinel, bool last)
-{
-	static bool first = true;
-	static uint8_t pad[PGPS_PREDICTION_PAD];
-	int err;
-	uint8_t schema = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
-	size_t schema_offset = ((size_t) &((struct nrf_cloud_pgps_prediction *)0)->schema_version);
-
-	if (first) {
-		memset(pad, 0xff, PGPS_PREDICTION_PAD);
-		first = false;
-	}
-
-	err = stream_flash_buffered_write(&stream, p, schema_offset, false);
-	if (err) {
-		LOG_ERR("Error writing pgps prediction:%d", err);
-		return err;
-	}
-	p += schema_offset;
-	len -= schema_offset;
-	err = stream_flash_buffered_write(&stream, &schema, sizeof(schema), false);
-	if (err) {
-		LOG_ERR("Error writing schema:%d", err);
-		return err;
-	}
-	err = stream_flash_buffered_write(&stream, p, len, false);
-	if (err) {
-		LOG_ERR("Error writing pgps prediction:%d", err);
-		return err;
-	}
-	err = stream_flash_buffered_write(&stream, (uint8_t *)&sentinel,
-					  sizeof(sentinel), false);
-	if (err) {
-		LOG_ERR("Error writing sentinel:%d", err);
-	}
-	err = stream_flash_buffered_write(&stream, pad, PGPS_PREDICTION_PAD, last);
-	if (err) {
-		LOG_ERR("Error writing sentinel:%d", err);
-	}
-	return err;
-}
-
 static int flush_storage(void)
 {
 	return stream_flash_buffered_write(&stream, NULL, 0, true);
@@ -1093,7 +1140,6 @@ static int flush_storage(void)
 static int process_buffer(uint8_t *buf, size_t len)
 {
 	int err;
-	size_t need;
 	int64_t gps_sec;
 
 	if (index.dl_offset == 0) {
@@ -1147,31 +1193,7 @@ static int process_buffer(uint8_t *buf, size_t len)
 		index.pred_offset = 0;
 	}
 
-	need = MIN((PGPS_PREDICTION_DL_SIZE - index.pred_offset), len);
-	memcpy(&prediction_buf[index.pred_offset], buf, need);
-	LOG_DBG("need:%zd bytes; pred_offset:%u, fragment len:%zd, dl_ofs:%zd",
-		need, index.pred_offset, len, index.dl_offset);
-	len -= need;
-	buf += need;
-	index.pred_offset += need;
-	index.dl_offset += need;
-
-	if (index.pred_offset == PGPS_PREDICTION_DL_SIZE) {
-		LOG_DBG("consuming data prediction num:%u, remainder:%zd",
-			index.dl_pnum, len);
-		err = consume_pgps_data(index.dl_pnum, prediction_buf,
-					PGPS_PREDICTION_DL_SIZE);
-		if (err) {
-			return err;
-		}
-		if (len) { /* keep extra data for next time */
-			memcpy(prediction_buf, buf, len);
-		}
-		index.pred_offset = len;
-		index.dl_pnum++;
-	}
-	index.dl_offset += len;
-	return 0;
+	return consume_pgps_data(buf, len);
 }
 
 static int consume_pgps_header(const char *buf, size_t buf_len)
@@ -1206,178 +1228,230 @@ static void cache_pgps_header(const struct nrf_cloud_pgps_header *header)
 			index.period_sec * index.header.prediction_count;
 }
 
-static size_t get_next_pgps_element(struct nrf_cloud_apgs_element *element,
-				    const char *buf)
+/* The head of a prediction holds its time and the header of the ephemeris array;
+ * once it is complete, the prediction is either stored or skipped as a whole.
+ */
+static int consume_prediction_head(uint8_t pnum)
 {
-	static uint16_t elements_left_to_process;
-	static enum nrf_cloud_agps_type element_type;
-	size_t len = 0;
+	/* the downloaded prediction matches the stored one up to the schema version */
+	const struct nrf_cloud_pgps_prediction *p =
+		(const struct nrf_cloud_pgps_prediction *)dl_pred.head;
+	const struct agps_header *ephem =
+		(const struct agps_header *)&dl_pred.head[PREDICTION_SCHEMA_OFFSET];
+	uint8_t schema = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+	int err;
 
-	/* Check if there are more elements left in the array to process.
-	 * The element type is only given once before the array, and not for
-	 * each element.
-	 */
-	if (elements_left_to_process == 0) {
-		element->type = (enum nrf_cloud_agps_type)
-				buf[NRF_CLOUD_AGPS_BIN_TYPE_OFFSET];
-		element_type = element->type;
-		elements_left_to_process =
-			*(uint16_t *)&buf[NRF_CLOUD_AGPS_BIN_COUNT_OFFSET] - 1;
-		len += NRF_CLOUD_AGPS_BIN_TYPE_SIZE +
-			NRF_CLOUD_AGPS_BIN_COUNT_SIZE;
+	LOG_DBG("Parsing prediction num:%u, idx:%u, type:%u, count:%u",
+		pnum, index.loading_count, p->time_type, p->time_count);
+
+	if ((p->time_type != NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK) || (p->time_count != 1) ||
+	    (ephem->type != NRF_CLOUD_AGPS_EPHEMERIDES) ||
+	    (ephem->count != NRF_CLOUD_PGPS_NUM_SV)) {
+		LOG_ERR("Parsing prediction num:%u failed; aborting.", pnum);
+		LOG_HEXDUMP_DBG(dl_pred.head, PREDICTION_HEAD_SIZE, "bad data");
+		state = PGPS_NONE;
+		return -EINVAL;
+	}
+
+	dl_pred.gps_sec = npgps_gps_day_time_to_sec(p->time.date_day, p->time.time_full_s);
+	dl_pred.skip = true;
+
+	if (pnum >= NUM_PREDICTIONS) {
+		LOG_WRN("Received extra prediction num:%u; ignoring", pnum);
+	} else if (index.predictions[pnum]) {
+		LOG_WRN("Received duplicate packet; ignoring");
+	} else if (dl_pred.gps_sec == 0) {
+		LOG_ERR("Prediction did not include GPS day and time of day; ignoring");
 	} else {
-		element->type = element_type;
-		elements_left_to_process -= 1;
-	}
-
-	switch (element->type) {
-	case NRF_CLOUD_AGPS_EPHEMERIDES:
-		element->ephemeris = (struct nrf_cloud_agps_ephemeris *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_ephemeris);
-		break;
-	case NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK:
-		element->time_and_tow =
-			(struct nrf_cloud_agps_system_time *)(buf + len);
-		len += sizeof(struct nrf_cloud_agps_system_time) -
-			sizeof(element->time_and_tow->sv_tow) + 4;
-		break;
-	default:
-		LOG_DBG("Unhandled P-GPS data type:%d", element->type);
+		dl_pred.skip = false;
+	}
+	if (dl_pred.skip) {
 		return 0;
 	}
 
-#if PGPS_DEBUG
-	LOG_DBG("  size:%zd, count:%u", len, elements_left_to_process);
-#endif
-	return len;
+	err = stream_flash_buffered_write(&stream, dl_pred.head, PREDICTION_SCHEMA_OFFSET,
+					  false);
+	if (!err) {
+		err = stream_flash_buffered_write(&stream, &schema, sizeof(schema), false);
+	}
+	if (!err) {
+		err = stream_flash_buffered_write(&stream, &dl_pred.head[PREDICTION_SCHEMA_OFFSET],
+						  PREDICTION_HEAD_SIZE - PREDICTION_SCHEMA_OFFSET,
+						  false);
+	}
+	if (err) {
+		LOG_ERR("Error writing pgps prediction:%d", err);
+	}
+	return err;
 }
 
-static int consume_pgps_data(uint8_t pnum, const char *buf, size_t buf_len)
+static int store_ephemeris(const uint8_t *buf)
 {
-	struct nrf_cloud_apgs_element element = {};
-	uint8_t *prediction_ptr = (uint8_t *)buf;
-	uint8_t *element_ptr = prediction_ptr;
-	struct agps_header *elem = (struct agps_header *)element_ptr;
-	size_t parsed_len = 0;
-	int64_t gps_sec;
-	bool finished = false;
+	struct nrf_cloud_agps_ephemeris ephemeris;
+	int err;
 
-	gps_sec = 0;
+	if (dl_pred.skip) {
+		return 0;
+	}
 
-	LOG_DBG("Parsing prediction num:%u, idx:%u, type:%u, count:%u, buf len:%u",
-		pnum, index.loading_count, elem->type, elem->count, buf_len);
+	/* check for all zeros except first byte (sv_id) */
+	for (int i = 1; i < EPHEMERIS_SIZE; i++) {
+		if (buf[i] != 0) {
+			err = stream_flash_buffered_write(&stream, buf, EPHEMERIS_SIZE, false);
+			goto done;
+		}
+	}
 
-	while (parsed_len < buf_len) {
-		bool empty;
-		size_t element_size = get_next_pgps_element(&element, element_ptr);
+	memcpy(&ephemeris, buf, sizeof(ephemeris));
+	LOG_INF("Marking ephemeris:%u as empty", ephemeris.sv_id);
+	ephemeris.health = NRF_CLOUD_PGPS_EMPTY_EPHEM_HEALTH;
+	err = stream_flash_buffered_write(&stream, (uint8_t *)&ephemeris, sizeof(ephemeris),
+					  false);
 
-		if (element_size == 0) {
-			LOG_INF("  End of element");
-			break;
-		}
-		switch (element.type) {
-		case NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK:
-			gps_sec = npgps_gps_day_time_to_sec(element.time_and_tow->date_day,
-							    element.time_and_tow->time_full_s);
-			break;
-		case NRF_CLOUD_AGPS_EPHEMERIDES:
-			/* check for all zeros except first byte (sv_id) */
-			empty = true;
-			for (int i = 1; i < sizeof(struct nrf_cloud_agps_ephemeris); i++) {
-				if (element_ptr[i] != 0) {
-					empty = false;
-					break;
-				}
-			}
-			if (empty) {
-				LOG_INF("Marking ephemeris:%u as empty",
-					element.ephemeris->sv_id);
-				element.ephemeris->health = NRF_CLOUD_PGPS_EMPTY_EPHEM_HEALTH;
-			}
-			break;
-		default: /* just store */
-			break;
-		}
+done:
+	if (err) {
+		LOG_ERR("Error writing pgps prediction:%d", err);
+	}
+	return err;
+}
+
+static int finish_prediction(uint8_t pnum)
+{
+	static bool first = true;
+	static uint8_t pad[PGPS_PREDICTION_PAD];
+	uint32_t sentinel = (uint32_t)dl_pred.gps_sec;
+	bool finished;
+	int err;
 
-		parsed_len += element_size;
-		element_ptr += element_size;
+	if (dl_pred.skip) {
+		return 0;
 	}
 
-	if (parsed_len == buf_len) {
-		LOG_DBG("Parsing finished");
+	if (first) {
+		memset(pad, 0xff, PGPS_PREDICTION_PAD);
+		first = false;
+	}
 
-		if (index.predictions[pnum]) {
-			LOG_WRN("Received duplicate packet; ignoring");
-		} else if (gps_sec == 0) {
-			LOG_ERR("Prediction did not include GPS day and time of day; ignoring");
-			LOG_HEXDUMP_DBG(prediction_ptr, buf_len, "bad data");
-		} else {
-			int err;
+	LOG_INF("Storing prediction num:%u idx:%u for gps sec:%d",
+		pnum, index.loading_count, (int32_t)dl_pred.gps_sec);
 
-			LOG_INF("Storing prediction num:%u idx:%u for gps sec:%d",
-				pnum, index.loading_count, (int32_t)gps_sec);
+	index.loading_count++;
+	finished = (index.loading_count == index.expected_count);
 
-			index.loading_count++;
-			finished = (index.loading_count == index.expected_count);
-			store_prediction(prediction_ptr, buf_len, (uint32_t)gps_sec,
-					 finished || (index.storage_extent == 1));
-			index.predictions[pnum] = npgps_block_to_pointer(index.store_block);
+	/* the sentinel is written last and marks the prediction as complete */
+	err = stream_flash_buffered_write(&stream, (uint8_t *)&sentinel,
+					  sizeof(sentinel), false);
+	if (!err) {
+		err = stream_flash_buffered_write(&stream, pad, PGPS_PREDICTION_PAD,
+						  finished || (index.storage_extent == 1));
+	}
+	if (err) {
+		LOG_ERR("Error writing sentinel:%d", err);
+		return err;
+	}
+	index.predictions[pnum] = npgps_block_to_pointer(index.store_block);
+	index.validated[pnum] = false;
 
-			if (pgps_need_assistance &&
-			    (finished || (index.loading_count > 1))) {
-				nrf_cloud_pgps_notify_prediction();
-			}
+	if (pgps_need_assistance &&
+	    (finished || (index.loading_count > 1))) {
+		nrf_cloud_pgps_notify_prediction();
+	}
 
-			if (!finished) {
-				if (evt_handler) {
-					struct nrf_cloud_pgps_event evt = {
-						.type = PGPS_EVT_LOADING,
-					};
+	if (!finished) {
+		if (evt_handler) {
+			struct nrf_cloud_pgps_event evt = {
+				.type = PGPS_EVT_LOADING,
+			};
 
-					evt_handler(&evt);
-				}
+			evt_handler(&evt);
+		}
+	} else {
+		LOG_INF("All P-GPS data received. Done.");
+		state = PGPS_READY;
+		if (evt_handler) {
+			struct nrf_cloud_pgps_event evt = {
+				.type = PGPS_EVT_READY,
+				.prediction = NULL
+			};
+
+			evt_handler(&evt);
+		}
+		npgps_print_blocks();
+		return 0;
+	}
+
+	index.store_block = npgps_alloc_block();
+	if (index.store_block == NO_BLOCK) {
+		LOG_ERR("No more free blocks!");
+		return -ENOMEM;
+	}
+	index.storage_extent--;
+	if (index.storage_extent == 0) {
+		index.storage_extent = npgps_get_block_extent(index.store_block);
+		LOG_INF("Moving to new flash region:%d, len:%d",
+			index.store_block, index.storage_extent);
+		err = flush_storage();
+		if (err) {
+			LOG_ERR("Error flushing storage:%d", err);
+			return err;
+		}
+		err = open_storage(npgps_block_to_offset(index.store_block), false);
+		if (err) {
+			LOG_ERR("Error opening storage again:%d", err);
+			return err;
+		}
+	}
+
+	return 0;
+}
+
+/* Predictions are written to flash straight from the download fragments;
+ * only the head of a prediction and an ephemeris split between two fragments
+ * are copied.
+ */
+static int consume_pgps_data(const uint8_t *buf, size_t len)
+{
+	size_t ephem_offset;
+	size_t n;
+	int err = 0;
+
+	while (len > 0) {
+		if (index.pred_offset < PREDICTION_HEAD_SIZE) {
+			n = MIN(len, PREDICTION_HEAD_SIZE - index.pred_offset);
+			memcpy(&dl_pred.head[index.pred_offset], buf, n);
+			if ((index.pred_offset + n) == PREDICTION_HEAD_SIZE) {
+				err = consume_prediction_head(index.dl_pnum);
+			}
+		} else {
+			ephem_offset = (index.pred_offset - PREDICTION_HEAD_SIZE) % EPHEMERIS_SIZE;
+			if ((ephem_offset == 0) && (len >= EPHEMERIS_SIZE)) {
+				n = EPHEMERIS_SIZE;
+				err = store_ephemeris(buf);
 			} else {
-				LOG_INF("All P-GPS data received. Done.");
-				state = PGPS_READY;
-				if (evt_handler) {
-					struct nrf_cloud_pgps_event evt = {
-						.type = PGPS_EVT_READY,
-						.prediction = NULL
-					};
-
-					evt_handler(&evt);
+				n = MIN(len, EPHEMERIS_SIZE - ephem_offset);
+				memcpy(&dl_pred.ephemeris[ephem_offset], buf, n);
+				if ((ephem_offset + n) == EPHEMERIS_SIZE) {
+					err = store_ephemeris(dl_pred.ephemeris);
 				}
-				npgps_print_blocks();
-				return 0;
 			}
+		}
+		if (err) {
+			return err;
+		}
 
-			index.store_block = npgps_alloc_block();
-			if (index.store_block == NO_BLOCK) {
-				LOG_ERR("No more free blocks!");
-				return -ENOMEM;
-			}
-			index.storage_extent--;
-			if (index.storage_extent == 0) {
-				index.storage_extent = npgps_get_block_extent(index.store_block);
-				LOG_INF("Moving to new flash region:%d, len:%d",
-					index.store_block, index.storage_extent);
-				err = flush_storage();
-				if (err) {
-					LOG_ERR("Error flushing storage:%d", err);
-					return err;
-				}
-				err = open_storage(npgps_block_to_offset(index.store_block),
-						   false);
-				if (err) {
-					LOG_ERR("Error opening storage again:%d", err);
-					return err;
-				}
+		buf += n;
+		len -= n;
+		index.pred_offset += n;
+		index.dl_offset += n;
+
+		if (index.pred_offset == PGPS_PREDICTION_DL_SIZE) {
+			err = finish_prediction(index.dl_pnum);
+			if (err) {
+				return err;
 			}
+			index.pred_offset = 0;
+			index.dl_pnum++;
 		}
-	} else {
-		LOG_ERR("Parsing incomplete; aborting.");
-		state = PGPS_NONE;
-		return -EINVAL;
 	}
 
 	return 0;
@@ -1430,10 +1504,12 @@ int nrf_cloud_pgps_process(const char *buf, size_t buf_len)
 		index.period_sec =
 			index.header.prediction_period_min * SEC_PER_MIN;
 		memset(index.predictions, 0, sizeof(index.predictions));
+		memset(index.validated, 0, sizeof(index.validated));
 	} else {
 		for (pnum = index.pnum_offset;
 		     pnum < index.expected_count + index.pnum_offset; pnum++) {
 			index.predictions[pnum] = NULL;
+			index.validated[pnum] = false;
 		}
 	}
 	index.loading_count = 0;
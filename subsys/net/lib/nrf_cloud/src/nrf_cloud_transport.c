@@ -10,6 +10,9 @@
 #if defined(CONFIG_NRF_CLOUD_FOTA)
 #include "nrf_cloud_fota.h"
 #endif
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+#include <net/mqtt_outbox.h>
+#endif
 
 #include <zephyr/kernel.h>
 #include <stdio.h>
@@ -94,6 +97,14 @@ static char *shadow_get_topic;
 static bool mqtt_client_initialized;
 static bool persistent_session;
 
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+/* Device message topics of the last connection, the messages sent while
+ * disconnected are stored in the outbox with them.
+ */
+static struct mqtt_utf8 outbox_tx_endp;
+static struct mqtt_utf8 outbox_bulk_endp;
+#endif
+
 #define NCT_RX_LIST 0
 #define NCT_TX_LIST 1
 
@@ -155,15 +166,28 @@ static void dc_endpoint_reset(void)
 	nct.dc_bulk_endp.size = 0;
 }
 
+static bool message_id_stored(uint16_t message_id)
+{
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+	/* Messages stored in the outbox keep their IDs across reconnects and reboots */
+	return mqtt_outbox_message_id_used(message_id);
+#else
+	ARG_UNUSED(message_id);
+	return false;
+#endif
+}
+
 /* Get the next unused message id. */
 static uint16_t get_next_message_id(void)
 {
-	if (nct.message_id < NCT_MSG_ID_INCREMENT_BEGIN ||
-	    nct.message_id == NCT_MSG_ID_INCREMENT_END) {
-		nct.message_id = NCT_MSG_ID_INCREMENT_BEGIN;
-	} else {
-		++nct.message_id;
-	}
+	do {
+		if (nct.message_id < NCT_MSG_ID_INCREMENT_BEGIN ||
+		    nct.message_id == NCT_MSG_ID_INCREMENT_END) {
+			nct.message_id = NCT_MSG_ID_INCREMENT_BEGIN;
+		} else {
+			++nct.message_id;
+		}
+	} while (message_id_stored(nct.message_id));
 
 	return nct.message_id;
 }
@@ -205,17 +229,82 @@ static void dc_endpoint_free(void)
 #endif
 }
 
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+static void outbox_endp_save(struct mqtt_utf8 *saved, const struct mqtt_utf8 *endp)
+{
+	uint8_t *copy;
+
+	if (endp->utf8 == NULL) {
+		return;
+	}
+
+	copy = nrf_cloud_malloc(endp->size);
+	if (copy == NULL) {
+		LOG_WRN("Failed to save topic for the outbox");
+		return;
+	}
+
+	memcpy(copy, endp->utf8, endp->size);
+	if (saved->utf8 != NULL) {
+		nrf_cloud_free((void *)saved->utf8);
+	}
+	saved->utf8 = copy;
+	saved->size = endp->size;
+}
+
+static void outbox_endp_free(struct mqtt_utf8 *saved)
+{
+	if (saved->utf8 != NULL) {
+		nrf_cloud_free((void *)saved->utf8);
+	}
+	saved->utf8 = NULL;
+	saved->size = 0;
+}
+#endif /* CONFIG_NRF_CLOUD_MQTT_OUTBOX */
+
+/* Topic of the device messages, the one of the last connection while disconnected */
+static const struct mqtt_utf8 *dc_tx_topic_get(bool bulk)
+{
+	const struct mqtt_utf8 *endp = bulk ? &nct.dc_bulk_endp : &nct.dc_tx_endp;
+
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+	if (endp->utf8 == NULL) {
+		endp = bulk ? &outbox_bulk_endp : &outbox_tx_endp;
+	}
+#endif
+	return endp;
+}
+
+static int dc_publish(const struct mqtt_publish_param *publish)
+{
+	if (publish->message.topic.topic.utf8 == NULL) {
+		return -ENOTCONN;
+	}
+
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+	int err = mqtt_outbox_publish(publish);
+
+	if (err != -EMSGSIZE) {
+		return err;
+	}
+
+	/* Too large for the outbox, only sent when connected */
+#endif
+	return mqtt_publish(&nct.client, publish);
+}
+
 static uint32_t dc_send(const struct nct_dc_data *dc_data, uint8_t qos)
 {
 	if (dc_data == NULL) {
 		return -EINVAL;
 	}
 
+	const struct mqtt_utf8 *topic = dc_tx_topic_get(false);
 	struct mqtt_publish_param publish = {
 		.message_id = 0,
 		.message.topic.qos = qos,
-		.message.topic.topic.size = nct.dc_tx_endp.size,
-		.message.topic.topic.utf8 = nct.dc_tx_endp.utf8,
+		.message.topic.topic.size = topic->size,
+		.message.topic.topic.utf8 = topic->utf8,
 	};
 
 	/* Populate payload. */
@@ -228,7 +317,7 @@ static uint32_t dc_send(const struct nct_dc_data *dc_data, uint8_t qos)
 		publish.message_id = get_message_id(dc_data->message_id);
 	}
 
-	return mqtt_publish(&nct.client, &publish);
+	return dc_publish(&publish);
 }
 
 static int bulk_send(const struct nct_dc_data *dc_data, enum mqtt_qos qos)
@@ -243,10 +332,11 @@ static int bulk_send(const struct nct_dc_data *dc_data, enum mqtt_qos qos)
 		return -EINVAL;
 	}
 
+	const struct mqtt_utf8 *topic = dc_tx_topic_get(true);
 	struct mqtt_publish_param publish = {
 		.message.topic.qos = qos,
-		.message.topic.topic.size = nct.dc_bulk_endp.size,
-		.message.topic.topic.utf8 = nct.dc_bulk_endp.utf8,
+		.message.topic.topic.size = topic->size,
+		.message.topic.topic.utf8 = topic->utf8,
 	};
 
 	/* Populate payload. */
@@ -261,7 +351,7 @@ static int bulk_send(const struct nct_dc_data *dc_data, enum mqtt_qos qos)
 		publish.message_id = get_message_id(dc_data->message_id);
 	}
 
-	return mqtt_publish(&nct.client, &publish);
+	return dc_publish(&publish);
 }
 
 static bool strings_compare(const char *s1, const char *s2, uint32_t s1_len,
@@ -966,6 +1056,13 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 				LOG_ERR("Failed to save session state: %d",
 					err);
 			}
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+			/* Send the messages stored while disconnected */
+			err = mqtt_outbox_connected(&nct.client);
+			if (err) {
+				LOG_ERR("Failed to send stored messages: %d", err);
+			}
+#endif
 #if defined(CONFIG_NRF_CLOUD_FOTA)
 			err = nrf_cloud_fota_subscribe();
 			if (err) {
@@ -988,6 +1085,9 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 		LOG_DBG("MQTT_EVT_PUBACK: id = %d result = %d",
 			_mqtt_evt->param.puback.message_id, _mqtt_evt->result);
 
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+		(void)mqtt_outbox_puback(_mqtt_evt->param.puback.message_id);
+#endif
 		evt.type = NCT_EVT_CC_TX_DATA_ACK;
 		evt.param.message_id = _mqtt_evt->param.puback.message_id;
 		event_notify = true;
@@ -1003,6 +1103,9 @@ static void nct_mqtt_evt_handler(struct mqtt_client *const mqtt_client,
 	case MQTT_EVT_DISCONNECT: {
 		LOG_DBG("MQTT_EVT_DISCONNECT: result = %d", _mqtt_evt->result);
 
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+		mqtt_outbox_disconnected();
+#endif
 		evt.type = NCT_EVT_DISCONNECTED;
 		event_notify = true;
 		break;
@@ -1046,6 +1149,14 @@ int nct_init(const char * const client_id)
 		return err;
 	}
 
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+	err = mqtt_outbox_init();
+	if (err) {
+		LOG_ERR("Failed to initialize the MQTT outbox: %d", err);
+		return err;
+	}
+#endif
+
 	dc_endpoint_reset();
 
 	err = nct_topics_populate();
@@ -1061,6 +1172,10 @@ void nct_uninit(void)
 	LOG_DBG("Uninitializing nRF Cloud transport");
 	dc_endpoint_free();
 	nct_reset_topics();
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+	outbox_endp_free(&outbox_tx_endp);
+	outbox_endp_free(&outbox_bulk_endp);
+#endif
 
 	if (client_id_buf) {
 		nrf_cloud_free(client_id_buf);
@@ -1252,6 +1367,11 @@ void nct_dc_endpoint_set(const struct nrf_cloud_data *tx_endp,
 	nct.dc_bulk_endp.utf8 = (const uint8_t *)bulk_endp->ptr;
 	nct.dc_bulk_endp.size = bulk_endp->len;
 
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+	outbox_endp_save(&outbox_tx_endp, &nct.dc_tx_endp);
+	outbox_endp_save(&outbox_bulk_endp, &nct.dc_bulk_endp);
+#endif
+
 	if (m_endp != NULL) {
 		nct.dc_m_endp.utf8 = (const uint8_t *)m_endp->ptr;
 		nct.dc_m_endp.size = m_endp->len;
@@ -1360,6 +1480,10 @@ int nct_disconnect(void)
 {
 	LOG_DBG("nct_disconnect");
 
+#if defined(CONFIG_NRF_CLOUD_MQTT_OUTBOX)
+	/* No more writes to the socket before it is closed */
+	mqtt_outbox_disconnected();
+#endif
 	dc_endpoint_free();
 	return mqtt_disconnect(&nct.client);
 }
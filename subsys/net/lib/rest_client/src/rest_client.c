@@ -26,6 +26,13 @@
 
 #include <net/rest_client.h>
 
+#if defined(CONFIG_REST_CLIENT_POOL)
+#include "rest_client_pool.h"
+#endif
+#if defined(CONFIG_REST_CLIENT_DNS_CACHE)
+#include "rest_client_dns_cache.h"
+#endif
+
 LOG_MODULE_REGISTER(rest_client, CONFIG_REST_CLIENT_LOG_LEVEL);
 
 #define HTTP_PROTOCOL "HTTP/1.1"
@@ -145,16 +152,11 @@ static int rest_client_sckt_timeouts_set(int fd, int32_t timeout_ms)
 	return 0;
 }
 
-static int rest_client_sckt_connect(int *const fd,
-				    const char *const hostname,
-				    const uint16_t port_num,
-				    const sec_tag_t sec_tag,
-				    int tls_peer_verify,
-				    int32_t timeout_ms)
+static int rest_client_addr_get(const char *const hostname, const uint16_t port_num,
+				struct sockaddr *addr, socklen_t *addrlen)
 {
 	int ret;
 	struct addrinfo *addr_info;
-	char peer_addr[INET6_ADDRSTRLEN];
 	char portstr[6] = { 0 };
 	struct addrinfo hints = {
 		.ai_flags = AI_NUMERICSERV, /* Let getaddrinfo() set port to addrinfo */
@@ -162,11 +164,13 @@ static int rest_client_sckt_connect(int *const fd,
 		.ai_socktype = SOCK_STREAM,
 		.ai_next = NULL,
 	};
-	struct sockaddr *sa;
-	int proto = 0;
 
-	/* Make sure fd is always initialized when this function is called */
-	*fd = -1;
+#if defined(CONFIG_REST_CLIENT_DNS_CACHE)
+	if (rest_client_dns_cache_get(hostname, port_num, addr, addrlen) == 0) {
+		LOG_DBG("Address of %s found in DNS cache", log_strdup(hostname));
+		return 0;
+	}
+#endif
 
 	snprintf(portstr, 6, "%d", port_num);
 
@@ -180,15 +184,50 @@ static int rest_client_sckt_connect(int *const fd,
 		return -EFAULT;
 	}
 
-	sa = addr_info->ai_addr;
-	inet_ntop(sa->sa_family,
-		  (void *)&((struct sockaddr_in *)sa)->sin_addr,
+	if (addr_info->ai_addrlen > sizeof(*addr)) {
+		LOG_ERR("Unsupported address length: %d", addr_info->ai_addrlen);
+		freeaddrinfo(addr_info);
+		return -EFAULT;
+	}
+	memcpy(addr, addr_info->ai_addr, addr_info->ai_addrlen);
+	*addrlen = addr_info->ai_addrlen;
+	freeaddrinfo(addr_info);
+
+#if defined(CONFIG_REST_CLIENT_DNS_CACHE)
+	rest_client_dns_cache_put(hostname, port_num, addr, *addrlen);
+#endif
+	return 0;
+}
+
+static int rest_client_sckt_connect(int *const fd,
+				    const char *const hostname,
+				    const uint16_t port_num,
+				    const sec_tag_t sec_tag,
+				    int tls_peer_verify,
+				    int32_t timeout_ms)
+{
+	int ret;
+	struct sockaddr addr;
+	socklen_t addrlen;
+	char peer_addr[INET6_ADDRSTRLEN];
+	int proto = 0;
+
+	/* Make sure fd is always initialized when this function is called */
+	*fd = -1;
+
+	ret = rest_client_addr_get(hostname, port_num, &addr, &addrlen);
+	if (ret) {
+		return ret;
+	}
+
+	inet_ntop(addr.sa_family,
+		  (void *)&((struct sockaddr_in *)&addr)->sin_addr,
 		  peer_addr,
 		  INET6_ADDRSTRLEN);
 	LOG_DBG("getaddrinfo() %s", log_strdup(peer_addr));
 
 	proto = (sec_tag == REST_CLIENT_SEC_TAG_NO_SEC) ? IPPROTO_TCP : IPPROTO_TLS_1_2;
-	*fd = socket(addr_info->ai_family, SOCK_STREAM, proto);
+	*fd = socket(addr.sa_family, SOCK_STREAM, proto);
 	if (*fd == -1) {
 		LOG_ERR("Failed to open socket, error: %d", errno);
 		ret = -ENOTCONN;
@@ -210,11 +249,11 @@ static int rest_client_sckt_connect(int *const fd,
 		goto clean_up;
 	}
 
-	LOG_DBG("Connecting to %s port %s",
+	LOG_DBG("Connecting to %s port %d",
 		log_strdup(hostname),
-		log_strdup(portstr));
+		port_num);
 
-	ret = connect(*fd, addr_info->ai_addr, addr_info->ai_addrlen);
+	ret = connect(*fd, &addr, addrlen);
 	if (ret) {
 		LOG_ERR("Failed to connect socket, error: %d", errno);
 		if (errno == ETIMEDOUT) {
@@ -222,12 +261,15 @@ static int rest_client_sckt_connect(int *const fd,
 		} else {
 			ret = -ECONNREFUSED;
 		}
+#if defined(CONFIG_REST_CLIENT_DNS_CACHE)
+		/* Resolve the address again next time, in case it has changed */
+		rest_client_dns_cache_remove(hostname, port_num);
+#endif
 		goto clean_up;
 	}
 
 clean_up:
 
-	freeaddrinfo(addr_info);
 	if (ret) {
 		if (*fd > -1) {
 			(void)close(*fd);
@@ -239,11 +281,19 @@ clean_up:
 }
 
 static void rest_client_close_connection(struct rest_client_req_context *const req_ctx,
-					 struct rest_client_resp_context *const resp_ctx)
+					 struct rest_client_resp_context *const resp_ctx,
+					 bool reusable)
 {
 	int ret;
 
 	if (!req_ctx->keep_alive) {
+#if defined(CONFIG_REST_CLIENT_POOL)
+		if (reusable) {
+			rest_client_pool_put(req_ctx, req_ctx->connect_socket);
+			req_ctx->connect_socket = REST_CLIENT_SCKT_CONNECT;
+			return;
+		}
+#endif
 		ret = close(req_ctx->connect_socket);
 		if (ret) {
 			LOG_WRN("Failed to close socket, error: %d", errno);
@@ -268,27 +318,11 @@ static void rest_client_init_request(struct rest_client_req_context *const req_c
 	req->method = req_ctx->http_method;
 }
 
-static int rest_client_do_api_call(struct http_request *http_req,
+static int rest_client_do_http_req(struct http_request *http_req,
 				   struct rest_client_req_context *const req_ctx,
 				   struct rest_client_resp_context *const resp_ctx)
 {
-	int err = 0;
-	int64_t sckt_connect_start_time;
-	int64_t sckt_connect_time;
-
-	sckt_connect_start_time = k_uptime_get();
-
-	if (req_ctx->connect_socket < 0) {
-		err = rest_client_sckt_connect(&req_ctx->connect_socket,
-						http_req->host,
-						req_ctx->port,
-						req_ctx->sec_tag,
-						req_ctx->tls_peer_verify,
-						req_ctx->timeout_ms);
-		if (err) {
-			return err;
-		}
-	}
+	int err;
 
 	/* Assign the user provided receive buffer into the http request */
 	http_req->recv_buf = req_ctx->resp_buff;
@@ -303,20 +337,9 @@ static int rest_client_do_api_call(struct http_request *http_req,
 	resp_ctx->response_len = 0;
 	resp_ctx->total_response_len = 0;
 	resp_ctx->used_socket_id = req_ctx->connect_socket;
+	resp_ctx->http_status_code = 0;
 	resp_ctx->http_status_code_str[0] = '\0';
 
-	if (req_ctx->timeout_ms != SYS_FOREVER_MS) {
-		/* Take time used for socket connect into account */
-		sckt_connect_time = k_uptime_get() - sckt_connect_start_time;
-
-		/* Check if timeout has already elapsed */
-		if (sckt_connect_time >= req_ctx->timeout_ms) {
-			LOG_WRN("Timeout occurred during socket connect");
-			return -ETIMEDOUT;
-		}
-		req_ctx->timeout_ms -= sckt_connect_time;
-	}
-
 	err = http_client_req(req_ctx->connect_socket, http_req, req_ctx->timeout_ms, resp_ctx);
 	if (err < 0) {
 		LOG_ERR("http_client_req() error: %d", err);
@@ -332,6 +355,109 @@ static int rest_client_do_api_call(struct http_request *http_req,
 	return err;
 }
 
+/* Take the time used since the start time into account in the request timeout */
+static int rest_client_timeout_update(struct rest_client_req_context *const req_ctx,
+				      int64_t *start_time)
+{
+	int64_t elapsed = k_uptime_delta(start_time);
+
+	if (req_ctx->timeout_ms == SYS_FOREVER_MS) {
+		return 0;
+	}
+
+	/* Check if timeout has already elapsed */
+	if (elapsed >= req_ctx->timeout_ms) {
+		return -ETIMEDOUT;
+	}
+	req_ctx->timeout_ms -= elapsed;
+
+	return 0;
+}
+
+static int rest_client_do_api_call(struct http_request *http_req,
+				   struct rest_client_req_context *const req_ctx,
+				   struct rest_client_resp_context *const resp_ctx)
+{
+	int err = 0;
+	int64_t start_time;
+#if defined(CONFIG_REST_CLIENT_POOL)
+	bool pooled = false;
+#endif
+
+	start_time = k_uptime_get();
+
+#if defined(CONFIG_REST_CLIENT_POOL)
+	if (req_ctx->connect_socket < 0) {
+		err = rest_client_pool_get(req_ctx);
+		if (err >= 0) {
+			req_ctx->connect_socket = err;
+			pooled = true;
+			err = rest_client_sckt_timeouts_set(req_ctx->connect_socket,
+							    req_ctx->timeout_ms);
+			if (err) {
+				(void)close(req_ctx->connect_socket);
+				req_ctx->connect_socket = REST_CLIENT_SCKT_CONNECT;
+				pooled = false;
+			}
+		}
+		err = 0;
+	}
+#endif
+
+	if (req_ctx->connect_socket < 0) {
+		err = rest_client_sckt_connect(&req_ctx->connect_socket,
+						http_req->host,
+						req_ctx->port,
+						req_ctx->sec_tag,
+						req_ctx->tls_peer_verify,
+						req_ctx->timeout_ms);
+		if (err) {
+			return err;
+		}
+	}
+
+	/* Take time used for socket connect into account */
+	if (rest_client_timeout_update(req_ctx, &start_time)) {
+		LOG_WRN("Timeout occurred during socket connect");
+		return -ETIMEDOUT;
+	}
+
+	err = rest_client_do_http_req(http_req, req_ctx, resp_ctx);
+
+#if defined(CONFIG_REST_CLIENT_POOL)
+	if (pooled && rest_client_pool_retry_allowed(req_ctx->http_method, err,
+						     resp_ctx->total_response_len)) {
+		/* The server closed the idle connection before the request got through.
+		 * The request is sent again on a new connection, within the time left.
+		 */
+		LOG_DBG("Pooled connection closed by the server, reconnecting");
+		(void)close(req_ctx->connect_socket);
+		req_ctx->connect_socket = REST_CLIENT_SCKT_CONNECT;
+
+		if (rest_client_timeout_update(req_ctx, &start_time)) {
+			LOG_WRN("Timeout occurred before reconnecting");
+			return -ETIMEDOUT;
+		}
+		err = rest_client_sckt_connect(&req_ctx->connect_socket,
+						http_req->host,
+						req_ctx->port,
+						req_ctx->sec_tag,
+						req_ctx->tls_peer_verify,
+						req_ctx->timeout_ms);
+		if (err) {
+			return err;
+		}
+		if (rest_client_timeout_update(req_ctx, &start_time)) {
+			LOG_WRN("Timeout occurred during socket connect");
+			return -ETIMEDOUT;
+		}
+		err = rest_client_do_http_req(http_req, req_ctx, resp_ctx);
+	}
+#endif
+
+	return err;
+}
+
 void rest_client_request_defaults_set(struct rest_client_req_context *req_ctx)
 {
 	__ASSERT_NO_MSG(req_ctx != NULL);
@@ -395,7 +521,9 @@ int rest_client_request(struct rest_client_req_context *req_ctx,
 clean_up:
 	if (req_ctx->connect_socket != REST_CLIENT_SCKT_CONNECT) {
 		/* Socket was not closed yet: */
-		rest_client_close_connection(req_ctx, resp_ctx);
+		rest_client_close_connection(req_ctx, resp_ctx,
+					     ret == 0 &&
+					     http_should_keep_alive(&http_req.internal.parser));
 	}
 	return ret;
 }
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+
+#include "rest_client_dns_cache.h"
+
+LOG_MODULE_DECLARE(rest_client, CONFIG_REST_CLIENT_LOG_LEVEL);
+
+#define DNS_CACHE_TTL_MS (CONFIG_REST_CLIENT_DNS_CACHE_TTL * MSEC_PER_SEC)
+
+struct rest_client_dns_cache_entry {
+	/** Uptime when the address was resolved, entry is free if 0. */
+	int64_t resolved;
+	struct sockaddr addr;
+	socklen_t addrlen;
+	uint16_t port;
+	char host[CONFIG_REST_CLIENT_HOSTNAME_MAX_LEN + 1];
+};
+
+static struct rest_client_dns_cache_entry cache[CONFIG_REST_CLIENT_DNS_CACHE_SIZE];
+
+static K_MUTEX_DEFINE(cache_mutex);
+
+static struct rest_client_dns_cache_entry *rest_client_dns_cache_find(const char *hostname,
+								      uint16_t port)
+{
+	for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+		if (cache[i].resolved && cache[i].port == port &&
+		    strcmp(cache[i].host, hostname) == 0) {
+			return &cache[i];
+		}
+	}
+
+	return NULL;
+}
+
+int rest_client_dns_cache_get(const char *hostname, uint16_t port,
+			      struct sockaddr *addr, socklen_t *addrlen)
+{
+	struct rest_client_dns_cache_entry *entry;
+	int err = -ENOENT;
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	entry = rest_client_dns_cache_find(hostname, port);
+	if (entry) {
+		if (k_uptime_get() - entry->resolved < DNS_CACHE_TTL_MS) {
+			memcpy(addr, &entry->addr, entry->addrlen);
+			*addrlen = entry->addrlen;
+			err = 0;
+		} else {
+			entry->resolved = 0;
+		}
+	}
+
+	k_mutex_unlock(&cache_mutex);
+
+	return err;
+}
+
+void rest_client_dns_cache_put(const char *hostname, uint16_t port,
+			       const struct sockaddr *addr, socklen_t addrlen)
+{
+	struct rest_client_dns_cache_entry *entry;
+
+	if (strlen(hostname) > CONFIG_REST_CLIENT_HOSTNAME_MAX_LEN ||
+	    addrlen > sizeof(entry->addr)) {
+		return;
+	}
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	entry = rest_client_dns_cache_find(hostname, port);
+	if (!entry) {
+		/* Free entry, or else the oldest one */
+		entry = &cache[0];
+		for (int i = 0; i < ARRAY_SIZE(cache); i++) {
+			if (cache[i].resolved < entry->resolved) {
+				entry = &cache[i];
+			}
+		}
+	}
+
+	memcpy(&entry->addr, addr, addrlen);
+	entry->addrlen = addrlen;
+	entry->port = port;
+	/* Uptime can be 0 at boot, but 0 marks a free entry */
+	entry->resolved = MAX(k_uptime_get(), 1);
+	strcpy(entry->host, hostname);
+
+	k_mutex_unlock(&cache_mutex);
+}
+
+void rest_client_dns_cache_remove(const char *hostname, uint16_t port)
+{
+	struct rest_client_dns_cache_entry *entry;
+
+	k_mutex_lock(&cache_mutex, K_FOREVER);
+
+	entry = rest_client_dns_cache_find(hostname, port);
+	if (entry) {
+		entry->resolved = 0;
+	}
+
+	k_mutex_unlock(&cache_mutex);
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef REST_CLIENT_DNS_CACHE_H__
+#define REST_CLIENT_DNS_CACHE_H__
+
+#if defined(CONFIG_POSIX_API)
+#include <zephyr/posix/sys/socket.h>
+#else
+#include <zephyr/net/socket.h>
+#endif
+
+/**
+ * @brief Look up the address of a host.
+ *
+ * @param[in] hostname Host name.
+ * @param[in] port Port.
+ * @param[out] addr Address.
+ * @param[out] addrlen Address length.
+ *
+ * @retval 0 Address found.
+ * @retval -ENOENT Address not found or expired.
+ */
+int rest_client_dns_cache_get(const char *hostname, uint16_t port,
+			      struct sockaddr *addr, socklen_t *addrlen);
+
+/**
+ * @brief Store the address of a host, replacing the oldest entry if the cache is full.
+ *
+ * @param[in] hostname Host name.
+ * @param[in] port Port.
+ * @param[in] addr Address.
+ * @param[in] addrlen Address length.
+ */
+void rest_client_dns_cache_put(const char *hostname, uint16_t port,
+			       const struct sockaddr *addr, socklen_t addrlen);
+
+/**
+ * @brief Remove the address of a host, for example when connecting to it failed.
+ *
+ * @param[in] hostname Host name.
+ * @param[in] port Port.
+ */
+void rest_client_dns_cache_remove(const char *hostname, uint16_t port);
+
+#endif /* REST_CLIENT_DNS_CACHE_H__ */
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <zephyr/kernel.h>
+#if defined(CONFIG_POSIX_API)
+#include <zephyr/posix/unistd.h>
+#else
+#include <zephyr/net/socket.h>
+#endif
+#include <zephyr/logging/log.h>
+
+#include <net/rest_client.h>
+
+#include "rest_client_pool.h"
+
+LOG_MODULE_DECLARE(rest_client, CONFIG_REST_CLIENT_LOG_LEVEL);
+
+#define IDLE_TIMEOUT_MS (CONFIG_REST_CLIENT_POOL_IDLE_TIMEOUT * MSEC_PER_SEC)
+
+/** Idle connection. */
+struct rest_client_pool_entry {
+	/** Socket, -1 if the entry is free. */
+	int fd;
+	int sec_tag;
+	int tls_peer_verify;
+	uint16_t port;
+	/** Uptime when the connection became idle. */
+	int64_t idle_since;
+	char host[CONFIG_REST_CLIENT_HOSTNAME_MAX_LEN + 1];
+};
+
+static struct rest_client_pool_entry pool[CONFIG_REST_CLIENT_POOL_SIZE] = {
+	[0 ... CONFIG_REST_CLIENT_POOL_SIZE - 1] = { .fd = -1 }
+};
+
+static K_MUTEX_DEFINE(pool_mutex);
+
+static void rest_client_pool_idle_work_fn(struct k_work *work);
+
+static K_WORK_DELAYABLE_DEFINE(idle_work, rest_client_pool_idle_work_fn);
+
+static void rest_client_pool_entry_close(struct rest_client_pool_entry *entry)
+{
+	if (close(entry->fd)) {
+		LOG_WRN("Failed to close pooled socket %d, error: %d", entry->fd, errno);
+	}
+	entry->fd = -1;
+}
+
+/** Closes the expired connections and schedules the next expiry. Called with the mutex held. */
+static void rest_client_pool_expire(void)
+{
+	int64_t now = k_uptime_get();
+	int64_t next = INT64_MAX;
+
+	for (int i = 0; i < ARRAY_SIZE(pool); i++) {
+		if (pool[i].fd < 0) {
+			continue;
+		}
+		if (now - pool[i].idle_since >= IDLE_TIMEOUT_MS) {
+			LOG_DBG("Closing idle connection to %s", log_strdup(pool[i].host));
+			rest_client_pool_entry_close(&pool[i]);
+		} else {
+			next = MIN(next, pool[i].idle_since + IDLE_TIMEOUT_MS);
+		}
+	}
+
+	if (next != INT64_MAX) {
+		k_work_reschedule(&idle_work, K_MSEC(next - now));
+	} else {
+		k_work_cancel_delayable(&idle_work);
+	}
+}
+
+static void rest_client_pool_idle_work_fn(struct k_work *work)
+{
+	k_mutex_lock(&pool_mutex, K_FOREVER);
+	rest_client_pool_expire();
+	k_mutex_unlock(&pool_mutex);
+}
+
+int rest_client_pool_get(const struct rest_client_req_context *req_ctx)
+{
+	struct rest_client_pool_entry *entry;
+	int fd = -ENOENT;
+
+	k_mutex_lock(&pool_mutex, K_FOREVER);
+
+	rest_client_pool_expire();
+
+	for (int i = 0; i < ARRAY_SIZE(pool); i++) {
+		entry = &pool[i];
+		if (entry->fd >= 0 &&
+		    entry->port == req_ctx->port &&
+		    entry->sec_tag == req_ctx->sec_tag &&
+		    entry->tls_peer_verify == req_ctx->tls_peer_verify &&
+		    strcmp(entry->host, req_ctx->host) == 0) {
+			fd = entry->fd;
+			entry->fd = -1;
+			LOG_DBG("Reusing connection %d to %s", fd, log_strdup(entry->host));
+			break;
+		}
+	}
+
+	k_mutex_unlock(&pool_mutex);
+
+	return fd;
+}
+
+void rest_client_pool_put(const struct rest_client_req_context *req_ctx, int fd)
+{
+	struct rest_client_pool_entry *entry = NULL;
+
+	if (strlen(req_ctx->host) > CONFIG_REST_CLIENT_HOSTNAME_MAX_LEN) {
+		LOG_DBG("Host name too long, connection not pooled");
+		if (close(fd)) {
+			LOG_WRN("Failed to close socket, error: %d", errno);
+		}
+		return;
+	}
+
+	k_mutex_lock(&pool_mutex, K_FOREVER);
+
+	for (int i = 0; i < ARRAY_SIZE(pool); i++) {
+		if (pool[i].fd < 0) {
+			entry = &pool[i];
+			break;
+		}
+		if (!entry || pool[i].idle_since < entry->idle_since) {
+			entry = &pool[i];
+		}
+	}
+
+	if (entry->fd >= 0) {
+		LOG_DBG("Pool full, closing connection to %s", log_strdup(entry->host));
+		rest_client_pool_entry_close(entry);
+	}
+
+	entry->fd = fd;
+	entry->port = req_ctx->port;
+	entry->sec_tag = req_ctx->sec_tag;
+	entry->tls_peer_verify = req_ctx->tls_peer_verify;
+	entry->idle_since = k_uptime_get();
+	strcpy(entry->host, req_ctx->host);
+
+	rest_client_pool_expire();
+
+	k_mutex_unlock(&pool_mutex);
+}
+
+bool rest_client_pool_retry_allowed(enum http_method method, int err, size_t received)
+{
+	if (received > 0) {
+		return false;
+	}
+
+	/* End of file, reset, or closed while sending the request */
+	if (err < 0 && err != -ECONNRESET && err != -EPIPE) {
+		return false;
+	}
+
+	switch (method) {
+	case HTTP_GET:
+	case HTTP_HEAD:
+	case HTTP_PUT:
+	case HTTP_DELETE:
+	case HTTP_OPTIONS:
+	case HTTP_TRACE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void rest_client_pool_flush(void)
+{
+	k_mutex_lock(&pool_mutex, K_FOREVER);
+
+	for (int i = 0; i < ARRAY_SIZE(pool); i++) {
+		if (pool[i].fd >= 0) {
+			rest_client_pool_entry_close(&pool[i]);
+		}
+	}
+	k_work_cancel_delayable(&idle_work);
+
+	k_mutex_unlock(&pool_mutex);
+}
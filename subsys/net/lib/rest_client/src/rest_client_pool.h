@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef REST_CLIENT_POOL_H__
+#define REST_CLIENT_POOL_H__
+
+#include <net/rest_client.h>
+
+/**
+ * @brief Take an idle connection matching the host, port, security tag and peer
+ *        verification of the request.
+ *
+ * @details The connection is removed from the pool; it is owned by the caller until it is
+ *          given back with @ref rest_client_pool_put or closed.
+ *
+ * @param[in] req_ctx Request context.
+ *
+ * @return Socket of the connection, or -ENOENT if there is no matching idle connection.
+ */
+int rest_client_pool_get(const struct rest_client_req_context *req_ctx);
+
+/**
+ * @brief Give a connection to the pool after a completed request.
+ *
+ * @details The connection is closed if the host name is too long to be pooled. If the pool
+ *          is full, the connection idle for the longest time is closed to make room.
+ *
+ * @param[in] req_ctx Request context the connection was used for.
+ * @param[in] fd Socket of the connection.
+ */
+void rest_client_pool_put(const struct rest_client_req_context *req_ctx, int fd);
+
+/**
+ * @brief Check if a request that failed on a pooled connection can be sent again on a new one.
+ *
+ * @details The server may close an idle connection at any time. The request is sent again
+ *          only if the connection was reset or closed before any part of the response was
+ *          received, and only if its method is idempotent, as the server may have processed
+ *          the request anyway.
+ *
+ * @param[in] method HTTP method of the request.
+ * @param[in] err Result of http_client_req().
+ * @param[in] received Number of response bytes received.
+ *
+ * @return true if the request can be sent again.
+ */
+bool rest_client_pool_retry_allowed(enum http_method method, int err, size_t received);
+
+#endif /* REST_CLIENT_POOL_H__ */
@@ -239,6 +239,7 @@ static int ch_rec_payload_parse(struct nfc_ndef_bin_payload_desc *payload_desc,
 	const uint8_t *payload_buf = payload_desc->payload;
 	uint32_t payload_len = payload_desc->payload_length;
 	uint32_t local_msg_size;
+	uint32_t local_rec_cnt;
 	uint8_t *local_msg;
 	struct nfc_ndef_ch_rec *ch_rec;
 	struct net_buf_simple buf;
@@ -264,7 +265,16 @@ static int ch_rec_payload_parse(struct nfc_ndef_bin_payload_desc *payload_desc,
 	payload_buf++;
 	payload_len--;
 
-	local_msg_size = net_buf_simple_tailroom(&buf);
+	/* Validate the local records first, to take only as much of
+	 * the result buffer as their descriptors need.
+	 */
+	err = nfc_ndef_msg_record_count(payload_buf, &payload_len,
+					&local_rec_cnt);
+	if (err) {
+		return err;
+	}
+
+	local_msg_size = NFC_NDEF_PARSER_REQUIRED_MEM(local_rec_cnt);
 
 	local_msg = memory_allocate(&buf, local_msg_size);
 	if (!local_msg) {
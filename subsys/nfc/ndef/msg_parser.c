@@ -3,8 +3,11 @@
  *
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
+#include <errno.h>
+#include <string.h>
 #include <zephyr/kernel.h>
 #include <zephyr/logging/log.h>
+#include <nfc/ndef/msg_parser.h>
 #include "msg_parser_local.h"
 
 LOG_MODULE_REGISTER(nfc_ndef_parser, CONFIG_NFC_NDEF_PARSER_LOG_LEVEL);
@@ -36,6 +39,93 @@ int nfc_ndef_msg_parse(uint8_t *result_buf,
 }
 
 
+void nfc_ndef_msg_iter_init(struct nfc_ndef_msg_iter *iter,
+			    const uint8_t *raw_data,
+			    uint32_t raw_data_len)
+{
+	__ASSERT_NO_MSG(iter);
+
+	memset(iter, 0, sizeof(*iter));
+
+	iter->data = raw_data;
+	iter->data_len = raw_data_len;
+}
+
+int nfc_ndef_msg_iter_next(struct nfc_ndef_msg_iter *iter,
+			   struct nfc_ndef_record_view *view)
+{
+	int err;
+	enum nfc_ndef_record_location location;
+
+	__ASSERT_NO_MSG(iter);
+	__ASSERT_NO_MSG(view);
+
+	if (iter->done) {
+		return -ENOENT;
+	}
+
+	/* No record with the Message End flag. */
+	if (iter->offset == iter->data_len) {
+		return -EFAULT;
+	}
+
+	err = nfc_ndef_record_view_decode(view, iter->data + iter->offset,
+					  iter->data_len - iter->offset);
+	if (err) {
+		return err;
+	}
+
+	/* Verify the records location flags. */
+	location = nfc_ndef_record_view_location(view);
+
+	if (iter->record_count == 0) {
+		if ((location != NDEF_FIRST_RECORD) &&
+		    (location != NDEF_LONE_RECORD)) {
+			return -EFAULT;
+		}
+	} else {
+		if ((location != NDEF_MIDDLE_RECORD) &&
+		    (location != NDEF_LAST_RECORD)) {
+			return -EFAULT;
+		}
+	}
+
+	iter->offset += nfc_ndef_record_view_size(view);
+	iter->record_count++;
+	iter->done = ((location == NDEF_LAST_RECORD) ||
+		      (location == NDEF_LONE_RECORD));
+
+	return 0;
+}
+
+int nfc_ndef_msg_record_count(const uint8_t *raw_data,
+			      uint32_t *raw_data_len,
+			      uint32_t *record_count)
+{
+	int err;
+	struct nfc_ndef_msg_iter iter;
+	struct nfc_ndef_record_view view;
+
+	if (!raw_data || !raw_data_len || !record_count) {
+		return -EINVAL;
+	}
+
+	nfc_ndef_msg_iter_init(&iter, raw_data, *raw_data_len);
+
+	do {
+		err = nfc_ndef_msg_iter_next(&iter, &view);
+	} while (!err);
+
+	if (err != -ENOENT) {
+		return err;
+	}
+
+	*record_count = iter.record_count;
+	*raw_data_len = nfc_ndef_msg_iter_parsed_len(&iter);
+
+	return 0;
+}
+
 void nfc_ndef_msg_printout(const struct nfc_ndef_msg_desc *msg_desc)
 {
 	uint32_t i;
@@ -19,93 +19,102 @@ LOG_MODULE_DECLARE(nfc_ndef_parser, CONFIG_NFC_NDEF_PARSER_LOG_LEVEL);
 #define NDEF_RECORD_BASE_SHORT_LEN (2 + NDEF_RECORD_PAYLOAD_LEN_SHORT_SIZE)
 
 
-int nfc_ndef_record_parse(struct nfc_ndef_bin_payload_desc *bin_pay_desc,
-			  struct nfc_ndef_record_desc *rec_desc,
-			  enum nfc_ndef_record_location *record_location,
-			  const uint8_t *nfc_data,
-			  uint32_t *nfc_data_len)
+int nfc_ndef_record_view_decode(struct nfc_ndef_record_view *view,
+				const uint8_t *nfc_data,
+				uint32_t nfc_data_len)
 {
-	uint32_t expected_rec_size = NDEF_RECORD_BASE_SHORT_LEN;
+	uint32_t header_len = NDEF_RECORD_BASE_SHORT_LEN;
+	uint32_t fields_len;
+	uint8_t flags;
 
-	if (expected_rec_size > *nfc_data_len) {
+	if (header_len > nfc_data_len) {
 		return -EINVAL;
 	}
 
-	rec_desc->tnf = (enum nfc_ndef_record_tnf) ((*nfc_data) & NDEF_RECORD_TNF_MASK);
-
-	/* An NDEF parser that receives an NDEF record with an unknown
-	 * or unsupported TNF field value
-	 * SHOULD treat it as Unknown. See NFCForum-TS-NDEF_1.0
-	 */
-	if (rec_desc->tnf == TNF_RESERVED) {
-		rec_desc->tnf = TNF_UNKNOWN_TYPE;
-	}
-
-	*record_location = (enum nfc_ndef_record_location) ((*nfc_data) & NDEF_RECORD_LOCATION_MASK);
-
-	uint8_t flags = *(nfc_data++);
+	flags = nfc_data[0];
 
-	rec_desc->type_length = *(nfc_data++);
-
-	uint32_t payload_length;
+	view->raw = nfc_data;
+	view->type_length = nfc_data[1];
 
 	if (flags & NDEF_RECORD_SR_MASK) {
-		payload_length = *(nfc_data++);
+		view->payload_length = nfc_data[2];
 	} else {
-		expected_rec_size +=
-			NDEF_RECORD_PAYLOAD_LEN_LONG_SIZE - NDEF_RECORD_PAYLOAD_LEN_SHORT_SIZE;
+		header_len += NDEF_RECORD_PAYLOAD_LEN_LONG_SIZE -
+			      NDEF_RECORD_PAYLOAD_LEN_SHORT_SIZE;
 
-		if (expected_rec_size > *nfc_data_len) {
+		if (header_len > nfc_data_len) {
 			return -EINVAL;
 		}
 
-		payload_length = sys_get_be32(nfc_data);
-		nfc_data += NDEF_RECORD_PAYLOAD_LEN_LONG_SIZE;
+		view->payload_length = sys_get_be32(&nfc_data[2]);
 	}
 
 	if (flags & NDEF_RECORD_IL_MASK) {
-		expected_rec_size += NDEF_RECORD_ID_LEN_SIZE;
+		header_len += NDEF_RECORD_ID_LEN_SIZE;
 
-		if (expected_rec_size > *nfc_data_len) {
+		if (header_len > nfc_data_len) {
 			return -EINVAL;
 		}
 
-		rec_desc->id_length = *(nfc_data++);
+		view->id_length = nfc_data[header_len - NDEF_RECORD_ID_LEN_SIZE];
 	} else {
-		rec_desc->id_length = 0;
-		rec_desc->id        = NULL;
+		view->id_length = 0;
 	}
 
-	expected_rec_size += rec_desc->type_length + rec_desc->id_length + payload_length;
+	view->header_length = header_len;
 
-	if (expected_rec_size > *nfc_data_len) {
-		return -EINVAL;
-	}
+	/* Compare against the remaining data, so that a long payload length
+	 * cannot overflow the record size.
+	 */
+	fields_len = view->type_length + view->id_length;
 
-	if (rec_desc->type_length > 0) {
-		rec_desc->type = nfc_data;
-		nfc_data += rec_desc->type_length;
-	} else {
-		rec_desc->type = NULL;
+	if ((fields_len > (nfc_data_len - header_len)) ||
+	    (view->payload_length > (nfc_data_len - header_len - fields_len))) {
+		return -EINVAL;
 	}
 
-	if (rec_desc->id_length > 0) {
-		rec_desc->id = nfc_data;
-		nfc_data += rec_desc->id_length;
-	}
+	return 0;
+}
 
-	if (payload_length == 0) {
-		bin_pay_desc->payload = NULL;
-	} else {
-		bin_pay_desc->payload = nfc_data;
-	}
+void nfc_ndef_record_view_desc_get(const struct nfc_ndef_record_view *view,
+				   struct nfc_ndef_record_desc *rec_desc,
+				   struct nfc_ndef_bin_payload_desc *bin_pay_desc)
+{
+	rec_desc->tnf = nfc_ndef_record_view_tnf(view);
+	rec_desc->type_length = view->type_length;
+	rec_desc->type = nfc_ndef_record_view_type(view);
+	rec_desc->id_length = view->id_length;
+	rec_desc->id = nfc_ndef_record_view_id(view);
 
-	bin_pay_desc->payload_length = payload_length;
+	bin_pay_desc->payload = nfc_ndef_record_view_payload(view);
+	bin_pay_desc->payload_length = view->payload_length;
 
 	rec_desc->payload_descriptor = bin_pay_desc;
 	rec_desc->payload_constructor  = (payload_constructor_t) nfc_ndef_bin_payload_memcopy;
+}
+
+int nfc_ndef_record_parse(struct nfc_ndef_bin_payload_desc *bin_pay_desc,
+			  struct nfc_ndef_record_desc *rec_desc,
+			  enum nfc_ndef_record_location *record_location,
+			  const uint8_t *nfc_data,
+			  uint32_t *nfc_data_len)
+{
+	int err;
+	struct nfc_ndef_record_view view;
+
+	err = nfc_ndef_record_view_decode(&view, nfc_data, *nfc_data_len);
+	if (err) {
+		return err;
+	}
+
+	/* An NDEF parser that receives an NDEF record with an unknown
+	 * or unsupported TNF field value
+	 * SHOULD treat it as Unknown. See NFCForum-TS-NDEF_1.0
+	 */
+	nfc_ndef_record_view_desc_get(&view, rec_desc, bin_pay_desc);
 
-	*nfc_data_len = expected_rec_size;
+	*record_location = nfc_ndef_record_view_location(&view);
+	*nfc_data_len = nfc_ndef_record_view_size(&view);
 
 	return 0;
 }
@@ -19,6 +19,7 @@ LOG_MODULE_REGISTER(nfc_t4t_apdu, CONFIG_NFC_T4T_APDU_LOG_LEVEL);
 #define LC_LONG_FORMAT_SIZE 3U
 #define LE_SHORT_FORMAT_SIZE 1U
 #define LE_LONG_FORMAT_SIZE 2U
+#define LE_LONG_FORMAT_NO_LC_SIZE 3U
 
 /** @brief Values used to encode Lc field in C-APDU.
  */
@@ -30,6 +31,7 @@ LOG_MODULE_REGISTER(nfc_t4t_apdu, CONFIG_NFC_T4T_APDU_LOG_LEVEL);
 #define LE_FIELD_ABSENT 0U
 #define LE_LONG_FORMAT_THR 0x0100
 #define LE_ENCODED_VAL_256 0x00
+#define LE_LONG_FORMAT_TOKEN 0x00
 
 /* Size of Status field contained in R-APDU. */
 #define STATUS_SIZE 2U
@@ -50,7 +52,8 @@ static uint16_t nfc_t4t_apdu_comm_size_calc(const struct nfc_t4t_apdu_comm *cmd_
 
 	if (cmd_apdu->resp_len != LE_FIELD_ABSENT) {
 		if (cmd_apdu->resp_len > LE_LONG_FORMAT_THR) {
-			res += LE_LONG_FORMAT_SIZE;
+			res += cmd_apdu->data.buff ? LE_LONG_FORMAT_SIZE :
+						     LE_LONG_FORMAT_NO_LC_SIZE;
 		} else {
 			res += LE_SHORT_FORMAT_SIZE;
 		}
@@ -125,6 +128,13 @@ int nfc_t4t_apdu_comm_encode(const struct nfc_t4t_apdu_comm *cmd_apdu,
 	if (cmd_apdu->resp_len != LE_FIELD_ABSENT) {
 		/* Use long response length encoding. */
 		if (cmd_apdu->resp_len > LE_LONG_FORMAT_THR) {
+			/* Without the Lc field, the long format is marked
+			 * with a leading zero byte.
+			 */
+			if (!cmd_apdu->data.buff) {
+				*raw_data++ = LE_LONG_FORMAT_TOKEN;
+			}
+
 			sys_put_be16(cmd_apdu->resp_len, raw_data);
 			raw_data += sizeof(uint16_t);
 		} else {
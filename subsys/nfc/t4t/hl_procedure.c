@@ -27,6 +27,19 @@ LOG_MODULE_REGISTER(nfc_t4t_hl_procedure,
 #define APDU_LE_MAP_2_MAX_VALUE 0xFF
 #define NFC_T4T_APDU_RSP_ALL 256
 
+#if defined(CONFIG_NFC_T4T_HL_PROCEDURE_BULK)
+#define BULK_RAPDU_SIZE CONFIG_NFC_T4T_HL_PROCEDURE_BULK_RAPDU_SIZE
+#define BULK_FIRST_READ_SIZE CONFIG_NFC_T4T_HL_PROCEDURE_BULK_FIRST_READ_SIZE
+#else
+#define BULK_RAPDU_SIZE APDU_LE_MAP_2_MAX_VALUE
+#define BULK_FIRST_READ_SIZE NDEF_FILE_NLEN_SIZE
+#endif
+
+/* C-APDU header (CLA, INS, P1, P2) and Lc field sizes of the UPDATE BINARY command. */
+#define UPDATE_APDU_HEADER_SIZE 4
+#define UPDATE_APDU_LC_SHORT_SIZE 1
+#define UPDATE_APDU_LC_LONG_SIZE 3
+
 enum nfc_t4t_hl_transaction_type {
 	NFC_T4T_HL_SELECT,
 	NFC_T4T_HL_CC_READ,
@@ -51,9 +64,15 @@ struct t4t_hl_cc {
 	uint8_t data[CONFIG_NFC_T4T_HL_PROCEDURE_CC_BUFFER_SIZE];
 };
 
+struct t4t_hl_chunk_plan {
+	uint16_t read_len;
+	uint16_t update_len;
+};
+
 struct t4t_hl_procedure {
 	struct t4t_hl_cc cc_file;
 	struct t4t_hl_ndef ndef;
+	struct t4t_hl_chunk_plan plan;
 	enum nfc_t4t_hl_transaction_type transaction_type;
 	enum nfc_t4t_hl_procedure_select select_type;
 	uint16_t file_offset;
@@ -63,22 +82,63 @@ struct t4t_hl_procedure {
 static struct t4t_hl_procedure t4t_hl;
 static const struct nfc_t4t_hl_procedure_cb *hl_cb;
 
-static int t4t_hl_data_exchange(struct nfc_t4t_apdu_comm *comm)
+static int t4t_hl_apdu_encode(struct nfc_t4t_apdu_comm *comm, uint16_t *apdu_len)
 {
 	int err;
-	uint16_t apdu_len = sizeof(t4t_hl.apdu_buff);
+
+	*apdu_len = sizeof(t4t_hl.apdu_buff);
 
 	err = nfc_t4t_apdu_comm_encode(comm,
 				       t4t_hl.apdu_buff,
-				       &apdu_len);
+				       apdu_len);
 	if (err) {
 		LOG_ERR("NFC T4T C-APDU encode error: %d", err);
+	}
+
+	return err;
+}
+
+static int t4t_hl_data_exchange(struct nfc_t4t_apdu_comm *comm)
+{
+	int err;
+	uint16_t apdu_len;
+
+	err = t4t_hl_apdu_encode(comm, &apdu_len);
+	if (err) {
 		return err;
 	}
 
 	return nfc_t4t_isodep_transmit(t4t_hl.apdu_buff, apdu_len);
 }
 
+/* Compute the data size of the READ BINARY and UPDATE BINARY commands once per procedure.
+ * In the bulk mode, a tag with MLe or MLc above 255 bytes is accessed with extended-length
+ * APDUs, which are transferred over ISO-DEP using chaining.
+ */
+static void chunk_plan_compute(const struct nfc_t4t_cc_file *cc)
+{
+	uint32_t read_len = APDU_LE_MAP_2_MAX_VALUE;
+	uint32_t update_len = sizeof(t4t_hl.apdu_buff) - UPDATE_APDU_HEADER_SIZE -
+			      UPDATE_APDU_LC_SHORT_SIZE;
+
+	if (IS_ENABLED(CONFIG_NFC_T4T_HL_PROCEDURE_BULK)) {
+		read_len = BULK_RAPDU_SIZE;
+
+		if (update_len > APDU_LE_MAP_2_MAX_VALUE) {
+			update_len = sizeof(t4t_hl.apdu_buff) - UPDATE_APDU_HEADER_SIZE -
+				     UPDATE_APDU_LC_LONG_SIZE;
+		}
+	} else {
+		update_len = MIN(update_len, APDU_LE_MAP_2_MAX_VALUE);
+	}
+
+	t4t_hl.plan.read_len = MIN(read_len, cc->max_rapdu_size);
+	t4t_hl.plan.update_len = MIN(update_len, cc->max_capdu_size);
+
+	LOG_DBG("NDEF chunk plan: read %u bytes, update %u bytes",
+		t4t_hl.plan.read_len, t4t_hl.plan.update_len);
+}
+
 static int on_cc_read(const struct nfc_t4t_apdu_resp *resp)
 {
 	__ASSERT_NO_MSG(resp);
@@ -134,13 +194,21 @@ static int on_ndef_nlen_read(const struct nfc_t4t_apdu_resp *resp)
 	const uint8_t *data = resp->data.buff;
 	uint16_t len = resp->data.len;
 
-	if (len != NDEF_FILE_NLEN_SIZE) {
+	/* In the bulk mode, the first part of the NDEF message is read with NLEN. */
+	if ((len != NDEF_FILE_NLEN_SIZE) &&
+	    (!IS_ENABLED(CONFIG_NFC_T4T_HL_PROCEDURE_BULK) || (len < NDEF_FILE_NLEN_SIZE))) {
 		LOG_ERR("NDEF NLEN response is to long");
 		return -EINVAL;
 	}
 
 	t4t_hl.ndef.nlen = sys_get_be16(data);
 
+	if (t4t_hl.ndef.buff_size < (t4t_hl.ndef.nlen + NDEF_FILE_NLEN_SIZE)) {
+		LOG_ERR("NDEF file of %u bytes does not fit in the buffer",
+			t4t_hl.ndef.nlen + NDEF_FILE_NLEN_SIZE);
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
@@ -164,7 +232,8 @@ static int ndef_file_chunk_read(const struct nfc_t4t_apdu_resp *resp)
 	uint16_t file_id;
 	struct nfc_t4t_apdu_comm apdu_comm;
 	const uint8_t *data = resp->data.buff;
-	uint16_t len = resp->data.len;
+	uint16_t ndef_file_len = t4t_hl.ndef.nlen + NDEF_FILE_NLEN_SIZE;
+	uint16_t len = MIN(resp->data.len, ndef_file_len - t4t_hl.file_offset);
 
 	if (t4t_hl.ndef.buff_size < t4t_hl.file_offset + len) {
 		return -ENOMEM;
@@ -174,13 +243,13 @@ static int ndef_file_chunk_read(const struct nfc_t4t_apdu_resp *resp)
 
 	t4t_hl.file_offset += len;
 
-	if (t4t_hl.file_offset < (t4t_hl.ndef.nlen + NDEF_FILE_NLEN_SIZE)) {
+	if (t4t_hl.file_offset < ndef_file_len) {
 		nfc_t4t_apdu_comm_clear(&apdu_comm);
 
 		apdu_comm.instruction = NFC_T4T_APDU_COMM_INS_READ;
 		apdu_comm.parameter = t4t_hl.file_offset;
-		apdu_comm.resp_len = MIN(t4t_hl.ndef.nlen - (t4t_hl.file_offset - NDEF_FILE_NLEN_SIZE),
-				MIN(APDU_LE_MAP_2_MAX_VALUE, t4t_hl.ndef.cc->max_rapdu_size));
+		apdu_comm.resp_len = MIN(ndef_file_len - t4t_hl.file_offset,
+					 t4t_hl.plan.read_len);
 
 		t4t_hl.transaction_type = NFC_T4T_HL_NDEF_READ;
 
@@ -215,7 +284,7 @@ static int ndef_file_chunk_update(void)
 		apdu_comm.parameter = t4t_hl.file_offset;
 		apdu_comm.data.buff = t4t_hl.ndef.buff + t4t_hl.file_offset;
 		apdu_comm.data.len = MIN(t4t_hl.ndef.buff_size - t4t_hl.file_offset,
-				MIN(APDU_LE_MAP_2_MAX_VALUE, t4t_hl.ndef.cc->max_capdu_size));
+					 t4t_hl.plan.update_len);
 
 		t4t_hl.file_offset += apdu_comm.data.len;
 		t4t_hl.transaction_type = NFC_T4T_HL_NDEF_UPDATE;
@@ -234,6 +303,36 @@ static int ndef_file_chunk_update(void)
 	return t4t_hl_data_exchange(&apdu_comm);
 }
 
+/* Write the first part of the NDEF message with NLEN set to 0 in one UPDATE BINARY command. */
+static int ndef_nlen_clear_with_data(void)
+{
+	int err;
+	uint16_t apdu_len;
+	struct nfc_t4t_apdu_comm apdu_comm;
+
+	nfc_t4t_apdu_comm_clear(&apdu_comm);
+
+	apdu_comm.instruction = NFC_T4T_APDU_COMM_INS_UPDATE;
+	apdu_comm.parameter = 0;
+	apdu_comm.data.buff = t4t_hl.ndef.buff;
+	apdu_comm.data.len = MIN(t4t_hl.ndef.buff_size, t4t_hl.plan.update_len);
+
+	err = t4t_hl_apdu_encode(&apdu_comm, &apdu_len);
+	if (err) {
+		return err;
+	}
+
+	/* The data field ends the C-APDU and starts with NLEN. The caller buffer holds the
+	 * final NLEN, which is written after the rest of the NDEF message.
+	 */
+	memset(&t4t_hl.apdu_buff[apdu_len - apdu_comm.data.len], 0, NDEF_FILE_NLEN_SIZE);
+
+	t4t_hl.file_offset = apdu_comm.data.len;
+	t4t_hl.transaction_type = NFC_T4T_HL_NDEF_NLEN_CLEAR;
+
+	return nfc_t4t_isodep_transmit(t4t_hl.apdu_buff, apdu_len);
+}
+
 static void on_ndef_nlen_update(void)
 {
 	uint16_t file_id = sys_get_be16(t4t_hl.ndef.file_id);
@@ -404,6 +503,7 @@ int nfc_t4t_hl_procedure_ndef_read(struct nfc_t4t_cc_file *cc,
 				   uint16_t ndef_len)
 {
 	struct nfc_t4t_apdu_comm apdu_comm;
+	struct nfc_t4t_tlv_block *tlv_block;
 
 	t4t_hl.file_offset = 0;
 
@@ -411,12 +511,27 @@ int nfc_t4t_hl_procedure_ndef_read(struct nfc_t4t_cc_file *cc,
 		return -EINVAL;
 	}
 
+	chunk_plan_compute(cc);
 	nfc_t4t_apdu_comm_clear(&apdu_comm);
 
 	apdu_comm.instruction = NFC_T4T_APDU_COMM_INS_READ;
 	apdu_comm.parameter = 0;
 	apdu_comm.resp_len = NDEF_FILE_NLEN_SIZE;
 
+	if (IS_ENABLED(CONFIG_NFC_T4T_HL_PROCEDURE_BULK)) {
+		/* Read NLEN together with the first part of the NDEF message. */
+		tlv_block = nfc_t4t_cc_file_content_get(cc, sys_get_be16(t4t_hl.ndef.file_id));
+
+		apdu_comm.resp_len = MIN(t4t_hl.plan.read_len, ndef_len);
+		apdu_comm.resp_len = MIN(apdu_comm.resp_len, BULK_FIRST_READ_SIZE);
+		if (tlv_block) {
+			apdu_comm.resp_len = MIN(apdu_comm.resp_len,
+						 tlv_block->value.max_file_size);
+		}
+
+		apdu_comm.resp_len = MAX(apdu_comm.resp_len, NDEF_FILE_NLEN_SIZE);
+	}
+
 	t4t_hl.ndef.buff = ndef_buff;
 	t4t_hl.ndef.buff_size = ndef_len;
 	t4t_hl.ndef.cc = cc;
@@ -457,8 +572,14 @@ int nfc_t4t_hl_procedure_ndef_update(struct nfc_t4t_cc_file *cc,
 	t4t_hl.ndef.nlen = nlen;
 	t4t_hl.ndef.cc = cc;
 
+	chunk_plan_compute(cc);
 	nfc_t4t_apdu_comm_clear(&apdu_comm);
 
+	if (IS_ENABLED(CONFIG_NFC_T4T_HL_PROCEDURE_BULK) &&
+	    (t4t_hl.plan.update_len >= NDEF_FILE_NLEN_SIZE)) {
+		return ndef_nlen_clear_with_data();
+	}
+
 	/* Set NDEF NLEN to 0. */
 	apdu_comm.instruction = NFC_T4T_APDU_COMM_INS_UPDATE;
 	apdu_comm.parameter = 0;
@@ -54,10 +54,12 @@ static int handover_rec_parse(const struct nfc_ndef_ch_rec **ch_rec,
 	int err;
 	uint8_t *rec_data;
 	size_t rec_data_size;
+	struct net_buf_simple_state state;
 
 	rec_data_size = sizeof(struct nfc_ndef_ch_rec) +
 		NFC_NDEF_PARSER_REQUIRED_MEM(CONFIG_NFC_TNEP_CH_MAX_LOCAL_RECORD_COUNT);
 
+	net_buf_simple_save(buf, &state);
 	rec_data = memory_allocate(buf, rec_data_size);
 	if (!rec_data) {
 		return -ENOMEM;
@@ -71,6 +73,10 @@ static int handover_rec_parse(const struct nfc_ndef_ch_rec **ch_rec,
 
 	*ch_rec = (struct nfc_ndef_ch_rec *)rec_data;
 
+	/* Keep only the part used by the local records descriptors. */
+	net_buf_simple_restore(buf, &state);
+	(void *)net_buf_simple_add(buf, rec_data_size);
+
 	return 0;
 }
 
@@ -158,42 +158,38 @@ static int tnep_tag_update_prepare(const struct nfc_ndef_msg_desc *msg,
 	return 0;
 }
 
-static bool status_record_check(const struct nfc_ndef_record_desc *record,
-				const uint8_t *type_field,
-				size_t type_field_length)
+static int tnep_status_find(const uint8_t *data, size_t len, uint8_t *status)
 {
-	if (!record->type_length) {
-		return false;
-	}
+	int err;
+	struct nfc_ndef_msg_iter iter;
+	struct nfc_ndef_record_view record;
 
-	return (memcmp(record->type, type_field, type_field_length) == 0);
-}
+	nfc_ndef_msg_iter_init(&iter, data, len);
 
-static int tnep_data_analyze(const struct nfc_ndef_msg_desc *msg,
-			     struct nfc_tnep_poller_msg *poller_msg)
-{
 	/* Look for TNEP Status Record. */
-	for (size_t i = 0; i < msg->record_count; i++) {
-		const struct nfc_ndef_record_desc *record =
-			msg->record[i];
-		const struct nfc_ndef_bin_payload_desc *desc =
-			(struct nfc_ndef_bin_payload_desc *)record->payload_descriptor;
-
-		if (status_record_check(record, nfc_ndef_tnep_rec_type_status,
-					NFC_NDEF_TNEP_REC_TYPE_LEN)) {
-			if (desc->payload_length != NFC_TNEP_STATUS_RECORD_LEN) {
-				LOG_ERR("Invalid TNEP status record length: %d. Length should be %d",
-					desc->payload_length,
-					NFC_TNEP_STATUS_RECORD_LEN);
-
-				return -EINVAL;
-			}
+	while ((err = nfc_ndef_msg_iter_next(&iter, &record)) == 0) {
+		if (!nfc_ndef_record_view_type_check(&record, TNF_WELL_KNOWN,
+						     nfc_ndef_tnep_rec_type_status,
+						     NFC_NDEF_TNEP_REC_TYPE_LEN)) {
+			continue;
+		}
 
-			poller_msg->msg = msg;
-			poller_msg->status = desc->payload[0];
+		if (record.payload_length != NFC_TNEP_STATUS_RECORD_LEN) {
+			LOG_ERR("Invalid TNEP status record length: %u. Length should be %d",
+				record.payload_length,
+				NFC_TNEP_STATUS_RECORD_LEN);
 
-			return 0;
+			return -EINVAL;
 		}
+
+		*status = nfc_ndef_record_view_payload(&record)[0];
+
+		return 0;
+	}
+
+	if (err != -ENOENT) {
+		LOG_ERR("Error during parsing a NDEF message, err: %d.", err);
+		return err;
 	}
 
 	LOG_DBG("Message does not have any status record");
@@ -203,8 +199,6 @@ static int tnep_data_analyze(const struct nfc_ndef_msg_desc *msg,
 
 static bool service_param_rec_check(uint8_t tnf, const uint8_t *type, uint8_t length)
 {
-	__ASSERT_NO_MSG(type);
-
 	if (tnf != TNF_WELL_KNOWN) {
 		return false;
 	}
@@ -213,20 +207,21 @@ static bool service_param_rec_check(uint8_t tnf, const uint8_t *type, uint8_t le
 		return false;
 	}
 
+	__ASSERT_NO_MSG(type);
+
 	return (memcmp(type, nfc_ndef_tnep_rec_type_svc_param,
 		       NFC_NDEF_TNEP_REC_TYPE_LEN) == 0);
 }
 
-static int svc_param_record_get(const struct nfc_ndef_bin_payload_desc *bin_pay_desc,
+static int svc_param_record_get(const uint8_t *payload, uint32_t payload_length,
 				struct nfc_ndef_tnep_rec_svc_param *param)
 {
-	__ASSERT_NO_MSG(bin_pay_desc);
 	__ASSERT_NO_MSG(param);
 
-	const uint8_t *nfc_data = bin_pay_desc->payload;
+	const uint8_t *nfc_data = payload;
 
 	/* Check length. */
-	if (bin_pay_desc->payload_length < NFC_TNEP_SERVICE_PARAM_MIN_LEN) {
+	if (payload_length < NFC_TNEP_SERVICE_PARAM_MIN_LEN) {
 		LOG_ERR("To short Service Parameters Record.");
 		return -EFAULT;
 	}
@@ -235,11 +230,11 @@ static int svc_param_record_get(const struct nfc_ndef_bin_payload_desc *bin_pay_
 	param->uri_length = *(nfc_data++);
 
 	/* Check the whole record length with Service Name URI. */
-	if (bin_pay_desc->payload_length !=
+	if (payload_length !=
 	    (NFC_TNEP_SERVICE_PARAM_MIN_LEN + param->uri_length)) {
 		LOG_ERR("Invalid Service Parameters Record length, expected %d, received: %d.",
 			NFC_TNEP_SERVICE_PARAM_MIN_LEN + param->uri_length,
-			bin_pay_desc->payload_length);
+			payload_length);
 		return -EFAULT;
 	}
 
@@ -379,6 +374,7 @@ int nfc_tnep_poller_svc_search(const struct nfc_ndef_msg_desc *ndef_msg,
 {
 	int err;
 	const struct nfc_ndef_record_desc *record;
+	const struct nfc_ndef_bin_payload_desc *bin_pay_desc;
 	uint8_t size;
 
 	if (!ndef_msg || !params || !cnt) {
@@ -406,14 +402,17 @@ int nfc_tnep_poller_svc_search(const struct nfc_ndef_msg_desc *ndef_msg,
 		if (service_param_rec_check(record->tnf, record->type,
 					    record->type_length)) {
 			/* Check if we have memory for service. */
-			if ((*cnt) > size) {
+			if ((*cnt) >= size) {
 				return -ENOMEM;
 			}
 
+			bin_pay_desc = record->payload_descriptor;
+
 			/* If service parameters record corrupted.
 			 * Search for next valid record.
 			 */
-			err = svc_param_record_get(record->payload_descriptor,
+			err = svc_param_record_get(bin_pay_desc->payload,
+						   bin_pay_desc->payload_length,
 						   &params[*cnt]);
 			if (err) {
 				LOG_DBG("Service Parameter Record corrupted.");
@@ -427,6 +426,58 @@ int nfc_tnep_poller_svc_search(const struct nfc_ndef_msg_desc *ndef_msg,
 	return 0;
 }
 
+int nfc_tnep_poller_svc_search_raw(const uint8_t *data, size_t len,
+				   struct nfc_ndef_tnep_rec_svc_param *params,
+				   uint8_t *cnt)
+{
+	int err;
+	struct nfc_ndef_msg_iter iter;
+	struct nfc_ndef_record_view record;
+	uint8_t size;
+
+	if (!data || !params || !cnt) {
+		LOG_ERR("NULL argument.");
+		return -EINVAL;
+	}
+
+	if ((*cnt) < 1) {
+		return -ENOMEM;
+	}
+
+	size = *cnt;
+	*cnt = 0;
+
+	nfc_ndef_msg_iter_init(&iter, data, len);
+
+	/* Look for TNEP Service Parameters Records. */
+	while ((err = nfc_ndef_msg_iter_next(&iter, &record)) == 0) {
+		if (!nfc_ndef_record_view_type_check(&record, TNF_WELL_KNOWN,
+						     nfc_ndef_tnep_rec_type_svc_param,
+						     NFC_NDEF_TNEP_REC_TYPE_LEN)) {
+			continue;
+		}
+
+		/* Check if we have memory for service. */
+		if ((*cnt) >= size) {
+			return -ENOMEM;
+		}
+
+		/* If service parameters record corrupted.
+		 * Search for next valid record.
+		 */
+		err = svc_param_record_get(nfc_ndef_record_view_payload(&record),
+					   record.payload_length, &params[*cnt]);
+		if (err) {
+			LOG_DBG("Service Parameter Record corrupted.");
+			continue;
+		}
+
+		(*cnt)++;
+	}
+
+	return (err == -ENOENT) ? 0 : err;
+}
+
 int nfc_tnep_poller_svc_select(const struct nfc_tnep_buf *svc_buf,
 			       const struct nfc_ndef_tnep_rec_svc_param *svc,
 			       uint32_t max_ndef_area_size)
@@ -605,6 +656,7 @@ int nfc_tnep_poller_on_ndef_read(const uint8_t *data, size_t len)
 	size_t desc_buf_len = sizeof(desc_buf);
 	struct nfc_tnep_poller_msg poller_msg;
 	struct nfc_ndef_msg_desc *msg;
+	uint8_t status;
 
 	tnep.last_time = k_uptime_get();
 
@@ -623,6 +675,16 @@ int nfc_tnep_poller_on_ndef_read(const uint8_t *data, size_t len)
 	tnep.retry_cnt = 0;
 	memset(&poller_msg, 0, sizeof(poller_msg));
 
+	/* Messages without the Status Record are rejected before
+	 * the descriptors are built.
+	 */
+	err = tnep_status_find(data, len, &status);
+	if (err) {
+		return err;
+	}
+
+	poller_msg.status = status;
+
 	err = nfc_ndef_msg_parse(desc_buf,
 				 &desc_buf_len,
 				 data,
@@ -633,11 +695,7 @@ int nfc_tnep_poller_on_ndef_read(const uint8_t *data, size_t len)
 	}
 
 	msg = (struct nfc_ndef_msg_desc *)desc_buf;
-
-	err = tnep_data_analyze(msg, &poller_msg);
-	if (err) {
-		return err;
-	}
+	poller_msg.msg = msg;
 
 	return on_ndef_read_cb(&poller_msg, false);
 }
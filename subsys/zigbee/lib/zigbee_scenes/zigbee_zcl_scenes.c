@@ -5,41 +5,12 @@
  */
 
 #include <zephyr/logging/log.h>
-#include <zephyr/settings/settings.h>
 #include <zb_nrf_platform.h>
 #include <zigbee/zigbee_zcl_scenes.h>
 
-LOG_MODULE_REGISTER(zigbee_zcl_scenes, CONFIG_ZIGBEE_SCENES_LOG_LEVEL);
-
-static zb_uint8_t scene_table_get_entry(zb_uint16_t group_id, zb_uint8_t scene_id);
-static void scene_table_remove_entries_by_group(zb_uint16_t group_id);
-static void scene_table_init(void);
-
-struct zb_zcl_scenes_fieldset_data_on_off {
-	zb_bool_t  has_on_off;
-	zb_uint8_t on_off;
-};
-
-struct zb_zcl_scenes_fieldset_data_level_control {
-	zb_bool_t  has_current_level;
-	zb_uint8_t current_level;
-};
-
-struct zb_zcl_scenes_fieldset_data_window_covering {
-	zb_bool_t  has_current_position_lift_percentage;
-	zb_uint8_t current_position_lift_percentage;
-	zb_bool_t  has_current_position_tilt_percentage;
-	zb_uint8_t current_position_tilt_percentage;
-};
-
-struct scene_table_on_off_entry {
-	zb_zcl_scene_table_record_fixed_t                  common;
-	struct zb_zcl_scenes_fieldset_data_on_off          on_off;
-	struct zb_zcl_scenes_fieldset_data_level_control   level_control;
-	struct zb_zcl_scenes_fieldset_data_window_covering window_covering;
-};
+#include "zigbee_zcl_scenes_table.h"
 
-static struct scene_table_on_off_entry scenes_table[CONFIG_ZIGBEE_SCENE_TABLE_SIZE];
+LOG_MODULE_REGISTER(zigbee_zcl_scenes, CONFIG_ZIGBEE_SCENES_LOG_LEVEL);
 
 struct response_info {
 	zb_zcl_parsed_hdr_t cmd_info;
@@ -49,37 +20,6 @@ struct response_info {
 
 static struct response_info resp_info;
 
-static int scenes_table_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
-{
-	const char *next;
-	int rc;
-
-	if (settings_name_steq(name, "scenes_table", &next) && !next) {
-		if (len != sizeof(scenes_table)) {
-			return -EINVAL;
-		}
-
-		rc = read_cb(cb_arg, scenes_table, sizeof(scenes_table));
-		if (rc >= 0) {
-			return 0;
-		}
-
-		return rc;
-	}
-
-	return -ENOENT;
-}
-
-static void scenes_table_save(void)
-{
-	settings_save_one("scenes/scenes_table", scenes_table, sizeof(scenes_table));
-}
-
-struct settings_handler scenes_conf = {
-	.name = "scenes",
-	.h_set = scenes_table_set
-};
-
 static zb_bool_t has_cluster(zb_uint16_t cluster_id)
 {
 	return (get_endpoint_by_cluster(cluster_id, ZB_ZCL_CLUSTER_SERVER_ROLE)
@@ -147,7 +87,7 @@ static zb_bool_t add_fieldset(zb_zcl_scenes_fieldset_common_t *fieldset,
 	return ZB_FALSE;
 }
 
-static zb_uint8_t *dump_fieldsets(struct scene_table_on_off_entry *entry,
+static zb_uint8_t *dump_fieldsets(const struct scene_table_on_off_entry *entry,
 				  zb_uint8_t *payload_ptr)
 {
 	if (entry->on_off.has_on_off == ZB_TRUE) {
@@ -292,7 +232,7 @@ static void save_state_as_scene(struct scene_table_on_off_entry *entry)
 	}
 }
 
-static void recall_scene(struct scene_table_on_off_entry *entry)
+static void recall_scene(const struct scene_table_on_off_entry *entry)
 {
 	zb_bufid_t buf = zb_buf_get_any();
 	zb_zcl_attr_t *attr_desc;
@@ -374,15 +314,17 @@ static void recall_scene(struct scene_table_on_off_entry *entry)
 	zb_buf_free(buf);
 }
 
-static void send_view_scene_resp(zb_bufid_t bufid, zb_uint16_t idx)
+static void send_view_scene_resp(zb_bufid_t bufid)
 {
 	zb_uint8_t *payload_ptr;
 	zb_uint8_t view_scene_status = ZB_ZCL_STATUS_NOT_FOUND;
+	const struct scene_table_on_off_entry *entry = scene_table_find(
+		resp_info.view_scene_req.group_id,
+		resp_info.view_scene_req.scene_id);
 
-	LOG_DBG(">> %s bufid %hd idx %d", __func__, bufid, idx);
+	LOG_DBG(">> %s bufid %hd", __func__, bufid);
 
-	if (idx != 0xFF &&
-	    scenes_table[idx].common.group_id != ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD) {
+	if (entry) {
 		/* Scene found */
 		view_scene_status = ZB_ZCL_STATUS_SUCCESS;
 	} else if (!zb_aps_is_endpoint_in_group(resp_info.view_scene_req.group_id,
@@ -402,13 +344,13 @@ static void send_view_scene_resp(zb_bufid_t bufid, zb_uint16_t idx)
 	if (view_scene_status == ZB_ZCL_STATUS_SUCCESS) {
 		ZB_ZCL_SCENES_ADD_TRANSITION_TIME_VIEW_SCENE_RES(
 			payload_ptr,
-			scenes_table[idx].common.transition_time);
+			entry->common.transition_time);
 
 		ZB_ZCL_SCENES_ADD_SCENE_NAME_VIEW_SCENE_RES(
 			payload_ptr,
-			scenes_table[idx].common.scene_name);
+			entry->common.scene_name);
 
-		payload_ptr = dump_fieldsets(&scenes_table[idx], payload_ptr);
+		payload_ptr = dump_fieldsets(entry, payload_ptr);
 	}
 
 	ZB_ZCL_SCENES_SEND_VIEW_SCENE_RES(
@@ -459,18 +401,19 @@ static void send_get_scene_membership_resp(zb_bufid_t bufid)
 		ZB_ZCL_SCENES_ADD_SCENE_COUNT_GET_SCENE_MEMBERSHIP_RES(payload_ptr, 0);
 
 		while (i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE) {
-			if (scenes_table[i].common.group_id ==
-			    resp_info.get_scene_membership_req.group_id) {
+			const struct scene_table_on_off_entry *entry = scene_table_get(i);
+
+			if (entry == NULL) {
+				LOG_INF("add capacity num");
+				++(*capacity_ptr);
+			} else if (entry->common.group_id ==
+				   resp_info.get_scene_membership_req.group_id) {
 				/* Add to payload */
-				LOG_INF("add scene_id %hd", scenes_table[i].common.scene_id);
+				LOG_INF("add scene_id %hd", entry->common.scene_id);
 				++(*scene_count_ptr);
 				ZB_ZCL_SCENES_ADD_SCENE_ID_GET_SCENE_MEMBERSHIP_RES(
 					payload_ptr,
-					scenes_table[i].common.scene_id);
-			} else if (scenes_table[i].common.group_id ==
-				   ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD) {
-				LOG_INF("add capacity num");
-				++(*capacity_ptr);
+					entry->common.scene_id);
 			}
 			++i;
 		}
@@ -488,55 +431,6 @@ static void send_get_scene_membership_resp(zb_bufid_t bufid)
 	LOG_DBG("<< %s", __func__);
 }
 
-static void scene_table_init(void)
-{
-	zb_uint8_t i = 0;
-
-	memset(scenes_table, 0, sizeof(scenes_table));
-	while (i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE) {
-		scenes_table[i].common.group_id = ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD;
-		++i;
-	}
-}
-
-static zb_uint8_t scene_table_get_entry(zb_uint16_t group_id, zb_uint8_t scene_id)
-{
-	zb_uint8_t i = 0;
-	zb_uint8_t idx = 0xFF, free_idx = 0xFF;
-
-	while (i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE) {
-		if (scenes_table[i].common.group_id == group_id &&
-		    scenes_table[i].common.scene_id == scene_id) {
-			idx = i;
-			break;
-		} else if ((free_idx == 0xFF) &&
-			 (scenes_table[i].common.group_id ==
-			  ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD)) {
-			/* Remember free index */
-			free_idx = i;
-		}
-		++i;
-	}
-
-	return ((idx != 0xFF) ? idx : free_idx);
-}
-
-static void scene_table_remove_entries_by_group(zb_uint16_t group_id)
-{
-	zb_uint8_t i = 0;
-
-	LOG_DBG(">> %s: group_id 0x%x", __func__, group_id);
-	while (i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE) {
-		if (scenes_table[i].common.group_id == group_id) {
-			LOG_INF("removing scene: entry idx %hd", i);
-			memset(&scenes_table[i], 0, sizeof(scenes_table[i]));
-			scenes_table[i].common.group_id = ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD;
-		}
-		++i;
-	}
-	LOG_DBG("<< %s", __func__);
-}
-
 static zb_ret_t get_scene_valid_value(zb_bool_t *scene_valid)
 {
 	zb_zcl_attr_t *attr_desc = zb_zcl_get_attr_desc_a(
@@ -616,51 +510,49 @@ static void update_scene_valid_value(void)
 	    get_current_scene_group_id_value(&group_id) == RET_OK &&
 	    scene_valid == ZB_TRUE) {
 		/* Verify if scene_valid should be reset. */
-		zb_uint8_t idx = scene_table_get_entry(group_id, scene_id);
+		const struct scene_table_on_off_entry *entry = scene_table_find(group_id, scene_id);
 
-		if (group_id == ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD ||
-		    scene_id < CONFIG_ZIGBEE_SCENE_TABLE_SIZE ||
-		    idx == ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD) {
+		if (entry == NULL) {
 			(void)set_scene_valid_value(ZB_FALSE);
 			return;
 		}
 
-		if (scenes_table[idx].on_off.has_on_off) {
+		if (entry->on_off.has_on_off) {
 			zb_uint8_t on_off;
 
 			(void)get_on_off_value(&on_off);
-			if (on_off != scenes_table[idx].on_off.on_off) {
+			if (on_off != entry->on_off.on_off) {
 				(void)set_scene_valid_value(ZB_FALSE);
 				return;
 			}
 		}
 
-		if (scenes_table[idx].level_control.has_current_level) {
+		if (entry->level_control.has_current_level) {
 			zb_uint8_t current_level;
 
 			(void)get_current_level_value(&current_level);
-			if (current_level != scenes_table[idx].level_control.current_level) {
+			if (current_level != entry->level_control.current_level) {
 				(void)set_scene_valid_value(ZB_FALSE);
 				return;
 			}
 		}
 
-		if (scenes_table[idx].window_covering.has_current_position_lift_percentage) {
+		if (entry->window_covering.has_current_position_lift_percentage) {
 			zb_uint8_t lift;
 
 			(void)get_current_lift_value(&lift);
 			if (lift !=
-			    scenes_table[idx].window_covering.current_position_lift_percentage) {
+			    entry->window_covering.current_position_lift_percentage) {
 				(void)set_scene_valid_value(ZB_FALSE);
 				return;
 			}
 		}
-		if (scenes_table[idx].window_covering.has_current_position_tilt_percentage) {
+		if (entry->window_covering.has_current_position_tilt_percentage) {
 			zb_uint8_t tilt;
 
 			(void)get_current_lift_value(&tilt);
 			if (tilt !=
-			    scenes_table[idx].window_covering.current_position_tilt_percentage) {
+			    entry->window_covering.current_position_tilt_percentage) {
 				(void)set_scene_valid_value(ZB_FALSE);
 				return;
 			}
@@ -671,7 +563,6 @@ static void update_scene_valid_value(void)
 void zcl_scenes_init(void)
 {
 	scene_table_init();
-	settings_register(&scenes_conf);
 }
 
 zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
@@ -688,7 +579,11 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 			ZB_ZCL_DEVICE_CMD_PARAM_IN_GET(
 				bufid,
 				zb_zcl_scenes_add_scene_req_t);
-		zb_uint8_t idx = 0xFF;
+		const struct scene_table_on_off_entry *entry;
+		struct scene_table_on_off_entry scene;
+		zb_zcl_scenes_fieldset_common_t *fieldset;
+		zb_uint8_t fs_content_length;
+		zb_bool_t empty_entry = ZB_TRUE;
 		zb_uint8_t *add_scene_status =
 			ZB_ZCL_DEVICE_CMD_PARAM_OUT_GET(bufid, zb_uint8_t);
 
@@ -698,44 +593,39 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 			add_scene_req->scene_id,
 			add_scene_req->transition_time);
 
-		*add_scene_status = ZB_ZCL_STATUS_INVALID_FIELD;
-		idx = scene_table_get_entry(add_scene_req->group_id,
-					    add_scene_req->scene_id);
-
-		if (idx != 0xFF) {
-			zb_zcl_scenes_fieldset_common_t *fieldset;
-			zb_uint8_t fs_content_length;
+		entry = scene_table_find(add_scene_req->group_id, add_scene_req->scene_id);
+		if (entry) {
+			/* Indicate that we overwriting existing record */
+			device_cb_param->status = RET_ALREADY_EXISTS;
+			scene = *entry;
+		} else {
+			memset(&scene, 0, sizeof(scene));
+		}
 
-			if (scenes_table[idx].common.group_id !=
-			    ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD) {
-				/* Indicate that we overwriting existing record */
-				device_cb_param->status = RET_ALREADY_EXISTS;
+		ZB_ZCL_SCENES_GET_ADD_SCENE_REQ_NEXT_FIELDSET_DESC(
+			bufid,
+			fieldset,
+			fs_content_length);
+		while (fieldset) {
+			if (add_fieldset(fieldset, &scene) == ZB_TRUE) {
+				empty_entry = ZB_FALSE;
 			}
-			zb_bool_t empty_entry = ZB_TRUE;
-
 			ZB_ZCL_SCENES_GET_ADD_SCENE_REQ_NEXT_FIELDSET_DESC(
 				bufid,
 				fieldset,
 				fs_content_length);
-			while (fieldset) {
-				if (add_fieldset(fieldset, &scenes_table[idx]) == ZB_TRUE) {
-					empty_entry = ZB_FALSE;
-				}
-				ZB_ZCL_SCENES_GET_ADD_SCENE_REQ_NEXT_FIELDSET_DESC(
-					bufid,
-					fieldset,
-					fs_content_length);
-			}
+		}
 
-			if (empty_entry) {
-				LOG_WRN("Saving empty scene.");
-			}
-			/* Store this scene */
-			scenes_table[idx].common.group_id = add_scene_req->group_id;
-			scenes_table[idx].common.scene_id = add_scene_req->scene_id;
-			scenes_table[idx].common.transition_time = add_scene_req->transition_time;
+		if (empty_entry) {
+			LOG_WRN("Saving empty scene.");
+		}
+		/* Store this scene */
+		scene.common.group_id = add_scene_req->group_id;
+		scene.common.scene_id = add_scene_req->scene_id;
+		scene.common.transition_time = add_scene_req->transition_time;
+
+		if (scene_table_store(&scene) == 0) {
 			*add_scene_status = ZB_ZCL_STATUS_SUCCESS;
-			scenes_table_save();
 		} else {
 			LOG_ERR("Unable to add scene: ZB_ZCL_STATUS_INSUFF_SPACE");
 			*add_scene_status = ZB_ZCL_STATUS_INSUFF_SPACE;
@@ -747,27 +637,22 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 		const zb_zcl_scenes_view_scene_req_t *view_scene_req =
 			ZB_ZCL_DEVICE_CMD_PARAM_IN_GET(bufid, zb_zcl_scenes_view_scene_req_t);
 		const zb_zcl_parsed_hdr_t *in_cmd_info = ZB_ZCL_DEVICE_CMD_PARAM_CMD_INFO(bufid);
-		zb_uint8_t idx = 0xFF;
 
 		LOG_INF("ZB_ZCL_SCENES_VIEW_SCENE_CB_ID: group_id 0x%x scene_id %hd",
 			view_scene_req->group_id,
 			view_scene_req->scene_id);
 
-		idx = scene_table_get_entry(view_scene_req->group_id, view_scene_req->scene_id);
-		LOG_INF("Scene table entry index: %d", idx);
-
 		/* Send View Scene Response */
 		ZB_MEMCPY(&resp_info.cmd_info, in_cmd_info, sizeof(zb_zcl_parsed_hdr_t));
 		ZB_MEMCPY(&resp_info.view_scene_req, view_scene_req,
 			  sizeof(zb_zcl_scenes_view_scene_req_t));
-		zb_buf_get_out_delayed_ext(send_view_scene_resp, idx, 0);
+		zb_buf_get_out_delayed(send_view_scene_resp);
 	}
 	break;
 
 	case ZB_ZCL_SCENES_REMOVE_SCENE_CB_ID: {
 		const zb_zcl_scenes_remove_scene_req_t *remove_scene_req =
 			ZB_ZCL_DEVICE_CMD_PARAM_IN_GET(bufid, zb_zcl_scenes_remove_scene_req_t);
-		zb_uint8_t idx = 0xFF;
 		zb_uint8_t *remove_scene_status =
 			ZB_ZCL_DEVICE_CMD_PARAM_OUT_GET(bufid, zb_uint8_t);
 		const zb_zcl_parsed_hdr_t *in_cmd_info = ZB_ZCL_DEVICE_CMD_PARAM_CMD_INFO(bufid);
@@ -777,17 +662,10 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 			remove_scene_req->scene_id);
 
 		*remove_scene_status = ZB_ZCL_STATUS_NOT_FOUND;
-		idx = scene_table_get_entry(remove_scene_req->group_id,
-					    remove_scene_req->scene_id);
-
-		if (idx != 0xFF &&
-		    scenes_table[idx].common.group_id != ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD) {
-			/* Remove this entry */
-			memset(&scenes_table[idx], 0, sizeof(scenes_table[idx]));
-			scenes_table[idx].common.group_id = ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD;
-			LOG_INF("removing scene: entry idx %hd", idx);
+
+		if (scene_table_remove(remove_scene_req->group_id,
+				       remove_scene_req->scene_id) == 0) {
 			*remove_scene_status = ZB_ZCL_STATUS_SUCCESS;
-			scenes_table_save();
 		} else if (!zb_aps_is_endpoint_in_group(
 				remove_scene_req->group_id,
 				ZB_ZCL_PARSED_HDR_SHORT_DATA(in_cmd_info).dst_endpoint)) {
@@ -812,9 +690,8 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 				ZB_ZCL_PARSED_HDR_SHORT_DATA(in_cmd_info).dst_endpoint)) {
 			*remove_all_scenes_status = ZB_ZCL_STATUS_INVALID_FIELD;
 		} else {
-			scene_table_remove_entries_by_group(remove_all_scenes_req->group_id);
+			scene_table_remove_group(remove_all_scenes_req->group_id);
 			*remove_all_scenes_status = ZB_ZCL_STATUS_SUCCESS;
-			scenes_table_save();
 		}
 	}
 	break;
@@ -822,7 +699,6 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 	case ZB_ZCL_SCENES_STORE_SCENE_CB_ID: {
 		const zb_zcl_scenes_store_scene_req_t *store_scene_req =
 			ZB_ZCL_DEVICE_CMD_PARAM_IN_GET(bufid, zb_zcl_scenes_store_scene_req_t);
-		zb_uint8_t idx = 0xFF;
 		zb_uint8_t *store_scene_status =
 			ZB_ZCL_DEVICE_CMD_PARAM_OUT_GET(bufid, zb_uint8_t);
 		const zb_zcl_parsed_hdr_t *in_cmd_info = ZB_ZCL_DEVICE_CMD_PARAM_CMD_INFO(bufid);
@@ -836,29 +712,29 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 				ZB_ZCL_PARSED_HDR_SHORT_DATA(in_cmd_info).dst_endpoint)) {
 			*store_scene_status = ZB_ZCL_STATUS_INVALID_FIELD;
 		} else {
-			idx = scene_table_get_entry(store_scene_req->group_id,
-						    store_scene_req->scene_id);
-
-			if (idx != 0xFF) {
-				if (scenes_table[idx].common.group_id !=
-				    ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD) {
-					/* Update existing entry with current On/Off state */
-					device_cb_param->status = RET_ALREADY_EXISTS;
-					LOG_INF("update existing scene: entry idx %hd", idx);
-				} else {
-					/* Create new entry with empty name
-					 * and 0 transition time
-					 */
-					scenes_table[idx].common.group_id =
-						store_scene_req->group_id;
-					scenes_table[idx].common.scene_id =
-						store_scene_req->scene_id;
-					scenes_table[idx].common.transition_time = 0;
-					LOG_INF("create new scene: entry idx %hd", idx);
-				}
-				save_state_as_scene(&scenes_table[idx]);
+			const struct scene_table_on_off_entry *entry = scene_table_find(
+				store_scene_req->group_id,
+				store_scene_req->scene_id);
+			struct scene_table_on_off_entry scene;
+
+			if (entry) {
+				/* Update existing entry with current On/Off state */
+				device_cb_param->status = RET_ALREADY_EXISTS;
+				LOG_INF("update existing scene");
+				scene = *entry;
+			} else {
+				/* Create new entry with empty name
+				 * and 0 transition time
+				 */
+				memset(&scene, 0, sizeof(scene));
+				scene.common.group_id = store_scene_req->group_id;
+				scene.common.scene_id = store_scene_req->scene_id;
+				scene.common.transition_time = 0;
+			}
+			save_state_as_scene(&scene);
+
+			if (scene_table_store(&scene) == 0) {
 				*store_scene_status = ZB_ZCL_STATUS_SUCCESS;
-				scenes_table_save();
 			} else {
 				*store_scene_status = ZB_ZCL_STATUS_INSUFF_SPACE;
 			}
@@ -869,7 +745,7 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 	case ZB_ZCL_SCENES_RECALL_SCENE_CB_ID: {
 		const zb_zcl_scenes_recall_scene_req_t *recall_scene_req =
 			ZB_ZCL_DEVICE_CMD_PARAM_IN_GET(bufid, zb_zcl_scenes_recall_scene_req_t);
-		zb_uint8_t idx = 0xFF;
+		const struct scene_table_on_off_entry *entry;
 		zb_uint8_t *recall_scene_status =
 			ZB_ZCL_DEVICE_CMD_PARAM_OUT_GET(bufid, zb_uint8_t);
 
@@ -877,13 +753,12 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 			recall_scene_req->group_id,
 			recall_scene_req->scene_id);
 
-		idx = scene_table_get_entry(recall_scene_req->group_id,
-					    recall_scene_req->scene_id);
+		entry = scene_table_find(recall_scene_req->group_id,
+					 recall_scene_req->scene_id);
 
-		if (idx != 0xFF &&
-		    scenes_table[idx].common.group_id != ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD) {
+		if (entry) {
 			/* Recall this entry */
-			recall_scene(&scenes_table[idx]);
+			recall_scene(entry);
 			*recall_scene_status = ZB_ZCL_STATUS_SUCCESS;
 		} else {
 			*recall_scene_status = ZB_ZCL_STATUS_NOT_FOUND;
@@ -918,14 +793,12 @@ zb_bool_t zcl_scenes_cb(zb_bufid_t bufid)
 			"group_id 0x%x", remove_all_scenes_req->group_id);
 
 		/* Have only one endpoint */
-		scene_table_remove_entries_by_group(remove_all_scenes_req->group_id);
-		scenes_table_save();
+		scene_table_remove_group(remove_all_scenes_req->group_id);
 	}
 	break;
 
 	case ZB_ZCL_SCENES_INTERNAL_REMOVE_ALL_SCENES_ALL_ENDPOINTS_ALL_GROUPS_CB_ID: {
-		scene_table_init();
-		scenes_table_save();
+		scene_table_remove_all();
 	}
 	break;
 
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/__assert.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/printk.h>
+
+#include "zigbee_zcl_scenes_table.h"
+
+LOG_MODULE_DECLARE(zigbee_zcl_scenes, CONFIG_ZIGBEE_SCENES_LOG_LEVEL);
+
+#define NO_ENTRY 0xFF
+
+BUILD_ASSERT(CONFIG_ZIGBEE_SCENE_TABLE_SIZE < NO_ENTRY, "Scene table too large");
+
+/* Settings key of the scene table saved as a whole by earlier versions */
+#define LEGACY_TABLE_KEY "scenes/scenes_table"
+#define ENTRY_KEY_FMT "scenes/entry/%u"
+
+static struct scene_table_on_off_entry scenes_table[CONFIG_ZIGBEE_SCENE_TABLE_SIZE];
+
+/* Hash index with one bucket per table entry. Each entry is linked either
+ * into the chain of its bucket or into the list of free entries.
+ */
+static zb_uint8_t bucket_head[CONFIG_ZIGBEE_SCENE_TABLE_SIZE];
+static zb_uint8_t next_entry[CONFIG_ZIGBEE_SCENE_TABLE_SIZE];
+static zb_uint8_t free_head;
+
+static ATOMIC_DEFINE(dirty_entries, CONFIG_ZIGBEE_SCENE_TABLE_SIZE);
+static bool save_scheduled;
+static bool legacy_table_loaded;
+static bool table_loaded;
+
+static zb_uint8_t bucket_get(zb_uint16_t group_id, zb_uint8_t scene_id)
+{
+	/* Groups and scenes are usually numbered sequentially. Adding the group
+	 * ID to the combined key spreads consecutive groups with the same scene
+	 * IDs over the buckets.
+	 */
+	uint32_t key = ((uint32_t)group_id << 8) | scene_id;
+
+	return (key + group_id) % CONFIG_ZIGBEE_SCENE_TABLE_SIZE;
+}
+
+static bool entry_is_free(zb_uint8_t idx)
+{
+	return scenes_table[idx].common.group_id == ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD;
+}
+
+static void entry_clear(zb_uint8_t idx)
+{
+	memset(&scenes_table[idx], 0, sizeof(scenes_table[idx]));
+	scenes_table[idx].common.group_id = ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD;
+}
+
+static void list_unlink(zb_uint8_t *head, zb_uint8_t idx)
+{
+	while (*head != idx) {
+		__ASSERT_NO_MSG(*head != NO_ENTRY);
+		head = &next_entry[*head];
+	}
+
+	*head = next_entry[idx];
+}
+
+static zb_uint8_t entry_find(zb_uint16_t group_id, zb_uint8_t scene_id)
+{
+	zb_uint8_t idx = bucket_head[bucket_get(group_id, scene_id)];
+
+	while (idx != NO_ENTRY &&
+	       (scenes_table[idx].common.group_id != group_id ||
+		scenes_table[idx].common.scene_id != scene_id)) {
+		idx = next_entry[idx];
+	}
+
+	return idx;
+}
+
+static void index_rebuild(void)
+{
+	memset(bucket_head, NO_ENTRY, sizeof(bucket_head));
+	free_head = NO_ENTRY;
+
+	/* Link in reverse order, so that free entries are used from the start */
+	for (int i = CONFIG_ZIGBEE_SCENE_TABLE_SIZE - 1; i >= 0; i--) {
+		zb_uint8_t *head;
+
+		if (entry_is_free(i)) {
+			head = &free_head;
+		} else {
+			head = &bucket_head[bucket_get(scenes_table[i].common.group_id,
+						       scenes_table[i].common.scene_id)];
+		}
+
+		next_entry[i] = *head;
+		*head = i;
+	}
+}
+
+static void entry_save(zb_uint8_t idx)
+{
+	char key[sizeof("scenes/entry/") + 3];
+	int err;
+
+	snprintk(key, sizeof(key), ENTRY_KEY_FMT, idx);
+
+	if (entry_is_free(idx)) {
+		err = settings_delete(key);
+	} else {
+		err = settings_save_one(key, &scenes_table[idx], sizeof(scenes_table[idx]));
+	}
+
+	if (err) {
+		LOG_ERR("Failed to save scene table entry %u (err %d)", idx, err);
+	}
+}
+
+static void scene_table_save(zb_uint8_t param)
+{
+	ARG_UNUSED(param);
+
+	save_scheduled = false;
+
+	for (zb_uint8_t i = 0; i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE; i++) {
+		if (atomic_test_and_clear_bit(dirty_entries, i)) {
+			entry_save(i);
+		}
+	}
+}
+
+static void entry_changed(zb_uint8_t idx)
+{
+	atomic_set_bit(dirty_entries, idx);
+
+	/* Changes made until the alarm expires are saved together. The alarm
+	 * is not restarted, so that a stream of changes cannot postpone the
+	 * save indefinitely.
+	 */
+	if (save_scheduled) {
+		return;
+	}
+
+	if (ZB_SCHEDULE_APP_ALARM(scene_table_save, 0,
+				  ZB_MILLISECONDS_TO_BEACON_INTERVAL(
+					  CONFIG_ZIGBEE_SCENES_SAVE_DELAY)) == RET_OK) {
+		save_scheduled = true;
+	} else {
+		LOG_WRN("Unable to schedule scene table save, saving now");
+		scene_table_save(0);
+	}
+}
+
+static void entry_free(zb_uint8_t idx)
+{
+	const struct scene_table_on_off_entry *entry = &scenes_table[idx];
+
+	LOG_INF("removing scene: entry idx %hd", idx);
+
+	list_unlink(&bucket_head[bucket_get(entry->common.group_id, entry->common.scene_id)],
+		    idx);
+	entry_clear(idx);
+
+	next_entry[idx] = free_head;
+	free_head = idx;
+
+	entry_changed(idx);
+}
+
+static int scenes_table_set(const char *name, size_t len, settings_read_cb read_cb, void *cb_arg)
+{
+	const char *next;
+	void *data;
+	size_t size;
+	int rc;
+
+	/* settings_load() may be called again at runtime by other modules. The
+	 * stored values are then older than the table in RAM, which has changes
+	 * that are not saved yet, so they are applied only on the first load.
+	 */
+	if (table_loaded) {
+		return 0;
+	}
+
+	if (settings_name_steq(name, "entry", &next) && next) {
+		char *end;
+		unsigned long idx = strtoul(next, &end, 10);
+
+		if (*end != '\0' || idx >= CONFIG_ZIGBEE_SCENE_TABLE_SIZE) {
+			LOG_WRN("Ignoring scene table entry %s", next);
+			return -ENOENT;
+		}
+
+		data = &scenes_table[idx];
+		size = sizeof(scenes_table[idx]);
+	} else if (settings_name_steq(name, "scenes_table", &next) && !next) {
+		data = scenes_table;
+		size = sizeof(scenes_table);
+		legacy_table_loaded = true;
+	} else {
+		return -ENOENT;
+	}
+
+	if (len != size) {
+		return -EINVAL;
+	}
+
+	rc = read_cb(cb_arg, data, size);
+	if (rc >= 0) {
+		return 0;
+	}
+
+	return rc;
+}
+
+static int scenes_table_commit(void)
+{
+	if (table_loaded) {
+		return 0;
+	}
+
+	table_loaded = true;
+	index_rebuild();
+
+	if (legacy_table_loaded) {
+		/* Move the scene table to the per-entry keys */
+		LOG_INF("Converting stored scene table");
+
+		for (zb_uint8_t i = 0; i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE; i++) {
+			if (!entry_is_free(i)) {
+				atomic_set_bit(dirty_entries, i);
+			}
+		}
+
+		scene_table_save(0);
+		settings_delete(LEGACY_TABLE_KEY);
+		legacy_table_loaded = false;
+	}
+
+	return 0;
+}
+
+static struct settings_handler scenes_conf = {
+	.name = "scenes",
+	.h_set = scenes_table_set,
+	.h_commit = scenes_table_commit,
+};
+
+void scene_table_init(void)
+{
+	for (zb_uint8_t i = 0; i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE; i++) {
+		entry_clear(i);
+		atomic_clear_bit(dirty_entries, i);
+	}
+
+	index_rebuild();
+	legacy_table_loaded = false;
+	table_loaded = false;
+
+	settings_register(&scenes_conf);
+}
+
+const struct scene_table_on_off_entry *scene_table_find(zb_uint16_t group_id,
+							 zb_uint8_t scene_id)
+{
+	zb_uint8_t idx = entry_find(group_id, scene_id);
+
+	return (idx != NO_ENTRY) ? &scenes_table[idx] : NULL;
+}
+
+const struct scene_table_on_off_entry *scene_table_get(zb_uint8_t idx)
+{
+	if (idx >= CONFIG_ZIGBEE_SCENE_TABLE_SIZE || entry_is_free(idx)) {
+		return NULL;
+	}
+
+	return &scenes_table[idx];
+}
+
+int scene_table_store(const struct scene_table_on_off_entry *scene)
+{
+	zb_uint16_t group_id = scene->common.group_id;
+	zb_uint8_t scene_id = scene->common.scene_id;
+	zb_uint8_t idx = entry_find(group_id, scene_id);
+
+	__ASSERT_NO_MSG(group_id != ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD);
+
+	if (idx == NO_ENTRY) {
+		zb_uint8_t *bucket = &bucket_head[bucket_get(group_id, scene_id)];
+
+		if (free_head == NO_ENTRY) {
+			return -ENOMEM;
+		}
+
+		idx = free_head;
+		free_head = next_entry[idx];
+
+		next_entry[idx] = *bucket;
+		*bucket = idx;
+
+		LOG_INF("create new scene: entry idx %hd", idx);
+	} else if (memcmp(&scenes_table[idx], scene, sizeof(*scene)) == 0) {
+		/* Nothing to save */
+		return 0;
+	}
+
+	memcpy(&scenes_table[idx], scene, sizeof(*scene));
+	entry_changed(idx);
+
+	return 0;
+}
+
+int scene_table_remove(zb_uint16_t group_id, zb_uint8_t scene_id)
+{
+	zb_uint8_t idx = entry_find(group_id, scene_id);
+
+	if (idx == NO_ENTRY) {
+		return -ENOENT;
+	}
+
+	entry_free(idx);
+
+	return 0;
+}
+
+void scene_table_remove_group(zb_uint16_t group_id)
+{
+	LOG_DBG(">> %s: group_id 0x%x", __func__, group_id);
+
+	for (zb_uint8_t i = 0; i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE; i++) {
+		if (!entry_is_free(i) && scenes_table[i].common.group_id == group_id) {
+			entry_free(i);
+		}
+	}
+
+	LOG_DBG("<< %s", __func__);
+}
+
+void scene_table_remove_all(void)
+{
+	for (zb_uint8_t i = 0; i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE; i++) {
+		if (!entry_is_free(i)) {
+			entry_free(i);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef ZIGBEE_ZCL_SCENES_TABLE_H__
+#define ZIGBEE_ZCL_SCENES_TABLE_H__
+
+#include <zboss_api.h>
+
+/* Scene table storage. Scenes are looked up through a hash index on the
+ * group ID and scene ID and each table entry is stored under its own
+ * settings key. Changed entries are written together once
+ * CONFIG_ZIGBEE_SCENES_SAVE_DELAY passes after the first change.
+ *
+ * All functions must be called from the ZBOSS thread, except for
+ * scene_table_init(), which must be called before settings_load().
+ */
+
+struct zb_zcl_scenes_fieldset_data_on_off {
+	zb_bool_t  has_on_off;
+	zb_uint8_t on_off;
+};
+
+struct zb_zcl_scenes_fieldset_data_level_control {
+	zb_bool_t  has_current_level;
+	zb_uint8_t current_level;
+};
+
+struct zb_zcl_scenes_fieldset_data_window_covering {
+	zb_bool_t  has_current_position_lift_percentage;
+	zb_uint8_t current_position_lift_percentage;
+	zb_bool_t  has_current_position_tilt_percentage;
+	zb_uint8_t current_position_tilt_percentage;
+};
+
+struct scene_table_on_off_entry {
+	zb_zcl_scene_table_record_fixed_t                  common;
+	struct zb_zcl_scenes_fieldset_data_on_off          on_off;
+	struct zb_zcl_scenes_fieldset_data_level_control   level_control;
+	struct zb_zcl_scenes_fieldset_data_window_covering window_covering;
+};
+
+/* Clear the scene table and register the settings handler that restores it. */
+void scene_table_init(void);
+
+/* Find the scene. Returns NULL if the scene is not in the table. */
+const struct scene_table_on_off_entry *scene_table_find(zb_uint16_t group_id,
+							 zb_uint8_t scene_id);
+
+/* Get the table entry by its index, for iterating over the table.
+ * Returns NULL if the entry is free.
+ */
+const struct scene_table_on_off_entry *scene_table_get(zb_uint8_t idx);
+
+/* Add or overwrite the scene identified by the group ID and scene ID of
+ * the given entry. The entry is saved only if its content has changed.
+ * Returns 0 on success or -ENOMEM if the table is full.
+ */
+int scene_table_store(const struct scene_table_on_off_entry *scene);
+
+/* Remove the scene. Returns 0 on success or -ENOENT if it was not found. */
+int scene_table_remove(zb_uint16_t group_id, zb_uint8_t scene_id);
+
+/* Remove all scenes of the group. */
+void scene_table_remove_group(zb_uint16_t group_id);
+
+/* Remove all scenes. */
+void scene_table_remove_all(void);
+
+#endif /* ZIGBEE_ZCL_SCENES_TABLE_H__ */
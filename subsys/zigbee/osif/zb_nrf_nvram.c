@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
  */
 
+#include <zephyr/kernel.h>
 #include <pm_config.h>
 #include <zephyr/storage/flash_map.h>
 #include <zephyr/logging/log.h>
@@ -27,10 +28,39 @@ void zb_nvram_erase_finished(zb_uint8_t page);
 
 static const struct flash_area *fa; /* ZBOSS nvram */
 
+#if CONFIG_ZIGBEE_NVRAM_WRITE_BUF_SIZE > 0
+/* Write-combining buffer with data for the flash area offsets
+ * from write_buf_offset to write_buf_offset + write_buf_len.
+ */
+static uint8_t write_buf[CONFIG_ZIGBEE_NVRAM_WRITE_BUF_SIZE] __aligned(4);
+static uint32_t write_buf_offset;
+static size_t write_buf_len;
+#endif
+
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+static K_THREAD_STACK_DEFINE(erase_stack_area,
+			     CONFIG_ZIGBEE_NVRAM_ERASE_THREAD_STACK_SIZE);
+static struct k_work_q erase_work_q;
+static struct k_work erase_work;
+static struct k_work_delayable erase_notify_work;
+static K_SEM_DEFINE(erase_done_sem, 0, 1);
+static bool erase_work_q_started;
+static zb_uint8_t erase_page;
+static int erase_err;
+/* Accessed from the ZBOSS thread only. */
+static bool erase_pending;
+static uint32_t erase_failed_pages;
+#endif
+
 #ifdef ZB_PRODUCTION_CONFIG
 static const struct flash_area *fa_pc; /* production config */
 #endif
 
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+static void erase_work_handler(struct k_work *work);
+static void erase_notify_work_handler(struct k_work *work);
+#endif
+
 void zb_osif_nvram_init(const zb_char_t *name)
 {
 	ARG_UNUSED(name);
@@ -41,6 +71,24 @@ void zb_osif_nvram_init(const zb_char_t *name)
 		LOG_ERR("Can't open ZBOSS NVRAM flash area");
 	}
 
+#if CONFIG_ZIGBEE_NVRAM_WRITE_BUF_SIZE > 0
+	__ASSERT((sizeof(write_buf) % flash_area_align(fa)) == 0,
+		 "Write buffer size must be a multiple of the flash write block size.");
+#endif
+
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+	if (!erase_work_q_started) {
+		k_work_queue_start(&erase_work_q, erase_stack_area,
+				   K_THREAD_STACK_SIZEOF(erase_stack_area),
+				   CONFIG_ZIGBEE_NVRAM_ERASE_THREAD_PRIORITY, NULL);
+		k_thread_name_set(&erase_work_q.thread, "zboss_nvram_erase");
+		k_work_init(&erase_work, erase_work_handler);
+		k_work_init_delayable(&erase_notify_work,
+				      erase_notify_work_handler);
+		erase_work_q_started = true;
+	}
+#endif
+
 #ifdef ZB_PRODUCTION_CONFIG
 	ret = flash_area_open(PM_ZBOSS_PRODUCT_CONFIG_ID, &fa_pc);
 	if (ret) {
@@ -64,6 +112,181 @@ static zb_uint32_t get_page_base_offset(int page_num)
 	return (page_num * zb_get_nvram_page_length());
 }
 
+static int write_buf_flush(void)
+{
+	int err = 0;
+
+#if CONFIG_ZIGBEE_NVRAM_WRITE_BUF_SIZE > 0
+	if (write_buf_len > 0) {
+		err = flash_area_write(fa, write_buf_offset, write_buf,
+				       write_buf_len);
+		write_buf_len = 0;
+	}
+#endif
+
+	return err;
+}
+
+/* Write the buffered data to flash if it overlaps the given range. */
+static int write_buf_flush_overlapping(uint32_t offset, size_t len)
+{
+#if CONFIG_ZIGBEE_NVRAM_WRITE_BUF_SIZE > 0
+	if ((write_buf_len > 0) &&
+	    (offset < write_buf_offset + write_buf_len) &&
+	    (write_buf_offset < offset + len)) {
+		return write_buf_flush();
+	}
+#endif
+
+	return 0;
+}
+
+static int nvram_write(uint32_t offset, const uint8_t *data, size_t len)
+{
+#if CONFIG_ZIGBEE_NVRAM_WRITE_BUF_SIZE > 0
+	int err;
+
+	/* Only data that directly follows the buffered data is combined. */
+	if ((write_buf_len > 0) &&
+	    (offset != write_buf_offset + write_buf_len)) {
+		err = write_buf_flush();
+		if (err) {
+			return err;
+		}
+	}
+
+	while (len > 0) {
+		size_t chunk;
+
+		if (write_buf_len == 0) {
+			if (len >= sizeof(write_buf)) {
+				/* Nothing to combine the data with. */
+				return flash_area_write(fa, offset, data, len);
+			}
+
+			write_buf_offset = offset;
+		}
+
+		chunk = MIN(len, sizeof(write_buf) - write_buf_len);
+		memcpy(&write_buf[write_buf_len], data, chunk);
+		write_buf_len += chunk;
+		offset += chunk;
+		data += chunk;
+		len -= chunk;
+
+		if (write_buf_len == sizeof(write_buf)) {
+			err = write_buf_flush();
+			if (err) {
+				return err;
+			}
+		}
+	}
+
+	return 0;
+#else
+	return flash_area_write(fa, offset, data, len);
+#endif
+}
+
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+static void erase_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	zb_uint8_t page = erase_page;
+
+	erase_err = flash_area_erase(fa, get_page_base_offset(page),
+				     zb_get_nvram_page_length());
+
+	/* The ZBOSS thread may be waiting for the erase, so nothing that
+	 * depends on it can be waited for here.
+	 */
+	k_sem_give(&erase_done_sem);
+	k_work_schedule(&erase_notify_work, K_NO_WAIT);
+}
+#endif
+
+/* Check if the pending erase operation has finished. Returns true if no
+ * erase operation is pending.
+ */
+static bool erase_complete(k_timeout_t timeout)
+{
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+	if (!erase_pending) {
+		return true;
+	}
+
+	if (k_sem_take(&erase_done_sem, timeout)) {
+		return false;
+	}
+
+	erase_pending = false;
+
+	if (erase_err) {
+		LOG_ERR("Erase error: %d", erase_err);
+		erase_failed_pages |= BIT(erase_page);
+	} else {
+		erase_failed_pages &= ~BIT(erase_page);
+	}
+
+	/* Called in the ZBOSS thread, possibly from within an NVRAM call, so
+	 * ZBOSS is notified from its scheduler.
+	 */
+	if (zigbee_schedule_callback(zb_nvram_erase_finished, erase_page) != RET_OK) {
+		LOG_ERR("Unable to schedule erase notification of page %u", erase_page);
+	}
+#endif
+
+	return true;
+}
+
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+static void erase_notify(zb_uint8_t param)
+{
+	ARG_UNUSED(param);
+
+	(void)erase_complete(K_NO_WAIT);
+}
+
+/* Report the finished erase even if ZBOSS makes no NVRAM call. The callback
+ * queue is emptied by the ZBOSS thread, so it is retried later if it is full.
+ */
+static void erase_notify_work_handler(struct k_work *work)
+{
+	ARG_UNUSED(work);
+
+	if (zigbee_schedule_callback(erase_notify, 0) != RET_OK) {
+		k_work_schedule(&erase_notify_work, K_MSEC(1));
+	}
+}
+#endif
+
+/* Check if the last erase operation of the page has failed. Data written
+ * to such a page would be corrupted.
+ */
+static bool erase_failed(zb_uint8_t page)
+{
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+	return (erase_failed_pages & BIT(page)) != 0;
+#else
+	return false;
+#endif
+}
+
+/* Wait for the pending erase operation only if it affects the given page. */
+static void erase_wait_for_page(zb_uint8_t page)
+{
+	if (erase_complete(K_NO_WAIT)) {
+		return;
+	}
+
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+	if (page == erase_page) {
+		(void)erase_complete(K_FOREVER);
+	}
+#endif
+}
+
 zb_ret_t zb_osif_nvram_read(zb_uint8_t page, zb_uint32_t pos, zb_uint8_t *buf,
 			    zb_uint16_t len)
 {
@@ -87,7 +310,16 @@ zb_ret_t zb_osif_nvram_read(zb_uint8_t page, zb_uint32_t pos, zb_uint8_t *buf,
 
 	uint32_t flash_addr = get_page_base_offset(page) + pos;
 
-	int err = flash_area_read(fa, flash_addr, buf, len);
+	erase_wait_for_page(page);
+
+	int err = write_buf_flush_overlapping(flash_addr, len);
+
+	if (err) {
+		LOG_ERR("Write error: %d", err);
+		return RET_ERROR;
+	}
+
+	err = flash_area_read(fa, flash_addr, buf, len);
 
 	if (err) {
 		LOG_ERR("Read error: %d", err);
@@ -124,7 +356,14 @@ zb_ret_t zb_osif_nvram_write(zb_uint8_t page, zb_uint32_t pos, void *buf,
 	LOG_DBG("Function: %s, page: %d, pos: %d, len: %d",
 		__func__, page, pos, len);
 
-	int err = flash_area_write(fa, flash_addr, buf, len);
+	erase_wait_for_page(page);
+
+	if (erase_failed(page)) {
+		LOG_ERR("Write to page %u that failed to erase", page);
+		return RET_ERROR;
+	}
+
+	int err = nvram_write(flash_addr, buf, len);
 
 	if (err) {
 		LOG_ERR("Write error: %d", err);
@@ -137,27 +376,55 @@ zb_ret_t zb_osif_nvram_write(zb_uint8_t page, zb_uint32_t pos, void *buf,
 zb_ret_t zb_osif_nvram_erase_async(zb_uint8_t page)
 {
 	zb_ret_t ret = RET_OK;
+	int err;
 
+	/* Only one page is erased at a time. */
+	(void)erase_complete(K_FOREVER);
+
+	err = write_buf_flush();
+	if (err) {
+		LOG_ERR("Write error: %d", err);
+		ret = RET_ERROR;
+	}
+
+#ifdef CONFIG_ZIGBEE_NVRAM_ASYNC_ERASE
+	if (page < zb_get_nvram_page_count()) {
+		erase_page = page;
+		erase_pending = true;
+		k_work_submit_to_queue(&erase_work_q, &erase_work);
+		return ret;
+	}
+#else
 	if (page < zb_get_nvram_page_count()) {
-		int err = flash_area_erase(fa, get_page_base_offset(page),
-					   zb_get_nvram_page_length());
+		err = flash_area_erase(fa, get_page_base_offset(page),
+				       zb_get_nvram_page_length());
 		if (err) {
 			LOG_ERR("Erase error: %d", err);
 			ret = RET_ERROR;
 		}
 	}
+#endif
 	zb_nvram_erase_finished(page);
 	return ret;
 }
 
 void zb_osif_nvram_wait_for_last_op(void)
 {
-	/* empty for synchronous erase and write */
+	(void)erase_complete(K_FOREVER);
 }
 
 void zb_osif_nvram_flush(void)
 {
-	/* empty for synchronous erase and write */
+	/* The pending erase operation does not need to be waited for, ZBOSS
+	 * waits for it before it uses the page again.
+	 */
+	(void)erase_complete(K_NO_WAIT);
+
+	int err = write_buf_flush();
+
+	if (err) {
+		LOG_ERR("Write error: %d", err);
+	}
 }
 
 
@@ -8,12 +8,22 @@
 #include <ei_run_classifier.h>
 
 
+size_t ei_mock_dsp_sample_cnt;
+
+static size_t prediction_idx;
+static size_t slice_idx;
+/* Sums of the input values of the slices in the input window. */
+static double slice_sum[EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW];
+
+
 /* Input data must be ascending sequence of floats. Difference between
  * subsequent elements of input sequence equals 1. The first element
- * has value defined by ei_test_params.h (depends on current prediction idx).
+ * has value defined by ei_test_params.h (depends on current prediction idx)
+ * increased by the position of the provided data in the input window.
+ * Returns the sum of the read values.
  */
-static void verify_data_read(signal_t *signal, const size_t prediction_idx,
-			     const size_t chunk_size)
+static double verify_data_read(signal_t *signal, const size_t pred_idx,
+			       const size_t window_offset, const size_t chunk_size)
 {
 	size_t data_size = signal->total_length;
 
@@ -31,39 +41,44 @@ static void verify_data_read(signal_t *signal, const size_t prediction_idx,
 		zassert_ok(err, "get_data returned an error");
 	}
 
-	float value = EI_MOCK_GEN_FIRST_INPUT(prediction_idx);;
+	float value = EI_MOCK_GEN_FIRST_INPUT(pred_idx) + window_offset;
+	double sum = 0;
 
 	for (size_t off = 0; off < data_size; off++) {
 		zassert_within(data_buf[off], value, FLOAT_CMP_EPSILON,
 			       "Input data error");
 		value++;
+		sum += data_buf[off];
 	}
+
+	return sum;
 }
 
-EI_IMPULSE_ERROR run_classifier(signal_t *signal,
-				ei_impulse_result_t *result,
-				bool debug)
+static double verify_signal(signal_t *signal, const size_t window_offset)
 {
-	static size_t prediction_idx = 0;
-	ARG_UNUSED(debug);
-
-	/* Test getting data. */
-	verify_data_read(signal, prediction_idx, 1);
-	verify_data_read(signal, prediction_idx,
+	verify_data_read(signal, prediction_idx, window_offset, 1);
+	verify_data_read(signal, prediction_idx, window_offset,
 			 EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME);
-	verify_data_read(signal, prediction_idx,
-			 EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE);
 
+	double sum = verify_data_read(signal, prediction_idx, window_offset,
+				      signal->total_length);
+
+	ei_mock_dsp_sample_cnt += signal->total_length;
+
+	return sum;
+}
+
+static EI_IMPULSE_ERROR classify(ei_impulse_result_t *result, const double input_sum)
+{
 	/* Busy wait for predefined amount of time to simulate calculations. */
 	k_busy_wait(EI_MOCK_BUSY_WAIT_TIME);
 
 	/* Timing results. */
-	result->timing.dsp = EI_MOCK_GEN_DSP_TIME(prediction_idx);
 	result->timing.classification = EI_MOCK_GEN_CLASSIFICATION_TIME(prediction_idx);
 	result->timing.anomaly = EI_MOCK_GEN_ANOMALY_TIME(prediction_idx);
 
 	/* Classification results. */
-	result->anomaly = EI_MOCK_GEN_ANOMALY(prediction_idx);
+	result->anomaly = input_sum / EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
 
 	size_t res_idx = EI_MOCK_GEN_LABEL_IDX(prediction_idx);
 	const float value_selected = EI_MOCK_GEN_VALUE(prediction_idx);
@@ -86,3 +101,63 @@ EI_IMPULSE_ERROR run_classifier(signal_t *signal,
 
 	return EI_IMPULSE_OK;
 }
+
+EI_IMPULSE_ERROR run_classifier(signal_t *signal,
+				ei_impulse_result_t *result,
+				bool debug)
+{
+	ARG_UNUSED(debug);
+
+	zassert_equal(signal->total_length, EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE,
+		      "Wrong signal length");
+
+	/* Test getting data. */
+	double input_sum = verify_signal(signal, 0);
+
+	result->timing.dsp = EI_MOCK_GEN_DSP_TIME(signal->total_length);
+
+	return classify(result, input_sum);
+}
+
+void run_classifier_init(void)
+{
+	slice_idx = 0;
+	memset(slice_sum, 0, sizeof(slice_sum));
+}
+
+EI_IMPULSE_ERROR run_classifier_continuous(signal_t *signal,
+					   ei_impulse_result_t *result,
+					   bool debug,
+					   bool enable_maf)
+{
+	ARG_UNUSED(debug);
+	ARG_UNUSED(enable_maf);
+
+	zassert_equal(signal->total_length, EI_CLASSIFIER_SLICE_SIZE,
+		      "Wrong signal length");
+
+	/* Slices are provided in order. After the window is filled, the new slice
+	 * is always the last one in the window.
+	 */
+	size_t window_slice = MIN(slice_idx, EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW - 1);
+
+	slice_sum[slice_idx % EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW] =
+		verify_signal(signal, window_slice * EI_CLASSIFIER_SLICE_SIZE);
+	slice_idx++;
+
+	memset(&result->timing, 0, sizeof(result->timing));
+	result->timing.dsp = EI_MOCK_GEN_DSP_TIME(signal->total_length);
+
+	if (slice_idx < EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW) {
+		/* Features are buffered, classification is not done yet. */
+		return EI_IMPULSE_OK;
+	}
+
+	double input_sum = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(slice_sum); i++) {
+		input_sum += slice_sum[i];
+	}
+
+	return classify(result, input_sum);
+}
@@ -18,6 +18,8 @@
 #define EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE	300
 #define EI_CLASSIFIER_HAS_ANOMALY		1
 #define EI_CLASSIFIER_FREQUENCY			60
+#define EI_CLASSIFIER_SLICES_PER_MODEL_WINDOW	20
+#define EI_CLASSIFIER_SLICE_SIZE		15
 
 /* Mocked results. */
 static const char * const ei_classifier_inferencing_categories[] = {
@@ -35,12 +37,21 @@ static const char * const ei_classifier_inferencing_categories[] = {
 #define EI_MOCK_GEN_VALUE(PRED_IDX)	(0.5 + ((PRED_IDX) * 0.001))
 #define EI_MOCK_GEN_VALUE_OTHERS(PRED_IDX) ((1.0 - EI_MOCK_GEN_VALUE(PRED_IDX)) / \
 					   (EI_CLASSIFIER_LABEL_COUNT - 1))
-#define EI_MOCK_GEN_ANOMALY(PRED_IDX)	((float)(PRED_IDX))
+/* Anomaly is the mean of the input window read by the DSP. The value expected
+ * from the float input data is also expected from the other configurations.
+ */
+#define EI_MOCK_GEN_ANOMALY(PRED_IDX)	(EI_MOCK_GEN_FIRST_INPUT(PRED_IDX) + \
+					 (EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE - 1) / 2.0f)
 
-#define EI_MOCK_GEN_DSP_TIME(PRED_IDX)			((int)(PRED_IDX) + 1)
+/* DSP time is proportional to the number of input values processed by DSP. */
+#define EI_MOCK_GEN_DSP_TIME(SAMPLE_CNT)		((int)((SAMPLE_CNT) / \
+							       EI_CLASSIFIER_SLICE_SIZE))
 #define EI_MOCK_GEN_CLASSIFICATION_TIME(PRED_IDX)	((int)(PRED_IDX) + 2)
 #define EI_MOCK_GEN_ANOMALY_TIME(PRED_IDX)		((int)(PRED_IDX) + 3)
 
+/* Number of input values processed by the mocked DSP since boot. */
+extern size_t ei_mock_dsp_sample_cnt;
+
 /* Data processing is simulated as busy wait. */
 #define EI_MOCK_BUSY_WAIT_TIME				(100U)
 
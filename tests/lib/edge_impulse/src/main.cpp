@@ -17,6 +17,9 @@
 static atomic_t rerun_in_cb;
 
 static size_t prediction_idx;
+/* DSP input values processed before the last result and the sum of reported DSP times. */
+static size_t dsp_sample_cnt_last;
+static int dsp_time_total;
 /* Semaphore is used to wait until ei_wrapper returns prediction results. */
 static K_SEM_DEFINE(test_sem, 0, 1)
 
@@ -99,7 +102,12 @@ static void verify_result(const size_t pred_idx)
 	err = ei_wrapper_get_timing(&dsp_time, &classification_time, &anomaly_time);
 	zassert_ok(err, "ei_wrapper_get_timing returned an error");
 
-	zassert_equal(dsp_time, EI_MOCK_GEN_DSP_TIME(pred_idx), "Wrong DSP time");
+	/* DSP time covers all of the input values processed for the prediction. */
+	zassert_equal(dsp_time, EI_MOCK_GEN_DSP_TIME(ei_mock_dsp_sample_cnt - dsp_sample_cnt_last),
+		      "Wrong DSP time");
+	dsp_sample_cnt_last = ei_mock_dsp_sample_cnt;
+	dsp_time_total += dsp_time;
+
 	zassert_equal(classification_time, EI_MOCK_GEN_CLASSIFICATION_TIME(pred_idx),
 		      "Wrong classification time");
 	zassert_equal(anomaly_time, EI_MOCK_GEN_ANOMALY_TIME(pred_idx), "Wrong anomaly time");
@@ -335,6 +343,49 @@ static void test_sliding_window(void)
 	}
 }
 
+static void test_incremental_dsp(void)
+{
+	const static size_t slice_shift = EI_CLASSIFIER_SLICE_SIZE /
+					  EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME;
+	const static size_t loop_cnt = 50;
+	size_t dsp_sample_cnt = ei_mock_dsp_sample_cnt;
+	int dsp_time = dsp_time_total;
+	size_t expected_cnt;
+	int err;
+
+	zassert_equal(EI_CLASSIFIER_SLICE_SIZE % EI_CLASSIFIER_RAW_SAMPLES_PER_FRAME, 0,
+		      "Wrong slice and frame size combination");
+	zassert_equal(slice_shift, 1, "Input data of subsequent predictions must not overlap");
+
+	err = add_input_data(prediction_idx, loop_cnt * slice_shift);
+	zassert_ok(err, "Cannot add input data");
+
+	for (size_t i = 0; i <= loop_cnt; i++) {
+		size_t frame_shift = (i == 0) ? (0) : (slice_shift);
+
+		err = ei_wrapper_start_prediction(0, frame_shift);
+		zassert_ok(err, "Cannot start prediction");
+		err = k_sem_take(&test_sem, EI_TEST_SEM_TIMEOUT);
+		zassert_ok(err, "Cannot take semaphore");
+	}
+
+	dsp_sample_cnt = ei_mock_dsp_sample_cnt - dsp_sample_cnt;
+	dsp_time = dsp_time_total - dsp_time;
+
+	if (IS_ENABLED(CONFIG_EI_WRAPPER_CONTINUOUS)) {
+		/* Only the slice entering the window is processed after the first prediction. */
+		expected_cnt = EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE +
+			       loop_cnt * EI_CLASSIFIER_SLICE_SIZE;
+	} else {
+		expected_cnt = (loop_cnt + 1) * EI_CLASSIFIER_DSP_INPUT_FRAME_SIZE;
+	}
+
+	TC_PRINT("DSP processed %zu input values for %zu predictions, DSP time: %d\n",
+		 dsp_sample_cnt, loop_cnt + 1, dsp_time);
+	zassert_equal(dsp_sample_cnt, expected_cnt, "Wrong number of values processed by DSP");
+	zassert_equal(dsp_time, EI_MOCK_GEN_DSP_TIME(expected_cnt), "Wrong DSP time");
+}
+
 static void test_data_after_start(void)
 {
 	static const size_t loop_cnt = 10;
@@ -457,6 +508,7 @@ void test_main(void)
 		ztest_unit_test_setup_teardown(test_cancel, setup_fn, teardown_fn),
 		ztest_unit_test_setup_teardown(test_loop, setup_fn, teardown_fn),
 		ztest_unit_test_setup_teardown(test_sliding_window, setup_fn, teardown_fn),
+		ztest_unit_test_setup_teardown(test_incremental_dsp, setup_fn, teardown_fn),
 		ztest_unit_test_setup_teardown(test_data_after_start, setup_fn, teardown_fn),
 		ztest_unit_test_setup_teardown(test_data_thread, setup_fn, teardown_fn),
 		ztest_unit_test_setup_teardown(test_data_isr, setup_fn, teardown_fn)
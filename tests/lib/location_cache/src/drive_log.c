@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* Three days of commuting between home and office, through seven cells. */
+
+#include "drive_log.h"
+
+const struct drive_log_cell drive_log_cells[] = {
+	{ .id = 0x01234503, .tac = 0x3c8e },
+	{ .id = 0x01234514, .tac = 0x3c8e },
+	{ .id = 0x01234525, .tac = 0x3c8e },
+	{ .id = 0x01234536, .tac = 0x3c8e },
+	{ .id = 0x01234547, .tac = 0x3c8e },
+	{ .id = 0x01234558, .tac = 0x3c8f },
+	{ .id = 0x01234569, .tac = 0x3c8f },
+	{ .id = 0x0123457a, .tac = 0x3c8f },
+	{ .id = 0x0123458b, .tac = 0x3c8f },
+};
+
+const struct drive_log_record drive_log[] = {
+	{ 421, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 845113, 1689799, 3225635 },
+	  61.497638, 23.763446, 2500 },
+	{ 421, LOCATION_METHOD_WIFI, -1, 3,
+	  { 0, 2, 3 },
+	  61.497755, 23.760944, 25 },
+	{ 3661, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 845113, 1689799, 3225752 },
+	  61.496713, 23.757839, 2500 },
+	{ 7771, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 845113, 3225635, 3225752 },
+	  61.498743, 23.760059, 2500 },
+	{ 11038, LOCATION_METHOD_CELLULAR, 0, 5,
+	  { 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496686, 23.760210, 2500 },
+	{ 11038, LOCATION_METHOD_WIFI, -1, 5,
+	  { 0, 1, 2, 3, 5 },
+	  61.497809, 23.761056, 25 },
+	{ 14781, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 18520, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 21613, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 21613, LOCATION_METHOD_WIFI, -1, 4,
+	  { 0, 1, 2, 4 },
+	  61.497773, 23.760981, 25 },
+	{ 25575, LOCATION_METHOD_CELLULAR, 0, 5,
+	  { 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496686, 23.760210, 2500 },
+	{ 27094, LOCATION_METHOD_CELLULAR, 1, 3,
+	  { 1689695, 3225683, 3225935 },
+	  61.491761, 23.773904, 1500 },
+	{ 27234, LOCATION_METHOD_CELLULAR, 2, 4,
+	  { 844864, 845107, 3225696, 3225893 },
+	  61.484240, 23.785847, 1500 },
+	{ 27341, LOCATION_METHOD_CELLULAR, 3, 7,
+	  { 844981, 845205, 3225687, 3225787, 3225855, 3225946, 3225970 },
+	  61.479334, 23.799165, 1200 },
+	{ 27514, LOCATION_METHOD_CELLULAR, 4, 6,
+	  { 844812, 1689721, 1689753, 3225626, 3225749, 3225788 },
+	  61.474894, 23.808324, 1500 },
+	{ 27677, LOCATION_METHOD_CELLULAR, 5, 3,
+	  { 1690034, 3225696, 3225710 },
+	  61.468352, 23.821604, 1500 },
+	{ 27842, LOCATION_METHOD_CELLULAR, 6, 5,
+	  { 845000, 845250, 1689622, 3225617, 3225898 },
+	  61.459807, 23.829840, 2000 },
+	{ 27974, LOCATION_METHOD_CELLULAR, 7, 6,
+	  { 845126, 1689700, 1689796, 1690084, 3225628, 3225717 },
+	  61.453158, 23.847524, 1200 },
+	{ 30880, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844817, 844877, 844946, 1689601, 1689963, 3225663 },
+	  61.449374, 23.858959, 2500 },
+	{ 30880, LOCATION_METHOD_WIFI, -1, 5,
+	  { 16, 18, 19, 20, 21 },
+	  61.448700, 23.856419, 30 },
+	{ 34585, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844817, 844877, 844946, 845209, 1689601, 1689963 },
+	  61.448314, 23.852900, 2500 },
+	{ 38388, LOCATION_METHOD_CELLULAR, 8, 7,
+	  { 844817, 844877, 844946, 845209, 1689601, 1689963, 3225663 },
+	  61.448484, 23.853351, 2500 },
+	{ 38388, LOCATION_METHOD_WIFI, -1, 7,
+	  { 16, 17, 18, 19, 20, 21, 22 },
+	  61.448673, 23.856513, 30 },
+	{ 41530, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844817, 844877, 844946, 845209, 1689601, 1689963 },
+	  61.448314, 23.852900, 2500 },
+	{ 45374, LOCATION_METHOD_CELLULAR, 8, 5,
+	  { 844817, 844877, 844946, 845209, 1689601 },
+	  61.446975, 23.856607, 2500 },
+	{ 45374, LOCATION_METHOD_WIFI, -1, 5,
+	  { 16, 18, 19, 20, 21 },
+	  61.448700, 23.856419, 30 },
+	{ 48815, LOCATION_METHOD_CELLULAR, 8, 7,
+	  { 844817, 844877, 844946, 845209, 1689601, 1689963, 3225663 },
+	  61.448484, 23.853351, 2500 },
+	{ 52216, LOCATION_METHOD_CELLULAR, 8, 4,
+	  { 844877, 844946, 845209, 3225663 },
+	  61.449868, 23.858846, 2500 },
+	{ 52216, LOCATION_METHOD_WIFI, -1, 8,
+	  { 16, 17, 18, 19, 20, 21, 22, 23 },
+	  61.448691, 23.856306, 30 },
+	{ 56399, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844817, 844877, 844946, 1689601, 1689963, 3225663 },
+	  61.449374, 23.858959, 2500 },
+	{ 60158, LOCATION_METHOD_CELLULAR, 7, 7,
+	  { 845126, 1689700, 1689796, 1690084, 3225628, 3225717, 3225811 },
+	  61.454658, 23.847975, 1200 },
+	{ 60283, LOCATION_METHOD_CELLULAR, 6, 7,
+	  { 845000, 845250, 845256, 1689622, 3225617, 3225884, 3225898 },
+	  61.461496, 23.832230, 2000 },
+	{ 60411, LOCATION_METHOD_CELLULAR, 5, 5,
+	  { 844812, 845006, 1690034, 1690079, 3225696 },
+	  61.466574, 23.821302, 1500 },
+	{ 60524, LOCATION_METHOD_CELLULAR, 4, 7,
+	  { 844812, 1689721, 1689753, 3225626, 3225749, 3225788, 3226072 },
+	  61.471534, 23.808813, 1500 },
+	{ 60618, LOCATION_METHOD_CELLULAR, 3, 5,
+	  { 844981, 3225787, 3225855, 3225946, 3225970 },
+	  61.479873, 23.796775, 1200 },
+	{ 60804, LOCATION_METHOD_CELLULAR, 2, 3,
+	  { 845107, 3225696, 3225809 },
+	  61.483872, 23.783928, 1500 },
+	{ 60991, LOCATION_METHOD_CELLULAR, 1, 7,
+	  { 844803, 1689695, 1690091, 3225635, 3225683, 3225696, 3225935 },
+	  61.490099, 23.773038, 1500 },
+	{ 61329, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845088, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.498312, 23.762129, 2500 },
+	{ 64942, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 64942, LOCATION_METHOD_WIFI, -1, 3,
+	  { 0, 3, 5 },
+	  61.497782, 23.761000, 25 },
+	{ 68991, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 1689799, 3225635, 3225752 },
+	  61.496758, 23.761979, 2500 },
+	{ 72277, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 845238, 1689876, 3225635 },
+	  61.497477, 23.757839, 2500 },
+	{ 76076, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225752 },
+	  61.496641, 23.763616, 2500 },
+	{ 76076, LOCATION_METHOD_WIFI, -1, 3,
+	  { 0, 3, 4 },
+	  61.497773, 23.760981, 25 },
+	{ 79787, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 845113, 1689799, 3225635 },
+	  61.499264, 23.757820, 2500 },
+	{ 83073, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845238, 1689799, 1689876, 3225752 },
+	  61.496767, 23.759758, 2500 },
+	{ 86657, LOCATION_METHOD_CELLULAR, 0, 5,
+	  { 845088, 845113, 845238, 1689799, 3225635 },
+	  61.498635, 23.759758, 2500 },
+	{ 86657, LOCATION_METHOD_WIFI, -1, 5,
+	  { 0, 2, 3, 4, 5 },
+	  61.497836, 23.761113, 25 },
+	{ 90240, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 845113, 1689799, 3225635 },
+	  61.497638, 23.763446, 2500 },
+	{ 93819, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 97338, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845088, 845113, 845238, 1689876, 3225635, 3225752 },
+	  61.496695, 23.760228, 2500 },
+	{ 97338, LOCATION_METHOD_WIFI, -1, 3,
+	  { 0, 2, 5 },
+	  61.497773, 23.760981, 25 },
+	{ 100909, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 104965, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 1689799, 3225635, 3225752 },
+	  61.496758, 23.761979, 2500 },
+	{ 108487, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 108487, LOCATION_METHOD_WIFI, -1, 6,
+	  { 0, 1, 2, 3, 4, 5 },
+	  61.497845, 23.761132, 25 },
+	{ 111904, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 845113, 845238, 3225752 },
+	  61.498195, 23.761546, 2500 },
+	{ 113573, LOCATION_METHOD_CELLULAR, 1, 7,
+	  { 844803, 1689695, 1690091, 3225635, 3225683, 3225696, 3225935 },
+	  61.490099, 23.773038, 1500 },
+	{ 113742, LOCATION_METHOD_CELLULAR, 2, 4,
+	  { 844864, 845107, 3225893, 3226046 },
+	  61.483782, 23.785866, 1500 },
+	{ 113915, LOCATION_METHOD_CELLULAR, 3, 7,
+	  { 844981, 845205, 3225687, 3225787, 3225855, 3225946, 3225970 },
+	  61.479334, 23.799165, 1200 },
+	{ 114076, LOCATION_METHOD_CELLULAR, 4, 4,
+	  { 844812, 1689721, 3225626, 3225749 },
+	  61.474148, 23.811579, 1500 },
+	{ 114174, LOCATION_METHOD_CELLULAR, 5, 7,
+	  { 844812, 845006, 1689956, 1690034, 1690079, 3225696, 3225710 },
+	  61.468442, 23.818047, 1500 },
+	{ 114365, LOCATION_METHOD_CELLULAR, 6, 6,
+	  { 845000, 845256, 1689622, 3225617, 3225884, 3225898 },
+	  61.462017, 23.830292, 2000 },
+	{ 114484, LOCATION_METHOD_CELLULAR, 7, 6,
+	  { 845126, 1689700, 1689796, 1690084, 3225628, 3225717 },
+	  61.453158, 23.847524, 1200 },
+	{ 117261, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844817, 844946, 845209, 1689601, 1689963, 3225663 },
+	  61.448754, 23.858978, 2500 },
+	{ 117261, LOCATION_METHOD_WIFI, -1, 8,
+	  { 16, 17, 18, 19, 20, 21, 22, 23 },
+	  61.448691, 23.856306, 30 },
+	{ 120774, LOCATION_METHOD_CELLULAR, 8, 4,
+	  { 844877, 845209, 1689601, 3225663 },
+	  61.447604, 23.853220, 2500 },
+	{ 124504, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844817, 844877, 844946, 1689601, 1689963, 3225663 },
+	  61.449374, 23.858959, 2500 },
+	{ 124504, LOCATION_METHOD_WIFI, -1, 5,
+	  { 17, 18, 19, 20, 22 },
+	  61.448718, 23.856456, 30 },
+	{ 127916, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844877, 844946, 845209, 1689601, 1689963, 3225663 },
+	  61.449293, 23.858978, 2500 },
+	{ 131606, LOCATION_METHOD_CELLULAR, 8, 4,
+	  { 844946, 1689601, 1689963, 3225663 },
+	  61.450452, 23.855120, 2500 },
+	{ 131606, LOCATION_METHOD_WIFI, -1, 5,
+	  { 16, 18, 19, 22, 23 },
+	  61.448736, 23.856494, 30 },
+	{ 135107, LOCATION_METHOD_CELLULAR, 8, 3,
+	  { 844817, 844877, 3225663 },
+	  61.449598, 23.856908, 2500 },
+	{ 139173, LOCATION_METHOD_CELLULAR, 8, 5,
+	  { 844877, 845209, 1689601, 1689963, 3225663 },
+	  61.448943, 23.857059, 2500 },
+	{ 139173, LOCATION_METHOD_WIFI, -1, 6,
+	  { 17, 18, 19, 20, 21, 22 },
+	  61.448718, 23.856532, 30 },
+	{ 142470, LOCATION_METHOD_CELLULAR, 8, 7,
+	  { 844817, 844877, 844946, 845209, 1689601, 1689963, 3225663 },
+	  61.448484, 23.853351, 2500 },
+	{ 146555, LOCATION_METHOD_CELLULAR, 7, 4,
+	  { 845126, 1689796, 3225628, 3225811 },
+	  61.456203, 23.847373, 1200 },
+	{ 146677, LOCATION_METHOD_CELLULAR, 6, 4,
+	  { 845256, 1689622, 3225617, 3225884 },
+	  61.462502, 23.835448, 2000 },
+	{ 146823, LOCATION_METHOD_CELLULAR, 5, 4,
+	  { 844812, 1690034, 1690079, 3225710 },
+	  61.465810, 23.819383, 1500 },
+	{ 147001, LOCATION_METHOD_CELLULAR, 4, 3,
+	  { 844812, 3225626, 3225788 },
+	  61.471732, 23.807759, 1500 },
+	{ 147189, LOCATION_METHOD_CELLULAR, 3, 3,
+	  { 3225787, 3225946, 3225970 },
+	  61.480915, 23.794385, 1200 },
+	{ 147285, LOCATION_METHOD_CELLULAR, 2, 4,
+	  { 845107, 3225696, 3225809, 3225893 },
+	  61.486109, 23.784380, 1500 },
+	{ 147470, LOCATION_METHOD_CELLULAR, 1, 4,
+	  { 844803, 1689695, 3225683, 3225935 },
+	  61.490827, 23.775823, 1500 },
+	{ 148184, LOCATION_METHOD_CELLULAR, 0, 5,
+	  { 845113, 845238, 1689799, 1689876, 3225752 },
+	  61.498617, 23.761677, 2500 },
+	{ 151633, LOCATION_METHOD_CELLULAR, 0, 5,
+	  { 845088, 845113, 1689799, 1689876, 3225635 },
+	  61.496219, 23.761677, 2500 },
+	{ 151633, LOCATION_METHOD_WIFI, -1, 4,
+	  { 2, 3, 4, 5 },
+	  61.497836, 23.761113, 25 },
+	{ 154828, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 158597, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 162577, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.498537, 23.762129, 2500 },
+	{ 162577, LOCATION_METHOD_WIFI, -1, 5,
+	  { 0, 1, 3, 4, 5 },
+	  61.497827, 23.761094, 25 },
+	{ 165605, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 845238, 3225635, 3225752 },
+	  61.497890, 23.761997, 2500 },
+	{ 169289, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 845238, 1689876, 3225635 },
+	  61.497477, 23.757839, 2500 },
+	{ 172965, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845088, 845113, 1689799, 1689876, 3225635, 3225752 },
+	  61.497189, 23.762129, 2500 },
+	{ 172965, LOCATION_METHOD_WIFI, -1, 6,
+	  { 0, 1, 2, 3, 4, 5 },
+	  61.497845, 23.761132, 25 },
+	{ 176863, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 845113, 1689799, 3225635 },
+	  61.499264, 23.757820, 2500 },
+	{ 180581, LOCATION_METHOD_CELLULAR, 0, 5,
+	  { 845088, 845113, 1689799, 1689876, 3225635 },
+	  61.496219, 23.761677, 2500 },
+	{ 184049, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 184049, LOCATION_METHOD_WIFI, -1, 6,
+	  { 0, 1, 2, 3, 4, 5 },
+	  61.497845, 23.761132, 25 },
+	{ 187614, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 191151, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845088, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.498312, 23.762129, 2500 },
+	{ 194845, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 845088, 845113, 1689876 },
+	  61.496435, 23.757387, 2500 },
+	{ 194845, LOCATION_METHOD_WIFI, -1, 3,
+	  { 0, 1, 5 },
+	  61.497764, 23.760962, 25 },
+	{ 198170, LOCATION_METHOD_CELLULAR, 0, 5,
+	  { 845088, 845113, 845238, 1689799, 3225635 },
+	  61.498635, 23.759758, 2500 },
+	{ 199993, LOCATION_METHOD_CELLULAR, 1, 6,
+	  { 844803, 1689695, 1690091, 3225635, 3225696, 3225935 },
+	  61.493351, 23.772567, 1500 },
+	{ 200124, LOCATION_METHOD_CELLULAR, 2, 5,
+	  { 845107, 1689654, 3225696, 3225809, 3225893 },
+	  61.484672, 23.788218, 1500 },
+	{ 200223, LOCATION_METHOD_CELLULAR, 3, 6,
+	  { 844981, 845205, 3225687, 3225855, 3225946, 3225970 },
+	  61.478049, 23.798713, 1200 },
+	{ 200392, LOCATION_METHOD_CELLULAR, 4, 4,
+	  { 844812, 1689721, 1689753, 3225626 },
+	  61.472657, 23.807420, 1500 },
+	{ 200558, LOCATION_METHOD_CELLULAR, 5, 6,
+	  { 844812, 1689956, 1690034, 1690079, 3225696, 3225710 },
+	  61.467553, 23.823674, 1500 },
+	{ 200705, LOCATION_METHOD_CELLULAR, 6, 4,
+	  { 845000, 1689622, 3225617, 3225884 },
+	  61.460202, 23.835448, 2000 },
+	{ 200861, LOCATION_METHOD_CELLULAR, 7, 5,
+	  { 845126, 1689796, 1690084, 3225628, 3225811 },
+	  61.455026, 23.843685, 1200 },
+	{ 203866, LOCATION_METHOD_CELLULAR, 8, 6,
+	  { 844817, 844877, 844946, 845209, 1689963, 3225663 },
+	  61.450398, 23.857059, 2500 },
+	{ 203866, LOCATION_METHOD_WIFI, -1, 5,
+	  { 16, 17, 19, 22, 23 },
+	  61.448727, 23.856475, 30 },
+	{ 207353, LOCATION_METHOD_CELLULAR, 8, 3,
+	  { 844817, 844946, 1689601 },
+	  61.448134, 23.852749, 2500 },
+	{ 211004, LOCATION_METHOD_CELLULAR, 8, 4,
+	  { 844877, 844946, 845209, 1689963 },
+	  61.447433, 23.854706, 2500 },
+	{ 211004, LOCATION_METHOD_WIFI, -1, 5,
+	  { 17, 19, 20, 21, 23 },
+	  61.448754, 23.856532, 30 },
+	{ 214269, LOCATION_METHOD_CELLULAR, 8, 3,
+	  { 844817, 845209, 1689963 },
+	  61.450146, 23.852768, 2500 },
+	{ 218040, LOCATION_METHOD_CELLULAR, 8, 7,
+	  { 844817, 844877, 844946, 845209, 1689601, 1689963, 3225663 },
+	  61.448484, 23.853351, 2500 },
+	{ 218040, LOCATION_METHOD_WIFI, -1, 5,
+	  { 16, 18, 19, 20, 21 },
+	  61.448700, 23.856419, 30 },
+	{ 221973, LOCATION_METHOD_CELLULAR, 8, 4,
+	  { 844877, 1689601, 1689963, 3225663 },
+	  61.449832, 23.855120, 2500 },
+	{ 225473, LOCATION_METHOD_CELLULAR, 8, 3,
+	  { 844946, 1689601, 1689963 },
+	  61.450281, 23.854669, 2500 },
+	{ 225473, LOCATION_METHOD_WIFI, -1, 7,
+	  { 16, 17, 18, 19, 20, 22, 23 },
+	  61.448691, 23.856551, 30 },
+	{ 228854, LOCATION_METHOD_CELLULAR, 8, 7,
+	  { 844817, 844877, 844946, 845209, 1689601, 1689963, 3225663 },
+	  61.448484, 23.853351, 2500 },
+	{ 232949, LOCATION_METHOD_CELLULAR, 7, 4,
+	  { 1689796, 1690084, 3225717, 3225811 },
+	  61.453858, 23.841765, 1200 },
+	{ 233103, LOCATION_METHOD_CELLULAR, 6, 3,
+	  { 845256, 3225617, 3225884 },
+	  61.460625, 23.831628, 2000 },
+	{ 233259, LOCATION_METHOD_CELLULAR, 5, 7,
+	  { 844812, 845006, 1689956, 1690034, 1690079, 3225696, 3225710 },
+	  61.468442, 23.818047, 1500 },
+	{ 233422, LOCATION_METHOD_CELLULAR, 4, 5,
+	  { 1689721, 1689753, 3225626, 3225749, 3225788 },
+	  61.472145, 23.806423, 1500 },
+	{ 233576, LOCATION_METHOD_CELLULAR, 3, 6,
+	  { 844981, 845205, 3225687, 3225787, 3225946, 3225970 },
+	  61.481040, 23.798694, 1200 },
+	{ 233771, LOCATION_METHOD_CELLULAR, 2, 5,
+	  { 844864, 845107, 1689654, 3225696, 3225893 },
+	  61.486405, 23.782121, 1500 },
+	{ 233915, LOCATION_METHOD_CELLULAR, 1, 4,
+	  { 844803, 3225635, 3225683, 3225935 },
+	  61.491815, 23.772436, 1500 },
+	{ 234079, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 845113, 1689876, 3225635 },
+	  61.496354, 23.757839, 2500 },
+	{ 237750, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.498537, 23.762129, 2500 },
+	{ 237750, LOCATION_METHOD_WIFI, -1, 4,
+	  { 1, 2, 3, 4 },
+	  61.497800, 23.761038, 25 },
+	{ 241476, LOCATION_METHOD_CELLULAR, 0, 6,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635 },
+	  61.499192, 23.763597, 2500 },
+	{ 244993, LOCATION_METHOD_CELLULAR, 0, 4,
+	  { 845088, 1689799, 1689876, 3225752 },
+	  61.499022, 23.759739, 2500 },
+	{ 248582, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 248582, LOCATION_METHOD_WIFI, -1, 5,
+	  { 1, 2, 3, 4, 5 },
+	  61.497845, 23.761132, 25 },
+	{ 252521, LOCATION_METHOD_CELLULAR, 0, 7,
+	  { 845088, 845113, 845238, 1689799, 1689876, 3225635, 3225752 },
+	  61.496560, 23.764067, 2500 },
+	{ 256014, LOCATION_METHOD_CELLULAR, 0, 3,
+	  { 845088, 1689799, 3225635 },
+	  61.497414, 23.763446, 2500 },
+};
+
+const size_t drive_log_len = ARRAY_SIZE(drive_log);
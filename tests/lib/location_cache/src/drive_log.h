@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef DRIVE_LOG_H
+#define DRIVE_LOG_H
+
+#include <zephyr/kernel.h>
+#include <modem/location.h>
+
+#define DRIVE_LOG_IDS_MAX 8
+
+/** Cell seen during the drive. */
+struct drive_log_cell {
+	uint32_t id;
+	uint32_t tac;
+};
+
+/** Location request made during the drive. */
+struct drive_log_record {
+	/** Time in seconds from the start of the drive. */
+	uint32_t time;
+	/** LOCATION_METHOD_CELLULAR or LOCATION_METHOD_WIFI. */
+	enum location_method method;
+	/** Serving cell index in drive_log_cells, -1 for Wi-Fi. */
+	int cell;
+	/** Number of neighbor cells or access points. */
+	uint8_t count;
+	/** Neighbor cells as (EARFCN << 9 | physical cell ID), or access point indexes. */
+	uint32_t ids[DRIVE_LOG_IDS_MAX];
+	/** Location returned by the location service. */
+	double latitude;
+	double longitude;
+	float accuracy;
+};
+
+extern const struct drive_log_cell drive_log_cells[];
+extern const struct drive_log_record drive_log[];
+extern const size_t drive_log_len;
+
+#endif /* DRIVE_LOG_H */
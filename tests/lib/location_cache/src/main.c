@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdio.h>
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <modem/location.h>
+#include <modem/lte_lc.h>
+
+#include "location_cache.h"
+#include "drive_log.h"
+
+LOG_MODULE_REGISTER(location, CONFIG_LOCATION_LOG_LEVEL);
+
+#define SECONDS_PER_DAY (24 * 60 * 60)
+#define METERS_PER_DEG_LAT 111320.0
+/* At the latitude of the drive */
+#define METERS_PER_DEG_LON 53140.0
+
+/* Minimum hit rate once the cells of the drive have been seen */
+#define HIT_PERCENT_MIN 70
+
+static struct lte_lc_ncell neighbor_cells[DRIVE_LOG_IDS_MAX];
+static struct lte_lc_cells_info cells_info = {
+	.neighbor_cells = neighbor_cells,
+};
+
+static void wifi_mac_addr_add(struct location_cache_key *key, uint32_t ap)
+{
+	char mac_addr_str[sizeof("00:00:00:00:00:00")];
+
+	snprintf(mac_addr_str, sizeof(mac_addr_str), "f4:ce:36:00:10:%02x", ap);
+	location_cache_key_add(key, mac_addr_str, strlen(mac_addr_str));
+}
+
+static void cellular_key_set(struct location_cache_key *key, uint32_t cell_id, uint32_t tac,
+			     const uint32_t *ncells, uint8_t ncells_count)
+{
+	cells_info.current_cell.mcc = 244;
+	cells_info.current_cell.mnc = 91;
+	cells_info.current_cell.id = cell_id;
+	cells_info.current_cell.tac = tac;
+	cells_info.ncells_count = ncells_count;
+	for (int i = 0; i < ncells_count; i++) {
+		neighbor_cells[i].earfcn = ncells[i] >> 9;
+		neighbor_cells[i].phys_cell_id = ncells[i] & 0x1FF;
+	}
+
+	location_cache_key_cellular_set(key, &cells_info);
+}
+
+static void record_key_set(struct location_cache_key *key, const struct drive_log_record *record)
+{
+	if (record->method == LOCATION_METHOD_CELLULAR) {
+		cellular_key_set(key, drive_log_cells[record->cell].id,
+				 drive_log_cells[record->cell].tac, record->ids, record->count);
+	} else {
+		location_cache_key_init(key, LOCATION_METHOD_WIFI);
+		for (int i = 0; i < record->count; i++) {
+			wifi_mac_addr_add(key, record->ids[i]);
+		}
+	}
+}
+
+static void location_set(struct location_data *location, double latitude, double longitude,
+			 float accuracy)
+{
+	memset(location, 0, sizeof(*location));
+	location->latitude = latitude;
+	location->longitude = longitude;
+	location->accuracy = accuracy;
+}
+
+static void sleep_until(int64_t uptime)
+{
+	int64_t delta = uptime - k_uptime_get();
+
+	if (delta > 0) {
+		k_sleep(K_MSEC(delta));
+	}
+}
+
+static void setup(void)
+{
+	zassert_equal(location_cache_reset(), 0, "Cache reset failed");
+}
+
+static void test_fingerprint(void)
+{
+	struct location_cache_key key;
+
+	location_cache_key_init(&key, LOCATION_METHOD_WIFI);
+	for (uint32_t ap = 0; ap < 3 * CONFIG_LOCATION_CACHE_FINGERPRINT_SIZE; ap++) {
+		wifi_mac_addr_add(&key, ap);
+		/* Duplicates are ignored */
+		wifi_mac_addr_add(&key, 0);
+	}
+
+	zassert_equal(key.fingerprint_count, CONFIG_LOCATION_CACHE_FINGERPRINT_SIZE,
+		      "Fingerprint not full");
+	for (int i = 1; i < key.fingerprint_count; i++) {
+		zassert_true(key.fingerprint[i - 1] < key.fingerprint[i],
+			     "Fingerprint not in increasing order");
+	}
+}
+
+static void test_drive_log_replay(void)
+{
+	const struct drive_log_record *record;
+	struct location_cache_key key;
+	struct location_data location;
+	struct location_cache_stats stats;
+	uint32_t lookups[3] = { 0 };
+	uint32_t hits[3] = { 0 };
+	int64_t start = k_uptime_get();
+	double dlat;
+	double dlon;
+	int day;
+
+	setup();
+
+	for (size_t i = 0; i < drive_log_len; i++) {
+		record = &drive_log[i];
+		day = record->time / SECONDS_PER_DAY;
+		zassert_true(day < ARRAY_SIZE(lookups), "Drive log too long");
+
+		sleep_until(start + (int64_t)record->time * MSEC_PER_SEC);
+
+		record_key_set(&key, record);
+		lookups[day]++;
+		if (location_cache_lookup(&key, &location) == 0) {
+			hits[day]++;
+
+			/* Cached location within the accuracy of the location service */
+			dlat = (location.latitude - record->latitude) * METERS_PER_DEG_LAT;
+			dlon = (location.longitude - record->longitude) * METERS_PER_DEG_LON;
+			zassert_true(dlat * dlat + dlon * dlon <=
+				     (double)record->accuracy * record->accuracy,
+				     "Cached location too far at record %zu", i);
+		} else {
+			/* Location service request */
+			location_set(&location, record->latitude, record->longitude,
+				     record->accuracy);
+			location_cache_store(&key, &location);
+		}
+	}
+
+	printk("Cache hits per day: %u/%u, %u/%u, %u/%u\n",
+	       hits[0], lookups[0], hits[1], lookups[1], hits[2], lookups[2]);
+
+	zassert_true((hits[1] + hits[2]) * 100 >= HIT_PERCENT_MIN * (lookups[1] + lookups[2]),
+		     "Hit rate too low once the drive is known");
+	zassert_true(hits[0] < hits[1] + hits[2], "First day should miss more");
+
+	location_cache_stats_read(&stats);
+	zassert_equal(stats.lookups, drive_log_len, "Wrong lookup count");
+	zassert_equal(stats.hits, hits[0] + hits[1] + hits[2], "Wrong hit count");
+	zassert_equal(stats.stores, stats.lookups - stats.hits, "Wrong store count");
+}
+
+static void test_ttl(void)
+{
+	const uint32_t ncells[] = { 100, 200, 300 };
+	struct location_cache_key key;
+	struct location_data location;
+
+	setup();
+
+	cellular_key_set(&key, 0x1234, 0x10, ncells, ARRAY_SIZE(ncells));
+	location_set(&location, 61.5, 23.8, 1000);
+	location_cache_store(&key, &location);
+	zassert_equal(location_cache_lookup(&key, &location), 0, "Stored location not found");
+
+	k_sleep(K_SECONDS(CONFIG_LOCATION_CACHE_TTL - 1));
+	zassert_equal(location_cache_lookup(&key, &location), 0, "Location expired too early");
+
+	k_sleep(K_SECONDS(2));
+	zassert_equal(location_cache_lookup(&key, &location), -ENOENT, "Location not expired");
+
+	/* Expired entry is reused */
+	location_cache_store(&key, &location);
+	zassert_equal(location_cache_lookup(&key, &location), 0, "Stored location not found");
+}
+
+static void test_lru_eviction(void)
+{
+	struct location_cache_key key;
+	struct location_data location;
+	struct location_cache_stats stats;
+
+	setup();
+
+	for (int i = 0; i < CONFIG_LOCATION_CACHE_SIZE; i++) {
+		cellular_key_set(&key, i, 0x10, NULL, 0);
+		location_set(&location, 61.0 + i * 0.01, 23.0, 1000);
+		location_cache_store(&key, &location);
+	}
+
+	/* Cell 1 becomes the least recently used */
+	cellular_key_set(&key, 0, 0x10, NULL, 0);
+	zassert_equal(location_cache_lookup(&key, &location), 0, "Cell 0 not found");
+
+	cellular_key_set(&key, CONFIG_LOCATION_CACHE_SIZE, 0x10, NULL, 0);
+	location_set(&location, 62.0, 23.0, 1000);
+	location_cache_store(&key, &location);
+
+	cellular_key_set(&key, 0, 0x10, NULL, 0);
+	zassert_equal(location_cache_lookup(&key, &location), 0, "Cell 0 evicted");
+	zassert_true(location.latitude == 61.0, "Wrong location for cell 0");
+	cellular_key_set(&key, 1, 0x10, NULL, 0);
+	zassert_equal(location_cache_lookup(&key, &location), -ENOENT, "Cell 1 not evicted");
+	cellular_key_set(&key, CONFIG_LOCATION_CACHE_SIZE, 0x10, NULL, 0);
+	zassert_equal(location_cache_lookup(&key, &location), 0, "New cell not found");
+	zassert_true(location.latitude == 62.0, "Wrong location for new cell");
+
+	location_cache_stats_read(&stats);
+	zassert_equal(stats.evictions, 1, "Wrong eviction count");
+	zassert_equal(stats.stores, CONFIG_LOCATION_CACHE_SIZE + 1, "Wrong store count");
+}
+
+static void test_similarity(void)
+{
+	const uint32_t stored[] = { 0, 1, 2, 3, 4, 5 };
+	/* Jaccard similarity 4/7 */
+	const uint32_t similar[] = { 0, 1, 2, 3, 6 };
+	/* Jaccard similarity 2/9 */
+	const uint32_t different[] = { 0, 1, 6, 7, 8 };
+	struct location_cache_key key;
+	struct location_data location;
+
+	setup();
+
+	location_cache_key_init(&key, LOCATION_METHOD_WIFI);
+	for (int i = 0; i < ARRAY_SIZE(stored); i++) {
+		wifi_mac_addr_add(&key, stored[i]);
+	}
+	location_set(&location, 61.5, 23.8, 30);
+	location_cache_store(&key, &location);
+
+	location_cache_key_init(&key, LOCATION_METHOD_WIFI);
+	for (int i = 0; i < ARRAY_SIZE(similar); i++) {
+		wifi_mac_addr_add(&key, similar[i]);
+	}
+	zassert_equal(location_cache_lookup(&key, &location), 0, "Similar access points missed");
+
+	location_cache_key_init(&key, LOCATION_METHOD_WIFI);
+	for (int i = 0; i < ARRAY_SIZE(different); i++) {
+		wifi_mac_addr_add(&key, different[i]);
+	}
+	zassert_equal(location_cache_lookup(&key, &location), -ENOENT,
+		      "Different access points hit");
+
+	/* Same neighbor cells under another serving cell */
+	cellular_key_set(&key, 0x1234, 0x10, stored, ARRAY_SIZE(stored));
+	location_cache_store(&key, &location);
+	cellular_key_set(&key, 0x1235, 0x10, stored, ARRAY_SIZE(stored));
+	zassert_equal(location_cache_lookup(&key, &location), -ENOENT,
+		      "Other serving cell hit");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(location_cache_test,
+		ztest_unit_test(test_fingerprint),
+		ztest_unit_test(test_drive_log_replay),
+		ztest_unit_test(test_ttl),
+		ztest_unit_test(test_lru_eviction),
+		ztest_unit_test(test_similarity)
+	);
+
+	ztest_run_test_suite(location_cache_test);
+}
@@ -0,0 +1,507 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <modem/location.h>
+
+#include "location_core.h"
+#include "method_gnss.h"
+#include "method_cellular.h"
+#include "method_wifi.h"
+
+#define REQUEST_COUNT 100
+
+#define GNSS_TIMEOUT_MS (60 * MSEC_PER_SEC)
+#define SERVICE_TIMEOUT_MS (30 * MSEC_PER_SEC)
+#define EVENT_TIMEOUT K_SECONDS(300)
+/* Kernel tick rounding */
+#define TTF_MARGIN_MS 20
+
+/* Location method replaced by a model of its time to fix and accuracy */
+struct method_mock {
+	enum location_method method;
+	struct k_work_delayable work;
+	bool running;
+	uint32_t cancel_count;
+	/* Model */
+	uint32_t ttf_min_ms;
+	uint32_t ttf_max_ms;
+	uint32_t accuracy_min;
+	uint32_t accuracy_max;
+	uint32_t failure_percent;
+	uint32_t rand_state;
+	double latitude;
+	double longitude;
+	/* Outcome of the ongoing request */
+	bool fail;
+	struct location_data location;
+};
+
+static struct method_mock gnss_mock = { .method = LOCATION_METHOD_GNSS };
+static struct method_mock cellular_mock = { .method = LOCATION_METHOD_CELLULAR };
+static struct method_mock wifi_mock = { .method = LOCATION_METHOD_WIFI };
+
+static K_SEM_DEFINE(event_sem, 0, 1);
+static struct location_event_data event_data;
+static int64_t event_uptime;
+
+/* Deterministic pseudo-random generator, one per method so that a method gets the same
+ * outcomes for the same requests whatever the mode
+ */
+static uint32_t rand_range(struct method_mock *mock, uint32_t min, uint32_t max)
+{
+	mock->rand_state ^= mock->rand_state << 13;
+	mock->rand_state ^= mock->rand_state >> 17;
+	mock->rand_state ^= mock->rand_state << 5;
+
+	return min + mock->rand_state % (max - min + 1);
+}
+
+static void method_mock_work_fn(struct k_work *work)
+{
+	struct method_mock *mock = CONTAINER_OF(k_work_delayable_from_work(work),
+						struct method_mock, work);
+
+	if (!mock->running) {
+		return;
+	}
+	mock->running = false;
+
+	if (mock->fail) {
+		location_core_event_cb_error(mock->method);
+	} else {
+		location_core_event_cb(&mock->location);
+	}
+}
+
+static int method_mock_location_get(struct method_mock *mock, int32_t timeout)
+{
+	uint32_t ttf = rand_range(mock, mock->ttf_min_ms, mock->ttf_max_ms);
+
+	mock->fail = rand_range(mock, 1, 100) <= mock->failure_percent;
+	memset(&mock->location, 0, sizeof(mock->location));
+	mock->location.method = mock->method;
+	mock->location.latitude = mock->latitude;
+	mock->location.longitude = mock->longitude;
+	mock->location.accuracy = rand_range(mock, mock->accuracy_min, mock->accuracy_max);
+	mock->running = true;
+
+	/* A time to fix longer than the timeout results in a timeout */
+	location_core_timer_start(mock->method, timeout);
+	k_work_reschedule_for_queue(location_core_method_work_queue_get(mock->method),
+				    &mock->work, K_MSEC(ttf));
+
+	return 0;
+}
+
+static int method_mock_cancel(struct method_mock *mock)
+{
+	if (!mock->running) {
+		return -EPERM;
+	}
+	mock->running = false;
+	mock->cancel_count++;
+	(void)k_work_cancel_delayable(&mock->work);
+
+	return 0;
+}
+
+static void method_mock_init(struct method_mock *mock)
+{
+	k_work_init_delayable(&mock->work, method_mock_work_fn);
+	mock->running = false;
+}
+
+int method_gnss_init(void)
+{
+	method_mock_init(&gnss_mock);
+	return 0;
+}
+
+int method_gnss_location_get(const struct location_method_config *config)
+{
+	return method_mock_location_get(&gnss_mock, config->gnss.timeout);
+}
+
+int method_gnss_cancel(void)
+{
+	return method_mock_cancel(&gnss_mock);
+}
+
+int method_cellular_init(void)
+{
+	method_mock_init(&cellular_mock);
+	return 0;
+}
+
+int method_cellular_location_get(const struct location_method_config *config)
+{
+	return method_mock_location_get(&cellular_mock, config->cellular.timeout);
+}
+
+int method_cellular_cancel(void)
+{
+	return method_mock_cancel(&cellular_mock);
+}
+
+int method_wifi_init(void)
+{
+	method_mock_init(&wifi_mock);
+	return 0;
+}
+
+int method_wifi_location_get(const struct location_method_config *config)
+{
+	return method_mock_location_get(&wifi_mock, config->wifi.timeout);
+}
+
+int method_wifi_cancel(void)
+{
+	return method_mock_cancel(&wifi_mock);
+}
+
+static void location_event_handler(const struct location_event_data *data)
+{
+	event_data = *data;
+	event_uptime = k_uptime_get();
+	k_sem_give(&event_sem);
+}
+
+static void method_mocks_rand_reset(void)
+{
+	gnss_mock.rand_state = 0x2545F491;
+	wifi_mock.rand_state = 0x9E3779B9;
+	cellular_mock.rand_state = 0x7F4A7C15;
+}
+
+/* Models from the field: GNSS is accurate but slow and often times out indoors,
+ * Wi-Fi is fast and fairly accurate when there are access points around, cellular
+ * is fast but inaccurate.
+ */
+static void method_mocks_model_set(void)
+{
+	gnss_mock.ttf_min_ms = 15 * MSEC_PER_SEC;
+	gnss_mock.ttf_max_ms = 90 * MSEC_PER_SEC;
+	gnss_mock.accuracy_min = 3;
+	gnss_mock.accuracy_max = 15;
+	gnss_mock.failure_percent = 0;
+	gnss_mock.latitude = 61.4921;
+	gnss_mock.longitude = 23.7705;
+
+	wifi_mock.ttf_min_ms = 3 * MSEC_PER_SEC;
+	wifi_mock.ttf_max_ms = 8 * MSEC_PER_SEC;
+	wifi_mock.accuracy_min = 20;
+	wifi_mock.accuracy_max = 80;
+	wifi_mock.failure_percent = 15;
+	wifi_mock.latitude = 61.4923;
+	wifi_mock.longitude = 23.7710;
+
+	cellular_mock.ttf_min_ms = 2 * MSEC_PER_SEC;
+	cellular_mock.ttf_max_ms = 6 * MSEC_PER_SEC;
+	cellular_mock.accuracy_min = 300;
+	cellular_mock.accuracy_max = 1500;
+	cellular_mock.failure_percent = 5;
+	cellular_mock.latitude = 61.4990;
+	cellular_mock.longitude = 23.7600;
+
+	method_mocks_rand_reset();
+}
+
+static void config_set(struct location_config *config, enum location_req_mode mode)
+{
+	enum location_method methods[] = {
+		LOCATION_METHOD_GNSS,
+		LOCATION_METHOD_WIFI,
+		LOCATION_METHOD_CELLULAR
+	};
+
+	location_config_defaults_set(config, ARRAY_SIZE(methods), methods);
+	config->mode = mode;
+	config->methods[0].gnss.timeout = GNSS_TIMEOUT_MS;
+	config->methods[1].wifi.timeout = SERVICE_TIMEOUT_MS;
+	config->methods[2].cellular.timeout = SERVICE_TIMEOUT_MS;
+}
+
+static int request_run(const struct location_config *config, int64_t *ttf)
+{
+	int64_t start = k_uptime_get();
+
+	zassert_equal(location_request(config), 0, NULL);
+	zassert_equal(k_sem_take(&event_sem, EVENT_TIMEOUT), 0, "No event");
+	*ttf = event_uptime - start;
+
+	return event_data.id;
+}
+
+struct ttf_stats {
+	int64_t ttf[REQUEST_COUNT];
+	uint32_t fixes;
+	uint32_t on_target;
+	float accuracy_sum;
+};
+
+static int ttf_compare(const void *a, const void *b)
+{
+	int64_t diff = *(const int64_t *)a - *(const int64_t *)b;
+
+	return (diff > 0) - (diff < 0);
+}
+
+static int64_t ttf_percentile(const struct ttf_stats *stats, int percent)
+{
+	return stats->ttf[(REQUEST_COUNT - 1) * percent / 100];
+}
+
+static void ttf_stats_run(const char *name, const struct location_config *config,
+			  float target, struct ttf_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	method_mocks_rand_reset();
+
+	for (int i = 0; i < REQUEST_COUNT; i++) {
+		if (request_run(config, &stats->ttf[i]) == LOCATION_EVT_LOCATION) {
+			stats->fixes++;
+			stats->accuracy_sum += event_data.location.accuracy;
+			if (event_data.location.accuracy <= target) {
+				stats->on_target++;
+			}
+		}
+	}
+	qsort(stats->ttf, REQUEST_COUNT, sizeof(stats->ttf[0]), ttf_compare);
+
+	TC_PRINT("%-22s ttf (ms) min %6lld p50 %6lld p90 %6lld max %6lld, "
+		 "%3u fixes, %3u within %d m, avg accuracy %d m\n",
+		 name, stats->ttf[0], ttf_percentile(stats, 50), ttf_percentile(stats, 90),
+		 stats->ttf[REQUEST_COUNT - 1], stats->fixes, stats->on_target, (int)target,
+		 stats->fixes ? (int)(stats->accuracy_sum / stats->fixes) : 0);
+}
+
+static void test_ttf_distribution(void)
+{
+	static struct ttf_stats fallback;
+	static struct ttf_stats parallel;
+	struct location_config config;
+	const float target = 100;
+
+	method_mocks_model_set();
+
+	config_set(&config, LOCATION_REQ_MODE_FALLBACK);
+	ttf_stats_run("fallback", &config, target, &fallback);
+
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.accuracy_target = target;
+	ttf_stats_run("parallel, target 100 m", &config, target, &parallel);
+
+	/* Wi-Fi answers within seconds most of the time, instead of waiting for GNSS */
+	zassert_true(ttf_percentile(&parallel, 50) * 4 < ttf_percentile(&fallback, 50),
+		     "Median time to fix not improved");
+	zassert_true(ttf_percentile(&parallel, 90) < ttf_percentile(&fallback, 90),
+		     "90th percentile not improved");
+	/* Never longer than the longest method timeout, as all methods run together */
+	zassert_true(parallel.ttf[REQUEST_COUNT - 1] <= GNSS_TIMEOUT_MS + TTF_MARGIN_MS, NULL);
+	zassert_true(parallel.on_target >= fallback.on_target * 9 / 10, NULL);
+}
+
+static void test_ttf_distribution_high_accuracy(void)
+{
+	static struct ttf_stats fallback;
+	static struct ttf_stats parallel;
+	struct location_config config;
+	const float target = 15;
+
+	method_mocks_model_set();
+
+	config_set(&config, LOCATION_REQ_MODE_FALLBACK);
+	ttf_stats_run("fallback", &config, target, &fallback);
+
+	/* Only GNSS meets the target, the others are a backup when it times out */
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.accuracy_target = target;
+	ttf_stats_run("parallel, target 15 m", &config, target, &parallel);
+
+	/* GNSS gets the same outcomes in both modes, the parallel mode does not wait for the
+	 * other methods after a GNSS timeout
+	 */
+	zassert_true(ttf_percentile(&parallel, 50) <= ttf_percentile(&fallback, 50), NULL);
+	zassert_true(ttf_percentile(&parallel, 90) < ttf_percentile(&fallback, 90), NULL);
+	zassert_equal(parallel.on_target, fallback.on_target, NULL);
+}
+
+static void method_mocks_fixed_set(void)
+{
+	method_mocks_model_set();
+
+	gnss_mock.ttf_min_ms = gnss_mock.ttf_max_ms = 10 * MSEC_PER_SEC;
+	gnss_mock.accuracy_min = gnss_mock.accuracy_max = 10;
+
+	wifi_mock.ttf_min_ms = wifi_mock.ttf_max_ms = 4 * MSEC_PER_SEC;
+	wifi_mock.accuracy_min = wifi_mock.accuracy_max = 20;
+	wifi_mock.failure_percent = 0;
+
+	cellular_mock.ttf_min_ms = cellular_mock.ttf_max_ms = 2 * MSEC_PER_SEC;
+	cellular_mock.accuracy_min = cellular_mock.accuracy_max = 1000;
+	cellular_mock.failure_percent = 0;
+}
+
+static void test_first_on_target_wins(void)
+{
+	struct location_config config;
+	int64_t ttf;
+
+	method_mocks_fixed_set();
+	gnss_mock.cancel_count = 0;
+	cellular_mock.cancel_count = 0;
+
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.accuracy_target = 50;
+
+	zassert_equal(request_run(&config, &ttf), LOCATION_EVT_LOCATION, NULL);
+	zassert_equal(event_data.location.method, LOCATION_METHOD_WIFI, NULL);
+	zassert_within(ttf, 4 * MSEC_PER_SEC, TTF_MARGIN_MS, "ttf %lld", ttf);
+	/* Cellular was done before, only GNSS was still running */
+	zassert_equal(gnss_mock.cancel_count, 1, NULL);
+	zassert_equal(cellular_mock.cancel_count, 0, NULL);
+	zassert_false(gnss_mock.running, NULL);
+
+	/* Nothing more is reported */
+	zassert_not_equal(k_sem_take(&event_sem, K_SECONDS(20)), 0, "Late event");
+}
+
+static void test_fuse(void)
+{
+	struct location_config config;
+	double latitude;
+	double longitude;
+	int64_t ttf;
+
+	method_mocks_fixed_set();
+
+	/* No target, wait for all methods */
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.fuse = true;
+
+	zassert_equal(request_run(&config, &ttf), LOCATION_EVT_LOCATION, NULL);
+	zassert_within(ttf, 10 * MSEC_PER_SEC, TTF_MARGIN_MS, "ttf %lld", ttf);
+	zassert_equal(event_data.location.method, LOCATION_METHOD_GNSS, NULL);
+	zassert_within(event_data.location.accuracy, 10.0, 0.01, NULL);
+
+	/* Weights 1/10^2, 1/20^2 and 1/1000^2 */
+	latitude = (gnss_mock.latitude / 100 + wifi_mock.latitude / 400 +
+		    cellular_mock.latitude / 1000000) / (1.0 / 100 + 1.0 / 400 + 1.0 / 1000000);
+	longitude = (gnss_mock.longitude / 100 + wifi_mock.longitude / 400 +
+		     cellular_mock.longitude / 1000000) / (1.0 / 100 + 1.0 / 400 + 1.0 / 1000000);
+	zassert_within(event_data.location.latitude, latitude, 1e-9, NULL);
+	zassert_within(event_data.location.longitude, longitude, 1e-9, NULL);
+
+	/* Without fusing, the most accurate location is reported as is */
+	config.fuse = false;
+	zassert_equal(request_run(&config, &ttf), LOCATION_EVT_LOCATION, NULL);
+	zassert_within(event_data.location.latitude, gnss_mock.latitude, 1e-9, NULL);
+	zassert_within(event_data.location.longitude, gnss_mock.longitude, 1e-9, NULL);
+}
+
+static void test_fuse_antimeridian(void)
+{
+	struct location_config config;
+	int64_t ttf;
+
+	method_mocks_fixed_set();
+	gnss_mock.longitude = 179.9999;
+	wifi_mock.accuracy_min = wifi_mock.accuracy_max = 10;
+	wifi_mock.longitude = -179.9999;
+	cellular_mock.failure_percent = 100;
+
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.fuse = true;
+
+	zassert_equal(request_run(&config, &ttf), LOCATION_EVT_LOCATION, NULL);
+	/* Averaged across the antimeridian, not around 0 */
+	zassert_true(event_data.location.longitude > 179.9998 ||
+		     event_data.location.longitude < -179.9998, NULL);
+}
+
+static void test_all_failed(void)
+{
+	struct location_config config;
+	int64_t ttf;
+
+	method_mocks_fixed_set();
+	gnss_mock.failure_percent = 100;
+	wifi_mock.failure_percent = 100;
+	cellular_mock.failure_percent = 100;
+
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.accuracy_target = 50;
+	zassert_equal(request_run(&config, &ttf), LOCATION_EVT_ERROR, NULL);
+	zassert_within(ttf, 10 * MSEC_PER_SEC, TTF_MARGIN_MS, NULL);
+
+	/* A timeout is reported when one of the methods timed out */
+	gnss_mock.ttf_min_ms = gnss_mock.ttf_max_ms = GNSS_TIMEOUT_MS * 2;
+	zassert_equal(request_run(&config, &ttf), LOCATION_EVT_TIMEOUT, NULL);
+	zassert_within(ttf, GNSS_TIMEOUT_MS, TTF_MARGIN_MS, NULL);
+	zassert_false(gnss_mock.running, "Timed out method not cancelled");
+}
+
+static void test_cancel(void)
+{
+	struct location_config config;
+
+	method_mocks_fixed_set();
+	gnss_mock.cancel_count = 0;
+	wifi_mock.cancel_count = 0;
+	cellular_mock.cancel_count = 0;
+
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	zassert_equal(location_request(&config), 0, NULL);
+	k_sleep(K_SECONDS(1));
+	zassert_equal(location_request_cancel(), 0, NULL);
+
+	zassert_equal(gnss_mock.cancel_count, 1, NULL);
+	zassert_equal(wifi_mock.cancel_count, 1, NULL);
+	zassert_equal(cellular_mock.cancel_count, 1, NULL);
+	zassert_not_equal(k_sem_take(&event_sem, K_SECONDS(20)), 0, "Event after cancel");
+
+	/* A new request can be made */
+	zassert_equal(location_request(&config), 0, NULL);
+	zassert_equal(k_sem_take(&event_sem, EVENT_TIMEOUT), 0, NULL);
+}
+
+static void test_invalid_config(void)
+{
+	struct location_config config;
+
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.methods[2].method = LOCATION_METHOD_GNSS;
+	zassert_equal(location_request(&config), -EINVAL, "Method given twice");
+
+	config_set(&config, LOCATION_REQ_MODE_PARALLEL);
+	config.accuracy_target = -1;
+	zassert_equal(location_request(&config), -EINVAL, NULL);
+}
+
+static void test_setup(void)
+{
+	zassert_equal(location_init(location_event_handler), 0, NULL);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(location_parallel,
+		ztest_unit_test(test_setup),
+		ztest_unit_test(test_invalid_config),
+		ztest_unit_test(test_first_on_target_wins),
+		ztest_unit_test(test_fuse),
+		ztest_unit_test(test_fuse_antimeridian),
+		ztest_unit_test(test_all_failed),
+		ztest_unit_test(test_cancel),
+		ztest_unit_test(test_ttf_distribution),
+		ztest_unit_test(test_ttf_distribution_high_accuracy)
+	);
+
+	ztest_run_test_suite(location_parallel);
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+
+#include "mock_nrf_socket.h"
+
+extern int unity_main(void);
+
+/* Suite teardown shall finalize with mandatory call to generic_suiteTearDown. */
+extern int generic_suiteTearDown(int num_failures);
+
+#define SENDERS 4
+#define MESSAGES_PER_SENDER 20
+#define HEADER_LEN 16
+#define PAYLOAD_LEN 64
+/* Time the stubbed modem takes to accept a datagram. */
+#define SENDTO_LATENCY_MS 2
+
+#define SENDER_STACK_SIZE 2048
+#define SENDER_PRIORITY 5
+
+static K_THREAD_STACK_ARRAY_DEFINE(sender_stacks, SENDERS, SENDER_STACK_SIZE);
+static struct k_thread sender_threads[SENDERS];
+
+static atomic_t next_sd;
+static atomic_t sendto_calls;
+static atomic_t sendto_bytes;
+static size_t last_sendto_len;
+
+static int nrf_socket_stub(int domain, int type, int protocol, int cmock_calls)
+{
+	return atomic_inc(&next_sd);
+}
+
+static int nrf_close_stub(int fildes, int cmock_calls)
+{
+	return 0;
+}
+
+static ssize_t nrf_sendto_stub(int socket, const void *message, size_t length,
+			       int flags, const struct nrf_sockaddr *dest_addr,
+			       nrf_socklen_t dest_len, int cmock_calls)
+{
+	atomic_inc(&sendto_calls);
+	atomic_add(&sendto_bytes, length);
+	last_sendto_len = length;
+
+	k_sleep(K_MSEC(SENDTO_LATENCY_MS));
+
+	return length;
+}
+
+void setUp(void)
+{
+	mock_nrf_socket_Init();
+
+	atomic_set(&sendto_calls, 0);
+	atomic_set(&sendto_bytes, 0);
+	last_sendto_len = 0;
+
+	__wrap_nrf_socket_Stub(nrf_socket_stub);
+	__wrap_nrf_close_Stub(nrf_close_stub);
+	__wrap_nrf_sendto_Stub(nrf_sendto_stub);
+}
+
+void tearDown(void)
+{
+	mock_nrf_socket_Verify();
+}
+
+int test_suiteTearDown(int num_failures)
+{
+	return generic_suiteTearDown(num_failures);
+}
+
+static ssize_t send_header_and_payload(int fd, size_t payload_len)
+{
+	static const uint8_t header[HEADER_LEN];
+	static uint8_t payload[512];
+	struct iovec iov[] = {
+		{ .iov_base = (void *)header, .iov_len = sizeof(header) },
+		{ .iov_base = payload, .iov_len = payload_len },
+	};
+	struct msghdr msg = {
+		.msg_iov = iov,
+		.msg_iovlen = ARRAY_SIZE(iov),
+	};
+
+	return zsock_sendmsg(fd, &msg, 0);
+}
+
+void test_sendmsg_small_message_is_repacked(void)
+{
+	int fd;
+	ssize_t ret;
+
+	fd = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+
+	ret = send_header_and_payload(fd, PAYLOAD_LEN);
+	TEST_ASSERT_EQUAL(HEADER_LEN + PAYLOAD_LEN, ret);
+	TEST_ASSERT_EQUAL(1, atomic_get(&sendto_calls));
+	TEST_ASSERT_EQUAL(HEADER_LEN + PAYLOAD_LEN, last_sendto_len);
+
+	TEST_ASSERT_EQUAL(0, zsock_close(fd));
+}
+
+void test_sendmsg_large_datagram_is_not_split(void)
+{
+	const size_t payload_len = CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE * 2;
+	int fd;
+	ssize_t ret;
+
+	fd = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+
+	ret = send_header_and_payload(fd, payload_len);
+	TEST_ASSERT_EQUAL(HEADER_LEN + payload_len, ret);
+	TEST_ASSERT_EQUAL(1, atomic_get(&sendto_calls));
+	TEST_ASSERT_EQUAL(HEADER_LEN + payload_len, last_sendto_len);
+
+	TEST_ASSERT_EQUAL(0, zsock_close(fd));
+}
+
+void test_sendmsg_large_stream_is_sent_per_part(void)
+{
+	const size_t payload_len = CONFIG_NRF_MODEM_LIB_SENDMSG_BUF_SIZE * 2;
+	int fd;
+	ssize_t ret;
+
+	fd = zsock_socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+
+	ret = send_header_and_payload(fd, payload_len);
+	TEST_ASSERT_EQUAL(HEADER_LEN + payload_len, ret);
+	TEST_ASSERT_EQUAL(2, atomic_get(&sendto_calls));
+	TEST_ASSERT_EQUAL(payload_len, last_sendto_len);
+
+	TEST_ASSERT_EQUAL(0, zsock_close(fd));
+}
+
+static void sender_fn(void *p1, void *p2, void *p3)
+{
+	int fd = POINTER_TO_INT(p1);
+
+	for (int i = 0; i < MESSAGES_PER_SENDER; i++) {
+		TEST_ASSERT_EQUAL(HEADER_LEN + PAYLOAD_LEN,
+				  send_header_and_payload(fd, PAYLOAD_LEN));
+	}
+}
+
+/* Senders on different sockets must not be serialized by sendmsg. */
+void test_sendmsg_concurrent_throughput(void)
+{
+	int fds[SENDERS];
+	uint32_t start;
+	uint32_t elapsed_ms;
+	uint32_t serialized_ms = SENDERS * MESSAGES_PER_SENDER * SENDTO_LATENCY_MS;
+
+	for (int i = 0; i < SENDERS; i++) {
+		fds[i] = zsock_socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		TEST_ASSERT_GREATER_OR_EQUAL(0, fds[i]);
+	}
+
+	start = k_uptime_get_32();
+
+	for (int i = 0; i < SENDERS; i++) {
+		k_thread_create(&sender_threads[i], sender_stacks[i],
+				K_THREAD_STACK_SIZEOF(sender_stacks[i]), sender_fn,
+				INT_TO_POINTER(fds[i]), NULL, NULL,
+				SENDER_PRIORITY, 0, K_NO_WAIT);
+	}
+
+	for (int i = 0; i < SENDERS; i++) {
+		k_thread_join(&sender_threads[i], K_FOREVER);
+	}
+
+	elapsed_ms = k_uptime_get_32() - start;
+
+	printk("sendmsg: %d senders, %ld messages, %ld bytes in %u ms "
+	       "(%u ms if serialized)\n",
+	       SENDERS, atomic_get(&sendto_calls), atomic_get(&sendto_bytes),
+	       elapsed_ms, serialized_ms);
+
+	TEST_ASSERT_EQUAL(SENDERS * MESSAGES_PER_SENDER, atomic_get(&sendto_calls));
+	TEST_ASSERT_LESS_THAN(serialized_ms, elapsed_ms);
+
+	for (int i = 0; i < SENDERS; i++) {
+		TEST_ASSERT_EQUAL(0, zsock_close(fds[i]));
+	}
+}
+
+void main(void)
+{
+	(void)unity_main();
+}
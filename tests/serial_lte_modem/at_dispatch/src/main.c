@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <string.h>
+#include <ctype.h>
+#include <zephyr/kernel.h>
+
+#include "slm_at_dispatch.h"
+
+#define REPLAY_ROUNDS 200
+#define MAX_PARAMS 8
+
+static int handler(enum at_cmd_type cmd_type)
+{
+	return cmd_type;
+}
+
+/* Full SLM command table, with all optional services enabled */
+static struct slm_at_cmd cmd_list[] = {
+	{"AT#XSLMVER", handler},
+	{"AT#XSLEEP", handler},
+	{"AT#XRESET", handler},
+	{"AT#XUUID", handler},
+	{"AT#XCLAC", handler},
+	{"AT#XSLMUART", handler},
+	{"AT#XDATACTRL", handler},
+	{"AT#XTCPSVR", handler},
+	{"AT#XTCPCLI", handler},
+	{"AT#XTCPSEND", handler, 2},
+	{"AT#XTCPHANGUP", handler},
+	{"AT#XUDPSVR", handler},
+	{"AT#XUDPCLI", handler},
+	{"AT#XUDPSEND", handler, 2},
+	{"AT#XSOCKET", handler},
+	{"AT#XSSOCKET", handler},
+	{"AT#XSOCKETSELECT", handler},
+	{"AT#XSOCKETOPT", handler},
+	{"AT#XSSOCKETOPT", handler},
+	{"AT#XBIND", handler},
+	{"AT#XCONNECT", handler},
+	{"AT#XLISTEN", handler},
+	{"AT#XACCEPT", handler},
+	{"AT#XSEND", handler, 2},
+	{"AT#XRECV", handler, 3},
+	{"AT#XSENDTO", handler, 4},
+	{"AT#XRECVFROM", handler, 3},
+	{"AT#XPOLL", handler},
+	{"AT#XGETADDRINFO", handler},
+	{"AT#XCMNG", handler},
+	{"AT#XMUX", handler},
+	{"AT#XPING", handler},
+	{"AT#XSMS", handler},
+	{"AT#XFOTA", handler},
+	{"AT#XGPS", handler},
+	{"AT#XNRFCLOUD", handler},
+	{"AT#XAGPS", handler},
+	{"AT#XPGPS", handler},
+	{"AT#XCELLPOS", handler},
+	{"AT#XFTP", handler},
+	{"AT#XMQTTCON", handler},
+	{"AT#XMQTTPUB", handler},
+	{"AT#XMQTTSUB", handler},
+	{"AT#XMQTTUNSUB", handler},
+	{"AT#XHTTPCCON", handler},
+	{"AT#XHTTPCREQ", handler},
+	{"AT#XTWILS", handler},
+	{"AT#XTWIW", handler},
+	{"AT#XTWIR", handler},
+	{"AT#XTWIWR", handler},
+	{"AT#XGPIOCFG", handler},
+	{"AT#XGPIO", handler},
+	{"AT#XDFUGET", handler},
+	{"AT#XDFURUN", handler},
+};
+
+SLM_AT_DISPATCH_DEFINE(dispatch, ARRAY_SIZE(cmd_list));
+
+static struct at_param_list param_list;
+
+/* Command log of a host streaming data through a socket */
+static const char * const at_log[] = {
+	"AT+CFUN=1",
+	"AT+CEREG?",
+	"AT#XSOCKET=1,1,0",
+	"AT#XSOCKETOPT=1,20,30",
+	"AT#XCONNECT=\"example.com\",1234",
+	"at#xsend=\"Hello from the host\"",
+	"AT#XRECV=10",
+	"AT#XSEND=\"0123456789ABCDEF0123456789ABCDEF\"",
+	"AT#XRECV=10,64",
+	"AT#XSEND=\"status\"",
+	"AT#XRECV=5",
+	"AT#XPOLL=0",
+	"AT+CESQ",
+	"AT#XSEND=\"more data\"",
+	"AT#XRECV=10",
+	"AT#XSENDTO=\"example.com\",5683,\"coap\"",
+	"AT#XRECVFROM=10",
+	"AT#XSLMVER",
+	"AT#XSOCKET?",
+	"AT#XSOCKET=?",
+	"AT#XSENDX=\"not a command\"",
+	"AT#XSOCKET=0",
+};
+
+/* Reference implementation, linear walk over the command table */
+static const struct slm_at_cmd *linear_find(const char *at_cmd)
+{
+	size_t len = strcspn(at_cmd, "=?\r\n");
+
+	for (size_t i = 0; i < ARRAY_SIZE(cmd_list); i++) {
+		const char *name = cmd_list[i].string;
+		size_t j;
+
+		if (strlen(name) != len) {
+			continue;
+		}
+		for (j = 0; j < len; j++) {
+			if (toupper((int)at_cmd[j]) != toupper((int)name[j])) {
+				break;
+			}
+		}
+		if (j == len) {
+			return &cmd_list[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void test_dispatch_init(void)
+{
+	int err;
+
+	err = slm_at_dispatch_init(&dispatch, cmd_list, ARRAY_SIZE(cmd_list));
+	zassert_equal(err, 0, "slm_at_dispatch_init failed: %d", err);
+}
+
+static void test_dispatch_all_commands(void)
+{
+	char cmd[32];
+
+	for (size_t i = 0; i < ARRAY_SIZE(cmd_list); i++) {
+		zassert_equal_ptr(slm_at_dispatch_find(&dispatch, cmd_list[i].string),
+				  &cmd_list[i], "%s not found", cmd_list[i].string);
+
+		/* Lower case, with parameters */
+		for (size_t j = 0; j <= strlen(cmd_list[i].string); j++) {
+			cmd[j] = tolower((int)cmd_list[i].string[j]);
+		}
+		strcat(cmd, "=1");
+		zassert_equal_ptr(slm_at_dispatch_find(&dispatch, cmd),
+				  &cmd_list[i], "%s not found", cmd);
+	}
+}
+
+static void test_dispatch_unknown_commands(void)
+{
+	zassert_is_null(slm_at_dispatch_find(&dispatch, "AT"), NULL);
+	zassert_is_null(slm_at_dispatch_find(&dispatch, "AT+CFUN?"), NULL);
+	zassert_is_null(slm_at_dispatch_find(&dispatch, "AT#XSENDX"), NULL);
+	zassert_is_null(slm_at_dispatch_find(&dispatch, "AT#XSEN=1"), NULL);
+}
+
+static void test_dispatch_parse_full_params(void)
+{
+	static const struct {
+		const char *at_cmd;
+		uint32_t param_count;
+	} cmds[] = {
+		{"AT#XSEND=\"Hello\"", 2},
+		{"AT#XRECV=10,64", 3},
+		{"AT#XSENDTO=\"example.com\",5683,\"coap\"", 4},
+		{"AT#XRECVFROM=10,64", 3},
+		{"AT#XTCPSEND=\"Hello\"", 2},
+		{"AT#XUDPSEND=\"Hello\"", 2},
+		/* Parameters that the handler does not read are not parsed */
+		{"AT#XRECV=10,64,1", 3},
+		/* Commands without a limit are parsed completely */
+		{"AT#XSOCKET=1,1,0", 4},
+		{"AT#XSOCKET?", 0},
+		{"AT#XRECV=?", 0},
+	};
+	const struct slm_at_cmd *cmd;
+	char str[16];
+	size_t len = sizeof(str);
+	uint16_t flags;
+	int err;
+
+	err = at_params_list_init(&param_list, MAX_PARAMS);
+	zassert_equal(err, 0, "at_params_list_init failed: %d", err);
+
+	for (size_t i = 0; i < ARRAY_SIZE(cmds); i++) {
+		cmd = slm_at_dispatch_find(&dispatch, cmds[i].at_cmd);
+		zassert_not_null(cmd, "%s not found", cmds[i].at_cmd);
+
+		err = slm_at_dispatch_parse(cmd, cmds[i].at_cmd, &param_list);
+		zassert_equal(err, 0, "Failed to parse %s: %d", cmds[i].at_cmd, err);
+		zassert_equal(at_params_valid_count_get(&param_list), cmds[i].param_count,
+			      "Unexpected parameter count for %s", cmds[i].at_cmd);
+	}
+
+	/* The last parameter read by the handler is complete */
+	cmd = slm_at_dispatch_find(&dispatch, "AT#XSENDTO");
+	err = slm_at_dispatch_parse(cmd, "AT#XSENDTO=\"example.com\",5683,\"coap\"",
+				    &param_list);
+	zassert_equal(err, 0, "Failed to parse: %d", err);
+	err = at_params_string_get(&param_list, 3, str, &len);
+	zassert_equal(err, 0, "Failed to get parameter: %d", err);
+	zassert_mem_equal(str, "coap", len, "Unexpected parameter");
+
+	cmd = slm_at_dispatch_find(&dispatch, "AT#XRECV");
+	err = slm_at_dispatch_parse(cmd, "AT#XRECV=10,64", &param_list);
+	zassert_equal(err, 0, "Failed to parse: %d", err);
+	err = at_params_unsigned_short_get(&param_list, 2, &flags);
+	zassert_equal(err, 0, "Failed to get parameter: %d", err);
+	zassert_equal(flags, 64, "Unexpected parameter");
+
+	at_params_list_free(&param_list);
+}
+
+static void test_dispatch_replay_log(void)
+{
+	uint32_t start;
+	uint32_t linear_cycles;
+	uint32_t hash_cycles;
+	const struct slm_at_cmd *volatile cmd;
+
+	for (size_t i = 0; i < ARRAY_SIZE(at_log); i++) {
+		zassert_equal_ptr(slm_at_dispatch_find(&dispatch, at_log[i]),
+				  linear_find(at_log[i]), "Mismatch for %s", at_log[i]);
+	}
+
+	start = k_cycle_get_32();
+	for (int round = 0; round < REPLAY_ROUNDS; round++) {
+		for (size_t i = 0; i < ARRAY_SIZE(at_log); i++) {
+			cmd = linear_find(at_log[i]);
+		}
+	}
+	linear_cycles = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (int round = 0; round < REPLAY_ROUNDS; round++) {
+		for (size_t i = 0; i < ARRAY_SIZE(at_log); i++) {
+			cmd = slm_at_dispatch_find(&dispatch, at_log[i]);
+		}
+	}
+	hash_cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("%u commands: linear %u cycles, hash %u cycles\n",
+		 REPLAY_ROUNDS * ARRAY_SIZE(at_log), linear_cycles, hash_cycles);
+}
+
+void test_main(void)
+{
+	ztest_test_suite(test_slm_at_dispatch,
+		ztest_unit_test(test_dispatch_init),
+		ztest_unit_test(test_dispatch_all_commands),
+		ztest_unit_test(test_dispatch_unknown_commands),
+		ztest_unit_test(test_dispatch_parse_full_params),
+		ztest_unit_test(test_dispatch_replay_log)
+	);
+
+	ztest_run_test_suite(test_slm_at_dispatch);
+}
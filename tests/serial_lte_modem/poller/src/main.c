@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/fdtable.h>
+
+#include "slm_poller.h"
+
+#define STUB_COUNT 4
+#define PACKET_SIZE 64
+#define PACKET_COUNT 200
+#define PACKET_INTERVAL_MS 5
+
+#define NET_STACK_SIZE 1024
+#define NET_PRIORITY 5
+
+/* Offloaded socket, polled and read like the nRF91 sockets */
+static struct stub_socket {
+	struct slm_poller_item item;
+	int fd;
+	atomic_t pending;	/* Packets not read yet */
+	uint32_t sent_cyc;	/* Time the last packet was received */
+	bool hangup;
+	/* Updated by the handler */
+	uint32_t received;
+	uint32_t latency_max_us;
+	uint64_t latency_sum_us;
+	short revents;
+	k_tid_t handler_thread;
+} stubs[STUB_COUNT];
+
+static const struct socket_op_vtable stub_vtable;
+
+/* Given on every network event */
+static K_SEM_DEFINE(stub_event, 0, K_SEM_MAX_LIMIT);
+static K_SEM_DEFINE(handler_done, 0, K_SEM_MAX_LIMIT);
+/* Calls to the offloaded poll(), that is poller wake-ups */
+static atomic_t stub_polls;
+
+K_THREAD_STACK_DEFINE(net_stack, NET_STACK_SIZE);
+static struct k_thread net_thread;
+
+static short stub_revents(struct stub_socket *stub, short events)
+{
+	short revents = 0;
+
+	if ((events & POLLIN) && atomic_get(&stub->pending) > 0) {
+		revents |= POLLIN;
+	}
+	if (stub->hangup) {
+		revents |= POLLHUP;
+	}
+
+	return revents;
+}
+
+static int stub_poll(struct zsock_pollfd *fds, int nfds, int timeout)
+{
+	int64_t end = k_uptime_get() + timeout;
+	struct stub_socket *stub;
+	int ready;
+
+	atomic_inc(&stub_polls);
+
+	while (true) {
+		ready = 0;
+		for (int i = 0; i < nfds; i++) {
+			fds[i].revents = 0;
+			if (fds[i].fd < 0) {
+				continue;
+			}
+			stub = z_get_fd_obj(fds[i].fd, (const struct fd_op_vtable *)&stub_vtable,
+					    ENOTSUP);
+			if (stub == NULL) {
+				fds[i].revents = POLLNVAL;
+			} else {
+				fds[i].revents = stub_revents(stub, fds[i].events);
+			}
+			if (fds[i].revents != 0) {
+				ready++;
+			}
+		}
+		if (ready > 0 || timeout == 0) {
+			return ready;
+		}
+		if (timeout > 0 && k_uptime_get() >= end) {
+			return 0;
+		}
+		if (k_sem_take(&stub_event, timeout < 0 ?
+			       K_FOREVER : K_MSEC(end - k_uptime_get())) != 0) {
+			return 0;
+		}
+	}
+}
+
+static int stub_ioctl(void *obj, unsigned int request, va_list args)
+{
+	ARG_UNUSED(obj);
+
+	switch (request) {
+	case ZFD_IOCTL_POLL_PREPARE:
+		return -EXDEV;
+
+	case ZFD_IOCTL_POLL_UPDATE:
+		return -EOPNOTSUPP;
+
+	case ZFD_IOCTL_POLL_OFFLOAD: {
+		struct zsock_pollfd *fds = va_arg(args, struct zsock_pollfd *);
+		int nfds = va_arg(args, int);
+		int timeout = va_arg(args, int);
+
+		return stub_poll(fds, nfds, timeout);
+	}
+
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+}
+
+static ssize_t stub_recvfrom(void *obj, void *buf, size_t max_len, int flags,
+			     struct sockaddr *src_addr, socklen_t *addrlen)
+{
+	struct stub_socket *stub = obj;
+	size_t len = MIN(max_len, PACKET_SIZE);
+
+	ARG_UNUSED(flags);
+	ARG_UNUSED(src_addr);
+	ARG_UNUSED(addrlen);
+
+	if (atomic_get(&stub->pending) == 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+	atomic_dec(&stub->pending);
+	memset(buf, 0xA5, len);
+
+	return len;
+}
+
+static int stub_close(void *obj)
+{
+	struct stub_socket *stub = obj;
+
+	stub->fd = -1;
+
+	return 0;
+}
+
+static const struct socket_op_vtable stub_vtable = {
+	.fd_vtable = {
+		.close = stub_close,
+		.ioctl = stub_ioctl,
+	},
+	.recvfrom = stub_recvfrom,
+};
+
+static void stub_packet_put(struct stub_socket *stub)
+{
+	stub->sent_cyc = k_cycle_get_32();
+	atomic_inc(&stub->pending);
+	k_sem_give(&stub_event);
+}
+
+static void stub_rx_handler(struct slm_poller_item *item, short revents)
+{
+	struct stub_socket *stub = CONTAINER_OF(item, struct stub_socket, item);
+	uint32_t latency_us = k_cyc_to_us_floor32(k_cycle_get_32() - stub->sent_cyc);
+	uint8_t buf[PACKET_SIZE];
+
+	stub->handler_thread = k_current_get();
+	stub->revents = revents;
+	if ((revents & POLLIN) != POLLIN) {
+		slm_poller_remove(item);
+		k_sem_give(&handler_done);
+		return;
+	}
+
+	while (recv(item->fd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+		stub->received++;
+	}
+	stub->latency_max_us = MAX(stub->latency_max_us, latency_us);
+	stub->latency_sum_us += latency_us;
+	slm_poller_arm(item);
+	k_sem_give(&handler_done);
+}
+
+static void stubs_open(void)
+{
+	for (int i = 0; i < STUB_COUNT; i++) {
+		struct stub_socket *stub = &stubs[i];
+		int fd = z_reserve_fd();
+
+		zassert_true(fd >= 0, "No fd");
+		memset(stub, 0, sizeof(*stub));
+		z_finalize_fd(fd, stub, (const struct fd_op_vtable *)&stub_vtable);
+		stub->fd = fd;
+		slm_poller_item_init(&stub->item, stub_rx_handler);
+	}
+	k_sem_reset(&stub_event);
+	k_sem_reset(&handler_done);
+}
+
+static void stubs_close(void)
+{
+	for (int i = 0; i < STUB_COUNT; i++) {
+		slm_poller_remove(&stubs[i].item);
+		if (stubs[i].fd >= 0) {
+			zassert_equal(close(stubs[i].fd), 0, NULL);
+		}
+	}
+}
+
+static void thread_count_cb(const struct k_thread *thread, void *user_data)
+{
+	ARG_UNUSED(thread);
+	(*(int *)user_data)++;
+}
+
+static int thread_count(void)
+{
+	int count = 0;
+
+	k_thread_foreach(thread_count_cb, &count);
+
+	return count;
+}
+
+static void net_emul(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	for (int n = 0; n < PACKET_COUNT; n++) {
+		k_sleep(K_MSEC(PACKET_INTERVAL_MS));
+		stub_packet_put(&stubs[n % STUB_COUNT]);
+	}
+}
+
+static void test_thread_count(void)
+{
+	int before = thread_count();
+	int started;
+
+	zassert_equal(slm_poller_init(), 0, NULL);
+	started = thread_count();
+	TC_PRINT("Threads: %d before, %d after start\n", before, started);
+	zassert_equal(started, before + 2, "Poller thread and work queue expected");
+
+	zassert_equal(slm_poller_init(), 0, NULL);
+	zassert_equal(thread_count(), started, "Started twice");
+
+	/* No thread per socket */
+	stubs_open();
+	for (int i = 0; i < STUB_COUNT; i++) {
+		zassert_equal(slm_poller_add(&stubs[i].item, stubs[i].fd, POLLIN), 0, NULL);
+	}
+	zassert_equal(slm_poller_add(&stubs[0].item, stubs[0].fd, POLLIN), -EALREADY, NULL);
+	zassert_equal(thread_count(), started, "Thread added for sockets");
+	stubs_close();
+}
+
+static void test_latency(void)
+{
+	uint32_t received = 0;
+	uint32_t latency_max_us = 0;
+	uint64_t latency_sum_us = 0;
+	uint32_t handled = 0;
+
+	stubs_open();
+	for (int i = 0; i < STUB_COUNT; i++) {
+		zassert_equal(slm_poller_add(&stubs[i].item, stubs[i].fd, POLLIN), 0, NULL);
+	}
+	atomic_set(&stub_polls, 0);
+
+	k_thread_create(&net_thread, net_stack, K_THREAD_STACK_SIZEOF(net_stack),
+			net_emul, NULL, NULL, NULL, NET_PRIORITY, 0, K_NO_WAIT);
+	zassert_equal(k_thread_join(&net_thread, K_SECONDS(10)), 0, NULL);
+	/* Let the last packet be handled */
+	k_sleep(K_MSEC(PACKET_INTERVAL_MS));
+
+	for (int i = 0; i < STUB_COUNT; i++) {
+		received += stubs[i].received;
+		latency_max_us = MAX(latency_max_us, stubs[i].latency_max_us);
+		latency_sum_us += stubs[i].latency_sum_us;
+		zassert_equal_ptr(stubs[i].handler_thread, stubs[0].handler_thread,
+				  "Handlers run in different threads");
+	}
+	zassert_not_equal(stubs[0].handler_thread, k_current_get(), NULL);
+	while (k_sem_take(&handler_done, K_NO_WAIT) == 0) {
+		handled++;
+	}
+
+	TC_PRINT("%u packets on %d sockets, %u handler runs, %d polls, "
+		 "latency avg %llu us, max %u us\n", received, STUB_COUNT, handled,
+		 (int)atomic_get(&stub_polls), latency_sum_us / MAX(handled, 1),
+		 latency_max_us);
+	zassert_equal(received, PACKET_COUNT, "Packets lost");
+	/* Re-armed from the handlers, the sockets are polled again without delay */
+	zassert_true(latency_max_us < PACKET_INTERVAL_MS * USEC_PER_MSEC,
+		     "Latency %u us too high", latency_max_us);
+	stubs_close();
+}
+
+static void test_idle_wakeups(void)
+{
+	int polls;
+
+	/* Nothing registered, the poller does not wake up */
+	atomic_set(&stub_polls, 0);
+	k_sleep(K_MSEC(CONFIG_SLM_POLLER_TIMEOUT * 5));
+	zassert_equal(atomic_get(&stub_polls), 0, "Idle poller woke up");
+
+	/* One wake-up per time-out with sockets registered, whatever their number */
+	stubs_open();
+	for (int i = 0; i < STUB_COUNT; i++) {
+		zassert_equal(slm_poller_add(&stubs[i].item, stubs[i].fd, POLLIN), 0, NULL);
+	}
+	k_sleep(K_MSEC(CONFIG_SLM_POLLER_TIMEOUT / 2));
+	atomic_set(&stub_polls, 0);
+	k_sleep(K_MSEC(CONFIG_SLM_POLLER_TIMEOUT * 5));
+	polls = atomic_get(&stub_polls);
+	TC_PRINT("%d polls in %d ms\n", polls, CONFIG_SLM_POLLER_TIMEOUT * 5);
+	zassert_true(polls >= 4 && polls <= 6, "%d polls", polls);
+	stubs_close();
+}
+
+static void test_arm_bound(void)
+{
+	int64_t start;
+
+	stubs_open();
+	zassert_equal(slm_poller_add(&stubs[0].item, stubs[0].fd, POLLIN), 0, NULL);
+	k_sleep(K_MSEC(10));
+
+	/* Added while the poller waits for the other socket */
+	stub_packet_put(&stubs[1]);
+	start = k_uptime_get();
+	zassert_equal(slm_poller_add(&stubs[1].item, stubs[1].fd, POLLIN), 0, NULL);
+	zassert_equal(k_sem_take(&handler_done, K_MSEC(CONFIG_SLM_POLLER_TIMEOUT * 2)), 0,
+		      "Socket not polled");
+	TC_PRINT("Socket polled after %lld ms\n", k_uptime_get() - start);
+	zassert_equal(stubs[1].received, 1, NULL);
+	zassert_true(k_uptime_get() - start <= CONFIG_SLM_POLLER_TIMEOUT + 10, NULL);
+	stubs_close();
+}
+
+static void test_hangup_remove(void)
+{
+	stubs_open();
+	zassert_equal(slm_poller_add(&stubs[0].item, stubs[0].fd, POLLIN), 0, NULL);
+	zassert_equal(slm_poller_add(&stubs[1].item, stubs[1].fd, POLLIN), 0, NULL);
+
+	/* Removed by its handler on hang-up */
+	stubs[0].hangup = true;
+	k_sem_give(&stub_event);
+	zassert_equal(k_sem_take(&handler_done, K_MSEC(CONFIG_SLM_POLLER_TIMEOUT)), 0, NULL);
+	zassert_equal(stubs[0].revents & POLLHUP, POLLHUP, NULL);
+	zassert_equal(stubs[0].item.fd, -1, "Not removed");
+
+	/* Not handled once removed */
+	slm_poller_remove(&stubs[1].item);
+	stub_packet_put(&stubs[1]);
+	zassert_not_equal(k_sem_take(&handler_done, K_MSEC(CONFIG_SLM_POLLER_TIMEOUT * 2)), 0,
+			  "Removed socket handled");
+	zassert_equal(atomic_get(&stubs[1].pending), 1, NULL);
+
+	/* Re-arming a removed item does nothing */
+	slm_poller_arm(&stubs[1].item);
+	zassert_not_equal(k_sem_take(&handler_done, K_MSEC(CONFIG_SLM_POLLER_TIMEOUT * 2)), 0,
+			  "Removed socket handled");
+	stubs_close();
+}
+
+static void test_wait(void)
+{
+	struct pollfd fds[2];
+
+	stubs_open();
+	fds[0].fd = stubs[0].fd;
+	fds[0].events = POLLIN;
+	fds[1].fd = stubs[1].fd;
+	fds[1].events = POLLIN;
+
+	zassert_equal(slm_poller_wait(fds, 2, 50), 0, "No time-out");
+
+	stub_packet_put(&stubs[1]);
+	zassert_equal(slm_poller_wait(fds, 2, 50), 1, NULL);
+	zassert_equal(fds[0].revents, 0, NULL);
+	zassert_equal(fds[1].revents, POLLIN, NULL);
+	stubs_close();
+}
+
+void test_main(void)
+{
+	ztest_test_suite(test_slm_poller,
+		ztest_unit_test(test_thread_count),
+		ztest_unit_test(test_latency),
+		ztest_unit_test(test_idle_wakeups),
+		ztest_unit_test(test_arm_bound),
+		ztest_unit_test(test_hangup_remove),
+		ztest_unit_test(test_wait)
+	);
+
+	ztest_run_test_suite(test_slm_poller);
+}
@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <zephyr/kernel.h>
+
+#include "slm_rx_stream.h"
+
+#define BUF_COUNT CONFIG_SLM_DATAMODE_STREAMING_BUF_COUNT
+#define BUF_SIZE  CONFIG_SLM_DATAMODE_STREAMING_BUF_SIZE
+
+/* Bytes received between two RX timeouts of the emulated UART */
+#define RX_CHUNK_LEN 128
+#define TOTAL_LEN (64 * 1024)
+#define BITS_PER_BYTE 10
+
+#define UART_STACK_SIZE 1024
+#define UART_PRIORITY 5
+
+K_THREAD_STACK_DEFINE(uart_stack, UART_STACK_SIZE);
+static struct k_thread uart_thread;
+
+static uint32_t uart_baudrate;
+static uint32_t uart_stalls;
+static K_SEM_DEFINE(uart_rx_sem, 0, 1);
+
+static size_t socket_sent;
+static uint32_t socket_ns_per_byte;
+static uint32_t socket_us;
+
+static uint8_t test_sent[64];
+static size_t test_sent_len;
+
+static uint8_t pattern(size_t n)
+{
+	return (uint8_t)(n * 7 + (n >> 8));
+}
+
+/* Emulates the UART driver in asynchronous mode, receiving at the given
+ * baudrate into the buffers of the pool. Reception stops while no buffer is
+ * available, as hardware flow control would stop the host.
+ */
+static void uart_emul(void *p1, void *p2, void *p3)
+{
+	uint8_t *buf = NULL;
+	size_t pos = 0;
+	size_t received = 0;
+	uint64_t start_us = k_ticks_to_us_floor64(k_uptime_ticks());
+	uint64_t line_us = 0;
+
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	while (received < TOTAL_LEN) {
+		size_t len;
+
+		if (buf == NULL) {
+			buf = slm_rx_stream_buf_alloc();
+			if (buf == NULL) {
+				uart_stalls++;
+				k_sleep(K_USEC(BITS_PER_BYTE * RX_CHUNK_LEN * USEC_PER_SEC /
+					       uart_baudrate));
+				/* The line was idle */
+				line_us = k_ticks_to_us_floor64(k_uptime_ticks()) - start_us;
+				continue;
+			}
+			pos = 0;
+		}
+
+		len = MIN(RX_CHUNK_LEN, BUF_SIZE - pos);
+		len = MIN(len, TOTAL_LEN - received);
+		for (size_t i = 0; i < len; i++) {
+			buf[pos + i] = pattern(received + i);
+		}
+
+		/* Wait for the bytes to be on the line */
+		line_us += (uint64_t)len * BITS_PER_BYTE * USEC_PER_SEC / uart_baudrate;
+		k_sleep(K_TIMEOUT_ABS_TICKS(k_us_to_ticks_ceil64(start_us + line_us)));
+
+		zassert_equal(slm_rx_stream_chunk_put(&buf[pos], len), 0, "Chunk dropped");
+		k_sem_give(&uart_rx_sem);
+		pos += len;
+		received += len;
+
+		if (pos == BUF_SIZE) {
+			slm_rx_stream_buf_release(buf);
+			buf = NULL;
+		}
+	}
+
+	if (buf != NULL) {
+		slm_rx_stream_buf_release(buf);
+	}
+}
+
+/* Socket taking the given time per byte plus a fixed time per call */
+static int socket_send(const uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		zassert_equal(data[i], pattern(socket_sent + i),
+			      "Corrupted data at %u", socket_sent + i);
+	}
+	k_sleep(K_USEC(socket_us + len * socket_ns_per_byte / 1000));
+	socket_sent += len;
+
+	return 0;
+}
+
+/* Consume the stream as the data mode does, sending the data to the socket */
+static uint32_t stream_run(uint32_t baudrate, uint32_t send_ns_per_byte, uint32_t send_us)
+{
+	int64_t start;
+	int64_t elapsed;
+	int ret;
+
+	slm_rx_stream_init();
+	k_sem_reset(&uart_rx_sem);
+	uart_baudrate = baudrate;
+	uart_stalls = 0;
+	socket_sent = 0;
+	socket_ns_per_byte = send_ns_per_byte;
+	socket_us = send_us;
+
+	start = k_uptime_get();
+	k_thread_create(&uart_thread, uart_stack, K_THREAD_STACK_SIZEOF(uart_stack),
+			uart_emul, NULL, NULL, NULL, UART_PRIORITY, 0, K_NO_WAIT);
+
+	while (socket_sent < TOTAL_LEN) {
+		zassert_equal(k_sem_take(&uart_rx_sem, K_SECONDS(1)), 0, "No data received");
+		ret = slm_rx_stream_send(socket_send);
+		zassert_true(ret >= 0, "Send failed: %d", ret);
+	}
+	elapsed = k_uptime_get() - start;
+
+	k_thread_join(&uart_thread, K_FOREVER);
+	zassert_true(slm_rx_stream_buf_available(), "Buffers not returned");
+	zassert_false(slm_rx_stream_terminated(), NULL);
+
+	TC_PRINT("%u baud: %u bytes in %lld ms, %lld bytes/s, %u stalls\n", baudrate,
+		 TOTAL_LEN, elapsed, (int64_t)TOTAL_LEN * MSEC_PER_SEC / elapsed, uart_stalls);
+
+	return (uint32_t)((int64_t)TOTAL_LEN * MSEC_PER_SEC / elapsed);
+}
+
+static int test_send(const uint8_t *data, size_t len)
+{
+	zassert_true(test_sent_len + len <= sizeof(test_sent), NULL);
+	memcpy(&test_sent[test_sent_len], data, len);
+	test_sent_len += len;
+
+	return 0;
+}
+
+/* Receive the string as one chunk and send the stream */
+static void chunk_recv(const char *str)
+{
+	static uint8_t *buf;
+	static size_t pos;
+	size_t len = strlen(str);
+
+	if (buf == NULL || pos + len > BUF_SIZE) {
+		if (buf != NULL) {
+			slm_rx_stream_buf_release(buf);
+		}
+		buf = slm_rx_stream_buf_alloc();
+		zassert_not_null(buf, NULL);
+		pos = 0;
+	}
+
+	memcpy(&buf[pos], str, len);
+	zassert_equal(slm_rx_stream_chunk_put(&buf[pos], len), 0, NULL);
+	pos += len;
+
+	zassert_equal(slm_rx_stream_send(test_send), 1, NULL);
+}
+
+static void sent_check(const char *expected)
+{
+	zassert_equal(test_sent_len, strlen(expected), "Sent %u bytes", test_sent_len);
+	zassert_mem_equal(test_sent, expected, test_sent_len, NULL);
+	test_sent_len = 0;
+}
+
+static void test_buf_pool(void)
+{
+	uint8_t *bufs[BUF_COUNT];
+	struct slm_rx_chunk chunk;
+
+	slm_rx_stream_init();
+
+	for (int i = 0; i < BUF_COUNT; i++) {
+		bufs[i] = slm_rx_stream_buf_alloc();
+		zassert_not_null(bufs[i], "Buffer %d not allocated", i);
+	}
+	zassert_is_null(slm_rx_stream_buf_alloc(), NULL);
+	zassert_false(slm_rx_stream_buf_available(), NULL);
+
+	/* A released buffer stays in use until its chunks are consumed */
+	zassert_equal(slm_rx_stream_chunk_put(bufs[0], 10), 0, NULL);
+	zassert_equal(slm_rx_stream_chunk_put(bufs[0] + 10, 20), 0, NULL);
+	slm_rx_stream_buf_release(bufs[0]);
+	zassert_false(slm_rx_stream_buf_available(), NULL);
+
+	zassert_equal(slm_rx_stream_chunk_get(&chunk, K_NO_WAIT), 0, NULL);
+	zassert_equal_ptr(chunk.data, bufs[0], NULL);
+	zassert_equal(chunk.len, 10, NULL);
+	slm_rx_stream_chunk_done(&chunk);
+	zassert_false(slm_rx_stream_buf_available(), NULL);
+
+	zassert_equal(slm_rx_stream_chunk_get(&chunk, K_NO_WAIT), 0, NULL);
+	zassert_equal_ptr(chunk.data, bufs[0] + 10, NULL);
+	zassert_equal(chunk.len, 20, NULL);
+	slm_rx_stream_chunk_done(&chunk);
+	zassert_true(slm_rx_stream_buf_available(), NULL);
+	zassert_equal_ptr(slm_rx_stream_buf_alloc(), bufs[0], NULL);
+
+	zassert_equal(slm_rx_stream_chunk_get(&chunk, K_NO_WAIT), -ENOMSG, NULL);
+
+	for (int i = 0; i < BUF_COUNT; i++) {
+		slm_rx_stream_buf_release(bufs[i]);
+	}
+	zassert_true(slm_rx_stream_buf_available(), NULL);
+}
+
+static void test_stream_115200(void)
+{
+	/* Socket faster than the UART, the line rate is sustained */
+	uint32_t rate = stream_run(115200, 2000, 200);
+
+	zassert_true(rate >= 115200 / BITS_PER_BYTE * 9 / 10, "Throughput %u too low", rate);
+}
+
+static void test_stream_1000000(void)
+{
+	uint32_t rate = stream_run(1000000, 500, 100);
+
+	zassert_true(rate >= 1000000 / BITS_PER_BYTE * 9 / 10, "Throughput %u too low", rate);
+}
+
+static void test_terminator(void)
+{
+	slm_rx_stream_init();
+	test_sent_len = 0;
+
+	chunk_recv("data+++");
+	sent_check("data");
+	zassert_true(slm_rx_stream_terminated(), NULL);
+
+	/* Data following the terminator makes it data */
+	chunk_recv("more");
+	sent_check("+++more");
+	zassert_false(slm_rx_stream_terminated(), NULL);
+
+	/* Terminator split between chunks */
+	chunk_recv("abc+");
+	sent_check("abc");
+	chunk_recv("+");
+	sent_check("");
+	zassert_false(slm_rx_stream_terminated(), NULL);
+	chunk_recv("+");
+	sent_check("");
+	zassert_true(slm_rx_stream_terminated(), NULL);
+
+	/* Beginning of the terminator followed by other data */
+	chunk_recv("++x++");
+	sent_check("+++++x");
+	chunk_recv("x+");
+	sent_check("++x");
+	chunk_recv("+++");
+	sent_check("+");
+	zassert_true(slm_rx_stream_terminated(), NULL);
+
+	slm_rx_stream_held_drop();
+	zassert_false(slm_rx_stream_terminated(), NULL);
+	chunk_recv("++");
+	sent_check("");
+	chunk_recv("+");
+	sent_check("");
+	zassert_true(slm_rx_stream_terminated(), NULL);
+
+	slm_rx_stream_init();
+	zassert_false(slm_rx_stream_terminated(), NULL);
+}
+
+static void test_stream_loopback(void)
+{
+	static const uint32_t baudrates[] = { 115200, 230400, 460800, 921600, 1000000 };
+
+	/* Data sent back to the host over the UART, at the same baudrate */
+	for (int i = 0; i < ARRAY_SIZE(baudrates); i++) {
+		uint32_t line_rate = baudrates[i] / BITS_PER_BYTE;
+		uint32_t rate = stream_run(baudrates[i], NSEC_PER_SEC / line_rate, 0);
+
+		TC_PRINT("Loopback at %u baud: %u%% of the line rate\n", baudrates[i],
+			 rate * 100 / line_rate);
+		zassert_true(rate >= line_rate * 8 / 10, "Throughput %u too low", rate);
+	}
+}
+
+static void test_stream_flow_control(void)
+{
+	/* Socket slower than the UART, reception stalls but nothing is lost */
+	stream_run(1000000, 20000, 1000);
+	zassert_true(uart_stalls > 0, "Flow control not applied");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(test_slm_rx_stream,
+		ztest_unit_test(test_buf_pool),
+		ztest_unit_test(test_terminator),
+		ztest_unit_test(test_stream_115200),
+		ztest_unit_test(test_stream_1000000),
+		ztest_unit_test(test_stream_loopback),
+		ztest_unit_test(test_stream_flow_control)
+	);
+
+	ztest_run_test_suite(test_slm_rx_stream);
+}
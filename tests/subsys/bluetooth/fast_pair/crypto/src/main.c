@@ -8,6 +8,11 @@
 #include "fp_crypto.h"
 #include "fp_common.h"
 
+/* Number of Account Keys used to compare timings, the default storage capacity. */
+#define TIMING_ACCOUNT_KEY_CNT	5
+/* Buffer size large enough for the Account Key Filter of TIMING_ACCOUNT_KEY_CNT keys. */
+#define TIMING_FILTER_BUF_LEN	16
+
 static void test_sha256(void)
 {
 	const uint8_t input_data[] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
@@ -51,6 +56,34 @@ static void test_aes128(void)
 	zassert_mem_equal(result_buf, plaintext, sizeof(plaintext), "Invalid decryption result.");
 }
 
+static void test_aes128_key(void)
+{
+	const uint8_t plaintext[] = {0xF3, 0x0F, 0x4E, 0x78, 0x6C, 0x59, 0xA7, 0xBB, 0xF3, 0x87,
+				     0x3B, 0x5A, 0x49, 0xBA, 0x97, 0xEA};
+
+	const uint8_t key[] = {0xA0, 0xBA, 0xF0, 0xBB, 0x95, 0x1F, 0xF7, 0xB6, 0xCF, 0x5E, 0x3F,
+			       0x45, 0x61, 0xC3, 0x32, 0x1D};
+
+	const uint8_t ciphertext[] = {0xAC, 0x9A, 0x16, 0xF0, 0x95, 0x3A, 0x3F, 0x22, 0x3D, 0xD1,
+				      0x0C, 0xF5, 0x36, 0xE0, 0x9E, 0x9C};
+
+	struct fp_crypto_aes128_key aes_key;
+	uint8_t result_buf[FP_CRYPTO_AES128_BLOCK_LEN];
+
+	zassert_ok(fp_crypto_aes128_decrypt_key_set(&aes_key, key), "Error during key expansion.");
+
+	/* The expanded key must be reusable. */
+	for (size_t i = 0; i < 2; i++) {
+		memset(result_buf, 0, sizeof(result_buf));
+		zassert_ok(fp_crypto_aes128_key_decrypt(&aes_key, result_buf, ciphertext),
+			   "Error during value decryption.");
+		zassert_mem_equal(result_buf, plaintext, sizeof(plaintext),
+				  "Invalid decryption result.");
+	}
+
+	fp_crypto_aes128_key_free(&aes_key);
+}
+
 static void test_ecdh(void)
 {
 	const uint8_t bobs_private_key[] = {0x02, 0xB4, 0x37, 0xB0, 0xED, 0xD6, 0xBB, 0xD4, 0x29,
@@ -169,14 +202,142 @@ static void test_bloom_filter(void)
 			  "Invalid resulting filter.");
 }
 
+static void test_bloom_filter_from_hash(void)
+{
+	const uint8_t salt = 0xC7;
+
+	const struct fp_account_key account_key_list[] = {
+		{ .key = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0x00, 0xAA, 0xBB,
+			  0xCC, 0xDD, 0xEE, 0xFF} },
+		{ .key = {0x11, 0x11, 0x22, 0x22, 0x33, 0x33, 0x44, 0x44, 0x55, 0x55, 0x66, 0x66,
+			  0x77, 0x77, 0x88, 0x88} }
+		};
+
+	const uint8_t first_bloom_filter[] = {0x0A, 0x42, 0x88, 0x10};
+	const uint8_t second_bloom_filter[] = {0x2F, 0xBA, 0x06, 0x42, 0x00};
+
+	struct fp_crypto_account_key_hash hash_list[ARRAY_SIZE(account_key_list)];
+	uint8_t result_buf[sizeof(second_bloom_filter)];
+	uint8_t expected_buf[sizeof(second_bloom_filter)];
+
+	for (size_t i = 0; i < ARRAY_SIZE(account_key_list); i++) {
+		zassert_ok(fp_crypto_account_key_hash_init(&hash_list[i], &account_key_list[i]),
+			   "Error during Account Key hashing");
+	}
+
+	zassert_ok(fp_crypto_account_key_filter_from_hash(result_buf, hash_list, 1, salt),
+		   "Error during filter computing");
+	zassert_mem_equal(result_buf, first_bloom_filter, sizeof(first_bloom_filter),
+			  "Invalid resulting filter.");
+
+	zassert_ok(fp_crypto_account_key_filter_from_hash(result_buf, hash_list,
+							  ARRAY_SIZE(hash_list), salt),
+		   "Error during filter computing");
+	zassert_mem_equal(result_buf, second_bloom_filter, sizeof(second_bloom_filter),
+			  "Invalid resulting filter.");
+
+	/* Hash states are not consumed, so every salt gives the same filter as hashing
+	 * the Account Keys from scratch.
+	 */
+	for (uint16_t s = 0; s <= UINT8_MAX; s++) {
+		zassert_ok(fp_crypto_account_key_filter(expected_buf, account_key_list,
+							ARRAY_SIZE(account_key_list), s),
+			   "Error during filter computing");
+		zassert_ok(fp_crypto_account_key_filter_from_hash(result_buf, hash_list,
+								  ARRAY_SIZE(hash_list), s),
+			   "Error during filter computing");
+		zassert_mem_equal(result_buf, expected_buf, sizeof(expected_buf),
+				  "Filter differs for salt 0x%02x", s);
+	}
+
+	for (size_t i = 0; i < ARRAY_SIZE(hash_list); i++) {
+		fp_crypto_account_key_hash_free(&hash_list[i]);
+	}
+}
+
+static void test_key_cache_timing(void)
+{
+	static const uint32_t iterations = 32;
+
+	struct fp_account_key account_key_list[TIMING_ACCOUNT_KEY_CNT];
+	struct fp_crypto_account_key_hash hash_list[ARRAY_SIZE(account_key_list)];
+	struct fp_crypto_aes128_key aes_key_list[ARRAY_SIZE(account_key_list)];
+	uint8_t filter_buf[TIMING_FILTER_BUF_LEN];
+	uint8_t block[FP_CRYPTO_AES128_BLOCK_LEN] = {0};
+	uint32_t start;
+	uint32_t full_cycles;
+	uint32_t cached_cycles;
+
+	zassert_true(fp_crypto_account_key_filter_size(ARRAY_SIZE(account_key_list)) <=
+		     sizeof(filter_buf), "Filter buffer too small.");
+
+	for (size_t i = 0; i < ARRAY_SIZE(account_key_list); i++) {
+		memset(account_key_list[i].key, i + 1, FP_ACCOUNT_KEY_LEN);
+		zassert_ok(fp_crypto_account_key_hash_init(&hash_list[i], &account_key_list[i]),
+			   "Error during Account Key hashing");
+		zassert_ok(fp_crypto_aes128_decrypt_key_set(&aes_key_list[i],
+							    account_key_list[i].key),
+			   "Error during key expansion.");
+	}
+
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < iterations; i++) {
+		zassert_ok(fp_crypto_account_key_filter(filter_buf, account_key_list,
+							ARRAY_SIZE(account_key_list), i),
+			   "Error during filter computing");
+	}
+	full_cycles = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < iterations; i++) {
+		zassert_ok(fp_crypto_account_key_filter_from_hash(filter_buf, hash_list,
+								  ARRAY_SIZE(hash_list), i),
+			   "Error during filter computing");
+	}
+	cached_cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("Account Key Filter: %u cycles, from hash states: %u cycles\n",
+		 full_cycles / iterations, cached_cycles / iterations);
+
+	/* Trial decryption of a request with every Account Key, as in Key-based Pairing. */
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < iterations; i++) {
+		for (size_t j = 0; j < ARRAY_SIZE(account_key_list); j++) {
+			zassert_ok(fp_crypto_aes128_decrypt(block, block, account_key_list[j].key),
+				   "Error during value decryption.");
+		}
+	}
+	full_cycles = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (size_t i = 0; i < iterations; i++) {
+		for (size_t j = 0; j < ARRAY_SIZE(aes_key_list); j++) {
+			zassert_ok(fp_crypto_aes128_key_decrypt(&aes_key_list[j], block, block),
+				   "Error during value decryption.");
+		}
+	}
+	cached_cycles = k_cycle_get_32() - start;
+
+	TC_PRINT("Account Key trial decryption: %u cycles, with expanded keys: %u cycles\n",
+		 full_cycles / iterations, cached_cycles / iterations);
+
+	for (size_t i = 0; i < ARRAY_SIZE(account_key_list); i++) {
+		fp_crypto_account_key_hash_free(&hash_list[i]);
+		fp_crypto_aes128_key_free(&aes_key_list[i]);
+	}
+}
+
 void test_main(void)
 {
 	ztest_test_suite(fast_pair_crypto_tests,
 			 ztest_unit_test(test_sha256),
 			 ztest_unit_test(test_aes128),
+			 ztest_unit_test(test_aes128_key),
 			 ztest_unit_test(test_ecdh),
 			 ztest_unit_test(test_aes_key_from_ecdh_shared_secret),
-			 ztest_unit_test(test_bloom_filter)
+			 ztest_unit_test(test_bloom_filter),
+			 ztest_unit_test(test_bloom_filter_from_hash),
+			 ztest_unit_test(test_key_cache_timing)
 			 );
 
 	ztest_run_test_suite(fast_pair_crypto_tests);
@@ -51,7 +51,7 @@
  * This macro is used only for attribute created for bt_gatt_discover mock.
  *
  * @note The value of the characteristic should be added using
- * @ref BT_GATT_DISCOVER_MOCK_DESC macro.
+ * @ref BT_GATT_DISCOVER_MOCK_DESC macro, just after the characteristic.
  *
  * @param _handle The handler of the characteristic attribute.
  * @param _uuid   The UUID of the characteristic itself.
@@ -61,7 +61,9 @@
 		.uuid = BT_UUID_GATT_CHRC,                         \
 		.handle = _handle,                                 \
 		.user_data = (void *)(&(const struct bt_gatt_chrc) \
-			{ .uuid = _uuid, .properties = _props })   \
+			{ .uuid = _uuid,                           \
+			  .value_handle = (_handle) + 1,           \
+			  .properties = _props })                 \
 	}
 
 /**
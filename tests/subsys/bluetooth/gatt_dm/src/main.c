@@ -16,9 +16,13 @@
 
 #define BT_UUID_EMPTY BT_UUID_DECLARE_16(0x1234)
 #define BT_UUID_EMPTY_CHR BT_UUID_DECLARE_16(0x1235)
+#define BT_UUID_LARGE BT_UUID_DECLARE_16(0x1236)
+#define BT_UUID_LARGE_CHR \
+	BT_UUID_DECLARE_128(BT_UUID_128_ENCODE(0x12345678, 0x1234, 0x5678, 0x1234, 0x56789abcdef0))
 
 static char dummy_conn;
-K_SEM_DEFINE(discovery_finished, 0, 1);
+static char dummy_conn_2;
+K_SEM_DEFINE(discovery_finished, 0, CONFIG_BT_GATT_DM_MAX_INSTANCES);
 
 
 const struct bt_gatt_attr discover_sim[] = {
@@ -60,6 +64,54 @@ const struct bt_gatt_attr discover_sim[] = {
 	BT_GATT_DISCOVER_MOCK_CHRC(23, BT_UUID_HRS_MEASUREMENT, BT_GATT_CHRC_READ),
 };
 
+/* HIDS followed by a service whose data does not fit in the arena of one instance */
+const struct bt_gatt_attr discover_large_sim[] = {
+	BT_GATT_DISCOVER_MOCK_SERV(1, BT_UUID_HIDS, 11),
+	BT_GATT_DISCOVER_MOCK_CHRC(2, BT_UUID_HIDS_INFO, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(3, BT_UUID_HIDS_INFO),
+
+	BT_GATT_DISCOVER_MOCK_CHRC(4, BT_UUID_HIDS_REPORT_MAP, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(5, BT_UUID_HIDS_REPORT_MAP),
+
+	BT_GATT_DISCOVER_MOCK_CHRC(6, BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY),
+	BT_GATT_DISCOVER_MOCK_DESC(7, BT_UUID_HIDS_REPORT),
+	BT_GATT_DISCOVER_MOCK_DESC(8, BT_UUID_GATT_CCC),
+	BT_GATT_DISCOVER_MOCK_DESC(9, BT_UUID_HIDS_REPORT_REF),
+
+	BT_GATT_DISCOVER_MOCK_CHRC(10, BT_UUID_HIDS_CTRL_POINT, BT_GATT_CHRC_WRITE_WITHOUT_RESP),
+	BT_GATT_DISCOVER_MOCK_DESC(11, BT_UUID_HIDS_CTRL_POINT),
+
+	BT_GATT_DISCOVER_MOCK_SERV(12, BT_UUID_LARGE, 0xffff),
+	BT_GATT_DISCOVER_MOCK_CHRC(13, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(14, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(15, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(16, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(17, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(18, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(19, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(20, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(21, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(22, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(23, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(24, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(25, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(26, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(27, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(28, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(29, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(30, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(31, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(32, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(33, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(34, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(35, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(36, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(37, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(38, BT_UUID_LARGE_CHR),
+	BT_GATT_DISCOVER_MOCK_CHRC(39, BT_UUID_LARGE_CHR, BT_GATT_CHRC_READ),
+	BT_GATT_DISCOVER_MOCK_DESC(40, BT_UUID_LARGE_CHR),
+};
+
 
 void test_cb_completed(struct bt_gatt_dm *dm, void *context)
 {
@@ -89,6 +141,19 @@ struct bt_gatt_dm_cb test_hids_cb = {
 	.error_found       = test_cb_error_found
 };
 
+void test_cb_error_expected(struct bt_conn *conn, int err, void *context)
+{
+	printk("%s\n", __func__);
+	*(int *)context = err;
+	k_sem_give(&discovery_finished);
+}
+
+struct bt_gatt_dm_cb test_error_cb = {
+	.completed         = test_cb_completed,
+	.service_not_found = test_cb_service_not_found,
+	.error_found       = test_cb_error_expected
+};
+
 void test_setup(void)
 {
 	k_sem_reset(&discovery_finished);
@@ -369,6 +434,117 @@ void test_gatt_HIDS_chrc_by_uuid(void)
 		      bt_gatt_dm_attr_cnt(dm));
 }
 
+void test_gatt_HIDS_shared_uuid(void)
+{
+	struct bt_gatt_dm *dm;
+	const struct bt_gatt_dm_attr *attr_chrc = NULL;
+	const struct bt_gatt_dm_attr *attr_val;
+	const struct bt_gatt_dm_attr *attr_desc;
+	const struct bt_gatt_chrc *chrc_val;
+
+	dm = run_dm(BT_UUID_HIDS);
+	zassert_not_null(dm, "Device Manager pointer not set");
+
+	/* The characteristic value UUID is stored once */
+	while ((attr_chrc = bt_gatt_dm_char_next(dm, attr_chrc)) != NULL) {
+		chrc_val = bt_gatt_dm_attr_chrc_val(attr_chrc);
+		zassert_not_null(chrc_val, "Unexpected NULL");
+		attr_val = bt_gatt_dm_attr_by_handle(dm, chrc_val->value_handle);
+		zassert_not_null(attr_val, "No value of characteristic: %d",
+				 attr_chrc->handle);
+		zassert_equal_ptr(chrc_val->uuid, attr_val->uuid,
+				  "UUID of characteristic %d not shared",
+				  attr_chrc->handle);
+	}
+
+	attr_desc = bt_gatt_dm_attr_by_handle(dm, 8);
+	zassert_not_null(attr_desc, "Unexpected NULL");
+	zassert_true(!bt_uuid_cmp(BT_UUID_GATT_CCC, attr_desc->uuid), "Unexpected UUID");
+
+	bt_gatt_dm_data_release(dm);
+}
+
+void test_gatt_concurrent(void)
+{
+	struct bt_gatt_dm *dm_hids = NULL;
+	struct bt_gatt_dm *dm_dis = NULL;
+	struct bt_gatt_dm *dm_hrs;
+	const struct bt_gatt_service_val *serv_val;
+	int err;
+
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn, BT_UUID_HIDS,
+			       &test_hids_cb, &dm_hids);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn_2, BT_UUID_DIS,
+			       &test_hids_cb, &dm_dis);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+
+	/* All instances are in use */
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn, BT_UUID_HRS,
+			       &test_hids_cb, &dm_hrs);
+	zassert_equal(-EALREADY, err, "Unexpected error: %d", err);
+
+	for (int i = 0; i < 2; i++) {
+		err = k_sem_take(&discovery_finished, K_MSEC(SERVICE_DISCOVERY_TIMEOUT));
+		zassert_equal(0, err, "It seems that no callback function was called: %d",
+			      err);
+	}
+
+	zassert_not_null(dm_hids, "HIDS not found");
+	zassert_not_null(dm_dis, "DIS not found");
+	zassert_not_equal(dm_hids, dm_dis, "Discoveries share the instance");
+	zassert_equal_ptr(&dummy_conn, bt_gatt_dm_conn_get(dm_hids), "Unexpected connection");
+	zassert_equal_ptr(&dummy_conn_2, bt_gatt_dm_conn_get(dm_dis), "Unexpected connection");
+
+	serv_val = bt_gatt_dm_attr_service_val(bt_gatt_dm_service_get(dm_hids));
+	zassert_true(!bt_uuid_cmp(BT_UUID_HIDS, serv_val->uuid), "Invalid service detected");
+	zassert_equal(11, bt_gatt_dm_attr_cnt(dm_hids), "Unexpected number of attributes");
+	serv_val = bt_gatt_dm_attr_service_val(bt_gatt_dm_service_get(dm_dis));
+	zassert_true(!bt_uuid_cmp(BT_UUID_DIS, serv_val->uuid), "Invalid service detected");
+	zassert_equal(5, bt_gatt_dm_attr_cnt(dm_dis), "Unexpected number of attributes");
+
+	/* The released instance can be used by the next discovery */
+	bt_gatt_dm_data_release(dm_hids);
+	dm_hrs = run_dm(BT_UUID_HRS);
+	zassert_equal_ptr(dm_hids, dm_hrs, "Released instance not used");
+	zassert_equal(2, bt_gatt_dm_attr_cnt(dm_hrs), "Unexpected number of attributes");
+	zassert_equal(5, bt_gatt_dm_attr_cnt(dm_dis), "Discovery data overwritten");
+
+	bt_gatt_dm_data_release(dm_hrs);
+	bt_gatt_dm_data_release(dm_dis);
+}
+
+void test_gatt_arena_quota(void)
+{
+	struct bt_gatt_dm *dm_hids = NULL;
+	int large_err = 0;
+	int err;
+
+	bt_gatt_discover_mock_setup(discover_large_sim, ARRAY_SIZE(discover_large_sim));
+
+	/* The large service fails on its own arena without taking the blocks of
+	 * the other instance.
+	 */
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn, BT_UUID_LARGE,
+			       &test_error_cb, &large_err);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+	err = bt_gatt_dm_start((struct bt_conn *)&dummy_conn_2, BT_UUID_HIDS,
+			       &test_hids_cb, &dm_hids);
+	zassert_false(err, "bt_gatt_dm_start finished with error: %d", err);
+
+	for (int i = 0; i < 2; i++) {
+		err = k_sem_take(&discovery_finished, K_MSEC(SERVICE_DISCOVERY_TIMEOUT));
+		zassert_equal(0, err, "It seems that no callback function was called: %d",
+			      err);
+	}
+
+	zassert_equal(-ENOMEM, large_err, "Unexpected error: %d", large_err);
+	zassert_not_null(dm_hids, "HIDS not found");
+	zassert_equal(11, bt_gatt_dm_attr_cnt(dm_hids), "Unexpected number of attributes");
+
+	bt_gatt_dm_data_release(dm_hids);
+}
+
 void test_gatt_generic_serv(void)
 {
 	struct bt_gatt_dm *dm;
@@ -486,6 +662,10 @@ void test_main(void)
 					       unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_HIDS_chrc_by_uuid, test_setup,
 					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_HIDS_shared_uuid, test_setup,
+					       unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_concurrent, test_setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_gatt_arena_quota, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_generic_serv, test_setup, unit_test_noop),
 		ztest_unit_test_setup_teardown(test_gatt_many_serv_by_uuid, test_setup,
 					       unit_test_noop)
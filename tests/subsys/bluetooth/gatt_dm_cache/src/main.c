@@ -0,0 +1,705 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/att.h>
+#include <zephyr/bluetooth/bluetooth.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <zephyr/bluetooth/uuid.h>
+#include <zephyr/settings/settings.h>
+#include <bluetooth/gatt_dm.h>
+#include <bluetooth/services/hogp.h>
+
+/* One ATT request and response takes two connection intervals */
+#define ATT_RTT_MS 15
+/* Attributes carried in one discovery response with the default ATT MTU */
+#define ATTRS_PER_RSP 3
+#define READY_TIMEOUT K_SECONDS(2)
+
+#define STORE_SIZE 16
+#define STORE_NAME_LEN 64
+#define STORE_VAL_LEN 1024
+
+#define REPORT_CNT 3
+
+#define SERV(_handle, _uuid, _end_handle) {                               \
+		.uuid = BT_UUID_GATT_PRIMARY,                             \
+		.handle = _handle,                                        \
+		.user_data = (void *)(&(const struct bt_gatt_service_val) \
+			{ .uuid = _uuid, .end_handle = _end_handle})      \
+	}
+
+#define CHRC(_handle, _uuid, _props) {                             \
+		.uuid = BT_UUID_GATT_CHRC,                         \
+		.handle = _handle,                                 \
+		.user_data = (void *)(&(const struct bt_gatt_chrc) \
+			{ .uuid = _uuid, .value_handle = (_handle) + 1, \
+			  .properties = _props })                  \
+	}
+
+#define DESC(_handle, _uuid) { \
+		.uuid = _uuid,         \
+		.handle = _handle      \
+	}
+
+static const struct bt_gatt_attr peer_db[] = {
+	SERV(1, BT_UUID_GATT, 3),
+	CHRC(2, BT_UUID_GATT_DB_HASH, BT_GATT_CHRC_READ),
+	DESC(3, BT_UUID_GATT_DB_HASH),
+
+	SERV(4, BT_UUID_HIDS, 24),
+	CHRC(5, BT_UUID_HIDS_INFO, BT_GATT_CHRC_READ),
+	DESC(6, BT_UUID_HIDS_INFO),
+	CHRC(7, BT_UUID_HIDS_REPORT_MAP, BT_GATT_CHRC_READ),
+	DESC(8, BT_UUID_HIDS_REPORT_MAP),
+	CHRC(9, BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY),
+	DESC(10, BT_UUID_HIDS_REPORT),
+	DESC(11, BT_UUID_GATT_CCC),
+	DESC(12, BT_UUID_HIDS_REPORT_REF),
+	CHRC(13, BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_NOTIFY),
+	DESC(14, BT_UUID_HIDS_REPORT),
+	DESC(15, BT_UUID_GATT_CCC),
+	DESC(16, BT_UUID_HIDS_REPORT_REF),
+	CHRC(17, BT_UUID_HIDS_REPORT, BT_GATT_CHRC_READ | BT_GATT_CHRC_WRITE |
+				      BT_GATT_CHRC_WRITE_WITHOUT_RESP),
+	DESC(18, BT_UUID_HIDS_REPORT),
+	DESC(19, BT_UUID_HIDS_REPORT_REF),
+	CHRC(20, BT_UUID_HIDS_CTRL_POINT, BT_GATT_CHRC_WRITE_WITHOUT_RESP),
+	DESC(21, BT_UUID_HIDS_CTRL_POINT),
+	CHRC(22, BT_UUID_BAS_BATTERY_LEVEL, BT_GATT_CHRC_READ),
+	DESC(23, BT_UUID_BAS_BATTERY_LEVEL),
+	DESC(24, BT_UUID_GATT_CUD),
+
+	SERV(25, BT_UUID_HRS, 27),
+	CHRC(26, BT_UUID_HRS_MEASUREMENT, BT_GATT_CHRC_NOTIFY),
+	DESC(27, BT_UUID_HRS_MEASUREMENT),
+
+	SERV(28, BT_UUID_HRS, 30),
+	CHRC(29, BT_UUID_HRS_MEASUREMENT, BT_GATT_CHRC_NOTIFY),
+	DESC(30, BT_UUID_HRS_MEASUREMENT),
+
+	SERV(31, BT_UUID_DIS, 0xffff),
+	CHRC(32, BT_UUID_DIS_MODEL_NUMBER, BT_GATT_CHRC_READ),
+	DESC(33, BT_UUID_DIS_MODEL_NUMBER),
+};
+
+/* Report Reference values of the reports, in the handle order */
+static const uint8_t report_ref[REPORT_CNT][2] = {
+	{ 1, BT_HIDS_REPORT_TYPE_INPUT },
+	{ 2, BT_HIDS_REPORT_TYPE_INPUT },
+	{ 1, BT_HIDS_REPORT_TYPE_OUTPUT },
+};
+
+static const uint8_t hid_info[] = { 0x11, 0x01, 0x00, 0x02 };
+
+static struct {
+	bool bonded;
+	bool connected;
+	bool db_hash;
+	uint8_t hash[16];
+	const bt_addr_le_t *peer;
+	size_t discover_cnt;
+	size_t read_cnt;
+	struct bt_gatt_discover_params *discover_params;
+	struct bt_gatt_read_params *read_params;
+	struct k_work_delayable discover_work;
+	struct k_work_delayable read_work;
+} mock;
+
+static struct {
+	char name[STORE_NAME_LEN];
+	uint8_t val[STORE_VAL_LEN];
+	size_t len;
+} store[STORE_SIZE];
+
+static const bt_addr_le_t peer_a = {
+	.type = BT_ADDR_LE_PUBLIC,
+	.a.val = { 0x01, 0x02, 0x03, 0x04, 0x05, 0xc0 },
+};
+
+static const bt_addr_le_t peer_b = {
+	.type = BT_ADDR_LE_RANDOM,
+	.a.val = { 0x11, 0x12, 0x13, 0x14, 0x15, 0xd0 },
+};
+
+static char dummy_conn;
+static struct bt_conn *const conn = (struct bt_conn *)&dummy_conn;
+static struct bt_conn_auth_info_cb *auth_info_cb;
+
+static struct bt_hogp hogp;
+static struct bt_gatt_dm *dm_found;
+static bool dm_restored;
+static K_SEM_DEFINE(dm_done, 0, 1);
+static K_SEM_DEFINE(hogp_ready, 0, 1);
+
+int bt_conn_get_info(const struct bt_conn *c, struct bt_conn_info *info)
+{
+	memset(info, 0, sizeof(*info));
+	info->id = BT_ID_DEFAULT;
+	info->le.dst = mock.peer;
+
+	return 0;
+}
+
+bool bt_addr_le_is_bonded(uint8_t id, const bt_addr_le_t *addr)
+{
+	return mock.bonded;
+}
+
+int bt_conn_auth_info_cb_register(struct bt_conn_auth_info_cb *cb)
+{
+	auth_info_cb = cb;
+
+	return 0;
+}
+
+uint16_t bt_gatt_get_mtu(struct bt_conn *c)
+{
+	return mock.connected ? BT_ATT_DEFAULT_LE_MTU : 0;
+}
+
+static bool attr_match(const struct bt_gatt_attr *attr,
+		       const struct bt_gatt_discover_params *params)
+{
+	const struct bt_gatt_service_val *service_val = attr->user_data;
+
+	if ((attr->handle < params->start_handle) ||
+	    (attr->handle > params->end_handle)) {
+		return false;
+	}
+
+	switch (params->type) {
+	case BT_GATT_DISCOVER_PRIMARY:
+		return !bt_uuid_cmp(attr->uuid, BT_UUID_GATT_PRIMARY) &&
+		       (!params->uuid ||
+			!bt_uuid_cmp(params->uuid, service_val->uuid));
+	case BT_GATT_DISCOVER_CHARACTERISTIC:
+		return !bt_uuid_cmp(attr->uuid, BT_UUID_GATT_CHRC);
+	case BT_GATT_DISCOVER_ATTRIBUTE:
+		return true;
+	default:
+		zassert_unreachable("Unexpected discovery type: %u",
+				    params->type);
+		return false;
+	}
+}
+
+static void discover_work_handler(struct k_work *work)
+{
+	struct bt_gatt_discover_params *params = mock.discover_params;
+
+	for (size_t i = 0; i < ARRAY_SIZE(peer_db); i++) {
+		if (!attr_match(&peer_db[i], params)) {
+			continue;
+		}
+		if (params->func(conn, &peer_db[i], params) ==
+		    BT_GATT_ITER_STOP) {
+			return;
+		}
+	}
+
+	params->func(conn, NULL, params);
+}
+
+int bt_gatt_discover(struct bt_conn *c, struct bt_gatt_discover_params *params)
+{
+	size_t rsp_cnt;
+	size_t attr_cnt = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(peer_db); i++) {
+		attr_cnt += attr_match(&peer_db[i], params);
+	}
+
+	/* Responses with attributes and the one ending the procedure */
+	rsp_cnt = ceiling_fraction(attr_cnt, ATTRS_PER_RSP) + 1;
+
+	mock.discover_cnt++;
+	mock.discover_params = params;
+	k_work_reschedule(&mock.discover_work, K_MSEC(rsp_cnt * ATT_RTT_MS));
+
+	return 0;
+}
+
+static void read_work_handler(struct k_work *work)
+{
+	struct bt_gatt_read_params *params = mock.read_params;
+	uint16_t handle = params->single.handle;
+
+	if (params->handle_count == 0) {
+		zassert_true(!bt_uuid_cmp(params->by_uuid.uuid,
+					  BT_UUID_GATT_DB_HASH),
+			     "Unexpected read by UUID");
+		if (mock.db_hash) {
+			params->func(conn, 0, params, mock.hash,
+				     sizeof(mock.hash));
+		} else {
+			params->func(conn, BT_ATT_ERR_ATTRIBUTE_NOT_FOUND,
+				     params, NULL, 0);
+		}
+		return;
+	}
+
+	switch (handle) {
+	case 6:
+		params->func(conn, 0, params, hid_info, sizeof(hid_info));
+		break;
+	case 12:
+		params->func(conn, 0, params, report_ref[0], 2);
+		break;
+	case 16:
+		params->func(conn, 0, params, report_ref[1], 2);
+		break;
+	case 19:
+		params->func(conn, 0, params, report_ref[2], 2);
+		break;
+	default:
+		zassert_unreachable("Unexpected read of handle %u", handle);
+	}
+}
+
+int bt_gatt_read(struct bt_conn *c, struct bt_gatt_read_params *params)
+{
+	mock.read_cnt++;
+	mock.read_params = params;
+	k_work_reschedule(&mock.read_work, K_MSEC(ATT_RTT_MS));
+
+	return 0;
+}
+
+int bt_gatt_write(struct bt_conn *c, struct bt_gatt_write_params *params)
+{
+	return -ENOTSUP;
+}
+
+int bt_gatt_write_without_response_cb(struct bt_conn *c, uint16_t handle,
+				      const void *data, uint16_t length,
+				      bool sign, bt_gatt_complete_func_t func,
+				      void *user_data)
+{
+	return -ENOTSUP;
+}
+
+int bt_gatt_subscribe(struct bt_conn *c,
+		      struct bt_gatt_subscribe_params *params)
+{
+	return -ENOTSUP;
+}
+
+int bt_gatt_unsubscribe(struct bt_conn *c,
+			struct bt_gatt_subscribe_params *params)
+{
+	return -ENOTSUP;
+}
+
+int settings_save_one(const char *name, const void *value, size_t val_len)
+{
+	size_t free_idx = ARRAY_SIZE(store);
+
+	zassert_true(strlen(name) < STORE_NAME_LEN, "Too long name: %s", name);
+	zassert_true(val_len <= STORE_VAL_LEN, "Too long value: %zu", val_len);
+
+	for (size_t i = 0; i < ARRAY_SIZE(store); i++) {
+		if (!strcmp(store[i].name, name)) {
+			free_idx = i;
+			break;
+		}
+		if (!store[i].name[0] && (free_idx == ARRAY_SIZE(store))) {
+			free_idx = i;
+		}
+	}
+
+	zassert_true(free_idx < ARRAY_SIZE(store), "Settings store full");
+
+	strcpy(store[free_idx].name, name);
+	memcpy(store[free_idx].val, value, val_len);
+	store[free_idx].len = val_len;
+
+	return 0;
+}
+
+int settings_delete(const char *name)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(store); i++) {
+		if (!strcmp(store[i].name, name)) {
+			memset(&store[i], 0, sizeof(store[i]));
+		}
+	}
+
+	return 0;
+}
+
+static ssize_t store_read(void *cb_arg, void *data, size_t len)
+{
+	size_t i = (size_t)cb_arg;
+
+	len = MIN(len, store[i].len);
+	memcpy(data, store[i].val, len);
+
+	return len;
+}
+
+int settings_load_subtree_direct(const char *subtree,
+				 settings_load_direct_cb cb, void *param)
+{
+	size_t len = strlen(subtree);
+
+	for (size_t i = 0; i < ARRAY_SIZE(store); i++) {
+		const char *name = store[i].name;
+		const char *key;
+
+		if (!name[0] || strncmp(name, subtree, len)) {
+			continue;
+		}
+
+		if (name[len] == '\0') {
+			key = NULL;
+		} else if (name[len] == '/') {
+			key = &name[len + 1];
+		} else {
+			continue;
+		}
+
+		cb(key, store[i].len, store_read, (void *)i, param);
+	}
+
+	return 0;
+}
+
+static size_t store_cnt(void)
+{
+	size_t cnt = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(store); i++) {
+		cnt += (store[i].name[0] != '\0');
+	}
+
+	return cnt;
+}
+
+static void dm_completed(struct bt_gatt_dm *dm, void *context)
+{
+	dm_found = dm;
+	dm_restored = bt_gatt_dm_cache_restored(dm);
+	k_sem_give(&dm_done);
+}
+
+static void dm_service_not_found(struct bt_conn *c, void *context)
+{
+	dm_found = NULL;
+	k_sem_give(&dm_done);
+}
+
+static void dm_error_found(struct bt_conn *c, int err, void *context)
+{
+	zassert_unreachable("Discovery error: %d", err);
+}
+
+static const struct bt_gatt_dm_cb dm_cb = {
+	.completed = dm_completed,
+	.service_not_found = dm_service_not_found,
+	.error_found = dm_error_found,
+};
+
+static void hogp_ready_cb(struct bt_hogp *hogp)
+{
+	k_sem_give(&hogp_ready);
+}
+
+static void hogp_prep_error_cb(struct bt_hogp *hogp, int err)
+{
+	zassert_unreachable("HOGP preparation error: %d", err);
+}
+
+static void connect(const bt_addr_le_t *peer)
+{
+	mock.peer = peer;
+	mock.connected = true;
+	mock.discover_cnt = 0;
+	mock.read_cnt = 0;
+	k_sem_reset(&dm_done);
+	k_sem_reset(&hogp_ready);
+}
+
+static struct bt_gatt_dm *discover(const struct bt_uuid *uuid)
+{
+	zassert_ok(bt_gatt_dm_start(conn, uuid, &dm_cb, NULL),
+		   "Discovery not started");
+	zassert_ok(k_sem_take(&dm_done, READY_TIMEOUT), "Discovery timeout");
+
+	return dm_found;
+}
+
+static struct bt_gatt_dm *discover_next(struct bt_gatt_dm *dm)
+{
+	zassert_ok(bt_gatt_dm_data_release(dm), "Data not released");
+	zassert_ok(bt_gatt_dm_continue(dm, NULL), "Discovery not continued");
+	zassert_ok(k_sem_take(&dm_done, READY_TIMEOUT), "Discovery timeout");
+
+	return dm_found;
+}
+
+/* Time from the start of the discovery until the HID reports can be used */
+static int64_t hids_connect(const bt_addr_le_t *peer)
+{
+	const struct bt_hogp_init_params params = {
+		.ready_cb = hogp_ready_cb,
+		.prep_error_cb = hogp_prep_error_cb,
+	};
+	struct bt_gatt_dm *dm;
+	int64_t start;
+
+	connect(peer);
+	bt_hogp_init(&hogp, &params);
+
+	start = k_uptime_get();
+
+	dm = discover(BT_UUID_HIDS);
+	zassert_not_null(dm, "HIDS not found");
+	zassert_ok(bt_hogp_handles_assign(dm, &hogp), "Handles not assigned");
+	zassert_ok(bt_gatt_dm_data_release(dm), "Data not released");
+
+	zassert_ok(k_sem_take(&hogp_ready, READY_TIMEOUT), "HOGP not ready");
+
+	return k_uptime_get() - start;
+}
+
+static void hids_check(void)
+{
+	struct bt_hogp_rep_info *rep = NULL;
+	const struct bt_hids_info *info = bt_hogp_conn_info_val(&hogp);
+
+	zassert_equal(REPORT_CNT, bt_hogp_rep_count(&hogp),
+		      "Unexpected report count");
+	for (size_t i = 0; i < REPORT_CNT; i++) {
+		rep = bt_hogp_rep_next(&hogp, rep);
+		zassert_not_null(rep, "Missing report %zu", i);
+		zassert_equal(report_ref[i][0], bt_hogp_rep_id(rep),
+			      "Unexpected ID of report %zu", i);
+		zassert_equal(report_ref[i][1], bt_hogp_rep_type(rep),
+			      "Unexpected type of report %zu", i);
+	}
+
+	zassert_equal(0x0111, info->bcd_hid, "Unexpected bcdHID");
+	zassert_equal(0x02, info->flags, "Unexpected HID information flags");
+
+	bt_hogp_release(&hogp);
+}
+
+static void test_setup(void)
+{
+	memset(store, 0, sizeof(store));
+	mock.bonded = true;
+	mock.db_hash = true;
+	memset(mock.hash, 0xa5, sizeof(mock.hash));
+}
+
+static void test_reconnect(void)
+{
+	int64_t discovered;
+	int64_t restored;
+
+	discovered = hids_connect(&peer_a);
+	zassert_false(dm_restored, "Service restored from an empty cache");
+	zassert_equal(3, mock.discover_cnt, "Unexpected discovery count");
+	/* Database Hash, HID Information and Report References */
+	zassert_equal(2 + REPORT_CNT, mock.read_cnt, "Unexpected read count");
+	zassert_equal(2, store_cnt(), "Service and HID data not stored");
+	hids_check();
+
+	restored = hids_connect(&peer_a);
+	zassert_true(dm_restored, "Service not restored");
+	zassert_equal(0, mock.discover_cnt, "Service discovered");
+	/* Database Hash and HID Information, as there is no Protocol Mode */
+	zassert_equal(2, mock.read_cnt, "Unexpected read count");
+	hids_check();
+
+	TC_PRINT("Reconnect to ready: %lld ms discovered, %lld ms cached\n",
+		 discovered, restored);
+	zassert_true(restored < discovered, "Cache does not save time");
+}
+
+static void test_db_hash_changed(void)
+{
+	hids_connect(&peer_a);
+	zassert_equal(3, mock.discover_cnt, "Unexpected discovery count");
+	hids_check();
+
+	mock.hash[0]++;
+
+	hids_connect(&peer_a);
+	zassert_false(dm_restored, "Service restored for a changed database");
+	zassert_equal(3, mock.discover_cnt, "Unexpected discovery count");
+	zassert_equal(2 + REPORT_CNT, mock.read_cnt, "Unexpected read count");
+	zassert_equal(2, store_cnt(), "Cache entries not replaced");
+	hids_check();
+
+	hids_connect(&peer_a);
+	zassert_true(dm_restored, "Service not restored");
+	zassert_equal(0, mock.discover_cnt, "Service discovered");
+	hids_check();
+}
+
+static void test_not_bonded(void)
+{
+	mock.bonded = false;
+
+	hids_connect(&peer_a);
+	hids_check();
+
+	hids_connect(&peer_a);
+	zassert_false(dm_restored, "Service restored for a peer without bond");
+	zassert_equal(3, mock.discover_cnt, "Unexpected discovery count");
+	/* No Database Hash read */
+	zassert_equal(1 + REPORT_CNT, mock.read_cnt, "Unexpected read count");
+	zassert_equal(0, store_cnt(), "Service stored for a peer without bond");
+	hids_check();
+}
+
+static void test_no_db_hash(void)
+{
+	mock.db_hash = false;
+
+	hids_connect(&peer_a);
+	hids_check();
+
+	hids_connect(&peer_a);
+	zassert_false(dm_restored, "Service restored without Database Hash");
+	zassert_equal(3, mock.discover_cnt, "Unexpected discovery count");
+	zassert_equal(2 + REPORT_CNT, mock.read_cnt, "Unexpected read count");
+	zassert_equal(0, store_cnt(), "Service stored without Database Hash");
+	hids_check();
+}
+
+static void test_link_lost(void)
+{
+	connect(&peer_a);
+	zassert_not_null(discover(BT_UUID_HIDS), "HIDS not found");
+	mock.connected = false;
+	zassert_ok(bt_gatt_dm_data_release(dm_found), "Data not released");
+
+	/* The discovery ends when the link is lost, its result is not stored */
+	connect(&peer_a);
+	mock.connected = false;
+	zassert_not_null(discover(BT_UUID_HRS), "HRS not found");
+	zassert_ok(bt_gatt_dm_data_release(dm_found), "Data not released");
+	zassert_equal(1, store_cnt(), "Service stored after the link was lost");
+}
+
+static void test_service_instances(void)
+{
+	const uint16_t handles[] = { 25, 28 };
+	struct bt_gatt_dm *dm;
+
+	for (int run = 0; run < 2; run++) {
+		connect(&peer_a);
+
+		dm = discover(BT_UUID_HRS);
+		for (size_t i = 0; i < ARRAY_SIZE(handles); i++) {
+			zassert_not_null(dm, "HRS %zu not found", i);
+			zassert_equal(run == 1, dm_restored,
+				      "Unexpected source of HRS %zu", i);
+			zassert_equal(handles[i],
+				      bt_gatt_dm_service_get(dm)->handle,
+				      "Unexpected HRS %zu", i);
+			zassert_equal(3, bt_gatt_dm_attr_cnt(dm),
+				      "Unexpected attribute count");
+			dm = discover_next(dm);
+		}
+		zassert_is_null(dm, "Unexpected HRS instance");
+
+		if (run == 0) {
+			zassert_equal(7, mock.discover_cnt,
+				      "Unexpected discovery count");
+		} else {
+			zassert_equal(0, mock.discover_cnt, "HRS discovered");
+		}
+	}
+
+	/* Both instances, and the end of the service list */
+	zassert_equal(3, store_cnt(), "Unexpected number of cache entries");
+}
+
+static void test_invalid_entry(void)
+{
+	hids_connect(&peer_a);
+	hids_check();
+
+	for (size_t i = 0; i < ARRAY_SIZE(store); i++) {
+		if (store[i].len > 32) {
+			store[i].len -= 5;
+		}
+	}
+
+	hids_connect(&peer_a);
+	zassert_false(dm_restored, "Service restored from an invalid entry");
+	zassert_equal(3, mock.discover_cnt, "Unexpected discovery count");
+	hids_check();
+
+	hids_connect(&peer_a);
+	zassert_true(dm_restored, "Service not restored");
+	hids_check();
+}
+
+static void test_bond_deleted(void)
+{
+	zassert_not_null(auth_info_cb, "Authentication info not registered");
+	zassert_not_null(auth_info_cb->bond_deleted, "No bond deleted callback");
+
+	hids_connect(&peer_a);
+	hids_check();
+	hids_connect(&peer_b);
+	hids_check();
+	zassert_equal(4, store_cnt(), "Unexpected number of cache entries");
+
+	auth_info_cb->bond_deleted(BT_ID_DEFAULT, &peer_a);
+	zassert_equal(2, store_cnt(), "Cache of the peer not deleted");
+
+	hids_connect(&peer_a);
+	zassert_false(dm_restored, "Service restored after the bond deletion");
+	hids_check();
+
+	hids_connect(&peer_b);
+	zassert_true(dm_restored, "Cache of another peer deleted");
+	hids_check();
+}
+
+void test_main(void)
+{
+	k_work_init_delayable(&mock.discover_work, discover_work_handler);
+	k_work_init_delayable(&mock.read_work, read_work_handler);
+
+	ztest_test_suite(bt_gatt_dm_cache_test,
+			 ztest_unit_test_setup_teardown(test_reconnect,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_db_hash_changed,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_not_bonded,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_no_db_hash,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_link_lost,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_service_instances,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_invalid_entry,
+							test_setup,
+							unit_test_noop),
+			 ztest_unit_test_setup_teardown(test_bond_deleted,
+							test_setup,
+							unit_test_noop)
+			 );
+
+	ztest_run_test_suite(bt_gatt_dm_cache_test);
+}
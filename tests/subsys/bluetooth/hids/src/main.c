@@ -0,0 +1,551 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/bluetooth/conn.h>
+#include <zephyr/bluetooth/gatt.h>
+#include <bluetooth/services/hids.h>
+
+#define CONN_CNT CONFIG_BT_HIDS_MAX_CLIENT_COUNT
+
+#define REP_IDX_MOVE   0
+#define REP_SIZE_MOVE  3
+#define REP_IDX_MASKED 1
+#define REP_SIZE_MASKED 8
+
+#define BENCH_EVENTS 1000
+
+BT_HIDS_DEF(hids_obj, REP_SIZE_MOVE, REP_SIZE_MASKED);
+
+/* Only the first half of the masked report is stored. */
+static const uint8_t rep_mask[] = {0x0f};
+
+/* Connection objects are only compared by address. */
+static uint8_t conn_mem[CONN_CNT];
+static bool subscribed[CONN_CNT];
+
+static size_t notify_conn_cnt;
+static size_t notify_all_cnt;
+
+#define CONN(_i) ((struct bt_conn *)&conn_mem[_i])
+
+static size_t conn_idx(const struct bt_conn *conn)
+{
+	size_t idx = (const uint8_t *)conn - conn_mem;
+
+	zassert_true(idx < CONN_CNT, "Unknown connection");
+
+	return idx;
+}
+
+bool bt_gatt_is_subscribed(struct bt_conn *conn,
+			   const struct bt_gatt_attr *attr, uint16_t ccc_type)
+{
+	return subscribed[conn_idx(conn)];
+}
+
+int bt_gatt_notify_cb(struct bt_conn *conn,
+		      struct bt_gatt_notify_params *params)
+{
+	if (conn) {
+		zassert_true(subscribed[conn_idx(conn)],
+			     "Notification to a connection that is not subscribed");
+		notify_conn_cnt++;
+	} else {
+		notify_all_cnt++;
+	}
+
+	return 0;
+}
+
+int bt_gatt_service_register(struct bt_gatt_service *svc)
+{
+	return 0;
+}
+
+int bt_gatt_service_unregister(struct bt_gatt_service *svc)
+{
+	return 0;
+}
+
+ssize_t bt_gatt_attr_read(struct bt_conn *conn, const struct bt_gatt_attr *attr,
+			  void *buf, uint16_t buf_len, uint16_t offset,
+			  const void *value, uint16_t value_len)
+{
+	uint16_t len;
+
+	if (offset > value_len) {
+		return BT_GATT_ERR(BT_ATT_ERR_INVALID_OFFSET);
+	}
+
+	len = MIN(buf_len, value_len - offset);
+	memcpy(buf, (const uint8_t *)value + offset, len);
+
+	return len;
+}
+
+ssize_t bt_gatt_attr_read_service(struct bt_conn *conn,
+				  const struct bt_gatt_attr *attr,
+				  void *buf, uint16_t len, uint16_t offset)
+{
+	return 0;
+}
+
+ssize_t bt_gatt_attr_read_chrc(struct bt_conn *conn,
+			       const struct bt_gatt_attr *attr, void *buf,
+			       uint16_t len, uint16_t offset)
+{
+	return 0;
+}
+
+ssize_t bt_gatt_attr_read_ccc(struct bt_conn *conn,
+			      const struct bt_gatt_attr *attr, void *buf,
+			      uint16_t len, uint16_t offset)
+{
+	return 0;
+}
+
+ssize_t bt_gatt_attr_write_ccc(struct bt_conn *conn,
+			       const struct bt_gatt_attr *attr, const void *buf,
+			       uint16_t len, uint16_t offset, uint8_t flags)
+{
+	return len;
+}
+
+static void rep_read(struct bt_conn *conn, uint8_t rep_idx, uint8_t *buf,
+		     uint8_t len)
+{
+	struct bt_hids_inp_rep *rep = &hids_obj.inp_rep_group.reports[rep_idx];
+	const struct bt_gatt_attr *attr = &hids_obj.gp.svc.attrs[rep->att_ind];
+	ssize_t ret;
+
+	ret = attr->read(conn, attr, buf, len, 0);
+	zassert_equal(ret, len, "Unexpected Input Report length");
+}
+
+static void rep_check(struct bt_conn *conn, uint8_t rep_idx,
+		      const uint8_t *expected, uint8_t len)
+{
+	uint8_t buf[REP_SIZE_MASKED];
+
+	rep_read(conn, rep_idx, buf, len);
+	zassert_equal(memcmp(buf, expected, len), 0,
+		      "Unexpected Input Report value for connection %zu",
+		      conn_idx(conn));
+}
+
+static void hids_setup(void)
+{
+	struct bt_hids_init_param init_param = {0};
+	struct bt_hids_inp_rep *rep;
+	int err;
+
+	init_param.inp_rep_group_init.cnt = 2;
+
+	rep = &init_param.inp_rep_group_init.reports[REP_IDX_MOVE];
+	rep->size = REP_SIZE_MOVE;
+	rep->id = 1;
+
+	rep = &init_param.inp_rep_group_init.reports[REP_IDX_MASKED];
+	rep->size = REP_SIZE_MASKED;
+	rep->id = 2;
+	rep->rep_mask = rep_mask;
+
+	err = bt_hids_init(&hids_obj, &init_param);
+	zassert_ok(err, "HIDS initialization failed (err %d)", err);
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		err = bt_hids_connected(&hids_obj, CONN(i));
+		zassert_ok(err, "Connection %zu not accepted (err %d)", i, err);
+		subscribed[i] = true;
+	}
+
+	notify_conn_cnt = 0;
+	notify_all_cnt = 0;
+}
+
+static void hids_teardown(void)
+{
+	int err;
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		err = bt_hids_disconnected(&hids_obj, CONN(i));
+		zassert_ok(err, "Disconnection failed (err %d)", err);
+	}
+
+	err = bt_hids_uninit(&hids_obj);
+	zassert_ok(err, "HIDS uninitialization failed (err %d)", err);
+}
+
+static void test_notify_all(void)
+{
+	static const uint8_t zero[REP_SIZE_MOVE];
+	const uint8_t rep[REP_SIZE_MOVE] = {0x11, 0x22, 0x33};
+	int err;
+
+	/* Connections start with an empty report value. */
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		rep_check(CONN(i), REP_IDX_MOVE, zero, sizeof(zero));
+	}
+
+	subscribed[0] = false;
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MOVE, rep,
+				   sizeof(rep), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+	zassert_equal(notify_all_cnt, 1, "Expected one notification");
+	zassert_equal(notify_conn_cnt, 0, "Unexpected connection notification");
+
+	rep_check(CONN(0), REP_IDX_MOVE, zero, sizeof(zero));
+	for (size_t i = 1; i < CONN_CNT; i++) {
+		rep_check(CONN(i), REP_IDX_MOVE, rep, sizeof(rep));
+	}
+
+	/* Values of the subscribers are not copied per connection. */
+	for (size_t i = 1; i < CONN_CNT; i++) {
+		struct bt_hids_conn_data *conn_data =
+			bt_conn_ctx_get(hids_obj.conn_ctx, CONN(i));
+
+		zassert_false(conn_data->inp_rep_own & BIT(REP_IDX_MOVE),
+			      "Report value copied for connection %zu", i);
+		bt_conn_ctx_release(hids_obj.conn_ctx, conn_data);
+	}
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		subscribed[i] = false;
+	}
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MOVE, rep,
+				   sizeof(rep), NULL);
+	zassert_equal(err, -ENODATA, "Unexpected error (err %d)", err);
+}
+
+static void test_single_conn_diverges(void)
+{
+	const uint8_t rep_all[REP_SIZE_MOVE] = {0x01, 0x02, 0x03};
+	const uint8_t rep_one[REP_SIZE_MOVE] = {0xa1, 0xa2, 0xa3};
+	const uint8_t rep_next[REP_SIZE_MOVE] = {0xb1, 0xb2, 0xb3};
+	int err;
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MOVE, rep_all,
+				   sizeof(rep_all), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+
+	err = bt_hids_inp_rep_send(&hids_obj, CONN(1), REP_IDX_MOVE, rep_one,
+				   sizeof(rep_one), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+	zassert_equal(notify_conn_cnt, 1, "Expected one notification");
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		rep_check(CONN(i), REP_IDX_MOVE, (i == 1) ? rep_one : rep_all,
+			  sizeof(rep_all));
+	}
+
+	/* Connection 0 does not receive the next report and keeps its value. */
+	subscribed[0] = false;
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MOVE, rep_next,
+				   sizeof(rep_next), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+
+	rep_check(CONN(0), REP_IDX_MOVE, rep_all, sizeof(rep_all));
+	for (size_t i = 1; i < CONN_CNT; i++) {
+		rep_check(CONN(i), REP_IDX_MOVE, rep_next, sizeof(rep_next));
+	}
+
+	subscribed[2] = false;
+
+	err = bt_hids_inp_rep_send(&hids_obj, CONN(2), REP_IDX_MOVE, rep_all,
+				   sizeof(rep_all), NULL);
+	zassert_equal(err, -EACCES, "Unexpected error (err %d)", err);
+}
+
+static void test_send_conns(void)
+{
+	static const uint8_t zero[REP_SIZE_MOVE];
+	const uint8_t rep[REP_SIZE_MOVE] = {0x44, 0x55, 0x66};
+	struct bt_conn *conns[] = {CONN(1), CONN(2), CONN(3)};
+	int err;
+
+	subscribed[3] = false;
+
+	err = bt_hids_inp_rep_send_conns(&hids_obj, conns, ARRAY_SIZE(conns),
+					 REP_IDX_MOVE, rep, sizeof(rep), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+	zassert_equal(notify_conn_cnt, 2, "Expected two notifications");
+	zassert_equal(notify_all_cnt, 0, "Unexpected notification to all");
+
+	rep_check(CONN(0), REP_IDX_MOVE, zero, sizeof(zero));
+	rep_check(CONN(1), REP_IDX_MOVE, rep, sizeof(rep));
+	rep_check(CONN(2), REP_IDX_MOVE, rep, sizeof(rep));
+	rep_check(CONN(3), REP_IDX_MOVE, zero, sizeof(zero));
+
+	err = bt_hids_inp_rep_send_conns(&hids_obj, conns, ARRAY_SIZE(conns),
+					 REP_IDX_MOVE, rep, sizeof(rep) - 1,
+					 NULL);
+	zassert_equal(err, -EINVAL, "Unexpected error (err %d)", err);
+
+	err = bt_hids_inp_rep_send_conns(&hids_obj, &conns[2], 1,
+					 REP_IDX_MOVE, rep, sizeof(rep), NULL);
+	zassert_equal(err, -ENODATA, "Unexpected error (err %d)", err);
+}
+
+static void test_masked_report(void)
+{
+	const uint8_t rep_first[REP_SIZE_MASKED] = {
+		1, 2, 3, 4, 5, 6, 7, 8
+	};
+	const uint8_t rep_second[REP_SIZE_MASKED] = {
+		9, 10, 11, 12, 13, 14, 15, 16
+	};
+	const uint8_t stored_first[REP_SIZE_MASKED] = {1, 2, 3, 4};
+	const uint8_t stored_second[REP_SIZE_MASKED] = {9, 10, 11, 12};
+	static const uint8_t zero[REP_SIZE_MASKED];
+	int err;
+
+	subscribed[0] = false;
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MASKED, rep_first,
+				   sizeof(rep_first), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+
+	rep_check(CONN(0), REP_IDX_MASKED, zero, sizeof(zero));
+	for (size_t i = 1; i < CONN_CNT; i++) {
+		rep_check(CONN(i), REP_IDX_MASKED, stored_first,
+			  sizeof(stored_first));
+	}
+
+	subscribed[0] = true;
+	subscribed[1] = false;
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MASKED,
+				   rep_second, sizeof(rep_second), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+
+	rep_check(CONN(1), REP_IDX_MASKED, stored_first, sizeof(stored_first));
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		if (i != 1) {
+			rep_check(CONN(i), REP_IDX_MASKED, stored_second,
+				  sizeof(stored_second));
+		}
+	}
+}
+
+static void test_reinit(void)
+{
+	static const uint8_t zero[REP_SIZE_MOVE];
+	const uint8_t rep[REP_SIZE_MOVE] = {0x77, 0x88, 0x99};
+	int err;
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MOVE, rep,
+				   sizeof(rep), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+
+	hids_teardown();
+	hids_setup();
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		rep_check(CONN(i), REP_IDX_MOVE, zero, sizeof(zero));
+	}
+
+	err = bt_hids_inp_rep_send(&hids_obj, NULL, REP_IDX_MOVE, rep,
+				   sizeof(rep), NULL);
+	zassert_ok(err, "Sending failed (err %d)", err);
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		rep_check(CONN(i), REP_IDX_MOVE, rep, sizeof(rep));
+	}
+}
+
+enum bench_mode {
+	BENCH_MODE_PER_CONN,
+	BENCH_MODE_ALL,
+	BENCH_MODE_CONN_LIST,
+	BENCH_MODE_COUNT
+};
+
+struct bench_result {
+	size_t notifications;
+	size_t stored_bytes;
+	uint32_t cycles;
+};
+
+static void snapshot(uint8_t *buf)
+{
+	size_t block_size = bt_conn_ctx_block_size_get(hids_obj.conn_ctx);
+
+	memcpy(buf, hids_obj.inp_rep_shared, hids_obj.inp_rep_shared_size);
+	buf += hids_obj.inp_rep_shared_size;
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		struct bt_hids_conn_data *conn_data =
+			bt_conn_ctx_get(hids_obj.conn_ctx, CONN(i));
+
+		memcpy(buf, conn_data, block_size);
+		bt_conn_ctx_release(hids_obj.conn_ctx, conn_data);
+		buf += block_size;
+	}
+}
+
+static size_t snapshot_diff(const uint8_t *a, const uint8_t *b, size_t len)
+{
+	size_t diff = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		diff += (a[i] != b[i]);
+	}
+
+	return diff;
+}
+
+static void bench_run(struct bench_result *res, size_t conn_cnt,
+		      enum bench_mode mode)
+{
+	static uint8_t before[sizeof(CONCAT(hids_obj, _inp_rep_shared)) +
+			      CONN_CNT * 64];
+	static uint8_t after[sizeof(before)];
+	size_t snapshot_len = hids_obj.inp_rep_shared_size +
+			      CONN_CNT * bt_conn_ctx_block_size_get(hids_obj.conn_ctx);
+	struct bt_conn *conns[CONN_CNT];
+	uint8_t rep[REP_SIZE_MOVE];
+	uint32_t start;
+	int err;
+
+	zassert_true(snapshot_len <= sizeof(before), "Snapshot buffer too small");
+
+	for (size_t i = 0; i < CONN_CNT; i++) {
+		conns[i] = CONN(i);
+		subscribed[i] = (i < conn_cnt);
+	}
+
+	memset(res, 0, sizeof(*res));
+	notify_conn_cnt = 0;
+	notify_all_cnt = 0;
+
+	for (size_t ev = 0; ev < BENCH_EVENTS; ev++) {
+		/* Every byte of the report changes with every event. */
+		memset(rep, ev + 1, sizeof(rep));
+		if ((ev + 1) % 256 == 0) {
+			memset(rep, 0xaa, sizeof(rep));
+		}
+
+		snapshot(before);
+		start = k_cycle_get_32();
+
+		switch (mode) {
+		case BENCH_MODE_PER_CONN:
+			for (size_t i = 0; i < conn_cnt; i++) {
+				err = bt_hids_inp_rep_send(&hids_obj, conns[i],
+							   REP_IDX_MOVE, rep,
+							   sizeof(rep), NULL);
+				zassert_ok(err, "Sending failed (err %d)", err);
+			}
+			break;
+		case BENCH_MODE_ALL:
+			err = bt_hids_inp_rep_send(&hids_obj, NULL,
+						   REP_IDX_MOVE, rep,
+						   sizeof(rep), NULL);
+			zassert_ok(err, "Sending failed (err %d)", err);
+			break;
+		case BENCH_MODE_CONN_LIST:
+			err = bt_hids_inp_rep_send_conns(&hids_obj, conns,
+							 conn_cnt,
+							 REP_IDX_MOVE, rep,
+							 sizeof(rep), NULL);
+			zassert_ok(err, "Sending failed (err %d)", err);
+			break;
+		default:
+			zassert_unreachable("Unknown benchmark mode");
+		}
+
+		res->cycles += k_cycle_get_32() - start;
+		snapshot(after);
+
+		/* The first event moves the values to their steady state. */
+		if (ev > 0) {
+			res->stored_bytes += snapshot_diff(before, after,
+							   snapshot_len);
+		}
+	}
+
+	res->notifications = notify_conn_cnt + notify_all_cnt;
+}
+
+static void test_benchmark(void)
+{
+	static const char * const mode_name[] = {
+		[BENCH_MODE_PER_CONN] = "per-connection",
+		[BENCH_MODE_ALL] = "all connections",
+		[BENCH_MODE_CONN_LIST] = "connection list",
+	};
+	struct bench_result res;
+
+	/* Bytes stored and notification calls are exact on every platform.
+	 * Cycle counts are only meaningful on targets with a hardware cycle
+	 * counter, as simulated time does not advance while code executes on
+	 * native_posix.
+	 */
+	TC_PRINT("HIDS Input Report RAM: %zu B per connection context, %zu B shared\n",
+		 bt_conn_ctx_block_size_get(hids_obj.conn_ctx),
+		 hids_obj.inp_rep_shared_size);
+	TC_PRINT("%u events, report of %u B\n", BENCH_EVENTS, REP_SIZE_MOVE);
+
+	for (size_t conn_cnt = 1; conn_cnt <= CONN_CNT; conn_cnt++) {
+		for (enum bench_mode mode = 0; mode < BENCH_MODE_COUNT; mode++) {
+			bench_run(&res, conn_cnt, mode);
+
+			TC_PRINT("%zu conn, %-16s: %5zu notify calls, %3zu B stored per event, "
+				 "%u cycles\n",
+				 conn_cnt, mode_name[mode], res.notifications,
+				 res.stored_bytes / (BENCH_EVENTS - 1),
+				 res.cycles);
+
+			if (mode == BENCH_MODE_PER_CONN) {
+				zassert_equal(res.stored_bytes,
+					      (BENCH_EVENTS - 1) * conn_cnt *
+					      REP_SIZE_MOVE,
+					      "Unexpected per-connection copies");
+			} else {
+				zassert_equal(res.stored_bytes,
+					      (BENCH_EVENTS - 1) * REP_SIZE_MOVE,
+					      "Report not stored once per event");
+			}
+
+			zassert_equal(res.notifications,
+				      BENCH_EVENTS *
+				      ((mode == BENCH_MODE_ALL) ? 1 : conn_cnt),
+				      "Unexpected number of notifications");
+		}
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(hids_tests,
+			 ztest_unit_test_setup_teardown(test_notify_all,
+							hids_setup,
+							hids_teardown),
+			 ztest_unit_test_setup_teardown(test_single_conn_diverges,
+							hids_setup,
+							hids_teardown),
+			 ztest_unit_test_setup_teardown(test_send_conns,
+							hids_setup,
+							hids_teardown),
+			 ztest_unit_test_setup_teardown(test_masked_report,
+							hids_setup,
+							hids_teardown),
+			 ztest_unit_test_setup_teardown(test_reinit,
+							hids_setup,
+							hids_teardown),
+			 ztest_unit_test_setup_teardown(test_benchmark,
+							hids_setup,
+							hids_teardown)
+			 );
+
+	ztest_run_test_suite(hids_tests);
+}
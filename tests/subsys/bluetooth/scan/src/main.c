@@ -0,0 +1,1174 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <string.h>
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <bluetooth/scan.h>
+
+#define CORPUS_SIZE 512
+#define CORPUS_SEED 0x5ca11ed
+#define ADV_MAX_LEN 62
+#define BENCH_ROUNDS 16
+
+#define NUS_UUID BT_UUID_128_ENCODE(0x6e400001, 0xb5a3, 0xf393, 0xe0a9, 0xe50e24dcca9e)
+#define LBS_UUID BT_UUID_128_ENCODE(0x00001523, 0x1212, 0xefde, 0x1523, 0x785feabcd123)
+#define VENDOR_UUID BT_UUID_128_ENCODE(0x8ec90001, 0xf315, 0x4f60, 0x9fb8, 0x838830daea50)
+#define BASE_UUID(_val) BT_UUID_128_ENCODE(_val, 0x0000, 0x1000, 0x8000, 0x00805f9b34fb)
+
+struct adv_report {
+	bt_addr_le_t addr;
+	uint8_t len;
+	uint8_t data[ADV_MAX_LEN];
+};
+
+static struct bt_le_scan_cb *scan_cb;
+
+static struct {
+	bool match;
+	struct bt_scan_filter_match status;
+} result;
+
+/* Filters added to the library, used by the reference matcher. */
+static struct {
+	char name[CONFIG_BT_SCAN_NAME_CNT][CONFIG_BT_SCAN_NAME_MAX_LEN + 1];
+	uint8_t name_cnt;
+	struct {
+		char name[CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN + 1];
+		uint8_t min_len;
+	} short_name[CONFIG_BT_SCAN_SHORT_NAME_CNT];
+	uint8_t short_name_cnt;
+	bt_addr_le_t addr[CONFIG_BT_SCAN_ADDRESS_CNT];
+	uint8_t addr_cnt;
+	const struct bt_uuid *uuid[CONFIG_BT_SCAN_UUID_CNT];
+	uint8_t uuid_cnt;
+	uint16_t appearance[CONFIG_BT_SCAN_APPEARANCE_CNT];
+	uint8_t appearance_cnt;
+	struct bt_scan_manufacturer_data manufacturer_data[CONFIG_BT_SCAN_MANUFACTURER_DATA_CNT];
+	uint8_t manufacturer_data_cnt;
+	uint8_t mode;
+	bool all_mode;
+} ref;
+
+static struct adv_report corpus[CORPUS_SIZE];
+static uint32_t rand_state;
+
+static const struct bt_uuid_16 hrs_uuid = BT_UUID_INIT_16(0x180d);
+static const struct bt_uuid_16 eddystone_uuid = BT_UUID_INIT_16(0xfeaa);
+static const struct bt_uuid_16 exposure_uuid = BT_UUID_INIT_16(0xfd6f);
+static const struct bt_uuid_32 bas_uuid = BT_UUID_INIT_32(0x180f);
+static const struct bt_uuid_128 hids_uuid = BT_UUID_INIT_128(BASE_UUID(0x1812));
+static const struct bt_uuid_128 nus_uuid = BT_UUID_INIT_128(NUS_UUID);
+static const struct bt_uuid_128 lbs_uuid = BT_UUID_INIT_128(LBS_UUID);
+
+static const char * const names[] = {
+	"Nordic_HRS", "Nordic_UART", "Nordic_Blinky", "Nordic_Throughput",
+	"Thingy", "Zephyr Heartrate Sensor", "HID Mouse", "HID Keyboard",
+	"Fitness Tracker", "LE-Bose Revolve+", "Galaxy Buds",
+	"Fast Pair Speaker", "[TV] Samsung 7 Series",
+};
+
+static const uint16_t uuid16_pool[] = {
+	0x180d, 0x180f, 0x1812, 0x1809, 0xfe2c, 0xfeaa, 0xfd6f, 0x181a, 0x1800,
+	0xfef3,
+};
+
+static const uint32_t uuid32_pool[] = {
+	0x0000180f, 0x0000fe2c, 0x12345678,
+};
+
+static const uint8_t uuid128_pool[][16] = {
+	{ NUS_UUID }, { LBS_UUID }, { VENDOR_UUID },
+	{ BASE_UUID(0x1812) }, { BASE_UUID(0x180d) },
+};
+
+static const uint16_t appearance_pool[] = {
+	0x03c1, 0x03c2, 0x0340, 0x0941, 0x0000,
+};
+
+static const uint8_t manufacturer_data_pool[][4] = {
+	{ 0x4c, 0x00, 0x02, 0x15 }, /* iBeacon */
+	{ 0x4c, 0x00, 0x10, 0x05 },
+	{ 0x59, 0x00, 0xbf, 0x0a },
+	{ 0x59, 0x00, 0x01, 0x02 },
+	{ 0x06, 0x00, 0x03, 0x00 }, /* Swift Pair */
+	{ 0xe0, 0x00, 0x00, 0x00 },
+};
+
+static uint8_t md_nordic_ext[] = { 0x59, 0x00, 0xbf };
+static uint8_t md_nordic[] = { 0x59, 0x00 };
+static uint8_t md_ibeacon[] = { 0x4c, 0x00, 0x02, 0x15 };
+static uint8_t md_swift_pair[] = { 0x06, 0x00, 0x03, 0x00 };
+
+/* Bluetooth API used by the scan library. */
+void bt_le_scan_cb_register(struct bt_le_scan_cb *cb)
+{
+	scan_cb = cb;
+}
+
+int bt_le_scan_start(const struct bt_le_scan_param *param, bt_le_scan_cb_t cb)
+{
+	return 0;
+}
+
+int bt_le_scan_stop(void)
+{
+	return 0;
+}
+
+int bt_conn_le_create(const bt_addr_le_t *peer,
+		      const struct bt_conn_le_create_param *create_param,
+		      const struct bt_le_conn_param *conn_param,
+		      struct bt_conn **conn)
+{
+	return -ENOTCONN;
+}
+
+void bt_conn_unref(struct bt_conn *conn)
+{
+}
+
+static void scan_filter_match(struct bt_scan_device_info *device_info,
+			      struct bt_scan_filter_match *filter_match,
+			      bool connectable)
+{
+	result.match = true;
+	result.status = *filter_match;
+}
+
+static void scan_filter_no_match(struct bt_scan_device_info *device_info,
+				 bool connectable)
+{
+	result.match = false;
+}
+
+BT_SCAN_CB_INIT(scan_cb_data, scan_filter_match, scan_filter_no_match,
+		NULL, NULL);
+
+static uint32_t rand_get(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return rand_state;
+}
+
+static uint32_t rand_range(uint32_t range)
+{
+	return rand_get() % range;
+}
+
+static void addr_get(bt_addr_le_t *addr, uint8_t idx)
+{
+	addr->type = (idx & 1) ? BT_ADDR_LE_RANDOM : BT_ADDR_LE_PUBLIC;
+	addr->a.val[0] = idx;
+	addr->a.val[1] = 0x5a;
+	addr->a.val[2] = 0x1e;
+	addr->a.val[3] = 0x77;
+	addr->a.val[4] = 0x00;
+	addr->a.val[5] = 0xc0;
+}
+
+static bool scan_report(const struct adv_report *report)
+{
+	struct bt_le_scan_recv_info info = {
+		.addr = &report->addr,
+		.adv_props = BT_GAP_ADV_PROP_CONNECTABLE,
+	};
+	struct net_buf_simple ad = {
+		.data = (uint8_t *)report->data,
+		.len = report->len,
+		.size = report->len,
+		.__buf = (uint8_t *)report->data,
+	};
+
+	memset(&result, 0, sizeof(result));
+	scan_cb->recv(&info, &ad);
+
+	return result.match;
+}
+
+static void report_set(struct adv_report *report, uint8_t addr_idx,
+		       const void *data, size_t len)
+{
+	zassert_true(len <= sizeof(report->data), "Report too long");
+
+	addr_get(&report->addr, addr_idx);
+	memcpy(report->data, data, len);
+	report->len = len;
+}
+
+static void filters_reset(void)
+{
+	bt_scan_filter_remove_all();
+	bt_scan_filter_disable();
+	memset(&ref, 0, sizeof(ref));
+}
+
+static void filters_enable(uint8_t mode, bool all_mode)
+{
+	zassert_equal(bt_scan_filter_enable(mode, all_mode), 0,
+		      "Cannot enable filters");
+
+	ref.mode = mode;
+	ref.all_mode = all_mode;
+}
+
+static void name_filter_add(const char *name)
+{
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_NAME, name), 0,
+		      "Cannot add name filter");
+	strcpy(ref.name[ref.name_cnt++], name);
+}
+
+static void short_name_filter_add(const char *name, uint8_t min_len)
+{
+	struct bt_scan_short_name short_name = {
+		.name = name,
+		.min_len = min_len,
+	};
+
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_SHORT_NAME,
+					 &short_name), 0,
+		      "Cannot add short name filter");
+	strcpy(ref.short_name[ref.short_name_cnt].name, name);
+	ref.short_name[ref.short_name_cnt++].min_len = min_len;
+}
+
+static void addr_filter_add(uint8_t idx)
+{
+	bt_addr_le_t addr;
+
+	addr_get(&addr, idx);
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_ADDR, &addr), 0,
+		      "Cannot add address filter");
+	bt_addr_le_copy(&ref.addr[ref.addr_cnt++], &addr);
+}
+
+static void uuid_filter_add(const struct bt_uuid *uuid)
+{
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_UUID, uuid), 0,
+		      "Cannot add UUID filter");
+	ref.uuid[ref.uuid_cnt++] = uuid;
+}
+
+static void appearance_filter_add(uint16_t appearance)
+{
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_APPEARANCE,
+					 &appearance), 0,
+		      "Cannot add appearance filter");
+	ref.appearance[ref.appearance_cnt++] = appearance;
+}
+
+static void manufacturer_data_filter_add(uint8_t *data, uint8_t len)
+{
+	struct bt_scan_manufacturer_data manufacturer_data = {
+		.data = data,
+		.data_len = len,
+	};
+
+	zassert_equal(bt_scan_filter_add(BT_SCAN_FILTER_TYPE_MANUFACTURER_DATA,
+					 &manufacturer_data), 0,
+		      "Cannot add manufacturer data filter");
+	ref.manufacturer_data[ref.manufacturer_data_cnt++] = manufacturer_data;
+}
+
+static void filters_add_all(void)
+{
+	name_filter_add("Nordic_HRS");
+	name_filter_add("Nordic_UART");
+	name_filter_add("Thingy");
+	name_filter_add("Zephyr Heartrate Sensor");
+	name_filter_add("HID Keyboard");
+	name_filter_add("Fast Pair Speaker");
+
+	short_name_filter_add("Nordic_Blinky", 10);
+	short_name_filter_add("Nordic", 3);
+	short_name_filter_add("Galaxy Buds", 4);
+
+	for (uint8_t i = 0; i < 4; i++) {
+		addr_filter_add(i * 3);
+	}
+
+	uuid_filter_add(&hrs_uuid.uuid);
+	uuid_filter_add(&eddystone_uuid.uuid);
+	uuid_filter_add(&bas_uuid.uuid);
+	uuid_filter_add(&nus_uuid.uuid);
+	uuid_filter_add(&lbs_uuid.uuid);
+	uuid_filter_add(&hids_uuid.uuid);
+	uuid_filter_add(&exposure_uuid.uuid);
+
+	appearance_filter_add(0x03c1);
+	appearance_filter_add(0x0941);
+
+	manufacturer_data_filter_add(md_nordic_ext, sizeof(md_nordic_ext));
+	manufacturer_data_filter_add(md_nordic, sizeof(md_nordic));
+	manufacturer_data_filter_add(md_ibeacon, sizeof(md_ibeacon));
+	manufacturer_data_filter_add(md_swift_pair, sizeof(md_swift_pair));
+}
+
+/* Reference matcher comparing every filter in turn, as the library did
+ * before the filters were compiled. Each filter type is checked until
+ * its first match.
+ */
+struct ref_control {
+	struct bt_scan_filter_match status;
+	uint8_t match_cnt;
+	bool all_mode;
+};
+
+static bool ref_name_cmp(const char *target, const uint8_t *data,
+			 uint8_t len, uint8_t min_len)
+{
+	return (len >= min_len) && (strncmp(target, (const char *)data, len) == 0);
+}
+
+static bool ref_uuid_find(const uint8_t *data, uint8_t len, uint8_t uuid_len,
+			  const struct bt_uuid *target)
+{
+	for (size_t i = 0; (i + uuid_len) <= len; i += uuid_len) {
+		struct bt_uuid_128 uuid;
+
+		if (bt_uuid_create(&uuid.uuid, &data[i], uuid_len) &&
+		    (bt_uuid_cmp(&uuid.uuid, target) == 0)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool ref_uuid_check(struct ref_control *ctl, const uint8_t *data,
+			   uint8_t len, uint8_t uuid_len)
+{
+	uint8_t cnt = 0;
+
+	for (size_t i = 0; i < ref.uuid_cnt; i++) {
+		if (ref_uuid_find(data, len, uuid_len, ref.uuid[i])) {
+			ctl->status.uuid.uuid[cnt++] = ref.uuid[i];
+
+			if (!ctl->all_mode) {
+				break;
+			}
+		} else if (ctl->all_mode) {
+			break;
+		}
+	}
+
+	ctl->status.uuid.count = cnt;
+
+	return ctl->all_mode ? (cnt == ref.uuid_cnt) : (cnt > 0);
+}
+
+static void ref_field_check(struct ref_control *ctl, uint8_t type,
+			    const uint8_t *data, uint8_t len)
+{
+	struct bt_scan_filter_match *status = &ctl->status;
+
+	switch (type) {
+	case BT_DATA_NAME_COMPLETE:
+		if (!(ref.mode & BT_SCAN_NAME_FILTER) || status->name.match) {
+			break;
+		}
+
+		for (size_t i = 0; i < ref.name_cnt; i++) {
+			if (ref_name_cmp(ref.name[i], data, len, 0)) {
+				status->name.match = true;
+				status->name.name = ref.name[i];
+				status->name.len = len;
+				ctl->match_cnt++;
+				break;
+			}
+		}
+		break;
+
+	case BT_DATA_NAME_SHORTENED:
+		if (!(ref.mode & BT_SCAN_SHORT_NAME_FILTER) ||
+		    status->short_name.match) {
+			break;
+		}
+
+		for (size_t i = 0; i < ref.short_name_cnt; i++) {
+			if (ref_name_cmp(ref.short_name[i].name, data, len,
+					 ref.short_name[i].min_len)) {
+				status->short_name.match = true;
+				status->short_name.name = ref.short_name[i].name;
+				status->short_name.len = len;
+				ctl->match_cnt++;
+				break;
+			}
+		}
+		break;
+
+	case BT_DATA_GAP_APPEARANCE:
+		if (!(ref.mode & BT_SCAN_APPEARANCE_FILTER) ||
+		    status->appearance.match || (len != sizeof(uint16_t))) {
+			break;
+		}
+
+		for (size_t i = 0; i < ref.appearance_cnt; i++) {
+			if (sys_get_be16(data) == ref.appearance[i]) {
+				status->appearance.match = true;
+				status->appearance.appearance = &ref.appearance[i];
+				ctl->match_cnt++;
+				break;
+			}
+		}
+		break;
+
+	case BT_DATA_UUID16_SOME:
+	case BT_DATA_UUID16_ALL:
+	case BT_DATA_UUID32_SOME:
+	case BT_DATA_UUID32_ALL:
+	case BT_DATA_UUID128_SOME:
+	case BT_DATA_UUID128_ALL:
+		if (!(ref.mode & BT_SCAN_UUID_FILTER) || status->uuid.match) {
+			break;
+		}
+
+		if (ref_uuid_check(ctl, data, len,
+				   (type <= BT_DATA_UUID16_ALL) ? 2 :
+				   (type <= BT_DATA_UUID32_ALL) ? 4 : 16)) {
+			status->uuid.match = true;
+			ctl->match_cnt++;
+		}
+		break;
+
+	case BT_DATA_MANUFACTURER_DATA:
+		if (!(ref.mode & BT_SCAN_MANUFACTURER_DATA_FILTER) ||
+		    status->manufacturer_data.match) {
+			break;
+		}
+
+		for (size_t i = 0; i < ref.manufacturer_data_cnt; i++) {
+			const struct bt_scan_manufacturer_data *md =
+				&ref.manufacturer_data[i];
+
+			if ((md->data_len <= len) &&
+			    (memcmp(md->data, data, md->data_len) == 0)) {
+				status->manufacturer_data.match = true;
+				status->manufacturer_data.data = md->data;
+				status->manufacturer_data.len = md->data_len;
+				ctl->match_cnt++;
+				break;
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+static bool ref_match(const struct adv_report *report,
+		      struct bt_scan_filter_match *status)
+{
+	struct ref_control ctl = {
+		.all_mode = ref.all_mode,
+	};
+	const uint8_t *data = report->data;
+	size_t len = report->len;
+	uint8_t filter_cnt = 0;
+
+	for (uint8_t mode = ref.mode; mode; mode &= mode - 1) {
+		filter_cnt++;
+	}
+
+	if (ref.mode & BT_SCAN_ADDR_FILTER) {
+		for (size_t i = 0; i < ref.addr_cnt; i++) {
+			if (bt_addr_le_cmp(&report->addr, &ref.addr[i]) == 0) {
+				ctl.status.addr.match = true;
+				ctl.status.addr.addr = &ref.addr[i];
+				ctl.match_cnt++;
+				break;
+			}
+		}
+	}
+
+	while (len > 1) {
+		uint8_t field_len = data[0];
+
+		if ((field_len == 0) || (field_len > (len - 1))) {
+			break;
+		}
+
+		ref_field_check(&ctl, data[1], &data[2], field_len - 1);
+
+		data += field_len + 1;
+		len -= field_len + 1;
+	}
+
+	*status = ctl.status;
+
+	return ctl.all_mode ? (ctl.match_cnt == filter_cnt) : (ctl.match_cnt > 0);
+}
+
+static void status_check(const struct bt_scan_filter_match *status,
+			 const struct bt_scan_filter_match *expected,
+			 size_t report)
+{
+	zassert_equal(status->name.match, expected->name.match,
+		      "Name match differs for report %zu", report);
+	if (expected->name.match) {
+		zassert_equal(status->name.len, expected->name.len,
+			      "Name length differs for report %zu", report);
+		zassert_equal(strncmp(status->name.name, expected->name.name,
+				      CONFIG_BT_SCAN_NAME_MAX_LEN), 0,
+			      "Name differs for report %zu", report);
+	}
+
+	zassert_equal(status->short_name.match, expected->short_name.match,
+		      "Short name match differs for report %zu", report);
+	if (expected->short_name.match) {
+		zassert_equal(status->short_name.len, expected->short_name.len,
+			      "Short name length differs for report %zu", report);
+		zassert_equal(strncmp(status->short_name.name,
+				      expected->short_name.name,
+				      CONFIG_BT_SCAN_SHORT_NAME_MAX_LEN), 0,
+			      "Short name differs for report %zu", report);
+	}
+
+	zassert_equal(status->addr.match, expected->addr.match,
+		      "Address match differs for report %zu", report);
+	if (expected->addr.match) {
+		zassert_equal(bt_addr_le_cmp(status->addr.addr,
+					     expected->addr.addr), 0,
+			      "Address differs for report %zu", report);
+	}
+
+	zassert_equal(status->uuid.match, expected->uuid.match,
+		      "UUID match differs for report %zu", report);
+	if (expected->uuid.match) {
+		zassert_equal(status->uuid.count, expected->uuid.count,
+			      "UUID count differs for report %zu", report);
+		for (size_t i = 0; i < expected->uuid.count; i++) {
+			zassert_equal(bt_uuid_cmp(status->uuid.uuid[i],
+						  expected->uuid.uuid[i]), 0,
+				      "UUID differs for report %zu", report);
+		}
+	}
+
+	zassert_equal(status->appearance.match, expected->appearance.match,
+		      "Appearance match differs for report %zu", report);
+	if (expected->appearance.match) {
+		zassert_equal(*status->appearance.appearance,
+			      *expected->appearance.appearance,
+			      "Appearance differs for report %zu", report);
+	}
+
+	zassert_equal(status->manufacturer_data.match,
+		      expected->manufacturer_data.match,
+		      "Manufacturer data match differs for report %zu", report);
+	if (expected->manufacturer_data.match) {
+		zassert_equal(status->manufacturer_data.len,
+			      expected->manufacturer_data.len,
+			      "Manufacturer data length differs for report %zu",
+			      report);
+		zassert_mem_equal(status->manufacturer_data.data,
+				  expected->manufacturer_data.data,
+				  expected->manufacturer_data.len,
+				  "Manufacturer data differs for report %zu",
+				  report);
+	}
+}
+
+static uint8_t *field_add(struct adv_report *report, uint8_t type,
+			  uint8_t len)
+{
+	uint8_t *field;
+
+	if ((report->len + len + 2) > sizeof(report->data)) {
+		return NULL;
+	}
+
+	field = &report->data[report->len];
+	field[0] = len + 1;
+	field[1] = type;
+	report->len += len + 2;
+
+	return &field[2];
+}
+
+static void rand_fill(uint8_t *data, size_t len)
+{
+	for (size_t i = 0; i < len; i++) {
+		data[i] = rand_get();
+	}
+}
+
+static void name_field_add(struct adv_report *report, uint8_t type)
+{
+	const char *name = names[rand_range(ARRAY_SIZE(names))];
+	size_t len = strlen(name);
+	uint8_t *data;
+
+	/* Advertise the whole name, a part of it, or a mangled one. */
+	switch (rand_range(4)) {
+	case 0:
+		len = rand_range(len + 1);
+		break;
+
+	case 1:
+		len = MIN(len + 1, 31);
+		break;
+
+	default:
+		break;
+	}
+
+	data = field_add(report, type, len);
+	if (!data) {
+		return;
+	}
+
+	memcpy(data, name, MIN(len, strlen(name)));
+
+	if (len > strlen(name)) {
+		data[len - 1] = rand_range(2) ? '\0' : 'X';
+	} else if (len && !rand_range(8)) {
+		data[rand_range(len)] = rand_get();
+	}
+}
+
+static void uuid_field_add(struct adv_report *report)
+{
+	uint8_t cnt = 1 + rand_range(4);
+	uint8_t *data;
+
+	switch (rand_range(3)) {
+	case 0:
+		data = field_add(report, BT_DATA_UUID16_ALL, cnt * 2);
+		for (size_t i = 0; data && (i < cnt); i++) {
+			sys_put_le16(uuid16_pool[rand_range(ARRAY_SIZE(uuid16_pool))],
+				     &data[i * 2]);
+		}
+		break;
+
+	case 1:
+		data = field_add(report, BT_DATA_UUID32_SOME, 4);
+		if (data) {
+			sys_put_le32(uuid32_pool[rand_range(ARRAY_SIZE(uuid32_pool))],
+				     data);
+		}
+		break;
+
+	default:
+		data = field_add(report, BT_DATA_UUID128_ALL, 16);
+		if (data) {
+			memcpy(data, uuid128_pool[rand_range(ARRAY_SIZE(uuid128_pool))],
+			       16);
+		}
+		break;
+	}
+}
+
+static void appearance_field_add(struct adv_report *report)
+{
+	uint8_t len = rand_range(8) ? sizeof(uint16_t) : 3;
+	uint8_t *data = field_add(report, BT_DATA_GAP_APPEARANCE, len);
+
+	if (data) {
+		rand_fill(data, len);
+		sys_put_be16(appearance_pool[rand_range(ARRAY_SIZE(appearance_pool))],
+			     data);
+	}
+}
+
+static void manufacturer_data_field_add(struct adv_report *report)
+{
+	const uint8_t *prefix =
+		manufacturer_data_pool[rand_range(ARRAY_SIZE(manufacturer_data_pool))];
+	uint8_t len = 1 + rand_range(25);
+	uint8_t *data = field_add(report, BT_DATA_MANUFACTURER_DATA, len);
+
+	if (data) {
+		rand_fill(data, len);
+		memcpy(data, prefix, MIN(len, 4));
+	}
+}
+
+/* Generate advertising reports resembling a busy scan, with device names,
+ * service UUIDs, beacons and some malformed data.
+ */
+static void corpus_generate(void)
+{
+	uint8_t *data;
+
+	rand_state = CORPUS_SEED;
+
+	for (size_t i = 0; i < ARRAY_SIZE(corpus); i++) {
+		struct adv_report *report = &corpus[i];
+		uint8_t max_len = rand_range(4) ? 31 : ADV_MAX_LEN;
+		uint8_t fields = 1 + rand_range(5);
+
+		memset(report, 0, sizeof(*report));
+		addr_get(&report->addr, rand_range(16));
+
+		data = field_add(report, BT_DATA_FLAGS, 1);
+		*data = BT_LE_AD_GENERAL | BT_LE_AD_NO_BREDR;
+
+		while (fields--) {
+			switch (rand_range(8)) {
+			case 0:
+				name_field_add(report, BT_DATA_NAME_COMPLETE);
+				break;
+
+			case 1:
+				name_field_add(report, BT_DATA_NAME_SHORTENED);
+				break;
+
+			case 2:
+			case 3:
+				uuid_field_add(report);
+				break;
+
+			case 4:
+				appearance_field_add(report);
+				break;
+
+			case 5:
+				manufacturer_data_field_add(report);
+				break;
+
+			case 6:
+				data = field_add(report, BT_DATA_TX_POWER, 1);
+				if (data) {
+					*data = rand_get();
+				}
+				break;
+
+			default:
+				data = field_add(report, BT_DATA_SVC_DATA16,
+						 2 + rand_range(8));
+				if (data) {
+					rand_fill(data, data[-2] - 1);
+				}
+				break;
+			}
+		}
+
+		/* Legacy advertising data, or extended advertising data. */
+		if (report->len > max_len) {
+			report->len = max_len;
+		}
+
+		/* Malformed data: a length running past the end. */
+		if (!rand_range(16) && report->len) {
+			report->data[report->len - 1] = 0xff;
+		}
+	}
+}
+
+static void corpus_check(uint8_t mode, bool all_mode, size_t *matches)
+{
+	struct bt_scan_filter_match expected;
+
+	filters_enable(mode, all_mode);
+
+	*matches = 0;
+
+	for (size_t i = 0; i < ARRAY_SIZE(corpus); i++) {
+		bool match = scan_report(&corpus[i]);
+
+		zassert_equal(match, ref_match(&corpus[i], &expected),
+			      "Match differs for report %zu", i);
+
+		if (match) {
+			status_check(&result.status, &expected, i);
+			(*matches)++;
+		}
+	}
+}
+
+static void test_name_filter(void)
+{
+	struct adv_report report;
+
+	filters_reset();
+	name_filter_add("Nordic_HRS");
+	name_filter_add("Nordic_UART");
+	filters_enable(BT_SCAN_NAME_FILTER, false);
+
+	report_set(&report, 0, "\x0c\x09Nordic_UART", 13);
+	zassert_true(scan_report(&report), "Name not matched");
+	zassert_true(result.status.name.match, "Name not reported");
+	zassert_equal(strcmp(result.status.name.name, "Nordic_UART"), 0,
+		      "Wrong name reported");
+	zassert_equal(result.status.name.len, 11, "Wrong name length");
+
+	/* An advertised name matches the lowest filter it starts. */
+	report_set(&report, 0, "\x08\x09Nordic_", 9);
+	zassert_true(scan_report(&report), "Name prefix not matched");
+	zassert_equal(strcmp(result.status.name.name, "Nordic_HRS"), 0,
+		      "Wrong name reported");
+
+	report_set(&report, 0, "\x0c\x09Nordic_HRSX", 13);
+	zassert_false(scan_report(&report), "Longer name matched");
+
+	/* The name terminator ends the comparison. */
+	report_set(&report, 0, "\x0c\x09Nordic_HRS\0", 13);
+	zassert_true(scan_report(&report), "Terminated name not matched");
+	zassert_equal(strcmp(result.status.name.name, "Nordic_HRS"), 0,
+		      "Wrong name reported");
+
+	report_set(&report, 0, "\x08\x09Nordic\0", 9);
+	zassert_false(scan_report(&report), "Terminated prefix matched");
+
+	report_set(&report, 0, "\x07\x08Nordic", 8);
+	zassert_false(scan_report(&report), "Short name matched");
+}
+
+static void test_short_name_filter(void)
+{
+	struct adv_report report;
+
+	filters_reset();
+	short_name_filter_add("Nordic_Blinky", 10);
+	short_name_filter_add("Nordic_B", 3);
+	filters_enable(BT_SCAN_SHORT_NAME_FILTER, false);
+
+	report_set(&report, 0, "\x0d\x08Nordic_Blink", 14);
+	zassert_true(scan_report(&report), "Short name not matched");
+	zassert_equal(strcmp(result.status.short_name.name, "Nordic_Blinky"), 0,
+		      "Wrong short name reported");
+
+	/* Too short for the first filter, but long enough for the second. */
+	report_set(&report, 0, "\x09\x08Nordic_B", 10);
+	zassert_true(scan_report(&report), "Short name not matched");
+	zassert_equal(strcmp(result.status.short_name.name, "Nordic_B"), 0,
+		      "Wrong short name reported");
+	zassert_equal(result.status.short_name.len, 8, "Wrong short name length");
+
+	report_set(&report, 0, "\x03\x08No", 4);
+	zassert_false(scan_report(&report), "Too short name matched");
+}
+
+static void test_addr_filter(void)
+{
+	struct adv_report report;
+	bt_addr_le_t addr;
+
+	filters_reset();
+	for (uint8_t i = 0; i < CONFIG_BT_SCAN_ADDRESS_CNT; i++) {
+		addr_filter_add(i * 2);
+	}
+	name_filter_add("Thingy");
+	filters_enable(BT_SCAN_ADDR_FILTER, false);
+
+	for (uint8_t i = 0; i < CONFIG_BT_SCAN_ADDRESS_CNT * 2; i++) {
+		report_set(&report, i, "\x07\x09Thingy", 8);
+		zassert_equal(scan_report(&report), !(i & 1),
+			      "Wrong address match for %u", i);
+		if (!(i & 1)) {
+			addr_get(&addr, i);
+			zassert_equal(bt_addr_le_cmp(result.status.addr.addr,
+						     &addr), 0,
+				      "Wrong address reported");
+		}
+	}
+
+	/* Without the address, the advertising data cannot make a match. */
+	filters_enable(BT_SCAN_ADDR_FILTER | BT_SCAN_NAME_FILTER, true);
+
+	report_set(&report, 1, "\x07\x09Thingy", 8);
+	zassert_false(scan_report(&report), "Filtered out address matched");
+
+	report_set(&report, 2, "\x07\x09Thingy", 8);
+	zassert_true(scan_report(&report), "Address and name not matched");
+}
+
+static void test_uuid_filter(void)
+{
+	const uint8_t hrs_128[] = { 0x11, BT_DATA_UUID128_SOME,
+				    BASE_UUID(0x180d) };
+	const uint8_t uuid_list[] = { 0x05, BT_DATA_UUID16_ALL,
+				      0x12, 0x18, 0x0d, 0x18 };
+	struct adv_report report;
+
+	filters_reset();
+	uuid_filter_add(&hrs_uuid.uuid);
+	uuid_filter_add(&bas_uuid.uuid);
+	uuid_filter_add(&hids_uuid.uuid);
+	filters_enable(BT_SCAN_UUID_FILTER, false);
+
+	/* UUIDs match in every representation. */
+	report_set(&report, 0, hrs_128, sizeof(hrs_128));
+	zassert_true(scan_report(&report), "128-bit UUID not matched");
+	zassert_equal(result.status.uuid.count, 1, "Wrong UUID count");
+	zassert_equal(bt_uuid_cmp(result.status.uuid.uuid[0], BT_UUID_HRS), 0,
+		      "Wrong UUID reported");
+
+	report_set(&report, 0, "\x03\x02\x0f\x18", 4);
+	zassert_true(scan_report(&report), "16-bit UUID not matched");
+	zassert_equal(bt_uuid_cmp(result.status.uuid.uuid[0], &bas_uuid.uuid),
+		      0, "Wrong UUID reported");
+
+	report_set(&report, 0, "\x05\x04\x12\x18\x00\x00", 6);
+	zassert_true(scan_report(&report), "32-bit UUID not matched");
+	zassert_equal(bt_uuid_cmp(result.status.uuid.uuid[0], BT_UUID_HIDS), 0,
+		      "Wrong UUID reported");
+
+	report_set(&report, 0, "\x03\x02\x10\x18", 4);
+	zassert_false(scan_report(&report), "Wrong UUID matched");
+
+	/* The lowest filter found is reported. */
+	report_set(&report, 0, uuid_list, sizeof(uuid_list));
+	zassert_true(scan_report(&report), "UUID list not matched");
+	zassert_equal(result.status.uuid.count, 1, "Wrong UUID count");
+	zassert_equal(bt_uuid_cmp(result.status.uuid.uuid[0], BT_UUID_HRS), 0,
+		      "Wrong UUID reported");
+}
+
+static void test_uuid_filter_all_mode(void)
+{
+	const uint8_t partial[] = { 0x05, BT_DATA_UUID16_ALL,
+				    0x12, 0x18, 0x0d, 0x18 };
+	const uint8_t all[] = { 0x09, BT_DATA_UUID16_ALL,
+				0x12, 0x18, 0x0f, 0x18, 0x00, 0x18, 0x0d, 0x18 };
+	struct adv_report report;
+
+	filters_reset();
+	uuid_filter_add(&hrs_uuid.uuid);
+	uuid_filter_add(&bas_uuid.uuid);
+	uuid_filter_add(&hids_uuid.uuid);
+	filters_enable(BT_SCAN_UUID_FILTER, true);
+
+	report_set(&report, 0, partial, sizeof(partial));
+	zassert_false(scan_report(&report), "Partial UUID list matched");
+
+	report_set(&report, 0, all, sizeof(all));
+	zassert_true(scan_report(&report), "UUID list not matched");
+	zassert_equal(result.status.uuid.count, 3, "Wrong UUID count");
+	for (size_t i = 0; i < ref.uuid_cnt; i++) {
+		zassert_equal(bt_uuid_cmp(result.status.uuid.uuid[i],
+					  ref.uuid[i]), 0,
+			      "Wrong UUID reported");
+	}
+}
+
+static void test_appearance_filter(void)
+{
+	struct adv_report report;
+
+	filters_reset();
+	appearance_filter_add(0x03c1);
+	appearance_filter_add(0x0941);
+	filters_enable(BT_SCAN_APPEARANCE_FILTER, false);
+
+	report_set(&report, 0, "\x03\x19\x09\x41", 4);
+	zassert_true(scan_report(&report), "Appearance not matched");
+	zassert_equal(*result.status.appearance.appearance, 0x0941,
+		      "Wrong appearance reported");
+
+	report_set(&report, 0, "\x03\x19\x03\xc2", 4);
+	zassert_false(scan_report(&report), "Wrong appearance matched");
+
+	report_set(&report, 0, "\x04\x19\x03\xc1\x00", 5);
+	zassert_false(scan_report(&report), "Invalid appearance matched");
+}
+
+static void test_manufacturer_data_filter(void)
+{
+	struct adv_report report;
+
+	filters_reset();
+	manufacturer_data_filter_add(md_nordic_ext, sizeof(md_nordic_ext));
+	manufacturer_data_filter_add(md_nordic, sizeof(md_nordic));
+	manufacturer_data_filter_add(md_ibeacon, sizeof(md_ibeacon));
+	filters_enable(BT_SCAN_MANUFACTURER_DATA_FILTER, false);
+
+	/* The lowest filter that is a prefix of the data is reported. */
+	report_set(&report, 0, "\x06\xff\x59\x00\xbf\x0a\x01", 7);
+	zassert_true(scan_report(&report), "Manufacturer data not matched");
+	zassert_equal(result.status.manufacturer_data.len, sizeof(md_nordic_ext),
+		      "Wrong manufacturer data reported");
+
+	report_set(&report, 0, "\x04\xff\x59\x00\x01", 5);
+	zassert_true(scan_report(&report), "Manufacturer data not matched");
+	zassert_equal(result.status.manufacturer_data.len, sizeof(md_nordic),
+		      "Wrong manufacturer data reported");
+
+	report_set(&report, 0, "\x05\xff\x4c\x00\x02\x15", 6);
+	zassert_true(scan_report(&report), "Manufacturer data not matched");
+	zassert_equal(result.status.manufacturer_data.len, sizeof(md_ibeacon),
+		      "Wrong manufacturer data reported");
+
+	report_set(&report, 0, "\x02\xff\x59", 3);
+	zassert_false(scan_report(&report), "Short manufacturer data matched");
+
+	report_set(&report, 0, "\x04\xff\x4c\x00\x02", 5);
+	zassert_false(scan_report(&report), "Short manufacturer data matched");
+}
+
+static void test_match_counted_once(void)
+{
+	const uint8_t names_only[] = { 0x07, BT_DATA_NAME_COMPLETE, 'T', 'h',
+				       'i', 'n', 'g', 'y', 0x07,
+				       BT_DATA_NAME_COMPLETE, 'T', 'h', 'i',
+				       'n', 'g', 'y' };
+	const uint8_t name_uuid[] = { 0x07, BT_DATA_NAME_COMPLETE, 'T', 'h',
+				      'i', 'n', 'g', 'y', 0x03,
+				      BT_DATA_UUID16_SOME, 0x0d, 0x18 };
+	struct adv_report report;
+
+	filters_reset();
+	name_filter_add("Thingy");
+	uuid_filter_add(&hrs_uuid.uuid);
+	filters_enable(BT_SCAN_NAME_FILTER | BT_SCAN_UUID_FILTER, true);
+
+	/* Two matching names do not make up for the missing UUID. */
+	report_set(&report, 0, names_only, sizeof(names_only));
+	zassert_false(scan_report(&report), "Repeated name matched");
+
+	report_set(&report, 0, name_uuid, sizeof(name_uuid));
+	zassert_true(scan_report(&report), "Name and UUID not matched");
+}
+
+static void test_malformed_data(void)
+{
+	struct adv_report report;
+
+	filters_reset();
+	name_filter_add("Thingy");
+	filters_enable(BT_SCAN_NAME_FILTER, false);
+
+	report_set(&report, 0, "\x08\x09Thingy", 8);
+	zassert_false(scan_report(&report), "Truncated name matched");
+
+	report_set(&report, 0, "\x00\x07\x09Thingy", 9);
+	zassert_false(scan_report(&report), "Name after terminator matched");
+
+	report_set(&report, 0, "\x07\x09Thingy\x05\x01", 10);
+	zassert_true(scan_report(&report), "Name before bad field not matched");
+}
+
+static void test_filter_remove_all(void)
+{
+	struct bt_filter_status status;
+	struct adv_report report;
+
+	filters_reset();
+	name_filter_add("Nordic_Blinky");
+	uuid_filter_add(&hrs_uuid.uuid);
+
+	filters_reset();
+	name_filter_add("Nordic");
+	filters_enable(BT_SCAN_NAME_FILTER | BT_SCAN_UUID_FILTER, false);
+
+	zassert_equal(bt_scan_filter_status_get(&status), 0,
+		      "Cannot get filter status");
+	zassert_equal(status.name.cnt, 1, "Wrong name filter count");
+	zassert_equal(status.uuid.cnt, 0, "Wrong UUID filter count");
+
+	report_set(&report, 0, "\x09\x09Nordic_B", 10);
+	zassert_false(scan_report(&report), "Removed name matched");
+
+	report_set(&report, 0, "\x03\x02\x0d\x18", 4);
+	zassert_false(scan_report(&report), "Removed UUID matched");
+
+	report_set(&report, 0, "\x07\x09Nordic", 8);
+	zassert_true(scan_report(&report), "Name not matched");
+	zassert_equal(strncmp(result.status.name.name, "Nordic",
+			      CONFIG_BT_SCAN_NAME_MAX_LEN), 0,
+		      "Wrong name reported");
+}
+
+static void test_corpus(void)
+{
+	static const struct {
+		uint8_t mode;
+		bool all_mode;
+	} configs[] = {
+		{ BT_SCAN_ALL_FILTER, false },
+		{ BT_SCAN_ALL_FILTER, true },
+		{ BT_SCAN_NAME_FILTER | BT_SCAN_UUID_FILTER, true },
+		{ BT_SCAN_UUID_FILTER | BT_SCAN_MANUFACTURER_DATA_FILTER, true },
+		{ BT_SCAN_ADDR_FILTER | BT_SCAN_MANUFACTURER_DATA_FILTER, true },
+		{ BT_SCAN_SHORT_NAME_FILTER | BT_SCAN_APPEARANCE_FILTER, false },
+		{ BT_SCAN_UUID_FILTER, false },
+	};
+	size_t matches;
+
+	filters_reset();
+	filters_add_all();
+
+	for (size_t i = 0; i < ARRAY_SIZE(configs); i++) {
+		corpus_check(configs[i].mode, configs[i].all_mode, &matches);
+
+		TC_PRINT("Filters 0x%02x%s: %zu of %zu reports matched\n",
+			 configs[i].mode, configs[i].all_mode ? " (all)" : "",
+			 matches, ARRAY_SIZE(corpus));
+
+		if (i == 0) {
+			zassert_true((matches > 0) && (matches < ARRAY_SIZE(corpus)),
+				     "Corpus does not exercise the filters");
+		}
+	}
+}
+
+static void test_corpus_benchmark(void)
+{
+	struct bt_scan_filter_match status;
+	uint32_t scan_cycles;
+	uint32_t ref_cycles;
+	uint32_t start;
+	size_t matches = 0;
+
+	filters_reset();
+	filters_add_all();
+	filters_enable(BT_SCAN_ALL_FILTER, false);
+
+	start = k_cycle_get_32();
+
+	for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+		for (size_t i = 0; i < ARRAY_SIZE(corpus); i++) {
+			matches += scan_report(&corpus[i]);
+		}
+	}
+
+	scan_cycles = k_cycle_get_32() - start;
+	start = k_cycle_get_32();
+
+	for (size_t round = 0; round < BENCH_ROUNDS; round++) {
+		for (size_t i = 0; i < ARRAY_SIZE(corpus); i++) {
+			matches -= ref_match(&corpus[i], &status);
+		}
+	}
+
+	ref_cycles = k_cycle_get_32() - start;
+
+	zassert_equal(matches, 0, "Match count differs");
+
+	TC_PRINT("%zu reports, %u rounds:\n", ARRAY_SIZE(corpus), BENCH_ROUNDS);
+	TC_PRINT("  compiled filters: %u cycles\n", scan_cycles);
+	TC_PRINT("  linear filters:   %u cycles\n", ref_cycles);
+}
+
+void test_main(void)
+{
+	bt_scan_init(NULL);
+	bt_scan_cb_register(&scan_cb_data);
+	corpus_generate();
+
+	ztest_test_suite(bt_scan_filter_test,
+			 ztest_unit_test(test_name_filter),
+			 ztest_unit_test(test_short_name_filter),
+			 ztest_unit_test(test_addr_filter),
+			 ztest_unit_test(test_uuid_filter),
+			 ztest_unit_test(test_uuid_filter_all_mode),
+			 ztest_unit_test(test_appearance_filter),
+			 ztest_unit_test(test_manufacturer_data_filter),
+			 ztest_unit_test(test_match_counted_once),
+			 ztest_unit_test(test_malformed_data),
+			 ztest_unit_test(test_filter_remove_all),
+			 ztest_unit_test(test_corpus),
+			 ztest_unit_test(test_corpus_benchmark)
+			 );
+
+	ztest_run_test_suite(bt_scan_filter_test);
+}
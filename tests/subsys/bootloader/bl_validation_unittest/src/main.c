@@ -30,11 +30,93 @@ void test_region_within(void)
 	zassert_false(region_within(0xFFFF, 0x20000, 0x10000, 0x100000), NULL);
 }
 
+static void record_init(struct bl_validation_record *record)
+{
+	record->address = 0x10000;
+	record->version = 5;
+	record->key_idx = 1;
+	for (size_t i = 0; i < sizeof(record->hash); i++) {
+		record->hash[i] = i;
+	}
+	record->valid = BL_VALIDATION_RECORD_VALID;
+}
+
+void test_validation_record_matches(void)
+{
+	struct bl_validation_record record;
+	uint8_t hash[BL_VALIDATION_RECORD_HASH_LEN];
+
+	record_init(&record);
+	memcpy(hash, record.hash, sizeof(hash));
+
+	/* Warm boot of the recorded firmware. */
+	zassert_true(validation_record_matches(&record, 0x10000, 5, hash), NULL);
+
+	/* Firmware updated in place, a new version must be fully validated. */
+	zassert_false(validation_record_matches(&record, 0x10000, 6, hash), NULL);
+	zassert_false(validation_record_matches(&record, 0x10000, 4, hash), NULL);
+
+	/* Recorded firmware is in the other slot. */
+	zassert_false(validation_record_matches(&record, 0x20000, 5, hash), NULL);
+
+	/* Firmware content differs from the recorded one. */
+	hash[0] ^= 0x01;
+	zassert_false(validation_record_matches(&record, 0x10000, 5, hash), NULL);
+	hash[0] ^= 0x01;
+	hash[BL_VALIDATION_RECORD_HASH_LEN - 1] ^= 0x80;
+	zassert_false(validation_record_matches(&record, 0x10000, 5, hash), NULL);
+}
+
+void test_validation_record_incomplete(void)
+{
+	struct bl_validation_record record;
+	uint8_t hash[BL_VALIDATION_RECORD_HASH_LEN];
+
+	record_init(&record);
+	memcpy(hash, record.hash, sizeof(hash));
+
+	/* Writing the record was interrupted before it was marked as valid. */
+	record.valid = 0xFFFFFFFF;
+	zassert_false(validation_record_matches(&record, 0x10000, 5, hash), NULL);
+
+	record.valid = 0;
+	zassert_false(validation_record_matches(&record, 0x10000, 5, hash), NULL);
+
+	/* Empty slot. */
+	memset(&record, 0xFF, sizeof(record));
+	memset(hash, 0xFF, sizeof(hash));
+	zassert_false(validation_record_matches(&record, 0xFFFFFFFF, 0xFFFFFFFF, hash), NULL);
+}
+
+void test_validation_record_forged(void)
+{
+	struct bl_validation_record record;
+	struct bl_validation_record fw_record;
+
+	/* Record written by the booted firmware for the firmware it installed. */
+	record_init(&record);
+	record_init(&fw_record);
+
+	/* Bootloader storage kept in OTP, the signature must be verified. */
+	zassert_false(validation_record_trusted(&record, &fw_record, false), NULL);
+
+	/* Bootloader storage protected before boot, so the bootloader wrote it. */
+	zassert_true(validation_record_trusted(&record, &fw_record, true), NULL);
+
+	/* Record forged for a different firmware. */
+	fw_record.hash[0] ^= 0x01;
+	zassert_false(validation_record_trusted(&record, &fw_record, true), NULL);
+	zassert_false(validation_record_trusted(&record, &fw_record, false), NULL);
+}
+
 void test_main(void)
 {
 	ztest_test_suite(test_bl_validation_unittest,
 			 ztest_unit_test(test_within),
-			 ztest_unit_test(test_region_within)
+			 ztest_unit_test(test_region_within),
+			 ztest_unit_test(test_validation_record_matches),
+			 ztest_unit_test(test_validation_record_incomplete),
+			 ztest_unit_test(test_validation_record_forged)
 	);
 	ztest_run_test_suite(test_bl_validation_unittest);
 }
@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <dfu/dfu_multi_image.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <ztest.h>
+
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define PAGE_SIZE 4096
+#define IMAGE_SIZE (8 * PAGE_SIZE)
+#define IMAGE_COUNT 2
+
+/* Package header: fixed header followed by the CBOR map with two image entries */
+#define IMAGE_INFO_SIZE 15
+#define CBOR_HEADER_SIZE (6 + IMAGE_COUNT * IMAGE_INFO_SIZE)
+#define HEADER_SIZE (sizeof(uint16_t) + CBOR_HEADER_SIZE)
+#define PACKAGE_SIZE (HEADER_SIZE + IMAGE_COUNT * IMAGE_SIZE)
+
+/* Package is received in 1 kB chunks at about 128 kB/s */
+#define DOWNLOAD_CHUNK_SIZE 1024
+#define DOWNLOAD_CHUNK_TIME_US 8000
+
+/*
+ * Simulated flash device. Pages are erased when the first byte is written to them, like
+ * the stream flash does, and the device busy time is simulated with sleeps.
+ */
+struct sim_flash {
+	const char *name;
+	uint32_t erase_time_us;
+	uint32_t write_time_us_per_kb;
+	size_t fail_at;
+
+	uint8_t mem[IMAGE_SIZE];
+	size_t offset;
+	size_t erased_pages;
+	bool open;
+	bool closed;
+	bool close_success;
+	bool misuse;
+};
+
+static struct sim_flash flashes[IMAGE_COUNT] = {
+	/* Internal flash: 85 ms page erase, 41 us per 32-bit word write */
+	{ .name = "internal", .erase_time_us = 85000, .write_time_us_per_kb = 10500 },
+	/* External QSPI flash: 45 ms sector erase, 0.85 ms per 256-byte page program */
+	{ .name = "external", .erase_time_us = 45000, .write_time_us_per_kb = 3400 },
+};
+
+static uint8_t package[PACKAGE_SIZE];
+
+static uint8_t image_byte(size_t image_no, size_t offset)
+{
+	return (uint8_t)(offset * 7 + (offset >> 8) + image_no * 13);
+}
+
+static int sim_flash_open(struct sim_flash *flash, int image_id, size_t image_size)
+{
+	if (flash->open || image_size != IMAGE_SIZE) {
+		flash->misuse = true;
+		return -EINVAL;
+	}
+
+	flash->open = true;
+	flash->offset = 0;
+	flash->erased_pages = 0;
+
+	return 0;
+}
+
+static int sim_flash_write(struct sim_flash *flash, const uint8_t *chunk, size_t chunk_size)
+{
+	if (!flash->open || flash->offset + chunk_size > IMAGE_SIZE) {
+		flash->misuse = true;
+		return -EINVAL;
+	}
+
+	if (flash->fail_at && flash->offset + chunk_size > flash->fail_at) {
+		return -EIO;
+	}
+
+	while (flash->erased_pages * PAGE_SIZE < flash->offset + chunk_size) {
+		k_usleep(flash->erase_time_us);
+		flash->erased_pages++;
+	}
+
+	k_usleep(chunk_size * flash->write_time_us_per_kb / 1024);
+	memcpy(&flash->mem[flash->offset], chunk, chunk_size);
+	flash->offset += chunk_size;
+
+	return 0;
+}
+
+static int sim_flash_close(struct sim_flash *flash, bool success)
+{
+	if (!flash->open) {
+		flash->misuse = true;
+		return -EINVAL;
+	}
+
+	flash->open = false;
+	flash->closed = true;
+	flash->close_success = success;
+
+	return 0;
+}
+
+#define SIM_FLASH_WRITER_FUNCTIONS(n)                                                              \
+	static int sim_flash_open_##n(int image_id, size_t image_size)                            \
+	{                                                                                          \
+		return sim_flash_open(&flashes[n], image_id, image_size);                         \
+	}                                                                                          \
+	static int sim_flash_write_##n(const uint8_t *chunk, size_t chunk_size)                   \
+	{                                                                                          \
+		return sim_flash_write(&flashes[n], chunk, chunk_size);                           \
+	}                                                                                          \
+	static int sim_flash_close_##n(bool success)                                              \
+	{                                                                                          \
+		return sim_flash_close(&flashes[n], success);                                     \
+	}
+
+SIM_FLASH_WRITER_FUNCTIONS(0)
+SIM_FLASH_WRITER_FUNCTIONS(1)
+
+static const struct dfu_image_writer sim_flash_writers[IMAGE_COUNT] = {
+	{ .image_id = 0, .open = sim_flash_open_0, .write = sim_flash_write_0,
+	  .close = sim_flash_close_0 },
+	{ .image_id = 1, .open = sim_flash_open_1, .write = sim_flash_write_1,
+	  .close = sim_flash_close_1 },
+};
+
+static void build_package(void)
+{
+	uint8_t *p = package;
+
+	sys_put_le16(CBOR_HEADER_SIZE, p);
+	p += sizeof(uint16_t);
+
+	/* {"img": [{"id": n, "size": IMAGE_SIZE}, ...]} */
+	*p++ = 0xa1;
+	*p++ = 0x63;
+	memcpy(p, "img", 3);
+	p += 3;
+	*p++ = 0x80 | IMAGE_COUNT;
+
+	for (size_t i = 0; i < IMAGE_COUNT; i++) {
+		*p++ = 0xa2;
+		*p++ = 0x62;
+		memcpy(p, "id", 2);
+		p += 2;
+		*p++ = (uint8_t)i;
+		*p++ = 0x64;
+		memcpy(p, "size", 4);
+		p += 4;
+		*p++ = 0x1a;
+		sys_put_be32(IMAGE_SIZE, p);
+		p += sizeof(uint32_t);
+	}
+
+	zassert_equal(p - package, HEADER_SIZE, "Invalid package header size");
+
+	for (size_t i = 0; i < IMAGE_COUNT; i++) {
+		for (size_t j = 0; j < IMAGE_SIZE; j++) {
+			*p++ = image_byte(i, j);
+		}
+	}
+}
+
+static void reset_flashes(void)
+{
+	for (size_t i = 0; i < IMAGE_COUNT; i++) {
+		struct sim_flash *flash = &flashes[i];
+
+		memset(flash->mem, 0xff, sizeof(flash->mem));
+		flash->offset = 0;
+		flash->erased_pages = 0;
+		flash->open = false;
+		flash->closed = false;
+		flash->close_success = false;
+		flash->misuse = false;
+		flash->fail_at = 0;
+	}
+}
+
+/* Time that writing an image takes on the simulated flash device, in milliseconds */
+static uint32_t sim_flash_time_ms(const struct sim_flash *flash)
+{
+	return ((IMAGE_SIZE / PAGE_SIZE) * flash->erase_time_us +
+		(IMAGE_SIZE / 1024) * flash->write_time_us_per_kb) / 1000;
+}
+
+/*
+ * Download the package in chunks, simulating the transfer time, and return the result
+ * of the DFU Multi Image library.
+ */
+static int download(const uint8_t *lanes, int64_t *elapsed_ms)
+{
+	static uint8_t buffer[64];
+	int64_t start = k_uptime_get();
+	int err;
+
+	reset_flashes();
+
+	err = dfu_multi_image_init(buffer, sizeof(buffer));
+	zassert_ok(err, "Unexpected failure: %d", err);
+
+	for (size_t i = 0; i < IMAGE_COUNT; i++) {
+		struct dfu_image_writer writer = sim_flash_writers[i];
+
+		writer.lane = lanes[i];
+		err = dfu_multi_image_register_writer(&writer);
+		zassert_ok(err, "Unexpected failure: %d", err);
+	}
+
+	for (size_t i = 0; i < PACKAGE_SIZE; i += DOWNLOAD_CHUNK_SIZE) {
+		k_usleep(DOWNLOAD_CHUNK_TIME_US);
+
+		err = dfu_multi_image_write(i, &package[i], MIN(DOWNLOAD_CHUNK_SIZE,
+								PACKAGE_SIZE - i));
+		if (err) {
+			return err;
+		}
+	}
+
+	err = dfu_multi_image_done(true);
+	*elapsed_ms = k_uptime_get() - start;
+
+	return err;
+}
+
+static void verify_flashes(void)
+{
+	for (size_t i = 0; i < IMAGE_COUNT; i++) {
+		const struct sim_flash *flash = &flashes[i];
+
+		zassert_false(flash->misuse, "Writer of %s flash misused", flash->name);
+		zassert_true(flash->closed && flash->close_success, "Image %zu not closed", i);
+		zassert_equal(flash->offset, IMAGE_SIZE, "Image %zu not fully written", i);
+
+		for (size_t j = 0; j < IMAGE_SIZE; j++) {
+			zassert_equal(flash->mem[j], image_byte(i, j), "Invalid image %zu content",
+				      i);
+		}
+	}
+}
+
+static void test_done_without_init(void)
+{
+	int err;
+
+	/* DFU can be aborted before it is started, for example by zigbee_fota_abort() */
+	err = dfu_multi_image_done(false);
+	zassert_ok(err, "Unexpected failure: %d", err);
+}
+
+static void test_two_flash_devices(void)
+{
+	static const uint8_t lanes[IMAGE_COUNT] = { 0, 1 };
+	uint32_t sequential_ms = (PACKAGE_SIZE / DOWNLOAD_CHUNK_SIZE) * DOWNLOAD_CHUNK_TIME_US /
+				 1000;
+	int64_t elapsed_ms;
+	int err;
+
+	for (size_t i = 0; i < IMAGE_COUNT; i++) {
+		sequential_ms += sim_flash_time_ms(&flashes[i]);
+	}
+
+	err = download(lanes, &elapsed_ms);
+	zassert_ok(err, "DFU failed: %d", err);
+	verify_flashes();
+
+	TC_PRINT("Total DFU time: %lld ms (download and writes without overlap: %u ms)\n",
+		 elapsed_ms, sequential_ms);
+
+	if (IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		zassert_true(elapsed_ms < sequential_ms, "Download and writes do not overlap");
+	}
+}
+
+static void test_shared_lane(void)
+{
+	static const uint8_t lanes[IMAGE_COUNT] = { 0, 0 };
+	int64_t elapsed_ms;
+	int err;
+
+	if (!IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		ztest_test_skip();
+	}
+
+	/* Images on one lane are written one after another */
+	err = download(lanes, &elapsed_ms);
+	zassert_ok(err, "DFU failed: %d", err);
+	verify_flashes();
+
+	TC_PRINT("Total DFU time with a single writer thread: %lld ms\n", elapsed_ms);
+}
+
+static void test_write_error(void)
+{
+	static const uint8_t lanes[IMAGE_COUNT] = { 0, 1 };
+	static uint8_t buffer[64];
+	int err;
+
+	if (!IS_ENABLED(CONFIG_DFU_MULTI_IMAGE_PIPELINE)) {
+		ztest_test_skip();
+	}
+
+	reset_flashes();
+	flashes[0].fail_at = IMAGE_SIZE / 2;
+
+	err = dfu_multi_image_init(buffer, sizeof(buffer));
+	zassert_ok(err, "Unexpected failure: %d", err);
+
+	for (size_t i = 0; i < IMAGE_COUNT; i++) {
+		struct dfu_image_writer writer = sim_flash_writers[i];
+
+		writer.lane = lanes[i];
+		err = dfu_multi_image_register_writer(&writer);
+		zassert_ok(err, "Unexpected failure: %d", err);
+	}
+
+	/* The error of the writer thread is returned by a subsequent write or by done */
+	for (size_t i = 0; i < PACKAGE_SIZE && !err; i += DOWNLOAD_CHUNK_SIZE) {
+		err = dfu_multi_image_write(i, &package[i], MIN(DOWNLOAD_CHUNK_SIZE,
+								PACKAGE_SIZE - i));
+	}
+
+	if (!err) {
+		err = dfu_multi_image_done(true);
+		zassert_equal(err, -EIO, "Unexpected result: %d", err);
+	} else {
+		zassert_equal(err, -EIO, "Unexpected result: %d", err);
+		err = dfu_multi_image_done(false);
+		zassert_equal(err, -EIO, "Unexpected result: %d", err);
+	}
+
+	/* Failed image is closed with failure, the other one is not completed */
+	zassert_false(flashes[0].misuse, "Writer misused");
+	zassert_true(flashes[0].closed && !flashes[0].close_success, "Image not closed");
+	zassert_false(flashes[1].misuse, "Writer misused");
+	zassert_false(flashes[1].open, "Image not closed");
+	zassert_false(flashes[1].closed && flashes[1].close_success, "Image completed");
+}
+
+#ifdef CONFIG_DFU_MULTI_IMAGE_PIPELINE
+static void test_invalid_lane(void)
+{
+	static uint8_t buffer[64];
+	struct dfu_image_writer writer = sim_flash_writers[0];
+	int err;
+
+	err = dfu_multi_image_init(buffer, sizeof(buffer));
+	zassert_ok(err, "Unexpected failure: %d", err);
+
+	writer.lane = CONFIG_DFU_MULTI_IMAGE_PIPELINE_LANES;
+	err = dfu_multi_image_register_writer(&writer);
+	zassert_equal(err, -EINVAL, "Unexpected result: %d", err);
+}
+#else
+
+static void test_invalid_lane(void)
+{
+	ztest_test_skip();
+}
+
+#endif
+
+void test_main(void)
+{
+	build_package();
+
+	ztest_test_suite(dfu_multi_image_pipeline_test,
+			 ztest_unit_test(test_done_without_init),
+			 ztest_unit_test(test_two_flash_devices),
+			 ztest_unit_test(test_shared_lane),
+			 ztest_unit_test(test_write_error),
+			 ztest_unit_test(test_invalid_lane));
+	ztest_run_test_suite(dfu_multi_image_pipeline_test);
+}
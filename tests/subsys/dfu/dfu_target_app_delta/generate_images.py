@@ -0,0 +1,41 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Nordic Semiconductor ASA
+#
+# SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+
+"""
+Generate a pair of test images resembling two versions of an application:
+the new image has relocated addresses, new code inserted and old code removed.
+"""
+
+import random
+import sys
+
+
+def main():
+    rng = random.Random(2022)
+
+    source = bytearray()
+    for _ in range(48 * 1024 // 4):
+        source += rng.randrange(1 << 32).to_bytes(4, 'little')
+
+    target = bytearray(source)
+
+    # Relocate one address in every 64 bytes
+    for offset in range(0, len(target), 64):
+        address = int.from_bytes(target[offset:offset + 4], 'little')
+        target[offset:offset + 4] = ((address + 0x400) & 0xffffffff).to_bytes(4, 'little')
+
+    # Insert new code and remove old code
+    target[10000:10000] = bytes(rng.randrange(256) for _ in range(1500))
+    del target[30000:31000]
+
+    with open(sys.argv[1], 'wb') as file:
+        file.write(source)
+    with open(sys.argv[2], 'wb') as file:
+        file.write(target)
+
+
+if __name__ == "__main__":
+    main()
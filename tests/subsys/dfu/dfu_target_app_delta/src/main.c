@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/flash.h>
+#include <zephyr/sys/util.h>
+#include <dfu/dfu_target_stream.h>
+#include <ztest.h>
+
+#include <string.h>
+
+#include "dfu_target_app_delta_patch.h"
+
+#define PAGE_SIZE 4096
+#define SOURCE_BASE (256 * 1024)
+#define TARGET_BASE (384 * 1024)
+#define TARGET_AREA_SIZE (128 * 1024)
+
+static const uint8_t source_image[] = {
+#include "source.inc"
+};
+
+static const uint8_t target_image[] = {
+#include "target.inc"
+};
+
+static const uint8_t patch_data[] = {
+#include "patch.inc"
+};
+
+static const struct device *fdev = DEVICE_DT_GET(DT_CHOSEN(zephyr_flash_controller));
+static uint8_t stream_buf[PAGE_SIZE];
+static uint8_t patch_buf[512];
+static uint8_t read_buf[PAGE_SIZE];
+static uint8_t patch_copy[sizeof(patch_data) + 1];
+static struct app_delta_patch patch;
+static bool target_opened;
+
+static int source_read(size_t offset, uint8_t *buf, size_t len)
+{
+	return flash_read(fdev, SOURCE_BASE + offset, buf, len);
+}
+
+static int target_open(size_t target_size)
+{
+	int err;
+
+	err = dfu_target_stream_init(&(struct dfu_target_stream_init){
+		.id = "app_delta", .fdev = fdev, .buf = stream_buf, .len = sizeof(stream_buf),
+		.offset = TARGET_BASE, .size = TARGET_AREA_SIZE });
+	target_opened = (err == 0);
+
+	return err;
+}
+
+static int target_write(const uint8_t *buf, size_t len)
+{
+	return dfu_target_stream_write(buf, len);
+}
+
+static const struct app_delta_patch_cb patch_cb = {
+	.source_read = source_read,
+	.target_open = target_open,
+	.target_write = target_write,
+};
+
+static int apply_patch(const uint8_t *data, size_t len, size_t chunk_size)
+{
+	int err;
+
+	err = app_delta_patch_init(&patch, &patch_cb, patch_buf, sizeof(patch_buf));
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	for (size_t offset = 0; offset < len && !err; offset += chunk_size) {
+		err = app_delta_patch_write(&patch, &data[offset], MIN(chunk_size, len - offset));
+	}
+
+	if (!err) {
+		err = app_delta_patch_done(&patch);
+	}
+
+	if (target_opened) {
+		int done_err = dfu_target_stream_done(err == 0);
+
+		zassert_equal(done_err, 0, "Unexpected failure: %d", done_err);
+		target_opened = false;
+	}
+
+	return err;
+}
+
+static void verify_target(void)
+{
+	int err;
+
+	for (size_t offset = 0; offset < sizeof(target_image); offset += sizeof(read_buf)) {
+		size_t len = MIN(sizeof(read_buf), sizeof(target_image) - offset);
+
+		err = flash_read(fdev, TARGET_BASE + offset, read_buf, len);
+		zassert_equal(err, 0, "Unexpected failure: %d", err);
+		zassert_mem_equal(read_buf, &target_image[offset], len,
+				  "Target image mismatch at offset %zu", offset);
+	}
+}
+
+static void test_app_delta_apply(void)
+{
+	const size_t chunk_sizes[] = { 1, 17, 256, 1024, sizeof(patch_data) };
+	int err;
+
+	for (size_t i = 0; i < ARRAY_SIZE(chunk_sizes); i++) {
+		err = flash_erase(fdev, TARGET_BASE, TARGET_AREA_SIZE);
+		zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+		err = apply_patch(patch_data, sizeof(patch_data), chunk_sizes[i]);
+		zassert_equal(err, 0, "Unexpected failure: %d", err);
+		zassert_equal(patch.patch_bytes, sizeof(patch_data), "Patch not consumed");
+		zassert_equal(patch.target_bytes, sizeof(target_image), "Wrong target size");
+
+		verify_target();
+	}
+}
+
+static void test_app_delta_throughput(void)
+{
+	int64_t start;
+	int64_t elapsed;
+	int err;
+
+	start = k_uptime_get();
+	err = apply_patch(patch_data, sizeof(patch_data), 1024);
+	elapsed = k_uptime_get() - start;
+
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	verify_target();
+
+	TC_PRINT("Patch of %zu bytes (%zu%% of %zu byte image) applied in %lld ms\n",
+		 sizeof(patch_data), 100 * sizeof(patch_data) / sizeof(target_image),
+		 sizeof(target_image), (long long)elapsed);
+
+	if (elapsed > 0) {
+		TC_PRINT("Target image written at %lld bytes/s\n",
+			 (long long)sizeof(target_image) * 1000 / elapsed);
+	}
+}
+
+static void test_app_delta_wrong_source(void)
+{
+	int err;
+
+	/* CRC of the source image is at offset 8 of the header */
+	memcpy(patch_copy, patch_data, sizeof(patch_data));
+	patch_copy[8] ^= 0x01;
+
+	err = apply_patch(patch_copy, sizeof(patch_data), 1024);
+	zassert_equal(err, -EINVAL, "Unexpected result: %d", err);
+}
+
+static void test_app_delta_truncated(void)
+{
+	int err;
+
+	err = apply_patch(patch_data, sizeof(patch_data) - 1, 1024);
+	zassert_equal(err, -ENODATA, "Unexpected result: %d", err);
+}
+
+static void test_app_delta_malformed(void)
+{
+	int err;
+
+	/* Trailing data */
+	memcpy(patch_copy, patch_data, sizeof(patch_data));
+	patch_copy[sizeof(patch_data)] = 0;
+
+	err = apply_patch(patch_copy, sizeof(patch_copy), 1024);
+	zassert_equal(err, -EBADMSG, "Unexpected result: %d", err);
+
+	/* Invalid magic */
+	patch_copy[0] ^= 0x01;
+	zassert_false(app_delta_patch_identify(patch_copy), "Invalid magic identified");
+
+	err = apply_patch(patch_copy, sizeof(patch_data), 1024);
+	zassert_equal(err, -EBADMSG, "Unexpected result: %d", err);
+}
+
+void test_main(void)
+{
+	int err;
+
+	__ASSERT_NO_MSG(device_is_ready(fdev));
+	__ASSERT_NO_MSG(app_delta_patch_identify(patch_data));
+
+	/* Install the source image as the current image */
+	err = flash_erase(fdev, SOURCE_BASE, ROUND_UP(sizeof(source_image), PAGE_SIZE));
+	__ASSERT(err == 0, "Failed to erase source image (err %d)", err);
+
+	err = flash_write(fdev, SOURCE_BASE, source_image, sizeof(source_image));
+	__ASSERT(err == 0, "Failed to write source image (err %d)", err);
+
+	ztest_test_suite(lib_dfu_target_app_delta,
+	     ztest_unit_test(test_app_delta_apply),
+	     ztest_unit_test(test_app_delta_throughput),
+	     ztest_unit_test(test_app_delta_wrong_source),
+	     ztest_unit_test(test_app_delta_truncated),
+	     ztest_unit_test(test_app_delta_malformed)
+	 );
+
+	ztest_run_test_suite(lib_dfu_target_app_delta);
+}
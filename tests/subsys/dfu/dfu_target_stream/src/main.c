@@ -11,6 +11,13 @@
 #include <ztest.h>
 #include <dfu/dfu_target_stream.h>
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+#include <tinycrypt/sha256.h>
+#endif
+#if defined(CONFIG_DFU_TARGET_STREAM_SHA256) && defined(CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS)
+#include <zephyr/settings/settings.h>
+#endif
+
 #define FLASH_BASE (64*1024)
 #define FLASH_SIZE DT_REG_SIZE(SOC_NV_FLASH_NODE)
 #define FLASH_AVAILABLE (FLASH_SIZE-FLASH_BASE)
@@ -34,6 +41,12 @@ static int page_size;
 		.fdev = fdev_, .buf = buf_, .len = len_, .offset = offset_,  \
 		.size = size_, .cb = cb_})
 
+#define DFU_TARGET_STREAM_INIT_SHA256(id_, expected_)                        \
+	dfu_target_stream_init(&(struct dfu_target_stream_init) { .id = id_, \
+		.fdev = fdev, .buf = sbuf, .len = sizeof(sbuf),              \
+		.offset = FLASH_BASE, .size = 0,                             \
+		.expected_sha256 = expected_})
+
 static void test_dfu_target_stream_null_checks(void)
 {
 	int err;
@@ -99,6 +112,167 @@ static void test_dfu_target_stream(void)
 	zassert_mem_equal(read_buf, write_buf, BUF_LEN, "Incorrect value");
 }
 
+#ifdef CONFIG_DFU_TARGET_STREAM_SHA256
+static uint8_t pattern_buf[BUF_LEN];
+
+static void pattern_sha256(uint8_t *digest)
+{
+	struct tc_sha256_state_struct s;
+
+	(void)tc_sha256_init(&s);
+	(void)tc_sha256_update(&s, pattern_buf, sizeof(pattern_buf));
+	(void)tc_sha256_final(digest, &s);
+}
+
+/* Write pattern_buf[from, to) in chunks of varying sizes, so that writes
+ * both fit in and overflow the stream buffer.
+ */
+static void pattern_write(size_t from, size_t to)
+{
+	static const size_t chunks[] = { 1, 7, 100, 129, 1000, 256 };
+	int err;
+
+	for (size_t i = 0; from < to; i = (i + 1) % ARRAY_SIZE(chunks)) {
+		size_t len = MIN(chunks[i], to - from);
+
+		err = dfu_target_stream_write(&pattern_buf[from], len);
+		zassert_equal(err, 0, "Unexpected failure: %d", err);
+		from += len;
+	}
+}
+
+static void test_dfu_target_stream_sha256(void)
+{
+	int err;
+	uint8_t expected[DFU_TARGET_STREAM_SHA256_LEN];
+	uint8_t digest[DFU_TARGET_STREAM_SHA256_LEN];
+	struct tc_sha256_state_struct s;
+	uint32_t done_cycles;
+	uint32_t read_back_cycles;
+
+	/* Reset state to avoid failure when initializing */
+	err = dfu_target_stream_done(true);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	for (size_t i = 0; i < sizeof(pattern_buf); i++) {
+		pattern_buf[i] = (uint8_t)(i * 31 + (i >> 8));
+	}
+	pattern_sha256(expected);
+
+	err = DFU_TARGET_STREAM_INIT_SHA256(TEST_ID_1, expected);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	err = dfu_target_stream_sha256_get(digest);
+	zassert_equal(err, -ENODATA, "Unexpected digest: %d", err);
+
+	pattern_write(0, sizeof(pattern_buf));
+
+	done_cycles = k_cycle_get_32();
+	err = dfu_target_stream_done(true);
+	done_cycles = k_cycle_get_32() - done_cycles;
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	err = dfu_target_stream_sha256_get(digest);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	zassert_mem_equal(digest, expected, sizeof(digest), "Incorrect digest");
+
+	/* What the digest costs when the image is read back instead */
+	read_back_cycles = k_cycle_get_32();
+	err = flash_read(fdev, FLASH_BASE, read_buf, BUF_LEN);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	(void)tc_sha256_init(&s);
+	(void)tc_sha256_update(&s, read_buf, BUF_LEN);
+	(void)tc_sha256_final(digest, &s);
+	read_back_cycles = k_cycle_get_32() - read_back_cycles;
+	zassert_mem_equal(digest, expected, sizeof(digest), "Incorrect digest");
+
+	TC_PRINT("Digest after done: %u cycles, read back and hash: %u cycles\n",
+		 done_cycles, read_back_cycles);
+
+	/* Mismatching digest must fail the stream */
+	expected[0] ^= 0x01;
+	err = DFU_TARGET_STREAM_INIT_SHA256(TEST_ID_1, expected);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	pattern_write(0, sizeof(pattern_buf));
+
+	err = dfu_target_stream_done(true);
+	zassert_equal(err, -EBADMSG, "Unexpected result: %d", err);
+
+	/* The computed digest is still available */
+	err = dfu_target_stream_sha256_get(digest);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	zassert_true(memcmp(digest, expected, sizeof(digest)) != 0,
+		     "Incorrect digest");
+}
+#else
+
+static void test_dfu_target_stream_sha256(void)
+{
+	ztest_test_skip();
+}
+
+#endif
+
+#if defined(CONFIG_DFU_TARGET_STREAM_SHA256) && defined(CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS)
+static void sha256_interrupted_write(const uint8_t *expected, bool drop_state)
+{
+	int err;
+	size_t offset;
+	uint8_t digest[DFU_TARGET_STREAM_SHA256_LEN];
+
+	err = DFU_TARGET_STREAM_INIT_SHA256(TEST_ID_1, expected);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	pattern_write(0, sizeof(pattern_buf) / 2);
+
+	/* Interrupt the transfer */
+	err = dfu_target_stream_done(false);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	if (drop_state) {
+		/* Without the stored hash state the data written so far is
+		 * read back from flash.
+		 */
+		err = settings_delete("dfu/" TEST_ID_1 "/sha256");
+		zassert_equal(err, 0, "Unexpected failure: %d", err);
+	}
+
+	err = DFU_TARGET_STREAM_INIT_SHA256(TEST_ID_1, expected);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	err = dfu_target_stream_offset_get(&offset);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	zassert_not_equal(offset, 0, "Progress not restored");
+
+	pattern_write(offset, sizeof(pattern_buf));
+
+	err = dfu_target_stream_done(true);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+
+	err = dfu_target_stream_sha256_get(digest);
+	zassert_equal(err, 0, "Unexpected failure: %d", err);
+	zassert_mem_equal(digest, expected, sizeof(digest), "Incorrect digest");
+}
+
+static void test_dfu_target_stream_sha256_resume(void)
+{
+	uint8_t expected[DFU_TARGET_STREAM_SHA256_LEN];
+
+	pattern_sha256(expected);
+
+	sha256_interrupted_write(expected, false);
+	sha256_interrupted_write(expected, true);
+}
+#else
+
+static void test_dfu_target_stream_sha256_resume(void)
+{
+	ztest_test_skip();
+}
+
+#endif
+
 #ifdef CONFIG_DFU_TARGET_STREAM_SAVE_PROGRESS
 static void test_dfu_target_stream_save_progress(void)
 {
@@ -300,6 +474,8 @@ void test_main(void)
 	ztest_test_suite(lib_dfu_target_stream,
 	     ztest_unit_test(test_dfu_target_stream_null_checks),
 	     ztest_unit_test(test_dfu_target_stream),
+	     ztest_unit_test(test_dfu_target_stream_sha256),
+	     ztest_unit_test(test_dfu_target_stream_sha256_resume),
 	     ztest_unit_test(test_dfu_target_stream_save_progress)
 	 );
 
@@ -0,0 +1,723 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <stdlib.h>
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <zephyr/sys/byteorder.h>
+#include <net/mqtt_outbox.h>
+
+#define TOPIC_DATA "dev/data"
+#define TOPIC_ALERT "dev/alert"
+#define TOPIC_TELEMETRY "dev/telemetry"
+#define TOPIC_STICKY "dev/sticky"
+
+#define PAYLOAD_SIZE 16
+#define RX_MAX 128
+
+/* PUBLISH packet as seen by the broker */
+struct broker_msg {
+	char topic[32];
+	uint8_t qos;
+	bool dup;
+	uint16_t id;
+	/* Message number carried in the payload */
+	int n;
+	size_t payload_len;
+	/* Payload is the number padded with spaces */
+	bool payload_valid;
+};
+
+/* Broker stand-in on the other end of a socket pair */
+static int client_fd = -1;
+static int broker_fd = -1;
+static uint8_t rx_buf[CONFIG_NET_SOCKETPAIR_BUFFER_SIZE];
+static size_t rx_len;
+
+/* Only the transport and the mutex of the client are used by the outbox */
+static struct mqtt_client client;
+
+static K_THREAD_STACK_DEFINE(publisher_stack, 2048);
+static struct k_thread publisher_thread;
+static int publisher_err;
+
+static void broker_connect(void)
+{
+	int fds[2];
+
+	zassert_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, "socketpair() failed");
+	client_fd = fds[0];
+	broker_fd = fds[1];
+	rx_len = 0;
+
+	client.transport.type = MQTT_TRANSPORT_NON_SECURE;
+	client.transport.tcp.sock = client_fd;
+	sys_mutex_init(&client.internal.mutex);
+
+	zassert_equal(mqtt_outbox_connected(&client), 0, "Failed to flush on connect");
+}
+
+static void broker_disconnect(void)
+{
+	mqtt_outbox_disconnected();
+
+	if (client_fd >= 0) {
+		close(client_fd);
+		client_fd = -1;
+	}
+	if (broker_fd >= 0) {
+		close(broker_fd);
+		broker_fd = -1;
+	}
+}
+
+static void outbox_reboot(void)
+{
+	broker_disconnect();
+	mqtt_outbox_uninit();
+	zassert_equal(mqtt_outbox_init(), 0, "Failed to initialize the outbox");
+}
+
+/* Returns the length of the packet at the start of the buffer, 0 if incomplete */
+static size_t packet_parse(const uint8_t *data, size_t len, struct broker_msg *msg)
+{
+	char payload[CONFIG_MQTT_OUTBOX_MSG_MAX_SIZE + 1];
+	uint32_t remaining = 0;
+	size_t off = 1;
+	size_t topic_len;
+	char *end;
+
+	do {
+		if (off >= len) {
+			return 0;
+		}
+		remaining |= (data[off] & 0x7f) << (7 * (off - 1));
+	} while (data[off++] & 0x80);
+
+	if (off + remaining > len) {
+		return 0;
+	}
+
+	zassert_equal(data[0] & 0xf0, 0x30, "Not a PUBLISH packet");
+	msg->dup = data[0] & BIT(3);
+	msg->qos = (data[0] >> 1) & 0x03;
+	msg->id = 0;
+
+	len = off + remaining;
+	topic_len = sys_get_be16(&data[off]);
+	off += 2;
+	zassert_true(topic_len < sizeof(msg->topic), "Topic too long");
+	memcpy(msg->topic, &data[off], topic_len);
+	msg->topic[topic_len] = '\0';
+	off += topic_len;
+
+	if (msg->qos) {
+		msg->id = sys_get_be16(&data[off]);
+		off += 2;
+	}
+
+	msg->payload_len = len - off;
+	zassert_true(msg->payload_len < sizeof(payload), "Payload too long");
+	memcpy(payload, &data[off], msg->payload_len);
+	payload[msg->payload_len] = '\0';
+
+	msg->n = strtol(payload, &end, 10);
+	msg->payload_valid = end != payload;
+	while (*end == ' ') {
+		end++;
+	}
+	if (*end != '\0') {
+		msg->payload_valid = false;
+	}
+
+	return len;
+}
+
+/* Reads the packets written by the outbox so far */
+static int broker_receive(struct broker_msg *msgs, int max)
+{
+	size_t len;
+	ssize_t ret;
+	int count = 0;
+
+	while (true) {
+		ret = recv(broker_fd, &rx_buf[rx_len], sizeof(rx_buf) - rx_len, MSG_DONTWAIT);
+		if (ret <= 0) {
+			break;
+		}
+		rx_len += ret;
+	}
+
+	while ((len = packet_parse(rx_buf, rx_len, &msgs[count])) > 0) {
+		memmove(rx_buf, &rx_buf[len], rx_len - len);
+		rx_len -= len;
+		count++;
+		zassert_true(count < max, "Too many messages received");
+	}
+
+	return count;
+}
+
+static int publish(const char *topic, uint8_t qos, int n, size_t size)
+{
+	static char payload[CONFIG_MQTT_OUTBOX_MSG_MAX_SIZE];
+	struct mqtt_publish_param param = { 0 };
+	int len = snprintk(payload, sizeof(payload), "%d", n);
+
+	if (size > len) {
+		memset(&payload[len], ' ', size - len);
+		len = size;
+	}
+
+	param.message.topic.topic.utf8 = (const uint8_t *)topic;
+	param.message.topic.topic.size = strlen(topic);
+	param.message.topic.qos = qos;
+	param.message.payload.data = (uint8_t *)payload;
+	param.message.payload.len = len;
+
+	return mqtt_outbox_publish(&param);
+}
+
+static struct mqtt_outbox_stats stats_get(void)
+{
+	struct mqtt_outbox_stats stats;
+
+	mqtt_outbox_stats_get(&stats);
+
+	return stats;
+}
+
+static void setup(void)
+{
+	mqtt_outbox_uninit();
+	zassert_equal(mqtt_outbox_init(), 0, "Failed to initialize the outbox");
+	zassert_equal(mqtt_outbox_clear(), 0, "Failed to clear the outbox");
+}
+
+static void teardown(void)
+{
+	broker_disconnect();
+}
+
+static void test_publish_invalid(void)
+{
+	struct mqtt_publish_param param = { 0 };
+	static char large[CONFIG_MQTT_OUTBOX_MSG_MAX_SIZE + 1];
+
+	zassert_equal(mqtt_outbox_publish(NULL), -EINVAL, "NULL accepted");
+	zassert_equal(mqtt_outbox_publish(&param), -EINVAL, "Empty topic accepted");
+
+	param.message.topic.topic.utf8 = (const uint8_t *)TOPIC_DATA;
+	param.message.topic.topic.size = strlen(TOPIC_DATA);
+	param.message.topic.qos = MQTT_QOS_2_EXACTLY_ONCE;
+	zassert_equal(mqtt_outbox_publish(&param), -ENOTSUP, "QoS 2 accepted");
+
+	param.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE;
+	param.message.payload.data = (uint8_t *)large;
+	param.message.payload.len = sizeof(large);
+	zassert_equal(mqtt_outbox_publish(&param), -EMSGSIZE, "Too large message accepted");
+
+	param.message.payload.len = 1;
+	param.message_id = 1234;
+	zassert_equal(mqtt_outbox_publish(&param), 0, "Publish failed");
+	zassert_equal(mqtt_outbox_publish(&param), -EEXIST, "Duplicate ID accepted");
+
+	zassert_equal(mqtt_outbox_flush(), -ENOTCONN, "Flushed while disconnected");
+	zassert_equal(mqtt_outbox_puback(4321), -ENOENT, "Unknown PUBACK accepted");
+	zassert_equal(mqtt_outbox_puback(1234), 0, "PUBACK not accepted");
+	zassert_equal(stats_get().stored, 0, "Acknowledged message stored");
+}
+
+static void test_flush_batching(void)
+{
+	struct broker_msg rx[RX_MAX];
+	struct mqtt_outbox_stats stats;
+	const int count = 40;
+	int received;
+
+	for (int i = 0; i < count; i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_0_AT_MOST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+	zassert_equal(stats_get().stored, count, "Messages not stored while disconnected");
+
+	broker_connect();
+
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, count, "Received %d messages", received);
+	for (int i = 0; i < count; i++) {
+		zassert_equal(rx[i].n, i, "Message %d out of order", i);
+		zassert_true(rx[i].payload_valid, "Message %d corrupted", i);
+		zassert_equal(rx[i].qos, MQTT_QOS_0_AT_MOST_ONCE, "Wrong QoS");
+		zassert_equal(strcmp(rx[i].topic, TOPIC_DATA), 0, "Wrong topic");
+	}
+
+	/* Queued messages are packed into as few writes as the buffer allows */
+	stats = stats_get();
+	zassert_equal(stats.stored, 0, "QoS 0 messages kept after sending");
+	zassert_equal(stats.sent, count, "Wrong sent count");
+	zassert_true(stats.writes <= DIV_ROUND_UP(stats.bytes, CONFIG_MQTT_OUTBOX_BUF_SIZE) + 1,
+		     "%d writes for %d bytes", stats.writes, stats.bytes);
+
+	printk("Flush: %d messages in %d writes, %d bytes per write\n", stats.sent, stats.writes,
+	       stats.bytes / stats.writes);
+}
+
+static void test_flush_window(void)
+{
+	struct broker_msg rx[RX_MAX];
+	struct mqtt_outbox_stats stats;
+	const int count = 40;
+	int delivered = 0;
+	int received;
+
+	for (int i = 0; i < count; i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+
+	broker_connect();
+
+	/* Broker acknowledges the messages one at a time, in order */
+	for (int round = 0; delivered < count; round++) {
+		zassert_true(round < count, "Delivery stalled at %d", delivered);
+
+		received = broker_receive(rx, ARRAY_SIZE(rx));
+		zassert_true(received <= CONFIG_MQTT_OUTBOX_INFLIGHT_MAX, "Window exceeded");
+
+		for (int i = 0; i < received; i++) {
+			zassert_equal(rx[i].n, delivered, "Message %d out of order", delivered);
+			zassert_false(rx[i].dup, "DUP set on first delivery");
+			zassert_equal(rx[i].qos, MQTT_QOS_1_AT_LEAST_ONCE, "Wrong QoS");
+			delivered++;
+		}
+		for (int i = 0; i < received; i++) {
+			zassert_equal(mqtt_outbox_puback(rx[i].id), 0, "PUBACK not accepted");
+		}
+	}
+
+	/* Window is refilled once half empty, not after every PUBACK */
+	stats = stats_get();
+	zassert_equal(stats.stored, 0, "Acknowledged messages stored");
+	zassert_equal(stats.acked, count, "Wrong acked count");
+	zassert_true(stats.writes <= count / (CONFIG_MQTT_OUTBOX_INFLIGHT_MAX / 2) + 2,
+		     "%d writes for %d messages", stats.writes, count);
+
+	printk("Window: %d messages in %d writes\n", stats.sent, stats.writes);
+}
+
+static void test_replay_after_disconnect(void)
+{
+	struct broker_msg rx[RX_MAX];
+	uint16_t ids[5];
+	int received;
+
+	broker_connect();
+
+	for (int i = 0; i < ARRAY_SIZE(ids); i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, ARRAY_SIZE(ids), "Messages not sent while connected");
+	for (int i = 0; i < received; i++) {
+		zassert_false(rx[i].dup, "DUP set on first delivery");
+		ids[i] = rx[i].id;
+	}
+
+	zassert_equal(mqtt_outbox_puback(ids[0]), 0, "PUBACK not accepted");
+	zassert_equal(mqtt_outbox_puback(ids[1]), 0, "PUBACK not accepted");
+
+	broker_disconnect();
+	broker_connect();
+
+	/* Unacknowledged messages are sent again with the same ID */
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, 3, "Received %d messages", received);
+	for (int i = 0; i < received; i++) {
+		zassert_true(rx[i].dup, "DUP not set on replay");
+		zassert_equal(rx[i].id, ids[i + 2], "Replayed with a different ID");
+		zassert_equal(rx[i].n, i + 2, "Wrong message replayed");
+		zassert_equal(mqtt_outbox_puback(rx[i].id), 0, "PUBACK not accepted");
+	}
+
+	zassert_equal(stats_get().replayed, 3, "Wrong replayed count");
+	zassert_equal(stats_get().stored, 0, "Acknowledged messages stored");
+}
+
+static void test_reboot_persistence(void)
+{
+	struct broker_msg rx[RX_MAX];
+	int received;
+	int n = 0;
+
+	/* Sent, not acknowledged */
+	broker_connect();
+	for (int i = 0; i < 3; i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, n++, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+	zassert_equal(broker_receive(rx, ARRAY_SIZE(rx)), 3, "Messages not sent");
+	broker_disconnect();
+
+	/* Queued while disconnected */
+	for (int i = 0; i < 2; i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_0_AT_MOST_ONCE, n++, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, n++, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+
+	outbox_reboot();
+	zassert_equal(stats_get().stored, n, "Messages lost on reboot");
+
+	broker_connect();
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, n, "Received %d messages", received);
+	for (int i = 0; i < received; i++) {
+		zassert_equal(rx[i].n, i, "Message %d out of order", i);
+		zassert_true(rx[i].payload_valid, "Message %d corrupted", i);
+		if (rx[i].qos) {
+			zassert_equal(mqtt_outbox_puback(rx[i].id), 0, "PUBACK not accepted");
+		}
+	}
+	zassert_equal(stats_get().stored, 0, "Delivered messages stored");
+
+	/* Deletions are persisted too */
+	outbox_reboot();
+	zassert_equal(stats_get().stored, 0, "Delivered messages loaded after reboot");
+}
+
+/* Deterministic pseudo-random numbers */
+static uint32_t rand_state = 0x2545f491;
+
+static uint32_t rand_next(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return rand_state;
+}
+
+static void test_no_loss_forced_disconnects(void)
+{
+	enum { COUNT = 300, STORED_MAX = 32 };
+	static bool delivered[COUNT];
+	struct broker_msg rx[RX_MAX];
+	/* Received on the current connection, not acknowledged yet */
+	uint16_t pending[RX_MAX];
+	int pending_count = 0;
+	int published = 0;
+	int received;
+	int i;
+
+	memset(delivered, 0, sizeof(delivered));
+	broker_connect();
+
+	for (int step = 0; published < COUNT || stats_get().stored > 0; step++) {
+		zassert_true(step < 100 * COUNT, "Delivery stalled");
+
+		switch (rand_next() % 16) {
+		case 0:
+			/* Connection lost, the broker never sees the pending PUBACKs */
+			broker_disconnect();
+			broker_connect();
+			pending_count = 0;
+			break;
+		case 1:
+			/* Broker closes the connection, the outbox notices on the next write */
+			close(broker_fd);
+			broker_fd = -1;
+			if (published < COUNT && stats_get().stored < STORED_MAX) {
+				zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE,
+						      published++, PAYLOAD_SIZE), 0,
+					      "Publish failed");
+			}
+			broker_disconnect();
+			broker_connect();
+			pending_count = 0;
+			break;
+		case 2:
+			outbox_reboot();
+			broker_connect();
+			pending_count = 0;
+			break;
+		case 3 ... 8:
+			if (published < COUNT && stats_get().stored < STORED_MAX) {
+				zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE,
+						      published++, PAYLOAD_SIZE), 0,
+					      "Publish failed");
+			}
+			break;
+		default:
+			/* Acknowledge some of the received messages, in any order */
+			for (i = 0; i < pending_count; ) {
+				if (rand_next() % 2) {
+					(void)mqtt_outbox_puback(pending[i]);
+					pending[i] = pending[--pending_count];
+				} else {
+					i++;
+				}
+			}
+			break;
+		}
+
+		if (broker_fd < 0) {
+			continue;
+		}
+
+		received = broker_receive(rx, ARRAY_SIZE(rx));
+		for (i = 0; i < received; i++) {
+			zassert_true(rx[i].n >= 0 && rx[i].n < published, "Unknown message");
+			zassert_true(rx[i].payload_valid, "Message %d corrupted", rx[i].n);
+			delivered[rx[i].n] = true;
+			zassert_true(pending_count < ARRAY_SIZE(pending), "Too many pending");
+			pending[pending_count++] = rx[i].id;
+		}
+
+		/* Drains the window once everything is published */
+		if (published == COUNT && pending_count > 0 && rand_next() % 4 == 0) {
+			while (pending_count > 0) {
+				(void)mqtt_outbox_puback(pending[--pending_count]);
+			}
+		}
+	}
+
+	for (i = 0; i < COUNT; i++) {
+		zassert_true(delivered[i], "Message %d lost", i);
+	}
+	zassert_equal(stats_get().dropped, 0, "Messages dropped");
+
+	printk("No loss: %d messages, %d replays\n", COUNT, stats_get().replayed);
+}
+
+static void test_ttl_and_priority(void)
+{
+	struct broker_msg rx[RX_MAX];
+	int received;
+
+	zassert_equal(mqtt_outbox_policy_set(TOPIC_ALERT, 10, 0), 0, "Failed to set policy");
+	zassert_equal(mqtt_outbox_policy_set(TOPIC_TELEMETRY, 0, 2), 0, "Failed to set policy");
+
+	for (int i = 0; i < 3; i++) {
+		zassert_equal(publish(TOPIC_TELEMETRY, MQTT_QOS_0_AT_MOST_ONCE, i, PAYLOAD_SIZE),
+			      0, "Publish failed");
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+		zassert_equal(publish(TOPIC_ALERT, MQTT_QOS_1_AT_LEAST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+
+	k_sleep(K_SECONDS(3));
+	broker_connect();
+
+	/* Alerts first, expired telemetry not sent at all */
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, 6, "Received %d messages", received);
+	for (int i = 0; i < 3; i++) {
+		zassert_equal(strcmp(rx[i].topic, TOPIC_ALERT), 0, "Alert not sent first");
+		zassert_equal(rx[i].n, i, "Alert %d out of order", i);
+		zassert_equal(strcmp(rx[i + 3].topic, TOPIC_DATA), 0, "Wrong topic");
+		zassert_equal(rx[i + 3].n, i, "Message %d out of order", i);
+	}
+	zassert_equal(stats_get().expired, 3, "Wrong expired count");
+
+	zassert_equal(mqtt_outbox_policy_set(TOPIC_ALERT, MQTT_OUTBOX_PRIORITY_DEFAULT, 0), 0,
+		      "Failed to reset policy");
+	zassert_equal(mqtt_outbox_policy_set(TOPIC_TELEMETRY, MQTT_OUTBOX_PRIORITY_DEFAULT, 0), 0,
+		      "Failed to reset policy");
+}
+
+static void test_outbox_full(void)
+{
+	struct broker_msg rx[RX_MAX];
+	const int extra = 4;
+	int received;
+
+	/* Oldest messages are dropped */
+	for (int i = 0; i < CONFIG_MQTT_OUTBOX_MSG_COUNT + extra; i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_0_AT_MOST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+	zassert_equal(stats_get().dropped, extra, "Wrong dropped count");
+	zassert_equal(stats_get().stored, CONFIG_MQTT_OUTBOX_MSG_COUNT, "Wrong stored count");
+
+	broker_connect();
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, CONFIG_MQTT_OUTBOX_MSG_COUNT, "Received %d messages", received);
+	zassert_equal(rx[0].n, extra, "Oldest messages not dropped");
+	broker_disconnect();
+
+	/* Messages of a lower priority do not replace more important ones */
+	zassert_equal(mqtt_outbox_policy_set(TOPIC_ALERT, 10, 0), 0, "Failed to set policy");
+	for (int i = 0; i < CONFIG_MQTT_OUTBOX_MSG_COUNT; i++) {
+		zassert_equal(publish(TOPIC_ALERT, MQTT_QOS_1_AT_LEAST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+	zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, 0, PAYLOAD_SIZE), -ENOMEM,
+		      "Alert dropped for a less important message");
+	zassert_equal(stats_get().stored, CONFIG_MQTT_OUTBOX_MSG_COUNT, "Wrong stored count");
+
+	zassert_equal(mqtt_outbox_policy_set(TOPIC_ALERT, MQTT_OUTBOX_PRIORITY_DEFAULT, 0), 0,
+		      "Failed to reset policy");
+}
+
+static void publisher(void *p1, void *p2, void *p3)
+{
+	ARG_UNUSED(p1);
+	ARG_UNUSED(p2);
+	ARG_UNUSED(p3);
+
+	publisher_err = publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, 0, PAYLOAD_SIZE);
+}
+
+static void test_client_mutex(void)
+{
+	struct broker_msg rx[RX_MAX];
+
+	broker_connect();
+
+	/* MQTT client in the middle of writing a packet */
+	sys_mutex_lock(&client.internal.mutex, K_FOREVER);
+
+	k_thread_create(&publisher_thread, publisher_stack,
+			K_THREAD_STACK_SIZEOF(publisher_stack), publisher, NULL, NULL, NULL,
+			k_thread_priority_get(k_current_get()), 0, K_NO_WAIT);
+	k_sleep(K_MSEC(100));
+	zassert_equal(broker_receive(rx, ARRAY_SIZE(rx)), 0, "Written while the client writes");
+
+	sys_mutex_unlock(&client.internal.mutex);
+	zassert_equal(k_thread_join(&publisher_thread, K_SECONDS(1)), 0, "Publisher blocked");
+	zassert_equal(publisher_err, 0, "Publish failed");
+
+	zassert_equal(broker_receive(rx, ARRAY_SIZE(rx)), 1, "Message not sent");
+	zassert_equal(mqtt_outbox_puback(rx[0].id), 0, "PUBACK not accepted");
+}
+
+static void test_message_id(void)
+{
+	struct mqtt_publish_param param = { 0 };
+	uint16_t ids[CONFIG_MQTT_OUTBOX_MSG_COUNT / 2];
+	uint16_t id;
+
+	param.message.topic.topic.utf8 = (const uint8_t *)TOPIC_DATA;
+	param.message.topic.topic.size = strlen(TOPIC_DATA);
+	param.message.topic.qos = MQTT_QOS_1_AT_LEAST_ONCE;
+	param.message.payload.data = (uint8_t *)"0";
+	param.message.payload.len = 1;
+
+	/* Stored with the IDs the next calls would return */
+	id = mqtt_outbox_message_id_get();
+	zassert_not_equal(id, 0, "Invalid message ID");
+	for (int i = 0; i < ARRAY_SIZE(ids); i++) {
+		ids[i] = id + 1 + 2 * i;
+		param.message_id = ids[i];
+		zassert_equal(mqtt_outbox_publish(&param), 0, "Publish failed");
+		zassert_true(mqtt_outbox_message_id_used(ids[i]), "Stored message ID not used");
+	}
+	zassert_false(mqtt_outbox_message_id_used(id), "Unused message ID reported");
+
+	for (int i = 0; i < 2 * ARRAY_SIZE(ids); i++) {
+		id = mqtt_outbox_message_id_get();
+		zassert_false(mqtt_outbox_message_id_used(id), "Stored message ID %d returned", id);
+	}
+
+	/* IDs of the acknowledged messages are free again */
+	for (int i = 0; i < ARRAY_SIZE(ids); i++) {
+		zassert_equal(mqtt_outbox_puback(ids[i]), 0, "PUBACK not accepted");
+		zassert_false(mqtt_outbox_message_id_used(ids[i]), "Acknowledged message ID used");
+	}
+}
+
+static void test_clear(void)
+{
+	struct broker_msg rx[RX_MAX];
+	struct mqtt_outbox_stats stats;
+	int received;
+
+	broker_connect();
+	zassert_equal(publish(TOPIC_DATA, MQTT_QOS_0_AT_MOST_ONCE, 0, PAYLOAD_SIZE), 0,
+		      "Publish failed");
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, 1, "Received %d messages", received);
+	broker_disconnect();
+
+	for (int i = 0; i < CONFIG_MQTT_OUTBOX_MSG_COUNT + 1; i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, i, PAYLOAD_SIZE), 0,
+			      "Publish failed");
+	}
+	zassert_not_equal(mqtt_outbox_message_id_get(), 1, "Message IDs not used");
+
+	/* Statistics and message IDs start again */
+	zassert_equal(mqtt_outbox_clear(), 0, "Failed to clear the outbox");
+	stats = stats_get();
+	zassert_equal(stats.stored, 0, "Messages stored after clear");
+	zassert_equal(stats.sent, 0, "Sent count kept after clear");
+	zassert_equal(stats.dropped, 0, "Dropped count kept after clear");
+	zassert_equal(mqtt_outbox_message_id_get(), 1, "Message IDs not reset");
+}
+
+static void test_log_compaction(void)
+{
+	enum { CYCLES = 400, STICKY = 3, STICKY_SIZE = 32, LARGE_SIZE = 200 };
+	struct broker_msg rx[RX_MAX];
+	int received;
+
+	broker_connect();
+
+	/* Never acknowledged, moved along by every compaction */
+	for (int i = 0; i < STICKY; i++) {
+		zassert_equal(publish(TOPIC_STICKY, MQTT_QOS_1_AT_LEAST_ONCE, i, STICKY_SIZE), 0,
+			      "Publish failed");
+	}
+	zassert_equal(broker_receive(rx, ARRAY_SIZE(rx)), STICKY, "Messages not sent");
+
+	/* Many times the size of the storage */
+	for (int i = 0; i < CYCLES; i++) {
+		zassert_equal(publish(TOPIC_DATA, MQTT_QOS_1_AT_LEAST_ONCE, i, LARGE_SIZE), 0,
+			      "Publish %d failed", i);
+		zassert_equal(broker_receive(rx, ARRAY_SIZE(rx)), 1, "Message %d not sent", i);
+		zassert_equal(rx[0].payload_len, LARGE_SIZE, "Wrong payload length");
+		zassert_equal(mqtt_outbox_puback(rx[0].id), 0, "PUBACK not accepted");
+	}
+	zassert_equal(stats_get().dropped, 0, "Messages dropped");
+
+	outbox_reboot();
+	zassert_equal(stats_get().stored, STICKY, "Messages lost in compaction");
+
+	broker_connect();
+	received = broker_receive(rx, ARRAY_SIZE(rx));
+	zassert_equal(received, STICKY, "Received %d messages", received);
+	for (int i = 0; i < STICKY; i++) {
+		zassert_equal(strcmp(rx[i].topic, TOPIC_STICKY), 0, "Wrong topic");
+		zassert_equal(rx[i].n, i, "Message %d out of order", i);
+		zassert_equal(rx[i].payload_len, STICKY_SIZE, "Wrong payload length");
+		zassert_true(rx[i].payload_valid, "Message %d corrupted", i);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(mqtt_outbox_test,
+		ztest_unit_test_setup_teardown(test_publish_invalid, setup, teardown),
+		ztest_unit_test_setup_teardown(test_flush_batching, setup, teardown),
+		ztest_unit_test_setup_teardown(test_flush_window, setup, teardown),
+		ztest_unit_test_setup_teardown(test_replay_after_disconnect, setup, teardown),
+		ztest_unit_test_setup_teardown(test_reboot_persistence, setup, teardown),
+		ztest_unit_test_setup_teardown(test_no_loss_forced_disconnects, setup, teardown),
+		ztest_unit_test_setup_teardown(test_ttl_and_priority, setup, teardown),
+		ztest_unit_test_setup_teardown(test_outbox_full, setup, teardown),
+		ztest_unit_test_setup_teardown(test_client_mutex, setup, teardown),
+		ztest_unit_test_setup_teardown(test_message_id, setup, teardown),
+		ztest_unit_test_setup_teardown(test_clear, setup, teardown),
+		ztest_unit_test_setup_teardown(test_log_compaction, setup, teardown)
+	);
+
+	ztest_run_test_suite(mqtt_outbox_test);
+}
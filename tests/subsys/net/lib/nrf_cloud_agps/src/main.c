@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <nrf_modem_gnss.h>
+#include <net/nrf_cloud_agps.h>
+
+#include "nrf_cloud_codec.h"
+#include "nrf_cloud_agps_schema_v1.h"
+
+/* Satellites in the recorded responses, the last one is not in orbit */
+#define NUM_SV			31
+#define ALL_SV			0xFFFFFFFFu
+#define CONSTELLATION		(ALL_SV >> (32 - NUM_SV))
+/* Satellites above the horizon during the replay */
+#define VISIBLE_SV		(BIT(1) | BIT(4) | BIT(6) | BIT(8) | BIT(12) | BIT(15) | \
+				 BIT(19) | BIT(25) | BIT(28) | BIT(29))
+#define ALL_FLAGS		(NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST | \
+				 NRF_MODEM_GNSS_AGPS_KLOBUCHAR_REQUEST | \
+				 NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST | \
+				 NRF_MODEM_GNSS_AGPS_POSITION_REQUEST | \
+				 NRF_MODEM_GNSS_AGPS_INTEGRITY_REQUEST)
+
+/* Time to first fix model: a download costs a round trip, including the RRC
+ * connection, and the transfer on an LTE-M link. With the time and the
+ * ephemerides of the visible satellites the GNSS gets a hot start, otherwise
+ * it decodes the missing ephemerides from the satellites.
+ */
+#define LINK_RTT_MS		1500
+#define LINK_BYTES_PER_SEC	10000
+#define HOT_START_MS		2000
+#define EPHE_DECODE_MS		30000
+
+/* A-GPS data the GNSS has received */
+static struct {
+	uint32_t sv_mask_ephe;
+	uint32_t sv_mask_alm;
+	uint32_t data_flags;
+	size_t writes;
+	uint16_t fail_type;
+} gnss;
+
+static uint8_t response[4096];
+static size_t response_len;
+
+/* Used by P-GPS to inject its predictions without caching them */
+int agps_process(const char *buf, size_t buf_len, bool store);
+
+struct session {
+	size_t downloaded;
+	int from_cache;
+	uint32_t ttff_ms;
+};
+
+static uint32_t sv_bit(uint8_t sv_id)
+{
+	return ((sv_id >= 1) && (sv_id <= 32)) ? BIT(sv_id - 1) : 0;
+}
+
+int nrf_modem_gnss_agps_write(void *buf, size_t buf_len, uint16_t type)
+{
+	if (type == gnss.fail_type) {
+		return -EINVAL;
+	}
+
+	switch (type) {
+	case NRF_MODEM_GNSS_AGPS_EPHEMERIDES:
+		gnss.sv_mask_ephe |=
+			sv_bit(((struct nrf_modem_gnss_agps_data_ephemeris *)buf)->sv_id);
+		break;
+	case NRF_MODEM_GNSS_AGPS_ALMANAC:
+		gnss.sv_mask_alm |=
+			sv_bit(((struct nrf_modem_gnss_agps_data_almanac *)buf)->sv_id);
+		break;
+	case NRF_MODEM_GNSS_AGPS_UTC_PARAMETERS:
+		gnss.data_flags |= NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST;
+		break;
+	case NRF_MODEM_GNSS_AGPS_KLOBUCHAR_IONOSPHERIC_CORRECTION:
+		gnss.data_flags |= NRF_MODEM_GNSS_AGPS_KLOBUCHAR_REQUEST;
+		break;
+	case NRF_MODEM_GNSS_AGPS_GPS_SYSTEM_CLOCK_AND_TOWS:
+		gnss.data_flags |= NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST;
+		break;
+	case NRF_MODEM_GNSS_AGPS_LOCATION:
+		gnss.data_flags |= NRF_MODEM_GNSS_AGPS_POSITION_REQUEST;
+		break;
+	case NRF_MODEM_GNSS_AGPS_INTEGRITY:
+		gnss.data_flags |= NRF_MODEM_GNSS_AGPS_INTEGRITY_REQUEST;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	gnss.writes++;
+	return 0;
+}
+
+int nrf_cloud_handle_error_message(const char *const buf, const char *const app_id,
+				   const char *const msg_type, enum nrf_cloud_error *const err)
+{
+	return -ENODATA;
+}
+
+void agps_print(enum nrf_cloud_agps_type type, void *data)
+{
+}
+
+static void *block_add(enum nrf_cloud_agps_type type, uint16_t count, size_t size)
+{
+	void *elements;
+
+	zassert_true(response_len + 3 + count * size <= sizeof(response),
+		     "Response does not fit");
+
+	response[response_len++] = type;
+	memcpy(&response[response_len], &count, sizeof(count));
+	response_len += sizeof(count);
+	elements = &response[response_len];
+	memset(elements, 0, count * size);
+	response_len += count * size;
+
+	return elements;
+}
+
+/* Builds the response recorded from nRF Cloud for the types in the request */
+static size_t response_build(const struct nrf_modem_gnss_agps_data_frame *req)
+{
+	response_len = 0;
+	response[response_len++] = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+
+	if (req->data_flags & NRF_MODEM_GNSS_AGPS_GPS_UTC_REQUEST) {
+		struct nrf_cloud_agps_utc *utc =
+			block_add(NRF_CLOUD_AGPS_UTC_PARAMETERS, 1, sizeof(*utc));
+
+		utc->delta_tls = 18;
+	}
+	if (req->sv_mask_ephe) {
+		struct nrf_cloud_agps_ephemeris *ephe =
+			block_add(NRF_CLOUD_AGPS_EPHEMERIDES, NUM_SV, sizeof(*ephe));
+
+		for (int i = 0; i < NUM_SV; i++) {
+			ephe[i].sv_id = i + 1;
+			ephe[i].toe = 7200 / 16;
+		}
+	}
+	if (req->sv_mask_alm) {
+		struct nrf_cloud_agps_almanac *alm =
+			block_add(NRF_CLOUD_AGPS_ALMANAC, NUM_SV, sizeof(*alm));
+
+		for (int i = 0; i < NUM_SV; i++) {
+			alm[i].sv_id = i + 1;
+		}
+	}
+	if (req->data_flags & NRF_MODEM_GNSS_AGPS_KLOBUCHAR_REQUEST) {
+		block_add(NRF_CLOUD_AGPS_KLOBUCHAR_CORRECTION, 1,
+			  sizeof(struct nrf_cloud_agps_klobuchar));
+	}
+	if (req->data_flags & NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST) {
+		struct nrf_cloud_agps_tow_element *tow =
+			block_add(NRF_CLOUD_AGPS_GPS_TOWS, NUM_SV, sizeof(*tow));
+		struct nrf_cloud_agps_system_time *time;
+
+		for (int i = 0; i < NUM_SV; i++) {
+			tow[i].sv_id = i + 1;
+			tow[i].tlm = i;
+		}
+		/* The clock is sent without the TOW array */
+		time = block_add(NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK, 1,
+				 sizeof(*time) - sizeof(time->sv_tow) + 4);
+		time->date_day = 15900;
+	}
+	if (req->data_flags & NRF_MODEM_GNSS_AGPS_POSITION_REQUEST) {
+		block_add(NRF_CLOUD_AGPS_LOCATION, 1, sizeof(struct nrf_cloud_agps_location));
+	}
+	if (req->data_flags & NRF_MODEM_GNSS_AGPS_INTEGRITY_REQUEST) {
+		block_add(NRF_CLOUD_AGPS_INTEGRITY, 1, sizeof(struct nrf_cloud_agps_integrity));
+	}
+
+	return response_len;
+}
+
+/* Replays a GNSS start: the request is served from the cache, and what is missing is
+ * downloaded and processed.
+ */
+static void session_run(const struct nrf_modem_gnss_agps_data_frame *gnss_req,
+			struct session *s)
+{
+	struct nrf_modem_gnss_agps_data_frame req = *gnss_req;
+	bool hot;
+
+	memset(s, 0, sizeof(*s));
+	gnss.sv_mask_ephe = 0;
+	gnss.sv_mask_alm = 0;
+	gnss.data_flags = 0;
+
+	s->from_cache = nrf_cloud_agps_cache_inject(&req);
+	zassert_true(s->from_cache >= 0, "Cache injection failed");
+
+	if (req.sv_mask_ephe || req.sv_mask_alm || req.data_flags) {
+		s->downloaded = response_build(&req);
+		zassert_equal(nrf_cloud_agps_process((const char *)response, s->downloaded), 0,
+			      "Processing failed");
+		s->ttff_ms = LINK_RTT_MS + s->downloaded * MSEC_PER_SEC / LINK_BYTES_PER_SEC;
+	}
+
+	hot = ((gnss.sv_mask_ephe & VISIBLE_SV) == VISIBLE_SV) &&
+	      (gnss.data_flags & NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST);
+	s->ttff_ms += hot ? HOT_START_MS : EPHE_DECODE_MS;
+
+	TC_PRINT("downloaded %zu bytes, %d elements from cache, TTFF %u ms\n",
+		 s->downloaded, s->from_cache, s->ttff_ms);
+}
+
+static void setup(void)
+{
+	nrf_cloud_agps_cache_clear();
+	memset(&gnss, 0, sizeof(gnss));
+}
+
+static const struct nrf_modem_gnss_agps_data_frame cold_request = {
+	.sv_mask_ephe = CONSTELLATION,
+	.sv_mask_alm = ALL_SV,
+	.data_flags = ALL_FLAGS,
+};
+
+static void test_replay(void)
+{
+	struct session cold;
+	struct session warm;
+	struct session stale;
+	size_t full_size;
+	size_t time_size;
+	struct nrf_modem_gnss_agps_data_frame time_request = {
+		.data_flags = NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST
+	};
+	struct nrf_modem_gnss_agps_data_frame stale_request = {
+		.sv_mask_ephe = ALL_SV,
+		.data_flags = NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST |
+			      NRF_MODEM_GNSS_AGPS_POSITION_REQUEST |
+			      NRF_MODEM_GNSS_AGPS_INTEGRITY_REQUEST
+	};
+
+	full_size = response_build(&cold_request);
+	time_size = response_build(&time_request);
+
+	/* Nothing cached, everything is downloaded */
+	session_run(&cold_request, &cold);
+	zassert_equal(cold.downloaded, full_size, "Wrong download");
+	zassert_equal(cold.from_cache, 0, "Injected from empty cache");
+	zassert_equal(gnss.sv_mask_ephe, CONSTELLATION, "Ephemerides not injected");
+
+	/* Half an hour later only the time is downloaded */
+	k_sleep(K_MINUTES(30));
+	session_run(&cold_request, &warm);
+	zassert_equal(warm.downloaded, time_size, "Cached data downloaded");
+	zassert_equal(warm.from_cache, 2 * NUM_SV + 4, "Wrong elements from cache");
+	zassert_equal(gnss.sv_mask_ephe, CONSTELLATION, "Ephemerides not injected");
+	zassert_equal(gnss.sv_mask_alm, CONSTELLATION, "Almanacs not injected");
+	zassert_equal(gnss.data_flags, ALL_FLAGS, "Elements not injected");
+	zassert_true(warm.ttff_ms < cold.ttff_ms, "No TTFF gain");
+
+	/* Ephemerides, location and integrity expire, almanacs are still valid */
+	k_sleep(K_MINUTES(100));
+	session_run(&cold_request, &stale);
+	zassert_equal(stale.downloaded, response_build(&stale_request), "Wrong download");
+	zassert_equal(stale.from_cache, NUM_SV + 2, "Wrong elements from cache");
+	zassert_equal(gnss.data_flags, ALL_FLAGS, "Elements not injected");
+
+	TC_PRINT("bytes downloaded: cold %zu, warm %zu, stale %zu\n",
+		 cold.downloaded, warm.downloaded, stale.downloaded);
+}
+
+static void test_partial_request(void)
+{
+	struct session s;
+	struct nrf_cloud_agps_cache_stats before;
+	struct nrf_cloud_agps_cache_stats after;
+	struct nrf_modem_gnss_agps_data_frame req = {
+		.sv_mask_ephe = BIT(1) | BIT(4) | BIT(6),
+		.data_flags = NRF_MODEM_GNSS_AGPS_INTEGRITY_REQUEST
+	};
+
+	session_run(&cold_request, &s);
+	nrf_cloud_agps_cache_stats_get(&before);
+
+	gnss.writes = 0;
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), 4, "Wrong elements injected");
+	zassert_equal(gnss.writes, 4, "Only the requested elements are written");
+	zassert_equal(req.sv_mask_ephe, 0, "Ephemerides left in request");
+	zassert_equal(req.data_flags, 0, "Integrity left in request");
+
+	nrf_cloud_agps_cache_stats_get(&after);
+	zassert_equal(after.injected - before.injected, 4, "Wrong injected count");
+	zassert_equal(after.processed_bytes, before.processed_bytes, "Data processed");
+}
+
+static void test_absent_satellite(void)
+{
+	struct session s;
+	struct nrf_modem_gnss_agps_data_frame req = {
+		.sv_mask_ephe = BIT(31)
+	};
+
+	session_run(&cold_request, &s);
+
+	if (IS_ENABLED(CONFIG_NRF_CLOUD_AGPS_FILTERED)) {
+		/* Satellites below the elevation mask are left out of a filtered response */
+		zassert_equal(nrf_cloud_agps_cache_inject(&req), 0, "Absent satellite injected");
+		zassert_equal(req.sv_mask_ephe, BIT(31), "Filtered satellite not requested");
+		return;
+	}
+
+	/* The satellite missing from the response is not requested again */
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), 0, "Absent satellite injected");
+	zassert_equal(req.sv_mask_ephe, 0, "Absent satellite requested");
+
+	/* Until the set expires */
+	k_sleep(K_MINUTES(CONFIG_NRF_CLOUD_AGPS_CACHE_EPHE_VALIDITY));
+	req.sv_mask_ephe = BIT(31);
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), 0, "Absent satellite injected");
+	zassert_equal(req.sv_mask_ephe, BIT(31), "Expired satellite not requested");
+}
+
+static void test_invalid_sv_id(void)
+{
+	struct nrf_modem_gnss_agps_data_frame req = {
+		.sv_mask_ephe = ALL_SV
+	};
+	struct nrf_cloud_agps_ephemeris *ephe;
+	size_t len;
+
+	len = response_build(&req);
+	ephe = (struct nrf_cloud_agps_ephemeris *)&response[1 + 3];
+	ephe[0].sv_id = 0;
+	ephe[1].sv_id = 33;
+	ephe[2].sv_id = 255;
+	zassert_equal(nrf_cloud_agps_process((const char *)response, len), 0,
+		      "Processing failed");
+
+	/* Only the valid satellites are cached */
+	gnss.sv_mask_ephe = 0;
+	req.sv_mask_ephe = ALL_SV;
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), NUM_SV - 3, "Wrong elements injected");
+	zassert_equal(gnss.sv_mask_ephe, CONSTELLATION & ~(BIT(0) | BIT(1) | BIT(2)),
+		      "Wrong ephemerides injected");
+}
+
+static void test_pgps_not_cached(void)
+{
+	struct nrf_modem_gnss_agps_data_frame req = cold_request;
+	struct nrf_cloud_agps_cache_stats before;
+	struct nrf_cloud_agps_cache_stats after;
+	size_t len;
+
+	nrf_cloud_agps_cache_stats_get(&before);
+
+	/* Predicted data injected by P-GPS */
+	len = response_build(&req);
+	zassert_equal(agps_process((const char *)response, len, false), 0, "Processing failed");
+	zassert_equal(gnss.sv_mask_ephe, CONSTELLATION, "Ephemerides not injected");
+
+	nrf_cloud_agps_cache_stats_get(&after);
+	zassert_equal(after.stored, before.stored, "Predicted data stored");
+	zassert_equal(after.processed_bytes, before.processed_bytes, "Predicted data counted");
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), 0, "Predicted data injected");
+	zassert_mem_equal(&req, &cold_request, sizeof(req), "Request modified");
+}
+
+static void test_time_not_cached(void)
+{
+	struct session s;
+	struct nrf_modem_gnss_agps_data_frame req = {
+		.data_flags = NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST
+	};
+
+	session_run(&cold_request, &s);
+
+	gnss.writes = 0;
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), 0, "Time injected from cache");
+	zassert_equal(gnss.writes, 0, "Time written");
+	zassert_equal(req.data_flags, NRF_MODEM_GNSS_AGPS_SYS_TIME_AND_SV_TOW_REQUEST,
+		      "Time not requested");
+}
+
+static void test_write_failure(void)
+{
+	struct session s;
+	struct nrf_modem_gnss_agps_data_frame req = cold_request;
+
+	session_run(&cold_request, &s);
+
+	/* Elements that could not be written stay in the request */
+	gnss.fail_type = NRF_MODEM_GNSS_AGPS_EPHEMERIDES;
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), -EINVAL, "Failure not reported");
+	zassert_equal(req.sv_mask_ephe, CONSTELLATION, "Ephemerides cleared from request");
+	gnss.fail_type = 0;
+}
+
+static void test_clear(void)
+{
+	struct session s;
+	struct nrf_modem_gnss_agps_data_frame req = cold_request;
+
+	session_run(&cold_request, &s);
+	nrf_cloud_agps_cache_clear();
+
+	zassert_equal(nrf_cloud_agps_cache_inject(&req), 0, "Injected after clear");
+	zassert_mem_equal(&req, &cold_request, sizeof(req), "Request modified");
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_agps_test,
+		ztest_unit_test_setup_teardown(test_replay, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_partial_request, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_absent_satellite, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_invalid_sv_id, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_pgps_not_cached, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_time_not_cached, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_write_failure, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_clear, setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(nrf_cloud_agps_test);
+}
@@ -0,0 +1,10 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+/* stub to simplify building the test; predictions are stored in RAM */
+#ifndef PM_CONFIG_H__
+#define PM_CONFIG_H__
+#endif /* PM_CONFIG_H__ */
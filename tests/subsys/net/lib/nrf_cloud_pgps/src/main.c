@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/storage/stream_flash.h>
+#include <net/download_client.h>
+#include <net/nrf_cloud_agps.h>
+#include <net/nrf_cloud_pgps.h>
+#include <date_time.h>
+
+#include "nrf_cloud_codec.h"
+#include "nrf_cloud_pgps_schema_v1.h"
+#include "nrf_cloud_pgps_utils.h"
+
+#define PERIOD_SEC		(CONFIG_NRF_CLOUD_PGPS_PREDICTION_PERIOD * SEC_PER_MIN)
+/* Predictions are selected for the middle of their period */
+#define MIDPOINT_SHIFT_SEC	(120 * SEC_PER_MIN)
+#define START_DAY		15900
+#define START_TIME_OF_DAY	(6 * SEC_PER_HOUR)
+#define START_SEC		((int64_t)START_DAY * SEC_PER_DAY + START_TIME_OF_DAY)
+/* Satellite without a prediction; its ephemeris is served as zeros */
+#define EMPTY_SV		5
+#define HEADER_SIZE		sizeof(struct nrf_cloud_pgps_header)
+#define PGPS_RESPONSE		"{\"host\":\"pgps.nrfcloud.com\",\"path\":\"predictions.bin\"}"
+
+/* Predictions are read memory-mapped, the stream_flash stand-in writes here */
+static uint8_t storage[NUM_BLOCKS * BLOCK_SIZE] __aligned(4);
+
+/* P-GPS file as served, and a copy to check that the fragments are not modified */
+static uint8_t dl_file[HEADER_SIZE + NUM_PREDICTIONS * PGPS_PREDICTION_DL_SIZE];
+static uint8_t dl_copy[sizeof(dl_file)];
+
+static download_client_callback_t dl_callback;
+static bool dl_started;
+static int64_t unix_time_ms;
+
+/* Bytes written to storage straight from the fragments, and from elsewhere */
+static size_t direct_bytes;
+static size_t copied_bytes;
+
+static enum nrf_cloud_pgps_event_type last_evt;
+static struct gps_pgps_request last_request;
+
+int date_time_now(int64_t *unix_time)
+{
+	*unix_time = unix_time_ms;
+	return 0;
+}
+
+int agps_process(const char *buf, size_t buf_len, bool store)
+{
+	return 0;
+}
+
+void nrf_cloud_agps_processed(struct nrf_modem_gnss_agps_data_frame *received_elements)
+{
+	memset(received_elements, 0, sizeof(*received_elements));
+}
+
+int nrf_cloud_parse_pgps_response(const char *const response,
+				  struct nrf_cloud_pgps_result *const result)
+{
+	strncpy(result->host, "pgps.nrfcloud.com", result->host_sz);
+	strncpy(result->path, "predictions.bin", result->path_sz);
+	return 0;
+}
+
+int download_client_init(struct download_client *client, download_client_callback_t callback)
+{
+	dl_callback = callback;
+	return 0;
+}
+
+int download_client_connect(struct download_client *client, const char *host,
+			    const struct download_client_cfg *config)
+{
+	return 0;
+}
+
+int download_client_start(struct download_client *client, const char *file, size_t from)
+{
+	dl_started = true;
+	return 0;
+}
+
+int download_client_disconnect(struct download_client *client)
+{
+	dl_started = false;
+	return 0;
+}
+
+/* The storage is a RAM buffer and the offset is its address */
+int stream_flash_init(struct stream_flash_ctx *ctx, const struct device *fdev, uint8_t *buf,
+		      size_t buf_len, size_t offset, size_t size, stream_flash_callback_t cb)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->fdev = fdev;
+	ctx->buf = buf;
+	ctx->buf_len = buf_len;
+	ctx->offset = offset;
+	ctx->available = size;
+	ctx->callback = cb;
+	return 0;
+}
+
+static void stream_flush(struct stream_flash_ctx *ctx)
+{
+	memcpy((uint8_t *)(ctx->offset + ctx->bytes_written), ctx->buf, ctx->buf_bytes);
+	ctx->bytes_written += ctx->buf_bytes;
+	ctx->buf_bytes = 0;
+}
+
+int stream_flash_buffered_write(struct stream_flash_ctx *ctx, const uint8_t *data, size_t len,
+				bool flush)
+{
+	size_t n;
+
+	if ((ctx->bytes_written + ctx->buf_bytes + len) > ctx->available) {
+		return -ENOMEM;
+	}
+
+	if ((data >= dl_file) && (data < (dl_file + sizeof(dl_file)))) {
+		direct_bytes += len;
+	} else {
+		copied_bytes += len;
+	}
+
+	while (len > 0) {
+		n = MIN(len, ctx->buf_len - ctx->buf_bytes);
+		memcpy(ctx->buf + ctx->buf_bytes, data, n);
+		ctx->buf_bytes += n;
+		data += n;
+		len -= n;
+		if (ctx->buf_bytes == ctx->buf_len) {
+			stream_flush(ctx);
+		}
+	}
+	if (flush && ctx->buf_bytes) {
+		stream_flush(ctx);
+	}
+	return 0;
+}
+
+static void pgps_event_handler(struct nrf_cloud_pgps_event *event)
+{
+	last_evt = event->type;
+	if (event->type == PGPS_EVT_REQUEST) {
+		last_request = *event->request;
+	}
+}
+
+static int pgps_init(void)
+{
+	struct nrf_cloud_pgps_init_param param = {
+		.event_handler = pgps_event_handler,
+		.storage_base = (uint32_t)storage,
+		.storage_size = sizeof(storage),
+	};
+
+	return nrf_cloud_pgps_init(&param);
+}
+
+static void time_set(int64_t gps_sec)
+{
+	unix_time_ms = (gps_sec - GPS_TO_UTC_LEAP_SECONDS + GPS_TO_UNIX_UTC_OFFSET_SECONDS) *
+		       MSEC_PER_SEC;
+}
+
+/* Sets a time for which the given prediction is selected */
+static void time_set_pnum(int pnum)
+{
+	time_set(START_SEC + pnum * PERIOD_SEC - MIDPOINT_SHIFT_SEC + 60);
+}
+
+/* Builds a prediction as stored; the server leaves out the schema version
+ * and the sentinel, and sends the ephemeris without a prediction as zeros
+ */
+static void prediction_build(struct nrf_cloud_pgps_prediction *p, int pnum)
+{
+	int64_t gps_sec = START_SEC + pnum * PERIOD_SEC;
+
+	memset(p, 0, sizeof(*p));
+	p->time_type = NRF_CLOUD_AGPS_GPS_SYSTEM_CLOCK;
+	p->time_count = 1;
+	p->time.date_day = gps_sec / SEC_PER_DAY;
+	p->time.time_full_s = gps_sec % SEC_PER_DAY;
+	p->schema_version = NRF_CLOUD_AGPS_BIN_SCHEMA_VERSION;
+	p->ephemeris_type = NRF_CLOUD_AGPS_EPHEMERIDES;
+	p->ephemeris_count = NRF_CLOUD_PGPS_NUM_SV;
+	for (int i = 0; i < NRF_CLOUD_PGPS_NUM_SV; i++) {
+		p->ephemerii[i].sv_id = i + 1;
+		if (i == EMPTY_SV) {
+			p->ephemerii[i].health = NRF_CLOUD_PGPS_EMPTY_EPHEM_HEALTH;
+			continue;
+		}
+		p->ephemerii[i].iodc = pnum;
+		p->ephemerii[i].toe = gps_sec / 16;
+		p->ephemerii[i].w = pnum * 1000 + i;
+		p->ephemerii[i].m0 = -i;
+	}
+	p->sentinel = (uint32_t)gps_sec;
+}
+
+/* Builds the file served for the given predictions */
+static size_t dl_file_build(int first_pnum, int count)
+{
+	struct nrf_cloud_pgps_header *header = (struct nrf_cloud_pgps_header *)dl_file;
+	struct nrf_cloud_pgps_prediction p;
+	size_t schema_offset = offsetof(struct nrf_cloud_pgps_prediction, schema_version);
+	int64_t first_sec = START_SEC + first_pnum * PERIOD_SEC;
+	uint8_t *buf = dl_file + HEADER_SIZE;
+
+	header->schema_version = NRF_CLOUD_PGPS_BIN_SCHEMA_VERSION;
+	header->array_type = NRF_CLOUD_PGPS_PREDICTION_HEADER;
+	header->num_items = 1;
+	header->prediction_count = count;
+	header->prediction_size = PGPS_PREDICTION_DL_SIZE;
+	header->prediction_period_min = CONFIG_NRF_CLOUD_PGPS_PREDICTION_PERIOD;
+	header->gps_day = first_sec / SEC_PER_DAY;
+	header->gps_time_of_day = first_sec % SEC_PER_DAY;
+
+	for (int pnum = first_pnum; pnum < (first_pnum + count); pnum++) {
+		prediction_build(&p, pnum);
+		p.ephemerii[EMPTY_SV].health = 0;
+		memcpy(buf, &p, schema_offset);
+		memcpy(buf + schema_offset, &p.ephemeris_type,
+		       PGPS_PREDICTION_DL_SIZE - schema_offset);
+		buf += PGPS_PREDICTION_DL_SIZE;
+	}
+
+	memcpy(dl_copy, dl_file, buf - dl_file);
+	return buf - dl_file;
+}
+
+/* Serves the requested file in fragments; the first one holds the header */
+static int download(size_t len, size_t frag_size)
+{
+	struct download_client_evt evt;
+	size_t offset = 0;
+	int err;
+
+	zassert_equal(last_evt, PGPS_EVT_REQUEST, "P-GPS data not requested");
+	err = nrf_cloud_pgps_process(PGPS_RESPONSE, strlen(PGPS_RESPONSE));
+	zassert_equal(err, 0, "Processing the response failed: %d", err);
+	zassert_true(dl_started, "Download not started");
+
+	while (offset < len) {
+		evt.id = DOWNLOAD_CLIENT_EVT_FRAGMENT;
+		evt.fragment.buf = &dl_file[offset];
+		evt.fragment.len = MIN(frag_size, len - offset);
+		if (offset == 0) {
+			evt.fragment.len = MAX(evt.fragment.len, HEADER_SIZE);
+		}
+		offset += evt.fragment.len;
+
+		err = dl_callback(&evt);
+		if (err) {
+			return err;
+		}
+	}
+
+	evt.id = DOWNLOAD_CLIENT_EVT_DONE;
+	return dl_callback(&evt);
+}
+
+/* Checks the predictions stored in consecutive blocks */
+static void predictions_check(int first_pnum, int count)
+{
+	struct nrf_cloud_pgps_prediction p;
+	uint8_t *block;
+
+	for (int pnum = first_pnum; pnum < (first_pnum + count); pnum++) {
+		block = &storage[pnum * BLOCK_SIZE];
+		prediction_build(&p, pnum);
+		zassert_mem_equal(block, &p, sizeof(p), "Prediction %d not stored", pnum);
+		for (int i = sizeof(p); i < BLOCK_SIZE; i++) {
+			zassert_equal(block[i], 0xff, "Prediction %d padding written", pnum);
+		}
+	}
+}
+
+static void pgps_load_all(void)
+{
+	size_t len;
+
+	zassert_equal(pgps_init(), 0, "Init failed");
+	zassert_equal(last_request.prediction_count, NUM_PREDICTIONS, "Wrong request");
+
+	len = dl_file_build(0, NUM_PREDICTIONS);
+	zassert_equal(download(len, CONFIG_NRF_CLOUD_PGPS_DOWNLOAD_FRAGMENT_SIZE), 0,
+		      "Download failed");
+	zassert_equal(last_evt, PGPS_EVT_READY, "P-GPS not ready");
+}
+
+static void setup(void)
+{
+	memset(storage, 0xff, sizeof(storage));
+	time_set_pnum(0);
+	direct_bytes = 0;
+	copied_bytes = 0;
+}
+
+static void test_download_stream(void)
+{
+	const size_t frag_sizes[] = { 1500, 1021, 97, 37, 1 };
+	size_t len;
+
+	for (int i = 0; i < ARRAY_SIZE(frag_sizes); i++) {
+		setup();
+		zassert_equal(pgps_init(), 0, "Init failed");
+
+		len = dl_file_build(0, NUM_PREDICTIONS);
+		zassert_equal(download(len, frag_sizes[i]), 0, "Download failed");
+		zassert_equal(last_evt, PGPS_EVT_READY, "P-GPS not ready");
+		zassert_mem_equal(dl_file, dl_copy, len, "Fragments modified");
+		predictions_check(0, NUM_PREDICTIONS);
+
+		TC_PRINT("fragment size %zu: %zu bytes stored from fragments, %zu copied\n",
+			 frag_sizes[i], direct_bytes, copied_bytes);
+		if (frag_sizes[i] >= 1000) {
+			/* ephemerides are stored straight from the fragments,
+			 * unless split between two of them
+			 */
+			zassert_true(direct_bytes >
+				     (NUM_PREDICTIONS * PGPS_PREDICTION_DL_SIZE * 9 / 10),
+				     "Predictions copied before storing");
+		}
+	}
+}
+
+static void test_find_prediction(void)
+{
+	struct nrf_cloud_pgps_prediction *p;
+	uint32_t first_cycles = 0;
+	uint32_t cached_cycles = 0;
+	uint32_t start;
+	int ret;
+
+	pgps_load_all();
+
+	/* first lookups validate the predictions, the following ones use the index */
+	for (int round = 0; round < 2; round++) {
+		for (int pnum = 0; pnum < NUM_PREDICTIONS; pnum++) {
+			time_set_pnum(pnum);
+			start = k_cycle_get_32();
+			ret = nrf_cloud_pgps_find_prediction(&p);
+			if (round == 0) {
+				first_cycles += k_cycle_get_32() - start;
+			} else {
+				cached_cycles += k_cycle_get_32() - start;
+			}
+			zassert_equal(ret, pnum, "Wrong prediction: %d", ret);
+			zassert_equal_ptr(p, &storage[pnum * BLOCK_SIZE], "Wrong prediction");
+			zassert_equal(p->sentinel, (uint32_t)(START_SEC + pnum * PERIOD_SEC),
+				      "Wrong prediction time");
+		}
+	}
+
+	TC_PRINT("lookup: first %llu ns, cached %llu ns\n",
+		 k_cyc_to_ns_floor64(first_cycles / NUM_PREDICTIONS),
+		 k_cyc_to_ns_floor64(cached_cycles / NUM_PREDICTIONS));
+
+	time_set(START_SEC + NUM_PREDICTIONS * PERIOD_SEC);
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), -ETIMEDOUT, "Predictions not expired");
+}
+
+static void test_lazy_validation(void)
+{
+	struct nrf_cloud_pgps_prediction *p;
+	struct nrf_cloud_pgps_prediction *bad;
+	size_t len;
+
+	pgps_load_all();
+
+	/* complete but corrupted prediction passes the init and fails on first use */
+	bad = (struct nrf_cloud_pgps_prediction *)&storage[2 * BLOCK_SIZE];
+	bad->ephemeris_count = 0;
+	zassert_equal(pgps_init(), 0, "Init failed");
+	zassert_equal(last_evt, PGPS_EVT_READY, "P-GPS not ready");
+
+	time_set_pnum(2);
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), -ELOADING, "Bad prediction used");
+	zassert_is_null(p, "Bad prediction returned");
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), -ELOADING, "Bad prediction kept");
+
+	/* discarded prediction is requested again and stored in its block */
+	zassert_equal(last_evt, PGPS_EVT_REQUEST, "Bad prediction not requested");
+	zassert_equal(last_request.prediction_count, 1, "Wrong count");
+	zassert_equal(npgps_gps_day_time_to_sec(last_request.gps_day,
+						last_request.gps_time_of_day),
+		      START_SEC + 2 * PERIOD_SEC, "Wrong start time");
+	len = dl_file_build(2, 1);
+	zassert_equal(download(len, CONFIG_NRF_CLOUD_PGPS_DOWNLOAD_FRAGMENT_SIZE), 0,
+		      "Download failed");
+	zassert_equal(last_evt, PGPS_EVT_READY, "P-GPS not ready");
+	predictions_check(0, NUM_PREDICTIONS);
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), 2, "Prediction not replaced");
+
+	/* validation result is kept */
+	time_set_pnum(1);
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), 1, "Prediction not found");
+	bad = (struct nrf_cloud_pgps_prediction *)&storage[1 * BLOCK_SIZE];
+	bad->ephemeris_type = 0;
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), 1, "Prediction validated again");
+
+	time_set_pnum(3);
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), 3, "Prediction not found");
+
+	/* validated again after a reboot */
+	zassert_equal(pgps_init(), 0, "Init failed");
+	time_set_pnum(1);
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), -ELOADING, "Bad prediction used");
+	zassert_equal(last_evt, PGPS_EVT_REQUEST, "Bad prediction not requested");
+	len = dl_file_build(1, 1);
+	zassert_equal(download(len, CONFIG_NRF_CLOUD_PGPS_DOWNLOAD_FRAGMENT_SIZE), 0,
+		      "Download failed");
+	zassert_equal(nrf_cloud_pgps_find_prediction(&p), 1, "Prediction not replaced");
+	predictions_check(0, NUM_PREDICTIONS);
+}
+
+static void test_incomplete_download(void)
+{
+	const int stored = 4;
+	struct nrf_cloud_pgps_prediction *p;
+	struct nrf_cloud_pgps_prediction *bad;
+	size_t len;
+
+	zassert_equal(pgps_init(), 0, "Init failed");
+	len = dl_file_build(0, NUM_PREDICTIONS);
+
+	/* download stops at a prediction that cannot be parsed */
+	bad = (struct nrf_cloud_pgps_prediction *)&dl_file[HEADER_SIZE +
+							   stored * PGPS_PREDICTION_DL_SIZE];
+	bad->time_type = 0;
+	zassert_equal(download(len, CONFIG_NRF_CLOUD_PGPS_DOWNLOAD_FRAGMENT_SIZE), -EINVAL,
+		      "Bad prediction stored");
+	predictions_check(0, stored);
+
+	/* remaining predictions are requested after a reboot */
+	zassert_equal(pgps_init(), 0, "Init failed");
+	zassert_equal(last_evt, PGPS_EVT_REQUEST, "Missing predictions not requested");
+	zassert_equal(last_request.prediction_count, NUM_PREDICTIONS - stored, "Wrong count");
+	zassert_equal(npgps_gps_day_time_to_sec(last_request.gps_day,
+						last_request.gps_time_of_day),
+		      START_SEC + stored * PERIOD_SEC, "Wrong start time");
+
+	len = dl_file_build(stored, NUM_PREDICTIONS - stored);
+	zassert_equal(download(len, CONFIG_NRF_CLOUD_PGPS_DOWNLOAD_FRAGMENT_SIZE), 0,
+		      "Download failed");
+	zassert_equal(last_evt, PGPS_EVT_READY, "P-GPS not ready");
+	predictions_check(0, NUM_PREDICTIONS);
+
+	for (int pnum = 0; pnum < NUM_PREDICTIONS; pnum++) {
+		time_set_pnum(pnum);
+		zassert_equal(nrf_cloud_pgps_find_prediction(&p), pnum, "Prediction not found");
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nrf_cloud_pgps_test,
+		ztest_unit_test(test_download_stream),
+		ztest_unit_test_setup_teardown(test_find_prediction, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_lazy_validation, setup, unit_test_noop),
+		ztest_unit_test_setup_teardown(test_incomplete_download, setup, unit_test_noop)
+	);
+
+	ztest_run_test_suite(nrf_cloud_pgps_test);
+}
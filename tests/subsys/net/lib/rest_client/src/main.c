@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/net/socket.h>
+#include <net/rest_client.h>
+
+#include "rest_client_pool.h"
+#include "rest_client_dns_cache.h"
+
+#define HOST "api.nrfcloud.com"
+#define PORT 443
+#define SEC_TAG 16842753
+
+/* Remote ends of the pooled connections */
+static int peers[CONFIG_REST_CLIENT_POOL_SIZE + 2];
+
+static void req_ctx_init(struct rest_client_req_context *req_ctx, const char *host)
+{
+	rest_client_request_defaults_set(req_ctx);
+	req_ctx->host = host;
+	req_ctx->port = PORT;
+	req_ctx->sec_tag = SEC_TAG;
+}
+
+/* Opens a connection, returning the local end */
+static int connection_open(int index)
+{
+	int fds[2];
+
+	zassert_equal(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0, "socketpair() failed");
+	peers[index] = fds[1];
+
+	return fds[0];
+}
+
+static bool connection_closed(int index)
+{
+	char c;
+	ssize_t ret = recv(peers[index], &c, sizeof(c), MSG_DONTWAIT);
+
+	zassert_true(ret == 0 || (ret < 0 && errno == EAGAIN), "Unexpected recv() result");
+
+	/* End of file once the local end is closed */
+	return ret == 0;
+}
+
+static void connection_peer_close(int index)
+{
+	zassert_equal(close(peers[index]), 0, "close() failed");
+}
+
+/* rest_client.c is not built, only the defaults are needed */
+void rest_client_request_defaults_set(struct rest_client_req_context *req_ctx)
+{
+	memset(req_ctx, 0, sizeof(*req_ctx));
+	req_ctx->connect_socket = REST_CLIENT_SCKT_CONNECT;
+	req_ctx->sec_tag = REST_CLIENT_SEC_TAG_NO_SEC;
+	req_ctx->tls_peer_verify = REST_CLIENT_TLS_DEFAULT_PEER_VERIFY;
+	req_ctx->http_method = HTTP_GET;
+}
+
+static void test_pool_reuse(void)
+{
+	struct rest_client_req_context req_ctx;
+	struct rest_client_req_context other_ctx;
+	int fd = connection_open(0);
+
+	req_ctx_init(&req_ctx, HOST);
+	zassert_equal(rest_client_pool_get(&req_ctx), -ENOENT, "Pool not empty");
+
+	rest_client_pool_put(&req_ctx, fd);
+	zassert_false(connection_closed(0), "Pooled connection closed");
+
+	/* Connections are only reused for the same host, port and security */
+	req_ctx_init(&other_ctx, "other.nrfcloud.com");
+	zassert_equal(rest_client_pool_get(&other_ctx), -ENOENT, "Other host matched");
+	req_ctx_init(&other_ctx, HOST);
+	other_ctx.port = 80;
+	zassert_equal(rest_client_pool_get(&other_ctx), -ENOENT, "Other port matched");
+	req_ctx_init(&other_ctx, HOST);
+	other_ctx.sec_tag = REST_CLIENT_SEC_TAG_NO_SEC;
+	zassert_equal(rest_client_pool_get(&other_ctx), -ENOENT, "Other security matched");
+
+	zassert_equal(rest_client_pool_get(&req_ctx), fd, "Connection not reused");
+	/* Connection is owned by the request until it is given back */
+	zassert_equal(rest_client_pool_get(&req_ctx), -ENOENT, "Connection reused twice");
+
+	zassert_equal(close(fd), 0, "close() failed");
+	connection_peer_close(0);
+}
+
+static void test_pool_full(void)
+{
+	struct rest_client_req_context req_ctx;
+	int fds[CONFIG_REST_CLIENT_POOL_SIZE + 1];
+
+	req_ctx_init(&req_ctx, HOST);
+
+	for (int i = 0; i < ARRAY_SIZE(fds); i++) {
+		fds[i] = connection_open(i);
+		rest_client_pool_put(&req_ctx, fds[i]);
+		k_sleep(K_MSEC(10));
+	}
+
+	/* Connection idle for the longest time is closed */
+	zassert_true(connection_closed(0), "Oldest connection not closed");
+	for (int i = 1; i < ARRAY_SIZE(fds); i++) {
+		zassert_false(connection_closed(i), "Connection %d closed", i);
+	}
+
+	rest_client_pool_flush();
+	for (int i = 0; i < ARRAY_SIZE(fds); i++) {
+		zassert_true(connection_closed(i), "Connection %d not flushed", i);
+		connection_peer_close(i);
+	}
+	zassert_equal(rest_client_pool_get(&req_ctx), -ENOENT, "Pool not empty after flush");
+}
+
+static void test_pool_idle_timeout(void)
+{
+	struct rest_client_req_context req_ctx;
+
+	req_ctx_init(&req_ctx, HOST);
+
+	rest_client_pool_put(&req_ctx, connection_open(0));
+	k_sleep(K_SECONDS(CONFIG_REST_CLIENT_POOL_IDLE_TIMEOUT / 2));
+	rest_client_pool_put(&req_ctx, connection_open(1));
+
+	/* Idle work closes the first connection without any request */
+	k_sleep(K_SECONDS(CONFIG_REST_CLIENT_POOL_IDLE_TIMEOUT / 2 + 1));
+	zassert_true(connection_closed(0), "Idle connection not closed");
+	zassert_false(connection_closed(1), "Connection closed too early");
+
+	k_sleep(K_SECONDS(CONFIG_REST_CLIENT_POOL_IDLE_TIMEOUT / 2));
+	zassert_true(connection_closed(1), "Idle connection not closed");
+	zassert_equal(rest_client_pool_get(&req_ctx), -ENOENT, "Expired connection reused");
+
+	connection_peer_close(0);
+	connection_peer_close(1);
+}
+
+static void test_pool_host_too_long(void)
+{
+	char host[CONFIG_REST_CLIENT_HOSTNAME_MAX_LEN + 2];
+	struct rest_client_req_context req_ctx;
+
+	memset(host, 'a', sizeof(host) - 1);
+	host[sizeof(host) - 1] = '\0';
+	req_ctx_init(&req_ctx, host);
+
+	rest_client_pool_put(&req_ctx, connection_open(0));
+	zassert_true(connection_closed(0), "Connection not closed");
+	zassert_equal(rest_client_pool_get(&req_ctx), -ENOENT, "Connection pooled");
+
+	connection_peer_close(0);
+}
+
+static void addr_set(struct sockaddr *addr, uint8_t last)
+{
+	struct sockaddr_in *addr4 = (struct sockaddr_in *)addr;
+
+	memset(addr, 0, sizeof(*addr));
+	addr4->sin_family = AF_INET;
+	addr4->sin_port = htons(PORT);
+	addr4->sin_addr.s4_addr[0] = 192;
+	addr4->sin_addr.s4_addr[1] = 0;
+	addr4->sin_addr.s4_addr[2] = 2;
+	addr4->sin_addr.s4_addr[3] = last;
+}
+
+static uint8_t addr_last(const struct sockaddr *addr)
+{
+	return ((const struct sockaddr_in *)addr)->sin_addr.s4_addr[3];
+}
+
+static void test_pool_retry_allowed(void)
+{
+	/* Connection closed or reset before any response, idempotent methods */
+	zassert_true(rest_client_pool_retry_allowed(HTTP_GET, 100, 0), "GET not retried on EOF");
+	zassert_true(rest_client_pool_retry_allowed(HTTP_PUT, -ECONNRESET, 0),
+		     "PUT not retried on reset");
+	zassert_true(rest_client_pool_retry_allowed(HTTP_DELETE, -EPIPE, 0),
+		     "DELETE not retried on broken pipe");
+	zassert_true(rest_client_pool_retry_allowed(HTTP_HEAD, 0, 0), "HEAD not retried");
+
+	/* The server may have processed the request */
+	zassert_false(rest_client_pool_retry_allowed(HTTP_POST, 100, 0), "POST retried");
+	zassert_false(rest_client_pool_retry_allowed(HTTP_PATCH, -ECONNRESET, 0), "PATCH retried");
+	zassert_false(rest_client_pool_retry_allowed(HTTP_GET, -EAGAIN, 0),
+		      "Retried after timeout");
+	zassert_false(rest_client_pool_retry_allowed(HTTP_GET, -ETIMEDOUT, 0),
+		      "Retried after timeout");
+	zassert_false(rest_client_pool_retry_allowed(HTTP_GET, -ECONNRESET, 10),
+		      "Retried after partial response");
+}
+
+static void test_dns_cache(void)
+{
+	struct sockaddr addr;
+	socklen_t addrlen;
+
+	zassert_equal(rest_client_dns_cache_get(HOST, PORT, &addr, &addrlen), -ENOENT,
+		      "Cache not empty");
+
+	addr_set(&addr, 1);
+	rest_client_dns_cache_put(HOST, PORT, &addr, sizeof(struct sockaddr_in));
+	memset(&addr, 0, sizeof(addr));
+	zassert_equal(rest_client_dns_cache_get(HOST, PORT, &addr, &addrlen), 0,
+		      "Address not cached");
+	zassert_equal(addrlen, sizeof(struct sockaddr_in), "Wrong address length");
+	zassert_equal(addr_last(&addr), 1, "Wrong address");
+	zassert_equal(rest_client_dns_cache_get(HOST, 80, &addr, &addrlen), -ENOENT,
+		      "Other port matched");
+
+	/* Updated address replaces the entry */
+	addr_set(&addr, 2);
+	rest_client_dns_cache_put(HOST, PORT, &addr, sizeof(struct sockaddr_in));
+	zassert_equal(rest_client_dns_cache_get(HOST, PORT, &addr, &addrlen), 0,
+		      "Address not cached");
+	zassert_equal(addr_last(&addr), 2, "Address not updated");
+
+	rest_client_dns_cache_remove(HOST, PORT);
+	zassert_equal(rest_client_dns_cache_get(HOST, PORT, &addr, &addrlen), -ENOENT,
+		      "Address not removed");
+}
+
+static void test_dns_cache_expiry(void)
+{
+	struct sockaddr addr;
+	socklen_t addrlen;
+
+	addr_set(&addr, 1);
+	rest_client_dns_cache_put(HOST, PORT, &addr, sizeof(struct sockaddr_in));
+
+	k_sleep(K_SECONDS(CONFIG_REST_CLIENT_DNS_CACHE_TTL - 1));
+	zassert_equal(rest_client_dns_cache_get(HOST, PORT, &addr, &addrlen), 0,
+		      "Address expired too early");
+
+	k_sleep(K_SECONDS(2));
+	zassert_equal(rest_client_dns_cache_get(HOST, PORT, &addr, &addrlen), -ENOENT,
+		      "Address not expired");
+}
+
+static void test_dns_cache_full(void)
+{
+	char host[] = "host0.example.com";
+	struct sockaddr addr;
+	socklen_t addrlen;
+
+	/* One more host than there are entries */
+	for (int i = 0; i <= CONFIG_REST_CLIENT_DNS_CACHE_SIZE; i++) {
+		host[4] = '0' + i;
+		addr_set(&addr, i);
+		rest_client_dns_cache_put(host, PORT, &addr, sizeof(struct sockaddr_in));
+		k_sleep(K_MSEC(10));
+	}
+
+	/* Oldest address is replaced */
+	host[4] = '0';
+	zassert_equal(rest_client_dns_cache_get(host, PORT, &addr, &addrlen), -ENOENT,
+		      "Oldest address not replaced");
+	for (int i = 1; i <= CONFIG_REST_CLIENT_DNS_CACHE_SIZE; i++) {
+		host[4] = '0' + i;
+		zassert_equal(rest_client_dns_cache_get(host, PORT, &addr, &addrlen), 0,
+			      "Address of host %d not cached", i);
+		zassert_equal(addr_last(&addr), i, "Wrong address for host %d", i);
+	}
+}
+
+void test_main(void)
+{
+	ztest_test_suite(rest_client_test,
+		ztest_unit_test(test_pool_reuse),
+		ztest_unit_test(test_pool_full),
+		ztest_unit_test(test_pool_idle_timeout),
+		ztest_unit_test(test_pool_host_too_long),
+		ztest_unit_test(test_pool_retry_allowed),
+		ztest_unit_test(test_dns_cache),
+		ztest_unit_test(test_dns_cache_expiry),
+		ztest_unit_test(test_dns_cache_full)
+	);
+
+	ztest_run_test_suite(rest_client_test);
+}
@@ -0,0 +1,576 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <nfc/ndef/msg_parser.h>
+
+#define MAX_RECORDS 64
+#define GEN_MAX_RECORDS 8
+#define GEN_MAX_TYPE_LEN 8
+#define GEN_MAX_ID_LEN 4
+#define GEN_MAX_PAYLOAD_LEN 300
+#define GEN_MAX_RECORD_LEN (7 + GEN_MAX_TYPE_LEN + GEN_MAX_ID_LEN + GEN_MAX_PAYLOAD_LEN)
+#define MSG_BUF_SIZE (GEN_MAX_RECORDS * GEN_MAX_RECORD_LEN)
+
+#define FUZZ_GENERATED_ITERATIONS 2000
+#define FUZZ_MUTATED_ITERATIONS 20000
+#define FUZZ_MAX_MUTATIONS 4
+
+#define BENCH_RECORDS 8
+#define BENCH_PAYLOAD_LEN 32
+#define BENCH_ITERATIONS 2000
+
+#define FLAG_MB 0x80
+#define FLAG_ME 0x40
+
+/* Record fields as offsets in the raw message. */
+struct test_record {
+	enum nfc_ndef_record_tnf tnf;
+	uint32_t type_offset;
+	uint8_t type_len;
+	uint32_t id_offset;
+	uint8_t id_len;
+	uint32_t payload_offset;
+	uint32_t payload_len;
+};
+
+static uint8_t msg_buf[MSG_BUF_SIZE];
+static uint8_t desc_buf[NFC_NDEF_PARSER_REQUIRED_MEM(MAX_RECORDS)] __aligned(4);
+static struct test_record ref_records[MAX_RECORDS];
+static uint32_t rand_state;
+
+/* Deterministic generator, so that a failing input can be reproduced. */
+static uint32_t test_rand(void)
+{
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+
+	return rand_state;
+}
+
+static uint32_t test_rand_range(uint32_t max)
+{
+	return (max == 0) ? 0 : (test_rand() % (max + 1));
+}
+
+static size_t record_generate(uint8_t *buf, size_t offset, uint8_t location,
+			      struct test_record *record)
+{
+	uint8_t *hdr = buf + offset;
+	uint8_t flags;
+	bool short_record;
+	bool il;
+	size_t header_len;
+	size_t len;
+
+	record->tnf = test_rand_range(TNF_RESERVED);
+	record->type_len = test_rand_range(GEN_MAX_TYPE_LEN);
+	record->payload_len = test_rand_range(GEN_MAX_PAYLOAD_LEN);
+	il = test_rand() & 1;
+	record->id_len = il ? test_rand_range(GEN_MAX_ID_LEN) : 0;
+	short_record = (record->payload_len <= UINT8_MAX) && (test_rand() & 1);
+
+	header_len = 2 + (short_record ? 1 : 4) + (il ? 1 : 0);
+	len = header_len + record->type_len + record->id_len + record->payload_len;
+
+	flags = location | record->tnf;
+	flags |= short_record ? NDEF_RECORD_SR_MASK : 0;
+	flags |= il ? NDEF_RECORD_IL_MASK : 0;
+
+	hdr[0] = flags;
+	hdr[1] = record->type_len;
+
+	if (short_record) {
+		hdr[2] = record->payload_len;
+	} else {
+		sys_put_be32(record->payload_len, &hdr[2]);
+	}
+
+	if (il) {
+		hdr[header_len - 1] = record->id_len;
+	}
+
+	record->type_offset = offset + header_len;
+	record->id_offset = record->type_offset + record->type_len;
+	record->payload_offset = record->id_offset + record->id_len;
+
+	for (size_t i = header_len; i < len; i++) {
+		hdr[i] = test_rand();
+	}
+
+	/* Reserved TNF is reported as Unknown. */
+	if (record->tnf == TNF_RESERVED) {
+		record->tnf = TNF_UNKNOWN_TYPE;
+	}
+
+	return len;
+}
+
+static size_t msg_generate(uint8_t *buf, struct test_record *records, size_t *record_cnt)
+{
+	size_t cnt = 1 + test_rand_range(GEN_MAX_RECORDS - 1);
+	size_t offset = 0;
+
+	for (size_t i = 0; i < cnt; i++) {
+		uint8_t location = 0;
+
+		location |= (i == 0) ? FLAG_MB : 0;
+		location |= (i == (cnt - 1)) ? FLAG_ME : 0;
+
+		offset += record_generate(buf, offset, location, &records[i]);
+	}
+
+	*record_cnt = cnt;
+
+	return offset;
+}
+
+/* Reference parser written directly from the NDEF specification, using 64-bit
+ * arithmetic. Error codes follow the order of checks in the library.
+ */
+static int ref_parse(const uint8_t *data, uint32_t len, struct test_record *records,
+		     size_t *record_cnt, uint32_t *parsed_len)
+{
+	uint64_t offset = 0;
+	size_t cnt = 0;
+
+	while (true) {
+		uint64_t header_len = 3;
+		uint64_t payload_len;
+		uint8_t flags;
+		uint8_t type_len;
+		uint8_t id_len = 0;
+		uint8_t location;
+
+		if (offset == len) {
+			return -EFAULT;
+		}
+
+		if (offset + header_len > len) {
+			return -EINVAL;
+		}
+
+		flags = data[offset];
+		type_len = data[offset + 1];
+
+		if (flags & NDEF_RECORD_SR_MASK) {
+			payload_len = data[offset + 2];
+		} else {
+			header_len += 3;
+			if (offset + header_len > len) {
+				return -EINVAL;
+			}
+
+			payload_len = sys_get_be32(&data[offset + 2]);
+		}
+
+		if (flags & NDEF_RECORD_IL_MASK) {
+			header_len++;
+			if (offset + header_len > len) {
+				return -EINVAL;
+			}
+
+			id_len = data[offset + header_len - 1];
+		}
+
+		if (offset + header_len + type_len + id_len + payload_len > len) {
+			return -EINVAL;
+		}
+
+		location = flags & (FLAG_MB | FLAG_ME);
+
+		if ((cnt == 0) != ((location & FLAG_MB) != 0)) {
+			return -EFAULT;
+		}
+
+		if (cnt < MAX_RECORDS) {
+			struct test_record *record = &records[cnt];
+
+			record->tnf = flags & NDEF_RECORD_TNF_MASK;
+			if (record->tnf == TNF_RESERVED) {
+				record->tnf = TNF_UNKNOWN_TYPE;
+			}
+
+			record->type_offset = offset + header_len;
+			record->type_len = type_len;
+			record->id_offset = record->type_offset + type_len;
+			record->id_len = id_len;
+			record->payload_offset = record->id_offset + id_len;
+			record->payload_len = payload_len;
+		}
+
+		cnt++;
+		offset += header_len + type_len + id_len + payload_len;
+
+		if (location & FLAG_ME) {
+			*record_cnt = cnt;
+			*parsed_len = offset;
+
+			return 0;
+		}
+	}
+}
+
+static const uint8_t *field_get(const uint8_t *data, uint32_t offset, uint32_t len)
+{
+	return (len == 0) ? NULL : (data + offset);
+}
+
+static void view_check(const uint8_t *data, const struct nfc_ndef_record_view *view,
+		       const struct test_record *record)
+{
+	zassert_equal(nfc_ndef_record_view_tnf(view), record->tnf, "Invalid TNF");
+	zassert_equal(view->type_length, record->type_len, "Invalid type length");
+	zassert_equal_ptr(nfc_ndef_record_view_type(view),
+			  field_get(data, record->type_offset, record->type_len),
+			  "Invalid type");
+	zassert_equal(view->id_length, record->id_len, "Invalid ID length");
+	zassert_equal_ptr(nfc_ndef_record_view_id(view),
+			  field_get(data, record->id_offset, record->id_len),
+			  "Invalid ID");
+	zassert_equal(view->payload_length, record->payload_len, "Invalid payload length");
+	zassert_equal_ptr(nfc_ndef_record_view_payload(view),
+			  field_get(data, record->payload_offset, record->payload_len),
+			  "Invalid payload");
+}
+
+static void desc_check(const uint8_t *data, const struct nfc_ndef_record_desc *rec_desc,
+		       const struct test_record *record)
+{
+	const struct nfc_ndef_bin_payload_desc *bin_pay_desc = rec_desc->payload_descriptor;
+
+	zassert_equal(rec_desc->tnf, record->tnf, "Invalid TNF");
+	zassert_equal(rec_desc->type_length, record->type_len, "Invalid type length");
+	zassert_equal_ptr(rec_desc->type, field_get(data, record->type_offset, record->type_len),
+			  "Invalid type");
+	zassert_equal(rec_desc->id_length, record->id_len, "Invalid ID length");
+	zassert_equal_ptr(rec_desc->id, field_get(data, record->id_offset, record->id_len),
+			  "Invalid ID");
+	zassert_equal(bin_pay_desc->payload_length, record->payload_len,
+		      "Invalid payload length");
+	zassert_equal_ptr(bin_pay_desc->payload,
+			  field_get(data, record->payload_offset, record->payload_len),
+			  "Invalid payload");
+}
+
+/* Parse the data with the iterator and the descriptor-based parser and
+ * compare the results with the expected records.
+ */
+static void parsers_check(const uint8_t *data, uint32_t len, int expected_err,
+			  const struct test_record *records, size_t record_cnt,
+			  uint32_t parsed_len)
+{
+	int err;
+	struct nfc_ndef_msg_iter iter;
+	struct nfc_ndef_record_view view;
+	struct nfc_ndef_msg_desc *msg_desc;
+	uint32_t desc_buf_len = sizeof(desc_buf);
+	uint32_t msg_len = len;
+	size_t cnt = 0;
+
+	nfc_ndef_msg_iter_init(&iter, data, len);
+
+	while ((err = nfc_ndef_msg_iter_next(&iter, &view)) == 0) {
+		if (cnt < MAX_RECORDS) {
+			view_check(data, &view, &records[cnt]);
+		}
+
+		cnt++;
+	}
+
+	if (expected_err) {
+		zassert_equal(err, expected_err, "Iterator returned %d instead of %d",
+			      err, expected_err);
+	} else {
+		zassert_equal(err, -ENOENT, "Iterator failed: %d", err);
+		zassert_equal(cnt, record_cnt, "Invalid record count");
+		zassert_equal(nfc_ndef_msg_iter_parsed_len(&iter), parsed_len,
+			      "Invalid message length");
+		zassert_equal(nfc_ndef_msg_iter_next(&iter, &view), -ENOENT,
+			      "Iterator did not stop");
+	}
+
+	err = nfc_ndef_msg_parse(desc_buf, &desc_buf_len, data, &msg_len);
+
+	if (cnt > MAX_RECORDS) {
+		zassert_equal(err, -ENOMEM, "Too many records not reported");
+		return;
+	}
+
+	zassert_equal(err, expected_err, "Parser returned %d instead of %d", err, expected_err);
+
+	if (err) {
+		return;
+	}
+
+	msg_desc = (struct nfc_ndef_msg_desc *)desc_buf;
+
+	zassert_equal(msg_desc->record_count, record_cnt, "Invalid record count");
+	zassert_equal(msg_len, parsed_len, "Invalid message length");
+
+	for (size_t i = 0; i < record_cnt; i++) {
+		desc_check(data, msg_desc->record[i], &records[i]);
+	}
+}
+
+static void test_iter_records(void)
+{
+	int err;
+	struct nfc_ndef_msg_iter iter;
+	struct nfc_ndef_record_view view;
+	struct nfc_ndef_record_desc rec_desc;
+	struct nfc_ndef_bin_payload_desc bin_pay_desc;
+	static const uint8_t uri_type[] = {'U'};
+	static const uint8_t msg[] = {
+		/* Short well-known URI record. */
+		0x91, 0x01, 0x05, 'U', 0x04, 'n', 'o', 'r', 'd',
+		/* Long media record with ID. */
+		0x0A, 0x03, 0x00, 0x00, 0x00, 0x02, 0x01, 'a', '/', 'b', 'I', 0xAA, 0xBB,
+		/* Short empty record. */
+		0x50, 0x00, 0x00,
+		/* Trailing data after the message end. */
+		0xFE, 0x00
+	};
+
+	nfc_ndef_msg_iter_init(&iter, msg, sizeof(msg));
+
+	err = nfc_ndef_msg_iter_next(&iter, &view);
+	zassert_ok(err, "First record not found");
+	zassert_equal(nfc_ndef_record_view_location(&view), NDEF_FIRST_RECORD,
+		      "Invalid location");
+	zassert_true(nfc_ndef_record_view_type_check(&view, TNF_WELL_KNOWN, uri_type,
+						     sizeof(uri_type)),
+		     "Invalid type");
+	zassert_false(nfc_ndef_record_view_type_check(&view, TNF_MEDIA_TYPE, uri_type,
+						      sizeof(uri_type)),
+		      "TNF not checked");
+	zassert_is_null(nfc_ndef_record_view_id(&view), "Unexpected ID");
+	zassert_equal(view.payload_length, 5, "Invalid payload length");
+	zassert_mem_equal(nfc_ndef_record_view_payload(&view), &msg[4], 5, "Invalid payload");
+	zassert_equal(nfc_ndef_record_view_size(&view), 9, "Invalid record size");
+
+	err = nfc_ndef_msg_iter_next(&iter, &view);
+	zassert_ok(err, "Second record not found");
+	zassert_equal(nfc_ndef_record_view_location(&view), NDEF_MIDDLE_RECORD,
+		      "Invalid location");
+	zassert_equal(nfc_ndef_record_view_tnf(&view), TNF_MEDIA_TYPE, "Invalid TNF");
+	zassert_mem_equal(nfc_ndef_record_view_type(&view), "a/b", 3, "Invalid type");
+	zassert_equal(view.id_length, 1, "Invalid ID length");
+	zassert_equal(*nfc_ndef_record_view_id(&view), 'I', "Invalid ID");
+	zassert_mem_equal(nfc_ndef_record_view_payload(&view), &msg[20], 2, "Invalid payload");
+
+	nfc_ndef_record_view_desc_get(&view, &rec_desc, &bin_pay_desc);
+	zassert_equal(rec_desc.tnf, TNF_MEDIA_TYPE, "Invalid TNF");
+	zassert_equal_ptr(rec_desc.type, &msg[16], "Invalid type");
+	zassert_equal_ptr(rec_desc.id, &msg[19], "Invalid ID");
+	zassert_equal_ptr(rec_desc.payload_descriptor, &bin_pay_desc, "Invalid payload");
+	zassert_equal_ptr(bin_pay_desc.payload, &msg[20], "Invalid payload");
+
+	err = nfc_ndef_msg_iter_next(&iter, &view);
+	zassert_ok(err, "Third record not found");
+	zassert_equal(nfc_ndef_record_view_location(&view), NDEF_LAST_RECORD,
+		      "Invalid location");
+	zassert_equal(nfc_ndef_record_view_tnf(&view), TNF_EMPTY, "Invalid TNF");
+	zassert_is_null(nfc_ndef_record_view_type(&view), "Unexpected type");
+	zassert_is_null(nfc_ndef_record_view_payload(&view), "Unexpected payload");
+
+	err = nfc_ndef_msg_iter_next(&iter, &view);
+	zassert_equal(err, -ENOENT, "Trailing data parsed");
+	zassert_equal(nfc_ndef_msg_iter_parsed_len(&iter), sizeof(msg) - 2,
+		      "Invalid message length");
+}
+
+static void test_iter_errors(void)
+{
+	struct nfc_ndef_msg_iter iter;
+	struct nfc_ndef_record_view view;
+	uint32_t len;
+	uint32_t cnt;
+	static const uint8_t truncated[] = {0xD1, 0x01, 0x05, 'U', 0x04};
+	static const uint8_t no_mb[] = {0x51, 0x01, 0x00, 'U'};
+	static const uint8_t second_mb[] = {0x91, 0x01, 0x00, 'U', 0xD1, 0x01, 0x00, 'U'};
+	static const uint8_t no_me[] = {0x91, 0x01, 0x00, 'U', 0x11, 0x01, 0x00, 'U'};
+	/* Payload length that overflows the record size. */
+	static const uint8_t long_payload[] = {0xC1, 0x01, 0xFF, 0xFF, 0xFF, 0xFE, 'U'};
+	static const uint8_t valid[] = {0x91, 0x01, 0x00, 'U', 0x51, 0x01, 0x00, 'U', 0x00};
+
+	nfc_ndef_msg_iter_init(&iter, valid, 0);
+	zassert_equal(nfc_ndef_msg_iter_next(&iter, &view), -EFAULT, "Empty data accepted");
+
+	nfc_ndef_msg_iter_init(&iter, truncated, sizeof(truncated));
+	zassert_equal(nfc_ndef_msg_iter_next(&iter, &view), -EINVAL, "Truncated record");
+
+	nfc_ndef_msg_iter_init(&iter, no_mb, sizeof(no_mb));
+	zassert_equal(nfc_ndef_msg_iter_next(&iter, &view), -EFAULT, "Missing MB flag");
+
+	nfc_ndef_msg_iter_init(&iter, second_mb, sizeof(second_mb));
+	zassert_ok(nfc_ndef_msg_iter_next(&iter, &view), "First record not found");
+	zassert_equal(nfc_ndef_msg_iter_next(&iter, &view), -EFAULT, "Second MB flag");
+
+	nfc_ndef_msg_iter_init(&iter, no_me, sizeof(no_me));
+	zassert_ok(nfc_ndef_msg_iter_next(&iter, &view), "First record not found");
+	zassert_ok(nfc_ndef_msg_iter_next(&iter, &view), "Second record not found");
+	zassert_equal(nfc_ndef_msg_iter_next(&iter, &view), -EFAULT, "Missing ME flag");
+
+	nfc_ndef_msg_iter_init(&iter, long_payload, sizeof(long_payload));
+	zassert_equal(nfc_ndef_msg_iter_next(&iter, &view), -EINVAL, "Payload overflow");
+
+	len = sizeof(long_payload);
+	zassert_equal(nfc_ndef_msg_record_count(long_payload, &len, &cnt), -EINVAL,
+		      "Payload overflow");
+
+	len = sizeof(valid);
+	zassert_ok(nfc_ndef_msg_record_count(valid, &len, &cnt), "Valid message rejected");
+	zassert_equal(cnt, 2, "Invalid record count");
+	zassert_equal(len, sizeof(valid) - 1, "Invalid message length");
+
+	parsers_check(long_payload, sizeof(long_payload), -EINVAL, NULL, 0, 0);
+}
+
+static void test_fuzz_generated(void)
+{
+	struct test_record records[GEN_MAX_RECORDS];
+	size_t record_cnt;
+	size_t len;
+
+	rand_state = 0x6E646566;
+
+	for (uint32_t i = 0; i < FUZZ_GENERATED_ITERATIONS; i++) {
+		len = msg_generate(msg_buf, records, &record_cnt);
+
+		parsers_check(msg_buf, len, 0, records, record_cnt, len);
+	}
+}
+
+static void test_fuzz_mutated(void)
+{
+	struct test_record records[GEN_MAX_RECORDS];
+	size_t record_cnt;
+	uint32_t parsed_len;
+	uint32_t len;
+	uint32_t accepted = 0;
+	int err;
+
+	rand_state = 0x70617273;
+
+	for (uint32_t i = 0; i < FUZZ_MUTATED_ITERATIONS; i++) {
+		len = msg_generate(msg_buf, records, &record_cnt);
+
+		switch (test_rand_range(3)) {
+		case 0:
+			/* Random bytes. */
+			len = test_rand_range(64);
+			for (size_t j = 0; j < len; j++) {
+				msg_buf[j] = test_rand();
+			}
+			break;
+
+		case 1:
+			/* Truncated message. */
+			len = test_rand_range(len);
+			break;
+
+		default:
+			/* Corrupted header or length fields. */
+			for (size_t j = 0; j <= test_rand_range(FUZZ_MAX_MUTATIONS); j++) {
+				msg_buf[test_rand_range(MIN(len - 1, 16))] ^= BIT(test_rand() % 8);
+			}
+			break;
+		}
+
+		err = ref_parse(msg_buf, len, ref_records, &record_cnt, &parsed_len);
+		if (!err) {
+			accepted++;
+		}
+
+		parsers_check(msg_buf, len, err, ref_records, record_cnt, parsed_len);
+	}
+
+	TC_PRINT("Fuzzing: %u of %u mutated messages accepted\n", accepted,
+		 FUZZ_MUTATED_ITERATIONS);
+}
+
+static void test_parser_benchmark(void)
+{
+	int err;
+	size_t offset = 0;
+	uint32_t start;
+	uint32_t desc_cycles;
+	uint32_t iter_cycles;
+	uint32_t desc_sum = 0;
+	uint32_t iter_sum = 0;
+	struct nfc_ndef_msg_iter iter;
+	struct nfc_ndef_record_view view;
+
+	for (size_t i = 0; i < BENCH_RECORDS; i++) {
+		uint8_t *rec = &msg_buf[offset];
+
+		rec[0] = TNF_WELL_KNOWN | NDEF_RECORD_SR_MASK;
+		rec[0] |= (i == 0) ? FLAG_MB : 0;
+		rec[0] |= (i == (BENCH_RECORDS - 1)) ? FLAG_ME : 0;
+		rec[1] = 1;
+		rec[2] = BENCH_PAYLOAD_LEN;
+		rec[3] = 'T';
+		memset(&rec[4], i, BENCH_PAYLOAD_LEN);
+
+		offset += 4 + BENCH_PAYLOAD_LEN;
+	}
+
+	start = k_cycle_get_32();
+	for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+		struct nfc_ndef_msg_desc *msg_desc = (struct nfc_ndef_msg_desc *)desc_buf;
+		uint32_t desc_buf_len = NFC_NDEF_PARSER_REQUIRED_MEM(BENCH_RECORDS);
+		uint32_t len = offset;
+
+		err = nfc_ndef_msg_parse(desc_buf, &desc_buf_len, msg_buf, &len);
+		zassert_ok(err, "Parsing failed");
+
+		for (size_t j = 0; j < msg_desc->record_count; j++) {
+			const struct nfc_ndef_bin_payload_desc *bin_pay_desc =
+				msg_desc->record[j]->payload_descriptor;
+
+			desc_sum += bin_pay_desc->payload[0];
+		}
+	}
+	desc_cycles = k_cycle_get_32() - start;
+
+	start = k_cycle_get_32();
+	for (uint32_t i = 0; i < BENCH_ITERATIONS; i++) {
+		nfc_ndef_msg_iter_init(&iter, msg_buf, offset);
+
+		while ((err = nfc_ndef_msg_iter_next(&iter, &view)) == 0) {
+			iter_sum += nfc_ndef_record_view_payload(&view)[0];
+		}
+
+		zassert_equal(err, -ENOENT, "Parsing failed");
+	}
+	iter_cycles = k_cycle_get_32() - start;
+
+	zassert_equal(desc_sum, iter_sum, "Parsers returned different payloads");
+
+	TC_PRINT("%u records, %u iterations:\n", BENCH_RECORDS, BENCH_ITERATIONS);
+	TC_PRINT("  nfc_ndef_msg_parse: %u cycles, %zu bytes of descriptors\n",
+		 desc_cycles, (size_t)NFC_NDEF_PARSER_REQUIRED_MEM(BENCH_RECORDS));
+	TC_PRINT("  nfc_ndef_msg_iter:  %u cycles, %zu bytes of iterator state\n",
+		 iter_cycles, sizeof(iter) + sizeof(view));
+}
+
+void test_main(void)
+{
+	ztest_test_suite(nfc_ndef_parser_test,
+			 ztest_unit_test(test_iter_records),
+			 ztest_unit_test(test_iter_errors),
+			 ztest_unit_test(test_fuzz_generated),
+			 ztest_unit_test(test_fuzz_mutated),
+			 ztest_unit_test(test_parser_benchmark)
+			 );
+
+	ztest_run_test_suite(nfc_ndef_parser_test);
+}
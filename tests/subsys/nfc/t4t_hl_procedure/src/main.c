@@ -0,0 +1,594 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <ztest.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/byteorder.h>
+#include <zephyr/sys/util.h>
+#include <nfc/t4t/hl_procedure.h>
+#include <nfc/t4t/isodep.h>
+#include <nfc/t4t/cc_file.h>
+
+#define CC_FILE_ID 0xE103
+#define NDEF_FILE_ID 0xE104
+#define NDEF_FILE_MAX_SIZE 0x2000
+#define NLEN_SIZE 2
+#define MAX_TLV_BLOCKS 1
+
+/* Frame sizes of the reader (FSD) and the simulated tag (FSC), without CRC. */
+#define FRAME_SIZE 256
+#define CRC_SIZE 2
+#define ISODEP_RX_BUF_SIZE 4096
+#define APDU_BUF_SIZE (ISODEP_RX_BUF_SIZE + NLEN_SIZE)
+
+#define PCB_I_BLOCK 0x02
+#define PCB_R_ACK 0xA2
+#define PCB_CHAINING BIT(4)
+#define PCB_BLOCK_NUM BIT(0)
+#define PCB_TYPE_MASK 0xE6
+#define RATS_CMD 0xE0
+
+#define INS_SELECT 0xA4
+#define INS_READ 0xB0
+#define INS_UPDATE 0xD6
+#define SW_OK 0x9000
+#define SW_NOT_FOUND 0x6A82
+#define SW_INS_NOT_SUPPORTED 0x6D00
+
+/* Rough air time model at 106 kbit/s: 9 bits per byte including parity, and a fixed
+ * frame delay time and frame start and end overhead per frame. The tag needs some time
+ * to process every command.
+ */
+#define BYTE_TIME_US 85
+#define FRAME_OVERHEAD_US 200
+#define APDU_PROCESSING_US 1000
+
+#define SHORT_APDU_MAX 0xFF
+#define UPDATE_HEADER_SHORT 5
+#define UPDATE_HEADER_LONG 7
+
+#define PROCEDURE_TIMEOUT_MS 10000
+
+struct sim_tag {
+	uint8_t cc[15];
+	uint8_t ndef[NDEF_FILE_MAX_SIZE];
+	const uint8_t *file;
+	uint8_t *file_writable;
+	size_t file_size;
+	uint16_t mle;
+	uint16_t mlc;
+	uint8_t capdu[APDU_BUF_SIZE];
+	size_t capdu_len;
+	uint8_t rapdu[APDU_BUF_SIZE];
+	size_t rapdu_len;
+	size_t rapdu_sent;
+	uint8_t block_num;
+};
+
+struct sim_stats {
+	uint32_t apdus;
+	uint32_t frames;
+	uint32_t air_time_us;
+};
+
+NFC_T4T_CC_DESC_DEF(t4t_cc, MAX_TLV_BLOCKS);
+
+static struct sim_tag tag;
+static struct sim_stats stats;
+
+static uint8_t isodep_tx_buf[FRAME_SIZE];
+static uint8_t isodep_rx_buf[ISODEP_RX_BUF_SIZE];
+
+static uint8_t reader_frame[FRAME_SIZE];
+static size_t reader_frame_len;
+static bool reader_frame_pending;
+
+static uint8_t ndef_buf[NDEF_FILE_MAX_SIZE];
+static uint8_t ndef_msg[NDEF_FILE_MAX_SIZE];
+
+static bool isodep_selected;
+static bool hl_selected;
+static bool cc_read;
+static bool ndef_read;
+static bool ndef_updated;
+static size_t ndef_read_len;
+static int hl_err;
+
+static void frame_account(size_t len)
+{
+	stats.frames++;
+	stats.air_time_us += (len + CRC_SIZE) * BYTE_TIME_US + FRAME_OVERHEAD_US;
+}
+
+static void tag_send(const uint8_t *data, size_t len)
+{
+	int err;
+
+	frame_account(len);
+
+	err = nfc_t4t_isodep_data_received(data, len, 0);
+	zassert_ok(err, "ISO-DEP frame handling failed: %d", err);
+}
+
+static void tag_rapdu_chunk_send(void)
+{
+	uint8_t frame[FRAME_SIZE - CRC_SIZE];
+	size_t chunk = MIN(tag.rapdu_len - tag.rapdu_sent, sizeof(frame) - 1);
+
+	frame[0] = PCB_I_BLOCK | tag.block_num;
+	if (tag.rapdu_sent + chunk < tag.rapdu_len) {
+		frame[0] |= PCB_CHAINING;
+	}
+
+	memcpy(&frame[1], &tag.rapdu[tag.rapdu_sent], chunk);
+	tag.rapdu_sent += chunk;
+
+	tag_send(frame, chunk + 1);
+}
+
+static void tag_status_set(uint16_t status)
+{
+	sys_put_be16(status, &tag.rapdu[tag.rapdu_len]);
+	tag.rapdu_len += sizeof(status);
+}
+
+static void tag_file_select(const uint8_t *data, size_t len)
+{
+	uint16_t id;
+
+	if (len != sizeof(id)) {
+		/* NDEF Tag Application selected by name. */
+		tag_status_set(SW_OK);
+		return;
+	}
+
+	id = sys_get_be16(data);
+
+	if (id == CC_FILE_ID) {
+		tag.file = tag.cc;
+		tag.file_writable = NULL;
+		tag.file_size = sizeof(tag.cc);
+	} else if (id == NDEF_FILE_ID) {
+		tag.file = tag.ndef;
+		tag.file_writable = tag.ndef;
+		tag.file_size = sizeof(tag.ndef);
+	} else {
+		tag_status_set(SW_NOT_FOUND);
+		return;
+	}
+
+	tag_status_set(SW_OK);
+}
+
+static void tag_capdu_process(void)
+{
+	const uint8_t *capdu = tag.capdu;
+	uint16_t offset = sys_get_be16(&capdu[2]);
+	size_t body_len = tag.capdu_len - 4;
+	const uint8_t *body = &capdu[4];
+	uint32_t le;
+	uint32_t lc;
+
+	stats.apdus++;
+	stats.air_time_us += APDU_PROCESSING_US;
+
+	tag.rapdu_len = 0;
+	tag.rapdu_sent = 0;
+
+	switch (capdu[1]) {
+	case INS_SELECT:
+		zassert_true(body_len > 1, "Invalid SELECT command");
+		tag_file_select(&body[1], body[0]);
+		break;
+
+	case INS_READ:
+		if (body_len == 1) {
+			le = body[0] ? body[0] : 256;
+		} else {
+			zassert_equal(body_len, 3, "Invalid READ BINARY Le field");
+			zassert_equal(body[0], 0, "Invalid extended Le field");
+			le = sys_get_be16(&body[1]);
+			zassert_true(le > 256, "Extended Le used for short length");
+		}
+
+		zassert_true(le <= tag.mle, "Le %u above MLe %u", le, tag.mle);
+		zassert_not_null(tag.file, "No file selected");
+		zassert_true(offset < tag.file_size, "Read outside of the file");
+
+		le = MIN(le, tag.file_size - offset);
+		memcpy(tag.rapdu, &tag.file[offset], le);
+		tag.rapdu_len = le;
+		tag_status_set(SW_OK);
+		break;
+
+	case INS_UPDATE:
+		if (body[0]) {
+			lc = body[0];
+			body++;
+			body_len--;
+		} else {
+			lc = sys_get_be16(&body[1]);
+			zassert_true(lc > SHORT_APDU_MAX, "Extended Lc used for short length");
+			body += 3;
+			body_len -= 3;
+		}
+
+		zassert_equal(lc, body_len, "Invalid UPDATE BINARY Lc field");
+		zassert_true(lc <= tag.mlc, "Lc %u above MLc %u", lc, tag.mlc);
+		zassert_not_null(tag.file_writable, "File not writable");
+		zassert_true(offset + lc <= tag.file_size, "Write outside of the file");
+
+		memcpy(&tag.file_writable[offset], body, lc);
+		tag_status_set(SW_OK);
+		break;
+
+	default:
+		tag_status_set(SW_INS_NOT_SUPPORTED);
+		break;
+	}
+
+	tag_rapdu_chunk_send();
+}
+
+static void tag_frame_process(void)
+{
+	static const uint8_t ats[] = {0x05, 0x78, 0x00, 0x00, 0x00};
+	uint8_t pcb = reader_frame[0];
+	uint8_t ack;
+
+	reader_frame_pending = false;
+
+	if (pcb == RATS_CMD) {
+		tag.block_num = 0;
+		tag_send(ats, sizeof(ats));
+		return;
+	}
+
+	tag.block_num = pcb & PCB_BLOCK_NUM;
+
+	if ((pcb & PCB_TYPE_MASK) == PCB_I_BLOCK) {
+		zassert_true(tag.capdu_len + reader_frame_len - 1 <= sizeof(tag.capdu),
+			     "C-APDU too long");
+
+		memcpy(&tag.capdu[tag.capdu_len], &reader_frame[1], reader_frame_len - 1);
+		tag.capdu_len += reader_frame_len - 1;
+
+		if (pcb & PCB_CHAINING) {
+			ack = PCB_R_ACK | tag.block_num;
+			tag_send(&ack, sizeof(ack));
+		} else {
+			tag_capdu_process();
+			tag.capdu_len = 0;
+		}
+	} else if ((pcb & PCB_TYPE_MASK) == PCB_R_ACK) {
+		zassert_true(tag.rapdu_sent < tag.rapdu_len, "Unexpected R(ACK)");
+		tag_rapdu_chunk_send();
+	} else {
+		zassert_unreachable("Unexpected frame 0x%02x", pcb);
+	}
+}
+
+static void run_until(const bool *done)
+{
+	int64_t start = k_uptime_get();
+
+	while (!*done && !hl_err) {
+		if (reader_frame_pending) {
+			tag_frame_process();
+		} else {
+			k_sleep(K_MSEC(1));
+		}
+
+		zassert_true(k_uptime_get() - start < PROCEDURE_TIMEOUT_MS,
+			     "Procedure timed out");
+	}
+}
+
+static void isodep_data_received(const uint8_t *data, size_t data_len)
+{
+	int err = nfc_t4t_hl_procedure_on_data_received(data, data_len);
+
+	if (err) {
+		hl_err = err;
+	}
+}
+
+static void isodep_selected_cb(const struct nfc_t4t_isodep_tag *t4t_tag)
+{
+	isodep_selected = true;
+}
+
+static void isodep_ready_to_send(uint8_t *data, size_t data_len, uint32_t ftd)
+{
+	zassert_false(reader_frame_pending, "Reader frame overrun");
+	zassert_true(data_len <= sizeof(reader_frame), "Reader frame too long");
+
+	memcpy(reader_frame, data, data_len);
+	reader_frame_len = data_len;
+	reader_frame_pending = true;
+
+	frame_account(data_len);
+}
+
+static void isodep_error(int err)
+{
+	hl_err = err;
+}
+
+static const struct nfc_t4t_isodep_cb isodep_cb = {
+	.data_received = isodep_data_received,
+	.selected = isodep_selected_cb,
+	.ready_to_send = isodep_ready_to_send,
+	.error = isodep_error,
+};
+
+static void hl_selected_cb(enum nfc_t4t_hl_procedure_select type)
+{
+	hl_selected = true;
+}
+
+static void hl_cc_read(struct nfc_t4t_cc_file *cc)
+{
+	cc_read = true;
+}
+
+static void hl_ndef_read(uint16_t file_id, const uint8_t *data, size_t len)
+{
+	zassert_equal(file_id, NDEF_FILE_ID, "Invalid file ID");
+	ndef_read_len = len;
+	ndef_read = true;
+}
+
+static void hl_ndef_updated(uint16_t file_id)
+{
+	zassert_equal(file_id, NDEF_FILE_ID, "Invalid file ID");
+	ndef_updated = true;
+}
+
+static const struct nfc_t4t_hl_procedure_cb hl_cb = {
+	.selected = hl_selected_cb,
+	.cc_read = hl_cc_read,
+	.ndef_read = hl_ndef_read,
+	.ndef_updated = hl_ndef_updated,
+};
+
+static uint16_t read_chunk_len(void)
+{
+#if defined(CONFIG_NFC_T4T_HL_PROCEDURE_BULK)
+	return MIN(CONFIG_NFC_T4T_HL_PROCEDURE_BULK_RAPDU_SIZE, tag.mle);
+#else
+	return MIN(SHORT_APDU_MAX, tag.mle);
+#endif
+}
+
+static uint16_t update_chunk_len(void)
+{
+	size_t len = CONFIG_NFC_T4T_HL_PROCEDURE_APDU_BUF_SIZE - UPDATE_HEADER_SHORT;
+
+	if (len > SHORT_APDU_MAX) {
+		len = IS_ENABLED(CONFIG_NFC_T4T_HL_PROCEDURE_BULK) ?
+		      (CONFIG_NFC_T4T_HL_PROCEDURE_APDU_BUF_SIZE - UPDATE_HEADER_LONG) :
+		      SHORT_APDU_MAX;
+	}
+
+	return MIN(len, tag.mlc);
+}
+
+static void tag_setup(uint16_t mle, uint16_t mlc, size_t ndef_len)
+{
+	uint8_t *cc = tag.cc;
+
+	memset(&tag, 0, sizeof(tag));
+	tag.mle = mle;
+	tag.mlc = mlc;
+
+	/* Mapping version 2.0 CC with one NDEF File Control TLV. */
+	sys_put_be16(sizeof(tag.cc), &cc[0]);
+	cc[2] = 0x20;
+	sys_put_be16(mle, &cc[3]);
+	sys_put_be16(mlc, &cc[5]);
+	cc[7] = NFC_T4T_TLV_BLOCK_TYPE_NDEF_FILE_CONTROL_TLV;
+	cc[8] = 6;
+	sys_put_be16(NDEF_FILE_ID, &cc[9]);
+	sys_put_be16(NDEF_FILE_MAX_SIZE, &cc[11]);
+	cc[13] = 0x00;
+	cc[14] = 0x00;
+
+	sys_put_be16(ndef_len - NLEN_SIZE, tag.ndef);
+	for (size_t i = NLEN_SIZE; i < ndef_len; i++) {
+		tag.ndef[i] = i * 7;
+	}
+
+	/* Garbage after the NDEF message must not be read. */
+	memset(&tag.ndef[ndef_len], 0xEE, sizeof(tag.ndef) - ndef_len);
+}
+
+static void tag_activate(void)
+{
+	int err;
+
+	reader_frame_pending = false;
+	isodep_selected = false;
+	hl_err = 0;
+
+	err = nfc_t4t_isodep_rats_send(NFC_T4T_ISODEP_FSD_256, 0);
+	zassert_ok(err, "RATS send failed: %d", err);
+	run_until(&isodep_selected);
+
+	hl_selected = false;
+	zassert_ok(nfc_t4t_hl_procedure_ndef_tag_app_select(), "App select failed");
+	run_until(&hl_selected);
+
+	hl_selected = false;
+	zassert_ok(nfc_t4t_hl_procedure_cc_select(), "CC select failed");
+	run_until(&hl_selected);
+
+	cc_read = false;
+	zassert_ok(nfc_t4t_hl_procedure_cc_read(&NFC_T4T_CC_DESC(t4t_cc)), "CC read failed");
+	run_until(&cc_read);
+
+	hl_selected = false;
+	zassert_ok(nfc_t4t_hl_procedure_ndef_file_select(NDEF_FILE_ID), "NDEF select failed");
+	run_until(&hl_selected);
+
+	zassert_ok(hl_err, "Tag activation failed: %d", hl_err);
+}
+
+static uint32_t expected_read_apdus(size_t ndef_len)
+{
+	uint16_t chunk = read_chunk_len();
+
+#if defined(CONFIG_NFC_T4T_HL_PROCEDURE_BULK)
+	/* NLEN is read together with the first part of the NDEF message. */
+	size_t first = MIN(chunk, CONFIG_NFC_T4T_HL_PROCEDURE_BULK_FIRST_READ_SIZE);
+
+	if (first >= ndef_len) {
+		return 1;
+	}
+
+	return 1 + ceiling_fraction(ndef_len - first, chunk);
+#else
+	return 1 + ceiling_fraction(ndef_len - NLEN_SIZE, chunk);
+#endif
+}
+
+static uint32_t expected_update_apdus(size_t ndef_len)
+{
+	uint16_t chunk = update_chunk_len();
+
+	if (!IS_ENABLED(CONFIG_NFC_T4T_HL_PROCEDURE_BULK)) {
+		/* NLEN clear, NDEF message and NLEN update. */
+		return 2 + ceiling_fraction(ndef_len - NLEN_SIZE, chunk);
+	}
+
+	return 1 + ceiling_fraction(ndef_len, chunk);
+}
+
+static void ndef_read_check(uint16_t mle, uint16_t mlc, size_t ndef_len)
+{
+	int err;
+
+	tag_setup(mle, mlc, ndef_len);
+	tag_activate();
+
+	memset(ndef_buf, 0, sizeof(ndef_buf));
+	memset(&stats, 0, sizeof(stats));
+	ndef_read = false;
+
+	err = nfc_t4t_hl_procedure_ndef_read(&NFC_T4T_CC_DESC(t4t_cc), ndef_buf,
+					     sizeof(ndef_buf));
+	zassert_ok(err, "NDEF read failed: %d", err);
+	run_until(&ndef_read);
+
+	zassert_ok(hl_err, "NDEF read procedure failed: %d", hl_err);
+	zassert_equal(ndef_read_len, ndef_len, "Invalid NDEF file length");
+	zassert_mem_equal(ndef_buf, tag.ndef, ndef_len, "Invalid NDEF file");
+	zassert_equal(stats.apdus, expected_read_apdus(ndef_len),
+		      "Unexpected number of APDUs: %u", stats.apdus);
+
+	TC_PRINT("NDEF read %5zu B, MLe %4u: %3u APDUs, %3u frames, %4u ms\n",
+		 ndef_len, mle, stats.apdus, stats.frames, stats.air_time_us / USEC_PER_MSEC);
+}
+
+static void ndef_update_check(uint16_t mle, uint16_t mlc, size_t ndef_len)
+{
+	int err;
+
+	tag_setup(mle, mlc, NLEN_SIZE);
+	tag_activate();
+
+	sys_put_be16(ndef_len - NLEN_SIZE, ndef_msg);
+	for (size_t i = NLEN_SIZE; i < ndef_len; i++) {
+		ndef_msg[i] = i * 13;
+	}
+
+	memset(&stats, 0, sizeof(stats));
+	ndef_updated = false;
+
+	err = nfc_t4t_hl_procedure_ndef_update(&NFC_T4T_CC_DESC(t4t_cc), ndef_msg, ndef_len);
+	zassert_ok(err, "NDEF update failed: %d", err);
+	run_until(&ndef_updated);
+
+	zassert_ok(hl_err, "NDEF update procedure failed: %d", hl_err);
+	zassert_mem_equal(tag.ndef, ndef_msg, ndef_len, "Invalid NDEF file");
+	zassert_equal(stats.apdus, expected_update_apdus(ndef_len),
+		      "Unexpected number of APDUs: %u", stats.apdus);
+
+	TC_PRINT("NDEF update %5zu B, MLc %4u: %3u APDUs, %3u frames, %4u ms\n",
+		 ndef_len, mlc, stats.apdus, stats.frames, stats.air_time_us / USEC_PER_MSEC);
+}
+
+static const size_t ndef_lens[] = {NLEN_SIZE, 16, 255, 1024, 4096, NDEF_FILE_MAX_SIZE};
+
+static void test_ndef_read(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(ndef_lens); i++) {
+		ndef_read_check(SHORT_APDU_MAX, SHORT_APDU_MAX, ndef_lens[i]);
+	}
+}
+
+static void test_ndef_update(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(ndef_lens); i++) {
+		ndef_update_check(SHORT_APDU_MAX, SHORT_APDU_MAX, ndef_lens[i]);
+	}
+}
+
+static void test_ndef_small_mle_mlc(void)
+{
+	ndef_read_check(0x3B, 0x34, 1024);
+	ndef_update_check(0x3B, 0x34, 1024);
+}
+
+static void test_ndef_large_mle_mlc(void)
+{
+	/* Extended-length APDUs are used only if the configuration allows them. */
+	for (size_t i = 0; i < ARRAY_SIZE(ndef_lens); i++) {
+		ndef_read_check(0x0800, 0x0800, ndef_lens[i]);
+		ndef_update_check(0x0800, 0x0800, ndef_lens[i]);
+	}
+}
+
+static void test_ndef_read_buffer_too_small(void)
+{
+	int err;
+	size_t ndef_len = 1024;
+
+	tag_setup(SHORT_APDU_MAX, SHORT_APDU_MAX, ndef_len);
+	tag_activate();
+
+	ndef_read = false;
+
+	err = nfc_t4t_hl_procedure_ndef_read(&NFC_T4T_CC_DESC(t4t_cc), ndef_buf,
+					     ndef_len - 1);
+	zassert_ok(err, "NDEF read failed: %d", err);
+	run_until(&ndef_read);
+
+	zassert_false(ndef_read, "NDEF read must fail");
+	zassert_equal(hl_err, -ENOMEM, "Unexpected error: %d", hl_err);
+}
+
+void test_main(void)
+{
+	int err;
+
+	err = nfc_t4t_isodep_init(isodep_tx_buf, sizeof(isodep_tx_buf),
+				  isodep_rx_buf, sizeof(isodep_rx_buf), &isodep_cb);
+	zassert_ok(err, "ISO-DEP init failed: %d", err);
+
+	err = nfc_t4t_hl_procedure_cb_register(&hl_cb);
+	zassert_ok(err, "HL procedure callback register failed: %d", err);
+
+	ztest_test_suite(nfc_t4t_hl_procedure_test,
+			 ztest_unit_test(test_ndef_read),
+			 ztest_unit_test(test_ndef_update),
+			 ztest_unit_test(test_ndef_small_mle_mlc),
+			 ztest_unit_test(test_ndef_large_mle_mlc),
+			 ztest_unit_test(test_ndef_read_buffer_too_small)
+			 );
+
+	ztest_run_test_suite(nfc_t4t_hl_procedure_test);
+}
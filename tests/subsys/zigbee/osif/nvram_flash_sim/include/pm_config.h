@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef PM_CONFIG_H__
+#define PM_CONFIG_H__
+
+#include <zephyr/storage/flash_map.h>
+
+/* ZBOSS NVRAM is placed in the storage partition of the flash simulator. */
+#define PM_ZBOSS_NVRAM_ID FLASH_AREA_ID(storage)
+#define PM_ZBOSS_NVRAM_SIZE FLASH_AREA_SIZE(storage)
+
+#endif /* PM_CONFIG_H__ */
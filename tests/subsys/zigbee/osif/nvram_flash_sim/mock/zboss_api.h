@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef ZBOSS_API_H__
+#define ZBOSS_API_H__
+
+#include <stdint.h>
+#include <string.h>
+
+/* Subset of the ZBOSS API used by the NVRAM osif. */
+#define ZB_USE_NVRAM
+
+typedef char zb_char_t;
+typedef uint8_t zb_uint8_t;
+typedef uint16_t zb_uint16_t;
+typedef uint32_t zb_uint32_t;
+typedef int32_t zb_ret_t;
+typedef void (*zb_callback_t)(zb_uint8_t param);
+
+#define RET_OK 0
+#define RET_ERROR (-1)
+#define RET_INVALID_PARAMETER (-4)
+#define RET_INVALID_PARAMETER_3 (-12)
+#define RET_INVALID_PARAMETER_4 (-13)
+#define RET_PAGE_NOT_FOUND (-25)
+
+void zb_osif_nvram_init(const zb_char_t *name);
+zb_uint32_t zb_get_nvram_page_length(void);
+zb_uint8_t zb_get_nvram_page_count(void);
+zb_ret_t zb_osif_nvram_read(zb_uint8_t page, zb_uint32_t pos, zb_uint8_t *buf,
+			    zb_uint16_t len);
+zb_ret_t zb_osif_nvram_write(zb_uint8_t page, zb_uint32_t pos, void *buf,
+			     zb_uint16_t len);
+zb_ret_t zb_osif_nvram_erase_async(zb_uint8_t page);
+void zb_osif_nvram_wait_for_last_op(void);
+void zb_osif_nvram_flush(void);
+
+zb_ret_t zigbee_schedule_callback(zb_callback_t func, zb_uint8_t param);
+
+#endif /* ZBOSS_API_H__ */
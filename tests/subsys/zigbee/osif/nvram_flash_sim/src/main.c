@@ -0,0 +1,422 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/storage/flash_map.h>
+#include <zephyr/sys/util.h>
+#include <ztest.h>
+#include <pm_config.h>
+#include <zboss_api.h>
+
+#include <string.h>
+
+LOG_MODULE_REGISTER(zboss_osif, CONFIG_ZBOSS_OSIF_LOG_LEVEL);
+
+#define ZBOSS_NVRAM_PAGE_SIZE (PM_ZBOSS_NVRAM_SIZE / CONFIG_ZIGBEE_NVRAM_PAGE_COUNT)
+#define PHYSICAL_PAGE_SIZE 0x1000
+
+/* Flash timing of nRF52 devices: writes block the CPU for 41 us per word,
+ * and each flash operation waits for a radio timeslot. Page erase takes
+ * 85 ms, during which the calling thread sleeps.
+ */
+#define WRITE_CALL_US 200
+#define WRITE_WORD_US 41
+#define ERASE_PAGE_MS 85
+
+/* ZBOSS-like dataset: a header followed by table entries of varying size. */
+#define DATASET_HDR_SIZE 8
+#define DATASET_COUNT 12
+#define DATASET_ENTRY_COUNT 16
+
+/* Time the ZBOSS thread is idle between datasets, waiting for radio events */
+#define STACK_IDLE_MS 40
+
+static const uint8_t entry_sizes[] = { 4, 8, 12, 16, 24, 32 };
+
+static uint8_t mirror[CONFIG_ZIGBEE_NVRAM_PAGE_COUNT][ZBOSS_NVRAM_PAGE_SIZE];
+static uint8_t read_buf[PHYSICAL_PAGE_SIZE];
+static uint8_t entry[64];
+
+static size_t write_calls;
+static size_t erase_calls;
+static int64_t stall_us;
+static int erased_page = -1;
+static size_t erase_finished_calls;
+static k_tid_t zboss_thread;
+static int erase_error;
+static bool in_callback;
+
+struct zb_callback {
+	zb_callback_t func;
+	zb_uint8_t param;
+};
+
+/* Callbacks scheduled from other threads go through the bounded application
+ * callback queue, the ones scheduled from the ZBOSS thread are put directly
+ * into the ZBOSS scheduler queue.
+ */
+K_MSGQ_DEFINE(callback_msgq, sizeof(struct zb_callback), 4, 4);
+K_MSGQ_DEFINE(scheduler_msgq, sizeof(struct zb_callback), 8, 4);
+
+int flash_area_write_traced(const struct flash_area *fa, off_t off, const void *src,
+			    size_t len);
+int flash_area_erase_traced(const struct flash_area *fa, off_t off, size_t len);
+
+static uint32_t write_time_us(size_t len)
+{
+	return WRITE_CALL_US + DIV_ROUND_UP(len, 4) * WRITE_WORD_US;
+}
+
+int flash_area_write_traced(const struct flash_area *fa, off_t off, const void *src,
+			    size_t len)
+{
+	write_calls++;
+	k_busy_wait(write_time_us(len));
+
+	return flash_area_write(fa, off, src, len);
+}
+
+int flash_area_erase_traced(const struct flash_area *fa, off_t off, size_t len)
+{
+	erase_calls++;
+	k_sleep(K_MSEC(ERASE_PAGE_MS * len / PHYSICAL_PAGE_SIZE));
+
+	if (erase_error) {
+		return erase_error;
+	}
+
+	return flash_area_erase(fa, off, len);
+}
+
+zb_ret_t zigbee_schedule_callback(zb_callback_t func, zb_uint8_t param)
+{
+	struct zb_callback cb = {
+		.func = func,
+		.param = param,
+	};
+
+	struct k_msgq *msgq = (k_current_get() == zboss_thread) ? &scheduler_msgq :
+								 &callback_msgq;
+
+	return k_msgq_put(msgq, &cb, K_NO_WAIT) ? RET_ERROR : RET_OK;
+}
+
+/* Run the scheduled callbacks, like the ZBOSS main loop does. */
+static void run_callbacks(void)
+{
+	struct zb_callback cb;
+
+	while ((k_msgq_get(&scheduler_msgq, &cb, K_NO_WAIT) == 0) ||
+	       (k_msgq_get(&callback_msgq, &cb, K_NO_WAIT) == 0)) {
+		in_callback = true;
+		cb.func(cb.param);
+		in_callback = false;
+	}
+}
+
+static void dummy_callback(zb_uint8_t param)
+{
+	ARG_UNUSED(param);
+}
+
+/* ZBOSS callout */
+void zb_nvram_erase_finished(zb_uint8_t page)
+{
+	zassert_equal(k_current_get(), zboss_thread, "Callout not in ZBOSS thread");
+	zassert_true(in_callback, "Callout not from a scheduled callback");
+
+	erased_page = page;
+	erase_finished_calls++;
+}
+
+static int64_t time_us(void)
+{
+	return k_ticks_to_us_floor64(k_uptime_ticks());
+}
+
+static void nvram_write(zb_uint8_t page, zb_uint32_t pos, void *buf, zb_uint16_t len)
+{
+	int64_t start = time_us();
+	zb_ret_t ret = zb_osif_nvram_write(page, pos, buf, len);
+
+	stall_us += time_us() - start;
+	zassert_equal(ret, RET_OK, "Write failed: %d", ret);
+
+	memcpy(&mirror[page][pos], buf, len);
+}
+
+static void nvram_flush(void)
+{
+	int64_t start = time_us();
+
+	zb_osif_nvram_flush();
+	stall_us += time_us() - start;
+}
+
+static void nvram_erase(zb_uint8_t page)
+{
+	int64_t start = time_us();
+	zb_ret_t ret = zb_osif_nvram_erase_async(page);
+
+	stall_us += time_us() - start;
+	zassert_equal(ret, RET_OK, "Erase failed: %d", ret);
+
+	memset(mirror[page], 0xFF, sizeof(mirror[page]));
+}
+
+static void nvram_wait_for_last_op(void)
+{
+	int64_t start = time_us();
+
+	zb_osif_nvram_wait_for_last_op();
+	stall_us += time_us() - start;
+}
+
+static void verify_page(zb_uint8_t page)
+{
+	for (zb_uint32_t pos = 0; pos < ZBOSS_NVRAM_PAGE_SIZE; pos += sizeof(read_buf)) {
+		zb_ret_t ret = zb_osif_nvram_read(page, pos, read_buf, sizeof(read_buf));
+
+		zassert_equal(ret, RET_OK, "Read failed: %d", ret);
+		zassert_mem_equal(read_buf, &mirror[page][pos], sizeof(read_buf),
+				  "Page %u mismatch at %u", page, pos);
+	}
+}
+
+/* Write datasets to the page like ZBOSS does. Returns the number of ZBOSS
+ * write calls and adds the flash time they would take when written to flash
+ * one by one.
+ */
+static size_t write_datasets(zb_uint8_t page, zb_uint32_t *pos, size_t count, bool idle,
+			     uint32_t *direct_time_us)
+{
+	size_t writes = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		memset(entry, 0xD0 + i, DATASET_HDR_SIZE);
+		nvram_write(page, *pos, entry, DATASET_HDR_SIZE);
+		*pos += DATASET_HDR_SIZE;
+		*direct_time_us += write_time_us(DATASET_HDR_SIZE);
+		writes++;
+
+		for (size_t j = 0; j < DATASET_ENTRY_COUNT; j++) {
+			size_t len = entry_sizes[(i + j) % ARRAY_SIZE(entry_sizes)];
+
+			for (size_t k = 0; k < len; k++) {
+				entry[k] = (uint8_t)(i * 31 + j * 7 + k);
+			}
+
+			nvram_write(page, *pos, entry, len);
+			*pos += len;
+			*direct_time_us += write_time_us(len);
+			writes++;
+		}
+
+		nvram_flush();
+
+		if (idle) {
+			k_sleep(K_MSEC(STACK_IDLE_MS));
+			run_callbacks();
+		}
+	}
+
+	return writes;
+}
+
+static void reset_stats(void)
+{
+	write_calls = 0;
+	erase_calls = 0;
+	stall_us = 0;
+	erase_finished_calls = 0;
+	erased_page = -1;
+	zboss_thread = k_current_get();
+}
+
+static void test_nvram_write_combining(void)
+{
+	uint32_t direct_time_us = 0;
+	zb_uint32_t pos = 0;
+	size_t writes;
+
+	reset_stats();
+	nvram_erase(0);
+	nvram_wait_for_last_op();
+	run_callbacks();
+	reset_stats();
+
+	writes = write_datasets(0, &pos, DATASET_COUNT, false, &direct_time_us);
+	zassert_true(pos <= PHYSICAL_PAGE_SIZE, "Trace does not fit the test page");
+
+	verify_page(0);
+
+	TC_PRINT("%zu ZBOSS writes of %u bytes: %zu flash writes\n", writes, pos, write_calls);
+	TC_PRINT("Write stall: %lld us (%u us with a flash write per ZBOSS write)\n",
+		 (long long)stall_us, direct_time_us);
+
+	/* Each dataset is flushed separately, in at most two buffer writes */
+	zassert_true(write_calls <= 2 * DATASET_COUNT + pos / CONFIG_ZIGBEE_NVRAM_WRITE_BUF_SIZE,
+		     "Writes not combined: %zu", write_calls);
+	zassert_true(stall_us < direct_time_us, "Write stall not reduced");
+}
+
+static void test_nvram_read_buffered(void)
+{
+	const uint8_t data[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88 };
+	/* Past the datasets written by the previous test */
+	zb_uint32_t pos = PHYSICAL_PAGE_SIZE - 512;
+	zb_ret_t ret;
+
+	reset_stats();
+
+	nvram_write(0, pos, (void *)data, sizeof(data));
+
+	/* Buffered data is visible before the flush. */
+	ret = zb_osif_nvram_read(0, pos, read_buf, sizeof(data));
+	zassert_equal(ret, RET_OK, "Read failed: %d", ret);
+	zassert_mem_equal(read_buf, data, sizeof(data), "Buffered data not read");
+
+	/* Non-contiguous writes are not combined. */
+	nvram_write(0, pos + 64, (void *)data, sizeof(data));
+	nvram_write(0, pos + 16, (void *)data, sizeof(data));
+	nvram_flush();
+
+	verify_page(0);
+}
+
+static void test_nvram_erase_async(void)
+{
+	uint32_t direct_time_us = 0;
+	uint32_t erase_time_ms = ERASE_PAGE_MS * zb_get_nvram_page_length() /
+				 PHYSICAL_PAGE_SIZE;
+	zb_uint32_t pos = 0;
+
+	reset_stats();
+	nvram_erase(1);
+	nvram_wait_for_last_op();
+	run_callbacks();
+	reset_stats();
+
+	/* Migration: datasets are written to the new page, then the old page
+	 * is erased while the stack keeps running.
+	 */
+	write_datasets(1, &pos, DATASET_COUNT / 2, true, &direct_time_us);
+	nvram_erase(0);
+	zassert_equal(erase_finished_calls, 0, "Erase not asynchronous");
+
+	write_datasets(1, &pos, DATASET_COUNT / 2, true, &direct_time_us);
+	nvram_wait_for_last_op();
+	run_callbacks();
+
+	zassert_equal(erase_calls, 1, "Unexpected erase count: %zu", erase_calls);
+	zassert_equal(erase_finished_calls, 1, "ZBOSS not notified");
+	zassert_equal(erased_page, 0, "Wrong page erased: %d", erased_page);
+
+	verify_page(0);
+	verify_page(1);
+
+	TC_PRINT("Migration stall: %lld us (%u us with synchronous erase and a flash write "
+		 "per ZBOSS write)\n", (long long)stall_us, erase_time_ms * 1000 + direct_time_us);
+
+	zassert_true(stall_us < erase_time_ms * 1000, "Erase stalled the stack");
+}
+
+static void test_nvram_erase_read_waits(void)
+{
+	zb_ret_t ret;
+
+	reset_stats();
+
+	/* A read of the page being erased waits for the erase to complete. */
+	nvram_erase(1);
+	ret = zb_osif_nvram_read(1, 0, read_buf, sizeof(read_buf));
+	zassert_equal(ret, RET_OK, "Read failed: %d", ret);
+	zassert_equal(erase_finished_calls, 0, "ZBOSS notified within NVRAM call");
+
+	run_callbacks();
+	zassert_equal(erase_finished_calls, 1, "ZBOSS not notified");
+
+	for (size_t i = 0; i < sizeof(read_buf); i++) {
+		zassert_equal(read_buf[i], 0xFF, "Page not erased");
+	}
+
+	/* Waiting without a pending operation does not block. */
+	reset_stats();
+	nvram_wait_for_last_op();
+	zassert_true(stall_us < WRITE_CALL_US, "Unexpected stall: %lld", (long long)stall_us);
+}
+
+static void test_nvram_erase_error(void)
+{
+	uint32_t data = 0x12345678;
+	zb_ret_t ret;
+
+	reset_stats();
+
+	/* ZBOSS is notified about the failed erase, but the page is not used. */
+	erase_error = -EIO;
+	nvram_erase(1);
+	nvram_wait_for_last_op();
+	erase_error = 0;
+	run_callbacks();
+	zassert_equal(erase_finished_calls, 1, "ZBOSS not notified");
+
+	ret = zb_osif_nvram_write(1, 0, &data, sizeof(data));
+	zassert_equal(ret, RET_ERROR, "Write to page that failed to erase: %d", ret);
+
+	/* The page can be used again once it is erased. */
+	nvram_erase(1);
+	nvram_wait_for_last_op();
+	run_callbacks();
+	zassert_equal(erase_finished_calls, 2, "ZBOSS not notified");
+
+	nvram_write(1, 0, &data, sizeof(data));
+	nvram_flush();
+	verify_page(1);
+}
+
+static void test_nvram_erase_callback_queue_full(void)
+{
+	reset_stats();
+
+	/* The erase completes while the application callback queue is full,
+	 * which only the ZBOSS thread can empty. The queue is filled as if by
+	 * another thread.
+	 */
+	zboss_thread = NULL;
+	while (zigbee_schedule_callback(dummy_callback, 0) == RET_OK) {
+	}
+	zboss_thread = k_current_get();
+
+	nvram_erase(1);
+	nvram_wait_for_last_op();
+	run_callbacks();
+	zassert_equal(erase_finished_calls, 1, "ZBOSS not notified");
+
+	/* The erase is reported if ZBOSS makes no NVRAM call. */
+	nvram_erase(0);
+	k_sleep(K_MSEC(2 * ERASE_PAGE_MS * zb_get_nvram_page_length() / PHYSICAL_PAGE_SIZE));
+	run_callbacks();
+	zassert_equal(erase_finished_calls, 2, "ZBOSS not notified");
+	zassert_equal(erased_page, 0, "Wrong page erased: %d", erased_page);
+}
+
+void test_main(void)
+{
+	zb_osif_nvram_init("");
+
+	ztest_test_suite(osif_nvram_flash_sim_test,
+			 ztest_unit_test(test_nvram_write_combining),
+			 ztest_unit_test(test_nvram_read_buffered),
+			 ztest_unit_test(test_nvram_erase_async),
+			 ztest_unit_test(test_nvram_erase_read_waits),
+			 ztest_unit_test(test_nvram_erase_error),
+			 ztest_unit_test(test_nvram_erase_callback_queue_full)
+			 );
+
+	ztest_run_test_suite(osif_nvram_flash_sim_test);
+}
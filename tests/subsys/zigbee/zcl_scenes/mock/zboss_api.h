@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#ifndef ZBOSS_API_H__
+#define ZBOSS_API_H__
+
+#include <stdint.h>
+
+/* Subset of the ZBOSS API used by the scene table. */
+typedef uint8_t zb_uint8_t;
+typedef uint16_t zb_uint16_t;
+typedef uint32_t zb_uint32_t;
+typedef char zb_char_t;
+typedef zb_uint8_t zb_bool_t;
+typedef zb_uint32_t zb_time_t;
+typedef int32_t zb_ret_t;
+
+#define ZB_FALSE 0U
+#define ZB_TRUE 1U
+
+#define RET_OK 0
+#define RET_ERROR (-1)
+
+#define ZB_BEACON_INTERVAL_USEC 15360
+#define ZB_MILLISECONDS_TO_BEACON_INTERVAL(ms) \
+	(((zb_time_t)(ms) * 1000 + (ZB_BEACON_INTERVAL_USEC - 1)) / ZB_BEACON_INTERVAL_USEC)
+
+#define ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD 0xFFFF
+
+/* Fields of the ZBOSS scene table record used by the scenes library. */
+typedef struct zb_zcl_scene_table_record_fixed_s {
+	zb_uint16_t group_id;
+	zb_uint8_t scene_id;
+	zb_char_t scene_name[17];
+	zb_uint16_t transition_time;
+} zb_zcl_scene_table_record_fixed_t;
+
+typedef void (*zb_callback_t)(zb_uint8_t param);
+
+zb_ret_t zb_schedule_app_alarm(zb_callback_t func, zb_uint8_t param, zb_time_t timeout_bi);
+
+#define ZB_SCHEDULE_APP_ALARM(func, param, timeout_bi) \
+	zb_schedule_app_alarm(func, param, timeout_bi)
+
+#endif /* ZBOSS_API_H__ */
@@ -0,0 +1,407 @@
+/*
+ * Copyright (c) 2022 Nordic Semiconductor ASA
+ *
+ * SPDX-License-Identifier: LicenseRef-Nordic-5-Clause
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/storage/flash_map.h>
+#include <ztest.h>
+#include <zboss_api.h>
+
+#include <string.h>
+
+#include "zigbee_zcl_scenes_table.h"
+
+LOG_MODULE_REGISTER(zigbee_zcl_scenes, CONFIG_ZIGBEE_SCENES_LOG_LEVEL);
+
+/* Lighting controller setup: scenes of many groups fill the table. */
+#define GROUP_ID_BASE 0x1000
+#define GROUP_COUNT 16
+#define SCENE_COUNT 4
+
+BUILD_ASSERT(GROUP_COUNT * SCENE_COUNT == CONFIG_ZIGBEE_SCENE_TABLE_SIZE,
+	     "Scenes do not fill the table");
+
+static size_t write_calls;
+static size_t write_bytes;
+static size_t delete_calls;
+static size_t alarm_calls;
+static zb_callback_t alarm_cb;
+
+int settings_save_one_traced(const char *name, const void *value, size_t val_len);
+int settings_delete_traced(const char *name);
+
+int settings_save_one_traced(const char *name, const void *value, size_t val_len)
+{
+	write_calls++;
+	write_bytes += val_len;
+
+	return settings_save_one(name, value, val_len);
+}
+
+int settings_delete_traced(const char *name)
+{
+	delete_calls++;
+
+	return settings_delete(name);
+}
+
+/* ZBOSS scheduler mock. The test runs the alarm instead of waiting for it. */
+zb_ret_t zb_schedule_app_alarm(zb_callback_t func, zb_uint8_t param, zb_time_t timeout_bi)
+{
+	zassert_is_null(alarm_cb, "Alarm already scheduled");
+	zassert_equal(timeout_bi, ZB_MILLISECONDS_TO_BEACON_INTERVAL(
+			      CONFIG_ZIGBEE_SCENES_SAVE_DELAY), "Wrong delay");
+
+	alarm_cb = func;
+	alarm_calls++;
+
+	return RET_OK;
+}
+
+static void run_alarm(void)
+{
+	zb_callback_t cb = alarm_cb;
+
+	alarm_cb = NULL;
+
+	if (cb) {
+		cb(0);
+	}
+}
+
+static void reset_stats(void)
+{
+	write_calls = 0;
+	write_bytes = 0;
+	delete_calls = 0;
+	alarm_calls = 0;
+}
+
+static void reset_table(void)
+{
+	scene_table_remove_all();
+	run_alarm();
+	reset_stats();
+}
+
+static zb_uint16_t group_id(size_t group)
+{
+	return GROUP_ID_BASE + group;
+}
+
+static void scene_make(struct scene_table_on_off_entry *scene, size_t group, size_t scene_id,
+		       zb_uint8_t level)
+{
+	memset(scene, 0, sizeof(*scene));
+	scene->common.group_id = group_id(group);
+	scene->common.scene_id = scene_id;
+	scene->on_off.has_on_off = ZB_TRUE;
+	scene->on_off.on_off = (level != 0);
+	scene->level_control.has_current_level = ZB_TRUE;
+	scene->level_control.current_level = level;
+}
+
+static void scene_store(size_t group, size_t scene_id, zb_uint8_t level)
+{
+	struct scene_table_on_off_entry scene;
+	int err;
+
+	scene_make(&scene, group, scene_id, level);
+	err = scene_table_store(&scene);
+	zassert_equal(err, 0, "Failed to store scene: %d", err);
+}
+
+static void scene_verify(size_t group, size_t scene_id, zb_uint8_t level)
+{
+	const struct scene_table_on_off_entry *entry;
+	struct scene_table_on_off_entry scene;
+
+	scene_make(&scene, group, scene_id, level);
+	entry = scene_table_find(group_id(group), scene_id);
+
+	zassert_not_null(entry, "Scene %zu/%zu not found", group, scene_id);
+	zassert_mem_equal(entry, &scene, sizeof(scene), "Scene %zu/%zu mismatch", group,
+			  scene_id);
+}
+
+static size_t free_entries(void)
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < CONFIG_ZIGBEE_SCENE_TABLE_SIZE; i++) {
+		if (scene_table_get(i) == NULL) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+static int legacy_key_find(const char *key, size_t len, settings_read_cb read_cb,
+			   void *cb_arg, void *param)
+{
+	if (strcmp(key, "scenes_table") == 0) {
+		*(bool *)param = true;
+	}
+
+	return 0;
+}
+
+static void test_scene_table_index(void)
+{
+	struct scene_table_on_off_entry scene;
+
+	reset_table();
+
+	for (size_t group = 0; group < GROUP_COUNT; group++) {
+		for (size_t scene_id = 1; scene_id <= SCENE_COUNT; scene_id++) {
+			scene_store(group, scene_id, group + scene_id);
+		}
+	}
+
+	zassert_equal(free_entries(), 0, "Table not full");
+
+	for (size_t group = 0; group < GROUP_COUNT; group++) {
+		for (size_t scene_id = 1; scene_id <= SCENE_COUNT; scene_id++) {
+			scene_verify(group, scene_id, group + scene_id);
+		}
+	}
+
+	zassert_is_null(scene_table_find(group_id(GROUP_COUNT), 1), "Unknown group found");
+	zassert_is_null(scene_table_find(group_id(0), 0), "Unknown scene found");
+
+	/* A new scene does not fit, but existing ones can be overwritten. */
+	scene_make(&scene, GROUP_COUNT, 1, 100);
+	zassert_equal(scene_table_store(&scene), -ENOMEM, "Stored in full table");
+	scene_store(0, 1, 100);
+	scene_verify(0, 1, 100);
+
+	zassert_equal(scene_table_remove(group_id(0), 1), 0, "Failed to remove scene");
+	zassert_equal(scene_table_remove(group_id(0), 1), -ENOENT, "Removed twice");
+	zassert_is_null(scene_table_find(group_id(0), 1), "Removed scene found");
+	zassert_equal(free_entries(), 1, "Entry not freed");
+
+	scene_store(GROUP_COUNT, 1, 100);
+	scene_verify(GROUP_COUNT, 1, 100);
+
+	scene_table_remove_group(group_id(2));
+	zassert_equal(free_entries(), SCENE_COUNT, "Group not removed");
+
+	for (size_t scene_id = 1; scene_id <= SCENE_COUNT; scene_id++) {
+		zassert_is_null(scene_table_find(group_id(2), scene_id), "Removed scene found");
+		scene_verify(3, scene_id, 3 + scene_id);
+	}
+}
+
+static void test_scene_table_save_batched(void)
+{
+	reset_table();
+
+	scene_store(0, 1, 10);
+	scene_store(0, 2, 20);
+	scene_store(1, 1, 30);
+	scene_store(0, 1, 40);
+	zassert_equal(write_calls, 0, "Saved before the delay");
+	zassert_equal(alarm_calls, 1, "Save not batched");
+
+	run_alarm();
+	zassert_equal(write_calls, 3, "Unexpected write count: %zu", write_calls);
+
+	/* Storing the same content does not write. */
+	scene_store(0, 2, 20);
+	zassert_is_null(alarm_cb, "Save scheduled without a change");
+
+	zassert_equal(scene_table_remove(group_id(1), 1), 0, "Failed to remove scene");
+	run_alarm();
+	zassert_equal(write_calls, 3, "Unexpected write count: %zu", write_calls);
+	zassert_equal(delete_calls, 1, "Unexpected delete count: %zu", delete_calls);
+}
+
+static void test_scene_table_restore(void)
+{
+	reset_table();
+
+	scene_store(0, 1, 10);
+	scene_store(5, 3, 20);
+	scene_store(9, 2, 30);
+	zassert_equal(scene_table_remove(group_id(5), 3), 0, "Failed to remove scene");
+	run_alarm();
+
+	scene_table_init();
+	zassert_is_null(scene_table_find(group_id(0), 1), "Table not cleared");
+
+	reset_stats();
+	zassert_equal(settings_load(), 0, "Failed to load settings");
+	zassert_equal(write_calls + delete_calls, 0, "Written on load");
+
+	scene_verify(0, 1, 10);
+	scene_verify(9, 2, 30);
+	zassert_is_null(scene_table_find(group_id(5), 3), "Removed scene restored");
+	zassert_equal(free_entries(), CONFIG_ZIGBEE_SCENE_TABLE_SIZE - 2, "Unexpected entries");
+
+	/* The restored index is used for further changes. */
+	scene_store(9, 2, 40);
+	scene_verify(9, 2, 40);
+	zassert_equal(free_entries(), CONFIG_ZIGBEE_SCENE_TABLE_SIZE - 2, "Duplicate entry");
+	run_alarm();
+}
+
+static void test_scene_table_reload(void)
+{
+	reset_table();
+
+	scene_store(0, 1, 10);
+	scene_store(3, 2, 20);
+	run_alarm();
+
+	/* Change the table and load the settings again before the changes are
+	 * saved, as done by other modules that call settings_load() at runtime.
+	 */
+	scene_store(0, 1, 15);
+	scene_store(7, 4, 40);
+	zassert_equal(scene_table_remove(group_id(3), 2), 0, "Failed to remove scene");
+
+	zassert_equal(settings_load(), 0, "Failed to load settings");
+
+	scene_verify(0, 1, 15);
+	scene_verify(7, 4, 40);
+	zassert_is_null(scene_table_find(group_id(3), 2), "Removed scene restored");
+	zassert_equal(free_entries(), CONFIG_ZIGBEE_SCENE_TABLE_SIZE - 2, "Unexpected entries");
+
+	/* The changes made before the reload are saved. */
+	reset_stats();
+	run_alarm();
+	zassert_equal(write_calls, 2, "Unexpected write count: %zu", write_calls);
+	zassert_equal(delete_calls, 1, "Unexpected delete count: %zu", delete_calls);
+
+	scene_table_init();
+	zassert_equal(settings_load(), 0, "Failed to load settings");
+
+	scene_verify(0, 1, 15);
+	scene_verify(7, 4, 40);
+	zassert_is_null(scene_table_find(group_id(3), 2), "Removed scene restored");
+	zassert_equal(free_entries(), CONFIG_ZIGBEE_SCENE_TABLE_SIZE - 2, "Unexpected entries");
+}
+
+static void test_scene_table_legacy_convert(void)
+{
+	static struct scene_table_on_off_entry legacy_table[CONFIG_ZIGBEE_SCENE_TABLE_SIZE];
+	bool legacy_found = false;
+	int err;
+
+	reset_table();
+
+	/* Scene table saved as a whole by earlier versions of the library */
+	for (size_t i = 0; i < ARRAY_SIZE(legacy_table); i++) {
+		memset(&legacy_table[i], 0, sizeof(legacy_table[i]));
+		legacy_table[i].common.group_id = ZB_ZCL_SCENES_FREE_SCENE_TABLE_RECORD;
+	}
+
+	scene_make(&legacy_table[0], 1, 1, 10);
+	scene_make(&legacy_table[2], 1, 2, 20);
+	scene_make(&legacy_table[7], 4, 1, 30);
+
+	err = settings_save_one("scenes/scenes_table", legacy_table, sizeof(legacy_table));
+	zassert_equal(err, 0, "Failed to save legacy table: %d", err);
+
+	scene_table_init();
+	zassert_equal(settings_load(), 0, "Failed to load settings");
+	zassert_equal(write_calls, 3, "Unexpected write count: %zu", write_calls);
+
+	err = settings_load_subtree_direct("scenes", legacy_key_find, &legacy_found);
+	zassert_equal(err, 0, "Failed to load settings: %d", err);
+	zassert_false(legacy_found, "Legacy table not deleted");
+
+	/* The converted table is restored from the per-entry keys. */
+	scene_table_init();
+	zassert_equal(settings_load(), 0, "Failed to load settings");
+
+	scene_verify(1, 1, 10);
+	scene_verify(1, 2, 20);
+	scene_verify(4, 1, 30);
+	zassert_equal(free_entries(), CONFIG_ZIGBEE_SCENE_TABLE_SIZE - 3, "Unexpected entries");
+}
+
+static void test_scene_table_storm(void)
+{
+	size_t commands = 0;
+	size_t changes = 0;
+	size_t table_size = CONFIG_ZIGBEE_SCENE_TABLE_SIZE *
+			    sizeof(struct scene_table_on_off_entry);
+
+	reset_table();
+
+	/* The controller stores all scenes of all groups, repeats the storm
+	 * and then updates the first scene of each group. Each burst of
+	 * commands is followed by a pause, in which the changes are saved.
+	 */
+	for (size_t round = 0; round < 3; round++) {
+		for (size_t group = 0; group < GROUP_COUNT; group++) {
+			for (size_t scene_id = 1; scene_id <= SCENE_COUNT; scene_id++) {
+				zb_uint8_t level = group + scene_id;
+
+				if (round == 2 && scene_id == 1) {
+					level += 100;
+					changes++;
+				} else if (round == 0) {
+					changes++;
+				}
+
+				scene_store(group, scene_id, level);
+				commands++;
+			}
+		}
+
+		run_alarm();
+	}
+
+	for (size_t group = 0; group < GROUP_COUNT; group += 4) {
+		scene_table_remove_group(group_id(group));
+		commands++;
+		changes += SCENE_COUNT;
+	}
+
+	run_alarm();
+
+	TC_PRINT("%zu scene commands: %zu settings writes of %zu bytes\n", commands,
+		 write_calls + delete_calls, write_bytes);
+	TC_PRINT("Saving the whole table: %zu settings writes of %zu bytes\n", commands,
+		 commands * table_size);
+
+	zassert_equal(write_calls + delete_calls, changes, "Unchanged scenes written");
+	zassert_true(write_bytes <= changes * sizeof(struct scene_table_on_off_entry),
+		     "Unexpected write size: %zu", write_bytes);
+}
+
+void test_main(void)
+{
+	const struct flash_area *fa;
+	int err;
+
+	/* Start with empty settings storage */
+	err = flash_area_open(FLASH_AREA_ID(storage), &fa);
+	zassert_equal(err, 0, "Failed to open storage: %d", err);
+	err = flash_area_erase(fa, 0, fa->fa_size);
+	zassert_equal(err, 0, "Failed to erase storage: %d", err);
+	flash_area_close(fa);
+
+	err = settings_subsys_init();
+	zassert_equal(err, 0, "Failed to initialize settings: %d", err);
+
+	scene_table_init();
+
+	ztest_test_suite(zigbee_zcl_scenes_test,
+			 ztest_unit_test(test_scene_table_index),
+			 ztest_unit_test(test_scene_table_save_batched),
+			 ztest_unit_test(test_scene_table_restore),
+			 ztest_unit_test(test_scene_table_reload),
+			 ztest_unit_test(test_scene_table_legacy_convert),
+			 ztest_unit_test(test_scene_table_storm)
+			 );
+
+	ztest_run_test_suite(zigbee_zcl_scenes_test);
+}